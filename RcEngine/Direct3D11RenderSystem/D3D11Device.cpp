@@ -339,7 +339,7 @@ void D3D11Device::DoDraw( const EffectTechnique* technique, const RenderOperatio
 		{
 			pass->BeginPass();
 
-			if (operation.NumInstances <= 1)
+			if (operation.NumInstances <= 1 && operation.InstanceStart == 0)
 			{
 				DeviceContextD3D11->DrawIndexed(
 					operation.IndexCount, 
@@ -350,10 +350,10 @@ void D3D11Device::DoDraw( const EffectTechnique* technique, const RenderOperatio
 			{
 				DeviceContextD3D11->DrawIndexedInstanced(
 					operation.IndexCount, 
-					operation.NumInstances,
+					(std::max)(operation.NumInstances, 1U),
 					operation.IndexStart,
 					operation.BaseVertex,
-					0);
+					operation.InstanceStart);
 			}
 
 			pass->EndPass();
@@ -365,7 +365,7 @@ void D3D11Device::DoDraw( const EffectTechnique* technique, const RenderOperatio
 		{
 			pass->BeginPass();
 
-			if (operation.NumInstances <= 1)
+			if (operation.NumInstances <= 1 && operation.InstanceStart == 0)
 			{
 				DeviceContextD3D11->Draw(
 					operation.VertexCount,
@@ -375,9 +375,9 @@ void D3D11Device::DoDraw( const EffectTechnique* technique, const RenderOperatio
 			{
 				DeviceContextD3D11->DrawInstanced(
 					operation.VertexCount,
-					operation.NumInstances,
+					(std::max)(operation.NumInstances, 1U),
 					operation.VertexStart,
-					0);
+					operation.InstanceStart);
 			}
 
 			pass->EndPass();
@@ -6,7 +6,11 @@
 #include <Core/Loger.h>
 #include <Core/Exception.h>
 #include <Core/Utility.h>
-#include <fstream>
+#include <Graphics/ShaderCache.h>
+#include <IO/FileSystem.h>
+#include <IO/PathUtil.h>
+#include <IO/Stream.h>
+#include <list>
 
 namespace RcEngine {
 
@@ -293,9 +297,135 @@ bool LoadBinary(const char* filename, std::vector<uint8_t>& byteCode)
 	return false;
 }
 
-// Helper function to dynamic compile HLSL shader code
+/**
+ * Includes relative to the including file, like D3DCompileFromFile resolves them. Files are
+ * read through FileSystem from General group, names are relative to it.
+ */
+class HLSLInclude : public ID3DInclude
+{
+public:
+	HLSLInclude(const String& filename) : mRootPath(PathUtil::GetPath(filename)) {}
+
+	STDMETHOD(Open)(D3D_INCLUDE_TYPE includeType, LPCSTR fileName, LPCVOID parentData, LPCVOID* data, UINT* bytes)
+	{
+		String path = mRootPath;
+		for (const IncludeFile& file : mOpenFiles)
+		{
+			if (file.Source.data() == parentData)
+				path = file.Path;
+		}
+
+		String includeFile = path + fileName;
+
+		FileSystem& fileSystem = FileSystem::GetSingleton();
+		if (fileSystem.Exits(includeFile) == false)
+			return E_FAIL;
+
+		if (std::find(mIncludedFiles.begin(), mIncludedFiles.end(), includeFile) == mIncludedFiles.end())
+			mIncludedFiles.push_back(includeFile);
+
+		// List nodes don't move, source stays valid until closed
+		mOpenFiles.push_back(IncludeFile());
+		mOpenFiles.back().Path = PathUtil::GetPath(includeFile);
+		mOpenFiles.back().Source = fileSystem.OpenStream(includeFile)->ReadText();
+
+		*data = mOpenFiles.back().Source.data();
+		*bytes = UINT(mOpenFiles.back().Source.size());
+		return S_OK;
+	}
+
+	STDMETHOD(Close)(LPCVOID data)
+	{
+		mOpenFiles.remove_if([=](const IncludeFile& file) { return file.Source.data() == data; });
+		return S_OK;
+	}
+
+	const vector<String>& GetIncludedFiles() const { return mIncludedFiles; }
+
+private:
+	struct IncludeFile
+	{
+		String Path;
+		String Source;
+	};
+
+	String mRootPath;
+	std::list<IncludeFile> mOpenFiles;
+	vector<String> mIncludedFiles;
+};
+
+void PrintCompileError(const String& filename, const String& entryPoint, ID3DBlob* errorBlob)
+{
+	if (errorBlob)
+	{
+		const char* msg = (char*)( errorBlob->GetBufferPointer() );
+		fprintf(stderr, "%s %s compile error:\n%s\n", filename.c_str(), entryPoint.c_str(), msg);
+
+		errorBlob->Release();
+	}
+	else
+		EngineLogger::LogError("HLSL shader compile failed!");
+}
+
+/**
+ * Preprocess, then load bytecode of the expanded source from shader cache or compile it. Key
+ * covers included files without tracking them, and the compiler version.
+ */
+HRESULT CompileHLSLCached(ShaderCache& shaderCache, const String& filename, const String& source, HLSLInclude& include, const D3D10_SHADER_MACRO* pMacro,
+	const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint, const String& shaderModel, DWORD dwShaderFlags, ID3DBlob** ppBlobOut)
+{
+	ID3DBlob* pPreprocessed = nullptr;
+	ID3DBlob* pErrorBlob = nullptr;
+
+	HRESULT hr = D3DPreprocess(source.data(), source.size(), filename.c_str(), pMacro, &include, &pPreprocessed, &pErrorBlob);
+	if( FAILED(hr) )
+	{
+		PrintCompileError(filename, entryPoint, pErrorBlob);
+		return hr;
+	}
+
+	if (pErrorBlob)
+		pErrorBlob->Release();
+
+	char compilerTag[64];
+	sprintf(compilerTag, "%s %x %d", shaderModel.c_str(), dwShaderFlags, D3D_COMPILER_VERSION);
+
+	String preprocessed((const char*)pPreprocessed->GetBufferPointer(), pPreprocessed->GetBufferSize());
+	uint64_t cacheKey = ShaderCache::ComputeKey(preprocessed, macros, macroCount, entryPoint, 0, compilerTag);
+
+	uint32_t format;
+	std::vector<uint8_t> byteCode;
+	if (shaderCache.Load(cacheKey, format, byteCode))
+	{
+		pPreprocessed->Release();
+
+		hr = D3DCreateBlob(byteCode.size(), ppBlobOut);
+		if (SUCCEEDED(hr))
+			memcpy((*ppBlobOut)->GetBufferPointer(), &byteCode[0], byteCode.size());
+		return hr;
+	}
+
+	// #line directives of preprocessed source keep errors and debug info pointing to original files
+	hr = D3DCompile(preprocessed.data(), preprocessed.size(), filename.c_str(), nullptr, nullptr, entryPoint.c_str(),
+		shaderModel.c_str(), dwShaderFlags, 0, ppBlobOut, &pErrorBlob);
+	pPreprocessed->Release();
+
+	if( FAILED(hr) )
+	{
+		PrintCompileError(filename, entryPoint, pErrorBlob);
+		return hr;
+	}
+
+	if (pErrorBlob)
+		pErrorBlob->Release();
+
+	shaderCache.Store(cacheKey, 0, (*ppBlobOut)->GetBufferPointer(), uint32_t((*ppBlobOut)->GetBufferSize()));
+	return hr;
+}
+
+// Helper function to dynamic compile HLSL shader code, files read are added to sourceFiles
 HRESULT CompileHLSL(const String& filename, const ShaderMacro* macros, uint32_t macroCount,
-	const String& entryPoint, const String& shaderModel, ID3DBlob** ppBlobOut)
+	const String& entryPoint, const String& shaderModel, ID3DBlob** ppBlobOut, vector<String>& sourceFiles)
 {
 	HRESULT hr = S_OK;
 
@@ -308,7 +438,7 @@ HRESULT CompileHLSL(const String& filename, const ShaderMacro* macros, uint32_t
 	dwShaderFlags |= D3DCOMPILE_DEBUG;
 #endif
 
-	ID3DBlob* pErrorBlob;
+	ID3DBlob* pErrorBlob = nullptr;
 
 	D3D10_SHADER_MACRO* pMacro = nullptr;
 	std::vector<D3D10_SHADER_MACRO> d3dMacro;
@@ -324,20 +454,44 @@ HRESULT CompileHLSL(const String& filename, const ShaderMacro* macros, uint32_t
 		pMacro = &d3dMacro[0];
 	}
 
-	hr = D3DCompileFromFile(StringToWString(filename).c_str(), pMacro, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint.c_str(), 
-		shaderModel.c_str(), dwShaderFlags, 0,  ppBlobOut, &pErrorBlob);
+	FileSystem& fileSystem = FileSystem::GetSingleton();
+	if (fileSystem.Exits(filename) == false)
+	{
+		fprintf(stderr, "%s not found\n", filename.c_str());
+		return E_FAIL;
+	}
 
-	if( FAILED(hr) )
+	String source = fileSystem.OpenStream(filename)->ReadText();
+
+	// Own include handler instead of D3D_COMPILE_STANDARD_FILE_INCLUDE, to know which files are read
+	HLSLInclude include(filename);
+
+	ShaderCache* shaderCache = ShaderCache::GetSingletonPtr();
+	if (shaderCache && shaderCache->IsEnabled())
 	{
-		if (pErrorBlob)
-		{
-			const char* msg = (char*)( pErrorBlob->GetBufferPointer() );
-			fprintf(stderr, "%s %s compile error:\n%s\n", filename.c_str(), entryPoint.c_str(), msg);
+		hr = CompileHLSLCached(*shaderCache, filename, source, include, pMacro, macros, macroCount, entryPoint, shaderModel, dwShaderFlags, ppBlobOut);
+	}
+	else
+	{
+		hr = D3DCompile(source.data(), source.size(), filename.c_str(), pMacro, &include, entryPoint.c_str(),
+			shaderModel.c_str(), dwShaderFlags, 0, ppBlobOut, &pErrorBlob);
 
+		if( FAILED(hr) )
+			PrintCompileError(filename, entryPoint, pErrorBlob);
+		else if (pErrorBlob)
 			pErrorBlob->Release();
-		}
-		else
-			EngineLogger::LogError("HLSL shader compile failed!");
+	}
+
+	// Only loose files are watched for changes, archived ones have no OS path
+	String fullPath;
+	sourceFiles.clear();
+	if (fileSystem.FindFile(filename, "General", fullPath))
+		sourceFiles.push_back(fullPath);
+
+	for (const String& includeFile : include.GetIncludedFiles())
+	{
+		if (fileSystem.FindFile(includeFile, "General", fullPath))
+			sourceFiles.push_back(fullPath);
 	}
 
 	return hr;
@@ -345,7 +499,7 @@ HRESULT CompileHLSL(const String& filename, const ShaderMacro* macros, uint32_t
 
 //////////////////////////////////////////////////////////////////////////
 D3D11Shader::D3D11Shader( ShaderType type ) 
-	: Shader(type), GlobalCBuffer(NULL)
+	: Shader(type), GlobalCBuffer(NULL), mPrepared(false), mPreparedBlob(nullptr), mPrepareResult(S_OK)
 {
 
 }
@@ -353,6 +507,35 @@ D3D11Shader::D3D11Shader( ShaderType type )
 D3D11Shader::~D3D11Shader()
 {
 	SAFE_DELETE(GlobalCBuffer);
+
+	if (mPreparedBlob)
+		mPreparedBlob->Release();
+}
+
+void D3D11Shader::PrepareFromFile( const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint /*= ""*/ )
+{
+	static const char* ShaderProfiles[ST_Count] = { "vs_5_0", "hs_5_0", "ds_5_0", "gs_5_0", "ps_5_0", "cs_5_0" };
+
+	if (mPreparedBlob)
+	{
+		mPreparedBlob->Release();
+		mPreparedBlob = nullptr;
+	}
+
+	mPrepareResult = CompileHLSL(filename, macros, macroCount, entryPoint, ShaderProfiles[mShaderType], &mPreparedBlob, mSourceFiles);
+	mPrepared = true;
+}
+
+HRESULT D3D11Shader::CompileFromFile( const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint, ID3DBlob** ppBlobOut )
+{
+	if (!mPrepared)
+		PrepareFromFile(filename, macros, macroCount, entryPoint);
+
+	*ppBlobOut = mPreparedBlob;
+	mPreparedBlob = nullptr;
+	mPrepared = false;
+
+	return mPrepareResult;
 }
 
 void D3D11Shader::CreateGlobalConstantBuffer( uint32_t bufferSize )
@@ -399,7 +582,7 @@ bool D3D11VertexShader::LoadFromFile( const String& filename, const ShaderMacro*
 {
 	ID3DBlob* shaderBlob = nullptr;
 
-	HRESULT hr = CompileHLSL(filename, macros, macroCount, entryPoint, "vs_5_0", &shaderBlob);
+	HRESULT hr = CompileFromFile(filename, macros, macroCount, entryPoint, &shaderBlob);
 	if (SUCCEEDED(hr))
 	{
 		ID3D11Device* deviceD3D11 = gD3D11Device->DeviceD3D11;
@@ -457,7 +640,7 @@ bool D3D11HullShader::LoadFromFile( const String& filename, const ShaderMacro* m
 {
 	ID3DBlob* shaderBlob = nullptr;
 
-	HRESULT hr = CompileHLSL(filename, macros, macroCount, entryPoint, "hs_5_0", &shaderBlob);
+	HRESULT hr = CompileFromFile(filename, macros, macroCount, entryPoint, &shaderBlob);
 	if (SUCCEEDED(hr))
 	{
 		ID3D11Device* deviceD3D11 = gD3D11Device->DeviceD3D11;
@@ -512,7 +695,7 @@ bool D3D11DomainShader::LoadFromFile( const String& filename, const ShaderMacro*
 {
 	ID3DBlob* shaderBlob = nullptr;
 
-	HRESULT hr = CompileHLSL(filename, macros, macroCount, entryPoint, "ds_5_0", &shaderBlob);
+	HRESULT hr = CompileFromFile(filename, macros, macroCount, entryPoint, &shaderBlob);
 	if (SUCCEEDED(hr))
 	{
 		ID3D11Device* deviceD3D11 = gD3D11Device->DeviceD3D11;
@@ -567,7 +750,7 @@ bool D3D11GeometryShader::LoadFromFile( const String& filename, const ShaderMacr
 {
 	ID3DBlob* shaderBlob = nullptr;
 
-	HRESULT hr = CompileHLSL(filename, macros, macroCount, entryPoint, "gs_5_0", &shaderBlob);
+	HRESULT hr = CompileFromFile(filename, macros, macroCount, entryPoint, &shaderBlob);
 	if (SUCCEEDED(hr))
 	{
 		ID3D11Device* deviceD3D11 = gD3D11Device->DeviceD3D11;
@@ -622,7 +805,7 @@ bool D3D11PixelShader::LoadFromFile( const String& filename, const ShaderMacro*
 {
 	ID3DBlob* shaderBlob = nullptr;
 
-	HRESULT hr = CompileHLSL(filename, macros, macroCount, entryPoint, "ps_5_0", &shaderBlob);
+	HRESULT hr = CompileFromFile(filename, macros, macroCount, entryPoint, &shaderBlob);
 	if (SUCCEEDED(hr))
 	{
 		ID3D11Device* deviceD3D11 = gD3D11Device->DeviceD3D11;
@@ -677,7 +860,7 @@ bool D3D11ComputeShader::LoadFromFile( const String& filename, const ShaderMacro
 {
 	ID3DBlob* shaderBlob = nullptr;
 
-	HRESULT hr = CompileHLSL(filename, macros, macroCount, entryPoint, "cs_5_0", &shaderBlob);
+	HRESULT hr = CompileFromFile(filename, macros, macroCount, entryPoint, &shaderBlob);
 	if (SUCCEEDED(hr))
 	{
 		ID3D11Device* deviceD3D11 = gD3D11Device->DeviceD3D11;
@@ -50,6 +50,17 @@ public:
 	 * Only called when shader has global uniform.
 	 */
 	void CreateGlobalConstantBuffer(uint32_t bufferSize);
+
+	/**
+	 * Compile to bytecode, device isn't used.
+	 */
+	virtual void PrepareFromFile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint = "");
+
+protected:
+	/**
+	 * Take bytecode compiled by PrepareFromFile, or compile it now if not prepared.
+	 */
+	HRESULT CompileFromFile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint, ID3DBlob** ppBlobOut);
 	
 public:
 	vector<ResourceInputParam> ResourceInputParams;
@@ -60,6 +71,12 @@ public:
 
 	friend class D3D11ShaderReflection;
 	friend class D3D11ShaderPipeline;
+
+protected:
+	// Bytecode compiled on a worker by PrepareFromFile
+	bool mPrepared;
+	ID3DBlob* mPreparedBlob;
+	HRESULT mPrepareResult;
 };
 
 
@@ -97,4 +97,57 @@ void D3D11Texture::CopyToTexture( Texture& destTexture )
 	deviceContext->CopyResource(destResourceD3D11, srcResourceD3D11);
 }
 
+void D3D11Texture::CopyLevelsToTexture( Texture& destTexture, uint32_t srcLevel )
+{
+	ID3D11DeviceContext* deviceContext = gD3D11Device->DeviceContextD3D11;
+
+	ID3D11Resource* destResourceD3D11;
+	ID3D11Resource* srcResourceD3D11;
+
+	const uint32_t destLevels = destTexture.GetMipLevels();
+	assert(mFormat == destTexture.GetTextureFormat() && mType == destTexture.GetTextureType() && 
+		   mTextureArraySize == destTexture.GetTextureArraySize() && srcLevel + destLevels <= mMipLevels);
+
+	uint32_t numSlices = mTextureArraySize;
+	switch (mType)
+	{
+	case TT_Texture1D:
+		{
+			destResourceD3D11 = static_cast_checked<D3D11Texture1D*>(&destTexture)->TextureD3D11;
+			srcResourceD3D11 = static_cast_checked<D3D11Texture1D*>(this)->TextureD3D11;
+		}
+		break;
+	case TT_Texture2D:
+		{
+			destResourceD3D11 = static_cast_checked<D3D11Texture2D*>(&destTexture)->TextureD3D11;
+			srcResourceD3D11 = static_cast_checked<D3D11Texture2D*>(this)->TextureD3D11;
+		}
+		break;
+	case TT_Texture3D:
+		{
+			destResourceD3D11 = static_cast_checked<D3D11Texture3D*>(&destTexture)->TextureD3D11;
+			srcResourceD3D11 = static_cast_checked<D3D11Texture3D*>(this)->TextureD3D11;
+		}
+		break;
+	case TT_TextureCube:
+		{
+			destResourceD3D11 = static_cast_checked<D3D11TextureCube*>(&destTexture)->TextureD3D11;
+			srcResourceD3D11 = static_cast_checked<D3D11TextureCube*>(this)->TextureD3D11;
+			numSlices *= CMF_Count;
+		}
+		break;
+	default:
+		ENGINE_EXCEPT(Exception::ERR_NOT_IMPLEMENTED, "Unsupported texture type copy!", "D3D11Texture::CopyLevelsToTexture");
+	}
+
+	for (uint32_t slice = 0; slice < numSlices; ++slice)
+	{
+		for (uint32_t level = 0; level < destLevels; ++level)
+		{
+			deviceContext->CopySubresourceRegion(destResourceD3D11, D3D11CalcSubresource(level, slice, destLevels), 0, 0, 0,
+				srcResourceD3D11, D3D11CalcSubresource(srcLevel + level, slice, mMipLevels), nullptr);
+		}
+	}
+}
+
 }
\ No newline at end of file
@@ -33,6 +33,7 @@ public:
 	virtual void UnmapCube(uint32_t arrayIndex, CubeMapFace face, uint32_t level);
 
 	virtual void CopyToTexture(Texture& destTexture);
+	virtual void CopyLevelsToTexture(Texture& destTexture, uint32_t srcLevel);
 
 protected:
 	// Used for read 
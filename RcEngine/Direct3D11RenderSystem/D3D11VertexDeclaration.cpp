@@ -4,7 +4,7 @@
 #include "D3D11Shader.h"
 #include <Core/Exception.h>
 
-#define MAX_ATTRIBUTES 8
+#define MAX_ATTRIBUTES 16
 
 namespace RcEngine {
 
@@ -32,9 +32,26 @@ void D3D11VertexDeclaration::CreateInputLayout( const RenderOperation& operation
 	 */
 	//assert(mVertexElemets.size() == vertexShaderD3D11->InputSignatures.size());
 	assert(mVertexElemets.size() >= vertexShaderD3D11->InputSignatures.size());
+	assert(vertexShaderD3D11->InputSignatures.size() <= MAX_ATTRIBUTES);
 	for (size_t i = 0; i < vertexShaderD3D11->InputSignatures.size(); ++i) //for (size_t i = 0; i < mVertexElemets.size(); ++i)
 	{
-		const VertexElement& element = mVertexElemets[i];
+		const VertexElement* pElement = &mVertexElemets[i];
+
+		// Instance rows are matched by semantic, shader may skip some mesh attributes before them
+		if (vertexShaderD3D11->InputSignatures[i].Semantic == "INSTANCE_TRANSFORM")
+		{
+			pElement = nullptr;
+			for (const VertexElement& instanceElement : mVertexElemets)
+			{
+				if (instanceElement.Usage == VEU_InstanceTransform && instanceElement.UsageIndex == vertexShaderD3D11->InputSignatures[i].SemanticIndex)
+					pElement = &instanceElement;
+			}
+
+			if (!pElement)
+				ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Error: Vertex Input Signature Not Match!", "D3D11VertexDeclaration::CreateInputLayout");
+		}
+
+		const VertexElement& element = *pElement;
 		layoutD3D11[i].SemanticName = vertexShaderD3D11->InputSignatures[i].Semantic.c_str();
 		layoutD3D11[i].SemanticIndex = element.UsageIndex;
 		layoutD3D11[i].Format = D3D11Mapping::Mapping(element.Type);
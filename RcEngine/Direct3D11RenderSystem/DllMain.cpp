@@ -1,5 +1,10 @@
 #include "D3D11Module.h"
 
+// Report allocations of this module to the engine allocation hook
+#ifndef BUILD_STATIC
+#include <Core/MemoryHook.inl>
+#endif
+
 extern "C" void _D3D11Export dllStartPlugin(RcEngine::IModule** pMoudle) 
 {
 	*pMoudle = new RcEngine::D3D11Module();
@@ -1,5 +1,10 @@
 #include "OISInputModule.h"
 
+// Report allocations of this module to the engine allocation hook
+#ifndef BUILD_STATIC
+#include <Core/MemoryHook.inl>
+#endif
+
 extern "C" void _InputExport dllStartPlugin(RcEngine::IModule** pMoudle) 
 {
 	*pMoudle = new RcEngine::OISInputModule();
@@ -3,7 +3,9 @@
 #include "/ModelVertexFactory.glsl"
 
 // Shader uniforms	
+#ifndef _Instancing
 uniform mat4 World;	
+#endif
 uniform mat4 ViewProj;
 
 // VS Outputs
@@ -22,6 +24,10 @@ out gl_PerVertex {
 
 void main()
 {
+#ifdef _Instancing
+	mat4 World = GetInstanceWorld();
+#endif
+
 #ifdef _Skinning
 
 	mat4 Skin = CalculateSkinMatrix();
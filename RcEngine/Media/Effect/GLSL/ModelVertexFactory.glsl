@@ -30,6 +30,23 @@ layout (location = TEXCOORD) in vec2 iTex;
 	layout (location = BINORMAL) in vec3 iBinormal;
 #endif
 
+// Per-instance world matrix, one attribute per row after mesh attributes
+#ifdef _Instancing
+	#ifdef _NormalMap
+		#define INSTANCE_TRANSFORM (BINORMAL+1)
+	#else
+		#define INSTANCE_TRANSFORM (TEXCOORD+1)
+	#endif
+
+	layout (location = INSTANCE_TRANSFORM) in mat4 iInstanceTransform;
+
+	// Attribute rows fill matrix columns, transpose to match World uniform
+	mat4 GetInstanceWorld()
+	{
+		return transpose(iInstanceTransform);
+	}
+#endif
+
 // Helper function for skin mesh
 #ifdef _Skinning
 
@@ -2,7 +2,9 @@
 
 #include "/ModelVertexFactory.glsl"
 
+#ifndef _Instancing
 uniform mat4 World;	
+#endif
 uniform mat4 ViewProj;
 
 #ifdef _AlphaTest
@@ -15,6 +17,10 @@ out gl_PerVertex {
 
 void main()
 {
+#ifdef _Instancing
+	mat4 World = GetInstanceWorld();
+#endif
+
 #ifdef _Skinning
 	mat4 Skin = CalculateSkinMatrix();
 	mat4 SkinWorld = Skin * World;
@@ -1,7 +1,9 @@
 #include "ModelVertexFactory.hlsl"
 
 // Unifroms
+#ifndef _Instancing
 float4x4 World;
+#endif
 float4x4 ViewProj;
 
 //-------------------------------------------------------------------------------------
@@ -9,6 +11,10 @@ VSOutput ModelVS(VSInput input)
 {
 	VSOutput output = (VSOutput)0;
 	
+#ifdef _Instancing
+	float4x4 World = GetInstanceWorld(input);
+#endif
+
 	// calculate position in view space:
 #ifdef _Skinning
 	float4x4 Skin = CalculateSkinMatrix(input.BlendWeights, input.BlendIndices);
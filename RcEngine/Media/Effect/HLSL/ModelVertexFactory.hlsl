@@ -17,6 +17,13 @@ struct VSInput
 	float3 Tangent		 : TANGENT;
 	float3 Binormal      : BINORMAL;
 #endif
+
+#ifdef _Instancing
+	float4 InstanceTransform0 : INSTANCE_TRANSFORM0;
+	float4 InstanceTransform1 : INSTANCE_TRANSFORM1;
+	float4 InstanceTransform2 : INSTANCE_TRANSFORM2;
+	float4 InstanceTransform3 : INSTANCE_TRANSFORM3;
+#endif
 };
 
 // Outputs
@@ -50,4 +57,11 @@ struct VSOutput
 			   SkinMatrices[BlendIndices[2]] * BlendWeights[2] +
 			   SkinMatrices[BlendIndices[3]] * BlendWeights[3];
 	}
+#endif
+
+#ifdef _Instancing
+	float4x4 GetInstanceWorld(in VSInput input)
+	{
+		return float4x4(input.InstanceTransform0, input.InstanceTransform1, input.InstanceTransform2, input.InstanceTransform3);
+	}
 #endif
\ No newline at end of file
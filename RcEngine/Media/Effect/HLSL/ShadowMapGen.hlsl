@@ -1,7 +1,9 @@
 #include "ModelVertexFactory.hlsl"
 #include "ModelMaterialFactory.hlsl"
 
+#ifndef _Instancing
 float4x4 World;
+#endif
 float4x4 ViewProj;
 
 void ShadowMapVS(VSInput input, 
@@ -10,6 +12,10 @@ void ShadowMapVS(VSInput input,
 			#endif
 				 out float4 oPos : SV_POSITION)
 {
+#ifdef _Instancing
+	float4x4 World = GetInstanceWorld(input);
+#endif
+
 // calculate position in view space:
 #ifdef _Skinning
 	float4x4 Skin = CalculateSkinMatrix(input.BlendWeights, input.BlendIndices);
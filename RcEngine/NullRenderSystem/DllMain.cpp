@@ -0,0 +1,16 @@
+#include "NullModule.h"
+
+// Report allocations of this module to the engine allocation hook
+#ifndef BUILD_STATIC
+#include <Core/MemoryHook.inl>
+#endif
+
+extern "C" void _NullExport dllStartPlugin(RcEngine::IModule** pMoudle) 
+{
+	*pMoudle = new RcEngine::NullModule();
+}
+
+extern "C" void _NullExport dllStopPlugin(RcEngine::IModule** pMoudle) 
+{
+	delete (*pMoudle);
+}
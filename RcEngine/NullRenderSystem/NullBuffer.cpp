@@ -0,0 +1,35 @@
+#include "NullBuffer.h"
+#include <Core/Exception.h>
+
+namespace RcEngine {
+
+NullBuffer::NullBuffer( uint32_t bufferSize, uint32_t accessHint, uint32_t flags, ElementInitData* initData )
+	: GraphicsBuffer(bufferSize, accessHint, flags),
+	  mData(bufferSize, 0)
+{
+	if (initData && initData->pData && bufferSize)
+		memcpy(&mData[0], initData->pData, bufferSize);
+}
+
+NullBuffer::~NullBuffer()
+{
+
+}
+
+void* NullBuffer::Map( uint32_t offset, uint32_t length, ResourceMapAccess mapType )
+{
+	if (length == MAP_ALL_BUFFER)
+		length = mBufferSize - offset;
+
+	if (offset + length > mBufferSize)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Map range out of buffer!", "NullBuffer::Map");
+
+	return mData.empty() ? nullptr : &mData[offset];
+}
+
+void NullBuffer::UnMap()
+{
+
+}
+
+}
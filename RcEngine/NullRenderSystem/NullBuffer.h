@@ -0,0 +1,29 @@
+#ifndef NullBuffer_h__
+#define NullBuffer_h__
+
+#include "NullPrerequisites.h"
+#include <Graphics/GraphicsResource.h>
+
+namespace RcEngine {
+
+/**
+ * Buffer kept in system memory, Map returns the storage directly.
+ */
+class _NullExport NullBuffer : public GraphicsBuffer
+{
+public:
+	NullBuffer(uint32_t bufferSize, uint32_t accessHint, uint32_t flags, ElementInitData* initData);
+	~NullBuffer();
+
+	void* Map(uint32_t offset, uint32_t length, ResourceMapAccess mapType);
+	void UnMap();
+
+	inline const uint8_t* GetData() const { return mData.empty() ? nullptr : &mData[0]; }
+
+private:
+	vector<uint8_t> mData;
+};
+
+}
+
+#endif // NullBuffer_h__
@@ -0,0 +1,169 @@
+#include "NullDevice.h"
+#include "NullFactory.h"
+#include "NullFrameBuffer.h"
+#include "NullView.h"
+#include <Graphics/RenderState.h>
+#include <Graphics/RenderOperation.h>
+#include <Graphics/Effect.h>
+#include <MainApp/Application.h>
+#include <Math/MathUtil.h>
+
+namespace RcEngine {
+
+NullDevice* gNullDevice = NULL;
+
+NullDevice::NullDevice()
+	: mNumFrames(0),
+	  mRecordDraws(false)
+{
+	gNullDevice = this;
+
+	mRenderFactory = new NullFactory();
+}
+
+NullDevice::~NullDevice(void)
+{
+	gNullDevice = NULL;
+}
+
+void NullDevice::CreateRenderWindow()
+{
+	const ApplicationSettings& appSettings = Application::msApp->GetAppSettings();
+
+	mScreenFrameBuffer = std::make_shared<NullRenderWindow>(appSettings.Width, appSettings.Height);
+
+	mScreenFrameBuffer->AttachRTV(ATT_Color0, std::make_shared<NullRenderView>(nullptr));
+	if(PixelFormatUtils::IsDepth(appSettings.DepthStencilFormat))
+	{
+		// Have depth buffer, attach it
+		mScreenFrameBuffer->AttachRTV(ATT_DepthStencil, std::make_shared<NullRenderView>(nullptr));
+	}
+	mScreenFrameBuffer->SetViewport(Viewport(0, 0, float(appSettings.Width), float(appSettings.Height)));
+
+	// Bind as default
+	BindFrameBuffer(mScreenFrameBuffer);
+
+	//Create default render state
+	mCurrentDepthStencilState = mRenderFactory->CreateDepthStencilState(DepthStencilStateDesc());
+	mCurrentBlendState = mRenderFactory->CreateBlendState(BlendStateDesc());
+	mCurrentRasterizerState = mRenderFactory->CreateRasterizerState(RasterizerStateDesc());
+}
+
+void NullDevice::OnWindowResize( uint32_t width, uint32_t height )
+{
+	mScreenFrameBuffer->Resize(width, height);
+	mScreenFrameBuffer->SetViewport(Viewport(0, 0, float(width), float(height)));
+	BindFrameBuffer(mScreenFrameBuffer);
+}
+
+void NullDevice::ToggleFullscreen( bool fs )
+{
+
+}
+
+void NullDevice::AdjustProjectionMatrix( float4x4& pOut )
+{
+	// Shaders are reflected from GLSL source, use OpenGL clip space like it
+	float4x4 scale = CreateScaling(1.0f, 1.0f, 2.0f);
+	float4x4 translate = CreateTranslation(0.0f, 0.0f, -1.0f);
+	pOut =  pOut * scale * translate;
+}
+
+void NullDevice::SetBlendState( const shared_ptr<BlendState>& state, const ColorRGBA& blendFactor, uint32_t sampleMask )
+{
+	mCurrentBlendState = state;
+	mCurrentBlendFactor = blendFactor;
+	mCurrentSampleMask = sampleMask;
+}
+
+void NullDevice::SetRasterizerState( const shared_ptr<RasterizerState>& state )
+{
+	mCurrentRasterizerState = state;
+}
+
+void NullDevice::SetDepthStencilState( const shared_ptr<DepthStencilState>& state, uint16_t frontStencilRef, uint16_t backStencilRef )
+{
+	mCurrentDepthStencilState = state;
+	mCurrentFrontStencilRef = frontStencilRef;
+	mCurrentBackStencilRef = backStencilRef;
+}
+
+void NullDevice::SetSamplerState( ShaderType stage, uint32_t unit, const shared_ptr<SamplerState>& state )
+{
+	// Sampler unit follows SRV binding, only the first units are tracked
+	if (unit < MaxSamplerCout)
+		mCurrentSamplerStates[unit] = state;
+}
+
+void NullDevice::DoBindShaderPipeline( const shared_ptr<ShaderPipeline>& pipeline )
+{
+	mFrameStats.NumPipelineBinds++;
+}
+
+void NullDevice::DoDraw( const EffectTechnique* technique, const RenderOperation& operation )
+{
+	const bool indexed = (operation.IndexBuffer != nullptr);
+	const uint32_t vertexCount = indexed ? operation.IndexCount : operation.VertexCount;
+	const uint32_t numInstances = (std::max)(operation.NumInstances, 1U);
+
+	const vector<EffectPass*>& passes = technique->GetPasses();
+	for (EffectPass* pass : passes)
+	{
+		pass->BeginPass();
+
+		mFrameStats.NumDrawCalls++;
+		mFrameStats.NumInstances += numInstances;
+		mFrameStats.NumVertices += uint64_t(vertexCount) * numInstances;
+
+		pass->EndPass();
+	}
+
+	if (mRecordDraws)
+	{
+		NullDrawRecord record;
+		record.Technique = technique;
+		record.PrimitiveType = operation.PrimitiveType;
+		record.NumPasses = passes.size();
+		record.VertexCount = vertexCount;
+		record.NumInstances = numInstances;
+		record.InstanceStart = operation.InstanceStart;
+		record.Indexed = indexed;
+		record.Compute = false;
+		mDrawRecords.push_back(record);
+	}
+}
+
+void NullDevice::DispatchCompute( const EffectTechnique* technique, uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCounZ )
+{
+	const vector<EffectPass*>& passes = technique->GetPasses();
+	for (EffectPass* pass : passes)
+	{
+		pass->BeginPass();
+		mFrameStats.NumDispatches++;
+		pass->EndPass();
+	}
+
+	if (mRecordDraws)
+	{
+		NullDrawRecord record;
+		record.Technique = technique;
+		record.PrimitiveType = PT_Point_List;
+		record.NumPasses = passes.size();
+		record.VertexCount = 0;
+		record.NumInstances = threadGroupCountX * threadGroupCountY * threadGroupCounZ;
+		record.InstanceStart = 0;
+		record.Indexed = false;
+		record.Compute = true;
+		mDrawRecords.push_back(record);
+	}
+}
+
+void NullDevice::EndFrame()
+{
+	mLastFrameStats = mFrameStats;
+	mFrameStats.Reset();
+	mDrawRecords.clear();
+	mNumFrames++;
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef NullDevice_h__
+#define NullDevice_h__
+
+#include "NullPrerequisites.h"
+#include <Graphics/RenderDevice.h>
+#include <Graphics/FrameBuffer.h>
+
+namespace RcEngine {
+
+class NullDevice;
+
+// Global null device
+extern NullDevice* gNullDevice;
+
+/**
+ * Counters of one frame, a frame ends when the screen frame buffer swaps.
+ */
+struct _NullExport NullFrameStats
+{
+	NullFrameStats() { Reset(); }
+
+	void Reset()
+	{
+		NumDrawCalls = NumInstances = NumDispatches = NumPipelineBinds = 0;
+		NumVertices = 0;
+	}
+
+	uint32_t NumDrawCalls;
+	uint32_t NumInstances;
+	uint32_t NumDispatches;
+	uint32_t NumPipelineBinds;
+
+	// Vertices or indices submitted, times instances
+	uint64_t NumVertices;
+};
+
+/**
+ * A draw or dispatch as it would have been sent to GPU. For dispatches NumInstances is the
+ * number of thread groups.
+ */
+struct _NullExport NullDrawRecord
+{
+	const EffectTechnique* Technique;
+	PrimitiveType PrimitiveType;
+	uint32_t NumPasses;
+	uint32_t VertexCount;		// Index count if indexed
+	uint32_t NumInstances;
+	uint32_t InstanceStart;
+	bool Indexed;
+	bool Compute;
+};
+
+/**
+ * Render device without GPU. Resources live in system memory and draws only run the effect
+ * passes (states, pipeline bind and parameter upload to constant buffers), so everything
+ * above RenderDevice runs as with a real device. Used for dedicated servers and CPU
+ * benchmarks.
+ */
+class _NullExport NullDevice : public RenderDevice
+{
+public:
+	NullDevice();
+	~NullDevice(void);
+
+	void CreateRenderWindow();
+
+	void OnWindowResize( uint32_t width, uint32_t height );
+	void ToggleFullscreen(bool fs);
+	void AdjustProjectionMatrix(float4x4& pOut);
+
+	void SetBlendState(const shared_ptr<BlendState>& state, const ColorRGBA& blendFactor, uint32_t sampleMask);
+	void SetRasterizerState(const shared_ptr<RasterizerState>& state);
+	void SetDepthStencilState(const shared_ptr<DepthStencilState>& state, uint16_t frontStencilRef = 0, uint16_t backStencilRef = 0);
+	void SetSamplerState(ShaderType stage, uint32_t unit, const shared_ptr<SamplerState>& state);
+	void DispatchCompute(const EffectTechnique* technique, uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCounZ);
+
+	// Called by screen frame buffer SwapBuffers
+	void EndFrame();
+
+	inline uint32_t GetNumFrames() const							{ return mNumFrames; }
+	inline const NullFrameStats& GetFrameStats() const				{ return mLastFrameStats; }
+	inline const NullFrameStats& GetCurrentFrameStats() const		{ return mFrameStats; }
+
+	/**
+	 * Keep a record of every draw and dispatch of current frame, cleared on EndFrame.
+	 * Off by default, benchmarks only need the counters.
+	 */
+	void SetRecordDraws(bool enable)								{ mRecordDraws = enable; }
+	inline const vector<NullDrawRecord>& GetDrawRecords() const		{ return mDrawRecords; }
+
+protected:
+	void DoBindShaderPipeline(const shared_ptr<ShaderPipeline>& pipeline);
+	void DoDraw(const EffectTechnique* technique, const RenderOperation& operation);
+
+private:
+	shared_ptr<SamplerState> mCurrentSamplerStates[MaxSamplerCout];
+
+	uint32_t mNumFrames;
+	NullFrameStats mFrameStats;
+	NullFrameStats mLastFrameStats;
+
+	bool mRecordDraws;
+	vector<NullDrawRecord> mDrawRecords;
+};
+
+}
+
+
+#endif // NullDevice_h__
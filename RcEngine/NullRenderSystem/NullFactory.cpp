@@ -0,0 +1,205 @@
+#include "NullFactory.h"
+#include "NullBuffer.h"
+#include "NullTexture.h"
+#include "NullView.h"
+#include "NullShader.h"
+#include "NullFrameBuffer.h"
+#include <Graphics/GLSLPreprocessor.h>
+#include <Graphics/RenderState.h>
+#include <Graphics/VertexDeclaration.h>
+#include <Core/Exception.h>
+
+namespace RcEngine {
+
+// No ambient occlusion without GPU, output frame buffer is left untouched
+class NullHBAOImpl : public AmbientOcclusion::HBAOImpl
+{
+public:
+	NullHBAOImpl() {}
+
+	virtual void RenderSSAO(const AmbientOcclusionSettings& settings,
+		const Camera& viewCamera,
+		const shared_ptr<FrameBuffer>& outAOFrameBuffer,
+		const shared_ptr<Texture>& depthBuffer,
+		const shared_ptr<Texture>& normalBuffer) {}
+};
+
+shared_ptr<RasterizerState> NullFactory::CreateRasterizerStateImpl( const RasterizerStateDesc& desc )
+{
+	return shared_ptr<RasterizerState>( new RasterizerState(desc) );
+}
+
+shared_ptr<SamplerState> NullFactory::CreateSamplerStateImpl( const SamplerStateDesc& desc )
+{
+	return shared_ptr<SamplerState>( new SamplerState(desc) );
+}
+
+shared_ptr<DepthStencilState> NullFactory::CreateDepthStencilStateImpl( const DepthStencilStateDesc& desc )
+{
+	return shared_ptr<DepthStencilState>( new DepthStencilState(desc) );
+}
+
+shared_ptr<BlendState> NullFactory::CreateBlendStateImpl( const BlendStateDesc& desc )
+{
+	return shared_ptr<BlendState>( new BlendState(desc) );
+}
+
+shared_ptr<GraphicsBuffer> NullFactory::CreateVertexBuffer( uint32_t buffreSize, uint32_t accessHint, uint32_t createFlags, ElementInitData* initData )
+{
+	return std::shared_ptr<NullBuffer>( new NullBuffer(buffreSize, accessHint, createFlags, initData) );
+}
+
+shared_ptr<GraphicsBuffer> NullFactory::CreateIndexBuffer( uint32_t buffreSize, uint32_t accessHint, uint32_t createFlags,ElementInitData* initData )
+{
+	return std::shared_ptr<NullBuffer>( new NullBuffer(buffreSize, accessHint, createFlags, initData) );
+}
+
+shared_ptr<GraphicsBuffer> NullFactory::CreateConstantBuffer( uint32_t buffreSize, uint32_t accessHint, uint32_t createFlags,ElementInitData* initData )
+{
+	return std::shared_ptr<NullBuffer>( new NullBuffer(buffreSize, accessHint, createFlags, initData) );
+}
+
+shared_ptr<GraphicsBuffer> NullFactory::CreateTextureBuffer( PixelFormat format, uint32_t elementCount, uint32_t accessHint, uint32_t createFlags, ElementInitData* initData )
+{
+	uint32_t texelSize = PixelFormatUtils::GetNumElemBytes(format);
+	return std::shared_ptr<NullBuffer>( new NullBuffer(texelSize * elementCount, accessHint, createFlags, initData) );
+}
+
+shared_ptr<GraphicsBuffer> NullFactory::CreateStructuredBuffer(uint32_t strutureStride, uint32_t elementCount, uint32_t accessHint, uint32_t createFlags, ElementInitData* initData)
+{
+	return std::shared_ptr<NullBuffer>( new NullBuffer(strutureStride * elementCount, accessHint, createFlags, initData) );
+}
+
+shared_ptr<Texture> NullFactory::CreateTexture1D( uint32_t width, PixelFormat format, uint32_t arrSize, uint32_t numMipMaps, uint32_t accessHint, uint32_t createFlags, ElementInitData* initData )
+{
+	return shared_ptr<NullTexture>(
+		new NullTexture(TT_Texture1D, format, arrSize, numMipMaps, width, 1, 1, 1, 0, accessHint, createFlags, initData) );
+}
+
+shared_ptr<Texture> NullFactory::CreateTexture2D( uint32_t width, uint32_t height, PixelFormat format, uint32_t arrSize, uint32_t numMipMaps, uint32_t sampleCount, uint32_t sampleQuality, uint32_t accessHint, uint32_t createFlags, ElementInitData* initData )
+{
+	return shared_ptr<NullTexture>(
+		new NullTexture(TT_Texture2D, format, arrSize, numMipMaps, width, height, 1, sampleCount, sampleQuality, accessHint, createFlags, initData) );
+}
+
+shared_ptr<Texture> NullFactory::CreateTexture3D( uint32_t width, uint32_t height, uint32_t depth, PixelFormat format, uint32_t numMipMaps, uint32_t accessHint, uint32_t createFlags, ElementInitData* initData )
+{
+	return shared_ptr<NullTexture>(
+		new NullTexture(TT_Texture3D, format, 1, numMipMaps, width, height, depth, 1, 0, accessHint, createFlags, initData) );
+}
+
+shared_ptr<Texture> NullFactory::CreateTextureCube( uint32_t width, uint32_t height, PixelFormat format, uint32_t arraySize, uint32_t numMipMaps, uint32_t sampleCount, uint32_t sampleQuality, uint32_t accessHint, uint32_t createFlags, ElementInitData* initData )
+{
+	return shared_ptr<NullTexture>(
+		new NullTexture(TT_TextureCube, format, arraySize, numMipMaps, width, height, 1, sampleCount, sampleQuality, accessHint, createFlags, initData) );
+}
+
+shared_ptr<ShaderResourceView> NullFactory::CreateTextureBufferSRV( const shared_ptr<GraphicsBuffer>& buffer, uint32_t elementOffset, uint32_t elementCount, PixelFormat format )
+{
+	return shared_ptr<ShaderResourceView>( new NullShaderResourceView() );
+}
+
+shared_ptr<ShaderResourceView> NullFactory::CreateStructuredBufferSRV( const shared_ptr<GraphicsBuffer>& buffer, uint32_t elementOffset, uint32_t elementCount, uint32_t strutureStride )
+{
+	return shared_ptr<ShaderResourceView>( new NullShaderResourceView() );
+}
+
+shared_ptr<UnorderedAccessView> NullFactory::CreateStructuredBufferUAV( const shared_ptr<GraphicsBuffer>& buffer, uint32_t elementOffset, uint32_t elementCount, uint32_t strutureStride )
+{
+	return shared_ptr<UnorderedAccessView>( new NullUnorderedAccessView() );
+}
+
+shared_ptr<UnorderedAccessView> NullFactory::CreateTextureBufferUAV( const shared_ptr<GraphicsBuffer>& buffer, uint32_t elementOffset, uint32_t elementCount, PixelFormat format )
+{
+	return shared_ptr<UnorderedAccessView>( new NullUnorderedAccessView() );
+}
+
+shared_ptr<RenderView> NullFactory::CreateRenderTargetView2D( const shared_ptr<Texture>& texture, uint32_t arrayIndex, uint32_t level )
+{
+	return shared_ptr<RenderView>( new NullRenderView(texture) );
+}
+
+shared_ptr<RenderView> NullFactory::CreateDepthStencilView( const shared_ptr<Texture>& texture, uint32_t arrayIndex, uint32_t level, uint32_t flags /*= 0*/ )
+{
+	return shared_ptr<RenderView>( new NullRenderView(texture) );
+}
+
+shared_ptr<RenderView> NullFactory::CreateRenderTargetViewArray( const shared_ptr<Texture>& texture, uint32_t level )
+{
+	return shared_ptr<RenderView>( new NullRenderView(texture) );
+}
+
+shared_ptr<Shader> NullFactory::CreateShader( ShaderType type )
+{
+	return shared_ptr<Shader>( new NullShader(type) );
+}
+
+shared_ptr<ShaderResourceView> NullFactory::CreateTexture3DSRV( const shared_ptr<Texture>& texture )
+{
+	return shared_ptr<ShaderResourceView>( new NullShaderResourceView() );
+}
+
+shared_ptr<ShaderResourceView> NullFactory::CreateTextureCubeSRV( const shared_ptr<Texture>& texture )
+{
+	return shared_ptr<ShaderResourceView>( new NullShaderResourceView() );
+}
+
+shared_ptr<ShaderResourceView> NullFactory::CreateTexture1DSRV( const shared_ptr<Texture>& texture, uint32_t mostDetailedMip, uint32_t mipLevels, uint32_t firstArraySlice, uint32_t arraySize )
+{
+	return shared_ptr<ShaderResourceView>( new NullShaderResourceView() );
+}
+
+shared_ptr<ShaderResourceView> NullFactory::CreateTexture2DSRV( const shared_ptr<Texture>& texture, uint32_t mostDetailedMip, uint32_t mipLevels, uint32_t firstArraySlice, uint32_t arraySize )
+{
+	return shared_ptr<ShaderResourceView>( new NullShaderResourceView() );
+}
+
+shared_ptr<UnorderedAccessView> NullFactory::CreateTexture1DUAV( const shared_ptr<Texture>& texture, uint32_t level, uint32_t firstArraySlice, uint32_t arraySize )
+{
+	return shared_ptr<UnorderedAccessView>( new NullUnorderedAccessView() );
+}
+
+shared_ptr<UnorderedAccessView> NullFactory::CreateTexture2DUAV( const shared_ptr<Texture>& texture, uint32_t level, uint32_t firstArraySlice, uint32_t arraySize )
+{
+	return shared_ptr<UnorderedAccessView>( new NullUnorderedAccessView() );
+}
+
+shared_ptr<UnorderedAccessView> NullFactory::CreateTexture3DUAV( const shared_ptr<Texture>& texture )
+{
+	return shared_ptr<UnorderedAccessView>( new NullUnorderedAccessView() );
+}
+
+shared_ptr<UnorderedAccessView> NullFactory::CreateTextureCubeUAV( const shared_ptr<Texture>& texture )
+{
+	return shared_ptr<UnorderedAccessView>( new NullUnorderedAccessView() );
+}
+
+shared_ptr<VertexDeclaration> NullFactory::CreateVertexDeclaration( VertexElement* elems, uint32_t count )
+{
+	return shared_ptr<VertexDeclaration>( new VertexDeclaration(elems, count) );
+}
+
+shared_ptr<ShaderPipeline> NullFactory::CreateShaderPipeline( Effect& effect )
+{
+	return shared_ptr<ShaderPipeline>( new NullShaderPipeline(effect) );
+}
+
+void NullFactory::InvalidateShaderFiles( const vector<String>& files )
+{
+	RenderFactory::InvalidateShaderFiles(files);
+
+	// Same include cache as OpenGL render system
+	GLSLPreprocessor::ClearIncludeCache();
+}
+
+shared_ptr<FrameBuffer> NullFactory::CreateFrameBuffer( uint32_t width, uint32_t height )
+{
+	return std::make_shared<NullFrameBuffer>(width, height);
+}
+
+shared_ptr<AmbientOcclusion::HBAOImpl> NullFactory::CreateHBAO(uint32_t aoWidth, uint32_t aoHeight)
+{
+	return std::make_shared<NullHBAOImpl>();
+}
+
+}
@@ -0,0 +1,11 @@
+#include "NullFrameBuffer.h"
+#include "NullDevice.h"
+
+namespace RcEngine {
+
+void NullRenderWindow::SwapBuffers()
+{
+	gNullDevice->EndFrame();
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef NullFrameBuffer_h__
+#define NullFrameBuffer_h__
+
+#include "NullPrerequisites.h"
+#include <Graphics/FrameBuffer.h>
+
+namespace RcEngine {
+
+class _NullExport NullFrameBuffer : public FrameBuffer
+{
+public:
+	NullFrameBuffer(uint32_t width, uint32_t height) : FrameBuffer(width, height) {}
+
+	virtual void SwapBuffers() {}
+
+protected:
+	void OnBind() {}
+	void OnUnbind() {}
+};
+
+/**
+ * Screen frame buffer, SwapBuffers ends the frame of null device.
+ */
+class _NullExport NullRenderWindow : public NullFrameBuffer
+{
+public:
+	NullRenderWindow(uint32_t width, uint32_t height) : NullFrameBuffer(width, height) {}
+
+	void SwapBuffers();
+};
+
+}
+
+#endif // NullFrameBuffer_h__
@@ -0,0 +1,35 @@
+#include "NullModule.h"
+#include "NullDevice.h"
+
+namespace RcEngine {
+
+const static std::string ModuleName = "Null RenderSystem";
+
+NullModule::NullModule(void)
+	: mRenderDevice(0)
+{
+}
+
+
+NullModule::~NullModule(void)
+{
+}
+
+const std::string& NullModule::GetName() const
+{
+	return ModuleName;
+}
+
+void NullModule::Initialise()
+{
+	mRenderDevice = new NullDevice();
+	mRenderDevice->CreateRenderWindow();
+}
+
+void NullModule::Shutdown()
+{
+	delete mRenderDevice;
+	mRenderDevice = 0;
+}
+
+}
@@ -0,0 +1,28 @@
+#ifndef NullModule_h__
+#define NullModule_h__
+
+#include "NullPrerequisites.h"
+#include <Core/IModule.h>
+
+namespace RcEngine {
+
+class NullDevice;
+
+class _NullExport NullModule : public IModule
+{
+public:
+	NullModule(void);
+	~NullModule(void);
+
+	const String& GetName() const ;
+	void Initialise();
+	void Shutdown();
+	
+private:
+	NullDevice* mRenderDevice;
+};
+
+}
+
+
+#endif // NullModule_h__
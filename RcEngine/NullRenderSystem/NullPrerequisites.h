@@ -0,0 +1,22 @@
+#ifndef NullPrerequisites_h__
+#define NullPrerequisites_h__
+
+//////////////////////////////////////////////////////////////////////////
+#include <Core/Prerequisites.h>
+
+//////////////////////////////////////////////////////////////////////////
+#ifndef BUILD_STATIC
+#	if defined(RcWindows)
+#		ifdef NULLRENDERSYSTEM_EXPORTS
+#			define _NullExport __declspec(dllexport)
+#		else
+#    		define _NullExport __declspec(dllimport) 
+#		endif
+#	else
+#		define _NullExport __attribute__ ((visibility("default")))
+#	endif
+#else
+#	define _NullExport
+#endif	
+
+#endif // NullPrerequisites_h__
@@ -0,0 +1,925 @@
+#include "NullShader.h"
+#include "NullDevice.h"
+#include <Graphics/EffectParameter.h>
+#include <Graphics/Effect.h>
+#include <Graphics/GLSLPreprocessor.h>
+#include <Graphics/RenderState.h>
+#include <Core/Exception.h>
+
+namespace RcEngine {
+
+namespace {
+
+// Replace comments with a space, line breaks are kept
+String StripComments(const String& source)
+{
+	String result;
+	result.reserve(source.size());
+
+	size_t i = 0, n = source.size();
+	while (i < n)
+	{
+		if (source[i] == '/' && i + 1 < n && source[i+1] == '/')
+		{
+			while (i < n && source[i] != '\n') ++i;
+		}
+		else if (source[i] == '/' && i + 1 < n && source[i+1] == '*')
+		{
+			for (i += 2; i < n && !(source[i] == '*' && i + 1 < n && source[i+1] == '/'); ++i)
+			{
+				if (source[i] == '\n')
+					result += '\n';
+			}
+			i = (std::min)(i + 2, n);
+			result += ' ';
+		}
+		else
+			result += source[i++];
+	}
+
+	return result;
+}
+
+inline bool IsIdentifierChar(char c)
+{
+	return isalnum((unsigned char)c) || c == '_';
+}
+
+void Tokenize(const String& text, vector<String>& tokens)
+{
+	static const char* TwoCharOps[] = { "&&", "||", "==", "!=", "<=", ">=", "<<", ">>" };
+
+	size_t i = 0, n = text.size();
+	while (i < n)
+	{
+		char c = text[i];
+		if (isspace((unsigned char)c))
+		{
+			++i;
+		}
+		else if (IsIdentifierChar(c))
+		{
+			// Identifier or number, fraction of float literals are kept in the number
+			size_t s = i;
+			while (i < n && (IsIdentifierChar(text[i]) || (isdigit((unsigned char)c) && text[i] == '.'))) ++i;
+			tokens.push_back(text.substr(s, i - s));
+		}
+		else
+		{
+			size_t len = 1;
+			for (const char* op : TwoCharOps)
+			{
+				if (text.compare(i, 2, op) == 0)
+					len = 2;
+			}
+
+			tokens.push_back(text.substr(i, len));
+			i += len;
+		}
+	}
+}
+
+String Trim(const String& str)
+{
+	size_t s = str.find_first_not_of(" \t\r\n");
+	if (s == String::npos)
+		return String();
+
+	size_t e = str.find_last_not_of(" \t\r\n");
+	return str.substr(s, e - s + 1);
+}
+
+inline uint32_t RoundUp(uint32_t value, uint32_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+typedef std::map<String, String> DefineMap;
+
+/**
+ * Integer expression of #if directives and array sizes. Undefined identifiers are 0,
+ * macros are evaluated recursively.
+ */
+class ExpressionEvaluator
+{
+public:
+	ExpressionEvaluator(const vector<String>& tokens, const DefineMap& defines, uint32_t depth = 0)
+		: mTokens(tokens), mDefines(defines), mDepth(depth), mPos(0) {}
+
+	long Evaluate()
+	{
+		mPos = 0;
+		return ParseBinary(1);
+	}
+
+private:
+	static int Precedence(const String& op)
+	{
+		if (op == "*" || op == "/" || op == "%") return 10;
+		if (op == "+" || op == "-") return 9;
+		if (op == "<<" || op == ">>") return 8;
+		if (op == "<" || op == ">" || op == "<=" || op == ">=") return 7;
+		if (op == "==" || op == "!=") return 6;
+		if (op == "&") return 5;
+		if (op == "^") return 4;
+		if (op == "|") return 3;
+		if (op == "&&") return 2;
+		if (op == "||") return 1;
+		return 0;
+	}
+
+	static long Apply(const String& op, long lhs, long rhs)
+	{
+		if (op == "*") return lhs * rhs;
+		if (op == "/") return rhs ? lhs / rhs : 0;
+		if (op == "%") return rhs ? lhs % rhs : 0;
+		if (op == "+") return lhs + rhs;
+		if (op == "-") return lhs - rhs;
+		if (op == "<<") return lhs << rhs;
+		if (op == ">>") return lhs >> rhs;
+		if (op == "<") return lhs < rhs;
+		if (op == ">") return lhs > rhs;
+		if (op == "<=") return lhs <= rhs;
+		if (op == ">=") return lhs >= rhs;
+		if (op == "==") return lhs == rhs;
+		if (op == "!=") return lhs != rhs;
+		if (op == "&") return lhs & rhs;
+		if (op == "^") return lhs ^ rhs;
+		if (op == "|") return lhs | rhs;
+		if (op == "&&") return lhs && rhs;
+		return lhs || rhs;
+	}
+
+	long ParseBinary(int minPrecedence)
+	{
+		long lhs = ParseUnary();
+		while (mPos < mTokens.size())
+		{
+			int precedence = Precedence(mTokens[mPos]);
+			if (precedence == 0 || precedence < minPrecedence)
+				break;
+
+			String op = mTokens[mPos++];
+			long rhs = ParseBinary(precedence + 1);
+			lhs = Apply(op, lhs, rhs);
+		}
+		return lhs;
+	}
+
+	long ParseUnary()
+	{
+		if (mPos >= mTokens.size())
+			return 0;
+
+		const String& token = mTokens[mPos];
+		if (token == "!") { ++mPos; return !ParseUnary(); }
+		if (token == "~") { ++mPos; return ~ParseUnary(); }
+		if (token == "-") { ++mPos; return -ParseUnary(); }
+		if (token == "+") { ++mPos; return ParseUnary(); }
+
+		return ParsePrimary();
+	}
+
+	long ParsePrimary()
+	{
+		const String& token = mTokens[mPos++];
+
+		if (token == "(")
+		{
+			long value = ParseBinary(1);
+			if (mPos < mTokens.size() && mTokens[mPos] == ")")
+				++mPos;
+			return value;
+		}
+
+		if (isdigit((unsigned char)token[0]))
+			return strtol(token.c_str(), nullptr, 0);
+
+		if (token == "defined")
+		{
+			bool paren = (mPos < mTokens.size() && mTokens[mPos] == "(");
+			if (paren) ++mPos;
+
+			long value = 0;
+			if (mPos < mTokens.size())
+				value = mDefines.count(mTokens[mPos++]) ? 1 : 0;
+
+			if (paren && mPos < mTokens.size() && mTokens[mPos] == ")")
+				++mPos;
+			return value;
+		}
+
+		auto it = mDefines.find(token);
+		if (it != mDefines.end() && mDepth < 16)
+		{
+			vector<String> tokens;
+			Tokenize(it->second, tokens);
+			return ExpressionEvaluator(tokens, mDefines, mDepth + 1).Evaluate();
+		}
+
+		return 0;
+	}
+
+private:
+	const vector<String>& mTokens;
+	const DefineMap& mDefines;
+	uint32_t mDepth;
+	size_t mPos;
+};
+
+typedef std::map<String, std::pair<EffectParameterType, ShaderParameterClass> > GLSLTypeMap;
+
+// Built before main, shaders are reflected on JobSystem workers
+GLSLTypeMap CreateTypeMap()
+{
+	GLSLTypeMap TypeMap;
+	TypeMap["float"] = std::make_pair(EPT_Float, Shader_Param_Uniform);
+	TypeMap["vec2"]  = std::make_pair(EPT_Float2, Shader_Param_Uniform);
+	TypeMap["vec3"]  = std::make_pair(EPT_Float3, Shader_Param_Uniform);
+	TypeMap["vec4"]  = std::make_pair(EPT_Float4, Shader_Param_Uniform);
+	TypeMap["uint"]  = std::make_pair(EPT_UInt, Shader_Param_Uniform);
+	TypeMap["uvec2"] = std::make_pair(EPT_UInt2, Shader_Param_Uniform);
+	TypeMap["uvec3"] = std::make_pair(EPT_UInt3, Shader_Param_Uniform);
+	TypeMap["uvec4"] = std::make_pair(EPT_UInt4, Shader_Param_Uniform);
+	TypeMap["int"]   = std::make_pair(EPT_Int, Shader_Param_Uniform);
+	TypeMap["ivec2"] = std::make_pair(EPT_Int2, Shader_Param_Uniform);
+	TypeMap["ivec3"] = std::make_pair(EPT_Int3, Shader_Param_Uniform);
+	TypeMap["ivec4"] = std::make_pair(EPT_Int4, Shader_Param_Uniform);
+	TypeMap["bool"]  = std::make_pair(EPT_Boolean, Shader_Param_Uniform);
+	TypeMap["mat2"]  = std::make_pair(EPT_Matrix2x2, Shader_Param_Uniform);
+	TypeMap["mat3"]  = std::make_pair(EPT_Matrix3x3, Shader_Param_Uniform);
+	TypeMap["mat4"]  = std::make_pair(EPT_Matrix4x4, Shader_Param_Uniform);
+	TypeMap["mat2x2"] = TypeMap["mat2"];
+	TypeMap["mat3x3"] = TypeMap["mat3"];
+	TypeMap["mat4x4"] = TypeMap["mat4"];
+
+	// Integer samplers and images map as float ones
+	TypeMap["sampler1D"]			= std::make_pair(EPT_Texture1D, Shader_Param_SRV);
+	TypeMap["sampler1DShadow"]		= std::make_pair(EPT_Texture1D, Shader_Param_SRV);
+	TypeMap["sampler2D"]			= std::make_pair(EPT_Texture2D, Shader_Param_SRV);
+	TypeMap["sampler2DMS"]			= std::make_pair(EPT_Texture2D, Shader_Param_SRV);
+	TypeMap["sampler2DShadow"]		= std::make_pair(EPT_Texture2D, Shader_Param_SRV);
+	TypeMap["sampler3D"]			= std::make_pair(EPT_Texture3D, Shader_Param_SRV);
+	TypeMap["samplerCube"]			= std::make_pair(EPT_TextureCube, Shader_Param_SRV);
+	TypeMap["samplerCubeShadow"]	= std::make_pair(EPT_TextureCube, Shader_Param_SRV);
+	TypeMap["sampler1DArray"]		= std::make_pair(EPT_Texture1DArray, Shader_Param_SRV);
+	TypeMap["sampler1DArrayShadow"]	= std::make_pair(EPT_Texture1DArray, Shader_Param_SRV);
+	TypeMap["sampler2DArray"]		= std::make_pair(EPT_Texture2DArray, Shader_Param_SRV);
+	TypeMap["sampler2DMSArray"]		= std::make_pair(EPT_Texture2DArray, Shader_Param_SRV);
+	TypeMap["sampler2DArrayShadow"]	= std::make_pair(EPT_Texture2DArray, Shader_Param_SRV);
+	TypeMap["samplerBuffer"]		= std::make_pair(EPT_TextureBuffer, Shader_Param_SRV);
+	TypeMap["image1D"]				= std::make_pair(EPT_Texture1D, Shader_Param_UAV);
+	TypeMap["image1DArray"]			= std::make_pair(EPT_Texture1DArray, Shader_Param_UAV);
+	TypeMap["image2D"]				= std::make_pair(EPT_Texture2D, Shader_Param_UAV);
+	TypeMap["image2DArray"]			= std::make_pair(EPT_Texture2DArray, Shader_Param_UAV);
+	TypeMap["image3D"]				= std::make_pair(EPT_Texture3D, Shader_Param_UAV);
+	TypeMap["imageBuffer"]			= std::make_pair(EPT_TextureBuffer, Shader_Param_UAV);
+
+	return TypeMap;
+}
+
+const GLSLTypeMap TypeMap = CreateTypeMap();
+
+bool UnMapping(const String& glslType, EffectParameterType& paramType, ShaderParameterClass& paramClass)
+{
+	String type = glslType;
+	if (type.size() > 1 && (type[0] == 'i' || type[0] == 'u') && (type.compare(1, 7, "sampler") == 0 || type.compare(1, 5, "image") == 0))
+		type = type.substr(1);
+
+	auto it = TypeMap.find(type);
+	if (it == TypeMap.end())
+		return false;
+
+	paramType = it->second.first;
+	paramClass = it->second.second;
+	return true;
+}
+
+// Size and base alignment of a non array std140 member
+void GetStd140Layout(EffectParameterType type, uint32_t& size, uint32_t& alignment)
+{
+	switch (type)
+	{
+	case EPT_Float2: case EPT_Int2: case EPT_UInt2:
+		size = alignment = 8;
+		break;
+	case EPT_Float3: case EPT_Int3: case EPT_UInt3:
+		size = 12; alignment = 16;
+		break;
+	case EPT_Float4: case EPT_Int4: case EPT_UInt4:
+		size = alignment = 16;
+		break;
+	case EPT_Matrix2x2:
+		size = 32; alignment = 16;
+		break;
+	case EPT_Matrix3x3:
+		size = 48; alignment = 16;
+		break;
+	case EPT_Matrix4x4:
+		size = 64; alignment = 16;
+		break;
+	default:
+		size = alignment = 4;
+		break;
+	}
+}
+
+bool IsQualifier(const String& token)
+{
+	static const char* Qualifiers[] = {
+		"const", "readonly", "writeonly", "coherent", "volatile", "restrict", "highp", "mediump", "lowp",
+		"flat", "smooth", "noperspective", "centroid", "sample", "patch", "invariant", "precise"
+	};
+
+	for (const char* qualifier : Qualifiers)
+	{
+		if (token == qualifier)
+			return true;
+	}
+	return false;
+}
+
+// Remove layout(...) and qualifiers
+void StripQualifiers(const vector<String>& tokens, vector<String>& oStripped)
+{
+	for (size_t i = 0; i < tokens.size(); ++i)
+	{
+		if (tokens[i] == "layout" && i + 1 < tokens.size() && tokens[i+1] == "(")
+		{
+			while (i < tokens.size() && tokens[i] != ")") ++i;
+		}
+		else if (!IsQualifier(tokens[i]))
+			oStripped.push_back(tokens[i]);
+	}
+}
+
+} // Anonymous namespace
+
+//////////////////////////////////////////////////////////////////////////
+class GLSLSourceReflection
+{
+public:
+	GLSLSourceReflection(NullShader* shader) : mShader(shader) {}
+
+	void Reflect(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint)
+	{
+		// Section, macros and includes are found as OpenGL render system does
+		GLSLSource glslSource;
+		GLSLPreprocessor::Preprocess(filename, mShader->mShaderType, macros, macroCount, entryPoint, "#version 430", glslSource);
+
+		GLSLPreprocessor::GetSourceFiles(filename, glslSource, mShader->mSourceFiles);
+		mShader->mSamplerStates = glslSource.SamplerStates;
+
+		// Conditionals are left to the driver by OpenGL, here they select the active declarations
+		String activeSource;
+		Preprocess(glslSource.Source, activeSource, 0);
+
+		ReflectDeclarations(activeSource);
+	}
+
+private:
+	struct Conditional
+	{
+		bool Active;
+		bool Taken;
+		bool ParentActive;
+	};
+
+	inline bool IsActive() const
+	{
+		return mConditionals.empty() || mConditionals.back().Active;
+	}
+
+	void Preprocess(const String& source, String& output, uint32_t includeDepth)
+	{
+		String text = StripComments(source);
+
+		size_t lineBegin = 0;
+		while (lineBegin < text.size())
+		{
+			size_t lineEnd = text.find('\n', lineBegin);
+			if (lineEnd == String::npos)
+				lineEnd = text.size();
+
+			String line = text.substr(lineBegin, lineEnd - lineBegin);
+			lineBegin = lineEnd + 1;
+
+			// Line continuation
+			while (!line.empty() && Trim(line).back() == '\\' && lineBegin < text.size())
+			{
+				line = Trim(line);
+				line.pop_back();
+
+				lineEnd = text.find('\n', lineBegin);
+				if (lineEnd == String::npos)
+					lineEnd = text.size();
+
+				line += text.substr(lineBegin, lineEnd - lineBegin);
+				lineBegin = lineEnd + 1;
+			}
+
+			size_t s = line.find_first_not_of(" \t\r");
+			if (s != String::npos && line[s] == '#')
+			{
+				ProcessDirective(line.substr(s + 1), output, includeDepth);
+			}
+			else if (IsActive())
+			{
+				output += line;
+				output += '\n';
+			}
+		}
+	}
+
+	void ProcessDirective(const String& line, String& output, uint32_t includeDepth)
+	{
+		size_t s = line.find_first_not_of(" \t");
+		if (s == String::npos)
+			return;
+
+		size_t e = s;
+		while (e < line.size() && isalpha((unsigned char)line[e])) ++e;
+
+		String directive = line.substr(s, e - s);
+		String argument = Trim(line.substr(e));
+
+		if (directive == "ifdef" || directive == "ifndef" || directive == "if")
+		{
+			Conditional cond;
+			cond.ParentActive = IsActive();
+
+			bool value;
+			if (directive == "if")
+				value = EvaluateCondition(argument);
+			else
+				value = (mDefines.count(FirstIdentifier(argument)) != 0) == (directive == "ifdef");
+
+			cond.Active = cond.Taken = cond.ParentActive && value;
+			mConditionals.push_back(cond);
+		}
+		else if (directive == "elif")
+		{
+			if (mConditionals.empty())
+				ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "#elif without #if", "NullShader::LoadFromFile");
+
+			Conditional& cond = mConditionals.back();
+			cond.Active = !cond.Taken && cond.ParentActive && EvaluateCondition(argument);
+			cond.Taken = cond.Taken || cond.Active;
+		}
+		else if (directive == "else")
+		{
+			if (mConditionals.empty())
+				ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "#else without #if", "NullShader::LoadFromFile");
+
+			Conditional& cond = mConditionals.back();
+			cond.Active = !cond.Taken && cond.ParentActive;
+			cond.Taken = true;
+		}
+		else if (directive == "endif")
+		{
+			if (mConditionals.empty())
+				ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "#endif without #if", "NullShader::LoadFromFile");
+
+			mConditionals.pop_back();
+		}
+		else if (!IsActive())
+		{
+			return;
+		}
+		else if (directive == "define")
+		{
+			String name = FirstIdentifier(argument);
+			if (!name.empty())
+			{
+				// Function like macros are only tracked for defined()
+				if (argument.size() > name.size() && argument[name.size()] == '(')
+					mDefines[name] = "";
+				else
+					mDefines[name] = Trim(argument.substr(name.size()));
+			}
+		}
+		else if (directive == "undef")
+		{
+			mDefines.erase(FirstIdentifier(argument));
+		}
+		else if (directive == "include")
+		{
+			size_t quoteBegin = argument.find('\"');
+			size_t quoteEnd = argument.find('\"', quoteBegin + 1);
+			if (quoteBegin == String::npos || quoteEnd == String::npos)
+				ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Invalid #include " + argument, "NullShader::LoadFromFile");
+
+			if (includeDepth > 32)
+				ENGINE_EXCEPT(Exception::ERR_INVALID_STATE, "#include nested too deep", "NullShader::LoadFromFile");
+
+			String includeName = argument.substr(quoteBegin + 1, quoteEnd - quoteBegin - 1);
+			Preprocess(GLSLPreprocessor::GetIncludeSource(includeName), output, includeDepth + 1);
+		}
+		// #version, #extension, #line, #error and #pragma are not needed for reflection
+	}
+
+	static String FirstIdentifier(const String& text)
+	{
+		size_t s = 0;
+		while (s < text.size() && !IsIdentifierChar(text[s])) ++s;
+
+		size_t e = s;
+		while (e < text.size() && IsIdentifierChar(text[e])) ++e;
+
+		return text.substr(s, e - s);
+	}
+
+	bool EvaluateCondition(const String& expression) const
+	{
+		vector<String> tokens;
+		Tokenize(expression, tokens);
+		return ExpressionEvaluator(tokens, mDefines).Evaluate() != 0;
+	}
+
+	uint32_t EvaluateArraySize(const vector<String>& tokens) const
+	{
+		long size = ExpressionEvaluator(tokens, mDefines).Evaluate();
+		return (size <= 1) ? 0 : uint32_t(size);
+	}
+
+	void ReflectDeclarations(const String& source)
+	{
+		vector<String> tokens;
+		Tokenize(source, tokens);
+
+		vector<String> statement;
+
+		size_t i = 0;
+		while (i < tokens.size())
+		{
+			if (tokens[i] == "{")
+			{
+				size_t blockEnd = i + 1;
+				for (int depth = 1; blockEnd < tokens.size(); ++blockEnd)
+				{
+					if (tokens[blockEnd] == "{") depth++;
+					else if (tokens[blockEnd] == "}" && --depth == 0) break;
+				}
+
+				vector<String> declaration;
+				StripQualifiers(statement, declaration);
+
+				bool isUniformBlock = std::find(declaration.begin(), declaration.end(), "uniform") != declaration.end();
+				bool isStorageBlock = std::find(declaration.begin(), declaration.end(), "buffer") != declaration.end();
+				if ((isUniformBlock || isStorageBlock) && !declaration.empty())
+				{
+					vector<String> members(tokens.begin() + i + 1, tokens.begin() + (std::min)(blockEnd, tokens.size()));
+					ReflectBlock(declaration.back(), isStorageBlock, members);
+
+					// Skip instance name
+					while (blockEnd < tokens.size() && tokens[blockEnd] != ";") ++blockEnd;
+				}
+
+				// Function bodies, structures and other blocks are skipped
+				statement.clear();
+				i = blockEnd + 1;
+			}
+			else if (tokens[i] == ";")
+			{
+				vector<String> declaration;
+				StripQualifiers(statement, declaration);
+
+				if (!declaration.empty() && declaration[0] == "uniform")
+					ReflectUniform(declaration);
+
+				statement.clear();
+				++i;
+			}
+			else
+			{
+				statement.push_back(tokens[i++]);
+			}
+		}
+	}
+
+	// Parse "type name[size], name ..." from tokens[start], initializers are skipped
+	template <typename Func>
+	void ParseDeclarators(const vector<String>& tokens, size_t start, Func func)
+	{
+		if (start + 1 >= tokens.size())
+			return;
+
+		const String& type = tokens[start];
+
+		size_t i = start + 1;
+		while (i < tokens.size())
+		{
+			String name = tokens[i++];
+
+			uint32_t arraySize = 0;
+			if (i < tokens.size() && tokens[i] == "[")
+			{
+				size_t sizeEnd = i + 1;
+				while (sizeEnd < tokens.size() && tokens[sizeEnd] != "]") ++sizeEnd;
+
+				vector<String> sizeTokens(tokens.begin() + i + 1, tokens.begin() + sizeEnd);
+				arraySize = EvaluateArraySize(sizeTokens);
+				i = sizeEnd + 1;
+			}
+
+			func(type, name, arraySize);
+
+			// Skip initializer to next declarator
+			for (int depth = 0; i < tokens.size(); ++i)
+			{
+				if (tokens[i] == "(") depth++;
+				else if (tokens[i] == ")") depth--;
+				else if (tokens[i] == "," && depth == 0) { ++i; break; }
+			}
+		}
+	}
+
+	void ReflectUniform(const vector<String>& declaration)
+	{
+		ParseDeclarators(declaration, 1, [&](const String& type, const String& name, uint32_t arraySize) {
+
+			EffectParameterType paramType;
+			ShaderParameterClass paramClass;
+			if (!UnMapping(type, paramType, paramClass))
+				return; // Structures are not supported
+
+			if (paramClass == Shader_Param_Uniform)
+			{
+				NullUniformParam uniform;
+				uniform.Name = name;
+				uniform.Type = paramType;
+				uniform.ArraySize = arraySize;
+				uniform.Offset = 0;
+				uniform.ArrayStride = 0;
+
+				if (mGlobalBlockIdx == -1)
+				{
+					// Add global uniform block
+					mGlobalBlockIdx = mShader->mUniformBuffers.size();
+					mShader->mUniformBuffers.resize(mGlobalBlockIdx + 1);
+					mShader->mUniformBuffers.back().Global = true;
+					mShader->mUniformBuffers.back().BufferSize = 0;
+				}
+
+				mShader->mUniformBuffers[mGlobalBlockIdx].BufferVariables.push_back(uniform);
+			}
+			else
+			{
+				// SRV: Texture or TBuffer
+				// UAV: Image or ImageBuffer
+				NullResouceViewParam viewParam;
+				viewParam.Name = name;
+				viewParam.Type = paramType;
+				viewParam.ViewClass = paramClass;
+				mShader->mBoundResources.push_back(viewParam);
+			}
+		});
+	}
+
+	void ReflectBlock(const String& blockName, bool storageBlock, const vector<String>& members)
+	{
+		if (storageBlock)
+		{
+			NullResouceViewParam viewParam;
+			viewParam.Type = EPT_StructureBuffer;
+
+			if (blockName.find("SRV") != String::npos)
+			{
+				viewParam.Name = blockName.substr(0, blockName.find("SRV"));
+				viewParam.ViewClass = Shader_Param_SRV;
+			}
+			else if (blockName.find("UAV") != String::npos)
+			{
+				viewParam.Name = blockName.substr(0, blockName.find("UAV"));
+				viewParam.ViewClass = Shader_Param_UAV;
+			}
+			else
+			{
+				ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "GLSL StructureBuffer must be postfix with SRV or UAV", "ReflectResource");
+			}
+
+			mShader->mBoundResources.push_back(viewParam);
+			return;
+		}
+
+		// Uniform block with std140 layout
+		NullUniformBuffer uniformBuffer;
+		uniformBuffer.Name = blockName;
+		uniformBuffer.Global = false;
+
+		uint32_t offset = 0;
+
+		vector<String> memberDecl;
+		for (size_t i = 0; i < members.size(); ++i)
+		{
+			if (members[i] != ";")
+			{
+				memberDecl.push_back(members[i]);
+				continue;
+			}
+
+			vector<String> declaration;
+			StripQualifiers(memberDecl, declaration);
+			memberDecl.clear();
+
+			ParseDeclarators(declaration, 0, [&](const String& type, const String& name, uint32_t arraySize) {
+
+				NullUniformParam bufferVariable;
+				ShaderParameterClass paramClass;
+				if (!UnMapping(type, bufferVariable.Type, paramClass) || paramClass != Shader_Param_Uniform)
+					ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported uniform block member " + name, "ReflectResource");
+
+				uint32_t size, alignment;
+				GetStd140Layout(bufferVariable.Type, size, alignment);
+
+				bufferVariable.Name = name;
+				bufferVariable.ArraySize = arraySize;
+				if (arraySize > 0)
+				{
+					// Array elements are aligned to vec4
+					bufferVariable.ArrayStride = RoundUp(size, 16);
+					bufferVariable.Offset = RoundUp(offset, 16);
+					offset = bufferVariable.Offset + bufferVariable.ArrayStride * arraySize;
+				}
+				else
+				{
+					bufferVariable.ArrayStride = 0;
+					bufferVariable.Offset = RoundUp(offset, alignment);
+					offset = bufferVariable.Offset + size;
+				}
+
+				uniformBuffer.BufferVariables.push_back(bufferVariable);
+			});
+		}
+
+		uniformBuffer.BufferSize = RoundUp(offset, 16);
+		mShader->mUniformBuffers.push_back(uniformBuffer);
+	}
+
+private:
+	NullShader* mShader;
+
+	DefineMap mDefines;
+	vector<Conditional> mConditionals;
+
+	int32_t mGlobalBlockIdx = -1;
+};
+
+//////////////////////////////////////////////////////////////////////////
+NullShader::NullShader( ShaderType shaderType )
+	: Shader(shaderType),
+	  mPrepared(false)
+{
+}
+
+NullShader::~NullShader()
+{
+
+}
+
+bool NullShader::LoadFromByteCode( const String& filename )
+{
+	ENGINE_EXCEPT(Exception::ERR_NOT_IMPLEMENTED, "Null render system can't load shader byte code!", "NullShader::LoadFromByteCode");
+	return false;
+}
+
+void NullShader::PrepareFromFile( const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint /*= ""*/ )
+{
+	GLSLSourceReflection reflection(this);
+	reflection.Reflect(filename, macros, macroCount, entryPoint);
+	mPrepared = true;
+}
+
+bool NullShader::LoadFromFile( const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint /*= ""*/ )
+{
+	// Nothing needs a device, all is done in PrepareFromFile
+	if (!mPrepared)
+		PrepareFromFile(filename, macros, macroCount, entryPoint);
+
+	mPrepared = false;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+NullShaderPipeline::NullShaderPipeline( Effect& effect )
+	: ShaderPipeline(effect)
+{
+
+}
+
+NullShaderPipeline::~NullShaderPipeline()
+{
+
+}
+
+void NullShaderPipeline::OnBind()
+{
+	for (EffectConstantBuffer* constantBuffer : mConstantBuffers)
+		constantBuffer->UpdateBuffer();
+
+	for (const auto& samplerBind : mSamplerBinds)
+	{
+		weak_ptr<SamplerState> sampler;
+		samplerBind.first->GetValue(sampler);
+
+		if (auto spt = sampler.lock())
+			gNullDevice->SetSamplerState(ST_Pixel, samplerBind.second, spt);
+	}
+}
+
+void NullShaderPipeline::OnUnbind()
+{
+
+}
+
+bool NullShaderPipeline::LinkPipeline()
+{
+	uint32_t srvBinding = 0;
+	uint32_t uavBinding = 0;
+	std::map<String, uint32_t> bindingCache;
+
+	for (int i = 0; i < ST_Count; ++i)
+	{
+		if (mShaderStages[i])
+		{
+			NullShader* shaderNull = static_cast<NullShader*>(mShaderStages[i].get());
+
+			// Uniform buffers
+			for (const NullUniformBuffer& uniformBlock : shaderNull->mUniformBuffers)
+			{
+				if (uniformBlock.Global)
+				{
+					for (const auto& globalUniform : uniformBlock.BufferVariables)
+						mEffect.FetchUniformParameter(globalUniform.Name, globalUniform.Type, globalUniform.ArraySize);
+				}
+				else
+				{
+					EffectConstantBuffer* uniformBuffer = mEffect.FetchConstantBuffer(uniformBlock.Name, uniformBlock.BufferSize);
+
+					if (uniformBuffer->GetNumVariables() > 0) // Already created
+					{
+						// check buffer variables
+						assert(uniformBuffer->GetNumVariables() == uniformBlock.BufferVariables.size());
+						for (size_t i = 0; i < uniformBlock.BufferVariables.size(); ++i)
+						{
+							EffectParameter* variable = uniformBuffer->GetVariable(i);
+							if (variable->GetName() != uniformBlock.BufferVariables[i].Name				||
+								variable->GetParameterType() != uniformBlock.BufferVariables[i].Type	||
+								variable->GetElementSize() != uniformBlock.BufferVariables[i].ArraySize ||
+								variable->GetOffset() != uniformBlock.BufferVariables[i].Offset)
+							{
+								ENGINE_EXCEPT(Exception::ERR_INVALID_STATE, "Error: Same uniform buffer with different variables!", "NullShaderPipeline::LinkPipeline");
+							}
+						}
+					}
+					else
+					{
+						for (const auto& bufferVariable : uniformBlock.BufferVariables)
+						{
+							EffectParameter* variable = mEffect.FetchUniformParameter(bufferVariable.Name, bufferVariable.Type, bufferVariable.ArraySize);
+							uniformBuffer->AddVariable(variable, bufferVariable.Offset);
+
+							if (bufferVariable.ArraySize > 1)
+								variable->SetArrayStride(bufferVariable.ArrayStride);
+
+							if (bufferVariable.Type >= EPT_Matrix2x2 && bufferVariable.Type <= EPT_Matrix4x4)
+								variable->SetMatrixStride(sizeof(float4));  // always float4
+						}
+					}
+
+					if (std::find(mConstantBuffers.begin(), mConstantBuffers.end(), uniformBuffer) == mConstantBuffers.end())
+						mConstantBuffers.push_back(uniformBuffer);
+				}
+			}
+
+			// Shader resource views
+			for (const NullResouceViewParam& viewParam : shaderNull->mBoundResources)
+			{
+				if (bindingCache.find(viewParam.Name) == bindingCache.end())
+				{
+					if (viewParam.ViewClass == Shader_Param_SRV)
+					{
+						bindingCache[viewParam.Name] = srvBinding++;
+						mEffect.FetchSRVParameter(viewParam.Name, viewParam.Type);
+					}
+					else
+					{
+						bindingCache[viewParam.Name] = uavBinding++;
+						mEffect.FetchUAVParameter(viewParam.Name, viewParam.Type);
+					}
+				}
+			}
+
+			// SamplerState
+			for (auto& kv : shaderNull->mSamplerStates)
+			{
+				EffectParameter* effectParam = mEffect.FetchSamplerParameter(kv.second);
+				mSamplerBinds.push_back( std::make_pair(effectParam, bindingCache[kv.first]) );
+			}
+		}
+	}
+
+	return true;
+}
+
+}
@@ -0,0 +1,84 @@
+#ifndef NullShader_h__
+#define NullShader_h__
+
+#include "NullPrerequisites.h"
+#include <Graphics/GraphicsResource.h>
+#include <Graphics/GraphicsCommon.h>
+
+namespace RcEngine {
+
+struct NullUniformParam
+{
+	String Name;
+	uint32_t Offset;
+	uint32_t ArraySize;
+	uint32_t ArrayStride;
+	EffectParameterType Type;
+};
+
+struct NullUniformBuffer
+{
+	String Name;
+	bool Global;			// Uniforms outside of blocks
+	uint32_t BufferSize;
+	vector<NullUniformParam> BufferVariables;
+};
+
+struct NullResouceViewParam
+{
+	String Name;
+	EffectParameterType Type;
+	ShaderParameterClass ViewClass;
+};
+
+class EffectConstantBuffer;
+class EffectParameter;
+
+/**
+ * Shader without GPU program. GLSL source is preprocessed and declarations of the active
+ * code are reflected, so effect parameters and constant buffers are created as with the
+ * OpenGL render system. Unlike the driver, declared but unused parameters are reported too.
+ */
+class _NullExport NullShader : public Shader
+{
+public:
+	NullShader(ShaderType shaderType);
+	virtual ~NullShader();
+
+	virtual bool LoadFromByteCode(const String& filename);
+	virtual bool LoadFromFile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint = "");
+	virtual void PrepareFromFile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint = "");
+
+private:
+	friend class GLSLSourceReflection;
+	friend class NullShaderPipeline;
+
+	std::vector<NullResouceViewParam> mBoundResources;
+	std::vector<NullUniformBuffer> mUniformBuffers;
+	std::map<String, String> mSamplerStates;
+
+	bool mPrepared;
+};
+
+class _NullExport NullShaderPipeline : public ShaderPipeline
+{
+public:
+	NullShaderPipeline(Effect& effect);
+	virtual ~NullShaderPipeline();
+
+	virtual void OnBind();
+	virtual void OnUnbind();
+	virtual bool LinkPipeline();
+
+private:
+	// Constant buffers are mapped and written on bind like a real device does
+	std::vector<EffectConstantBuffer*> mConstantBuffers;
+	std::vector< std::pair<EffectParameter*, uint32_t> > mSamplerBinds;
+};
+
+
+}
+
+
+
+#endif // NullShader_h__
@@ -0,0 +1,180 @@
+#include "NullTexture.h"
+#include "NullView.h"
+#include <Core/Exception.h>
+
+namespace RcEngine {
+
+static uint32_t GetCompressedBlockSize(PixelFormat format)
+{
+	switch (format)
+	{
+	case PF_RGB_DXT1_UNORM:
+	case PF_RGBA_DXT1_UNORM:
+	case PF_SRGB_DXT1_UNORM:
+	case PF_SRGB_ALPHA_DXT1_UNORM:
+	case PF_R_ATI1N_UNORM:
+	case PF_R_ATI1N_SNORM:
+		return 8;
+	default:
+		return 16;
+	}
+}
+
+NullTexture::NullTexture( TextureType type, PixelFormat format, uint32_t arraySize, uint32_t numMipMaps, uint32_t width, uint32_t height, uint32_t depth,
+	uint32_t sampleCount, uint32_t sampleQuality, uint32_t accessHint, uint32_t flags, ElementInitData* initData )
+	: Texture(type, format, numMipMaps, sampleCount, sampleQuality, accessHint, flags),
+	  mNumFaces(type == TT_TextureCube ? CMF_Count : 1)
+{
+	mWidth = width;
+	mHeight = (std::max)(height, 1U);
+	mDepth = (std::max)(depth, 1U);
+	mTextureArraySize = (std::max)(arraySize, 1U);
+
+	if (mMipLevels == 0)
+	{
+		// numMipMap == 0, will generate mipmap levels automatically
+		if (mCreateFlags & TexCreate_GenerateMipmaps)
+			mMipLevels = Texture::CalculateMipmapLevels((std::max)((std::max)(mWidth, mHeight), mDepth));
+		else
+			mMipLevels = 1;
+	}
+
+	// Layout subresources, array slice major, then cube face, then mipmap level
+	size_t offset = 0;
+	for (uint32_t arrIndex = 0; arrIndex < mTextureArraySize; ++arrIndex)
+	{
+		for (uint32_t face = 0; face < mNumFaces; ++face)
+		{
+			for (uint32_t level = 0; level < mMipLevels; ++level)
+			{
+				mSubresourceOffsets.push_back(offset);
+				offset += GetRowPitch(level) * GetNumRows(level) * CalculateLevelSize(mDepth, level);
+			}
+		}
+	}
+	mData.resize(offset, 0);
+
+	if (initData)
+	{
+		// Init data is ordered as subresources
+		for (size_t i = 0; i < mSubresourceOffsets.size(); ++i)
+		{
+			const uint8_t* pSrc = static_cast<const uint8_t*>(initData[i].pData);
+			if (!pSrc)
+				continue;
+
+			uint32_t level = i % mMipLevels;
+			uint32_t rowPitch = GetRowPitch(level);
+			uint32_t numRows = GetNumRows(level);
+			uint32_t levelDepth = CalculateLevelSize(mDepth, level);
+
+			uint32_t srcRowPitch = initData[i].rowPitch ? initData[i].rowPitch : rowPitch;
+			uint32_t srcSlicePitch = (mType == TT_Texture3D && initData[i].slicePitch) ? initData[i].slicePitch : srcRowPitch * numRows;
+
+			uint8_t* pDst = &mData[mSubresourceOffsets[i]];
+			for (uint32_t z = 0; z < levelDepth; ++z)
+			{
+				for (uint32_t row = 0; row < numRows; ++row)
+					memcpy(pDst + (z * numRows + row) * rowPitch, pSrc + z * srcSlicePitch + row * srcRowPitch, (std::min)(rowPitch, srcRowPitch));
+			}
+		}
+	}
+
+	if (mCreateFlags & TexCreate_ShaderResource)
+	{
+		mTextureSRV = std::make_shared<NullShaderResourceView>();
+	}
+}
+
+NullTexture::~NullTexture()
+{
+
+}
+
+uint32_t NullTexture::GetRowPitch( uint32_t level ) const
+{
+	uint32_t levelWidth = CalculateLevelSize(mWidth, level);
+
+	if (PixelFormatUtils::IsCompressed(mFormat))
+		return ((levelWidth + 3) / 4) * GetCompressedBlockSize(mFormat);
+	else
+		return levelWidth * PixelFormatUtils::GetNumElemBytes(mFormat);
+}
+
+uint32_t NullTexture::GetNumRows( uint32_t level ) const
+{
+	uint32_t levelHeight = CalculateLevelSize(mHeight, level);
+
+	if (PixelFormatUtils::IsCompressed(mFormat))
+		return (levelHeight + 3) / 4;
+	else
+		return levelHeight;
+}
+
+uint8_t* NullTexture::GetSubresource( uint32_t arrayIndex, uint32_t face, uint32_t level )
+{
+	if (arrayIndex >= mTextureArraySize || face >= mNumFaces || level >= mMipLevels)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Texture subresource out of range!", "NullTexture::Map");
+
+	return &mData[ mSubresourceOffsets[(arrayIndex * mNumFaces + face) * mMipLevels + level] ];
+}
+
+void* NullTexture::Map1D( uint32_t arrayIndex, uint32_t level, ResourceMapAccess mapType )
+{
+	return GetSubresource(arrayIndex, 0, level);
+}
+
+void* NullTexture::Map2D( uint32_t arrayIndex, uint32_t level, ResourceMapAccess mapType, uint32_t& rowPitch )
+{
+	rowPitch = GetRowPitch(level);
+	return GetSubresource(arrayIndex, 0, level);
+}
+
+void* NullTexture::Map3D( uint32_t arrayIndex, uint32_t level, ResourceMapAccess mapType, uint32_t& rowPitch, uint32_t& slicePitch )
+{
+	rowPitch = GetRowPitch(level);
+	slicePitch = rowPitch * GetNumRows(level);
+	return GetSubresource(arrayIndex, 0, level);
+}
+
+void* NullTexture::MapCube( uint32_t arrayIndex, CubeMapFace face, uint32_t level, ResourceMapAccess mapType, uint32_t& rowPitch )
+{
+	rowPitch = GetRowPitch(level);
+	return GetSubresource(arrayIndex, face, level);
+}
+
+void NullTexture::CopyToTexture( Texture& destTexture )
+{
+	NullTexture* pDestTexture = static_cast_checked<NullTexture*>(&destTexture);
+
+	if (pDestTexture->mData.size() != mData.size() || pDestTexture->mFormat != mFormat)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Copy between different textures!", "NullTexture::CopyToTexture");
+
+	pDestTexture->mData = mData;
+}
+
+void NullTexture::CopyLevelsToTexture( Texture& destTexture, uint32_t srcLevel )
+{
+	NullTexture* pDestTexture = static_cast_checked<NullTexture*>(&destTexture);
+
+	if (pDestTexture->mFormat != mFormat || pDestTexture->mType != mType || pDestTexture->mTextureArraySize != mTextureArraySize ||
+		srcLevel + pDestTexture->mMipLevels > mMipLevels || pDestTexture->mWidth != CalculateLevelSize(mWidth, srcLevel) ||
+		pDestTexture->mHeight != CalculateLevelSize(mHeight, srcLevel) || pDestTexture->mDepth != CalculateLevelSize(mDepth, srcLevel))
+	{
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Copy between different textures!", "NullTexture::CopyLevelsToTexture");
+	}
+
+	for (uint32_t arrIndex = 0; arrIndex < mTextureArraySize; ++arrIndex)
+	{
+		for (uint32_t face = 0; face < mNumFaces; ++face)
+		{
+			for (uint32_t level = 0; level < pDestTexture->mMipLevels; ++level)
+			{
+				size_t size = pDestTexture->GetRowPitch(level) * pDestTexture->GetNumRows(level) * CalculateLevelSize(pDestTexture->mDepth, level);
+				memcpy(pDestTexture->GetSubresource(arrIndex, face, level), GetSubresource(arrIndex, face, srcLevel + level), size);
+			}
+		}
+	}
+}
+
+}
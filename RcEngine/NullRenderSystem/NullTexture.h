@@ -0,0 +1,64 @@
+#ifndef NullTexture_h__
+#define NullTexture_h__
+
+#include "NullPrerequisites.h"
+#include <Graphics/GraphicsResource.h>
+
+namespace RcEngine {
+
+/**
+ * Texture of any type kept in system memory, one block per array slice, cube face and
+ * mipmap level. Map returns the block directly.
+ */
+class _NullExport NullTexture : public Texture
+{
+public:
+	NullTexture(
+		TextureType type,
+		PixelFormat format,
+		uint32_t arraySize,
+		uint32_t numMipMaps,
+		uint32_t width,
+		uint32_t height,
+		uint32_t depth,
+		uint32_t sampleCount,
+		uint32_t sampleQuality,
+		uint32_t accessHint,
+		uint32_t flags,
+		ElementInitData* initData);
+	~NullTexture();
+
+	virtual void* Map1D(uint32_t arrayIndex, uint32_t level, ResourceMapAccess mapType);
+	virtual void* Map2D(uint32_t arrayIndex, uint32_t level, ResourceMapAccess mapType, uint32_t& rowPitch);
+	virtual void* Map3D(uint32_t arrayIndex, uint32_t level, ResourceMapAccess mapType, uint32_t& rowPitch, uint32_t& slicePitch);
+	virtual void* MapCube(uint32_t arrayIndex, CubeMapFace face, uint32_t level, ResourceMapAccess mapType, uint32_t& rowPitch);
+
+	virtual void Unmap1D(uint32_t arrayIndex, uint32_t level) {}
+	virtual void Unmap2D(uint32_t arrayIndex, uint32_t level) {}
+	virtual void Unmap3D(uint32_t arrayIndex, uint32_t level) {}
+	virtual void UnmapCube(uint32_t arrayIndex, CubeMapFace face, uint32_t level) {}
+
+	virtual void BuildMipMap() {}
+	virtual void CopyToTexture(Texture& destTexture);
+	virtual void CopyLevelsToTexture(Texture& destTexture, uint32_t srcLevel);
+
+	// Bytes of a row of blocks and number of rows of a mipmap level
+	uint32_t GetRowPitch(uint32_t level) const;
+	uint32_t GetNumRows(uint32_t level) const;
+
+	// Total bytes of all subresources
+	inline size_t GetMemorySize() const { return mData.size(); }
+
+private:
+	uint8_t* GetSubresource(uint32_t arrayIndex, uint32_t face, uint32_t level);
+
+private:
+	uint32_t mNumFaces;
+
+	vector<uint8_t> mData;
+	vector<size_t> mSubresourceOffsets;
+};
+
+}
+
+#endif // NullTexture_h__
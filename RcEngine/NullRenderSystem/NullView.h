@@ -0,0 +1,45 @@
+#ifndef NullView_h__
+#define NullView_h__
+
+#include "NullPrerequisites.h"
+#include <Graphics/GraphicsResource.h>
+#include <Graphics/FrameBuffer.h>
+
+namespace RcEngine {
+
+class _NullExport NullShaderResourceView : public ShaderResourceView
+{
+public:
+	NullShaderResourceView() {}
+};
+
+class _NullExport NullUnorderedAccessView : public UnorderedAccessView
+{
+public:
+	NullUnorderedAccessView() {}
+
+	void Clear(const float4& clearData) {}
+	void Clear(const uint4& clearData) {}
+};
+
+/**
+ * Render target or depth stencil view, texture is null for screen frame buffer.
+ */
+class _NullExport NullRenderView : public RenderView
+{
+public:
+	NullRenderView(const shared_ptr<Texture>& texture) : RenderView(texture) {}
+
+	void ClearColor(const ColorRGBA& clr) {}
+	void ClearDepth(float depth) {}
+	void ClearStencil(uint32_t stencil) {}
+	void ClearDepthStencil(float depth, uint32_t stencil) {}
+
+protected:
+	void OnAttach(FrameBuffer& fb, Attachment attr) {}
+	void OnDetach(FrameBuffer& fb, Attachment attr) {}
+};
+
+}
+
+#endif // NullView_h__
@@ -1,5 +1,10 @@
 #include "OpenGLModule.h"
 
+// Report allocations of this module to the engine allocation hook
+#ifndef BUILD_STATIC
+#include <Core/MemoryHook.inl>
+#endif
+
 extern "C" void _OpenGLExport dllStartPlugin(RcEngine::IModule** pMoudle) 
 {
 	*pMoudle = new RcEngine::OpenGLModule();
@@ -521,7 +521,7 @@ void OpenGLDevice::DoDraw( const EffectTechnique* technique, const RenderOperati
 		{
 			pass->BeginPass();
 
-			if (operation.NumInstances <= 1)
+			if (operation.NumInstances <= 1 && operation.InstanceStart == 0)
 			{
 				glDrawElementsBaseVertex(
 					primitiveTypeOGL,
@@ -530,7 +530,7 @@ void OpenGLDevice::DoDraw( const EffectTechnique* technique, const RenderOperati
 					BUFFER_OFFSET(indexOffset),
 					operation.BaseVertex);
 			}
-			else
+			else if (operation.InstanceStart == 0)
 			{
 				glDrawElementsInstancedBaseVertex(
 					primitiveTypeOGL, 
@@ -540,6 +540,17 @@ void OpenGLDevice::DoDraw( const EffectTechnique* technique, const RenderOperati
 					operation.NumInstances,
 					operation.BaseVertex);
 			}
+			else
+			{
+				glDrawElementsInstancedBaseVertexBaseInstance(
+					primitiveTypeOGL, 
+					operation.IndexCount,
+					indexTypeOGL, 
+					BUFFER_OFFSET(indexOffset),
+					(std::max)(operation.NumInstances, 1U),
+					operation.BaseVertex,
+					operation.InstanceStart);
+			}
 
 			pass->EndPass();
 		}
@@ -550,11 +561,11 @@ void OpenGLDevice::DoDraw( const EffectTechnique* technique, const RenderOperati
 		{
 			pass->BeginPass();
 
-			if (operation.NumInstances <= 1)
+			if (operation.NumInstances <= 1 && operation.InstanceStart == 0)
 			{
 				glDrawArrays(primitiveTypeOGL, operation.VertexStart, operation.VertexCount);
 			}
-			else
+			else if (operation.InstanceStart == 0)
 			{
 				glDrawArraysInstanced(
 					primitiveTypeOGL,
@@ -562,6 +573,15 @@ void OpenGLDevice::DoDraw( const EffectTechnique* technique, const RenderOperati
 					operation.VertexCount,
 					operation.NumInstances);
 			}
+			else
+			{
+				glDrawArraysInstancedBaseInstance(
+					primitiveTypeOGL,
+					operation.VertexStart,
+					operation.VertexCount,
+					(std::max)(operation.NumInstances, 1U),
+					operation.InstanceStart);
+			}
 	
 			pass->EndPass();
 		}
@@ -8,6 +8,7 @@
 #include "OpenGLVertexDeclaration.h"
 #include "OpenGLHBAO.h"
 #include <Core/Exception.h>
+#include <Graphics/GLSLPreprocessor.h>
 #include <Graphics/RenderState.h>
 #include "pfm.h"
 
@@ -131,6 +132,14 @@ shared_ptr<Shader> OpenGLFactory::CreateShader( ShaderType type )
 	return shared_ptr<Shader>( new OpenGLShader(type) );
 }
 
+void OpenGLFactory::InvalidateShaderFiles( const vector<String>& files )
+{
+	RenderFactory::InvalidateShaderFiles(files);
+
+	// Includes are shared by all shaders and cheap to read, read them all again
+	GLSLPreprocessor::ClearIncludeCache();
+}
+
 shared_ptr<ShaderResourceView> OpenGLFactory::CreateTexture3DSRV( const shared_ptr<Texture>& texture )
 {
 	return shared_ptr<ShaderResourceView>( new OpenGLTextureSRV(texture, 0, texture->GetMipLevels(), 0, texture->GetTextureArraySize()) );
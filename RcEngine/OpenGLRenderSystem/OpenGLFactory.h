@@ -28,6 +28,7 @@ public:
 	// Shader
 	virtual shared_ptr<Shader> CreateShader(ShaderType type);
 	virtual shared_ptr<ShaderPipeline> CreateShaderPipeline(Effect& effect);
+	virtual void InvalidateShaderFiles(const vector<String>& files);
 
 	// Texture resource
 	virtual shared_ptr<Texture> CreateTexture1D(
@@ -4,7 +4,8 @@
 #include <Core/Loger.h>
 #include <Core/Utility.h>
 #include <Core/Profiler.h>
-#include <IO/PathUtil.h>
+#include <Graphics/GLSLPreprocessor.h>
+#include <Graphics/ShaderCache.h>
 #include <fstream>
 #include <iterator>
 #include <set>
@@ -36,46 +37,29 @@ const String& GetSupportedGLSLVersion()
 		ENGINE_EXCEPT(Exception::ERR_INTERNAL_ERROR, "Only supported OpenGL 4.2 above hardware!", "GetSupportedGLSLVersion");
 }
 
-bool HasVersion(const String& source)
-{
-	return source.find("#version") != std::string::npos;
-}
-
-bool HasSpecialToken(const std::string& line, std::string& oToken)
+/**
+ * Program binaries are only valid for the driver which created them.
+ */
+const String& GetDriverTag()
 {
-	size_t s = line.find('#');
-	if (s == std::string::npos)
-		return false;
-
-	size_t e = s+1;
-	while(isalpha(line[e])) e++;
+	static String driverTag;
+	if (driverTag.empty())
+	{
+		const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		for (GLenum name : names)
+		{
+			const GLubyte* value = glGetString(name);
+			driverTag += value ? (const char*)value : "";
+			driverTag += '\n';
+		}
+	}
 
-	oToken = line.substr(s, e - s);
-	return true;
+	return driverTag;
 }
 
-bool HasSamplerState(const std::string& line, std::string& oSamplerState, std::string& oTexture)
+bool HasVersion(const String& source)
 {
-	bool hasSamplerState = false;
-
-	size_t colonPos = line.find(':');
-	if (colonPos != std::string::npos)
-	{
-		size_t s = 0, e = colonPos - 1;
-		while(!isalpha(line[s])) s++;
-		while(!isalpha(line[e])) e--;
-		oTexture = line.substr(s, e - s + 1);	
-
-		s = colonPos+1;
-		while(!isalpha(line[s])) s++;
-		e = s;
-		while(isalpha(line[e])) e++;
-		oSamplerState = line.substr(s, e - s);	
-
-		hasSamplerState = true;
-	}
-
-	return hasSamplerState;
+	return source.find("#version") != std::string::npos;
 }
 
 
@@ -98,251 +82,146 @@ inline bool LoadBinary(const char* filename, GLenum & format, std::vector<uint8_
 	return false;
 }
 
-//////////////////////////////////////////////////////////////////////////
-class GLSLInclude
-{
-public:
-	GLSLInclude() {}
-
-	void LoadInclude(const std::string& parentGLSLPath, const std::string& includeName)
-	{
-		std::string includeFile = PathUtil::GetParentPath(parentGLSLPath) + includeName;
-
-		std::ifstream fs(includeFile);
-		if (fs.is_open() == false)
-		{
-			ENGINE_EXCEPT(Exception::ERR_FILE_NOT_FOUND, includeFile + " not founded!", "OpenGLCompile");
-		}
-
-		std::string includeScript( (std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>() ); 
-		glNamedStringARB(GL_SHADER_INCLUDE_ARB, includeName.length(), includeName.c_str(), includeScript.length(), includeScript.c_str());
-
-		std::string line, token, samplerState, texture;
-
-		size_t lineBeign = 0;
-		size_t lineEnd = includeScript.find('\n');	
-		while (lineEnd < std::string::npos)
-		{
-			line = includeScript.substr(lineBeign, lineEnd - lineBeign);
-			if ( HasSpecialToken(line, token) )
-			{
-				if ( token == "#pragma" && HasSamplerState(line, samplerState, texture) )
-				{
-					SamplerStates.push_back(make_pair(samplerState, texture));
-				}
-			}
-
-			lineBeign = lineEnd+1;
-			lineEnd = includeScript.find('\n', lineBeign);	
-		}
-	}
-
-	static const GLSLInclude& FetchGLSLInclude(const std::string& parentGLSLPath, const std::string& includeName)
-	{
-		auto it = msCachedIncludes.find(includeName);
-		if (it == msCachedIncludes.end())
-		{
-			it = msCachedIncludes.insert(make_pair(includeName, GLSLInclude())).first;
-			it->second.LoadInclude(parentGLSLPath, includeName);
-		}
-
-		return it->second;
-	}
-
-public:
-	typedef std::pair<std::string, std::string> SamplerState;
-	std::vector<SamplerState> SamplerStates;
-
-private:
-	static std::map<std::string, GLSLInclude> msCachedIncludes;
-};
-
-std::map<std::string, GLSLInclude> GLSLInclude::msCachedIncludes;
-
 //////////////////////////////////////////////////////////////////////////
 class GLSLScriptCompiler
 {
 public:
 	GLSLScriptCompiler(OpenGLShader* shader) : mShader(shader) {}
 
-	bool OpenGLCompile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint)
+	bool OpenGLCompile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint, const GLSLSource& glslSource)
 	{
-		//ENGINE_PUSH_CPU_PROFIER("Buld GLSL");
-
-		std::ifstream fs(filename);
-		std::string glslScript( (std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>() );
-
-		size_t shaderSectionBegin, shaderSectionEnd;
-		FindShaderSectionRange(glslScript, mShader->mShaderType, entryPoint, shaderSectionBegin, shaderSectionEnd);
-
-		bool hasVersion = false;
-		bool hasInclude = false;
-		
-		uint32_t lineNum = 0;
-		std::string line, token, samplerState, texture, version;
-
-		size_t lineBeign = shaderSectionBegin;
-		size_t lineEnd = glslScript.find('\n', shaderSectionBegin);	
-		while (lineEnd < shaderSectionEnd && lineEnd != std::string::npos)
+		// Named strings are registered on the thread of the context, again when an include changed
+		static std::map<String, uint64_t> registeredIncludes;
+		for (const String& includeName : glslSource.Includes)
 		{
-			line = glslScript.substr(lineBeign, lineEnd - lineBeign);
+			const String& includeSource = GLSLPreprocessor::GetIncludeSource(includeName);
+			uint64_t sourceHash = ShaderCache::Hash(includeSource.data(), includeSource.length());
 
-			if (line.size())
+			auto registered = registeredIncludes.find(includeName);
+			if (registered == registeredIncludes.end() || registered->second != sourceHash)
 			{
-				if ( HasSpecialToken(line, token) )
-				{
-					if (token == "#version")
-					{
-						version = line;
-						hasVersion = true;
-						shaderSectionBegin = lineEnd+1;
-					}
-					else if (token == "#include")
-					{
-						// Find include file 
-						size_t s = line.find('\"');
-						size_t e = line.find('\"', s + 1);
-
-						std::string includeName = line.substr(s + 1, e-s-1);
-
-						const GLSLInclude& glslInclude = GLSLInclude::FetchGLSLInclude(filename, includeName);
-						for (const auto& v : glslInclude.SamplerStates)
-						{
-							mShader->mSamplerStates[v.second] = v.first;
-						}
-
-						hasInclude = true;
-					}
-					else if (token == "#pragma")
-					{
-						if ( HasSamplerState(line, samplerState, texture) )
-						{
-							mShader->mSamplerStates[texture] = samplerState;
-						}
-					}
-				}
+				glNamedStringARB(GL_SHADER_INCLUDE_ARB, includeName.length(), includeName.c_str(), includeSource.length(), includeSource.c_str());
+				registeredIncludes[includeName] = sourceHash;
 			}
-			
-			++lineNum;
-			lineBeign = lineEnd+1;
-			lineEnd = glslScript.find('\n', lineBeign);	
 		}
 
-		std::string shaderSource;
-
-		// Add version 
-		if (!hasVersion)
-			version = GetSupportedGLSLVersion();
+		const String& shaderSource = glslSource.Source;
+		mShader->mSamplerStates = glslSource.SamplerStates;
 
-		shaderSource += version + '\n';
+		// Sampler states above come from source, only the program is cached
+		ShaderCache* shaderCache = ShaderCache::GetSingletonPtr();
+		bool useCache = shaderCache && shaderCache->IsEnabled() && GLEW_ARB_get_program_binary;
 
-		// Add include extension
-		if (hasInclude)
-			shaderSource += "#extension GL_ARB_shading_language_include : enable\n";
-	
-		// Add Macro
-		if (macros)
+		uint64_t cacheKey = 0;
+		if (useCache)
 		{
-			for (uint32_t i = 0; i < macroCount; ++i)
-			{
-				shaderSource += "#define " + macros[i].Name + " " + macros[i].Definition + "\n";
-			}
-		}
+			cacheKey = ShaderCache::ComputeKey(shaderSource, macros, macroCount, entryPoint, mShader->mShaderType, GetDriverTag());
+			cacheKey = ShaderCache::Hash(&glslSource.IncludeHash, sizeof(uint64_t), cacheKey);
 
-		// Add #line
-#ifdef _DEBUG
-		size_t lineNum0 = std::count(glslScript.begin(), glslScript.begin() + shaderSectionBegin, '\n');
-		lineNum = lineNum0 + 1;
-		
-		static char lineBuffer[100];
-		std::sprintf(lineBuffer, "#line %d\n", lineNum);
-		shaderSource += lineBuffer;
-#endif
-		
-		shaderSource += glslScript.substr(shaderSectionBegin, shaderSectionEnd - shaderSectionBegin);
-		
-		//ENGINE_POP_CPU_PROFIER("Buld GLSL");
+			if (LoadProgramBinary(*shaderCache, cacheKey))
+				return true;
+		}
 
 		//ENGINE_PUSH_CPU_PROFIER("Compile GLSL");
-		char const* pSource = shaderSource.c_str();
-		mShader->mShaderOGL = glCreateShaderProgramv(OpenGLMapping::Mapping(mShader->mShaderType), 1, &pSource);
+		String compileOutput;
+		mShader->mShaderOGL = CreateShaderProgram(OpenGLMapping::Mapping(mShader->mShaderType), shaderSource.c_str(), useCache, compileOutput);
 		//ENGINE_POP_CPU_PROFIER("Compile GLSL");
 
-		int success;
-		glGetProgramiv(mShader->mShaderOGL, GL_LINK_STATUS, &success);
-		if (success != GL_TRUE)
+		bool success = compileOutput.empty();
+		if (!success)
 		{
-			int length;
-			glGetProgramiv(mShader->mShaderOGL, GL_INFO_LOG_LENGTH, &length);
-
-			std::vector<char> compileOutput(length);
-			glGetProgramInfoLog(mShader->mShaderOGL, length, &length, &compileOutput[0]);
-
-			fprintf(stderr, "GLSL %s %s compile failed\n\n%s\n\n", filename.c_str(), entryPoint.c_str(), &compileOutput[0]);
+			fprintf(stderr, "GLSL %s %s compile failed\n\n%s\n\n", filename.c_str(), entryPoint.c_str(), compileOutput.c_str());
 			//EngineLogger::LogError("GLSL %s compile failed\n\n%s\n\n", filename.c_str(), &compileOutput[0]);
 
 			std::ofstream ofs("E:/" + entryPoint + ".glsl");
 			ofs << shaderSource;
 			ofs.close();
 		}
+		else if (useCache)
+		{
+			StoreProgramBinary(*shaderCache, cacheKey);
+		}
 		
-		return (success == GL_TRUE);
+		return success;
 	} 
 
-	void FindShaderSectionRange(const String& glslScript, ShaderType shaderStage, const String& entryPoint, size_t& oSectionBegin, size_t& oSectionEnd)
+	/**
+	 * Same as glCreateShaderProgramv, compile output is returned for shader compile errors too
+	 * and the binary can be retrieved if requested. Output is empty if it links.
+	 */
+	GLuint CreateShaderProgram(GLenum shaderStage, const char* source, bool retrievable, String& compileOutput)
 	{
-		// find shader section of entry point
-		static const char* GLSLShaderToken[] = {
-			"[[Vertex=%s]]", "[[TessControl=%s]", "[[TessEval=%s]]", "[[Geometry=%s]]", "[[Fragment=%s]]", "[[Compute=%s]]" 
-		};
-
-		// Split into shader section
-		char delimiter[255];
-		std::sprintf(delimiter, GLSLShaderToken[shaderStage], entryPoint.c_str());	
-
-		size_t tokenBegin = glslScript.find(delimiter);
-		if (tokenBegin != std::string::npos)
+		GLuint shader = glCreateShader(shaderStage);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+
+		GLuint program = glCreateProgram();
+		glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+		if (retrievable)
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		GLint success, length;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (success == GL_TRUE)
 		{
-			// Find the range of this shader section
+			glAttachShader(program, shader);
+			glLinkProgram(program);
+			glDetachShader(program, shader);
 
-			size_t tokenEnd = glslScript.find('\n', tokenBegin)+1; 
-			size_t nextTokenEnd = glslScript.find("]]", tokenEnd);
-
-			if (nextTokenEnd != std::string::npos)
+			glGetProgramiv(program, GL_LINK_STATUS, &success);
+			if (success != GL_TRUE)
 			{
-				// Validate
-				size_t nextTokenBegin = glslScript.rfind("[[", nextTokenEnd);
-
-				// Check whether exits = in nextToken
-				bool valid = false;
-				for (size_t i = nextTokenBegin; i < nextTokenEnd && !valid; ++i)
-					valid = (glslScript[i] == '=');
-
-				assert(valid == true);
-				oSectionBegin = tokenEnd;
-				oSectionEnd = nextTokenBegin;
-			}
-			else
-			{
-				oSectionBegin = tokenEnd;
-				oSectionEnd = glslScript.length();
+				glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+				compileOutput.resize((std::max)(length, 1));
+				glGetProgramInfoLog(program, length, &length, &compileOutput[0]);
 			}
 		}
 		else
 		{
-			if (glslScript.find("[[") == std::string::npos)
-			{
-				// No shader stage token, use the whole content as this shader stage
-				oSectionBegin = 0;
-				oSectionEnd = glslScript.length();
-			}
-			else
-			{
-				// Error: exits other shader section, but can't find this shader stage
-				std::cerr << "Shader " + entryPoint + " not found!" << std::endl;
-				ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND, "Shader " + entryPoint + " not found!", "OpenGLShader::LoadFromFile");
-			}
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			compileOutput.resize((std::max)(length, 1));
+			glGetShaderInfoLog(shader, length, &length, &compileOutput[0]);
+		}
+		glDeleteShader(shader);
+
+		return program;
+	}
+
+	bool LoadProgramBinary(ShaderCache& shaderCache, uint64_t cacheKey)
+	{
+		uint32_t format;
+		std::vector<uint8_t> binary;
+		if (!shaderCache.Load(cacheKey, format, binary))
+			return false;
+
+		GLuint program = glCreateProgram();
+		glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+		glProgramBinary(program, GLenum(format), &binary[0], GLsizei(binary.size()));
+
+		// Driver may reject binaries after an update which didn't change its version string
+		GLint success;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (success != GL_TRUE)
+		{
+			glDeleteProgram(program);
+			return false;
 		}
+
+		mShader->mShaderOGL = program;
+		return true;
+	}
+
+	void StoreProgramBinary(ShaderCache& shaderCache, uint64_t cacheKey)
+	{
+		GLint length = 0;
+		glGetProgramiv(mShader->mShaderOGL, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+			return;
+
+		GLenum format;
+		std::vector<uint8_t> binary(length);
+		glGetProgramBinary(mShader->mShaderOGL, length, &length, &format, &binary[0]);
+		shaderCache.Store(cacheKey, format, &binary[0], uint32_t(length));
 	}
 
 private:
@@ -632,10 +511,23 @@ bool OpenGLShader::LoadFromByteCode( const String& filename )
 	return (success == GL_TRUE);
 }
 
+void OpenGLShader::PrepareFromFile( const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint /*= ""*/ )
+{
+	mPreparedSource = std::make_shared<GLSLSource>();
+	GLSLPreprocessor::Preprocess(filename, mShaderType, macros, macroCount, entryPoint, GetSupportedGLSLVersion(), *mPreparedSource);
+	GLSLPreprocessor::GetSourceFiles(filename, *mPreparedSource, mSourceFiles);
+}
+
 bool OpenGLShader::LoadFromFile( const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint /*= ""*/ )
 {
+	if (!mPreparedSource)
+		PrepareFromFile(filename, macros, macroCount, entryPoint);
+
+	shared_ptr<GLSLSource> glslSource = mPreparedSource;
+	mPreparedSource = nullptr;
+
 	GLSLScriptCompiler compiler(this);
-	if ( compiler.OpenGLCompile(filename, macros, macroCount, entryPoint) )
+	if ( compiler.OpenGLCompile(filename, macros, macroCount, entryPoint, *glslSource) )
 	{
 		OpenGLShaderReflection shaderReflection(this);
 		shaderReflection.ReflectShader();
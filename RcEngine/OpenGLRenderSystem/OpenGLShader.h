@@ -44,6 +44,7 @@ struct ResouceViewParam
 };
 
 // Forward declaration
+struct GLSLSource;
 class OpenGLShaderReflection;
 class OpenGLShaderPipeline;
 
@@ -54,6 +55,7 @@ public:
 	virtual ~OpenGLShader();
 
 	virtual bool LoadFromByteCode(const String& filename);
+	virtual void PrepareFromFile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint = "");
 	virtual bool LoadFromFile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint = "");
 
 private:
@@ -67,6 +69,9 @@ private:
 	std::vector<UniformBuffer> mUniformBuffers;
 	std::vector<InputSignature> mInputSignatures;
 	std::map<String, String> mSamplerStates;
+
+	// Preprocessed on a worker by PrepareFromFile, compiled by LoadFromFile
+	shared_ptr<GLSLSource> mPreparedSource;
 };
 
 class EffectConstantBuffer;
@@ -68,6 +68,36 @@ void OpenGLTexture::CopyToTexture( Texture& destTexture )
 	ENGINE_EXCEPT(Exception::ERR_INVALID_STATE, "Shoudn't be here!", "OpenGLTexture::CopyToTexture");
 }
 
+void OpenGLTexture::CopyLevelsToTexture( Texture& destTexture, uint32_t srcLevel )
+{
+	assert(mFormat == destTexture.GetTextureFormat() && mType == destTexture.GetTextureType() && 
+		   mTextureArraySize == destTexture.GetTextureArraySize() && srcLevel + destTexture.GetMipLevels() <= mMipLevels);
+
+	if (!GLEW_ARB_copy_image)
+		ENGINE_EXCEPT(Exception::ERR_NOT_IMPLEMENTED, "Level copy needs ARB_copy_image!", "OpenGLTexture::CopyLevelsToTexture");
+
+	OpenGLTexture& destTextureOGL = *(static_cast<OpenGLTexture*>(&destTexture));
+
+	for (uint32_t level = 0; level < destTexture.GetMipLevels(); ++level)
+	{
+		uint32_t levelWidth = CalculateLevelSize(mWidth, srcLevel + level);
+		uint32_t levelHeight = CalculateLevelSize(mHeight, srcLevel + level);
+		uint32_t levelDepth = 1;
+
+		// Array layers are rows of 1D array and slices of 2D and cube array
+		if (mType == TT_Texture1D)
+			levelHeight = mTextureArraySize;
+		else if (mType == TT_Texture3D)
+			levelDepth = CalculateLevelSize(mDepth, srcLevel + level);
+		else
+			levelDepth = mTextureArraySize * (mType == TT_TextureCube ? CMF_Count : 1);
+
+		glCopyImageSubData(mTextureOGL, mTextureTarget, srcLevel + level, 0, 0, 0,
+			destTextureOGL.mTextureOGL, destTextureOGL.mTextureTarget, level, 0, 0, 0,
+			levelWidth, levelHeight, levelDepth);
+	}
+}
+
 void OpenGLTexture::BuildMipMap()
 {
 	if (GLEW_EXT_framebuffer_object)
@@ -35,6 +35,7 @@ public:
 
 	virtual void BuildMipMap();
 	virtual void CopyToTexture(Texture& destTexture);
+	virtual void CopyLevelsToTexture(Texture& destTexture, uint32_t srcLevel);
 
 protected:
 
@@ -0,0 +1,102 @@
+#include <Core/CpuInfo.h>
+#include <thread>
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#	include <cpuid.h>
+#endif
+
+namespace RcEngine {
+
+namespace {
+
+void CpuId(int32_t info[4], int32_t function, int32_t subFunction)
+{
+#if defined(_MSC_VER)
+	__cpuidex(info, function, subFunction);
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	__cpuid_count(function, subFunction, info[0], info[1], info[2], info[3]);
+#else
+	info[0] = info[1] = info[2] = info[3] = 0;
+#endif
+}
+
+uint64_t GetXCR0()
+{
+#if defined(_MSC_VER) && (_MSC_FULL_VER >= 160040219)
+	return _xgetbv(0);
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	uint32_t eax, edx;
+	__asm__ volatile (".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (uint64_t(edx) << 32) | eax;
+#else
+	return 0;
+#endif
+}
+
+struct CpuFeatures
+{
+	bool SSE2, SSE41, AVX, AVX2;
+	uint32_t NumHardwareThreads;
+
+	CpuFeatures() : SSE2(false), SSE41(false), AVX(false), AVX2(false)
+	{
+		int32_t info[4];
+		CpuId(info, 0, 0);
+		int32_t maxFunction = info[0];
+
+		if (maxFunction >= 1)
+		{
+			CpuId(info, 1, 0);
+			SSE2  = (info[3] & (1 << 26)) != 0;
+			SSE41 = (info[2] & (1 << 19)) != 0;
+
+			// AVX needs OSXSAVE and OS support for XMM/YMM state
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			if (osxsave && avx)
+				AVX = (GetXCR0() & 0x6) == 0x6;
+		}
+
+		if (AVX && maxFunction >= 7)
+		{
+			CpuId(info, 7, 0);
+			AVX2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		NumHardwareThreads = (std::max)(1U, std::thread::hardware_concurrency());
+	}
+};
+
+// Detect at load time, avoid thread unsafe function local static
+const CpuFeatures gCpuFeatures;
+
+}
+
+bool CpuInfo::HasSSE2()
+{
+	return gCpuFeatures.SSE2;
+}
+
+bool CpuInfo::HasSSE41()
+{
+	return gCpuFeatures.SSE41;
+}
+
+bool CpuInfo::HasAVX()
+{
+	return gCpuFeatures.AVX;
+}
+
+bool CpuInfo::HasAVX2()
+{
+	return gCpuFeatures.AVX2;
+}
+
+uint32_t CpuInfo::GetNumHardwareThreads()
+{
+	return gCpuFeatures.NumHardwareThreads;
+}
+
+} // Namespace RcEngine
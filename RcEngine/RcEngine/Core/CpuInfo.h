@@ -0,0 +1,32 @@
+#ifndef CpuInfo_h__
+#define CpuInfo_h__
+
+#include <Core/Prerequisites.h>
+
+namespace RcEngine {
+
+/**
+ * Runtime CPU feature query, used to select SIMD code path. Features are
+ * detected once when the engine module is loaded.
+ */
+class _ApiExport CpuInfo
+{
+public:
+	static bool HasSSE2();
+	static bool HasSSE41();
+
+	/**
+	 * AVX is only reported if OS also saves YMM registers on context switch.
+	 */
+	static bool HasAVX();
+	static bool HasAVX2();
+
+	/**
+	 * Number of hardware threads.
+	 */
+	static uint32_t GetNumHardwareThreads();
+};
+
+} // Namespace RcEngine
+
+#endif // CpuInfo_h__
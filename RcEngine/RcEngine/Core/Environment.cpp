@@ -5,7 +5,8 @@ namespace RcEngine{
 Environment::Environment()
 	: mApplication(nullptr),
 	  mRenderFactory(nullptr), 
-	  mRenderDevice(nullptr)
+	  mRenderDevice(nullptr),
+	  mJobSystem(nullptr)
 {
 
 }
@@ -9,6 +9,7 @@ namespace RcEngine{
 class Application;
 class RenderDevice;
 class RenderFactory;
+class JobSystem;
 
 class _ApiExport Environment : public Singleton<Environment>
 {
@@ -20,6 +21,7 @@ public:
 	inline RenderDevice*     GetRenderDevice() const		{ assert(mRenderDevice); return mRenderDevice; }
 	inline RenderFactory*    GetRenderFactory() const		{ assert(mRenderFactory); return mRenderFactory; }
 	inline SceneManager*	 GetSceneManager() const		{ assert(mRenderFactory); return mSceneManager; }
+	inline JobSystem*		 GetJobSystem() const			{ assert(mJobSystem); return mJobSystem; }
 
 private:
 
@@ -27,11 +29,13 @@ private:
 	friend class RenderDevice;
 	friend class RenderFactory;
 	friend class SceneManager;
+	friend class JobSystem;
 
 	Application* mApplication;
 	RenderDevice* mRenderDevice;
 	RenderFactory* mRenderFactory;
 	SceneManager* mSceneManager;
+	JobSystem* mJobSystem;
 };
 
 } // Namespace RcEngine
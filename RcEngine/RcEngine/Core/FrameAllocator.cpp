@@ -0,0 +1,97 @@
+#include <Core/FrameAllocator.h>
+#include <Core/Exception.h>
+
+namespace RcEngine {
+
+static inline uintptr_t AlignUp(uintptr_t value, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0);
+	return (value + alignment - 1) & ~uintptr_t(alignment - 1);
+}
+
+FrameAllocator::FrameAllocator( size_t capacity )
+	: mArena(nullptr),
+	  mCapacity(capacity),
+	  mOffset(0),
+	  mOverflowBytes(0),
+	  mPeakBytes(0),
+	  mNumOverflows(0)
+{
+	mArena = static_cast<uint8_t*>( std::malloc(mCapacity) );
+	if (!mArena)
+		ENGINE_EXCEPT(Exception::ERR_INTERNAL_ERROR, "Out of memory", "FrameAllocator::FrameAllocator");
+}
+
+FrameAllocator::~FrameAllocator()
+{
+	for (void* block : mOverflowBlocks)
+		std::free(block);
+
+	std::free(mArena);
+}
+
+void* FrameAllocator::Allocate( size_t size, size_t alignment )
+{
+	const uintptr_t base = reinterpret_cast<uintptr_t>(mArena);
+
+	size_t offset = mOffset.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		size_t alignedOffset = AlignUp(base + offset, alignment) - base;
+		size_t newOffset = alignedOffset + size;
+
+		if (newOffset > mCapacity)
+			return AllocateOverflow(size, alignment);
+
+		if (mOffset.compare_exchange_weak(offset, newOffset, std::memory_order_relaxed))
+			return mArena + alignedOffset;
+	}
+}
+
+void* FrameAllocator::AllocateOverflow( size_t size, size_t alignment )
+{
+	void* block = std::malloc(size + alignment);
+	if (!block)
+		ENGINE_EXCEPT(Exception::ERR_INTERNAL_ERROR, "Out of memory", "FrameAllocator::Allocate");
+
+	std::lock_guard<std::mutex> lock(mOverflowMutex);
+	mOverflowBlocks.push_back(block);
+	mOverflowBytes += size + alignment;
+
+	return reinterpret_cast<void*>( AlignUp(reinterpret_cast<uintptr_t>(block), alignment) );
+}
+
+size_t FrameAllocator::GetUsedBytes() const
+{
+	return mOffset.load(std::memory_order_relaxed) + mOverflowBytes;
+}
+
+void FrameAllocator::Reset()
+{
+	size_t usedBytes = GetUsedBytes();
+	mPeakBytes = (std::max)(mPeakBytes, usedBytes);
+
+	if (!mOverflowBlocks.empty())
+	{
+		for (void* block : mOverflowBlocks)
+			std::free(block);
+
+		mOverflowBlocks.clear();
+		mOverflowBytes = 0;
+		mNumOverflows++;
+
+		// Grow to the peak with some headroom, so following frames fit in the arena
+		size_t newCapacity = (std::max)(mCapacity * 2, mPeakBytes + mPeakBytes / 2);
+		uint8_t* newArena = static_cast<uint8_t*>( std::malloc(newCapacity) );
+		if (newArena)
+		{
+			std::free(mArena);
+			mArena = newArena;
+			mCapacity = newCapacity;
+		}
+	}
+
+	mOffset.store(0, std::memory_order_relaxed);
+}
+
+} // Namespace RcEngine
@@ -0,0 +1,75 @@
+#ifndef FrameAllocator_h__
+#define FrameAllocator_h__
+
+#include <Core/Prerequisites.h>
+#include <Core/Singleton.h>
+#include <atomic>
+#include <mutex>
+
+namespace RcEngine {
+
+/**
+ * Linear allocator for memory which only lives until the end of the frame, like per draw
+ * transforms. Allocate bumps an offset, Reset frees everything at once and is called by
+ * Application at the start of each frame.
+ *
+ * If a frame runs out of space, overflow blocks are taken from the heap and the next Reset
+ * grows the arena to the peak usage, so steady state frames never touch the heap.
+ *
+ * Allocate is thread safe, Reset is main thread only. Destructors are never called, only
+ * use it for trivially destructible types.
+ */
+class _ApiExport FrameAllocator : public Singleton<FrameAllocator>
+{
+public:
+	static const size_t DefaultCapacity = 1024 * 1024;
+	static const size_t DefaultAlignment = 16;
+
+public:
+	FrameAllocator(size_t capacity = DefaultCapacity);
+	~FrameAllocator();
+
+	void* Allocate(size_t size, size_t alignment = DefaultAlignment);
+
+	template <typename T>
+	inline T* AllocateArray(uint32_t count)		{ return static_cast<T*>(Allocate(sizeof(T) * count)); }
+
+	/**
+	 * Free all allocations of the last frame.
+	 */
+	void Reset();
+
+	inline size_t GetCapacity() const			{ return mCapacity; }
+	inline size_t GetPeakBytes() const			{ return mPeakBytes; }
+	inline uint32_t GetNumOverflows() const		{ return mNumOverflows; }
+
+	/**
+	 * Bytes allocated since last Reset, including overflow blocks.
+	 */
+	size_t GetUsedBytes() const;
+
+private:
+	FrameAllocator(const FrameAllocator&);
+	FrameAllocator& operator= (const FrameAllocator&);
+
+	void* AllocateOverflow(size_t size, size_t alignment);
+
+private:
+	uint8_t* mArena;
+	size_t mCapacity;
+	std::atomic<size_t> mOffset;
+
+	// Heap blocks of this frame once arena is full
+	std::mutex mOverflowMutex;
+	vector<void*> mOverflowBlocks;
+	size_t mOverflowBytes;
+
+	size_t mPeakBytes;
+
+	// Number of frames which had to use overflow blocks
+	uint32_t mNumOverflows;
+};
+
+} // Namespace RcEngine
+
+#endif // FrameAllocator_h__
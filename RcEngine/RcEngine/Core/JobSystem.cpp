@@ -0,0 +1,454 @@
+#include <Core/JobSystem.h>
+#include <Core/CpuInfo.h>
+#include <Core/Environment.h>
+#include <Core/Profiler.h>
+
+namespace RcEngine {
+
+/**
+ * Free jobs of one thread. Only the owner takes jobs from FreeJobs, other threads return
+ * jobs of this pool to RemoteFreeJobs, the owner takes them all when FreeJobs runs dry.
+ */
+struct JobPool
+{
+	static const uint32_t BlockSize = 256;
+
+	JobPool() : FreeJobs(nullptr), RemoteFreeJobs(nullptr) {}
+
+	Job* FreeJobs;
+	std::atomic<Job*> RemoteFreeJobs;
+	vector<Job*> Blocks;
+};
+
+/**
+ * Fixed size Chase-Lev deque. Owner thread pushes and pops at the bottom, other threads
+ * steal from the top. See "Correct and Efficient Work-Stealing for Weak Memory Models".
+ */
+class WorkStealingQueue
+{
+public:
+	static const int64_t Capacity = 4096;
+
+public:
+	WorkStealingQueue()
+		: mTop(0), mBottom(0)
+	{
+		for (int64_t i = 0; i < Capacity; ++i)
+			mJobs[i].store(nullptr, std::memory_order_relaxed);
+	}
+
+	// Owner only, return false if the queue is full
+	bool Push(Job* job)
+	{
+		int64_t bottom = mBottom.load(std::memory_order_relaxed);
+		int64_t top = mTop.load(std::memory_order_acquire);
+		if (bottom - top >= Capacity)
+			return false;
+
+		mJobs[bottom & (Capacity - 1)].store(job, std::memory_order_relaxed);
+		mBottom.store(bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Owner only
+	Job* Pop()
+	{
+		int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+		mBottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = mTop.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			// Empty
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = mJobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (top == bottom)
+		{
+			// Last job, race against thieves
+			if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				job = nullptr;
+
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		return job;
+	}
+
+	Job* Steal()
+	{
+		int64_t top = mTop.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = mBottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+			return nullptr;
+
+		Job* job = mJobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+
+		return job;
+	}
+
+private:
+	std::atomic<int64_t> mTop;
+	std::atomic<int64_t> mBottom;
+	std::atomic<Job*> mJobs[Capacity];
+};
+
+namespace {
+
+// Index of the deque owned by current thread, -1 for threads not owned by the job system
+ENGINE_THREAD_LOCAL int32_t ThreadQueueIndex = -1;
+
+}
+
+//////////////////////////////////////////////////////////////////////////
+JobCounter::JobCounter()
+	: mCount(0)
+{
+
+}
+
+JobCounter::~JobCounter()
+{
+	// Finishing job may still hold the mutex after count reaches zero
+	std::lock_guard<std::mutex> lock(mMutex);
+}
+
+//////////////////////////////////////////////////////////////////////////
+JobSystem::JobSystem( uint32_t numWorkers )
+	: mNumQueuedJobs(0),
+	  mNumSleepingWorkers(0),
+	  mShutdown(false)
+{
+	if (numWorkers == 0)
+	{
+		uint32_t numThreads = CpuInfo::GetNumHardwareThreads();
+		numWorkers = numThreads > 1 ? numThreads - 1 : 1;
+	}
+
+	mMainThreadID = std::this_thread::get_id();
+	ThreadQueueIndex = 0;
+
+	for (uint32_t i = 0; i <= numWorkers; ++i)
+		mQueues.push_back(new WorkStealingQueue);
+
+	for (uint32_t i = 0; i <= numWorkers + 1; ++i)
+		mJobPools.push_back(new JobPool);
+
+	for (uint32_t i = 0; i < numWorkers; ++i)
+		mWorkers.push_back(std::thread(&JobSystem::WorkerThreadFunc, this, i + 1));
+
+	if (Environment* environment = Environment::GetSingletonPtr())
+		environment->mJobSystem = this;
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mShutdown = true;
+	}
+	mSleepCondition.notify_all();
+
+	for (std::thread& worker : mWorkers)
+		worker.join();
+
+	// Jobs never executed
+	for (WorkStealingQueue* queue : mQueues)
+	{
+		while (Job* job = queue->Steal())
+			job->Invoke(*job, false);
+		delete queue;
+	}
+
+	while (Job* job = mSharedJobs.PopFront())
+		job->Invoke(*job, false);
+
+	while (Job* job = mMainThreadJobs.PopFront())
+		job->Invoke(*job, false);
+
+	for (JobPool* pool : mJobPools)
+	{
+		for (Job* block : pool->Blocks)
+			delete[] block;
+		delete pool;
+	}
+
+	ThreadQueueIndex = -1;
+
+	if (Environment* environment = Environment::GetSingletonPtr())
+		environment->mJobSystem = nullptr;
+}
+
+bool JobSystem::IsMainThread() const
+{
+	return std::this_thread::get_id() == mMainThreadID;
+}
+
+Job* JobSystem::AllocateJob()
+{
+	int32_t queueIndex = ThreadQueueIndex;
+	uint32_t poolIndex = (queueIndex < 0) ? uint32_t(mQueues.size()) : uint32_t(queueIndex);
+	JobPool& pool = *mJobPools[poolIndex];
+
+	// Threads not owned by the job system share one pool
+	std::unique_lock<std::mutex> lock(mSharedPoolMutex, std::defer_lock);
+	if (queueIndex < 0)
+		lock.lock();
+
+	if (!pool.FreeJobs)
+		pool.FreeJobs = pool.RemoteFreeJobs.exchange(nullptr, std::memory_order_acquire);
+
+	if (!pool.FreeJobs)
+	{
+		Job* block = new Job[JobPool::BlockSize];
+		for (uint32_t i = 0; i < JobPool::BlockSize; ++i)
+		{
+			block[i].Pool = poolIndex;
+			block[i].Next = (i + 1 < JobPool::BlockSize) ? &block[i + 1] : nullptr;
+		}
+
+		pool.Blocks.push_back(block);
+		pool.FreeJobs = block;
+	}
+
+	Job* job = pool.FreeJobs;
+	pool.FreeJobs = job->Next;
+	return job;
+}
+
+void JobSystem::FreeJob( Job* job )
+{
+	JobPool& pool = *mJobPools[job->Pool];
+
+	if (ThreadQueueIndex >= 0 && uint32_t(ThreadQueueIndex) == job->Pool)
+	{
+		job->Next = pool.FreeJobs;
+		pool.FreeJobs = job;
+	}
+	else
+	{
+		// Owner only ever takes the whole list, so pushing can't suffer from ABA
+		Job* next = pool.RemoteFreeJobs.load(std::memory_order_relaxed);
+		do
+		{
+			job->Next = next;
+		} while (!pool.RemoteFreeJobs.compare_exchange_weak(next, job, std::memory_order_release, std::memory_order_relaxed));
+	}
+}
+
+void JobSystem::Submit( Job* job, JobCounter* dependency )
+{
+	if (job->Counter)
+		job->Counter->mCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (dependency)
+	{
+		std::lock_guard<std::mutex> lock(dependency->mMutex);
+		if (dependency->mCount.load(std::memory_order_acquire) > 0)
+		{
+			dependency->mContinuations.PushBack(job);
+			return;
+		}
+	}
+
+	Enqueue(job);
+}
+
+void JobSystem::Enqueue( Job* job )
+{
+	if (job->MainThread)
+	{
+		std::lock_guard<std::mutex> lock(mMainThreadMutex);
+		mMainThreadJobs.PushBack(job);
+		return;
+	}
+
+	// Sleeping workers check mNumQueuedJobs under mSleepMutex, take the lock so the
+	// notification can't be lost between their check and wait.
+	mNumQueuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+	int32_t queueIndex = ThreadQueueIndex;
+	if (queueIndex < 0 || !mQueues[queueIndex]->Push(job))
+	{
+		std::lock_guard<std::mutex> lock(mSharedMutex);
+		mSharedJobs.PushBack(job);
+	}
+
+	if (mNumSleepingWorkers.load(std::memory_order_seq_cst) > 0)
+	{
+		{ std::lock_guard<std::mutex> lock(mSleepMutex); }
+		mSleepCondition.notify_one();
+	}
+}
+
+void JobSystem::Execute( Job* job )
+{
+	job->Invoke(*job, true);
+	Finish(job->Counter);
+	FreeJob(job);
+}
+
+void JobSystem::Finish( JobCounter* counter )
+{
+	if (!counter)
+		return;
+
+	Internal::JobQueue continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter->mMutex);
+		if (counter->mCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			std::swap(continuations, counter->mContinuations);
+	}
+
+	while (Job* job = continuations.PopFront())
+		Enqueue(job);
+}
+
+Job* JobSystem::FindJob( uint32_t queueIndex )
+{
+	Job* job = nullptr;
+
+	if (queueIndex < mQueues.size())
+		job = mQueues[queueIndex]->Pop();
+
+	if (!job)
+	{
+		std::lock_guard<std::mutex> lock(mSharedMutex);
+		job = mSharedJobs.PopFront();
+	}
+
+	if (!job)
+	{
+		// Start from the next queue so thieves spread over victims
+		uint32_t numQueues = mQueues.size();
+		for (uint32_t i = 1; i <= numQueues && !job; ++i)
+		{
+			uint32_t victim = (queueIndex + i) % numQueues;
+			if (victim != queueIndex)
+				job = mQueues[victim]->Steal();
+		}
+	}
+
+	if (job)
+		mNumQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+	return job;
+}
+
+bool JobSystem::RunMainThreadJob()
+{
+	Job* job = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mMainThreadMutex);
+		job = mMainThreadJobs.PopFront();
+	}
+
+	if (!job)
+		return false;
+
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Wait( JobCounter& counter )
+{
+	bool mainThread = IsMainThread();
+	int32_t queueIndex = ThreadQueueIndex;
+
+	while (!counter.IsDone())
+	{
+		if (mainThread && RunMainThreadJob())
+			continue;
+
+		if (Job* job = FindJob(queueIndex < 0 ? mQueues.size() : uint32_t(queueIndex)))
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::ParallelFor( uint32_t begin, uint32_t end, uint32_t grainSize, const RangeFunc& func )
+{
+	if (begin >= end)
+		return;
+
+	uint32_t count = end - begin;
+	grainSize = (std::max)(grainSize, 1U);
+
+	// Enough ranges to balance load, but not so many that scheduling dominates
+	uint32_t maxRanges = (GetNumWorkers() + 1) * 4;
+	uint32_t numRanges = (count + grainSize - 1) / grainSize;
+	if (numRanges > maxRanges)
+	{
+		grainSize = (count + maxRanges - 1) / maxRanges;
+		numRanges = (count + grainSize - 1) / grainSize;
+	}
+
+	if (numRanges <= 1 || mWorkers.empty())
+	{
+		func(begin, end);
+		return;
+	}
+
+	JobCounter counter;
+	for (uint32_t i = 1; i < numRanges; ++i)
+	{
+		uint32_t rangeBegin = begin + i * grainSize;
+		uint32_t rangeEnd = (std::min)(rangeBegin + grainSize, end);
+		Run([&func, rangeBegin, rangeEnd]() { func(rangeBegin, rangeEnd); }, &counter);
+	}
+
+	func(begin, (std::min)(begin + grainSize, end));
+	Wait(counter);
+}
+
+void JobSystem::Update()
+{
+	assert(IsMainThread());
+
+	// Only jobs queued before this call, new ones run next frame
+	size_t numJobs;
+	{
+		std::lock_guard<std::mutex> lock(mMainThreadMutex);
+		numJobs = mMainThreadJobs.Size;
+	}
+
+	for (size_t i = 0; i < numJobs && RunMainThreadJob(); ++i);
+}
+
+void JobSystem::WorkerThreadFunc( uint32_t queueIndex )
+{
+	ThreadQueueIndex = int32_t(queueIndex);
+
+	if (ProfilerManager* profiler = ProfilerManager::GetSingletonPtr())
+	{
+		std::ostringstream name;
+		name << "Worker " << queueIndex;
+		profiler->SetThreadName(name.str());
+	}
+
+	while (!mShutdown.load(std::memory_order_acquire))
+	{
+		if (Job* job = FindJob(queueIndex))
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mNumSleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+		mSleepCondition.wait(lock, [this]() {
+			return mNumQueuedJobs.load(std::memory_order_seq_cst) > 0 || mShutdown.load(std::memory_order_acquire);
+		});
+		mNumSleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+} // Namespace RcEngine
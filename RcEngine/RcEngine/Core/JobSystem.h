@@ -0,0 +1,269 @@
+#ifndef JobSystem_h__
+#define JobSystem_h__
+
+#include <Core/Prerequisites.h>
+#include <Core/Singleton.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <type_traits>
+
+namespace RcEngine {
+
+class JobCounter;
+class WorkStealingQueue;
+struct JobPool;
+
+/**
+ * Queued unit of work. Callables up to StorageSize bytes are stored in place, larger ones
+ * on the heap. Jobs are recycled through per thread pools of JobSystem, so submitting a
+ * small job does not allocate once the pools are warm.
+ */
+struct Job
+{
+	static const size_t StorageSize = 64;
+
+	// Call stored callable if call is true, then destroy it
+	typedef void (*InvokeFunc)(Job& job, bool call);
+
+	std::aligned_storage<StorageSize>::type Storage;
+	InvokeFunc Invoke;
+	JobCounter* Counter;
+
+	// Link in free list or continuation list
+	Job* Next;
+
+	// Pool the job is returned to
+	uint32_t Pool;
+	bool MainThread;
+};
+
+namespace Internal {
+
+// FIFO of jobs linked through Job::Next
+struct JobQueue
+{
+	Job* First;
+	Job* Last;
+	size_t Size;
+
+	JobQueue() : First(nullptr), Last(nullptr), Size(0) {}
+
+	bool Empty() const			{ return First == nullptr; }
+
+	void PushBack(Job* job)
+	{
+		job->Next = nullptr;
+		if (Last)
+			Last->Next = job;
+		else
+			First = job;
+		Last = job;
+		++Size;
+	}
+
+	Job* PopFront()
+	{
+		Job* job = First;
+		if (job)
+		{
+			First = job->Next;
+			if (!First)
+				Last = nullptr;
+			--Size;
+		}
+		return job;
+	}
+};
+
+template <typename Func, bool InPlace = (sizeof(Func) <= Job::StorageSize &&
+	std::alignment_of<Func>::value <= std::alignment_of<std::aligned_storage<Job::StorageSize>::type>::value)>
+struct JobCallable
+{
+	static void Store(Job& job, const Func& func)
+	{
+		new (&job.Storage) Func(func);
+		job.Invoke = &Invoke;
+	}
+
+	static void Invoke(Job& job, bool call)
+	{
+		Func& func = *reinterpret_cast<Func*>(&job.Storage);
+		if (call)
+			func();
+		func.~Func();
+	}
+};
+
+template <typename Func>
+struct JobCallable<Func, false>
+{
+	static void Store(Job& job, const Func& func)
+	{
+		*reinterpret_cast<Func**>(&job.Storage) = new Func(func);
+		job.Invoke = &Invoke;
+	}
+
+	static void Invoke(Job& job, bool call)
+	{
+		Func* func = *reinterpret_cast<Func**>(&job.Storage);
+		if (call)
+			(*func)();
+		delete func;
+	}
+};
+
+}
+
+/**
+ * Number of unfinished jobs of a group. A counter is incremented when a job is submitted
+ * with it and decremented when the job finishes. Jobs can depend on a counter, they are
+ * queued once it reaches zero. A counter must outlive all jobs referencing it, and must
+ * not be reused before it reaches zero.
+ */
+class _ApiExport JobCounter
+{
+public:
+	JobCounter();
+	~JobCounter();
+
+	inline bool IsDone() const			{ return mCount.load(std::memory_order_acquire) == 0; }
+	inline int32_t GetCount() const		{ return mCount.load(std::memory_order_acquire); }
+
+private:
+	friend class JobSystem;
+
+	JobCounter(const JobCounter&);
+	JobCounter& operator= (const JobCounter&);
+
+	std::atomic<int32_t> mCount;
+
+	// Jobs waiting for this counter to reach zero
+	std::mutex mMutex;
+	Internal::JobQueue mContinuations;
+};
+
+/**
+ * Work stealing job scheduler. Each worker thread owns a lock free deque, it pushes and
+ * pops jobs at the bottom while idle workers steal from the top. The main thread owns a
+ * deque as well and executes jobs while waiting for a counter. Jobs submitted from other
+ * threads, e.g. resource loader threads, go to a shared queue.
+ *
+ * Main thread jobs are only executed on the main thread, in Update or while the main
+ * thread waits for a counter. Use them for work touching the render device.
+ *
+ * Jobs must not throw.
+ */
+class _ApiExport JobSystem : public Singleton<JobSystem>
+{
+public:
+	typedef std::function<void()> JobFunc;
+	typedef std::function<void(uint32_t, uint32_t)> RangeFunc;
+
+public:
+	/**
+	 * Start numWorkers threads, 0 means one per hardware thread except the main thread.
+	 * Must be created on the main thread.
+	 */
+	JobSystem(uint32_t numWorkers = 0);
+	~JobSystem();
+
+	inline uint32_t GetNumWorkers() const	{ return mWorkers.size(); }
+
+	bool IsMainThread() const;
+
+	/**
+	 * Submit a job calling func(). If counter is not null it is incremented now and
+	 * decremented when the job finishes. If dependency is not null, the job is queued once
+	 * it reaches zero.
+	 */
+	template <typename Func>
+	void Run(const Func& func, JobCounter* counter = nullptr, JobCounter* dependency = nullptr)
+	{
+		Submit(CreateJob(func, counter, false), dependency);
+	}
+
+	/**
+	 * Same as Run, but the job is only executed on the main thread.
+	 */
+	template <typename Func>
+	void RunOnMainThread(const Func& func, JobCounter* counter = nullptr, JobCounter* dependency = nullptr)
+	{
+		Submit(CreateJob(func, counter, true), dependency);
+	}
+
+	/**
+	 * Execute other jobs until counter reaches zero. Never wait in a job for a counter of
+	 * a main thread job, it can only complete on the main thread.
+	 */
+	void Wait(JobCounter& counter);
+
+	/**
+	 * Split [begin, end) into ranges of at least grainSize and call func(rangeBegin, rangeEnd)
+	 * for each in parallel. Return when all ranges are done, the calling thread takes part.
+	 */
+	void ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const RangeFunc& func);
+
+	/**
+	 * Execute pending main thread jobs. Called once per frame by Application.
+	 */
+	void Update();
+
+private:
+	JobSystem(const JobSystem&);
+	JobSystem& operator= (const JobSystem&);
+
+	template <typename Func>
+	Job* CreateJob(const Func& func, JobCounter* counter, bool mainThread)
+	{
+		Job* job = AllocateJob();
+		Internal::JobCallable<Func>::Store(*job, func);
+		job->Counter = counter;
+		job->MainThread = mainThread;
+		return job;
+	}
+
+	Job* AllocateJob();
+	void FreeJob(Job* job);
+
+	void Submit(Job* job, JobCounter* dependency);
+	void Enqueue(Job* job);
+	void Execute(Job* job);
+	void Finish(JobCounter* counter);
+
+	Job* FindJob(uint32_t queueIndex);
+	bool RunMainThreadJob();
+
+	void WorkerThreadFunc(uint32_t queueIndex);
+
+private:
+	vector<std::thread> mWorkers;
+
+	// Queue 0 belongs to main thread, queue i to worker i-1
+	vector<WorkStealingQueue*> mQueues;
+
+	// Pool i belongs to the owner of queue i, last pool to threads not owned by the job system
+	vector<JobPool*> mJobPools;
+	std::mutex mSharedPoolMutex;
+
+	// Jobs submitted from threads not owned by the job system
+	std::mutex mSharedMutex;
+	Internal::JobQueue mSharedJobs;
+
+	std::mutex mMainThreadMutex;
+	Internal::JobQueue mMainThreadJobs;
+
+	// Sleeping workers are woken up when the number of queued jobs becomes non zero
+	std::atomic<int32_t> mNumQueuedJobs;
+	std::atomic<int32_t> mNumSleepingWorkers;
+	std::mutex mSleepMutex;
+	std::condition_variable mSleepCondition;
+
+	std::thread::id mMainThreadID;
+	std::atomic<bool> mShutdown;
+};
+
+} // Namespace RcEngine
+
+#endif // JobSystem_h__
@@ -0,0 +1,23 @@
+#include <Core/MemoryHook.h>
+#include <atomic>
+
+namespace RcEngine {
+
+// Zero initialized before any static constructor allocates
+static std::atomic<AllocationHook> gAllocationHook(nullptr);
+
+void SetAllocationHook( AllocationHook hook )
+{
+	gAllocationHook.store(hook);
+}
+
+void NotifyAllocation( size_t size )
+{
+	AllocationHook hook = gAllocationHook.load(std::memory_order_relaxed);
+	if (hook)
+		hook(size);
+}
+
+} // Namespace RcEngine
+
+#include <Core/MemoryHook.inl>
@@ -0,0 +1,26 @@
+#ifndef MemoryHook_h__
+#define MemoryHook_h__
+
+#include <Core/Prerequisites.h>
+
+namespace RcEngine {
+
+/**
+ * Called with the size of every operator new in the engine and in each module including
+ * MemoryHook.inl, in all build configurations. Tests use it to count heap allocations.
+ */
+typedef void (*AllocationHook)(size_t size);
+
+/**
+ * Install hook, nullptr removes it. Hook is called from any thread and must not allocate.
+ */
+_ApiExport void SetAllocationHook(AllocationHook hook);
+
+/**
+ * Forward one allocation to the installed hook, called by the operators in MemoryHook.inl.
+ */
+_ApiExport void NotifyAllocation(size_t size);
+
+} // Namespace RcEngine
+
+#endif // MemoryHook_h__
@@ -0,0 +1,54 @@
+// Global operator new and delete reporting to RcEngine::NotifyAllocation. A DLL only sees
+// its own replacement, so every module includes this in exactly one source file. Static
+// builds link the engine's copy only.
+
+#include <Core/MemoryHook.h>
+#include <cstdlib>
+#include <new>
+
+void* operator new(size_t size)
+{
+	RcEngine::NotifyAllocation(size);
+
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+	RcEngine::NotifyAllocation(size);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) throw()
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+	std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+	std::free(p);
+}
@@ -2,7 +2,12 @@
 #include <Core/Utility.h>
 #include <Core/IModule.h>
 #include <Core/Exception.h>
-#include <windows.h>
+
+#if defined(RcWindows)
+	#include <windows.h>
+#else
+	#include <dlfcn.h>
+#endif
 
 namespace RcEngine{
 
@@ -11,11 +16,12 @@ typedef void (*DLL_START_PLUGIN)(IModule** pModule);
 class DynLib
 {
 public:
-	DynLib(const String& name) : mName(name) {}
+	DynLib(const String& name) : mName(name), m_hInst(0) {}
 	~DynLib() { Unload(); }
 
 	const String& GetName() const { return mName; }
 
+#if defined(RcWindows)
 	void Load()
 	{
 		String name = mName;
@@ -63,6 +69,37 @@ public:
 	{
 		return (void*)GetProcAddress(m_hInst, strName.c_str());
 	}
+#else
+	void Load()
+	{
+		String name = mName;
+		if (name.length() < 3 || name.substr(name.length() - 3, 3) != ".so")
+			name = "lib" + name + ".so";
+
+		m_hInst = dlopen(name.c_str(), RTLD_NOW | RTLD_LOCAL);
+		if (!m_hInst)
+		{
+			fprintf(stderr, "%s\n", dlerror());
+
+			String error = "Load " + name + " failed!";
+			ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND,  error, "DynLib::Load");
+		}
+	}
+
+	void Unload()
+	{
+		if (m_hInst)
+		{
+			dlclose(m_hInst);
+			m_hInst = 0;
+		}
+	}
+
+	void* GetSymbol( const String& strName ) const throw()
+	{
+		return dlsym(m_hInst, strName.c_str());
+	}
+#endif
 
 	std::string DynLibError()
 	{
@@ -71,7 +108,11 @@ public:
 
 private:
 	String mName;
+#if defined(RcWindows)
 	HINSTANCE m_hInst;
+#else
+	void* m_hInst;
+#endif
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -14,6 +14,7 @@ enum ModuleType
 {
 	MT_Render_OpengGL = 0,
 	MT_Render_D3D11,
+	MT_Render_Null,
 	MT_Count
 };
 
@@ -23,9 +24,11 @@ const String ModuleNames[MT_Count] =
 #ifdef _DEBUG
 	"OpenGLRenderSystem_d",
 	"Direct3D11RenderSystem_d",
+	"NullRenderSystem_d",
 #else
 	"OpenGLRenderSystem",
 	"Direct3D11RenderSystem",
+	"NullRenderSystem",
 #endif
 };
 
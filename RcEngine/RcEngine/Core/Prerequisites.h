@@ -79,6 +79,13 @@ typedef std::map<String, String> NameValuePairList;
 #define public_internal public
 #define SAFE_DELETE(p) if(p) { delete p; p = NULL;}
 
+// Thread local storage of POD types, VS2013 lacks thread_local
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#	define ENGINE_THREAD_LOCAL __declspec(thread)
+#else
+#	define ENGINE_THREAD_LOCAL thread_local
+#endif
+
 // Compile time type-safe array size
 template <typename T, int N> char(&dim_helper(T(&)[N]))[N];
 #define ARRAY_SIZE(x) (sizeof(dim_helper(x)))
@@ -145,6 +152,7 @@ class AnimationPlayer;
 class AnimationState;
 class AnimationClip;
 class AnimationController;
+struct AnimationPose;
 
 class UIWindow;
 class Label;
@@ -1,133 +1,468 @@
 #include <Core/Profiler.h>
 #include <Core/Timer.h>
-
-#define INVALID_TIME	((uint64_t)(-1))
-#define INVALID_INDEX   ((size_t)(-1))
+#include <IO/FileStream.h>
+#include <atomic>
 
 namespace RcEngine {
 
+enum ProfileCategory
+{
+	PC_Cpu = 0,
+	PC_Gpu
+};
+
+static const char* CategoryNames[] = { "cpu", "gpu" };
+
+/**
+ * Scopes of one thread. Only the owner thread touches the scope stack and writes
+ * events, EndFrame on main thread reads them. Events are a single producer single
+ * consumer ring buffer, events are dropped if the main thread falls behind.
+ */
+struct ThreadProfile
+{
+	static const uint32_t MaxCallStackDepth = 64;
+	static const uint32_t Capacity = 8192;
+
+	String Name;
+	uint32_t Index;
+
+	const char* ScopeNames[MaxCallStackDepth];
+	uint64_t ScopeStartTimes[MaxCallStackDepth];
+	uint32_t ScopeCategories[MaxCallStackDepth];
+	uint32_t CallStackDepth;
+
+	ProfilerManager::ProfileEvent Events[Capacity];
+	std::atomic<uint32_t> Head;
+	std::atomic<uint32_t> Tail;
+	std::atomic<uint32_t> NumDropped;
+
+	ThreadProfile() : Index(0), CallStackDepth(0), Head(0), Tail(0), NumDropped(0) {}
+
+	void Push(const ProfilerManager::ProfileEvent& evt)
+	{
+		uint32_t head = Head.load(std::memory_order_relaxed);
+		if (head - Tail.load(std::memory_order_acquire) >= Capacity)
+		{
+			NumDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		Events[head % Capacity] = evt;
+		Head.store(head + 1, std::memory_order_release);
+	}
+};
+
+namespace {
+
+ENGINE_THREAD_LOCAL ThreadProfile* CurrentThreadProfile = nullptr;
+ENGINE_THREAD_LOCAL ProfilerManager* CurrentThreadProfiler = nullptr;
+
+void WriteJsonString(std::ostringstream& stream, const char* str)
+{
+	stream << '"';
+	for (; *str; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+			stream << '\\' << *str;
+		else if ((unsigned char)*str < 0x20)
+			stream << ' ';
+		else
+			stream << *str;
+	}
+	stream << '"';
+}
+
+}
+
 //////////////////////////////////////////////////////////////////////////
 CpuAutoProfiler::CpuAutoProfiler( const char* name )
+	: Active(ProfilerManager::IsEnabled())
 {
-	ProfilerManager::GetSingleton().ProfilerStart(name);
+	if (Active)
+		ProfilerManager::GetSingleton().ProfilerStart(name, PC_Cpu);
 }
 
 CpuAutoProfiler::~CpuAutoProfiler()
 {
-	ProfilerManager::GetSingleton().ProfilerEnd();
+	if (Active)
+		ProfilerManager::GetSingleton().ProfilerEnd();
+}
+
+GpuAutoProfiler::GpuAutoProfiler( const char* name )
+	: Active(ProfilerManager::IsEnabled())
+{
+	if (Active)
+		ProfilerManager::GetSingleton().ProfilerStart(name, PC_Gpu);
+}
+
+GpuAutoProfiler::~GpuAutoProfiler()
+{
+	if (Active)
+		ProfilerManager::GetSingleton().ProfilerEnd();
 }
 
 //////////////////////////////////////////////////////////////////////////
+std::atomic<bool> ProfilerManager::msEnabled(false);
+
 ProfilerManager::ProfilerManager()
-	: mCurrNumSamples(0),
-	  mLastOpenedSample(INVALID_INDEX),
-	  mCallStackDepth(0)
+	: mNumFrames(0),
+	  mFrameBeginTime(SystemClock::Now())
 {
-
+	GetThreadProfile()->Name = "Main";
 }
 
 ProfilerManager::~ProfilerManager()
 {
+	for (ThreadProfile* profile : mThreads)
+		delete profile;
 
+	CurrentThreadProfile = nullptr;
+	CurrentThreadProfiler = nullptr;
+}
+
+void ProfilerManager::SetEnabled( bool enable )
+{
+	msEnabled.store(enable, std::memory_order_relaxed);
+}
+
+ThreadProfile* ProfilerManager::GetThreadProfile()
+{
+	if (CurrentThreadProfiler != this)
+	{
+		ThreadProfile* profile = new ThreadProfile;
+
+		std::lock_guard<std::mutex> lock(mThreadsMutex);
+		profile->Index = mThreads.size();
+
+		std::ostringstream name;
+		name << "Thread " << profile->Index;
+		profile->Name = name.str();
+
+		mThreads.push_back(profile);
+
+		CurrentThreadProfile = profile;
+		CurrentThreadProfiler = this;
+	}
+
+	return CurrentThreadProfile;
+}
+
+void ProfilerManager::SetThreadName( const String& name )
+{
+	ThreadProfile* profile = GetThreadProfile();
+
+	std::lock_guard<std::mutex> lock(mThreadsMutex);
+	profile->Name = name;
 }
 
 void ProfilerManager::ProfilerStart( const char* name )
 {
-	bool found = false;
-	for (uint32_t i = 0; i < mCurrNumSamples; ++i)
+	ProfilerStart(name, PC_Cpu);
+}
+
+void ProfilerManager::ProfilerStart( const char* name, uint32_t category )
+{
+	ThreadProfile* profile = GetThreadProfile();
+
+	// Too deep scopes are only counted to keep start and end balanced
+	uint32_t depth = profile->CallStackDepth++;
+	if (depth < ThreadProfile::MaxCallStackDepth)
+	{
+		profile->ScopeNames[depth] = name;
+		profile->ScopeCategories[depth] = category;
+		profile->ScopeStartTimes[depth] = SystemClock::Now();
+	}
+}
+
+void ProfilerManager::ProfilerEnd()
+{
+	ThreadProfile* profile = GetThreadProfile();
+	if (profile->CallStackDepth == 0)
+		return;
+
+	uint32_t depth = --profile->CallStackDepth;
+	if (depth < ThreadProfile::MaxCallStackDepth)
+	{
+		ProfileEvent evt;
+		evt.Name = profile->ScopeNames[depth];
+		evt.StartTime = profile->ScopeStartTimes[depth];
+		evt.EndTime = SystemClock::Now();
+		evt.CallStackDepth = depth;
+		evt.Category = profile->ScopeCategories[depth];
+
+		profile->Push(evt);
+	}
+}
+
+void ProfilerManager::EndFrame()
+{
+	uint64_t frameEndTime = SystemClock::Now();
+
+	FrameRecord& frame = mFrames[mNumFrames % NumHistoryFrames];
+	frame.StartTime = mFrameBeginTime;
+	frame.EndTime = frameEndTime;
+	frame.Events.clear();
+
 	{
-		if (mSamples[i].SampleName == name)
+		std::lock_guard<std::mutex> lock(mThreadsMutex);
+		for (ThreadProfile* profile : mThreads)
 		{
-			mSamples[i].ParentSampleIndex = mLastOpenedSample;
-			mLastOpenedSample = i;
+			uint32_t tail = profile->Tail.load(std::memory_order_relaxed);
+			uint32_t head = profile->Head.load(std::memory_order_acquire);
 
-			mSamples[i].CallStackDepth = mCallStackDepth++;
-			++mSamples[i].CallCount;
+			for (; tail != head; ++tail)
+				frame.Events.push_back(std::make_pair(profile->Index, profile->Events[tail % ThreadProfile::Capacity]));
 
-			found = true;
-			break;
+			profile->Tail.store(head, std::memory_order_release);
 		}
 	}
 
-	if (!found)
+	// Scopes are recorded when they end, sort by start so parents come before their children
+	std::sort(frame.Events.begin(), frame.Events.end(), [](const std::pair<uint32_t, ProfileEvent>& a, const std::pair<uint32_t, ProfileEvent>& b) {
+		if (a.first != b.first)
+			return a.first < b.first;
+		if (a.second.StartTime != b.second.StartTime)
+			return a.second.StartTime < b.second.StartTime;
+		return a.second.CallStackDepth < b.second.CallStackDepth;
+	});
+
+	mEventSamples.resize(frame.Events.size());
+	mEventChildTimes.assign(frame.Events.size(), 0);
+
+	// Latest scope at each depth of current thread, an ancestor if it contains the event.
+	// Parents started in an earlier frame or dropped are not found.
+	int32_t openScopes[ThreadProfile::MaxCallStackDepth];
+	uint32_t threadIndex = UINT32_MAX;
+
+	for (size_t i = 0; i < frame.Events.size(); ++i)
 	{
-		size_t index = mCurrNumSamples++;
-		assert(index < MAX_PROFILERS);
-		
-		mSamples[index].SampleName = name;
-		mSamples[index].SampleIndex = index;
-
-		mSamples[index].ParentSampleIndex = mLastOpenedSample;
-		mLastOpenedSample = index;
-
-		mSamples[index].CallStackDepth = mCallStackDepth++;
-		mSamples[index].CallCount = 1;
-		mSamples[index].TotalTime = 0;
-		mSamples[index].TotalChildTime = 0;
-
-		mSamples[index].StartTime = SystemClock::Now();
-	
-		if (mSamples[index].ParentSampleIndex == INVALID_INDEX)
+		const auto& threadEvent = frame.Events[i];
+		const ProfileEvent& evt = threadEvent.second;
+		const uint64_t duration = evt.EndTime - evt.StartTime;
+
+		if (threadEvent.first != threadIndex)
 		{
-			// Root Begin
-			mFrameBeginTime = mSamples[index].StartTime;
+			threadIndex = threadEvent.first;
+			std::fill(openScopes, openScopes + ThreadProfile::MaxCallStackDepth, -1);
 		}
-	}
-}
 
-void ProfilerManager::ProfilerEnd( )
-{
-	uint64_t endTime = SystemClock::Now();
-	uint64_t elapsedTime = endTime - mSamples[mLastOpenedSample].StartTime;
+		bool recursive = false;
+		for (uint32_t depth = 0; depth < evt.CallStackDepth; ++depth)
+		{
+			if (openScopes[depth] < 0)
+				continue;
+
+			const ProfileEvent& ancestor = frame.Events[openScopes[depth]].second;
+			if (ancestor.StartTime > evt.StartTime || ancestor.EndTime < evt.EndTime)
+				continue;
+
+			recursive |= (ancestor.Name == evt.Name);
+			if (depth + 1 == evt.CallStackDepth)
+				mEventChildTimes[openScopes[depth]] += duration;
+		}
+		openScopes[evt.CallStackDepth] = int32_t(i);
+
+		auto key = std::make_pair(threadEvent.first, evt.Name);
+		auto iter = mSampleIndices.find(key);
+		if (iter == mSampleIndices.end())
+		{
+			SampleRecord record;
+			memset(&record, 0, sizeof(record));
+			record.Name = evt.Name;
+			record.ThreadIndex = threadEvent.first;
+
+			iter = mSampleIndices.insert(std::make_pair(key, uint32_t(mSamples.size()))).first;
+			mSamples.push_back(record);
+		}
 
-	if (mSamples[mLastOpenedSample].ParentSampleIndex != INVALID_INDEX)
+		SampleRecord& record = mSamples[iter->second];
+		record.FrameCalls++;
+
+		// Outermost scope of a name already covers nested ones
+		if (!recursive)
+		{
+			record.CallStackDepth = evt.CallStackDepth;
+			record.FrameTime += duration;
+		}
+
+		mEventSamples[i] = iter->second;
+	}
+
+	// Children are all known now
+	for (size_t i = 0; i < frame.Events.size(); ++i)
 	{
-		size_t parentIndex = mSamples[mLastOpenedSample].ParentSampleIndex;
-		mSamples[parentIndex].TotalChildTime += elapsedTime;
+		const ProfileEvent& evt = frame.Events[i].second;
+		uint64_t duration = evt.EndTime - evt.StartTime;
+		mSamples[mEventSamples[i]].FrameSelfTime += duration - (std::min)(duration, mEventChildTimes[i]);
 	}
-	else
+
+	uint32_t slot = mNumFrames % NumHistoryFrames;
+	for (SampleRecord& record : mSamples)
 	{
-		// Root End
-		mFrameEndTime = endTime;
+		record.HistoryTime[slot] = record.FrameTime;
+		record.HistorySelfTime[slot] = record.FrameSelfTime;
+		record.HistoryCalls[slot] = record.FrameCalls;
+		record.FrameTime = 0;
+		record.FrameSelfTime = 0;
+		record.FrameCalls = 0;
 	}
 
-	mSamples[mLastOpenedSample].TotalTime += elapsedTime;
-	mLastOpenedSample = mSamples[mLastOpenedSample].ParentSampleIndex;
-	--mCallStackDepth;
+	++mNumFrames;
+	mFrameBeginTime = frameEndTime;
 }
 
 void ProfilerManager::ResetProfiler( const char* name )
 {
-
+	for (SampleRecord& record : mSamples)
+	{
+		if (strcmp(record.Name, name) == 0)
+		{
+			memset(record.HistoryTime, 0, sizeof(record.HistoryTime));
+			memset(record.HistorySelfTime, 0, sizeof(record.HistorySelfTime));
+			memset(record.HistoryCalls, 0, sizeof(record.HistoryCalls));
+		}
+	}
 }
 
 void ProfilerManager::ResetAll()
 {
-	
+	mSamples.clear();
+	mSampleIndices.clear();
+
+	for (FrameRecord& frame : mFrames)
+		frame.Events.clear();
+
+	mNumFrames = 0;
+}
+
+void ProfilerManager::GetSampleStats( vector<SampleStats>& stats ) const
+{
+	stats.clear();
+
+	uint32_t numFrames = (std::min)(mNumFrames, NumHistoryFrames);
+	for (const SampleRecord& record : mSamples)
+	{
+		uint64_t minTime = UINT64_MAX, maxTime = 0, totalTime = 0, totalSelfTime = 0;
+		uint32_t numCalledFrames = 0, totalCalls = 0;
+
+		for (uint32_t i = 0; i < numFrames; ++i)
+		{
+			if (record.HistoryCalls[i] == 0)
+				continue;
+
+			minTime = (std::min)(minTime, record.HistoryTime[i]);
+			maxTime = (std::max)(maxTime, record.HistoryTime[i]);
+			totalTime += record.HistoryTime[i];
+			totalSelfTime += record.HistorySelfTime[i];
+			totalCalls += record.HistoryCalls[i];
+			numCalledFrames++;
+		}
+
+		if (numCalledFrames == 0)
+			continue;
+
+		SampleStats sample;
+		sample.Name = record.Name;
+		sample.ThreadIndex = record.ThreadIndex;
+		sample.CallStackDepth = record.CallStackDepth;
+		sample.MinTime = SystemClock::ToSeconds(minTime);
+		sample.MaxTime = SystemClock::ToSeconds(maxTime);
+		sample.AvgTime = SystemClock::ToSeconds(totalTime) / numCalledFrames;
+		sample.AvgSelfTime = SystemClock::ToSeconds(totalSelfTime) / numCalledFrames;
+		sample.AvgCallCount = double(totalCalls) / numCalledFrames;
+		stats.push_back(sample);
+	}
+
+	std::stable_sort(stats.begin(), stats.end(), [](const SampleStats& a, const SampleStats& b) {
+		return a.ThreadIndex < b.ThreadIndex;
+	});
 }
 
 void ProfilerManager::Output()
 {
-	for (uint32_t i = 0; i < mCurrNumSamples; ++i)
+	vector<SampleStats> stats;
+	GetSampleStats(stats);
+
+	std::lock_guard<std::mutex> lock(mThreadsMutex);
+
+	uint32_t threadIndex = UINT32_MAX;
+	for (const SampleStats& sample : stats)
 	{
+		if (sample.ThreadIndex != threadIndex)
+		{
+			threadIndex = sample.ThreadIndex;
+			printf("%s:\n", mThreads[threadIndex]->Name.c_str());
+		}
 
 		char namebuf[256];
 
-		for (uint32_t indent = 0; indent < mSamples[i].CallStackDepth; ++indent)
-			namebuf[indent] = ' ';
+		uint32_t indent = (std::min)(sample.CallStackDepth + 1, 64U);
+		memset(namebuf, ' ', indent);
+		strncpy(namebuf + indent, sample.Name, sizeof(namebuf) - indent - 1);
+		namebuf[sizeof(namebuf) - 1] = 0;
 
-		strcpy(namebuf + mSamples[i].CallStackDepth, mSamples[i].SampleName);
-		printf("time=%f, childTime=%f, call=%d, %s\n", SystemClock::ToSeconds(mSamples[i].TotalTime), SystemClock::ToSeconds(mSamples[i].TotalChildTime), mSamples[i].CallCount, namebuf);
+		printf("avg=%.3fms, min=%.3fms, max=%.3fms, self=%.3fms, calls=%.1f, %s\n", sample.AvgTime * 1000.0, sample.MinTime * 1000.0,
+			sample.MaxTime * 1000.0, sample.AvgSelfTime * 1000.0, sample.AvgCallCount, namebuf);
+	}
 
-		//reset the sample for next time
-		mSamples[i].CallCount = 0;
-		mSamples[i].TotalTime = 0;
-		mSamples[i].TotalChildTime = 0;
+	for (ThreadProfile* profile : mThreads)
+	{
+		uint32_t numDropped = profile->NumDropped.load(std::memory_order_relaxed);
+		if (numDropped)
+			printf("%s: %u scopes dropped\n", profile->Name.c_str(), numDropped);
 	}
 }
 
+bool ProfilerManager::ExportChromeTrace( const String& fileName ) const
+{
+	uint32_t numFrames = (std::min)(mNumFrames, NumHistoryFrames);
+	uint32_t firstFrame = mNumFrames - numFrames;
+	uint64_t baseTime = numFrames ? mFrames[firstFrame % NumHistoryFrames].StartTime : 0;
+
+	std::ostringstream json;
+	json.setf(std::ios::fixed);
+	json.precision(3);
+	json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool first = true;
+	{
+		std::lock_guard<std::mutex> lock(mThreadsMutex);
+		for (ThreadProfile* profile : mThreads)
+		{
+			json << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << profile->Index << ",\"args\":{\"name\":";
+			WriteJsonString(json, profile->Name.c_str());
+			json << "}}";
+			first = false;
+		}
+	}
+
+	for (uint32_t i = firstFrame; i < mNumFrames; ++i)
+	{
+		const FrameRecord& frame = mFrames[i % NumHistoryFrames];
+		for (const auto& threadEvent : frame.Events)
+		{
+			const ProfileEvent& evt = threadEvent.second;
+
+			// Scopes started before the history window
+			if (evt.StartTime < baseTime)
+				continue;
+
+			json << ",\n{\"name\":";
+			WriteJsonString(json, evt.Name);
+			json << ",\"cat\":\"" << CategoryNames[evt.Category] << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << threadEvent.first
+				 << ",\"ts\":" << SystemClock::ToSeconds(evt.StartTime - baseTime) * 1e6
+				 << ",\"dur\":" << SystemClock::ToSeconds(evt.EndTime - evt.StartTime) * 1e6 << "}";
+		}
+	}
 
+	json << "\n]}\n";
 
+	FileStream stream;
+	if (!stream.Open(fileName, FILE_WRITE))
+		return false;
 
+	String content = json.str();
+	return stream.Write(content.c_str(), content.length()) == content.length();
+}
 
-}
\ No newline at end of file
+}
@@ -3,89 +3,173 @@
 
 #include <Core/Prerequisites.h>
 #include <Core/Singleton.h>
+#include <atomic>
+#include <mutex>
 
 namespace RcEngine {
 
-#define INVALID_TIME	((uint64_t)(-1))
-#define MAX_PROFILERS   (200)
-
+struct ThreadProfile;
+
+/**
+ * Hierarchical CPU profiler usable from any thread. Each thread records finished scopes
+ * into its own lock free ring buffer, EndFrame collects them on the main thread into a
+ * history of recent frames. Statistics are per thread and scope name, min/avg/max are
+ * computed from per frame inclusive time over the history. A scope nested in a scope of
+ * the same name adds to exclusive time and calls only, so recursion is not counted twice.
+ *
+ * Scopes are identified by the name pointer, use string literals. Profiler is disabled
+ * until SetEnabled(true).
+ */
 class _ApiExport ProfilerManager : public Singleton<ProfilerManager>
 {
-	struct ProfilerSample
-	{
-		const char* SampleName;
-
-		size_t SampleIndex;
-		size_t ParentSampleIndex;
-
-		uint64_t StartTime;
-		uint64_t TotalTime;
-		uint64_t TotalChildTime;
+public:
+	static const uint32_t NumHistoryFrames = 128;
 
-		uint32_t CallCount;
+	struct SampleStats
+	{
+		const char* Name;
+		uint32_t ThreadIndex;
 		uint32_t CallStackDepth;
 
-		ProfilerSample() : TotalTime(0), CallCount(0) {}
-	};
-
-
-	struct Marker
-	{
-		uint32_t Frame;
+		// Per frame inclusive time in seconds, over frames the scope was entered
+		double MinTime, AvgTime, MaxTime;
 
-		uint64_t StartTime, TotalTime, TotalChildTime;
-		
-		uint32_t CallCount;
-		uint32_t CallStackDepth;
+		// Per frame exclusive time, without child scopes
+		double AvgSelfTime;
+		double AvgCallCount;
 	};
 
-
 public:
 	ProfilerManager();
 	~ProfilerManager();
 
+	/**
+	 * Disabled profiler only costs a flag check per scope.
+	 */
+	static inline bool IsEnabled()	{ return msEnabled.load(std::memory_order_relaxed); }
+	static void SetEnabled(bool enable);
+
 public:
 	void ProfilerStart(const char* name);
 	void ProfilerEnd();
 
+	/**
+	 * Name current thread in outputs, threads are named "Thread N" by default.
+	 */
+	void SetThreadName(const String& name);
+
+	/**
+	 * Collect scopes finished by all threads since last call as one frame. Called by
+	 * Application at end of each frame, main thread only.
+	 */
+	void EndFrame();
+
 	void ResetProfiler(const char* name);
 	void ResetAll();
 
+	void GetSampleStats(vector<SampleStats>& stats) const;
+
 	void Output();
 
+	/**
+	 * Write scopes of history frames in Chrome trace event format, open with
+	 * about:tracing or ui.perfetto.dev.
+	 */
+	bool ExportChromeTrace(const String& fileName) const;
+
+public_internal:
+	void ProfilerStart(const char* name, uint32_t category);
+
+private:
+	ThreadProfile* GetThreadProfile();
+
 private:
-	ProfilerSample mSamples[MAX_PROFILERS];
+	struct ProfileEvent
+	{
+		const char* Name;
+		uint64_t StartTime;
+		uint64_t EndTime;
+		uint32_t CallStackDepth;
+		uint32_t Category;
+	};
+
+	struct FrameRecord
+	{
+		uint64_t StartTime;
+		uint64_t EndTime;
+
+		// Thread index and event
+		vector<std::pair<uint32_t, ProfileEvent> > Events;
+	};
 
-	size_t mLastOpenedSample;
+	struct SampleRecord
+	{
+		const char* Name;
+		uint32_t ThreadIndex;
+		uint32_t CallStackDepth;
+
+		uint64_t FrameTime;
+		uint64_t FrameSelfTime;
+		uint32_t FrameCalls;
+
+		uint64_t HistoryTime[NumHistoryFrames];
+		uint64_t HistorySelfTime[NumHistoryFrames];
+		uint32_t HistoryCalls[NumHistoryFrames];
+	};
 
-	uint32_t mCurrNumSamples;
-	uint32_t mCallStackDepth;
+	friend struct ThreadProfile;
 
+	static std::atomic<bool> msEnabled;
+
+	mutable std::mutex mThreadsMutex;
+	vector<ThreadProfile*> mThreads;
+
+	FrameRecord mFrames[NumHistoryFrames];
+	uint32_t mNumFrames;
 	uint64_t mFrameBeginTime;
-	uint64_t mFrameEndTime;
 
-	volatile uint32_t mCurrFrame;		// Global frame counter
+	vector<SampleRecord> mSamples;
+	std::map<std::pair<uint32_t, const char*>, uint32_t> mSampleIndices;
 
-	friend struct CpuAutoProfiler;
-	friend struct GpuAutoProfiler;
+	// Per event of current frame, avoid per frame allocation
+	vector<uint32_t> mEventSamples;
+	vector<uint64_t> mEventChildTimes;
 };
 
 struct _ApiExport CpuAutoProfiler
 {
 	CpuAutoProfiler(const char* name);
 	~CpuAutoProfiler();
+
+	bool Active;
 };
 
+/**
+ * Measures CPU time spent submitting GPU work, reported in "gpu" category. Actual GPU
+ * execution time needs timestamp queries which RenderDevice doesn't expose yet.
+ */
 struct _ApiExport GpuAutoProfiler
 {
 	GpuAutoProfiler(const char* name);
 	~GpuAutoProfiler();
+
+	bool Active;
 };
 
-#define ENGINE_CPU_AUTO_PROFIER(name) CpuAutoProfiler _cpu_profiler(name);
-#define ENGINE_PUSH_CPU_PROFIER(name) ProfilerManager::GetSingleton().ProfilerStart(name)
-#define ENGINE_POP_CPU_PROFIER(name)  ProfilerManager::GetSingleton().ProfilerEnd()
-#define ENGINE_DUMP_PROFILERS()		  ProfilerManager::GetSingleton().Output()
+#ifndef ENGINE_DISABLE_PROFILER
+	#define ENGINE_CPU_AUTO_PROFIER(name) CpuAutoProfiler _cpu_profiler(name);
+	#define ENGINE_GPU_AUTO_PROFIER(name) GpuAutoProfiler _gpu_profiler(name);
+	#define ENGINE_PUSH_CPU_PROFIER(name) if (ProfilerManager::IsEnabled()) ProfilerManager::GetSingleton().ProfilerStart(name)
+	#define ENGINE_POP_CPU_PROFIER(name)  if (ProfilerManager::IsEnabled()) ProfilerManager::GetSingleton().ProfilerEnd()
+	#define ENGINE_DUMP_PROFILERS()		  ProfilerManager::GetSingleton().Output()
+#else
+	#define ENGINE_CPU_AUTO_PROFIER(name)
+	#define ENGINE_GPU_AUTO_PROFIER(name)
+	#define ENGINE_PUSH_CPU_PROFIER(name)
+	#define ENGINE_POP_CPU_PROFIER(name)
+	#define ENGINE_DUMP_PROFILERS()
+#endif
+
 }
 
 
@@ -1,18 +1,60 @@
 #include <Core/Timer.h>
-#include <windows.h>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
 
 namespace RcEngine {
 
-double SystemClock::SecondsPerCount;
-int64_t SystemClock::StartTime;
+namespace {
 
-void SystemClock::InitClock()
+#ifdef _WIN32
+
+int64_t ReadCounter()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+double GetSecondsPerCount()
 {
 	LARGE_INTEGER frequency;
 	QueryPerformanceFrequency(&frequency);
-	SecondsPerCount = 1.0 / double(frequency.QuadPart);
+	return 1.0 / double(frequency.QuadPart);
+}
+
+#else
+
+// Monotonic clock in nanoseconds
+int64_t ReadCounter()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+double GetSecondsPerCount()
+{
+	return 1e-9;
+}
+
+#endif
+
+}
+
+double SystemClock::SecondsPerCount;
+int64_t SystemClock::StartTime;
 
-	QueryPerformanceCounter((LARGE_INTEGER*)&StartTime);
+void SystemClock::InitClock()
+{
+	SecondsPerCount = GetSecondsPerCount();
+	StartTime = ReadCounter();
 }
 
 void SystemClock::ShutClock()
@@ -22,9 +64,7 @@ void SystemClock::ShutClock()
 
 uint64_t SystemClock::Now()
 {
-	int64_t now; 
-	QueryPerformanceCounter((LARGE_INTEGER*)&now);
-	return uint64_t(now - StartTime);
+	return uint64_t(ReadCounter() - StartTime);
 }
 
 
@@ -58,9 +98,7 @@ Timer::Timer()
 	: mSecondsPerCount(0.0), mDeltaTime(-1.0), mBaseTime(0),
 	mPausedTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
 {
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	mSecondsPerCount = 1.0 / (double)countsPerSec;
+	mSecondsPerCount = GetSecondsPerCount();
 }
 
 
@@ -92,9 +130,7 @@ void Timer::Tick()
 	}
 
 	// Get Time this frame
-	__int64 currentTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
-	mCurrTime = currentTime;
+	mCurrTime = ReadCounter();
 
 	// Times difference between this and previous frame
 	mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
@@ -113,8 +149,7 @@ void Timer::Tick()
 
 void Timer::Reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	int64_t currTime = ReadCounter();
 
 	mBaseTime = currTime;
 	mPrevTime = currTime;
@@ -126,8 +161,7 @@ void Timer::Stop()
 {
 	if(!mStopped)
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+		int64_t currTime = ReadCounter();
 
 		mStopTime = currTime;
 		mStopped = true;
@@ -136,8 +170,7 @@ void Timer::Stop()
 
 void Timer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	int64_t startTime = ReadCounter();
 
 	if(mStopped)
 	{
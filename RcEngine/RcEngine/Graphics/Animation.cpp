@@ -8,17 +8,57 @@
 #include <IO/FileStream.h>
 #include <Core/Environment.h>
 #include <Core/Exception.h>
+#include <Math/MathUtil.h>
 
 namespace RcEngine {
 
+static inline bool IsStateActive( const AnimationState* state )
+{
+	return state->IsEnabled() && state->IsClipStateBitSet(AnimationState::Clip_Is_Playing_Bit) && state->BlendWeight > 0.0f;
+}
+
+void AnimationPose::Resize( uint32_t numTargets )
+{
+	Translations.resize(numTargets);
+	Rotations.resize(numTargets);
+	Scales.resize(numTargets);
+}
+
+//////////////////////////////////////////////////////////////////////////
 AnimationPlayer::AnimationPlayer( )
-	: mCurrentClipState(nullptr)
+	: mCurrentClipState(nullptr),
+	  mNumSkinMatrices(0),
+	  mSkinPaletteOffset(0),
+	  mPoseDirty(false),
+	  mVisibilityTracked(false),
+	  mVisibleFrame(UINT32_MAX),
+	  mVisibleScreenSize(0.0f),
+	  mVisibleDistance(0.0f),
+	  mLodBias(0),
+	  mLodLevel(0),
+	  mNumActiveStates(0),
+	  mUpdateInterval(1),
+	  mSkipTargetHeight(0),
+	  mInterpolatePoses(false),
+	  mFrozen(false),
+	  mFramesSinceEvaluation(0),
+	  mEvaluated(false),
+	  mHasPrevPose(false)
 {
 	mController = Environment::GetSingleton().GetSceneManager()->GetAnimationController();
+	mController->AddPlayer(this);
+
+	// Spread reduced rate evaluation of players over frames
+	mLodPhase = mController->mPlayers.size();
 }
 
 AnimationPlayer::~AnimationPlayer()
 {
+	mController->RemovePlayer(this);
+
+	for (AnimationState* state : mStateList)
+		mController->Unschedule(state);
+
 	for (auto iter = mAnimationStates.begin(); iter != mAnimationStates.end(); ++iter)
 		delete iter->second;
 
@@ -46,10 +86,333 @@ AnimationState* AnimationPlayer::AddClip( const shared_ptr<AnimationClip>& clip
 
 	AnimationState* newClipState = new AnimationState(*this, clip);
 	mAnimationStates.insert( std::make_pair(clip->GetClipName(),  newClipState) );
+	mStateList.push_back(newClipState);
 
 	return newClipState;
 }
 
+int32_t AnimationPlayer::GetTargetIndex( const String& name ) const
+{
+	unordered_map<String, uint32_t>::const_iterator found = mTargetIndices.find(name);
+	if (found == mTargetIndices.end())
+		return -1;
+
+	return (int32_t)found->second;
+}
+
+void AnimationPlayer::AddTarget( Bone* bone )
+{
+	mTargetIndices.insert( std::make_pair(bone->GetName(), (uint32_t)mAnimateTargets.size()) );
+	mAnimateTargets.push_back(bone);
+}
+
+void AnimationPlayer::BuildTargets()
+{
+	uint32_t numTargets = mAnimateTargets.size();
+
+	mTargetParents.assign(numTargets, -1);
+	vector<uint32_t> depths(numTargets, 0);
+
+	for (uint32_t i = 0; i < numTargets; ++i)
+	{
+		Node* parent = mAnimateTargets[i]->GetParent();
+		if (parent)
+			mTargetParents[i] = GetTargetIndex(parent->GetName());
+
+		for (Node* node = parent; node; node = node->GetParent())
+			depths[i]++;
+	}
+
+	mTargetOrder.resize(numTargets);
+	for (uint32_t i = 0; i < numTargets; ++i)
+		mTargetOrder[i] = i;
+
+	std::stable_sort(mTargetOrder.begin(), mTargetOrder.end(),
+		[&depths](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+
+	mBindPose.Resize(numTargets);
+	for (uint32_t i = 0; i < numTargets; ++i)
+	{
+		mBindPose.Translations[i] = mAnimateTargets[i]->GetPosition();
+		mBindPose.Rotations[i] = mAnimateTargets[i]->GetRotation();
+		mBindPose.Scales[i] = mAnimateTargets[i]->GetScale();
+	}
+
+	mPose = mBindPose;
+	mLayerPose.Resize(numTargets);
+	mLayerWeights.resize(numTargets);
+	mModelTransforms.resize(numTargets);
+
+	// Bind pose is written on first update
+	mPoseDirty = true;
+
+	mNumChildTargets.assign(numTargets, 0);
+	for (uint32_t i = 0; i < numTargets; ++i)
+	{
+		if (mTargetParents[i] >= 0)
+			mNumChildTargets[mTargetParents[i]]++;
+	}
+
+	// Children come after parents in target order
+	mTargetHeights.assign(numTargets, 0);
+	for (auto iter = mTargetOrder.rbegin(); iter != mTargetOrder.rend(); ++iter)
+	{
+		int32_t parent = mTargetParents[*iter];
+		if (parent >= 0)
+			mTargetHeights[parent] = (std::max)(mTargetHeights[parent], mTargetHeights[*iter] + 1);
+	}
+
+	uint32_t maxHeight = numTargets ? *std::max_element(mTargetHeights.begin(), mTargetHeights.end()) : 0;
+	mNumTargetsOfHeight.assign(maxHeight + 2, 0);
+	for (uint32_t height : mTargetHeights)
+		mNumTargetsOfHeight[height]++;
+	for (uint32_t height = maxHeight; height > 0; --height)
+		mNumTargetsOfHeight[height-1] += mNumTargetsOfHeight[height];
+}
+
+bool AnimationPlayer::Update()
+{
+	if (mAnimateTargets.empty())
+		return false;
+
+	mActiveStates.clear();
+	for (AnimationState* state : mStateList)
+	{
+		if (IsStateActive(state))
+			mActiveStates.push_back(state);
+	}
+
+	if (mActiveStates.empty() && !mPoseDirty)
+		return false;
+
+	if (mFrozen)
+	{
+		// Clips keep advancing, pose is evaluated as soon as visible again
+		mPoseDirty = true;
+		mHasPrevPose = false;
+		mFramesSinceEvaluation = mUpdateInterval;
+		return false;
+	}
+
+	mFramesSinceEvaluation++;
+	if (mEvaluated && mFramesSinceEvaluation < mUpdateInterval)
+	{
+		if (!mInterpolatePoses || !mHasPrevPose)
+			return false;
+
+		float t = float(mFramesSinceEvaluation + 1) / float(mUpdateInterval);
+		BlendPoses(t);
+		WritePose(mBlendedPose);
+
+		mPoseDirty = !mActiveStates.empty() || mFramesSinceEvaluation + 1 < mUpdateInterval;
+		return true;
+	}
+
+	bool interpolate = mInterpolatePoses && mUpdateInterval > 1;
+	if (interpolate)
+	{
+		mHasPrevPose = mEvaluated;
+		mPrevPose = mPose;
+	}
+
+	std::stable_sort(mActiveStates.begin(), mActiveStates.end(),
+		[](const AnimationState* a, const AnimationState* b) { return a->GetLayer() < b->GetLayer(); });
+
+	if (mSkipTargetHeight == 0)
+	{
+		mPose = mBindPose;
+	}
+	else
+	{
+		for (uint32_t i = 0; i < mAnimateTargets.size(); ++i)
+		{
+			if (IsTargetSkipped(i))
+				continue;
+
+			mPose.Translations[i] = mBindPose.Translations[i];
+			mPose.Rotations[i] = mBindPose.Rotations[i];
+			mPose.Scales[i] = mBindPose.Scales[i];
+		}
+	}
+	
+	uint32_t layerBegin = 0;
+	while (layerBegin < mActiveStates.size())
+	{
+		uint32_t layerEnd = layerBegin + 1;
+		while (layerEnd < mActiveStates.size() && mActiveStates[layerEnd]->GetLayer() == mActiveStates[layerBegin]->GetLayer())
+			layerEnd++;
+
+		BlendLayer(layerBegin, layerEnd);
+		layerBegin = layerEnd;
+	}
+
+	mFramesSinceEvaluation = 0;
+	mEvaluated = true;
+
+	if (interpolate && mHasPrevPose)
+	{
+		BlendPoses(1.0f / float(mUpdateInterval));
+		WritePose(mBlendedPose);
+		mPoseDirty = true;
+	}
+	else
+	{
+		WritePose(mPose);
+		mPoseDirty = !mActiveStates.empty();
+	}
+
+	return true;
+}
+
+void AnimationPlayer::BlendLayer( uint32_t stateBegin, uint32_t stateEnd )
+{
+	uint32_t numTargets = mAnimateTargets.size();
+
+	std::fill(mLayerPose.Translations.begin(), mLayerPose.Translations.end(), float3(0, 0, 0));
+	std::fill(mLayerPose.Rotations.begin(), mLayerPose.Rotations.end(), Quaternionf(0, 0, 0, 0));
+	std::fill(mLayerPose.Scales.begin(), mLayerPose.Scales.end(), float3(0, 0, 0));
+	std::fill(mLayerWeights.begin(), mLayerWeights.end(), 0.0f);
+
+	bool hasAdditive = false;
+	for (uint32_t i = stateBegin; i < stateEnd; ++i)
+	{
+		if (mActiveStates[i]->Additive)
+			hasAdditive = true;
+		else
+			mActiveStates[i]->SampleWeighted(mLayerPose, mLayerWeights, mPose);
+	}
+
+	for (uint32_t i = 0; i < numTargets; ++i)
+	{
+		float weight = mLayerWeights[i];
+		if (weight <= 0.0f)
+			continue;
+
+		float3 translation = mLayerPose.Translations[i] / weight;
+		Quaternionf rotation = QuaternionNormalize(mLayerPose.Rotations[i]);
+		float3 scale = mLayerPose.Scales[i] / weight;
+
+		if (weight >= 1.0f)
+		{
+			mPose.Translations[i] = translation;
+			mPose.Rotations[i] = rotation;
+			mPose.Scales[i] = scale;
+		}
+		else
+		{
+			mPose.Translations[i] = Lerp(mPose.Translations[i], translation, weight);
+			mPose.Rotations[i] = QuaternionSlerp(mPose.Rotations[i], rotation, weight);
+			mPose.Scales[i] = Lerp(mPose.Scales[i], scale, weight);
+		}
+	}
+
+	if (hasAdditive)
+	{
+		for (uint32_t i = stateBegin; i < stateEnd; ++i)
+		{
+			if (mActiveStates[i]->Additive)
+				mActiveStates[i]->SampleAdditive(mPose);
+		}
+	}
+}
+
+void AnimationPlayer::BlendPoses( float t )
+{
+	uint32_t numTargets = mAnimateTargets.size();
+	mBlendedPose.Resize(numTargets);
+
+	for (uint32_t i = 0; i < numTargets; ++i)
+	{
+		mBlendedPose.Translations[i] = Lerp(mPrevPose.Translations[i], mPose.Translations[i], t);
+		mBlendedPose.Rotations[i] = QuaternionSlerp(mPrevPose.Rotations[i], mPose.Rotations[i], t);
+		mBlendedPose.Scales[i] = Lerp(mPrevPose.Scales[i], mPose.Scales[i], t);
+	}
+}
+
+void AnimationPlayer::WritePose( const AnimationPose& pose )
+{
+	for (uint32_t i : mTargetOrder)
+	{
+		float4x4 localTransform = CreateTransformMatrix(pose.Scales[i], pose.Rotations[i], pose.Translations[i]);
+
+		int32_t parent = mTargetParents[i];
+		mModelTransforms[i] = (parent < 0) ? localTransform : localTransform * mModelTransforms[parent];
+
+		mAnimateTargets[i]->SetAnimatedTransform(pose.Translations[i], pose.Rotations[i], pose.Scales[i], mModelTransforms[i]);
+	}
+}
+
+void AnimationPlayer::NotifyVisible( float screenSize, float distance )
+{
+	uint32_t frame = mController->GetFrameNumber();
+	if (mVisibleFrame != frame)
+	{
+		mVisibleFrame = frame;
+		mVisibleScreenSize = screenSize;
+		mVisibleDistance = distance;
+	}
+	else
+	{
+		mVisibleScreenSize = (std::max)(mVisibleScreenSize, screenSize);
+		mVisibleDistance = (std::min)(mVisibleDistance, distance);
+	}
+}
+
+uint32_t AnimationPlayer::CountActiveStates() const
+{
+	uint32_t numActive = 0;
+	for (AnimationState* state : mStateList)
+	{
+		if (IsStateActive(state))
+			numActive++;
+	}
+	return numActive;
+}
+
+uint32_t AnimationPlayer::GetEvaluationCost( const AnimationLodLevel& lod ) const
+{
+	if (mNumTargetsOfHeight.empty())
+		return 0;
+
+	uint32_t height = (std::min)(lod.SkipBoneHeight, (uint32_t)mNumTargetsOfHeight.size() - 1);
+	uint32_t interval = (std::max)(lod.UpdateInterval, 1U);
+
+	return (mNumActiveStates * mNumTargetsOfHeight[height] + interval - 1) / interval;
+}
+
+void AnimationPlayer::SetLod( uint32_t level, const AnimationLodLevel& lod, bool interpolatePoses )
+{
+	uint32_t interval = (std::max)(lod.UpdateInterval, 1U);
+	if (interval != mUpdateInterval)
+	{
+		mUpdateInterval = interval;
+		mFramesSinceEvaluation = mLodPhase % interval;
+	}
+
+	mLodLevel = level;
+	mSkipTargetHeight = lod.SkipBoneHeight;
+	mInterpolatePoses = interpolatePoses;
+}
+
+void AnimationPlayer::DirtyAttachedNodes()
+{
+	for (uint32_t i = 0; i < mAnimateTargets.size(); ++i)
+	{
+		// Any other child is an attached scene node
+		if (mAnimateTargets[i]->GetChildren().size() > mNumChildTargets[i])
+			mAnimateTargets[i]->DirtyAttachedNodes();
+	}
+}
+
+const float4x4* AnimationPlayer::GetSkinMatrices() const
+{
+	// Range is allocated on creation, offset only changes in AnimationController::Update
+	if (!mNumSkinMatrices)
+		return nullptr;
+
+	return mController->GetSkinPalette() + mSkinPaletteOffset;
+}
+
 void AnimationPlayer::StopAll()
 {
 	for (auto& kv : mAnimationStates)
@@ -95,11 +458,18 @@ SkinnedAnimationPlayer::SkinnedAnimationPlayer( const shared_ptr<Skeleton>& skel
 {
 	assert(skeleton != nullptr);
 
+	// Target index is bone index
 	for (uint32_t i = 0; i < skeleton->GetNumBones(); ++i)
-	{
-		Bone* bone = skeleton->GetBone(i);
-		mAnimateTargets.insert( std::make_pair(bone->GetName(), bone));
-	}
+		AddTarget(skeleton->GetBone(i));
+
+	BuildTargets();
+
+	mOffsetMatrices.resize(skeleton->GetNumBones());
+	for (uint32_t i = 0; i < skeleton->GetNumBones(); ++i)
+		mOffsetMatrices[i] = skeleton->GetBone(i)->GetOffsetMatrix();
+
+	mNumSkinMatrices = skeleton->GetNumBones();
+	mController->AllocateSkinMatrices(this);
 }
 
 SkinnedAnimationPlayer::~SkinnedAnimationPlayer()
@@ -107,6 +477,12 @@ SkinnedAnimationPlayer::~SkinnedAnimationPlayer()
 
 }
 
+void SkinnedAnimationPlayer::UpdateSkinMatrices( float4x4* skinMatrices )
+{
+	for (uint32_t i = 0; i < mNumSkinMatrices; ++i)
+		skinMatrices[i] = mOffsetMatrices[i] * mModelTransforms[i];
+}
+
 
 }
 
@@ -2,19 +2,49 @@
 #define Animation_h__
 
 #include <Core/Prerequisites.h>
+#include <Math/Vector.h>
+#include <Math/Quaternion.h>
+#include <Math/Matrix.h>
 
 namespace RcEngine {
 
 class Bone;
 class Skeleton;
+struct AnimationLodLevel;
 
+/**
+ * Local transforms of animation targets, indexed by target.
+ */
+struct _ApiExport AnimationPose
+{
+	vector<float3> Translations;
+	vector<Quaternionf> Rotations;
+	vector<float3> Scales;
+
+	void Resize(uint32_t numTargets);
+};
+
+/**
+ * Plays animation clips on a set of targets. Each frame, playing clips are sampled into a
+ * pose buffer and blended layer by layer starting from the bind pose:
+ *
+ * Clips of a layer are blended by weight. If weights of a layer add up to more than one
+ * they are normalized, otherwise the layer is blended over lower layers by its total
+ * weight, per target, so a layer only animating some bones leaves the others alone.
+ * Additive clips add their difference to their first frame on top of the layer result.
+ *
+ * The final pose is written to the targets once and model space transforms are computed
+ * in one pass over the target parent indices. The result only depends on clip weights and
+ * layers, not on the order clips were added or applied.
+ */
 class _ApiExport AnimationPlayer
 {
 	friend class AnimationState;
+	friend class AnimationController;
 
 public:
 	AnimationPlayer();
-	~AnimationPlayer();
+	virtual ~AnimationPlayer();
 
 	bool IsPlaying(const String& clipName) const;
 
@@ -31,12 +61,96 @@ public:
 
 	AnimationController* GetAnimationController() const { return mController; }
 
+	/**
+	 * Blend playing clips and update targets, called by AnimationController once per frame,
+	 * possibly on a worker thread. Return false if the pose didn't change.
+	 */
+	bool Update();
+
+	uint32_t GetNumTargets() const								{ return mAnimateTargets.size(); }
+
+	/**
+	 * Model space transform of each target after last Update.
+	 */
+	const vector<float4x4>& GetModelTransforms() const			{ return mModelTransforms; }
+
+	/**
+	 * Skin matrices in AnimationController's palette, null if the player doesn't skin. Bind
+	 * pose until the player is updated. Valid until next AnimationController::Update or
+	 * until another skinned player is created.
+	 */
+	const float4x4* GetSkinMatrices() const;
+	uint32_t GetNumSkinMatrices() const							{ return mNumSkinMatrices; }
+
+	/**
+	 * Players tracking visibility get a level of detail from their screen size or distance,
+	 * and can be frozen while not visible, see AnimationLodSettings. Entity tracks the
+	 * visibility of its player.
+	 */
+	void SetVisibilityTracked(bool tracked)						{ mVisibilityTracked = tracked; }
+	bool IsVisibilityTracked() const							{ return mVisibilityTracked; }
+
+	/**
+	 * Report the player's owner was queued for rendering this frame, the largest screen
+	 * size and nearest distance of the frame pick the level of detail of next update.
+	 */
+	void NotifyVisible(float screenSize, float distance);
+
+	/**
+	 * Levels added to the one picked by screen size or distance, the evaluation budget
+	 * may raise it further.
+	 */
+	void SetLodBias(int32_t bias)								{ mLodBias = bias; }
+	int32_t GetLodBias() const									{ return mLodBias; }
+
+	uint32_t GetLodLevel() const								{ return mLodLevel; }
+	bool IsFrozen() const										{ return mFrozen; }
+
 public:
 	static shared_ptr<AnimationPlayer> LoadFrom(Mesh& parentMesh, Stream& source);
 
 	// Events
 	EventHandler EventAnimationCompleted;
 
+protected:
+	/**
+	 * Index of the animated bone with name, -1 if not found. Tracks are bound to target
+	 * indices once, when a clip is added.
+	 */
+	int32_t GetTargetIndex(const String& name) const;
+
+	void AddTarget(Bone* bone);
+
+	/**
+	 * Resolve target parents and bind pose once all targets are added.
+	 */
+	void BuildTargets();
+
+	void BlendLayer(uint32_t stateBegin, uint32_t stateEnd);
+	void BlendPoses(float t);
+	void WritePose(const AnimationPose& pose);
+
+	/**
+	 * Targets skipped at current level of detail keep their last sampled transform.
+	 */
+	bool IsTargetSkipped(uint32_t target) const					{ return mTargetHeights[target] < mSkipTargetHeight; }
+
+	uint32_t CountActiveStates() const;
+
+	/**
+	 * Bone tracks sampled per frame at level, averaged over its update interval.
+	 */
+	uint32_t GetEvaluationCost(const AnimationLodLevel& lod) const;
+
+	void SetLod(uint32_t level, const AnimationLodLevel& lod, bool interpolatePoses);
+
+	virtual void UpdateSkinMatrices(float4x4* skinMatrices) { }
+
+	/**
+	 * Mark scene nodes attached to targets dirty after Update, main thread only.
+	 */
+	void DirtyAttachedNodes();
+
 protected:
 
 	AnimationController* mController; 
@@ -45,7 +159,63 @@ protected:
 
 	unordered_map<String, AnimationState*> mAnimationStates;
 
-	unordered_map<String, Bone*> mAnimateTargets;
+	// States in the order they were added, blending never depends on hash order
+	vector<AnimationState*> mStateList;
+	vector<AnimationState*> mActiveStates;
+
+	vector<Bone*> mAnimateTargets;
+	unordered_map<String, uint32_t> mTargetIndices;
+
+	// Parent target index, -1 for roots, and an order with parents before children
+	vector<int32_t> mTargetParents;
+	vector<uint32_t> mTargetOrder;
+
+	AnimationPose mBindPose;
+	AnimationPose mPose;
+
+	// Weighted sum of the layer being blended, and total weight per target
+	AnimationPose mLayerPose;
+	vector<float> mLayerWeights;
+
+	vector<float4x4> mModelTransforms;
+
+	// Number of child targets of each target, other children are attached scene nodes
+	vector<uint32_t> mNumChildTargets;
+
+	// Levels of targets below each target, 0 for leaves, and number of targets of at
+	// least each height
+	vector<uint32_t> mTargetHeights;
+	vector<uint32_t> mNumTargetsOfHeight;
+
+	// Visibility reported for AnimationController frame
+	bool mVisibilityTracked;
+	uint32_t mVisibleFrame;
+	float mVisibleScreenSize;
+	float mVisibleDistance;
+
+	// Level of detail picked by AnimationController
+	int32_t mLodBias;
+	uint32_t mLodLevel;
+	uint32_t mLodPhase;
+	uint32_t mNumActiveStates;
+	uint32_t mUpdateInterval;
+	uint32_t mSkipTargetHeight;
+	bool mInterpolatePoses;
+	bool mFrozen;
+
+	// Reduced rate evaluation, output pose blends from previous to last evaluated pose
+	uint32_t mFramesSinceEvaluation;
+	bool mEvaluated;
+	bool mHasPrevPose;
+	AnimationPose mPrevPose;
+	AnimationPose mBlendedPose;
+
+	// Range in AnimationController's skin palette
+	uint32_t mNumSkinMatrices;
+	uint32_t mSkinPaletteOffset;
+
+	// Targets need to be written, set when clips played last frame
+	bool mPoseDirty;
 };
 
 
@@ -57,8 +227,11 @@ public:
 
 	void CrossFade( const String& fadeClip, float fadeLength );
 
+protected:
+	void UpdateSkinMatrices(float4x4* skinMatrices) override;
+
 private:
-	
+	vector<float4x4> mOffsetMatrices;
 };
 
 }
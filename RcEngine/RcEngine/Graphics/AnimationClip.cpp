@@ -2,6 +2,7 @@
 #include <Graphics/AnimationState.h>
 #include <Graphics/Animation.h>
 #include <Graphics/AnimationController.h>
+#include <Math/MathUtil.h>
 #include <Core/Exception.h>
 #include <IO/FileSystem.h>
 #include <IO/FileStream.h>
@@ -11,20 +12,191 @@
 namespace RcEngine {
 
 
-int32_t AnimationClip::AnimationTrack::GetKeyFrameIndex( float time ) const
-{
-	//if (time < 0) time = 0;
-	int32_t index = 0;
-	while (index < (int32_t)KeyFrames.size() && KeyFrames[index].Time < time)
-		index ++;
+namespace {
 
+int32_t FindKeyFrame( const float* keyTimes, int32_t numKeys, float time )
+{
+	int32_t index = int32_t(std::lower_bound(keyTimes, keyTimes + numKeys, time) - keyTimes);
 	return (std::max)(0, index-1);
 }
 
+int32_t FindKeyFrame( const float* keyTimes, int32_t numKeys, float time, uint32_t& cursor )
+{
+	// Keys probed around the cursor before falling back to binary search
+	const int32_t MaxProbes = 4;
+
+	assert(numKeys > 0);
+	if (numKeys == 1)
+		return 0;
+
+	int32_t index = (std::min)((int32_t)cursor, numKeys - 1);
+	if (index == 0 || keyTimes[index] < time)
+	{
+		if (keyTimes[numKeys-1] < time)
+		{
+			// Past the last key, also where reverse looping playback wraps to
+			index = numKeys - 1;
+		}
+		else
+		{
+			int32_t probe = 0;
+			while (probe++ < MaxProbes && keyTimes[index+1] < time)
+				index++;
+
+			if (keyTimes[index+1] < time)
+				index = FindKeyFrame(keyTimes, numKeys, time);
+		}
+	}
+	else
+	{
+		if (keyTimes[1] >= time)
+		{
+			// Before the second key, also where forward looping playback wraps to
+			index = 0;
+		}
+		else
+		{
+			int32_t probe = 0;
+			while (probe++ < MaxProbes && keyTimes[index] >= time)
+				index--;
+
+			if (keyTimes[index] >= time)
+				index = FindKeyFrame(keyTimes, numKeys, time);
+		}
+	}
+
+	cursor = (uint32_t)index;
+	return index;
+}
+
+enum ConstantChannel
+{
+	CC_Translation = 1,
+	CC_Rotation = 2,
+	CC_Scale = 4
+};
+
+// Compressed clip files start with this instead of duration, as a float it is far too long
+const uint32_t CompressedClipMagic = 0x5A4D4E41;   // "ANMZ"
+const uint32_t CompressedClipVersion = 1;
+
+template<typename T>
+void ReadArray( Stream& source, vector<T>& values )
+{
+	values.resize(source.ReadUInt());
+	if (values.size())
+		source.Read(&values[0], values.size() * sizeof(T));
+}
+
+template<typename T>
+void WriteArray( Stream& stream, const vector<T>& values )
+{
+	stream.WriteUInt(values.size());
+	if (values.size())
+		stream.Write(&values[0], values.size() * sizeof(T));
+}
+
+// Largest absolute component of a unit quaternion is dropped, others are in [-1/sqrt2, 1/sqrt2]
+const float SmallestThreeRange = 0.70710678f;
+
+void PackQuaternion( const Quaternionf& quat, uint16_t* packed )
+{
+	Quaternionf q = QuaternionNormalize(quat);
+
+	int32_t largest = 0;
+	for (int32_t i = 1; i < 4; ++i)
+	{
+		if (fabsf(q[i]) > fabsf(q[largest]))
+			largest = i;
+	}
+
+	// q and -q are the same rotation, make dropped component positive
+	float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+	// 15 bits per component, index of the dropped component in the high bits of the first two
+	for (int32_t i = 0, j = 0; i < 4; ++i)
+	{
+		if (i == largest)
+			continue;
+
+		float value = Clamp(q[i] * sign / SmallestThreeRange, -1.0f, 1.0f);
+		packed[j++] = uint16_t((value * 0.5f + 0.5f) * 32767.0f + 0.5f);
+	}
+
+	packed[0] |= uint16_t((largest & 1) << 15);
+	packed[1] |= uint16_t((largest >> 1) << 15);
+}
+
+Quaternionf UnpackQuaternion( const uint16_t* packed )
+{
+	int32_t largest = (packed[0] >> 15) | ((packed[1] >> 15) << 1);
+
+	Quaternionf q;
+	float sum = 0.0f;
+	for (int32_t i = 0, j = 0; i < 4; ++i)
+	{
+		if (i == largest)
+			continue;
+
+		float value = ((packed[j++] & 0x7FFF) * (2.0f / 32767.0f) - 1.0f) * SmallestThreeRange;
+		q[i] = value;
+		sum += value * value;
+	}
+
+	q[largest] = sqrtf((std::max)(0.0f, 1.0f - sum));
+	return q;
+}
+
+void PackVector( const float3& value, const float3& min, const float3& step, uint16_t* packed )
+{
+	for (int32_t i = 0; i < 3; ++i)
+	{
+		float quantized = step[i] > 0.0f ? (value[i] - min[i]) / step[i] : 0.0f;
+		packed[i] = uint16_t(Clamp(quantized + 0.5f, 0.0f, 65535.0f));
+	}
+}
+
+inline float3 UnpackVector( const uint16_t* packed, const float3& min, const float3& step )
+{
+	return float3(min[0] + packed[0] * step[0], min[1] + packed[1] * step[1], min[2] + packed[2] * step[2]);
+}
+
+inline float RotationError( const Quaternionf& a, const Quaternionf& b )
+{
+	// Angle from chord length, acos of the dot product is off by about 1e-3 radians near zero
+	float sign = QuaternionDot(a, b) < 0.0f ? -1.0f : 1.0f;
+
+	float chord = 0.0f;
+	for (int32_t i = 0; i < 4; ++i)
+		chord += (a[i] - sign * b[i]) * (a[i] - sign * b[i]);
+
+	return 4.0f * asinf((std::min)(sqrtf(chord) * 0.5f, 1.0f));
+}
+
+inline float ScaleError( const float3& a, const float3& b )
+{
+	return (std::max)((std::max)(fabsf(a[0] - b[0]), fabsf(a[1] - b[1])), fabsf(a[2] - b[2]));
+}
+
+}
+
+AnimationClip::CompressionSettings AnimationClip::msLoadCompression;
+
+AnimationClip::CompressionSettings::CompressionSettings()
+	: Enabled(false),
+	  TranslationTolerance(0.001f),
+	  RotationTolerance(0.001f),
+	  ScaleTolerance(0.001f)
+{
+
+}
 
 AnimationClip::AnimationClip(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
-	: Resource(RT_Animation, creator, handle, name, group)
+	: Resource(RT_Animation, creator, handle, name, group),
+	  mTrackVersion(0),
+	  mCompressed(false)
 {
+	memset(&mCompressionReport, 0, sizeof(mCompressionReport));
 
 }
 
@@ -33,6 +205,270 @@ AnimationClip::~AnimationClip()
 	
 }
 
+int32_t AnimationClip::GetKeyFrameIndex( uint32_t track, float time ) const
+{
+	const AnimationTrack& animTrack = mAnimationTracks[track];
+	return FindKeyFrame(&mKeyTimes[animTrack.FirstKey], animTrack.NumKeys, time);
+}
+
+int32_t AnimationClip::GetKeyFrameIndex( uint32_t track, float time, uint32_t& cursor ) const
+{
+	const AnimationTrack& animTrack = mAnimationTracks[track];
+	return FindKeyFrame(&mKeyTimes[animTrack.FirstKey], animTrack.NumKeys, time, cursor);
+}
+
+void AnimationClip::SampleTrack( uint32_t track, float time, bool loop, uint32_t& cursor, float3& translation, Quaternionf& rotation, float3& scale ) const
+{
+	const AnimationTrack& animTrack = mAnimationTracks[track];
+	const float* keyTimes = &mKeyTimes[animTrack.FirstKey];
+
+	int32_t frame = FindKeyFrame(keyTimes, animTrack.NumKeys, time, cursor);
+	int32_t nextFrame = frame + 1;
+
+	if (nextFrame >= (int32_t)animTrack.NumKeys)
+	{
+		if (!loop)
+		{
+			// No interpolation after the last key
+			if (mCompressed)
+			{
+				SampleCompressedTrack(track, frame, frame, 0.0f, translation, rotation, scale);
+				return;
+			}
+
+			translation = mKeyTranslations[animTrack.FirstKey + frame];
+			rotation = mKeyRotations[animTrack.FirstKey + frame];
+			scale = mKeyScales[animTrack.FirstKey + frame];
+			return;
+		}
+
+		nextFrame = 0;
+	}
+
+	float timeInterval = keyTimes[nextFrame] - keyTimes[frame];
+	if (timeInterval < 0.0f)
+		timeInterval += mDuration;
+	float t = timeInterval > 0.0f ? (time - keyTimes[frame]) / timeInterval : 1.0f;
+
+	if (mCompressed)
+	{
+		SampleCompressedTrack(track, frame, nextFrame, t, translation, rotation, scale);
+		return;
+	}
+
+	uint32_t key = animTrack.FirstKey + frame;
+	uint32_t nextKey = animTrack.FirstKey + nextFrame;
+
+	translation = Lerp(mKeyTranslations[key], mKeyTranslations[nextKey], t);
+	rotation = QuaternionSlerp(mKeyRotations[key], mKeyRotations[nextKey], t);
+	scale = Lerp(mKeyScales[key], mKeyScales[nextKey], t);
+}
+
+void AnimationClip::SampleCompressedTrack( uint32_t track, int32_t frame, int32_t nextFrame, float t, float3& translation, Quaternionf& rotation, float3& scale ) const
+{
+	const CompressedTrack& packedTrack = mCompressedTracks[track];
+
+	uint32_t key, nextKey;
+
+	key = nextKey = packedTrack.TranslationOffset;
+	if (!(packedTrack.ConstantChannels & CC_Translation))
+		key += frame, nextKey += nextFrame;
+
+	translation = UnpackVector(&mPackedTranslations[key * 3], packedTrack.TranslationMin, packedTrack.TranslationStep);
+	if (key != nextKey)
+		translation = Lerp(translation, UnpackVector(&mPackedTranslations[nextKey * 3], packedTrack.TranslationMin, packedTrack.TranslationStep), t);
+
+	key = nextKey = packedTrack.RotationOffset;
+	if (!(packedTrack.ConstantChannels & CC_Rotation))
+		key += frame, nextKey += nextFrame;
+
+	rotation = UnpackQuaternion(&mPackedRotations[key * 3]);
+	if (key != nextKey)
+		rotation = QuaternionSlerp(rotation, UnpackQuaternion(&mPackedRotations[nextKey * 3]), t);
+
+	key = nextKey = packedTrack.ScaleOffset;
+	if (!(packedTrack.ConstantChannels & CC_Scale))
+		key += frame, nextKey += nextFrame;
+
+	scale = UnpackVector(&mPackedScales[key * 3], packedTrack.ScaleMin, packedTrack.ScaleStep);
+	if (key != nextKey)
+		scale = Lerp(scale, UnpackVector(&mPackedScales[nextKey * 3], packedTrack.ScaleMin, packedTrack.ScaleStep), t);
+}
+
+void AnimationClip::Compress( const CompressionSettings& settings )
+{
+	// Longest run of keys replaced by interpolation, bounds reduction cost on long clips
+	const uint32_t MaxRemovedRun = 256;
+
+	if (mCompressed)
+		return;
+
+	vector<float> keyTimes;
+	vector<CompressedTrack> packedTracks(mAnimationTracks.size());
+	vector<uint16_t> packedTranslations, packedRotations, packedScales;
+
+	vector<AnimationTrack> rawTracks = mAnimationTracks;
+
+	vector<uint32_t> keptKeys;
+	for (uint32_t track = 0; track < mAnimationTracks.size(); ++track)
+	{
+		AnimationTrack& animTrack = mAnimationTracks[track];
+		CompressedTrack& packedTrack = packedTracks[track];
+
+		const uint32_t first = animTrack.FirstKey;
+		const uint32_t numKeys = animTrack.NumKeys;
+
+		packedTrack.ConstantChannels = CC_Translation | CC_Rotation | CC_Scale;
+		for (uint32_t key = first + 1; key < first + numKeys; ++key)
+		{
+			if (Length(mKeyTranslations[key] - mKeyTranslations[first]) > settings.TranslationTolerance)
+				packedTrack.ConstantChannels &= ~CC_Translation;
+			if (RotationError(mKeyRotations[key], mKeyRotations[first]) > settings.RotationTolerance)
+				packedTrack.ConstantChannels &= ~CC_Rotation;
+			if (ScaleError(mKeyScales[key], mKeyScales[first]) > settings.ScaleTolerance)
+				packedTrack.ConstantChannels &= ~CC_Scale;
+		}
+
+		// Keep first and last key, and every key its neighbors can't interpolate
+		keptKeys.clear();
+		if (numKeys)
+			keptKeys.push_back(first);
+
+		uint32_t start = first;
+		for (uint32_t end = first + 2; end < first + numKeys; ++end)
+		{
+			bool reducible = (end - start - 1 <= MaxRemovedRun);
+			for (uint32_t key = start + 1; key < end && reducible; ++key)
+			{
+				float interval = mKeyTimes[end] - mKeyTimes[start];
+				float t = interval > 0.0f ? (mKeyTimes[key] - mKeyTimes[start]) / interval : 0.0f;
+
+				if (!(packedTrack.ConstantChannels & CC_Translation) &&
+					Length(Lerp(mKeyTranslations[start], mKeyTranslations[end], t) - mKeyTranslations[key]) > settings.TranslationTolerance)
+					reducible = false;
+				else if (!(packedTrack.ConstantChannels & CC_Rotation) &&
+					RotationError(QuaternionSlerp(mKeyRotations[start], mKeyRotations[end], t), mKeyRotations[key]) > settings.RotationTolerance)
+					reducible = false;
+				else if (!(packedTrack.ConstantChannels & CC_Scale) &&
+					ScaleError(Lerp(mKeyScales[start], mKeyScales[end], t), mKeyScales[key]) > settings.ScaleTolerance)
+					reducible = false;
+			}
+
+			if (!reducible)
+			{
+				start = end - 1;
+				keptKeys.push_back(start);
+			}
+		}
+
+		if (numKeys > 1 && packedTrack.ConstantChannels != (CC_Translation | CC_Rotation | CC_Scale))
+			keptKeys.push_back(first + numKeys - 1);
+
+		// Quantization range
+		float3 translationMin(FLT_MAX, FLT_MAX, FLT_MAX), translationMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		float3 scaleMin = translationMin, scaleMax = translationMax;
+		for (uint32_t key : keptKeys)
+		{
+			for (int32_t i = 0; i < 3; ++i)
+			{
+				translationMin[i] = (std::min)(translationMin[i], mKeyTranslations[key][i]);
+				translationMax[i] = (std::max)(translationMax[i], mKeyTranslations[key][i]);
+				scaleMin[i] = (std::min)(scaleMin[i], mKeyScales[key][i]);
+				scaleMax[i] = (std::max)(scaleMax[i], mKeyScales[key][i]);
+			}
+		}
+
+		if (keptKeys.empty())
+			translationMin = translationMax = scaleMin = scaleMax = float3(0, 0, 0);
+
+		packedTrack.TranslationMin = translationMin;
+		packedTrack.TranslationStep = (translationMax - translationMin) / 65535.0f;
+		packedTrack.ScaleMin = scaleMin;
+		packedTrack.ScaleStep = (scaleMax - scaleMin) / 65535.0f;
+
+		packedTrack.TranslationOffset = packedTranslations.size() / 3;
+		packedTrack.RotationOffset = packedRotations.size() / 3;
+		packedTrack.ScaleOffset = packedScales.size() / 3;
+
+		for (size_t i = 0; i < keptKeys.size(); ++i)
+		{
+			uint32_t key = keptKeys[i];
+			uint16_t packed[3];
+
+			if (i == 0 || !(packedTrack.ConstantChannels & CC_Translation))
+			{
+				PackVector(mKeyTranslations[key], packedTrack.TranslationMin, packedTrack.TranslationStep, packed);
+				packedTranslations.insert(packedTranslations.end(), packed, packed + 3);
+			}
+
+			if (i == 0 || !(packedTrack.ConstantChannels & CC_Rotation))
+			{
+				PackQuaternion(mKeyRotations[key], packed);
+				packedRotations.insert(packedRotations.end(), packed, packed + 3);
+			}
+
+			if (i == 0 || !(packedTrack.ConstantChannels & CC_Scale))
+			{
+				PackVector(mKeyScales[key], packedTrack.ScaleMin, packedTrack.ScaleStep, packed);
+				packedScales.insert(packedScales.end(), packed, packed + 3);
+			}
+		}
+
+		animTrack.FirstKey = keyTimes.size();
+		animTrack.NumKeys = keptKeys.size();
+		for (uint32_t key : keptKeys)
+			keyTimes.push_back(mKeyTimes[key]);
+	}
+
+	// Raw keys stay alive until the report is done
+	vector<float> rawKeyTimes;
+	vector<float3> rawTranslations, rawScales;
+	vector<Quaternionf> rawRotations;
+
+	mKeyTimes.swap(rawKeyTimes);
+	mKeyTimes.swap(keyTimes);
+	mKeyTranslations.swap(rawTranslations);
+	mKeyRotations.swap(rawRotations);
+	mKeyScales.swap(rawScales);
+
+	mCompressedTracks.swap(packedTracks);
+	mPackedTranslations.swap(packedTranslations);
+	mPackedRotations.swap(packedRotations);
+	mPackedScales.swap(packedScales);
+	mCompressed = true;
+
+	CompressionReport& report = mCompressionReport;
+	memset(&report, 0, sizeof(report));
+
+	report.NumRawKeys = rawKeyTimes.size();
+	report.NumKeys = mKeyTimes.size();
+	report.RawSize = rawKeyTimes.size() * (sizeof(float) + sizeof(float3) + sizeof(Quaternionf) + sizeof(float3));
+	report.CompressedSize = mKeyTimes.size() * sizeof(float) + mCompressedTracks.size() * sizeof(CompressedTrack) +
+		(mPackedTranslations.size() + mPackedRotations.size() + mPackedScales.size()) * sizeof(uint16_t);
+
+	for (uint32_t track = 0; track < mAnimationTracks.size(); ++track)
+	{
+		uint32_t cursor = 0;
+		for (uint32_t key = rawTracks[track].FirstKey; key < rawTracks[track].FirstKey + rawTracks[track].NumKeys; ++key)
+		{
+			float3 translation, scale;
+			Quaternionf rotation;
+			SampleTrack(track, rawKeyTimes[key], false, cursor, translation, rotation, scale);
+
+			report.MaxTranslationError = (std::max)(report.MaxTranslationError, Length(translation - rawTranslations[key]));
+			report.MaxRotationError = (std::max)(report.MaxRotationError, RotationError(rotation, rawRotations[key]));
+			report.MaxScaleError = (std::max)(report.MaxScaleError, ScaleError(scale, rawScales[key]));
+		}
+	}
+
+	mSize = sizeof(AnimationClip) + mAnimationTracks.size() * sizeof(AnimationTrack) + report.CompressedSize;
+}
+
+void AnimationClip::SetLoadCompression( const CompressionSettings& settings )
+{
+	msLoadCompression = settings;
+}
+
 void AnimationClip::LoadImpl()
 {
 	FileSystem& fileSystem = FileSystem::GetSingleton();
@@ -41,7 +477,22 @@ void AnimationClip::LoadImpl()
 	Stream& source = *clipStream;	
 
 	mClipName = PathUtil::GetFileName(mResourceName);
-	mDuration = source.ReadFloat();
+	mTrackVersion++;
+
+	mKeyTimes.clear();
+	mKeyTranslations.clear();
+	mKeyRotations.clear();
+	mKeyScales.clear();
+	mCompressed = false;
+
+	uint32_t header = source.ReadUInt();
+	if (header == CompressedClipMagic)
+	{
+		LoadCompressed(source);
+		return;
+	}
+
+	memcpy(&mDuration, &header, sizeof(float));
 
 	// read track count
 	uint32_t numTracks = source.ReadUInt();
@@ -49,30 +500,181 @@ void AnimationClip::LoadImpl()
 
 	for (uint32_t track = 0; track < numTracks; ++track)
 	{
-		String trackName = source.ReadString(); 
-
 		AnimationClip::AnimationTrack& animTrack = mAnimationTracks[track];
 
 		// read key frame count
-		animTrack.Name = trackName;
-		size_t numKeyframes = source.ReadUInt();
-		animTrack.KeyFrames.resize(numKeyframes);
+		animTrack.Name = source.ReadString();
+		animTrack.FirstKey = mKeyTimes.size();
+		animTrack.NumKeys = source.ReadUInt();
 
-		for (uint32_t key = 0; key < numKeyframes; ++key)
+		for (uint32_t key = 0; key < animTrack.NumKeys; ++key)
 		{
-			AnimationClip::KeyFrame& animKey = animTrack.KeyFrames[key];
+			float3 translation, scale;
+			Quaternionf rotation;
 
-			animKey.Time = source.ReadFloat();
-			source.Read(&animKey.Translation, sizeof(float3));
-			source.Read(&animKey.Rotation, sizeof(Quaternionf));
-			source.Read(&animKey.Scale, sizeof(float3));
+			float time = source.ReadFloat();
+			source.Read(&translation, sizeof(float3));
+			source.Read(&rotation, sizeof(Quaternionf));
+			source.Read(&scale, sizeof(float3));
+
+			mKeyTimes.push_back(time);
+			mKeyTranslations.push_back(translation);
+			mKeyRotations.push_back(rotation);
+			mKeyScales.push_back(scale);
 		}
 	}
+
+	mSize = sizeof(AnimationClip) + numTracks * sizeof(AnimationTrack);
+	mSize += mKeyTimes.size() * (sizeof(float) + sizeof(float3) + sizeof(Quaternionf) + sizeof(float3));
+
+	if (msLoadCompression.Enabled)
+		Compress(msLoadCompression);
+}
+
+void AnimationClip::LoadCompressed( Stream& source )
+{
+	uint32_t version = source.ReadUInt();
+	if (version != CompressedClipVersion)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, mResourceName + ": unsupported compressed clip version " + std::to_string(version), "AnimationClip::LoadCompressed");
+
+	mDuration = source.ReadFloat();
+
+	CompressionReport& report = mCompressionReport;
+	report.NumRawKeys = source.ReadUInt();
+	report.NumKeys = source.ReadUInt();
+	report.RawSize = source.ReadUInt();
+	report.CompressedSize = source.ReadUInt();
+	report.MaxTranslationError = source.ReadFloat();
+	report.MaxRotationError = source.ReadFloat();
+	report.MaxScaleError = source.ReadFloat();
+
+	uint32_t numTracks = source.ReadUInt();
+	mAnimationTracks.resize(numTracks);
+	mCompressedTracks.resize(numTracks);
+
+	for (uint32_t track = 0; track < numTracks; ++track)
+	{
+		AnimationTrack& animTrack = mAnimationTracks[track];
+		animTrack.Name = source.ReadString();
+		animTrack.FirstKey = source.ReadUInt();
+		animTrack.NumKeys = source.ReadUInt();
+
+		CompressedTrack& packedTrack = mCompressedTracks[track];
+		packedTrack.TranslationOffset = source.ReadUInt();
+		packedTrack.RotationOffset = source.ReadUInt();
+		packedTrack.ScaleOffset = source.ReadUInt();
+		packedTrack.ConstantChannels = source.ReadUInt();
+		source.Read(&packedTrack.TranslationMin, sizeof(float3));
+		source.Read(&packedTrack.TranslationStep, sizeof(float3));
+		source.Read(&packedTrack.ScaleMin, sizeof(float3));
+		source.Read(&packedTrack.ScaleStep, sizeof(float3));
+	}
+
+	ReadArray(source, mKeyTimes);
+	ReadArray(source, mPackedTranslations);
+	ReadArray(source, mPackedRotations);
+	ReadArray(source, mPackedScales);
+
+	// Packed streams are indexed without checks at sample time
+	for (uint32_t track = 0; track < numTracks; ++track)
+	{
+		const AnimationTrack& animTrack = mAnimationTracks[track];
+		const CompressedTrack& packedTrack = mCompressedTracks[track];
+
+		const uint32_t channels[3] = { CC_Translation, CC_Rotation, CC_Scale };
+		uint32_t numChannelKeys[3];
+		for (uint32_t i = 0; i < 3; ++i)
+			numChannelKeys[i] = (packedTrack.ConstantChannels & channels[i]) ? (std::min)(animTrack.NumKeys, 1U) : animTrack.NumKeys;
+
+		if (uint64_t(animTrack.FirstKey) + animTrack.NumKeys > mKeyTimes.size() ||
+			uint64_t(packedTrack.TranslationOffset + numChannelKeys[0]) * 3 > mPackedTranslations.size() ||
+			uint64_t(packedTrack.RotationOffset + numChannelKeys[1]) * 3 > mPackedRotations.size() ||
+			uint64_t(packedTrack.ScaleOffset + numChannelKeys[2]) * 3 > mPackedScales.size())
+		{
+			ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, mResourceName + ": track " + animTrack.Name + " is out of key streams", "AnimationClip::LoadCompressed");
+		}
+	}
+
+	mCompressed = true;
+	mSize = sizeof(AnimationClip) + numTracks * sizeof(AnimationTrack) + report.CompressedSize;
+}
+
+void AnimationClip::Save( Stream& stream ) const
+{
+	if (!mCompressed)
+	{
+		stream.WriteFloat(mDuration);
+		stream.WriteUInt(mAnimationTracks.size());
+
+		for (const AnimationTrack& animTrack : mAnimationTracks)
+		{
+			stream.WriteString(animTrack.Name);
+			stream.WriteUInt(animTrack.NumKeys);
+
+			for (uint32_t key = animTrack.FirstKey; key < animTrack.FirstKey + animTrack.NumKeys; ++key)
+			{
+				stream.WriteFloat(mKeyTimes[key]);
+				stream.Write(&mKeyTranslations[key], sizeof(float3));
+				stream.Write(&mKeyRotations[key], sizeof(Quaternionf));
+				stream.Write(&mKeyScales[key], sizeof(float3));
+			}
+		}
+		return;
+	}
+
+	stream.WriteUInt(CompressedClipMagic);
+	stream.WriteUInt(CompressedClipVersion);
+	stream.WriteFloat(mDuration);
+
+	const CompressionReport& report = mCompressionReport;
+	stream.WriteUInt(report.NumRawKeys);
+	stream.WriteUInt(report.NumKeys);
+	stream.WriteUInt(report.RawSize);
+	stream.WriteUInt(report.CompressedSize);
+	stream.WriteFloat(report.MaxTranslationError);
+	stream.WriteFloat(report.MaxRotationError);
+	stream.WriteFloat(report.MaxScaleError);
+
+	stream.WriteUInt(mAnimationTracks.size());
+	for (uint32_t track = 0; track < mAnimationTracks.size(); ++track)
+	{
+		const AnimationTrack& animTrack = mAnimationTracks[track];
+		stream.WriteString(animTrack.Name);
+		stream.WriteUInt(animTrack.FirstKey);
+		stream.WriteUInt(animTrack.NumKeys);
+
+		const CompressedTrack& packedTrack = mCompressedTracks[track];
+		stream.WriteUInt(packedTrack.TranslationOffset);
+		stream.WriteUInt(packedTrack.RotationOffset);
+		stream.WriteUInt(packedTrack.ScaleOffset);
+		stream.WriteUInt(packedTrack.ConstantChannels);
+		stream.Write(&packedTrack.TranslationMin, sizeof(float3));
+		stream.Write(&packedTrack.TranslationStep, sizeof(float3));
+		stream.Write(&packedTrack.ScaleMin, sizeof(float3));
+		stream.Write(&packedTrack.ScaleStep, sizeof(float3));
+	}
+
+	WriteArray(stream, mKeyTimes);
+	WriteArray(stream, mPackedTranslations);
+	WriteArray(stream, mPackedRotations);
+	WriteArray(stream, mPackedScales);
 }
 
 void AnimationClip::UnloadImpl()
 {
+	mAnimationTracks.clear();
+	mTrackVersion++;
+
+	vector<float>().swap(mKeyTimes);
+	vector<float3>().swap(mKeyTranslations);
+	vector<Quaternionf>().swap(mKeyRotations);
+	vector<float3>().swap(mKeyScales);
 
+	mCompressed = false;
+	vector<CompressedTrack>().swap(mCompressedTracks);
+	vector<uint16_t>().swap(mPackedTranslations);
+	vector<uint16_t>().swap(mPackedRotations);
+	vector<uint16_t>().swap(mPackedScales);
 }
 
 shared_ptr<Resource> AnimationClip::FactoryFunc( ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
@@ -14,23 +14,49 @@ public:
 	friend class AnimationPlayer;
 	friend class AnimationState;
 
-	struct _ApiExport KeyFrame
+	/**
+	 * Keys of a track are a range of the clip's key streams. Times, translations, rotations
+	 * and scales are stored in separate streams, searching a key only touches times.
+	 */
+	struct _ApiExport AnimationTrack
 	{
-		// The time offset from the start of the animation to this keyframe.
-		float Time;
+		// Bone name
+		String Name;
 
-		float3 Translation;
-		Quaternionf Rotation;
-		float3 Scale;
+		uint32_t FirstKey;
+		uint32_t NumKeys;
 	};
 
-	struct _ApiExport AnimationTrack
+	/**
+	 * Keys are removed where interpolating their neighbors stays within tolerance. Constant
+	 * channels keep one value, rotations are quantized to 48 bits (smallest three) and
+	 * translations and scales to 16 bits per component over the track's range.
+	 * Quantization error comes on top of the tolerances.
+	 */
+	struct _ApiExport CompressionSettings
 	{
-		// Bone name
-		String Name;
-		vector<KeyFrame> KeyFrames;
+		CompressionSettings();
+
+		bool Enabled;
+
+		float TranslationTolerance;
+		float RotationTolerance;	// In radians
+		float ScaleTolerance;
+	};
+
+	struct _ApiExport CompressionReport
+	{
+		uint32_t NumRawKeys;
+		uint32_t NumKeys;
 
-		int32_t GetKeyFrameIndex( float time ) const;
+		// Key data size in bytes, before and after compression
+		uint32_t RawSize;
+		uint32_t CompressedSize;
+
+		// Max error of compressed clip at raw key times
+		float MaxTranslationError;
+		float MaxRotationError;
+		float MaxScaleError;
 	};
 
 public:
@@ -45,6 +71,60 @@ public:
 	 */
 	float GetDuration() const { return mDuration; }
 
+	uint32_t GetNumTracks() const							{ return mAnimationTracks.size(); }
+	const AnimationTrack& GetTrack(uint32_t index) const	{ return mAnimationTracks[index]; }
+
+	/**
+	 * Time of a key in track, compressed clips only have keys kept by reduction.
+	 */
+	float GetKeyTime(uint32_t track, uint32_t key) const	{ return mKeyTimes[mAnimationTracks[track].FirstKey + key]; }
+
+	/**
+	 * Incremented whenever tracks are loaded or unloaded, track indices of a clip reloaded
+	 * from a changed file may refer to other targets.
+	 */
+	uint32_t GetTrackVersion() const						{ return mTrackVersion; }
+
+	/**
+	 * Index in track of the last key frame before time, binary search.
+	 */
+	int32_t GetKeyFrameIndex( uint32_t track, float time ) const;
+
+	/**
+	 * Same as above, but search starts from cursor, the result of the previous call, and
+	 * cursor is updated. Playback only moves a few keys per frame, so this is O(1) for
+	 * forward, reverse and looping playback.
+	 */
+	int32_t GetKeyFrameIndex( uint32_t track, float time, uint32_t& cursor ) const;
+
+	/**
+	 * Interpolate track at time, track must have keys. If loop, time after the last key
+	 * interpolates to the first key.
+	 */
+	void SampleTrack( uint32_t track, float time, bool loop, uint32_t& cursor,
+		float3& translation, Quaternionf& rotation, float3& scale ) const;
+
+	/**
+	 * Compress loaded key frames, clips loaded while load time compression is enabled are
+	 * compressed already. Tools can compress clips offline to check the report.
+	 */
+	void Compress( const CompressionSettings& settings );
+
+	bool IsCompressed() const								{ return mCompressed; }
+	const CompressionReport& GetCompressionReport() const	{ return mCompressionReport; }
+
+	/**
+	 * Write clip in a format LoadImpl reads. Compressed clips keep packed keys and report,
+	 * loading them needs no compression pass.
+	 */
+	void Save( Stream& stream ) const;
+
+	/**
+	 * Settings for clips loaded afterwards, load time compression is disabled by default.
+	 */
+	static void SetLoadCompression( const CompressionSettings& settings );
+	static const CompressionSettings& GetLoadCompression()	{ return msLoadCompression; }
+
 protected:
 	void LoadImpl();
 	void UnloadImpl();
@@ -52,10 +132,47 @@ protected:
 public:
 	static shared_ptr<Resource> FactoryFunc(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group);
 
-private:	
+private:
+	struct CompressedTrack
+	{
+		// First key in packed streams, constant channels have a single key
+		uint32_t TranslationOffset;
+		uint32_t RotationOffset;
+		uint32_t ScaleOffset;
+		uint32_t ConstantChannels;
+
+		// value = min + quantized * step
+		float3 TranslationMin, TranslationStep;
+		float3 ScaleMin, ScaleStep;
+	};
+
+	void SampleCompressedTrack( uint32_t track, int32_t frame, int32_t nextFrame, float t,
+		float3& translation, Quaternionf& rotation, float3& scale ) const;
+
+	void LoadCompressed( Stream& source );
+
+private:
+	static CompressionSettings msLoadCompression;
+
 	float mDuration;
 	String mClipName;
 	vector<AnimationTrack> mAnimationTracks;
+	uint32_t mTrackVersion;
+
+	// Key streams of all tracks
+	vector<float> mKeyTimes;
+	vector<float3> mKeyTranslations;
+	vector<Quaternionf> mKeyRotations;
+	vector<float3> mKeyScales;
+
+	// Replace translation, rotation and scale streams once compressed, 3 values per key
+	bool mCompressed;
+	vector<CompressedTrack> mCompressedTracks;
+	vector<uint16_t> mPackedTranslations;
+	vector<uint16_t> mPackedRotations;
+	vector<uint16_t> mPackedScales;
+
+	CompressionReport mCompressionReport;
 };
 
 
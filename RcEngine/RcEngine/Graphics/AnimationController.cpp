@@ -2,11 +2,32 @@
 #include <Graphics/Animation.h>
 #include <Graphics/AnimationState.h>
 #include <Graphics/AnimationClip.h>
+#include <Core/JobSystem.h>
+#include <Core/Profiler.h>
+#include <Math/MathUtil.h>
 
 namespace RcEngine {
 
+// Players evaluated per job, a player is typically a few dozen bones
+static const uint32_t PlayerGrainSize = 8;
+
+// Used when no levels are set
+static const AnimationLodLevel FullLodLevel = { 0.0f, 1, 0 };
+
+AnimationLodSettings::AnimationLodSettings()
+	: LodMetric(ScreenSize),
+	  InterpolatePoses(true),
+	  FreezeInvisible(false),
+	  EvaluationBudget(0)
+{
+
+}
+
 AnimationController::AnimationController()
-	: mState(Idle)
+	: mState(Idle),
+	  mSkinPaletteChanged(false),
+	  mEvaluationCost(0),
+	  mFrameNumber(0)
 {
 
 }
@@ -18,25 +39,204 @@ AnimationController::~AnimationController()
 
 void AnimationController::Update( float elapsedTime )
 {
-	if (mState != Running)
+	// Loop through running clips and call update() on them.
+	if (mState == Running)
+	{
+		std::list<AnimationState*>::iterator clipIter = mRunningClips.begin();
+		while (clipIter != mRunningClips.end())
+		{
+			AnimationState* clipState = *clipIter;
+
+			if( !clipState->Update(elapsedTime) )
+			{
+				clipIter = mRunningClips.erase(clipIter);
+			}
+			else
+				++clipIter;
+		}
+
+		if (mRunningClips.empty())
+			mState = Idle;
+	}
+
+	SelectLods();
+
+	// Stopped clips still need their players to go back to bind pose
+	UpdatePlayers();
+
+	// Visibility reported from now on is for next update
+	mFrameNumber++;
+}
+
+void AnimationController::SetLodSettings( const AnimationLodSettings& settings )
+{
+	mLodSettings = settings;
+}
+
+void AnimationController::SelectLods()
+{
+	const AnimationLodSettings& settings = mLodSettings;
+	const uint32_t numLevels = settings.Levels.size();
+	const uint32_t lastLevel = numLevels ? numLevels - 1 : 0;
+
+	auto getLevel = [&](uint32_t level) -> const AnimationLodLevel& {
+		return numLevels ? settings.Levels[level] : FullLodLevel;
+	};
+
+	mEvaluationCost = 0;
+	mLodCandidates.clear();
+
+	for (AnimationPlayer* player : mPlayers)
+	{
+		int32_t level = 0;
+		bool frozen = false;
+
+		// Least significant players are throttled first by the budget
+		float significance = FLT_MAX;
+
+		if (player->mVisibilityTracked)
+		{
+			// Reported while culling since last update
+			bool visible = (player->mVisibleFrame == mFrameNumber);
+
+			if (visible)
+			{
+				float metric = (settings.LodMetric == AnimationLodSettings::ScreenSize) ? player->mVisibleScreenSize : player->mVisibleDistance;
+				while (level < (int32_t)lastLevel)
+				{
+					float threshold = settings.Levels[level+1].Threshold;
+					bool passed = (settings.LodMetric == AnimationLodSettings::ScreenSize) ? (metric < threshold) : (metric > threshold);
+					if (!passed)
+						break;
+					level++;
+				}
+
+				significance = player->mVisibleScreenSize;
+			}
+			else
+			{
+				level = lastLevel;
+				significance = -1.0f;
+
+				// Player is evaluated once so its targets leave bind pose
+				frozen = settings.FreezeInvisible && player->mEvaluated;
+			}
+		}
+
+		level = Clamp(level + player->mLodBias, 0, (int32_t)lastLevel);
+
+		player->mFrozen = frozen;
+		player->mLodLevel = level;
+		player->mNumActiveStates = player->CountActiveStates();
+
+		if (!frozen)
+		{
+			mEvaluationCost += player->GetEvaluationCost(getLevel(level));
+			if (settings.EvaluationBudget)
+				mLodCandidates.push_back(std::make_pair(significance, player));
+		}
+	}
+
+	if (settings.EvaluationBudget && mEvaluationCost > settings.EvaluationBudget)
+	{
+		std::stable_sort(mLodCandidates.begin(), mLodCandidates.end(),
+			[](const std::pair<float, AnimationPlayer*>& a, const std::pair<float, AnimationPlayer*>& b) { return a.first < b.first; });
+
+		for (size_t i = 0; i < mLodCandidates.size() && mEvaluationCost > settings.EvaluationBudget; ++i)
+		{
+			AnimationPlayer* player = mLodCandidates[i].second;
+			while (player->mLodLevel < lastLevel && mEvaluationCost > settings.EvaluationBudget)
+			{
+				mEvaluationCost -= player->GetEvaluationCost(getLevel(player->mLodLevel));
+				player->mLodLevel++;
+				mEvaluationCost += player->GetEvaluationCost(getLevel(player->mLodLevel));
+			}
+		}
+	}
+
+	for (AnimationPlayer* player : mPlayers)
+		player->SetLod(player->mLodLevel, getLevel(player->mLodLevel), settings.InterpolatePoses);
+}
+
+void AnimationController::UpdatePlayers()
+{
+	ENGINE_CPU_AUTO_PROFIER("Animation Update");
+
+	uint32_t numPlayers = mPlayers.size();
+	if (numPlayers == 0)
 		return;
 
-	// Loop through running clips and call update() on them.
-	std::list<AnimationState*>::iterator clipIter = mRunningClips.begin();
-	while (clipIter != mRunningClips.end())
+	// Close ranges of removed players, matrices move with their player
+	if (mSkinPaletteChanged)
 	{
-		AnimationState* clipState = *clipIter;
+		uint32_t paletteSize = 0;
+		for (AnimationPlayer* player : mPlayers)
+			paletteSize += player->mNumSkinMatrices;
 
-		if( !clipState->Update(elapsedTime) )
+		vector<float4x4> palette(paletteSize);
+
+		paletteSize = 0;
+		for (AnimationPlayer* player : mPlayers)
 		{
-			clipIter = mRunningClips.erase(clipIter);
+			if (player->mNumSkinMatrices)
+			{
+				std::copy_n(mSkinPalette.begin() + player->mSkinPaletteOffset, player->mNumSkinMatrices, palette.begin() + paletteSize);
+				player->mSkinPaletteOffset = paletteSize;
+				paletteSize += player->mNumSkinMatrices;
+			}
 		}
-		else
-			++clipIter;
+
+		mSkinPalette.swap(palette);
+		mSkinPaletteChanged = false;
 	}
 
-	if (mRunningClips.empty())
-		mState = Idle;
+	mPlayersUpdated.resize(numPlayers);
+
+	JobSystem& jobSystem = JobSystem::GetSingleton();
+	jobSystem.ParallelFor(0, numPlayers, PlayerGrainSize, [this](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			AnimationPlayer* player = mPlayers[i];
+
+			bool updated = player->Update();
+			if (updated && player->mNumSkinMatrices)
+				player->UpdateSkinMatrices(&mSkinPalette[player->mSkinPaletteOffset]);
+
+			mPlayersUpdated[i] = updated;
+		}
+	});
+
+	// Dirty flags propagate into the scene graph, not safe in jobs
+	for (uint32_t i = 0; i < numPlayers; ++i)
+	{
+		if (mPlayersUpdated[i])
+			mPlayers[i]->DirtyAttachedNodes();
+	}
+}
+
+void AnimationController::AddPlayer( AnimationPlayer* player )
+{
+	mPlayers.push_back(player);
+}
+
+void AnimationController::RemovePlayer( AnimationPlayer* player )
+{
+	auto found = std::find(mPlayers.begin(), mPlayers.end(), player);
+	if (found != mPlayers.end())
+	{
+		mPlayers.erase(found);
+
+		// Other players keep their offsets until next update
+		if (player->mNumSkinMatrices)
+			mSkinPaletteChanged = true;
+	}
+}
+
+void AnimationController::AllocateSkinMatrices( AnimationPlayer* player )
+{
+	// Bind pose until the player is updated
+	player->mSkinPaletteOffset = mSkinPalette.size();
+	mSkinPalette.resize(mSkinPalette.size() + player->mNumSkinMatrices, float4x4::Identity());
 }
 
 void AnimationController::Schedule(AnimationState* clipState)
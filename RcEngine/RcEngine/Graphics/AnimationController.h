@@ -2,13 +2,61 @@
 #define AnimationController_h__
 
 #include <Core/Prerequisites.h>
+#include <Math/Matrix.h>
 
 namespace RcEngine {
 
+/**
+ * Animation level of detail, only used by players tracking visibility. Level 0 is full
+ * quality, a player uses the last level whose threshold it passes.
+ */
+struct _ApiExport AnimationLodLevel
+{
+	// Screen height fraction the player must be below, or distance it must be above
+	float Threshold;
+
+	// Frames between pose evaluations
+	uint32_t UpdateInterval;
+
+	// Bones less than this many levels above a leaf bone keep their last pose, 1 skips leaves
+	uint32_t SkipBoneHeight;
+};
+
+struct _ApiExport AnimationLodSettings
+{
+	enum Metric
+	{
+		ScreenSize,
+		Distance
+	};
+
+	AnimationLodSettings();
+
+	Metric LodMetric;
+	vector<AnimationLodLevel> Levels;
+
+	// Blend between the last two evaluated poses on frames that are not evaluated. Smooth,
+	// but the pose lags one update interval behind.
+	bool InterpolatePoses;
+
+	// Players not queued for rendering last frame keep their pose while clips advance,
+	// otherwise they use the last level
+	bool FreezeInvisible;
+
+	// Max bone tracks sampled per frame, averaged over update intervals, 0 is unlimited.
+	// Least significant players are moved to coarser levels until the estimate fits.
+	uint32_t EvaluationBudget;
+};
 
+/**
+ * Advances playing clips and evaluates all animation players once per frame, before
+ * culling, so skinning doesn't depend on visibility. Players are evaluated in parallel and
+ * write skin matrices into one contiguous palette.
+ */
 class _ApiExport AnimationController
 {
 	friend class AnimationPlayer;
+	friend class SkinnedAnimationPlayer;
 
 public:
 	enum State
@@ -25,6 +73,9 @@ public:
 	
 	State GetState() const	{ return mState; }
 
+	/**
+	 * Advance running clips and evaluate players, called by SceneManager::UpdateSceneGraph.
+	 */
 	void Update(float elapsedTime);
 
 	void Unschedule(AnimationState* clipState);
@@ -33,11 +84,62 @@ public:
 	void Pause();
 	void Resume();
 
+	/**
+	 * Skin matrices of all players, see AnimationPlayer::GetSkinMatrices.
+	 */
+	const float4x4* GetSkinPalette() const		{ return mSkinPalette.empty() ? nullptr : &mSkinPalette[0]; }
+	uint32_t GetSkinPaletteSize() const			{ return mSkinPalette.size(); }
+
+	void SetLodSettings(const AnimationLodSettings& settings);
+	const AnimationLodSettings& GetLodSettings() const	{ return mLodSettings; }
+
+	/**
+	 * Estimated bone tracks sampled in last update, comparable to the evaluation budget.
+	 */
+	uint32_t GetEvaluationCost() const			{ return mEvaluationCost; }
+
+	/**
+	 * Number of updates so far, visibility reported to players is for the current one.
+	 */
+	uint32_t GetFrameNumber() const				{ return mFrameNumber; }
+
+protected:
+	void AddPlayer(AnimationPlayer* player);
+	void RemovePlayer(AnimationPlayer* player);
+
+	/**
+	 * Append player's skin matrices to the palette, initialized to bind pose.
+	 */
+	void AllocateSkinMatrices(AnimationPlayer* player);
+
+	void UpdatePlayers();
+
+	/**
+	 * Pick each player's level of detail from last frame's visibility and the budget.
+	 */
+	void SelectLods();
+
 public:
 	State mState;
 
 	// A list of running AnimationClips.
 	std::list<AnimationState*> mRunningClips;     
+
+private:
+	vector<AnimationPlayer*> mPlayers;
+	vector<uint8_t> mPlayersUpdated;
+
+	vector<float4x4> mSkinPalette;
+
+	// Palette has ranges of removed players, compacted in next update
+	bool mSkinPaletteChanged;
+
+	AnimationLodSettings mLodSettings;
+	uint32_t mEvaluationCost;
+	uint32_t mFrameNumber;
+
+	// Players by ascending significance, reused each frame
+	vector<std::pair<float, AnimationPlayer*> > mLodCandidates;
 };
 
 }
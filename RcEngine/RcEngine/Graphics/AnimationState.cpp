@@ -16,11 +16,15 @@ AnimationState::AnimationState( AnimationPlayer& animation, const shared_ptr<Ani
 	  BlendWeight(1.0f), 
 	  PlayBackSpeed(1.0f), 
 	  WrapMode(Wrap_Once),
+	  Additive(false),
+	  mLayer(0),
 	  mStateBits(0x00),
 	  mEnable(true),
+	  mKeyFrameCursorsValid(false),
+	  mBoundTrackVersion(0),
 	  mFadeToClipState(nullptr)
 {
-
+	BindTracks();
 }
 
 AnimationState::~AnimationState()
@@ -43,75 +47,114 @@ float AnimationState::GetDuration() const
 	return mClip->GetDuration();
 }
 
-void AnimationState::Apply()
+void AnimationState::PrepareSampling()
 {
-	if (!IsEnabled() || !IsClipStateBitSet(Clip_Is_Playing_Bit))
-		return;
+	// Clip may be reloaded with different tracks, even with the same track count
+	if (mBoundTrackVersion != mClip->GetTrackVersion())
+		BindTracks();
 
-	for (const AnimationClip::AnimationTrack& animTrack : mClip->mAnimationTracks)
+	if (!mKeyFrameCursorsValid)
 	{
-		// if no key frames, pass
-		if (animTrack.KeyFrames.empty())
+		for (uint32_t i = 0; i < mTrackTargets.size(); ++i)
+		{
+			if (mTrackTargets[i] >= 0)
+				mKeyFrameCursors[i] = mClip->GetKeyFrameIndex(i, mTime);
+		}
+
+		mKeyFrameCursorsValid = true;
+	}
+}
+
+void AnimationState::SampleWeighted( AnimationPose& pose, vector<float>& weights, const AnimationPose& basePose )
+{
+	PrepareSampling();
+
+	const bool loop = (WrapMode == Wrap_Loop);
+	for (uint32_t i = 0; i < mTrackTargets.size(); ++i)
+	{
+		int32_t target = mTrackTargets[i];
+		if (target < 0 || mAnimation.IsTargetSkipped(target))
 			continue;
 
-		unordered_map<String, Bone*>::const_iterator found = mAnimation.mAnimateTargets.find(animTrack.Name);
+		float3 translation, scale;
+		Quaternionf rotation;
+		mClip->SampleTrack(i, mTime, loop, mKeyFrameCursors[i], translation, rotation, scale);
 
-		assert( found != mAnimation.mAnimateTargets.end() );
-		Bone* bone = found->second;
+		// q and -q are the same rotation, sum the ones closer to base pose
+		if (QuaternionDot(rotation, basePose.Rotations[target]) < 0.0f)
+			rotation = rotation * -1.0f;
 
-		int32_t frame = animTrack.GetKeyFrameIndex(mTime);
-		int32_t nextFrame = frame + 1;
-		//printf("nextFrame = %d\n", nextFrame);
+		pose.Translations[target] += translation * BlendWeight;
+		pose.Rotations[target] += rotation * BlendWeight;
+		pose.Scales[target] += scale * BlendWeight;
+		weights[target] += BlendWeight;
+	}
+}
 
-		bool interpolate = true;
-		if (nextFrame >= (int32_t)animTrack.KeyFrames.size())
-		{
-			if (WrapMode != Wrap_Loop)
-			{
-				nextFrame = frame;
-				interpolate = false;
-			}
-			else
-				nextFrame = 0;
-		}
+void AnimationState::SampleAdditive( AnimationPose& pose )
+{
+	PrepareSampling();
 
-		const AnimationClip::KeyFrame& keyframe = animTrack.KeyFrames[frame];
+	const bool loop = (WrapMode == Wrap_Loop);
+	const float weight = (std::min)(BlendWeight, 1.0f);
 
-		if (!interpolate)
+	for (uint32_t i = 0; i < mTrackTargets.size(); ++i)
+	{
+		int32_t target = mTrackTargets[i];
+		if (target < 0 || mAnimation.IsTargetSkipped(target))
+			continue;
+
+		float3 translation, scale, refTranslation, refScale;
+		Quaternionf rotation, refRotation;
+		mClip->SampleTrack(i, mTime, loop, mKeyFrameCursors[i], translation, rotation, scale);
+
+		uint32_t refCursor = 0;
+		mClip->SampleTrack(i, 0.0f, false, refCursor, refTranslation, refRotation, refScale);
+
+		pose.Translations[target] += (translation - refTranslation) * weight;
+
+		Quaternionf deltaRotation = QuaternionInverse(refRotation) * rotation;
+		pose.Rotations[target] = pose.Rotations[target] * QuaternionSlerp(Quaternionf::Identity(), deltaRotation, weight);
+
+		for (int k = 0; k < 3; ++k)
 		{
-			// No interpolation, blend between old transform & animation
-			 bone->SetPosition( Lerp(bone->GetPosition(), keyframe.Translation, BlendWeight) );
-			 bone->SetRotation( QuaternionSlerp(bone->GetRotation(), keyframe.Rotation, BlendWeight) );
-			 bone->SetScale( Lerp(bone->GetScale(), keyframe.Scale, BlendWeight) );
+			float ratio = (refScale[k] != 0.0f) ? scale[k] / refScale[k] : 1.0f;
+			pose.Scales[target][k] *= Lerp(1.0f, ratio, weight);
 		}
-		else
-		{		
-			const AnimationClip::KeyFrame& nextKeyframe = animTrack.KeyFrames[nextFrame];
-
-			//std::cout << keyframe.Time << "-->" << nextKeyframe.Time << std::endl;
-			float timeInterval = nextKeyframe.Time - keyframe.Time;
-			if (timeInterval < 0.0f)
-				timeInterval += mClip->GetDuration();
-			float t = timeInterval > 0.0f ? (mTime - keyframe.Time) / timeInterval : 1.0f;
-		
-			bone->SetPosition( Lerp(bone->GetPosition(),
-			Lerp(keyframe.Translation, nextKeyframe.Translation, t), BlendWeight) );
+	}
+}
 
-			bone->SetRotation( QuaternionSlerp(bone->GetRotation(), 
-			QuaternionSlerp(keyframe.Rotation, nextKeyframe.Rotation, t), BlendWeight) );
+void AnimationState::BindTracks()
+{
+	uint32_t numTracks = mClip->GetNumTracks();
 
-			bone->SetScale( Lerp(bone->GetScale(),
-			Lerp(keyframe.Scale, nextKeyframe.Scale, t), BlendWeight) );
-		}
+	mTrackTargets.resize(numTracks);
+	for (uint32_t i = 0; i < numTracks; ++i)
+	{
+		const AnimationClip::AnimationTrack& animTrack = mClip->GetTrack(i);
+
+		// if no key frames, pass
+		mTrackTargets[i] = animTrack.NumKeys ? mAnimation.GetTargetIndex(animTrack.Name) : -1;
+		assert(!animTrack.NumKeys || mTrackTargets[i] >= 0);
 	}
+
+	mKeyFrameCursors.assign(numTracks, 0);
+	mKeyFrameCursorsValid = false;
+	mBoundTrackVersion = mClip->GetTrackVersion();
 }
 
 void AnimationState::AdvanceTime( float deltaTime )
 {
-	SetTime(mTime + deltaTime);
+	UpdateTime(mTime + deltaTime);
 }
 
 void AnimationState::SetTime( float timePos )
+{
+	UpdateTime(timePos);
+	mKeyFrameCursorsValid = false;
+}
+
+void AnimationState::UpdateTime( float timePos )
 {
 	float length = mClip->GetDuration();
 
@@ -290,6 +333,7 @@ void AnimationState::Play()
 	else
 	{
 		SetClipStateBit(Clip_Is_Playing_Bit);
+		mKeyFrameCursorsValid = false;
 		
 		if (PlayBackSpeed > 0.0f)
 		{
@@ -55,7 +55,8 @@ public:
 	bool IsEnabled() const { return mEnable; } 
 
 	/**
-	 * Current animation time position.
+	 * Current animation time position. SetTime is a seek, key frames are searched again
+	 * when sampled next, AdvanceTime continues from the keys of the last sample.
 	 */
 	void SetTime( float time );
 	void AdvanceTime( float deltaTime );
@@ -73,9 +74,16 @@ public:
 	void SetFadeLength(float fadeLength);
 
 	/**
-	 * Applies an animation track to the designated target. 
+	 * Add sampled transforms times BlendWeight to pose and BlendWeight to weights of animated
+	 * targets. Rotations are aligned to the same hemisphere as basePose before summing.
 	 */
-	void Apply();
+	void SampleWeighted(AnimationPose& pose, vector<float>& weights, const AnimationPose& basePose);
+
+	/**
+	 * Add difference between sampled transforms and clip's first frame, times BlendWeight,
+	 * to animated targets of pose.
+	 */
+	void SampleAdditive(AnimationPose& pose);
 
 	void ResetCrossFadeTime()	{ mCrossFadeOutElapsed = 0.0f; }
 
@@ -94,6 +102,11 @@ public:
 private:
 	void OnBegin();
 	void OnEnd();
+
+	void UpdateTime( float timePos );
+
+	void BindTracks();
+	void PrepareSampling();
 		
 private:
 
@@ -108,6 +121,16 @@ private:
 
 	// The current time of the animation.
 	float mTime;
+
+	// Animation target index of each track, -1 if not animated
+	vector<int32_t> mTrackTargets;
+
+	// Key frame index of each track at last sample, invalid after a seek
+	vector<uint32_t> mKeyFrameCursors;
+	bool mKeyFrameCursorsValid;
+
+	// Clip track version targets are bound to
+	uint32_t mBoundTrackVersion;
 	
 	// Cross fade time, and fade to clip state
 	float mCrossFadeOutElapsed;
@@ -132,6 +155,9 @@ public:
 	// Wrapping mode of the animation.
 	AnimationWrapMode WrapMode;
 
+	// Additive animation is added on top of its layer, relative to its first frame
+	bool Additive;
+
 	// The layer of the animation. When calculating the final blend weights, animations in higher layers will get their weights
 	uint8_t mLayer;
 
@@ -0,0 +1,1062 @@
+#include <Graphics/BlockCompression.h>
+#include <Core/JobSystem.h>
+#include <Core/Exception.h>
+#include <climits>
+
+namespace RcEngine {
+
+namespace {
+
+// Blocks per job, a block is a few hundred operations for BC1 and a few thousand for BC7
+const uint32_t BlockGrainSize = 256;
+
+enum BlockType
+{
+	BT_None,
+	BT_BC1,
+	BT_BC1A,	// BC1 with 1 bit alpha
+	BT_BC2,
+	BT_BC3,
+	BT_BC4,
+	BT_BC5,
+	BT_BC7
+};
+
+BlockType GetBlockType( PixelFormat format )
+{
+	switch (format)
+	{
+	case PF_RGB_DXT1_UNORM:
+	case PF_SRGB_DXT1_UNORM:
+		return BT_BC1;
+	case PF_RGBA_DXT1_UNORM:
+	case PF_SRGB_ALPHA_DXT1_UNORM:
+		return BT_BC1A;
+	case PF_RGBA_DXT3_UNORM:
+	case PF_SRGB_ALPHA_DXT3_UNORM:
+		return BT_BC2;
+	case PF_RGBA_DXT5_UNORM:
+	case PF_SRGB_ALPHA_DXT5_UNORM:
+		return BT_BC3;
+	case PF_R_ATI1N_UNORM:
+		return BT_BC4;
+	case PF_RG_ATI2N_UNORM:
+		return BT_BC5;
+	case PF_RGB_BP_UNORM:
+	case PF_SRGB_BP_UNORM:
+		return BT_BC7;
+	default:
+		return BT_None;
+	}
+}
+
+template<typename T>
+inline T Clamp( T value, T minValue, T maxValue )
+{
+	return value < minValue ? minValue : (value > maxValue ? maxValue : value);
+}
+
+inline uint64_t ReadUInt64( const uint8_t* bytes, uint32_t count )
+{
+	uint64_t value = 0;
+	for (uint32_t i = 0; i < count; ++i)
+		value |= uint64_t(bytes[i]) << (i * 8);
+	return value;
+}
+
+inline void WriteUInt64( uint8_t* bytes, uint64_t value, uint32_t count )
+{
+	for (uint32_t i = 0; i < count; ++i)
+		bytes[i] = uint8_t(value >> (i * 8));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Endpoint fitting shared by color and BC7 encoders
+
+/**
+ * Endpoints on the principal axis of pixels, spanning their projections on it. Pixels
+ * with skip set are ignored.
+ */
+void FitPrincipalAxis( const uint8_t* pixels, const bool* skip, uint32_t numChannels, float* e0, float* e1 )
+{
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float minValue[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+	float maxValue[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		if (skip && skip[i])
+			continue;
+
+		for (uint32_t c = 0; c < numChannels; ++c)
+		{
+			float value = pixels[i*4+c];
+			mean[c] += value;
+			minValue[c] = (std::min)(minValue[c], value);
+			maxValue[c] = (std::max)(maxValue[c], value);
+		}
+		++count;
+	}
+
+	for (uint32_t c = 0; c < numChannels; ++c)
+		mean[c] /= float(count);
+
+	float covariance[4][4] = { };
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		if (skip && skip[i])
+			continue;
+
+		float d[4];
+		for (uint32_t c = 0; c < numChannels; ++c)
+			d[c] = pixels[i*4+c] - mean[c];
+
+		for (uint32_t r = 0; r < numChannels; ++r)
+			for (uint32_t c = r; c < numChannels; ++c)
+				covariance[r][c] += d[r] * d[c];
+	}
+
+	for (uint32_t r = 0; r < numChannels; ++r)
+		for (uint32_t c = 0; c < r; ++c)
+			covariance[r][c] = covariance[c][r];
+
+	// Power iteration, starting from the bounding box diagonal
+	float axis[4];
+	for (uint32_t c = 0; c < numChannels; ++c)
+		axis[c] = maxValue[c] - minValue[c];
+
+	for (uint32_t iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float largest = 0.0f;
+		for (uint32_t r = 0; r < numChannels; ++r)
+		{
+			for (uint32_t c = 0; c < numChannels; ++c)
+				next[r] += covariance[r][c] * axis[c];
+			largest = (std::max)(largest, fabsf(next[r]));
+		}
+
+		if (largest == 0.0f)
+			break;
+
+		for (uint32_t c = 0; c < numChannels; ++c)
+			axis[c] = next[c] / largest;
+	}
+
+	float lengthSq = 0.0f;
+	for (uint32_t c = 0; c < numChannels; ++c)
+		lengthSq += axis[c] * axis[c];
+
+	float minT = 0.0f, maxT = 0.0f;
+	if (lengthSq > 0.0f)
+	{
+		float invLength = 1.0f / sqrtf(lengthSq);
+		for (uint32_t c = 0; c < numChannels; ++c)
+			axis[c] *= invLength;
+
+		minT = FLT_MAX;
+		maxT = -FLT_MAX;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			if (skip && skip[i])
+				continue;
+
+			float t = 0.0f;
+			for (uint32_t c = 0; c < numChannels; ++c)
+				t += (pixels[i*4+c] - mean[c]) * axis[c];
+
+			minT = (std::min)(minT, t);
+			maxT = (std::max)(maxT, t);
+		}
+	}
+
+	for (uint32_t c = 0; c < numChannels; ++c)
+	{
+		e0[c] = Clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+		e1[c] = Clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+	}
+}
+
+/**
+ * Least squares endpoints for pixels interpolated by indices, weights are the fraction of
+ * e1 of each index. False if the system is singular, all pixels use the same weight.
+ */
+bool FitEndpoints( const uint8_t* pixels, const bool* skip, const uint8_t* indices, const float* weights,
+	               uint32_t numChannels, float* e0, float* e1 )
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		if (skip && skip[i])
+			continue;
+
+		float b = weights[indices[i]];
+		float a = 1.0f - b;
+
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (uint32_t c = 0; c < numChannels; ++c)
+		{
+			ax[c] += a * pixels[i*4+c];
+			bx[c] += b * pixels[i*4+c];
+		}
+	}
+
+	float det = aa * bb - ab * ab;
+	if (fabsf(det) < 1e-6f)
+		return false;
+
+	float invDet = 1.0f / det;
+	for (uint32_t c = 0; c < numChannels; ++c)
+	{
+		e0[c] = Clamp((bb * ax[c] - ab * bx[c]) * invDet, 0.0f, 255.0f);
+		e1[c] = Clamp((aa * bx[c] - ab * ax[c]) * invDet, 0.0f, 255.0f);
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// BC1 color block, also the color part of BC2 and BC3
+
+const float ColorWeights4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+const float ColorWeights3[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+
+inline void Unpack565( uint32_t color, int32_t* rgb )
+{
+	int32_t r = (color >> 11) & 31;
+	int32_t g = (color >> 5) & 63;
+	int32_t b = color & 31;
+
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+inline uint32_t Pack565( const float* rgb )
+{
+	uint32_t r = Clamp(int32_t(rgb[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+	uint32_t g = Clamp(int32_t(rgb[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+	uint32_t b = Clamp(int32_t(rgb[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+
+	return (r << 11) | (g << 5) | b;
+}
+
+/**
+ * Palette the way decoders build it, 4 colors or 3 colors and transparent black.
+ */
+void BuildColorPalette( uint32_t c0, uint32_t c1, bool fourColor, int32_t palette[4][4] )
+{
+	Unpack565(c0, palette[0]);
+	Unpack565(c1, palette[1]);
+	palette[0][3] = palette[1][3] = 255;
+
+	if (fourColor)
+	{
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+		}
+		palette[2][3] = palette[3][3] = 255;
+	}
+	else
+	{
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+			palette[3][c] = 0;
+		}
+		palette[2][3] = 255;
+		palette[3][3] = 0;
+	}
+}
+
+int32_t FindColorIndices( const uint8_t* pixels, const bool* transparent, const int32_t palette[4][4], uint32_t numColors, uint8_t* indices )
+{
+	int32_t error = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		if (transparent && transparent[i])
+		{
+			indices[i] = 3;
+			continue;
+		}
+
+		int32_t best = INT_MAX;
+		for (uint32_t k = 0; k < numColors; ++k)
+		{
+			int32_t dr = pixels[i*4+0] - palette[k][0];
+			int32_t dg = pixels[i*4+1] - palette[k][1];
+			int32_t db = pixels[i*4+2] - palette[k][2];
+			int32_t distance = dr*dr + dg*dg + db*db;
+			if (distance < best)
+			{
+				best = distance;
+				indices[i] = uint8_t(k);
+			}
+		}
+		error += best;
+	}
+
+	return error;
+}
+
+/**
+ * Opaque blocks always use 4 color mode, blocks with pixels of alpha below 128 use 3 color
+ * mode if punchThrough, else alpha is ignored.
+ */
+void EncodeColorBlock( const uint8_t* pixels, uint8_t* block, bool punchThrough )
+{
+	bool transparent[16];
+	uint32_t numOpaque = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		transparent[i] = punchThrough && pixels[i*4+3] < 128;
+		if (!transparent[i])
+			++numOpaque;
+	}
+
+	if (numOpaque == 0)
+	{
+		// c0 <= c1 selects 3 color mode, index 3 is transparent
+		WriteUInt64(block, 0xFFFFFFFF00000000ULL, 8);
+		return;
+	}
+
+	bool threeColor = numOpaque < 16;
+	const bool* skip = threeColor ? transparent : nullptr;
+
+	float e0[3], e1[3];
+	FitPrincipalAxis(pixels, skip, 3, e0, e1);
+
+	uint32_t bestC0 = 0, bestC1 = 0;
+	uint8_t bestIndices[16];
+	int32_t bestError = INT_MAX;
+
+	for (uint32_t iteration = 0; iteration < 2; ++iteration)
+	{
+		uint32_t c0 = Pack565(e0);
+		uint32_t c1 = Pack565(e1);
+
+		// 4 color mode needs c0 > c1, equal endpoints decode in 3 color mode
+		if (threeColor ? c0 > c1 : c0 < c1)
+			std::swap(c0, c1);
+		bool fourColor = !threeColor && c0 != c1;
+
+		int32_t palette[4][4];
+		BuildColorPalette(c0, c1, fourColor, palette);
+
+		uint8_t indices[16];
+		int32_t error = FindColorIndices(pixels, skip, palette, fourColor ? 4 : 3, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			bestC0 = c0;
+			bestC1 = c1;
+			memcpy(bestIndices, indices, 16);
+		}
+
+		if (error == 0 || !FitEndpoints(pixels, skip, indices, fourColor ? ColorWeights4 : ColorWeights3, 3, e0, e1))
+			break;
+	}
+
+	uint32_t indexBits = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+		indexBits |= uint32_t(bestIndices[i]) << (i * 2);
+
+	WriteUInt64(block, bestC0 | (bestC1 << 16) | (uint64_t(indexBits) << 32), 8);
+}
+
+void DecodeColorBlock( const uint8_t* block, uint8_t* pixels, bool allowThreeColor )
+{
+	uint32_t c0 = block[0] | (block[1] << 8);
+	uint32_t c1 = block[2] | (block[3] << 8);
+
+	int32_t palette[4][4];
+	BuildColorPalette(c0, c1, c0 > c1 || !allowThreeColor, palette);
+
+	uint32_t indexBits = uint32_t(ReadUInt64(block + 4, 4));
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const int32_t* color = palette[(indexBits >> (i * 2)) & 3];
+		for (uint32_t c = 0; c < 4; ++c)
+			pixels[i*4+c] = uint8_t(color[c]);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// BC4 single channel block, also alpha of BC3 and both channels of BC5
+
+void BuildAlphaPalette( int32_t a0, int32_t a1, int32_t palette[8] )
+{
+	palette[0] = a0;
+	palette[1] = a1;
+
+	if (a0 > a1)
+	{
+		for (int32_t i = 2; i < 8; ++i)
+			palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+	}
+	else
+	{
+		for (int32_t i = 2; i < 6; ++i)
+			palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+int32_t FindAlphaIndices( const uint8_t* values, int32_t a0, int32_t a1, uint64_t& indexBits )
+{
+	int32_t palette[8];
+	BuildAlphaPalette(a0, a1, palette);
+
+	int32_t error = 0;
+	indexBits = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		int32_t best = INT_MAX;
+		uint64_t bestIndex = 0;
+		for (uint32_t k = 0; k < 8; ++k)
+		{
+			int32_t d = values[i*4] - palette[k];
+			if (d*d < best)
+			{
+				best = d*d;
+				bestIndex = k;
+			}
+		}
+
+		error += best;
+		indexBits |= bestIndex << (i * 3);
+	}
+
+	return error;
+}
+
+/**
+ * Values are 4 bytes apart. 8 value mode spans min to max, 6 value mode spans the values
+ * between 0 and 255 which it has exactly, the one with lower error is kept.
+ */
+void EncodeAlphaBlock( const uint8_t* values, uint8_t* block )
+{
+	int32_t minValue = 255, maxValue = 0;
+	int32_t innerMin = 255, innerMax = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		int32_t value = values[i*4];
+		minValue = (std::min)(minValue, value);
+		maxValue = (std::max)(maxValue, value);
+		if (value != 0 && value != 255)
+		{
+			innerMin = (std::min)(innerMin, value);
+			innerMax = (std::max)(innerMax, value);
+		}
+	}
+
+	int32_t a0 = maxValue, a1 = minValue;
+	uint64_t indexBits;
+	int32_t error = FindAlphaIndices(values, a0, a1, indexBits);
+
+	if (error > 0 && (minValue == 0 || maxValue == 255))
+	{
+		// Only 0 and 255, any endpoints with a0 <= a1 select 6 value mode
+		if (innerMin > innerMax)
+		{
+			innerMin = 0;
+			innerMax = 255;
+		}
+
+		uint64_t sixIndexBits;
+		int32_t sixError = FindAlphaIndices(values, innerMin, innerMax, sixIndexBits);
+		if (sixError < error)
+		{
+			a0 = innerMin;
+			a1 = innerMax;
+			indexBits = sixIndexBits;
+		}
+	}
+
+	WriteUInt64(block, uint64_t(a0) | (uint64_t(a1) << 8) | (indexBits << 16), 8);
+}
+
+void DecodeAlphaBlock( const uint8_t* block, uint8_t* values )
+{
+	int32_t palette[8];
+	BuildAlphaPalette(block[0], block[1], palette);
+
+	uint64_t indexBits = ReadUInt64(block + 2, 6);
+	for (uint32_t i = 0; i < 16; ++i)
+		values[i*4] = uint8_t(palette[(indexBits >> (i * 3)) & 7]);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// BC2 explicit 4 bit alpha
+
+void EncodeExplicitAlpha( const uint8_t* pixels, uint8_t* block )
+{
+	uint64_t alphaBits = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+		alphaBits |= uint64_t((pixels[i*4+3] * 15 + 127) / 255) << (i * 4);
+
+	WriteUInt64(block, alphaBits, 8);
+}
+
+void DecodeExplicitAlpha( const uint8_t* block, uint8_t* pixels )
+{
+	uint64_t alphaBits = ReadUInt64(block, 8);
+	for (uint32_t i = 0; i < 16; ++i)
+		pixels[i*4+3] = uint8_t(((alphaBits >> (i * 4)) & 15) * 17);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// BC7
+
+struct BC7ModeInfo
+{
+	uint8_t NumSubsets;
+	uint8_t PartitionBits;
+	uint8_t RotationBits;
+	uint8_t IndexSelectionBits;
+	uint8_t ColorBits;
+	uint8_t AlphaBits;
+	uint8_t EndpointPBits;
+	uint8_t SharedPBits;
+	uint8_t IndexBits;
+	uint8_t IndexBits2;
+};
+
+const BC7ModeInfo BC7Modes[8] = {
+	{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+	{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+	{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+	{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+	{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+	{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+	{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+	{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+};
+
+const uint32_t BC7Weights2[4] = { 0, 21, 43, 64 };
+const uint32_t BC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+const uint32_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Subset of each pixel, one bit per pixel for 2 subsets
+const uint16_t BC7Partitions2[64] = {
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+	0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+	0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+	0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+	0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+	0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+	0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+	0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+// Two bits per pixel for 3 subsets
+const uint32_t BC7Partitions3[64] = {
+	0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+	0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+	0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+	0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+	0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+	0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+	0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+	0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+};
+
+// Anchor pixel of subset 1 with 2 subsets, subset 0 is always anchored at pixel 0
+const uint8_t BC7Anchors2[64] = {
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+	15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+	 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+};
+
+// Anchor pixels of subsets 1 and 2 with 3 subsets
+const uint8_t BC7Anchors3a[64] = {
+	 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+	 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+	 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+	 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3
+};
+
+const uint8_t BC7Anchors3b[64] = {
+	15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+	15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+	15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+	15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8
+};
+
+/**
+ * Reads fields of a 128 bit block from the least significant bit.
+ */
+class BlockBitReader
+{
+public:
+	BlockBitReader(const uint8_t* block) : mBlock(block), mPosition(0) { }
+
+	uint32_t Read(uint32_t numBits)
+	{
+		uint32_t value = 0;
+		for (uint32_t i = 0; i < numBits; ++i, ++mPosition)
+			value |= uint32_t((mBlock[mPosition >> 3] >> (mPosition & 7)) & 1) << i;
+		return value;
+	}
+
+private:
+	const uint8_t* mBlock;
+	uint32_t mPosition;
+};
+
+inline int32_t BC7Interpolate( int32_t e0, int32_t e1, uint32_t weight )
+{
+	return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+inline uint32_t BC7Weight( uint32_t indexBits, uint32_t index )
+{
+	return indexBits == 2 ? BC7Weights2[index] : (indexBits == 3 ? BC7Weights3[index] : BC7Weights4[index]);
+}
+
+// Expand an endpoint component with p-bit to 8 bits by replicating high bits
+inline int32_t BC7Expand( uint32_t value, uint32_t numBits )
+{
+	value <<= (8 - numBits);
+	return int32_t(value | (value >> numBits));
+}
+
+void DecodeBC7Block( const uint8_t* block, uint8_t* pixels )
+{
+	uint32_t mode = 0;
+	while (mode < 8 && !(block[0] & (1 << mode)))
+		++mode;
+
+	// Reserved mode decodes to transparent black
+	if (mode == 8)
+	{
+		memset(pixels, 0, 64);
+		return;
+	}
+
+	const BC7ModeInfo& info = BC7Modes[mode];
+	BlockBitReader bits(block);
+	bits.Read(mode + 1);
+
+	uint32_t partition = bits.Read(info.PartitionBits);
+	uint32_t rotation = bits.Read(info.RotationBits);
+	uint32_t indexSelection = bits.Read(info.IndexSelectionBits);
+
+	uint32_t numEndpoints = info.NumSubsets * 2;
+	uint32_t endpoints[6][4];
+
+	for (uint32_t c = 0; c < 3; ++c)
+		for (uint32_t e = 0; e < numEndpoints; ++e)
+			endpoints[e][c] = bits.Read(info.ColorBits);
+
+	for (uint32_t e = 0; e < numEndpoints; ++e)
+		endpoints[e][3] = info.AlphaBits ? bits.Read(info.AlphaBits) : 255;
+
+	// P-bits are the lowest bit of all components of an endpoint, or of both endpoints of a subset
+	uint32_t colorBits = info.ColorBits;
+	uint32_t alphaBits = info.AlphaBits;
+	if (info.EndpointPBits || info.SharedPBits)
+	{
+		uint32_t numPBits = info.EndpointPBits ? numEndpoints : info.NumSubsets;
+		for (uint32_t i = 0; i < numPBits; ++i)
+		{
+			uint32_t pbit = bits.Read(1);
+			uint32_t first = info.EndpointPBits ? i : i * 2;
+			uint32_t last = info.EndpointPBits ? i : i * 2 + 1;
+
+			for (uint32_t e = first; e <= last; ++e)
+			{
+				for (uint32_t c = 0; c < 3; ++c)
+					endpoints[e][c] = (endpoints[e][c] << 1) | pbit;
+				if (alphaBits)
+					endpoints[e][3] = (endpoints[e][3] << 1) | pbit;
+			}
+		}
+
+		colorBits++;
+		if (alphaBits)
+			alphaBits++;
+	}
+
+	int32_t expanded[6][4];
+	for (uint32_t e = 0; e < numEndpoints; ++e)
+	{
+		for (uint32_t c = 0; c < 3; ++c)
+			expanded[e][c] = BC7Expand(endpoints[e][c], colorBits);
+		expanded[e][3] = alphaBits ? BC7Expand(endpoints[e][3], alphaBits) : 255;
+	}
+
+	uint32_t subsets[16];
+	uint32_t anchor1 = 0, anchor2 = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		if (info.NumSubsets == 2)
+			subsets[i] = (BC7Partitions2[partition] >> i) & 1;
+		else if (info.NumSubsets == 3)
+			subsets[i] = (BC7Partitions3[partition] >> (i * 2)) & 3;
+		else
+			subsets[i] = 0;
+	}
+
+	if (info.NumSubsets == 2)
+		anchor1 = BC7Anchors2[partition];
+	else if (info.NumSubsets == 3)
+	{
+		anchor1 = BC7Anchors3a[partition];
+		anchor2 = BC7Anchors3b[partition];
+	}
+
+	// Most significant bit of anchor indices is implicitly 0
+	uint32_t indices[16], indices2[16];
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		bool anchor = (i == 0) || (info.NumSubsets > 1 && i == anchor1) || (info.NumSubsets > 2 && i == anchor2);
+		indices[i] = bits.Read(anchor ? info.IndexBits - 1 : info.IndexBits);
+	}
+
+	if (info.IndexBits2)
+	{
+		for (uint32_t i = 0; i < 16; ++i)
+			indices2[i] = bits.Read(i == 0 ? info.IndexBits2 - 1 : info.IndexBits2);
+	}
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const int32_t* e0 = expanded[subsets[i] * 2];
+		const int32_t* e1 = expanded[subsets[i] * 2 + 1];
+
+		uint32_t colorWeight, alphaWeight;
+		if (info.IndexBits2 == 0)
+			colorWeight = alphaWeight = BC7Weight(info.IndexBits, indices[i]);
+		else if (indexSelection == 0)
+		{
+			colorWeight = BC7Weight(info.IndexBits, indices[i]);
+			alphaWeight = BC7Weight(info.IndexBits2, indices2[i]);
+		}
+		else
+		{
+			colorWeight = BC7Weight(info.IndexBits2, indices2[i]);
+			alphaWeight = BC7Weight(info.IndexBits, indices[i]);
+		}
+
+		uint8_t* pixel = pixels + i * 4;
+		for (uint32_t c = 0; c < 3; ++c)
+			pixel[c] = uint8_t(BC7Interpolate(e0[c], e1[c], colorWeight));
+		pixel[3] = uint8_t(BC7Interpolate(e0[3], e1[3], alphaWeight));
+
+		// Rotation swaps alpha with a color channel
+		if (rotation)
+			std::swap(pixel[3], pixel[rotation - 1]);
+	}
+}
+
+/**
+ * 7 bit components and a p-bit shared by all components of an endpoint, the p-bit with
+ * lower error is picked.
+ */
+void QuantizeMode6Endpoint( const float* value, uint32_t* quantized, uint32_t& pbit )
+{
+	float bestError = FLT_MAX;
+	for (uint32_t p = 0; p < 2; ++p)
+	{
+		uint32_t q[4];
+		float error = 0.0f;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			q[c] = Clamp(int32_t(floorf((value[c] - p) * 0.5f + 0.5f)), 0, 127);
+			float d = float(q[c] * 2 + p) - value[c];
+			error += d * d;
+		}
+
+		if (error < bestError)
+		{
+			bestError = error;
+			pbit = p;
+			memcpy(quantized, q, sizeof(q));
+		}
+	}
+}
+
+int32_t FindMode6Indices( const uint8_t* pixels, const int32_t* e0, const int32_t* e1, uint8_t* indices )
+{
+	int32_t palette[16][4];
+	for (uint32_t k = 0; k < 16; ++k)
+		for (uint32_t c = 0; c < 4; ++c)
+			palette[k][c] = BC7Interpolate(e0[c], e1[c], BC7Weights4[k]);
+
+	int32_t error = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const uint8_t* pixel = pixels + i * 4;
+
+		int32_t best = INT_MAX;
+		for (uint32_t k = 0; k < 16; ++k)
+		{
+			int32_t d0 = pixel[0] - palette[k][0];
+			int32_t d1 = pixel[1] - palette[k][1];
+			int32_t d2 = pixel[2] - palette[k][2];
+			int32_t d3 = pixel[3] - palette[k][3];
+			int32_t distance = d0*d0 + d1*d1 + d2*d2 + d3*d3;
+			if (distance < best)
+			{
+				best = distance;
+				indices[i] = uint8_t(k);
+			}
+		}
+		error += best;
+	}
+
+	return error;
+}
+
+/**
+ * Mode 6, one subset of RGBA endpoints with 4 bit indices. It's the mode that suits most
+ * blocks of a single gradient, other modes would need a search over partitions.
+ */
+void EncodeBC7Block( const uint8_t* pixels, uint8_t* block )
+{
+	float weights[16];
+	for (uint32_t k = 0; k < 16; ++k)
+		weights[k] = BC7Weights4[k] / 64.0f;
+
+	float e0[4], e1[4];
+	FitPrincipalAxis(pixels, nullptr, 4, e0, e1);
+
+	uint32_t bestQuantized[2][4], bestPBits[2];
+	uint8_t bestIndices[16];
+	int32_t bestError = INT_MAX;
+
+	for (uint32_t iteration = 0; iteration < 2; ++iteration)
+	{
+		uint32_t quantized[2][4], pbits[2];
+		QuantizeMode6Endpoint(e0, quantized[0], pbits[0]);
+		QuantizeMode6Endpoint(e1, quantized[1], pbits[1]);
+
+		int32_t endpoint0[4], endpoint1[4];
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			endpoint0[c] = (quantized[0][c] << 1) | pbits[0];
+			endpoint1[c] = (quantized[1][c] << 1) | pbits[1];
+		}
+
+		uint8_t indices[16];
+		int32_t error = FindMode6Indices(pixels, endpoint0, endpoint1, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			memcpy(bestQuantized, quantized, sizeof(quantized));
+			memcpy(bestPBits, pbits, sizeof(pbits));
+			memcpy(bestIndices, indices, 16);
+		}
+
+		if (error == 0 || !FitEndpoints(pixels, nullptr, indices, weights, 4, e0, e1))
+			break;
+	}
+
+	// Anchor index has its most significant bit implied 0, swap endpoints if it's set
+	if (bestIndices[0] >= 8)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+			std::swap(bestQuantized[0][c], bestQuantized[1][c]);
+		std::swap(bestPBits[0], bestPBits[1]);
+
+		for (uint32_t i = 0; i < 16; ++i)
+			bestIndices[i] = uint8_t(15 - bestIndices[i]);
+	}
+
+	// Mode bit, R0 R1 G0 G1 B0 B1 A0 A1, P0 P1, then indices
+	uint64_t low = 1 << 6;
+	uint32_t shift = 7;
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		for (uint32_t e = 0; e < 2; ++e)
+		{
+			low |= uint64_t(bestQuantized[e][c]) << shift;
+			shift += 7;
+		}
+	}
+	low |= uint64_t(bestPBits[0]) << 63;
+
+	uint64_t high = bestPBits[1];
+	high |= uint64_t(bestIndices[0]) << 1;
+	for (uint32_t i = 1; i < 16; ++i)
+		high |= uint64_t(bestIndices[i]) << (i * 4);
+
+	WriteUInt64(block, low, 8);
+	WriteUInt64(block + 8, high, 8);
+}
+
+/**
+ * Run kernel over rows of blocks, split over JobSystem workers if parallel and large enough.
+ */
+void ForEachBlockRow( uint32_t blocksWide, uint32_t blocksHigh, bool parallel, const std::function<void(uint32_t, uint32_t)>& kernel )
+{
+	uint32_t grainSize = (std::max)(1U, BlockGrainSize / (std::max)(1U, blocksWide));
+	if (parallel && blocksHigh > grainSize)
+		JobSystem::GetSingleton().ParallelFor(0, blocksHigh, grainSize, kernel);
+	else
+		kernel(0, blocksHigh);
+}
+
+}
+
+uint32_t BlockCompression::GetBlockBytes( PixelFormat format )
+{
+	switch (GetBlockType(format))
+	{
+	case BT_BC1:
+	case BT_BC1A:
+	case BT_BC4:
+		return 8;
+	case BT_BC2:
+	case BT_BC3:
+	case BT_BC5:
+	case BT_BC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+void BlockCompression::EncodeBlock( PixelFormat format, const uint8_t* pixels, void* block )
+{
+	uint8_t* dest = static_cast<uint8_t*>(block);
+
+	switch (GetBlockType(format))
+	{
+	case BT_BC1:
+		EncodeColorBlock(pixels, dest, false);
+		break;
+	case BT_BC1A:
+		EncodeColorBlock(pixels, dest, true);
+		break;
+	case BT_BC2:
+		EncodeExplicitAlpha(pixels, dest);
+		EncodeColorBlock(pixels, dest + 8, false);
+		break;
+	case BT_BC3:
+		EncodeAlphaBlock(pixels + 3, dest);
+		EncodeColorBlock(pixels, dest + 8, false);
+		break;
+	case BT_BC4:
+		EncodeAlphaBlock(pixels, dest);
+		break;
+	case BT_BC5:
+		EncodeAlphaBlock(pixels, dest);
+		EncodeAlphaBlock(pixels + 1, dest + 8);
+		break;
+	case BT_BC7:
+		EncodeBC7Block(pixels, dest);
+		break;
+	default:
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported block compressed format", "BlockCompression::EncodeBlock");
+	}
+}
+
+void BlockCompression::DecodeBlock( PixelFormat format, const void* block, uint8_t* pixels )
+{
+	const uint8_t* src = static_cast<const uint8_t*>(block);
+
+	switch (GetBlockType(format))
+	{
+	case BT_BC1:
+	case BT_BC1A:
+		DecodeColorBlock(src, pixels, true);
+		break;
+	case BT_BC2:
+		DecodeColorBlock(src + 8, pixels, false);
+		DecodeExplicitAlpha(src, pixels);
+		break;
+	case BT_BC3:
+		DecodeColorBlock(src + 8, pixels, false);
+		DecodeAlphaBlock(src, pixels + 3);
+		break;
+	case BT_BC4:
+	case BT_BC5:
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			pixels[i*4+1] = pixels[i*4+2] = 0;
+			pixels[i*4+3] = 255;
+		}
+		DecodeAlphaBlock(src, pixels);
+		if (GetBlockType(format) == BT_BC5)
+			DecodeAlphaBlock(src + 8, pixels + 1);
+		break;
+	case BT_BC7:
+		DecodeBC7Block(src, pixels);
+		break;
+	default:
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported block compressed format", "BlockCompression::DecodeBlock");
+	}
+}
+
+void BlockCompression::Encode( PixelFormat format, const uint8_t* pixels, uint32_t rowPitch, uint32_t width, uint32_t height,
+	                           void* blocks, uint32_t blockRowPitch, bool parallel )
+{
+	uint32_t blockBytes = GetBlockBytes(format);
+	if (blockBytes == 0)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported block compressed format", "BlockCompression::Encode");
+
+	uint32_t blocksWide = (width + 3) / 4;
+	uint32_t blocksHigh = (height + 3) / 4;
+
+	ForEachBlockRow(blocksWide, blocksHigh, parallel, [&](uint32_t begin, uint32_t end) {
+		uint8_t blockPixels[64];
+		for (uint32_t by = begin; by < end; ++by)
+		{
+			uint8_t* dest = static_cast<uint8_t*>(blocks) + by * blockRowPitch;
+			for (uint32_t bx = 0; bx < blocksWide; ++bx)
+			{
+				for (uint32_t y = 0; y < 4; ++y)
+				{
+					const uint8_t* row = pixels + (std::min)(by * 4 + y, height - 1) * rowPitch;
+					for (uint32_t x = 0; x < 4; ++x)
+						memcpy(blockPixels + (y * 4 + x) * 4, row + (std::min)(bx * 4 + x, width - 1) * 4, 4);
+				}
+
+				EncodeBlock(format, blockPixels, dest + bx * blockBytes);
+			}
+		}
+	});
+}
+
+void BlockCompression::Decode( PixelFormat format, const void* blocks, uint32_t blockRowPitch, uint32_t width, uint32_t height,
+	                           uint8_t* pixels, uint32_t rowPitch, bool parallel )
+{
+	uint32_t blockBytes = GetBlockBytes(format);
+	if (blockBytes == 0)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported block compressed format", "BlockCompression::Decode");
+
+	uint32_t blocksWide = (width + 3) / 4;
+	uint32_t blocksHigh = (height + 3) / 4;
+
+	ForEachBlockRow(blocksWide, blocksHigh, parallel, [&](uint32_t begin, uint32_t end) {
+		uint8_t blockPixels[64];
+		for (uint32_t by = begin; by < end; ++by)
+		{
+			const uint8_t* src = static_cast<const uint8_t*>(blocks) + by * blockRowPitch;
+			for (uint32_t bx = 0; bx < blocksWide; ++bx)
+			{
+				DecodeBlock(format, src + bx * blockBytes, blockPixels);
+
+				uint32_t numColumns = (std::min)(4U, width - bx * 4);
+				uint32_t numRows = (std::min)(4U, height - by * 4);
+				for (uint32_t y = 0; y < numRows; ++y)
+					memcpy(pixels + (by * 4 + y) * rowPitch + bx * 16, blockPixels + y * 16, numColumns * 4);
+			}
+		}
+	});
+}
+
+} // Namespace RcEngine
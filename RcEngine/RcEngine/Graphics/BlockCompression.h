@@ -0,0 +1,49 @@
+#ifndef BlockCompression_h__
+#define BlockCompression_h__
+
+#include <Core/Prerequisites.h>
+#include <Graphics/PixelFormat.h>
+
+namespace RcEngine {
+
+/**
+ * CPU encoders and decoders of 4x4 block compressed formats: BC1 (DXT1), BC2 (DXT3),
+ * BC3 (DXT5), BC4 and BC5 unsigned, BC7, with their sRGB variants. Pixels are RGBA8 in
+ * row order; BC4 and BC5 read and write red and green, blue is 0 and alpha 255 when decoded
+ * like a sampler returns them.
+ *
+ * Encoders fit endpoints along the principal axis of a block and refine them once by least
+ * squares, fast enough for a cooker, not as good as an exhaustive search. BC7 blocks are
+ * encoded in mode 6 only, all modes are decoded.
+ */
+class _ApiExport BlockCompression
+{
+public:
+	/**
+	 * Bytes of a 4x4 block, 0 if format isn't one of the formats above.
+	 */
+	static uint32_t GetBlockBytes(PixelFormat format);
+
+	static bool IsSupported(PixelFormat format)		{ return GetBlockBytes(format) != 0; }
+
+	/**
+	 * Encode or decode one block of 16 RGBA8 pixels.
+	 */
+	static void EncodeBlock(PixelFormat format, const uint8_t* pixels, void* block);
+	static void DecodeBlock(PixelFormat format, const void* block, uint8_t* pixels);
+
+	/**
+	 * Encode a surface of RGBA8 pixels, rows rowPitch bytes apart, into rows of blocks
+	 * blockRowPitch bytes apart. Edge pixels are repeated to fill partial blocks. Rows of
+	 * blocks are split over JobSystem workers if parallel.
+	 */
+	static void Encode(PixelFormat format, const uint8_t* pixels, uint32_t rowPitch, uint32_t width, uint32_t height,
+		void* blocks, uint32_t blockRowPitch, bool parallel = true);
+
+	static void Decode(PixelFormat format, const void* blocks, uint32_t blockRowPitch, uint32_t width, uint32_t height,
+		uint8_t* pixels, uint32_t rowPitch, bool parallel = true);
+};
+
+} // Namespace RcEngine
+
+#endif // BlockCompression_h__
@@ -99,6 +99,22 @@ bool Camera::Visible( const BoundingBoxf& box ) const
 	return true;
 }
 
+float Camera::GetProjectedScreenSize( const BoundingBoxf& box, float* oDistance ) const
+{
+	float radius = Length(box.Max - box.Min) * 0.5f;
+	float distance = Length(box.Center() - mPosition);
+
+	if (oDistance)
+		*oDistance = distance;
+
+	// M34 is zero for ortho projection
+	float screenSize = radius * mProjMatrix.M22;
+	if (mProjMatrix.M34 != 0.0f)
+		screenSize /= (std::max)(distance, mNearPlane);
+
+	return screenSize;
+}
+
 
 
 } // Namespace RcEngine
\ No newline at end of file
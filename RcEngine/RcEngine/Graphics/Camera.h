@@ -34,6 +34,12 @@ public:
 	bool Visible( const BoundingSpheref& sphere ) const;
 	bool Visible( const BoundingBoxf& box ) const;
 
+	/**
+	 * Fraction of screen height covered by bounding sphere of box, distance is from camera
+	 * to box center. Orthographic projection ignores distance.
+	 */
+	float GetProjectedScreenSize( const BoundingBoxf& box, float* oDistance = nullptr ) const;
+
 public_internal:
 	const float4x4& GetEngineProjMatrix() const			{ return mEngineProjMatrix; }
 	const float4x4& GetEngineViewProjMatrix() const     { return mEngineViewProjMatrix; }
@@ -396,10 +396,11 @@ void CascadedShadowMap::MakeCascadedShadowMap(const Light& light)
 			RenderQueue::BucketOpaque | RenderQueue::BucketTransparent, SceneObject::NoCastShadow);
 
 		const RenderBucket& opaqueBucket = sceneMan->GetRenderQueue().GetRenderBucket(RenderQueue::BucketOpaque);
-		for (const RenderQueueItem& renderItem : opaqueBucket) 
+		mInstanceBatcher.BuildBatches(opaqueBucket);
+		for (const InstanceBatch& batch : mInstanceBatcher.GetBatches()) 
 		{
-			renderItem.Renderable->GetMaterial()->SetCurrentTechnique(mShadowMapTech);
-			renderItem.Renderable->Render();
+			batch.Items[0].Renderable->GetMaterial()->SetCurrentTechnique(mShadowMapTech);
+			mInstanceBatcher.Render(batch);
 		}
 	}
 	
@@ -648,10 +649,11 @@ void CascadedShadowMap::MakeSpotShadowMap( const Light& light )
 	mShadowFrameBuffer->Clear(CF_Depth, ColorRGBA::Black, 1.0, 0);
 
 	const RenderBucket& opaqueBucket = sceneMan->GetRenderQueue().GetRenderBucket(RenderQueue::BucketOpaque);	
-	for (const RenderQueueItem& renderItem : opaqueBucket) 
+	mInstanceBatcher.BuildBatches(opaqueBucket);
+	for (const InstanceBatch& batch : mInstanceBatcher.GetBatches()) 
 	{
-		renderItem.Renderable->GetMaterial()->SetCurrentTechnique(shadowMapTech);
-		renderItem.Renderable->Render();
+		batch.Items[0].Renderable->GetMaterial()->SetCurrentTechnique(shadowMapTech);
+		mInstanceBatcher.Render(batch);
 	}
 
 	// Save ShadowMatrix
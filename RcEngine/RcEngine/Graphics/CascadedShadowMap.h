@@ -3,6 +3,7 @@
 
 #include <Core/Prerequisites.h>
 #include <Graphics/RenderOperation.h>
+#include <Graphics/InstanceBatcher.h>
 #include <Math/Matrix.h>
 
 namespace RcEngine {
@@ -58,6 +59,9 @@ private:
 	// FSQuad
 	RenderOperation mFSQuadRop;
 
+	// Own instance stream, shadow maps are drawn while forward path batches are in use
+	InstanceBatcher mInstanceBatcher;
+
 public:
 
 	ShadowMapFilter mShadowMapFilter;
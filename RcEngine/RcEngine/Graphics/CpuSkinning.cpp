@@ -0,0 +1,531 @@
+#include <Graphics/CpuSkinning.h>
+#include <Graphics/VertexDeclaration.h>
+#include <Graphics/GraphicsResource.h>
+#include <Core/JobSystem.h>
+#include <Core/CpuInfo.h>
+#include <Core/Exception.h>
+#include <emmintrin.h>
+
+#if defined(_MSC_VER)
+#	include <immintrin.h>
+#	define ENGINE_HAS_AVX_PATH
+#	define ENGINE_TARGET_AVX
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#	include <immintrin.h>
+#	define ENGINE_HAS_AVX_PATH
+#	define ENGINE_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace RcEngine {
+
+namespace {
+
+// Vertices per job, a vertex is a few dozen multiply-adds
+const uint32_t VertexGrainSize = 2048;
+
+CpuSkinning::CodePath gCodePath = CpuSkinning::Path_Auto;
+
+float ReadComponent( const uint8_t* element, VertexElementFormat format, uint32_t component )
+{
+	switch (format)
+	{
+	case VEF_Float: case VEF_Float2: case VEF_Float3: case VEF_Float4:
+		return reinterpret_cast<const float*>(element)[component];
+	case VEF_Int: case VEF_Int2: case VEF_Int3: case VEF_Int4:
+		return (float)reinterpret_cast<const int32_t*>(element)[component];
+	case VEF_UInt: case VEF_UInt2: case VEF_UInt3: case VEF_UInt4:
+		return (float)reinterpret_cast<const uint32_t*>(element)[component];
+	default:
+		return 0.0f;
+	}
+}
+
+inline uint8_t* Advance( float* ptr, uint32_t bytes )
+{
+	return reinterpret_cast<uint8_t*>(ptr) + bytes;
+}
+
+inline void Store3( float* dest, const float* value )
+{
+	dest[0] = value[0];
+	dest[1] = value[1];
+	dest[2] = value[2];
+}
+
+inline void StoreNormal( float* dest, float x, float y, float z )
+{
+	float lengthSq = x*x + y*y + z*z;
+	float invLength = lengthSq > 0.0f ? 1.0f / sqrtf(lengthSq) : 0.0f;
+
+	dest[0] = x * invLength;
+	dest[1] = y * invLength;
+	dest[2] = z * invLength;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Linear blend, v' = v * sum(weight * matrix), row vectors
+
+/**
+ * Scalar reference, only the 4x3 affine part of matrices is blended.
+ */
+void SkinLinearScalar( const float* positions, const float* normals, const float* weights,
+	                   const uint32_t* indices, const float4x4* skinMatrices, const SkinningTarget& target, uint32_t begin, uint32_t end )
+{
+	for (uint32_t v = begin; v < end; ++v)
+	{
+		float blended[12] = { 0 };
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			const float w = weights[v*4+i];
+			const float* m = skinMatrices[indices[v*4+i]].Elements;
+			for (uint32_t row = 0; row < 4; ++row)
+			{
+				blended[row*3+0] += m[row*4+0] * w;
+				blended[row*3+1] += m[row*4+1] * w;
+				blended[row*3+2] += m[row*4+2] * w;
+			}
+		}
+
+		const float* p = &positions[v*4];
+		float result[3];
+		for (uint32_t k = 0; k < 3; ++k)
+			result[k] = p[0] * blended[k] + p[1] * blended[3+k] + p[2] * blended[6+k] + blended[9+k];
+		Store3((float*)Advance(target.Positions, v * target.Stride), result);
+
+		if (normals)
+		{
+			const float* n = &normals[v*4];
+			for (uint32_t k = 0; k < 3; ++k)
+				result[k] = n[0] * blended[k] + n[1] * blended[3+k] + n[2] * blended[6+k];
+			StoreNormal((float*)Advance(target.Normals, v * target.Stride), result[0], result[1], result[2]);
+		}
+	}
+}
+
+void SkinLinearSSE( const float* positions, const float* normals, const float* weights,
+	                const uint32_t* indices, const float4x4* skinMatrices, const SkinningTarget& target, uint32_t begin, uint32_t end )
+{
+	float result[4];
+
+	for (uint32_t v = begin; v < end; ++v)
+	{
+		__m128 row0 = _mm_setzero_ps(), row1 = row0, row2 = row0, row3 = row0;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			const __m128 w = _mm_set1_ps(weights[v*4+i]);
+			const float* m = skinMatrices[indices[v*4+i]].Elements;
+
+			row0 = _mm_add_ps(row0, _mm_mul_ps(_mm_loadu_ps(m), w));
+			row1 = _mm_add_ps(row1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+			row2 = _mm_add_ps(row2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+			row3 = _mm_add_ps(row3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+		}
+
+		const float* p = &positions[v*4];
+		__m128 pos = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), row0), _mm_mul_ps(_mm_set1_ps(p[1]), row1));
+		pos = _mm_add_ps(pos, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[2]), row2), row3));
+		_mm_storeu_ps(result, pos);
+		Store3((float*)Advance(target.Positions, v * target.Stride), result);
+
+		if (normals)
+		{
+			const float* n = &normals[v*4];
+			__m128 nrm = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(n[0]), row0), _mm_mul_ps(_mm_set1_ps(n[1]), row1));
+			nrm = _mm_add_ps(nrm, _mm_mul_ps(_mm_set1_ps(n[2]), row2));
+			_mm_storeu_ps(result, nrm);
+			StoreNormal((float*)Advance(target.Normals, v * target.Stride), result[0], result[1], result[2]);
+		}
+	}
+}
+
+#ifdef ENGINE_HAS_AVX_PATH
+
+/**
+ * Two matrix rows per register, blending a vertex takes half the instructions of SSE.
+ */
+ENGINE_TARGET_AVX
+void SkinLinearAVX( const float* positions, const float* normals, const float* weights,
+	                const uint32_t* indices, const float4x4* skinMatrices, const SkinningTarget& target, uint32_t begin, uint32_t end )
+{
+	float result[4];
+
+	for (uint32_t v = begin; v < end; ++v)
+	{
+		__m256 rows01 = _mm256_setzero_ps(), rows23 = rows01;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			const __m256 w = _mm256_broadcast_ss(&weights[v*4+i]);
+			const float* m = skinMatrices[indices[v*4+i]].Elements;
+
+			rows01 = _mm256_add_ps(rows01, _mm256_mul_ps(_mm256_loadu_ps(m), w));
+			rows23 = _mm256_add_ps(rows23, _mm256_mul_ps(_mm256_loadu_ps(m + 8), w));
+		}
+
+		// (x, x, x, x, y, y, y, y) * rows01 + (z, z, z, z, 1, 1, 1, 1) * rows23
+		const float* p = &positions[v*4];
+		__m256 xy = _mm256_set_m128(_mm_set1_ps(p[1]), _mm_set1_ps(p[0]));
+		__m256 z1 = _mm256_set_m128(_mm_set1_ps(1.0f), _mm_set1_ps(p[2]));
+		__m256 sum = _mm256_add_ps(_mm256_mul_ps(xy, rows01), _mm256_mul_ps(z1, rows23));
+		_mm_storeu_ps(result, _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+		Store3((float*)Advance(target.Positions, v * target.Stride), result);
+
+		if (normals)
+		{
+			const float* n = &normals[v*4];
+			xy = _mm256_set_m128(_mm_set1_ps(n[1]), _mm_set1_ps(n[0]));
+			z1 = _mm256_set_m128(_mm_setzero_ps(), _mm_set1_ps(n[2]));
+			sum = _mm256_add_ps(_mm256_mul_ps(xy, rows01), _mm256_mul_ps(z1, rows23));
+			_mm_storeu_ps(result, _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+			StoreNormal((float*)Advance(target.Normals, v * target.Stride), result[0], result[1], result[2]);
+		}
+	}
+
+	_mm256_zeroupper();
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Dual quaternion, (x, y, z, w) real part then (x, y, z, w) dual part
+
+/**
+ * Rigid part of a row vector skin matrix as unit dual quaternion.
+ */
+void MatrixToDualQuaternion( const float4x4& matrix, float* dq )
+{
+	// Column vector rotation R(i,j) is row vector M(j,i)
+	const float* m = matrix.Elements;
+	#define R(i, j) m[(j)*4+(i)]
+
+	float x, y, z, w;
+	float trace = R(0,0) + R(1,1) + R(2,2);
+	if (trace > 0.0f)
+	{
+		float s = 0.5f / sqrtf(trace + 1.0f);
+		w = 0.25f / s;
+		x = (R(2,1) - R(1,2)) * s;
+		y = (R(0,2) - R(2,0)) * s;
+		z = (R(1,0) - R(0,1)) * s;
+	}
+	else if (R(0,0) > R(1,1) && R(0,0) > R(2,2))
+	{
+		float s = 2.0f * sqrtf(1.0f + R(0,0) - R(1,1) - R(2,2));
+		w = (R(2,1) - R(1,2)) / s;
+		x = 0.25f * s;
+		y = (R(0,1) + R(1,0)) / s;
+		z = (R(0,2) + R(2,0)) / s;
+	}
+	else if (R(1,1) > R(2,2))
+	{
+		float s = 2.0f * sqrtf(1.0f + R(1,1) - R(0,0) - R(2,2));
+		w = (R(0,2) - R(2,0)) / s;
+		x = (R(0,1) + R(1,0)) / s;
+		y = 0.25f * s;
+		z = (R(1,2) + R(2,1)) / s;
+	}
+	else
+	{
+		float s = 2.0f * sqrtf(1.0f + R(2,2) - R(0,0) - R(1,1));
+		w = (R(1,0) - R(0,1)) / s;
+		x = (R(0,2) + R(2,0)) / s;
+		y = (R(1,2) + R(2,1)) / s;
+		z = 0.25f * s;
+	}
+
+	#undef R
+
+	float invLength = 1.0f / sqrtf(x*x + y*y + z*z + w*w);
+	x *= invLength; y *= invLength; z *= invLength; w *= invLength;
+
+	// Dual part is translation * real / 2
+	float tx = m[12], ty = m[13], tz = m[14];
+	dq[0] = x; dq[1] = y; dq[2] = z; dq[3] = w;
+	dq[4] = 0.5f * ( tx*w + ty*z - tz*y);
+	dq[5] = 0.5f * (-tx*z + ty*w + tz*x);
+	dq[6] = 0.5f * ( tx*y - ty*x + tz*w);
+	dq[7] = 0.5f * (-tx*x - ty*y - tz*z);
+}
+
+/**
+ * Normalize blended dual quaternion and transform position and normal.
+ */
+inline void TransformDualQuaternion( const float* dq, const float* position, const float* normal, float* outPosition, float* outNormal )
+{
+	float invLength = 1.0f / sqrtf(dq[0]*dq[0] + dq[1]*dq[1] + dq[2]*dq[2] + dq[3]*dq[3]);
+
+	float rx = dq[0] * invLength, ry = dq[1] * invLength, rz = dq[2] * invLength, rw = dq[3] * invLength;
+	float dx = dq[4] * invLength, dy = dq[5] * invLength, dz = dq[6] * invLength, dw = dq[7] * invLength;
+
+	// Translation is 2 * dual * conjugate(real)
+	float tx = 2.0f * (rw*dx - dw*rx + ry*dz - rz*dy);
+	float ty = 2.0f * (rw*dy - dw*ry + rz*dx - rx*dz);
+	float tz = 2.0f * (rw*dz - dw*rz + rx*dy - ry*dx);
+
+	// v + 2w(r x v) + 2r x (r x v)
+	float cx = ry*position[2] - rz*position[1];
+	float cy = rz*position[0] - rx*position[2];
+	float cz = rx*position[1] - ry*position[0];
+	outPosition[0] = position[0] + 2.0f * (rw*cx + ry*cz - rz*cy) + tx;
+	outPosition[1] = position[1] + 2.0f * (rw*cy + rz*cx - rx*cz) + ty;
+	outPosition[2] = position[2] + 2.0f * (rw*cz + rx*cy - ry*cx) + tz;
+
+	if (normal)
+	{
+		cx = ry*normal[2] - rz*normal[1];
+		cy = rz*normal[0] - rx*normal[2];
+		cz = rx*normal[1] - ry*normal[0];
+		StoreNormal(outNormal,
+			normal[0] + 2.0f * (rw*cx + ry*cz - rz*cy),
+			normal[1] + 2.0f * (rw*cy + rz*cx - rx*cz),
+			normal[2] + 2.0f * (rw*cz + rx*cy - ry*cx));
+	}
+}
+
+void SkinDualQuaternionScalar( const float* positions, const float* normals, const float* weights,
+	                           const uint32_t* indices, const float* dualQuats, const SkinningTarget& target, uint32_t begin, uint32_t end )
+{
+	for (uint32_t v = begin; v < end; ++v)
+	{
+		const float* first = &dualQuats[indices[v*4] * 8];
+
+		float blended[8] = { 0 };
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			const float* dq = &dualQuats[indices[v*4+i] * 8];
+
+			// Blend in the hemisphere of the first influence
+			float w = weights[v*4+i];
+			if (dq[0]*first[0] + dq[1]*first[1] + dq[2]*first[2] + dq[3]*first[3] < 0.0f)
+				w = -w;
+
+			for (uint32_t k = 0; k < 8; ++k)
+				blended[k] += dq[k] * w;
+		}
+
+		float result[3];
+		float* outNormal = normals ? (float*)Advance(target.Normals, v * target.Stride) : nullptr;
+		TransformDualQuaternion(blended, &positions[v*4], normals ? &normals[v*4] : nullptr, result, outNormal);
+		Store3((float*)Advance(target.Positions, v * target.Stride), result);
+	}
+}
+
+void SkinDualQuaternionSSE( const float* positions, const float* normals, const float* weights,
+	                        const uint32_t* indices, const float* dualQuats, const SkinningTarget& target, uint32_t begin, uint32_t end )
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+
+	float blended[8];
+	float result[3];
+
+	for (uint32_t v = begin; v < end; ++v)
+	{
+		const __m128 first = _mm_loadu_ps(&dualQuats[indices[v*4] * 8]);
+
+		__m128 real = zero, dual = zero;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			const float* dq = &dualQuats[indices[v*4+i] * 8];
+			__m128 dqReal = _mm_loadu_ps(dq);
+
+			// Horizontal dot product, sign flips weight into the first influence's hemisphere
+			__m128 dot = _mm_mul_ps(dqReal, first);
+			dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(1, 0, 3, 2)));
+			dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			__m128 w = _mm_xor_ps(_mm_set1_ps(weights[v*4+i]), _mm_and_ps(_mm_cmplt_ps(dot, zero), signBit));
+
+			real = _mm_add_ps(real, _mm_mul_ps(dqReal, w));
+			dual = _mm_add_ps(dual, _mm_mul_ps(_mm_loadu_ps(dq + 4), w));
+		}
+
+		_mm_storeu_ps(blended, real);
+		_mm_storeu_ps(blended + 4, dual);
+
+		float* outNormal = normals ? (float*)Advance(target.Normals, v * target.Stride) : nullptr;
+		TransformDualQuaternion(blended, &positions[v*4], normals ? &normals[v*4] : nullptr, result, outNormal);
+		Store3((float*)Advance(target.Positions, v * target.Stride), result);
+	}
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////
+SkinningSource::SkinningSource( const VertexDeclaration& vertexDecl, const void* vertexData, uint32_t vertexCount )
+	: mVertexCount(vertexCount),
+	  mNumBonesUsed(0)
+{
+	const VertexElement* positionElem = nullptr;
+	const VertexElement* normalElem = nullptr;
+	const VertexElement* weightElem = nullptr;
+	const VertexElement* indexElem = nullptr;
+
+	for (const VertexElement& element : vertexDecl.GetVertexElements())
+	{
+		if (element.UsageIndex != 0)
+			continue;
+
+		switch (element.Usage)
+		{
+		case VEU_Position:		positionElem = &element; break;
+		case VEU_Normal:		normalElem = &element; break;
+		case VEU_BlendWeight:	weightElem = &element; break;
+		case VEU_BlendIndices:	indexElem = &element; break;
+		default: break;
+		}
+	}
+
+	if (!positionElem || !weightElem || !indexElem)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Vertex buffer has no position, blend weights or blend indices", "SkinningSource::SkinningSource");
+
+	uint32_t numIndices = (std::min)(VertexElementUtil::GetElementComponentCount(*indexElem), 4U);
+	uint32_t numWeights = (std::min)(VertexElementUtil::GetElementComponentCount(*weightElem), numIndices);
+
+	const uint32_t stride = vertexDecl.GetVertexSize();
+	const uint8_t* vertex = static_cast<const uint8_t*>(vertexData);
+
+	mPositions.resize(vertexCount * 4);
+	mWeights.resize(vertexCount * 4);
+	mIndices.resize(vertexCount * 4);
+	if (normalElem)
+		mNormals.resize(vertexCount * 4);
+
+	for (uint32_t v = 0; v < vertexCount; ++v, vertex += stride)
+	{
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			mPositions[v*4+k] = ReadComponent(vertex + positionElem->Offset, positionElem->Type, k);
+			if (normalElem)
+				mNormals[v*4+k] = ReadComponent(vertex + normalElem->Offset, normalElem->Type, k);
+		}
+
+		// Unused influences have index 0 and weight 0, so kernels always blend four
+		float weightSum = 0.0f;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			float weight = 0.0f;
+			uint32_t index = 0;
+
+			if (i < numIndices)
+			{
+				index = (uint32_t)ReadComponent(vertex + indexElem->Offset, indexElem->Type, i);
+				weight = (i < numWeights) ? ReadComponent(vertex + weightElem->Offset, weightElem->Type, i) : 1.0f - weightSum;
+			}
+
+			mWeights[v*4+i] = weight;
+			mIndices[v*4+i] = index;
+			weightSum += weight;
+
+			if (weight != 0.0f)
+				mNumBonesUsed = (std::max)(mNumBonesUsed, index + 1);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CpuSkinning::Skin( const SkinningSource& source, const float4x4* skinMatrices, uint32_t numSkinMatrices, const SkinningTarget& target,
+	                    SkinningMethod method, uint32_t firstVertex, uint32_t numVertices, bool parallel )
+{
+	// Nothing to skin with, kernels index the palette
+	if (numVertices == 0 || numSkinMatrices == 0)
+		return;
+
+	assert(firstVertex + numVertices <= source.GetVertexCount());
+	assert(numSkinMatrices >= source.GetNumBonesUsed());
+
+	const float* positions = &source.mPositions[0];
+	const float* normals = (target.Normals && source.HasNormals()) ? &source.mNormals[0] : nullptr;
+	const float* weights = &source.mWeights[0];
+	const uint32_t* indices = &source.mIndices[0];
+
+	CodePath path = gCodePath;
+	if (path == Path_Auto)
+		path = CpuInfo::HasAVX() ? Path_AVX : (CpuInfo::HasSSE2() ? Path_SSE : Path_Scalar);
+	if (path == Path_AVX && !CpuInfo::HasAVX())
+		path = Path_Scalar;
+	if (path == Path_SSE && !CpuInfo::HasSSE2())
+		path = Path_Scalar;
+
+	std::function<void(uint32_t, uint32_t)> kernel;
+	vector<float> dualQuats;
+
+	if (method == SM_LinearBlend)
+	{
+		auto linearKernel = &SkinLinearScalar;
+		if (path == Path_SSE)
+			linearKernel = &SkinLinearSSE;
+#ifdef ENGINE_HAS_AVX_PATH
+		else if (path == Path_AVX)
+			linearKernel = &SkinLinearAVX;
+#endif
+
+		// Kernel pointer goes out of scope before the lambda runs, capture it by value
+		kernel = [&, linearKernel](uint32_t begin, uint32_t end) {
+			linearKernel(positions, normals, weights, indices, skinMatrices, target, begin, end);
+		};
+	}
+	else
+	{
+		// Converted once per call, there are far fewer bones than vertices
+		dualQuats.resize(numSkinMatrices * 8);
+		for (uint32_t i = 0; i < numSkinMatrices; ++i)
+			MatrixToDualQuaternion(skinMatrices[i], &dualQuats[i*8]);
+
+		auto dualQuatKernel = (path == Path_Scalar) ? &SkinDualQuaternionScalar : &SkinDualQuaternionSSE;
+		const float* dq = &dualQuats[0];
+
+		kernel = [&, dq, dualQuatKernel](uint32_t begin, uint32_t end) {
+			dualQuatKernel(positions, normals, weights, indices, dq, target, begin, end);
+		};
+	}
+
+	uint32_t end = firstVertex + numVertices;
+	if (parallel && numVertices > VertexGrainSize)
+		JobSystem::GetSingleton().ParallelFor(firstVertex, end, VertexGrainSize, kernel);
+	else
+		kernel(firstVertex, end);
+}
+
+void CpuSkinning::SkinToBuffer( const SkinningSource& source, const float4x4* skinMatrices, uint32_t numSkinMatrices,
+	                            GraphicsBuffer& buffer, const VertexDeclaration& vertexDecl, SkinningMethod method )
+{
+	SkinningTarget target = { nullptr, nullptr, vertexDecl.GetVertexSize() };
+
+	int32_t positionOffset = -1, normalOffset = -1;
+	for (const VertexElement& element : vertexDecl.GetVertexElements())
+	{
+		if (element.UsageIndex != 0)
+			continue;
+
+		if (element.Usage == VEU_Position)
+			positionOffset = element.Offset;
+		else if (element.Usage == VEU_Normal)
+			normalOffset = element.Offset;
+	}
+
+	if (positionOffset < 0)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Skinned vertex buffer has no position", "CpuSkinning::SkinToBuffer");
+
+	uint32_t size = target.Stride * source.GetVertexCount();
+	uint8_t* data = static_cast<uint8_t*>(buffer.Map(0, size, RMA_Write_Discard));
+
+	target.Positions = reinterpret_cast<float*>(data + positionOffset);
+	if (normalOffset >= 0)
+		target.Normals = reinterpret_cast<float*>(data + normalOffset);
+
+	Skin(source, skinMatrices, numSkinMatrices, target, method, 0, source.GetVertexCount());
+
+	buffer.UnMap();
+}
+
+void CpuSkinning::SetCodePath( CodePath path )
+{
+	gCodePath = path;
+}
+
+CpuSkinning::CodePath CpuSkinning::GetCodePath()
+{
+	return gCodePath;
+}
+
+} // Namespace RcEngine
@@ -0,0 +1,106 @@
+#ifndef CpuSkinning_h__
+#define CpuSkinning_h__
+
+#include <Core/Prerequisites.h>
+#include <Math/Matrix.h>
+
+namespace RcEngine {
+
+class VertexDeclaration;
+class GraphicsBuffer;
+
+enum SkinningMethod
+{
+	SM_LinearBlend,
+
+	// No candy wrapper artifacts on twisting joints, but skin matrices must be rigid, scale
+	// is ignored
+	SM_DualQuaternion
+};
+
+/**
+ * Positions, normals, blend indices and weights of a skinned vertex buffer, repacked once
+ * for CPU skinning. Elements are found by usage in the vertex declaration, up to four
+ * influences per vertex. If weights have one component less than indices, the last weight
+ * is one minus the others.
+ */
+class _ApiExport SkinningSource
+{
+public:
+	SkinningSource(const VertexDeclaration& vertexDecl, const void* vertexData, uint32_t vertexCount);
+
+	uint32_t GetVertexCount() const			{ return mVertexCount; }
+	bool HasNormals() const					{ return !mNormals.empty(); }
+
+	/**
+	 * Number of skin matrices referenced by blend indices.
+	 */
+	uint32_t GetNumBonesUsed() const		{ return mNumBonesUsed; }
+
+private:
+	friend class CpuSkinning;
+
+	uint32_t mVertexCount;
+	uint32_t mNumBonesUsed;
+
+	// Four floats or indices per vertex, w of positions and normals is unused
+	vector<float> mPositions;
+	vector<float> mNormals;
+	vector<float> mWeights;
+	vector<uint32_t> mIndices;
+};
+
+/**
+ * Where skinned vertices are written. Positions and Normals point to the first vertex and
+ * advance by Stride bytes, so output can be float3 arrays or an interleaved vertex buffer.
+ * Normals may be null.
+ */
+struct _ApiExport SkinningTarget
+{
+	float* Positions;
+	float* Normals;
+	uint32_t Stride;
+};
+
+/**
+ * Skins vertices on the CPU, for physics, picking, shadow caster bounds and builds without
+ * a GPU. Skin matrices are the ones AnimationPlayer writes for the shader, offset * model.
+ * Linear blend has scalar, SSE and AVX paths, dual quaternion scalar and SSE, picked at
+ * runtime by CpuInfo.
+ */
+class _ApiExport CpuSkinning
+{
+public:
+	enum CodePath
+	{
+		Path_Auto,
+		Path_Scalar,
+		Path_SSE,
+		Path_AVX
+	};
+
+public:
+	/**
+	 * Skin vertices [firstVertex, firstVertex + numVertices) of source into the same vertices
+	 * of target. Large ranges are split over JobSystem workers if parallel.
+	 */
+	static void Skin(const SkinningSource& source, const float4x4* skinMatrices, uint32_t numSkinMatrices,
+		const SkinningTarget& target, SkinningMethod method, uint32_t firstVertex, uint32_t numVertices, bool parallel = true);
+
+	/**
+	 * Skin all vertices into a dynamic vertex buffer, written through positions and normals
+	 * of its declaration. Buffer is mapped with discard.
+	 */
+	static void SkinToBuffer(const SkinningSource& source, const float4x4* skinMatrices, uint32_t numSkinMatrices,
+		GraphicsBuffer& buffer, const VertexDeclaration& vertexDecl, SkinningMethod method);
+
+	/**
+	 * Force a code path, for benchmarks and tests. Unsupported paths fall back to scalar.
+	 */
+	static void SetCodePath(CodePath path);
+	static CodePath GetCodePath();
+};
+
+} // Namespace RcEngine
+
+#endif // CpuSkinning_h__
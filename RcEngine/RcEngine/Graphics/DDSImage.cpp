@@ -337,6 +337,8 @@ struct DDS_HEADER_DXT10
 #define DDS_WIDTH  0x00000004 // DDSD_WIDTH
 
 #define DDS_SURFACE_FLAGS_TEXTURE 0x00001000 // DDSCAPS_TEXTURE
+#define DDS_SURFACE_FLAGS_MIPMAP  0x00400008 // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+#define DDS_SURFACE_FLAGS_CUBEMAP 0x00000008 // DDSCAPS_COMPLEX
 
 #define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
 #define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
@@ -362,6 +364,7 @@ struct DDS_HEADER_DXT10
 	DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
 
 #define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+#define DDS_FLAGS_VOLUME 0x00200000 // DDSCAPS2_VOLUME
 
 enum DDS_MISC_FLAGS2
 {
@@ -815,15 +818,39 @@ static DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf)
 }
 
 
-bool Image::LoadImageFromDDS( const String& filename )
+bool Image::LoadImageFromDDS( const String& filename, uint32_t firstLevel /*= 0*/ )
 {
-	// clear any previously loaded images
-	Clear();
+	FileStream stream;
+	if (stream.Open(filename, FILE_READ) == false)
+		return false;
+
+	return LoadDDS(stream, firstLevel, false);
+}
+
+bool Image::LoadImageFromDDS( Stream& stream, uint32_t firstLevel /*= 0*/ )
+{
+	return LoadDDS(stream, firstLevel, false);
+}
 
+bool Image::LoadImageInfoFromDDS( const String& filename )
+{
 	FileStream stream;
 	if (stream.Open(filename, FILE_READ) == false)
 		return false;
 
+	return LoadDDS(stream, 0, true);
+}
+
+bool Image::LoadImageInfoFromDDS( Stream& stream )
+{
+	return LoadDDS(stream, 0, true);
+}
+
+bool Image::LoadDDS( Stream& stream, uint32_t firstLevel, bool headerOnly )
+{
+	// clear any previously loaded images
+	Clear();
+
 	// Need at least enough data to fill the header and magic number to be a valid DDS
 	if (stream.GetSize() < (sizeof(DDS_HEADER) + sizeof(uint32_t)))
 		return false;
@@ -1027,18 +1054,19 @@ bool Image::LoadImageFromDDS( const String& filename )
 	// Unmaping to Engine Pixel Format
 	mFormat = DXGI2PixelFormat[format];
 
-	uint32_t imageDataSize = stream.GetSize() - stream.GetPosition();
-	uint8_t* pData = new uint8_t[imageDataSize];
-	stream.Read(pData, imageDataSize);
+	uint32_t dataOffset = stream.GetPosition();
+	uint32_t numChains = (mType == TT_TextureCube ? mLayers * 6 : mLayers);
+
+	// Mip chain of each surface is stored contiguous, compute which part of it is read
+	firstLevel = (std::min)(firstLevel, mLevels - 1);
 
 	size_t NumBytes = 0;
 	size_t RowBytes = 0;
 
-	uint8_t* pSrcBits = pData;
-	uint8_t* pEndBits = pData + imageDataSize;
+	struct LevelInfo { size_t RowPitch, SlicePitch, Size; };
+	std::vector<LevelInfo> levelInfos(mLevels);
 
-	// load all surfaces for the image (6 surfaces for cubemaps)
-	for (uint32_t j = 0; j < uint32_t(mType == TT_TextureCube ? mLayers * 6 : mLayers); j++) 
+	size_t skippedSize = 0, chainSize = 0;
 	{
 		size_t w = mWidth;
 		size_t h = mHeight;
@@ -1048,162 +1076,167 @@ bool Image::LoadImageFromDDS( const String& filename )
 		{
 			GetSurfaceInfo(w, h, format, &NumBytes, &RowBytes, nullptr);
 
-			size_t totalSize = NumBytes*d;
+			LevelInfo info = { RowBytes, NumBytes, NumBytes*d };
+			levelInfos[i] = info;
 
-			SurfaceInfo surface = { pSrcBits, RowBytes, NumBytes };
-			mSurfaces.push_back(surface);
-
-			if (pSrcBits + totalSize > pEndBits)
-			{
-				return false;
-				// return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
-			}
-
-			pSrcBits += totalSize;
+			if (i < firstLevel)
+				skippedSize += info.Size;
+			chainSize += info.Size;
 
 			w = std::max(1U, w >> 1);
 			h = std::max(1U, h >> 1);
 			d = std::max(1U, d >> 1);
 		}
+	}
+
+	if (dataOffset + chainSize * numChains > stream.GetSize())
+	{
+		return false;
+		// return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+	}
+
+	// Only levels from firstLevel are read, header only load keeps pitches without data
+	size_t loadedSize = chainSize - skippedSize;
+	uint8_t* pDstBits = headerOnly ? nullptr : new uint8_t[loadedSize * numChains];
+
+	// load all surfaces for the image (6 surfaces for cubemaps)
+	for (uint32_t j = 0; j < numChains; j++) 
+	{
+		if (!headerOnly)
+		{
+			stream.Seek(uint32_t(dataOffset + j * chainSize + skippedSize));
+			stream.Read(pDstBits, uint32_t(loadedSize));
+		}
 
+		for (uint32_t i = firstLevel; i < mLevels; ++i)
+		{
+			SurfaceInfo surface = { pDstBits, levelInfos[i].RowPitch, levelInfos[i].SlicePitch };
+			mSurfaces.push_back(surface);
+
+			if (pDstBits)
+				pDstBits += levelInfos[i].Size;
+		}
 	}
 
-	assert(stream.GetPosition() == stream.GetSize());
+	mWidth = std::max(1U, mWidth >> firstLevel);
+	mHeight = std::max(1U, mHeight >> firstLevel);
+	mDepth = std::max(1U, mDepth >> firstLevel);
+	mLevels -= firstLevel;
 
 	mValid = true;
 	return mValid;
 }
 
-//bool Image::SaveImageToDDS( const String& filename )
-//{
-//	// Setup header
-//	const size_t MAX_HEADER_SIZE = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
-//	uint8_t fileHeader[ MAX_HEADER_SIZE ];
-//
-//	*reinterpret_cast<uint32_t*>(&fileHeader[0]) = DDS_MAGIC;
-//
-//	auto header = reinterpret_cast<DDS_HEADER*>( &fileHeader[0] + sizeof(uint32_t) );
-//	size_t headerSize = sizeof(uint32_t) + sizeof(DDS_HEADER);
-//	memset( header, 0, sizeof(DDS_HEADER) );
-//	header->size = sizeof( DDS_HEADER );
-//	header->flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_MIPMAP;
-//	header->height = mWidth;
-//	header->width = mHeight;
-//	header->mipMapCount = 1;
-//	header->caps = DDS_SURFACE_FLAGS_TEXTURE;
-//
-//	// Try to use a legacy .DDS pixel format for better tools support, otherwise fallback to 'DX10' header extension
-//	DDS_HEADER_DXT10* extHeader = nullptr;
-//	switch(mFormat)
-//	{
-//	case PF_RGBA8_UNORM:					memcpy(&header->ddspf,  &DDSPF_A8B8G8R8, sizeof(DDS_PIXELFORMAT) );    break;
-//	case PF_RG16_UNORM:						memcpy( &header->ddspf, &DDSPF_G16R16, sizeof(DDS_PIXELFORMAT) );      break;
-//	case PF_RG8_UNORM:						memcpy( &header->ddspf, &DDSPF_A8L8, sizeof(DDS_PIXELFORMAT) );        break;
-//	case PF_R16_UNORM:						memcpy( &header->ddspf, &DDSPF_L16, sizeof(DDS_PIXELFORMAT) );         break;
-//	case PF_R8_UNORM:						memcpy( &header->ddspf, &DDSPF_L8, sizeof(DDS_PIXELFORMAT) );          break;
-//	//case PF_A8_UNORM:						memcpy( &header->ddspf, &DDSPF_A8, sizeof(DDS_PIXELFORMAT) );          break;
-//	//case PF_R8G8_B8G8_UNORM:				memcpy( &header->ddspf, &DDSPF_R8G8_B8G8, sizeof(DDS_PIXELFORMAT) );   break;
-//	//case PF_G8R8_G8B8_UNORM:				memcpy( &header->ddspf, &DDSPF_G8R8_G8B8, sizeof(DDS_PIXELFORMAT) );   break;
-//	case PF_RGBA_DXT1_UNORM:				memcpy( &header->ddspf, &DDSPF_DXT1, sizeof(DDS_PIXELFORMAT) );        break;
-//	case PF_RGBA_DXT3_UNORM:				memcpy( &header->ddspf, &DDSPF_DXT3, sizeof(DDS_PIXELFORMAT) );        break;
-//	case PF_RGBA_DXT5_UNORM:				memcpy( &header->ddspf, &DDSPF_DXT5, sizeof(DDS_PIXELFORMAT) );        break;
-//	case PF_R_ATI1N_UNORM:					memcpy( &header->ddspf, &DDSPF_BC4_UNORM, sizeof(DDS_PIXELFORMAT) );   break;
-//	case PF_R_ATI1N_SNORM:					memcpy( &header->ddspf, &DDSPF_BC4_SNORM, sizeof(DDS_PIXELFORMAT) );   break;
-//	case PF_RG_ATI2N_UNORM:					memcpy( &header->ddspf, &DDSPF_BC5_UNORM, sizeof(DDS_PIXELFORMAT) );   break;
-//	case PF_RG_ATI2N_SNORM:					memcpy( &header->ddspf, &DDSPF_BC5_SNORM, sizeof(DDS_PIXELFORMAT) );   break;
-//	case PF_B5G6R5:							memcpy( &header->ddspf, &DDSPF_R5G6B5, sizeof(DDS_PIXELFORMAT) );      break;
-//	case PF_BGR5A1:							memcpy( &header->ddspf, &DDSPF_A1R5G5B5, sizeof(DDS_PIXELFORMAT) );    break;
-//	case PF_BGRA8_UNORM:					memcpy( &header->ddspf, &DDSPF_A8R8G8B8, sizeof(DDS_PIXELFORMAT) );    break; // DXGI 1.1
-//	case PF_BGRX8_UNORM:					memcpy( &header->ddspf, &DDSPF_X8R8G8B8, sizeof(DDS_PIXELFORMAT) );    break; // DXGI 1.1
-//	//case PF_YUY2:							memcpy( &header->ddspf, &DDSPF_YUY2, sizeof(DDS_PIXELFORMAT) );        break; // DXGI 1.2
-//	//case PF_B4G4R4A4_UNORM:				memcpy( &header->ddspf, &DDSPF_A4R4G4B4, sizeof(DDS_PIXELFORMAT) );    break; // DXGI 1.2
-//		
-//	// Legacy D3DX formats using D3DFMT enum value as FourCC
-//	case PF_RGBA32F:					    header->ddspf.size = sizeof(DDS_PIXELFORMAT); header->ddspf.flags = DDS_FOURCC; header->ddspf.fourCC = 116; break; // D3DFMT_A32B32G32R32F
-//	case PF_RGBA16F:					    header->ddspf.size = sizeof(DDS_PIXELFORMAT); header->ddspf.flags = DDS_FOURCC; header->ddspf.fourCC = 113; break; // D3DFMT_A16B16G16R16F
-//	case PF_RGBA16_UNORM:				    header->ddspf.size = sizeof(DDS_PIXELFORMAT); header->ddspf.flags = DDS_FOURCC; header->ddspf.fourCC = 36;  break; // D3DFMT_A16B16G16R16
-//	case PF_RGBA16_SNORM:					header->ddspf.size = sizeof(DDS_PIXELFORMAT); header->ddspf.flags = DDS_FOURCC; header->ddspf.fourCC = 110; break; // D3DFMT_Q16W16V16U16
-//	case PF_RG32F:							header->ddspf.size = sizeof(DDS_PIXELFORMAT); header->ddspf.flags = DDS_FOURCC; header->ddspf.fourCC = 115; break; // D3DFMT_G32R32F
-//	case PF_RG16F:							header->ddspf.size = sizeof(DDS_PIXELFORMAT); header->ddspf.flags = DDS_FOURCC; header->ddspf.fourCC = 112; break; // D3DFMT_G16R16F
-//	case PF_R32F:							header->ddspf.size = sizeof(DDS_PIXELFORMAT); header->ddspf.flags = DDS_FOURCC; header->ddspf.fourCC = 114; break; // D3DFMT_R32F
-//	case PF_R16F:							header->ddspf.size = sizeof(DDS_PIXELFORMAT); header->ddspf.flags = DDS_FOURCC; header->ddspf.fourCC = 111; break; // D3DFMT_R16F
-//
-//	//case PF_AI44:
-//	//case PF_IA44:
-//	//case PF_P8:
-//	//case PF_A8P8:
-//	//	return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
-//
-//	default:
-//		memcpy_s( &header->ddspf, sizeof(header->ddspf), &DDSPF_DX10, sizeof(DDS_PIXELFORMAT) );
-//
-//		headerSize += sizeof(DDS_HEADER_DXT10);
-//		extHeader = reinterpret_cast<DDS_HEADER_DXT10*>( reinterpret_cast<uint8_t*>(&fileHeader[0]) + sizeof(uint32_t) + sizeof(DDS_HEADER) );
-//		memset( extHeader, 0, sizeof(DDS_HEADER_DXT10) );
-//		extHeader->dxgiFormat = desc.Format;
-//		extHeader->resourceDimension = D3D11_RESOURCE_DIMENSION_TEXTURE2D;
-//		extHeader->arraySize = 1;
-//		break;
-//	}
-//
-//	//size_t rowPitch, slicePitch, rowCount;
-//	//GetSurfaceInfo( desc.Width, desc.Height, desc.Format, &slicePitch, &rowPitch, &rowCount );
-//
-//	//if ( IsCompressed( desc.Format ) )
-//	//{
-//	//	header->flags |= DDS_HEADER_FLAGS_LINEARSIZE;
-//	//	header->pitchOrLinearSize = static_cast<uint32_t>( slicePitch );
-//	//}
-//	//else
-//	//{
-//	//	header->flags |= DDS_HEADER_FLAGS_PITCH;
-//	//	header->pitchOrLinearSize = static_cast<uint32_t>( rowPitch );
-//	//}
-//
-//	//// Setup pixels
-//	//std::unique_ptr<uint8_t[]> pixels( new (std::nothrow) uint8_t[ slicePitch ] );
-//	//if (!pixels)
-//	//	return E_OUTOFMEMORY;
-//
-//	//D3D11_MAPPED_SUBRESOURCE mapped;
-//	//hr = pContext->Map( pStaging.Get(), 0, D3D11_MAP_READ, 0, &mapped );
-//	//if ( FAILED(hr) )
-//	//	return hr;
-//
-//	//auto sptr = reinterpret_cast<const uint8_t*>( mapped.pData );
-//	//if ( !sptr )
-//	//{
-//	//	pContext->Unmap( pStaging.Get(), 0 );
-//	//	return E_POINTER;
-//	//}
-//
-//	//uint8_t* dptr = pixels.get();
-//
-//	//size_t msize = std::min<size_t>( rowPitch, mapped.RowPitch );
-//	//for( size_t h = 0; h < rowCount; ++h )
-//	//{
-//	//	memcpy_s( dptr, rowPitch, sptr, msize );
-//	//	sptr += mapped.RowPitch;
-//	//	dptr += rowPitch;
-//	//}
-//
-//	//pContext->Unmap( pStaging.Get(), 0 );
-//
-//	//// Write header & pixels
-//	//DWORD bytesWritten;
-//	//if ( !WriteFile( hFile.get(), fileHeader, static_cast<DWORD>( headerSize ), &bytesWritten, 0 ) )
-//	//	return HRESULT_FROM_WIN32( GetLastError() );
-//
-//	//if ( bytesWritten != headerSize )
-//	//	return E_FAIL;
-//
-//	//if ( !WriteFile( hFile.get(), pixels.get(), static_cast<DWORD>( slicePitch ), &bytesWritten, 0 ) )
-//	//	return HRESULT_FROM_WIN32( GetLastError() );
-//
-//	//if ( bytesWritten != slicePitch )
-//	//	return E_FAIL;
-//
-//	//return S_OK;
-//}
+bool Image::SaveImageToDDS( const String& filename ) const
+{
+	if (!mValid)
+		return false;
+
+	// Reverse lookup, entries past the DXGI range are extra formats without DXGI code
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	for (uint32_t i = 1; i <= DXGI_FORMAT_B4G4R4A4_UNORM; ++i)
+	{
+		if (DXGI2PixelFormat[i] == mFormat)
+		{
+			format = DXGI_FORMAT(i);
+			break;
+		}
+	}
+
+	if (format == DXGI_FORMAT_UNKNOWN)
+		return false;
+
+	FileStream stream;
+	if (stream.Open(filename, FILE_WRITE) == false)
+		return false;
+
+	size_t numBytes, rowBytes, numRows;
+	GetSurfaceInfo(mWidth, mHeight, format, &numBytes, &rowBytes, &numRows);
+
+	// Always DX10 header, it is the only one to express arrays and every DXGI format
+	DDS_HEADER header;
+	memset(&header, 0, sizeof(DDS_HEADER));
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE;
+	header.width = mWidth;
+	header.height = mHeight;
+	header.depth = mDepth;
+	header.mipMapCount = mLevels;
+	header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+
+	if (PixelFormatUtils::IsCompressed(mFormat))
+	{
+		header.flags |= DDS_HEADER_FLAGS_LINEARSIZE;
+		header.pitchOrLinearSize = uint32_t(numBytes);
+	}
+	else
+	{
+		header.flags |= DDS_HEADER_FLAGS_PITCH;
+		header.pitchOrLinearSize = uint32_t(rowBytes);
+	}
+
+	if (mLevels > 1)
+	{
+		header.flags |= DDS_HEADER_FLAGS_MIPMAP;
+		header.caps |= DDS_SURFACE_FLAGS_MIPMAP;
+	}
+
+	header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header.ddspf.flags = DDS_FOURCC;
+	header.ddspf.fourCC = MAKEFOURCC( 'D', 'X', '1', '0' );
+
+	DDS_HEADER_DXT10 dds10Ext;
+	memset(&dds10Ext, 0, sizeof(DDS_HEADER_DXT10));
+	dds10Ext.dxgiFormat = format;
+	dds10Ext.arraySize = mLayers;
+
+	switch (mType)
+	{
+	case TT_Texture1D:
+		dds10Ext.resourceDimension = D3D11_RESOURCE_DIMENSION_TEXTURE1D;
+		break;
+	case TT_Texture3D:
+		header.flags |= DDS_HEADER_FLAGS_VOLUME;
+		header.caps2 = DDS_FLAGS_VOLUME;
+		dds10Ext.resourceDimension = D3D11_RESOURCE_DIMENSION_TEXTURE3D;
+		break;
+	case TT_TextureCube:
+		header.caps |= DDS_SURFACE_FLAGS_CUBEMAP;
+		header.caps2 = DDS_CUBEMAP_ALLFACES;
+		dds10Ext.resourceDimension = D3D11_RESOURCE_DIMENSION_TEXTURE2D;
+		dds10Ext.miscFlag = D3D11_RESOURCE_MISC_TEXTURECUBE;
+		break;
+	default:
+		dds10Ext.resourceDimension = D3D11_RESOURCE_DIMENSION_TEXTURE2D;
+		break;
+	}
+
+	uint32_t magic = DDS_MAGIC;
+	stream.Write(&magic, sizeof(uint32_t));
+	stream.Write(&header, sizeof(DDS_HEADER));
+	stream.Write(&dds10Ext, sizeof(DDS_HEADER_DXT10));
+
+	// Surfaces are stored in file order, mip chain of each layer and face, rows copied one
+	// by one since images read back from a texture may have padded rows
+	for (size_t i = 0; i < mSurfaces.size(); ++i)
+	{
+		uint32_t level = uint32_t(i % mLevels);
+		uint32_t depth = (std::max)(1U, mDepth >> level);
+
+		GetSurfaceInfo((std::max)(1U, mWidth >> level), (std::max)(1U, mHeight >> level), format, &numBytes, &rowBytes, &numRows);
+
+		const SurfaceInfo& surface = mSurfaces[i];
+		uint32_t slicePitch = surface.SlicePitch ? surface.SlicePitch : surface.RowPitch * uint32_t(numRows);
+
+		for (uint32_t z = 0; z < depth; ++z)
+		{
+			const uint8_t* pSrcBits = static_cast<const uint8_t*>(surface.pData) + z * slicePitch;
+			for (size_t row = 0; row < numRows; ++row)
+				stream.Write(pSrcBits + row * surface.RowPitch, uint32_t(rowBytes));
+		}
+	}
+
+	return true;
+}
 
 }
\ No newline at end of file
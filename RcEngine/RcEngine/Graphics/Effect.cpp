@@ -30,6 +30,12 @@ Effect::~Effect()
 
 	for (auto iter = mConstantBuffers.begin(); iter != mConstantBuffers.end(); ++iter)
 		delete *iter;
+
+	for (EffectParameter* param : mRetiredParameters)
+		delete param;
+
+	for (EffectTechnique* technique : mRetiredTechniques)
+		delete technique;
 }
 
 EffectTechnique* Effect::GetTechniqueByIndex( uint32_t index ) const
@@ -106,8 +112,12 @@ EffectParameter* Effect::FetchSRVParameter( const String& name, EffectParameterT
 
 			if (mParameters.find(name) == mParameters.end())
 			{
-				srvParam = new EffectSRVParameter(name, effectType);
-				mParameters[name] = srvParam;
+				srvParam = TakeReloadParameter(name, effectType, 0);
+				if (!srvParam)
+				{
+					srvParam = new EffectSRVParameter(name, effectType);
+					mParameters[name] = srvParam;
+				}
 			}
 			else
 			{
@@ -144,8 +154,12 @@ EffectParameter* Effect::FetchUAVParameter( const String& name, EffectParameterT
 
 			if (mParameters.find(name) == mParameters.end())
 			{
-				uavParam = new EffectUAVParameter(name, effectType);
-				mParameters[name] = uavParam;
+				uavParam = TakeReloadParameter(name, effectType, 0, true);
+				if (!uavParam)
+				{
+					uavParam = new EffectUAVParameter(name, effectType);
+					mParameters[name] = uavParam;
+				}
 			}
 			else
 			{
@@ -179,7 +193,11 @@ EffectParameter* Effect::FetchUniformParameter( const String& name, EffectParame
 		return uniformParam;
 	}
 
-	// Not exit, create one
+	// Not exit, take over one of previous load or create one
+	uniformParam = TakeReloadParameter(name, type, elementSize > 1 ? elementSize : 0);
+	if (uniformParam)
+		return uniformParam;
+
 	switch(type)
 	{
 	case EPT_Boolean:
@@ -307,8 +325,12 @@ EffectParameter* Effect::FetchSamplerParameter( const String& name )
 
 	if (mParameters.find(name) == mParameters.end())
 	{
-		samplerParam = new EffectSamplerParameter(name);
-		mParameters[name] = samplerParam;
+		samplerParam = TakeReloadParameter(name, EPT_Sampler, 0);
+		if (!samplerParam)
+		{
+			samplerParam = new EffectSamplerParameter(name);
+			mParameters[name] = samplerParam;
+		}
 	}
 	else
 	{
@@ -332,6 +354,30 @@ EffectConstantBuffer* Effect::FetchConstantBuffer( const String& name, uint32_t
 	return buffer;
 }
 
+EffectParameter* Effect::TakeReloadParameter( const String& name, EffectParameterType type, uint32_t elementSize, bool unorderedAccess )
+{
+	auto paramIter = mReloadParameters.find(name);
+	if (paramIter == mReloadParameters.end())
+		return nullptr;
+
+	EffectParameter* param = paramIter->second;
+
+	// SRV and UAV parameters may have the same type
+	bool isUnorderedAccess = (dynamic_cast<EffectUAVParameter*>(param) != nullptr);
+	if (param->GetParameterType() != type || param->GetElementSize() != elementSize || isUnorderedAccess != unorderedAccess)
+		return nullptr;
+
+	mReloadParameters.erase(paramIter);
+
+	// Bound to constant buffers and auto bindings of the new load
+	param->mConstantBuffer = nullptr;
+	param->mOffset = 0;
+	param->mParameterUsage = EPU_Unknown;
+
+	mParameters[name] = param;
+	return param;
+}
+
 EffectConstantBuffer* Effect::CreateConstantBuffer( const String& name, uint32_t bufferSize )
 {
 	EffectConstantBuffer* buffer = new EffectConstantBuffer(name, bufferSize);
@@ -361,12 +407,28 @@ void Effect::LoadImpl()
 	shared_ptr<Stream> effectStream = fileSystem.OpenStream(effectFlags[0], mGroup);
 	Stream& source = *effectStream;	
 
+	String effectFile;
+	if (fileSystem.FindFile(effectFlags[0], mGroup, effectFile))
+		AddFileDependency(effectFile);
+
 	XMLDoc doc;
 	XMLNodePtr root = doc.Parse(source);
 
 	// Effect name 
 	mEffectName = root->AttributeString("name", "");
 
+	// Passes with the range of their shaders in one batch, so all permutations are compiled in parallel
+	struct PassShaders
+	{
+		EffectPass* Pass;
+		XMLNodePtr PassNode;
+		size_t FirstShader, NumShaders;
+		bool HasComputeShader;
+	};
+
+	vector<PassShaders> passShaders;
+	vector<ShaderLoadDesc> shaderDescs;
+
 	// Parse techniques
 	XMLNodePtr technqueNode, passNode, shaderNode;
 	for (technqueNode = root->FirstNode("Technique");  technqueNode; technqueNode = technqueNode->NextSibling("Technique"))
@@ -374,70 +436,82 @@ void Effect::LoadImpl()
 		EffectTechnique* technique = new EffectTechnique(*this);
 		technique->mName = technqueNode->AttributeString("name", "");
 		
-		String filename, entryPoint;
 		for (passNode = technqueNode->FirstNode("Pass");  passNode; passNode = passNode->NextSibling("Pass"))
 		{
 			EffectPass* pass = new EffectPass;
 			pass->mName = passNode->AttributeString("name", "");
 			pass->mShaderPipeline = factory->CreateShaderPipeline(*this);
 
-			bool hasComputeShader = false;
+			PassShaders shaders = { pass, passNode, shaderDescs.size(), 0, false };
 
-			// Load shader 
+			// Collect shaders 
 			static const String ShaderNodeNames[] = {"VertexShader", "TessControlShader", "TessEvalShader", "GeometryShader", "PixelShader", "ComputeShader"};
 			for (uint32_t i = 0; i < ST_Count; ++i)
 			{
 				if (shaderNode = passNode->FirstNode(ShaderNodeNames[i]))
 				{
-					filename = shaderNode->AttributeString("file", "");
-					entryPoint = shaderNode->AttributeString("entry", "");
+					ShaderLoadDesc desc;
+					desc.Type = ShaderType(ST_Vertex + i);
+					desc.Filename = shaderNode->AttributeString("file", "");
+					desc.EntryPoint = shaderNode->AttributeString("entry", "");
 
-					vector<ShaderMacro> shaderMacros;
-					Internal::CollectShaderMacro(shaderNode, shaderMacros);
+					Internal::CollectShaderMacro(shaderNode, desc.Macros);
 
 					for (size_t j = 1; j < effectFlags.size(); ++j)
 					{
 						ShaderMacro macro = { effectFlags[j], "" };
-						shaderMacros.push_back(macro);
+						desc.Macros.push_back(macro);
 					}
 
-					pass->mShaderPipeline->AttachShader(
-						factory->LoadShaderFromFile(
-						ShaderType(ST_Vertex + i),
-						filename, 
-						shaderMacros.empty() ? nullptr : &shaderMacros[0],
-						shaderMacros.size(),
-						entryPoint) );
+					shaderDescs.push_back(desc);
+					shaders.NumShaders++;
 
 					// Compute pass
 					if (i == ST_Compute)
-						hasComputeShader = true;
+						shaders.HasComputeShader = true;
 				}
 			}
 
-			if (pass->mShaderPipeline->LinkPipeline() == false)
-			{
-				ENGINE_EXCEPT(Exception::ERR_INVALID_STATE, "Effect error!", "Effect::LoadForm");
-			}
+			passShaders.push_back(shaders);
+			technique->mPasses.push_back(pass);	
+		}
 
-			// Compute shader pass has no render state
-			if (!hasComputeShader)
-			{
-				DepthStencilStateDesc dsDesc;
-				BlendStateDesc blendDesc;
-				RasterizerStateDesc rasDesc;
+		mTechniques.push_back(technique);
+	}
 
-				Internal::CollectRenderStates(passNode, dsDesc, blendDesc, rasDesc, pass->mBlendColor, pass->mSampleMask, pass->mFrontStencilRef, pass->mBackStencilRef);
+	factory->LoadShadersFromFile(shaderDescs);
 
-				pass->mDepthStencilState = factory->CreateDepthStencilState(dsDesc);
-				pass->mBlendState = factory->CreateBlendState(blendDesc);
-				pass->mRasterizerState = factory->CreateRasterizerState(rasDesc);
-			}
+	for (const ShaderLoadDesc& desc : shaderDescs)
+	{
+		for (const String& sourceFile : desc.Result->GetSourceFiles())
+			AddFileDependency(sourceFile);
+	}
 
-			technique->mPasses.push_back(pass);	
+	for (const PassShaders& shaders : passShaders)
+	{
+		EffectPass* pass = shaders.Pass;
+
+		for (size_t i = 0; i < shaders.NumShaders; ++i)
+			pass->mShaderPipeline->AttachShader(shaderDescs[shaders.FirstShader + i].Result);
+
+		if (pass->mShaderPipeline->LinkPipeline() == false)
+		{
+			ENGINE_EXCEPT(Exception::ERR_INVALID_STATE, "Effect error!", "Effect::LoadForm");
 		}
 
-		mTechniques.push_back(technique);
+		// Compute shader pass has no render state
+		if (!shaders.HasComputeShader)
+		{
+			DepthStencilStateDesc dsDesc;
+			BlendStateDesc blendDesc;
+			RasterizerStateDesc rasDesc;
+
+			Internal::CollectRenderStates(shaders.PassNode, dsDesc, blendDesc, rasDesc, pass->mBlendColor, pass->mSampleMask, pass->mFrontStencilRef, pass->mBackStencilRef);
+
+			pass->mDepthStencilState = factory->CreateDepthStencilState(dsDesc);
+			pass->mBlendState = factory->CreateBlendState(blendDesc);
+			pass->mRasterizerState = factory->CreateRasterizerState(rasDesc);
+		}
 	}
 
 	// Parse sampler states
@@ -545,6 +619,156 @@ void Effect::UnloadImpl()
 
 }
 
+void Effect::ReloadImpl()
+{
+	RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
+
+	// Pooled shaders would be used again as they are, drop the ones read from files of this effect
+	vector<String> shaderFiles;
+	for (EffectTechnique* technique : mTechniques)
+	{
+		for (EffectPass* pass : technique->mPasses)
+		{
+			for (uint32_t i = 0; i < ST_Count; ++i)
+			{
+				if (shared_ptr<Shader> shader = pass->mShaderPipeline->GetShader(ShaderType(i)))
+					shaderFiles.insert(shaderFiles.end(), shader->GetSourceFiles().begin(), shader->GetSourceFiles().end());
+			}
+		}
+	}
+
+	factory->InvalidateShaderFiles(shaderFiles);
+
+	// Move current content aside, the new load takes over parameters of the same name
+	struct ParameterBinding
+	{
+		EffectConstantBuffer* ConstantBuffer;
+		uint32_t Offset;
+		EffectParameterUsage Usage;
+	};
+
+	std::map<EffectParameter*, ParameterBinding> oldBindings;
+	for (auto& kv : mParameters)
+	{
+		ParameterBinding binding = { kv.second->mConstantBuffer, kv.second->mOffset, kv.second->mParameterUsage };
+		oldBindings[kv.second] = binding;
+	}
+
+	String oldEffectName = mEffectName;
+	EffectTechnique* oldCurrTechnique = mCurrTechnique;
+
+	vector<EffectTechnique*> oldTechniques;
+	vector<EffectConstantBuffer*> oldConstantBuffers;
+	std::map<String, shared_ptr<SamplerState> > oldSamplerStates;
+
+	oldTechniques.swap(mTechniques);
+	oldConstantBuffers.swap(mConstantBuffers);
+	oldSamplerStates.swap(mSamplerStates);
+	mReloadParameters.swap(mParameters);
+
+	try
+	{
+		LoadImpl();
+	}
+	catch (...)
+	{
+		// Put previous content back, parameters taken by the failed load get their old binding
+		for (auto& kv : mParameters)
+		{
+			if (oldBindings.find(kv.second) == oldBindings.end())
+				delete kv.second;
+		}
+
+		mParameters.clear();
+		mReloadParameters.clear();
+
+		for (auto& kv : oldBindings)
+		{
+			EffectParameter* param = kv.first;
+			param->mConstantBuffer = kv.second.ConstantBuffer;
+			param->mOffset = kv.second.Offset;
+			param->mParameterUsage = kv.second.Usage;
+
+			mParameters[param->GetName()] = param;
+		}
+
+		for (EffectTechnique* technique : mTechniques)
+			delete technique;
+
+		for (EffectConstantBuffer* buffer : mConstantBuffers)
+			delete buffer;
+
+		mTechniques.swap(oldTechniques);
+		mConstantBuffers.swap(oldConstantBuffers);
+		mSamplerStates.swap(oldSamplerStates);
+
+		mEffectName = oldEffectName;
+		mCurrTechnique = oldCurrTechnique;
+
+		// Failed load may have set sampler parameters to its own states
+		for (auto& kv : mSamplerStates)
+		{
+			if (EffectParameter* samplerParam = GetParameterByName(kv.first))
+				samplerParam->SetValue(kv.second);
+		}
+
+		throw;
+	}
+
+	// Keep technique objects of the same name, render paths hold them
+	for (EffectTechnique*& technique : mTechniques)
+	{
+		auto oldIter = std::find_if(oldTechniques.begin(), oldTechniques.end(), [&](EffectTechnique* oldTechnique) {
+							return oldTechnique->mName == technique->mName; });
+
+		if (oldIter != oldTechniques.end())
+		{
+			// Old passes go with the new object
+			EffectTechnique* oldTechnique = *oldIter;
+			oldTechnique->mPasses.swap(technique->mPasses);
+			delete technique;
+
+			technique = oldTechnique;
+			oldTechniques.erase(oldIter);
+		}
+	}
+
+	// Techniques gone from the effect have no passes left, drawing with them draws nothing
+	for (EffectTechnique* technique : oldTechniques)
+	{
+		for (EffectPass* pass : technique->mPasses)
+			delete pass;
+
+		technique->mPasses.clear();
+		technique->mValid = false;
+		mRetiredTechniques.push_back(technique);
+	}
+
+	if (std::find(mTechniques.begin(), mTechniques.end(), oldCurrTechnique) != mTechniques.end())
+		mCurrTechnique = oldCurrTechnique;
+	else
+		mCurrTechnique = mTechniques.front();
+
+	// Taken over parameters keep their value, write it to the new constant buffers
+	for (auto& kv : mParameters)
+	{
+		if (oldBindings.find(kv.second) != oldBindings.end())
+			kv.second->WriteBufferValue();
+	}
+
+	// Parameters gone from the effect are kept, but no longer bound
+	for (auto& kv : mReloadParameters)
+	{
+		kv.second->mConstantBuffer = nullptr;
+		mRetiredParameters.push_back(kv.second);
+	}
+
+	mReloadParameters.clear();
+
+	for (EffectConstantBuffer* buffer : oldConstantBuffers)
+		delete buffer;
+}
+
 shared_ptr<Resource> Effect::FactoryFunc( ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
 {
 	return std::make_shared<Effect>(creator, handle, name, group);
@@ -36,6 +36,12 @@ protected:
 	void LoadImpl();
 	void UnloadImpl();
 
+	/**
+	 * Load into this effect, keeping techniques and parameters of the same name, so pointers to
+	 * them stay valid. Previous content is kept if loading fails.
+	 */
+	void ReloadImpl();
+
 public:
 	static shared_ptr<Resource> FactoryFunc(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group);
 
@@ -54,6 +60,10 @@ public_internal:
 	inline EffectConstantBuffer* GetConstantBuffer(uint32_t index) const      { return mConstantBuffers[index]; }
 	inline uint32_t GetNumConstantBuffers() const							{ return mConstantBuffers.size(); }
 
+private:
+	// Parameter of previous load with same name and kind while reloading, null if there is none
+	EffectParameter* TakeReloadParameter(const String& name, EffectParameterType type, uint32_t elementSize, bool unorderedAccess = false);
+
 protected:
 	String mEffectName;
 
@@ -64,6 +74,13 @@ protected:
 	std::map<String, EffectParameter*> mParameters;
 
 	std::map<String, shared_ptr<SamplerState> > mSamplerStates;
+
+	// Parameters of previous load while reloading
+	std::map<String, EffectParameter*> mReloadParameters;
+
+	// Dropped by a reload, callers may still hold them
+	vector<EffectParameter*> mRetiredParameters;
+	vector<EffectTechnique*> mRetiredTechniques;
 };
 
 class _ApiExport EffectTechnique 
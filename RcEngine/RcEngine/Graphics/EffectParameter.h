@@ -140,6 +140,9 @@ public_internal:
 	virtual void SetArrayStride(uint32_t stride);
 	virtual void SetMatrixStride(uint32_t matStride);
 
+	// Write value set before into constant buffer, after parameter moved to another one on effect reload
+	virtual void WriteBufferValue() {}
+
 protected:
 	void IncrementTimeStamp();
 
@@ -182,6 +185,15 @@ public:
 		}
 	}
 
+	void WriteBufferValue()
+	{
+		if (mConstantBuffer && mLastModifiedTime)
+		{
+			*(reinterpret_cast<T*>(mConstantBuffer->GetRawData(mOffset))) = mValue;
+			mConstantBuffer->MakeDirty();
+		}
+	}
+
 protected:
 	T mValue;
 };
@@ -211,6 +223,15 @@ public:
 		}
 	}
 
+	void WriteBufferValue()
+	{
+		if (mConstantBuffer && mLastModifiedTime)
+		{
+			*(reinterpret_cast<int*>(mConstantBuffer->GetRawData(mOffset))) = mValue ? 1 : 0;
+			mConstantBuffer->MakeDirty();
+		}
+	}
+
 protected:
 	bool mValue;
 };
@@ -267,6 +288,18 @@ public:
 		}
 	}
 
+	void WriteBufferValue()
+	{
+		if (mConstantBuffer && mLastModifiedTime)
+		{
+			uint8_t* pData = mConstantBuffer->GetRawData(mOffset);
+			for (uint32_t i = 0; i < mElementSize; ++i)
+				memcpy(pData + i * mArrayStrides, mValue + i, sizeof(T));
+
+			mConstantBuffer->MakeDirty();
+		}
+	}
+
 protected:
 	T* mValue;
 
@@ -301,6 +334,15 @@ public:
 		}
 	}
 
+	virtual void WriteBufferValue()
+	{
+		if (mConstantBuffer && mLastModifiedTime)
+		{
+			*(reinterpret_cast<float4x4*>(mConstantBuffer->GetRawData(mOffset))) = mValue.Transpose();
+			mConstantBuffer->MakeDirty();
+		}
+	}
+
 protected:
 	float4x4 mValue;
 	uint32_t mMatrixStride;
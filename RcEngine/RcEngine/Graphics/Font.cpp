@@ -7,11 +7,11 @@
 #include <Core/Exception.h>
 #include <Core/Utility.h>
 #include <IO/FileSystem.h>
-#include <IO/FileStream.h>
+#include <IO/Stream.h>
 #include <GUI/GuiSkin.h>
 #include <Math/Rectangle.h>
 #include <Resource/ResourceManager.h>
-#include <fstream>
+#include <sstream>
 
 namespace {
 
@@ -234,12 +234,8 @@ void Font::LoadImpl()
 	mFontTexture = fontTexture->GetTexture();
 
 	// description file
-	String filePath = fileSystem.Locate(mResourceName + ".sdff.txt", mGroup)  ;
-
-	if (filePath.find(".txt") != std::string::npos)
-		LoadTXT(filePath);
-	else
-		LoadBinary(filePath);
+	shared_ptr<Stream> stream = fileSystem.OpenStream(mResourceName + ".sdff.txt", mGroup);
+	LoadTXT(*stream);
 	
 	mSpaceAdvance = mFontMetrics[L' '].Advance;
 }
@@ -249,7 +245,7 @@ void Font::UnloadImpl()
 
 }
 
-void Font::LoadTXT(const String& fileName)
+void Font::LoadTXT(Stream& stream)
 {
 	std::string line;
 
@@ -257,7 +253,7 @@ void Font::LoadTXT(const String& fileName)
 	
 	Glyph charGlyph;
 
-	std::ifstream file(fileName);
+	std::istringstream file(stream.ReadText());
 	while (std::getline(file, line))
 	{
 		// Skip white spaces
@@ -281,7 +277,6 @@ void Font::LoadTXT(const String& fileName)
 			mDescent = (std::min)(mDescent, charGlyph.OffsetY - charGlyph.Height);
 		}
 	}
-	file.close();
 
 	assert(numChars == mFontMetrics.size());
 	mRowHeight = mAscent - mDescent;
@@ -529,7 +524,7 @@ void Font::DrawString( SpriteBatch& spriteBatch, const std::wstring& text, float
 	}
 }
 
-void Font::LoadBinary( const String& fileName )
+void Font::LoadBinary( Stream& stream )
 {
 
 }
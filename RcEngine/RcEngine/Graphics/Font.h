@@ -70,8 +70,8 @@ protected:
 	void LoadImpl();
 	void UnloadImpl();
 
-	void LoadTXT(const String& fileName);
-	void LoadBinary(const String& fileName);
+	void LoadTXT(Stream& stream);
+	void LoadBinary(Stream& stream);
 
 public:
 	static shared_ptr<Resource> FactoryFunc(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group);
@@ -128,10 +128,11 @@ void ForwardPlusPath::DepthPrePass()
 	mSceneMan->UpdateRenderQueue(mCamera, RO_None, RenderQueue::BucketAll, 0);
 
 	const RenderBucket& opaqueBucket = mSceneMan->GetRenderQueue().GetRenderBucket(RenderQueue::BucketOpaque);
-	for (const RenderQueueItem& renderItem : opaqueBucket) 
+	mInstanceBatcher.BuildBatches(opaqueBucket);
+	for (const InstanceBatch& batch : mInstanceBatcher.GetBatches()) 
 	{
-		renderItem.Renderable->GetMaterial()->SetCurrentTechnique("DepthPre");
-		renderItem.Renderable->Render();
+		batch.Items[0].Renderable->GetMaterial()->SetCurrentTechnique("DepthPre");
+		mInstanceBatcher.Render(batch);
 	}
 
 	//auto proj = mCamera->GetProjMatrix();
@@ -235,10 +236,12 @@ void ForwardPlusPath::ForwardShading()
 	mDevice->BindFrameBuffer(mForwardFB);
 	mHDRBufferRTV->ClearColor(ColorRGBA(0, 0, 0, 0)); 
 
+	// Items of a batch share material, so effect parameters are set once per batch
 	const RenderBucket& opaqueBucket = mSceneMan->GetRenderQueue().GetRenderBucket(RenderQueue::BucketOpaque);
-	for (const RenderQueueItem& renderItem : opaqueBucket) 
+	mInstanceBatcher.BuildBatches(opaqueBucket);
+	for (const InstanceBatch& batch : mInstanceBatcher.GetBatches()) 
 	{
-		shared_ptr<Effect> finalShadingEffect = renderItem.Renderable->GetMaterial()->GetEffect();
+		shared_ptr<Effect> finalShadingEffect = batch.Items[0].Renderable->GetMaterial()->GetEffect();
 
 		finalShadingEffect->GetParameterByName("CameraOrigin")->SetValue(mCamera->GetPosition());
 		finalShadingEffect->GetParameterByName("PointLightsPosRange")->SetValue(mPointLightsPosRangeSRV);
@@ -247,7 +250,7 @@ void ForwardPlusPath::ForwardShading()
 		finalShadingEffect->GetParameterByName("LightIndexList")->SetValue(mTilePointLightsIndexListSRV);
 		finalShadingEffect->GetParameterByName("LightListRange")->SetValue(mTilePointLightsRangeSRV);
 		finalShadingEffect->SetCurrentTechnique("ForwardShading");
-		renderItem.Renderable->Render();
+		mInstanceBatcher.Render(batch);
 	}
 
 	//mDevice->GetRenderFactory()->SaveTextureToFile("E:/HDR.pfm", mHDRBuffer);
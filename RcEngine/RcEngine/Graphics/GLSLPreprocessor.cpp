@@ -0,0 +1,389 @@
+#include <Graphics/GLSLPreprocessor.h>
+#include <Graphics/GraphicsResource.h>
+#include <Graphics/ShaderCache.h>
+#include <Core/Exception.h>
+#include <IO/FileSystem.h>
+#include <IO/PathUtil.h>
+#include <IO/Stream.h>
+#include <mutex>
+
+namespace RcEngine {
+
+namespace {
+
+bool HasSpecialToken(const std::string& line, std::string& oToken)
+{
+	size_t s = line.find('#');
+	if (s == std::string::npos)
+		return false;
+
+	size_t e = s+1;
+	while(isalpha(line[e])) e++;
+
+	oToken = line.substr(s, e - s);
+	return true;
+}
+
+bool HasSamplerState(const std::string& line, std::string& oSamplerState, std::string& oTexture)
+{
+	bool hasSamplerState = false;
+
+	size_t colonPos = line.find(':');
+	if (colonPos != std::string::npos)
+	{
+		// Texture name follows the pragma token, "#pragma DiffuseMap : MaterialSampler"
+		size_t s = line.find("pragma") + 6, e = colonPos - 1;
+		while(!isalpha(line[s])) s++;
+		while(!isalpha(line[e])) e--;
+		oTexture = line.substr(s, e - s + 1);
+
+		s = colonPos+1;
+		while(!isalpha(line[s])) s++;
+		e = s;
+		while(isalpha(line[e])) e++;
+		oSamplerState = line.substr(s, e - s);
+
+		hasSamplerState = true;
+	}
+
+	return hasSamplerState;
+}
+
+std::string GetIncludeName(const std::string& line)
+{
+	size_t s = line.find('\"');
+	size_t e = line.find('\"', s + 1);
+	return line.substr(s + 1, e-s-1);
+}
+
+/** Include names are absolute to shader directory, "/LightingUtil.glsl". */
+std::string GetIncludeFile(const std::string& parentGLSLPath, const std::string& includeName)
+{
+	std::string includeRoot = PathUtil::GetParentPath(parentGLSLPath);
+	if (includeRoot.empty() && !includeName.empty() && includeName[0] == '/')
+		return includeName.substr(1);
+
+	return includeRoot + includeName;
+}
+
+//////////////////////////////////////////////////////////////////////////
+class GLSLInclude
+{
+public:
+	GLSLInclude() : SourceHash(0) {}
+
+	/**
+	 * Read include once, concurrent first reads of the same file both load it and the first
+	 * one is kept. Nested includes are read too, loading stops cycles.
+	 */
+	static const GLSLInclude& FetchGLSLInclude(const std::string& parentGLSLPath, const std::string& includeName,
+		vector<std::string>& loading)
+	{
+		{
+			std::lock_guard<std::mutex> lock(msMutex);
+
+			auto it = msCachedIncludes.find(includeName);
+			if (it != msCachedIncludes.end())
+				return it->second;
+		}
+
+		GLSLInclude glslInclude;
+		loading.push_back(includeName);
+		glslInclude.LoadInclude(parentGLSLPath, includeName, loading);
+		loading.pop_back();
+
+		std::lock_guard<std::mutex> lock(msMutex);
+		return msCachedIncludes.insert(make_pair(includeName, glslInclude)).first->second;
+	}
+
+	static const GLSLInclude* FindGLSLInclude(const std::string& includeName)
+	{
+		std::lock_guard<std::mutex> lock(msMutex);
+
+		auto it = msCachedIncludes.find(includeName);
+		return (it != msCachedIncludes.end()) ? &it->second : nullptr;
+	}
+
+	static void ClearCachedIncludes()
+	{
+		std::lock_guard<std::mutex> lock(msMutex);
+		msCachedIncludes.clear();
+	}
+
+	/**
+	 * Add nested includes, then this one, to list if not in it yet.
+	 */
+	void CollectIncludes(const std::string& includeName, vector<String>& includes) const
+	{
+		if (std::find(includes.begin(), includes.end(), includeName) != includes.end())
+			return;
+
+		for (const std::string& nestedName : NestedIncludes)
+		{
+			if (const GLSLInclude* nestedInclude = FindGLSLInclude(nestedName))
+				nestedInclude->CollectIncludes(nestedName, includes);
+		}
+
+		includes.push_back(includeName);
+	}
+
+private:
+	void LoadInclude(const std::string& parentGLSLPath, const std::string& includeName, vector<std::string>& loading)
+	{
+		std::string includeFile = GetIncludeFile(parentGLSLPath, includeName);
+
+		shared_ptr<Stream> stream = FileSystem::GetSingleton().OpenStream(includeFile);
+		Source = stream->ReadText();
+
+		SourceHash = ShaderCache::Hash(includeName.c_str(), includeName.length());
+		SourceHash = ShaderCache::Hash(Source.c_str(), Source.length(), SourceHash);
+
+		std::string line, token, samplerState, texture;
+
+		size_t lineBeign = 0;
+		size_t lineEnd = Source.find('\n');
+		while (lineEnd < std::string::npos)
+		{
+			line = Source.substr(lineBeign, lineEnd - lineBeign);
+			if ( HasSpecialToken(line, token) )
+			{
+				if ( token == "#pragma" && HasSamplerState(line, samplerState, texture) )
+				{
+					SamplerStates.push_back(make_pair(samplerState, texture));
+				}
+				else if (token == "#include")
+				{
+					// Nested include, its text is part of the cache key of every shader including this
+					std::string nestedName = GetIncludeName(line);
+					if (std::find(loading.begin(), loading.end(), nestedName) == loading.end())
+					{
+						const GLSLInclude& nestedInclude = FetchGLSLInclude(parentGLSLPath, nestedName, loading);
+						SourceHash = ShaderCache::Hash(&nestedInclude.SourceHash, sizeof(uint64_t), SourceHash);
+						NestedIncludes.push_back(nestedName);
+					}
+				}
+			}
+
+			lineBeign = lineEnd+1;
+			lineEnd = Source.find('\n', lineBeign);
+		}
+	}
+
+public:
+	typedef std::pair<std::string, std::string> SamplerState;
+	std::vector<SamplerState> SamplerStates;
+
+	std::string Source;
+	std::vector<std::string> NestedIncludes;
+
+	// Hash of text of this and nested includes
+	uint64_t SourceHash;
+
+private:
+	static std::mutex msMutex;
+	static std::map<std::string, GLSLInclude> msCachedIncludes;
+};
+
+std::mutex GLSLInclude::msMutex;
+std::map<std::string, GLSLInclude> GLSLInclude::msCachedIncludes;
+
+}
+
+void GLSLPreprocessor::Preprocess( const String& filename, ShaderType shaderStage, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint, const String& defaultVersion, GLSLSource& result )
+{
+	shared_ptr<Stream> stream = FileSystem::GetSingleton().OpenStream(filename);
+	std::string glslScript = stream->ReadText();
+
+	size_t shaderSectionBegin, shaderSectionEnd;
+	FindShaderSectionRange(glslScript, shaderStage, entryPoint, shaderSectionBegin, shaderSectionEnd);
+
+	bool hasVersion = false;
+	bool hasInclude = false;
+
+	result.Includes.clear();
+	result.SamplerStates.clear();
+	result.IncludeHash = 0;
+
+	uint32_t lineNum = 0;
+	std::string line, token, samplerState, texture, version;
+	vector<std::string> loading;
+
+	size_t lineBeign = shaderSectionBegin;
+	size_t lineEnd = glslScript.find('\n', shaderSectionBegin);
+	while (lineEnd < shaderSectionEnd && lineEnd != std::string::npos)
+	{
+		line = glslScript.substr(lineBeign, lineEnd - lineBeign);
+
+		if (line.size())
+		{
+			if ( HasSpecialToken(line, token) )
+			{
+				if (token == "#version")
+				{
+					version = line;
+					hasVersion = true;
+					shaderSectionBegin = lineEnd+1;
+				}
+				else if (token == "#include")
+				{
+					// Find include file
+					std::string includeName = GetIncludeName(line);
+
+					const GLSLInclude& glslInclude = GLSLInclude::FetchGLSLInclude(filename, includeName, loading);
+
+					// Sampler states of this and nested includes not seen yet
+					size_t firstCollected = result.Includes.size();
+					glslInclude.CollectIncludes(includeName, result.Includes);
+					for (size_t i = firstCollected; i < result.Includes.size(); ++i)
+					{
+						if (const GLSLInclude* collected = GLSLInclude::FindGLSLInclude(result.Includes[i]))
+						{
+							for (const auto& v : collected->SamplerStates)
+								result.SamplerStates[v.second] = v.first;
+						}
+					}
+
+					result.IncludeHash = ShaderCache::Hash(&glslInclude.SourceHash, sizeof(uint64_t), result.IncludeHash);
+
+					hasInclude = true;
+				}
+				else if (token == "#pragma")
+				{
+					if ( HasSamplerState(line, samplerState, texture) )
+					{
+						result.SamplerStates[texture] = samplerState;
+					}
+				}
+			}
+		}
+
+		++lineNum;
+		lineBeign = lineEnd+1;
+		lineEnd = glslScript.find('\n', lineBeign);
+	}
+
+	String& shaderSource = result.Source;
+	shaderSource.clear();
+
+	// Add version
+	if (!hasVersion)
+		version = defaultVersion;
+
+	shaderSource += version + '\n';
+
+	// Add include extension
+	if (hasInclude)
+		shaderSource += "#extension GL_ARB_shading_language_include : enable\n";
+
+	// Add Macro
+	if (macros)
+	{
+		for (uint32_t i = 0; i < macroCount; ++i)
+		{
+			shaderSource += "#define " + macros[i].Name + " " + macros[i].Definition + "\n";
+		}
+	}
+
+	// Add #line
+#ifdef _DEBUG
+	size_t lineNum0 = std::count(glslScript.begin(), glslScript.begin() + shaderSectionBegin, '\n');
+	lineNum = lineNum0 + 1;
+
+	char lineBuffer[100];
+	std::sprintf(lineBuffer, "#line %d\n", lineNum);
+	shaderSource += lineBuffer;
+#endif
+
+	shaderSource += glslScript.substr(shaderSectionBegin, shaderSectionEnd - shaderSectionBegin);
+}
+
+const String& GLSLPreprocessor::GetIncludeSource( const String& includeName )
+{
+	const GLSLInclude* glslInclude = GLSLInclude::FindGLSLInclude(includeName);
+	if (!glslInclude)
+	{
+		ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND, includeName + " not preprocessed!", "GLSLPreprocessor::GetIncludeSource");
+	}
+
+	return glslInclude->Source;
+}
+
+void GLSLPreprocessor::GetSourceFiles( const String& filename, const GLSLSource& source, vector<String>& oFiles )
+{
+	FileSystem& fileSystem = FileSystem::GetSingleton();
+
+	oFiles.clear();
+
+	String fullPath;
+	if (fileSystem.FindFile(filename, "General", fullPath))
+		oFiles.push_back(fullPath);
+
+	for (const String& includeName : source.Includes)
+	{
+		if (fileSystem.FindFile(GetIncludeFile(filename, includeName), "General", fullPath))
+			oFiles.push_back(fullPath);
+	}
+}
+
+void GLSLPreprocessor::ClearIncludeCache()
+{
+	GLSLInclude::ClearCachedIncludes();
+}
+
+void GLSLPreprocessor::FindShaderSectionRange( const String& glslScript, ShaderType shaderStage, const String& entryPoint, size_t& oSectionBegin, size_t& oSectionEnd )
+{
+	// find shader section of entry point
+	static const char* GLSLShaderToken[] = {
+		"[[Vertex=%s]]", "[[TessControl=%s]]", "[[TessEval=%s]]", "[[Geometry=%s]]", "[[Fragment=%s]]", "[[Compute=%s]]"
+	};
+
+	// Split into shader section
+	char delimiter[255];
+	std::sprintf(delimiter, GLSLShaderToken[shaderStage], entryPoint.c_str());
+
+	size_t tokenBegin = glslScript.find(delimiter);
+	if (tokenBegin != std::string::npos)
+	{
+		// Find the range of this shader section
+
+		size_t tokenEnd = glslScript.find('\n', tokenBegin)+1;
+		size_t nextTokenEnd = glslScript.find("]]", tokenEnd);
+
+		if (nextTokenEnd != std::string::npos)
+		{
+			// Validate
+			size_t nextTokenBegin = glslScript.rfind("[[", nextTokenEnd);
+
+			// Check whether exits = in nextToken
+			bool valid = false;
+			for (size_t i = nextTokenBegin; i < nextTokenEnd && !valid; ++i)
+				valid = (glslScript[i] == '=');
+
+			assert(valid == true);
+			oSectionBegin = tokenEnd;
+			oSectionEnd = nextTokenBegin;
+		}
+		else
+		{
+			oSectionBegin = tokenEnd;
+			oSectionEnd = glslScript.length();
+		}
+	}
+	else
+	{
+		if (glslScript.find("[[") == std::string::npos)
+		{
+			// No shader stage token, use the whole content as this shader stage
+			oSectionBegin = 0;
+			oSectionEnd = glslScript.length();
+		}
+		else
+		{
+			// Error: exits other shader section, but can't find this shader stage
+			std::cerr << "Shader " + entryPoint + " not found!" << std::endl;
+			ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND, "Shader " + entryPoint + " not found!", "GLSLPreprocessor::FindShaderSectionRange");
+		}
+	}
+}
+
+} // Namespace RcEngine
@@ -0,0 +1,71 @@
+#ifndef GLSLPreprocessor_h__
+#define GLSLPreprocessor_h__
+
+#include <Core/Prerequisites.h>
+#include <Graphics/GraphicsCommon.h>
+
+namespace RcEngine {
+
+struct ShaderMacro;
+
+/**
+ * One shader stage of a GLSL file, ready to compile.
+ */
+struct GLSLSource
+{
+	GLSLSource() : IncludeHash(0) {}
+
+	String Source;
+
+	// Named strings the source includes, nested ones first, each once
+	vector<String> Includes;
+
+	// Texture to sampler state, from #pragma lines of the section and of files it includes
+	std::map<String, String> SamplerStates;
+
+	// Text of includes, source only names them
+	uint64_t IncludeHash;
+};
+
+/**
+ * CPU side of GLSL shader loading. Finds the section of an entry point in a shader file,
+ * adds version, include extension and macros, and reads the files it includes. Makes no GL
+ * calls and may run on any thread, included files are read once and shared by all shaders.
+ * Used by OpenGL render system, and by null render system to reflect GLSL without a device.
+ */
+class _ApiExport GLSLPreprocessor
+{
+public:
+	/**
+	 * Shader file and its includes are read through FileSystem from General group, so they
+	 * may be in an archive. Version is added if the section has no #version line.
+	 */
+	static void Preprocess(const String& filename, ShaderType shaderStage, const ShaderMacro* macros, uint32_t macroCount,
+		const String& entryPoint, const String& version, GLSLSource& result);
+
+	/**
+	 * Text of an include read by Preprocess, to register as named string.
+	 */
+	static const String& GetIncludeSource(const String& includeName);
+
+	/**
+	 * OS paths of shader file and includes of result, for hot reload. Archived files can't
+	 * change and are left out.
+	 */
+	static void GetSourceFiles(const String& filename, const GLSLSource& source, vector<String>& oFiles);
+
+	/**
+	 * Forget included files read so far, so changed ones are read again.
+	 */
+	static void ClearIncludeCache();
+
+	/**
+	 * Range of [[Stage=entryPoint]] section, the whole file if it has no sections.
+	 */
+	static void FindShaderSectionRange(const String& glslScript, ShaderType shaderStage, const String& entryPoint,
+		size_t& oSectionBegin, size_t& oSectionEnd);
+};
+
+} // Namespace RcEngine
+
+#endif // GLSLPreprocessor_h__
@@ -269,6 +269,10 @@ enum VertexElementUsage
 	/** Vertex binormal data.
 	*/
 	VEU_Binormal = 7,
+
+	/** Per-instance world matrix row, usage index is the row.
+	*/
+	VEU_InstanceTransform = 8,
 };
 
 enum CubeMapFace
@@ -116,6 +116,12 @@ public:
 
 	virtual void CopyToTexture(Texture& destTexture) = 0;
 
+	/**
+	 * Copy levels [srcLevel, srcLevel + destTexture.GetMipLevels()) of every slice to the levels
+	 * of destTexture, which has the type, format and array size of this and level srcLevel size.
+	 */
+	virtual void CopyLevelsToTexture(Texture& destTexture, uint32_t srcLevel) = 0;
+
 protected:
 	// Help function used to compute mipmap levels
 	static uint32_t CalculateMipmapLevels( uint32_t n );
@@ -147,8 +153,36 @@ public:
 	virtual bool LoadFromByteCode(const String& filename) = 0;
 	virtual bool LoadFromFile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint = "") = 0;
 
+	/**
+	 * Part of LoadFromFile which needs no device, like reading, preprocessing or compiling to
+	 * bytecode. May run on any thread, RenderFactory calls it for batches of shaders in parallel,
+	 * then LoadFromFile with the same arguments on main thread.
+	 */
+	virtual void PrepareFromFile(const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint = "") {}
+
+	/**
+	 * OS paths of shader file and files it includes, set by PrepareFromFile. Files read
+	 * from an archive are not listed.
+	 */
+	inline const vector<String>& GetSourceFiles() const	{ return mSourceFiles; }
+
 protected:
 	ShaderType mShaderType;
+	vector<String> mSourceFiles;
+};
+
+/**
+ * One shader of a batch loaded by RenderFactory::LoadShadersFromFile.
+ */
+struct ShaderLoadDesc
+{
+	ShaderType Type;
+	String Filename;
+	String EntryPoint;
+	vector<ShaderMacro> Macros;
+
+	// Set by LoadShadersFromFile
+	shared_ptr<Shader> Result;
 };
 
 class _ApiExport ShaderPipeline : public GraphicsResouce
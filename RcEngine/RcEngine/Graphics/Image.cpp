@@ -1,5 +1,7 @@
 #include <Graphics/Image.h>
 #include <Graphics/GraphicsResource.h>
+#include <Graphics/BlockCompression.h>
+#include <Graphics/ImageProcessing.h>
 #include <MainApp/Application.h>
 #include <Core/Exception.h>
 #include <fstream>
@@ -32,20 +34,25 @@ void Image::Clear()
 	mValid = false;
 }
 
-uint32_t Image::GetRowPitch( uint32_t level )
+uint32_t Image::GetRowPitch( uint32_t level ) const
 {
 	return mSurfaces[level].RowPitch;
 }
 
-uint32_t Image::GetSlicePitch( uint32_t level )
+uint32_t Image::GetSlicePitch( uint32_t level ) const
 {
 	assert(mType == TT_Texture3D);
 	return mSurfaces[level].SlicePitch;
 }
 
-uint32_t Image::GetSurfaceSize( uint32_t level )
+uint32_t Image::GetSurfaceSize( uint32_t level ) const
 {
-	return 0;
+	// DDS loader fills slice size, image read back from texture only has row pitch
+	uint32_t sliceSize = mSurfaces[level].SlicePitch;
+	if (sliceSize == 0)
+		sliceSize = mSurfaces[level].RowPitch * (std::max)(1U, mHeight >> level);
+
+	return sliceSize * (std::max)(1U, mDepth >> level);
 }
 
 const void* Image::GetLevel( uint32_t level, uint32_t layer /*= 0*/, CubeMapFace face /*= CMF_PositiveX*/ ) const
@@ -72,6 +79,63 @@ void* Image::GetLevel( uint32_t level, uint32_t layer /*= 0*/, CubeMapFace face
 	return mSurfaces[index].pData;
 }
 
+void Image::Create( TextureType type, PixelFormat format, uint32_t width, uint32_t height, uint32_t depth, uint32_t levels, uint32_t layers )
+{
+	Clear();
+
+	uint32_t blockBytes = BlockCompression::GetBlockBytes(format);
+	if (PixelFormatUtils::IsCompressed(format) && blockBytes == 0)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported compressed format", "Image::Create");
+
+	mType = type;
+	mFormat = format;
+	mWidth = width;
+	mHeight = height;
+	mDepth = (type == TT_Texture3D) ? depth : 1;
+	mLevels = levels;
+	mLayers = layers;
+
+	// Surfaces of a chain are contiguous like in a DDS file, all in one allocation
+	vector<SurfaceInfo> levelInfos(mLevels);
+	uint32_t chainSize = 0;
+	for (uint32_t level = 0; level < mLevels; ++level)
+	{
+		uint32_t levelWidth = (std::max)(1U, mWidth >> level);
+		uint32_t levelHeight = (std::max)(1U, mHeight >> level);
+		uint32_t levelDepth = (std::max)(1U, mDepth >> level);
+
+		SurfaceInfo& info = levelInfos[level];
+		if (blockBytes)
+		{
+			info.RowPitch = (levelWidth + 3) / 4 * blockBytes;
+			info.SlicePitch = info.RowPitch * ((levelHeight + 3) / 4);
+		}
+		else
+		{
+			info.RowPitch = levelWidth * PixelFormatUtils::GetNumElemBytes(mFormat);
+			info.SlicePitch = info.RowPitch * levelHeight;
+		}
+
+		chainSize += info.SlicePitch * levelDepth;
+	}
+
+	uint32_t numChains = (mType == TT_TextureCube) ? mLayers * CMF_Count : mLayers;
+	uint8_t* pData = new uint8_t[chainSize * numChains];
+
+	for (uint32_t chain = 0; chain < numChains; ++chain)
+	{
+		for (uint32_t level = 0; level < mLevels; ++level)
+		{
+			SurfaceInfo surface = { pData, levelInfos[level].RowPitch, levelInfos[level].SlicePitch };
+			mSurfaces.push_back(surface);
+
+			pData += levelInfos[level].SlicePitch * (std::max)(1U, mDepth >> level);
+		}
+	}
+
+	mValid = true;
+}
+
 bool Image::CopyImageFromTexture( const shared_ptr<Texture>& texture )
 {
 	Clear();
@@ -268,16 +332,6 @@ int WritePfm(const char *fn, int resX, int resY, int channels, const float* data
 	return 0;
 }
 
-float Float16ToFloat( uint16_t fltInt16 )
-{
-	uint32_t fltInt32    =  ((fltInt16 & 0x8000) << 16);
-	fltInt32        |= ((fltInt16 & 0x7fff) << 13) + 0x38000000;
-
-	float fRet;
-	memcpy( &fRet, &fltInt32, sizeof( float ) );
-	return fRet;
-}
-
 }
 
 void Image::SaveImageToFile( const String& filename, int layer, int level)
@@ -287,123 +341,40 @@ void Image::SaveImageToFile( const String& filename, int layer, int level)
 
 	if (mFormat == PF_RGBA8_UNORM)
 	{
-		uint8_t* pixel = (uint8_t*)mSurfaces.at(index).pData;
-		
+		const uint8_t* pixel = (const uint8_t*)mSurfaces.at(index).pData;
+		bool flip = (Application::msApp->GetAppSettings().RHDeviceType != RD_Direct3D11);
+
+		// Pixel32 is BGRA in memory
 		vector<Pixel32> imageData(w*h);
-		
-		if (Application::msApp->GetAppSettings().RHDeviceType != RD_Direct3D11)
+		for (uint32_t j = 0; j < h; j++)
 		{
-			for (uint32_t j = 0; j < h; j++)
-				for(uint32_t i = 0; i < w; i ++)
-				{
-					uint8_t r = pixel[((h-j-1) * w + i)*4 + 0];
-					uint8_t g = pixel[((h-j-1) * w + i)*4 + 1];
-					uint8_t b = pixel[((h-j-1) * w + i)*4 + 2];
-					uint8_t a = pixel[((h-j-1) * w + i)*4 + 3];
-
-					imageData[j*w+i].r = r;
-					imageData[j*w+i].g = g;
-					imageData[j*w+i].b = b;
-					imageData[j*w+i].a = a;
-				}
-		}
-		else
-		{
-			for (uint32_t j = 0; j < h; j++)
-				for(uint32_t i = 0; i < w; i ++)
-				{
-					uint8_t r = pixel[(j * w + i)*4 + 0];
-					uint8_t g = pixel[(j * w + i)*4 + 1];
-					uint8_t b = pixel[(j * w + i)*4 + 2];
-					uint8_t a = pixel[(j * w + i)*4 + 3];
-
-					imageData[j*w+i].r = r;
-					imageData[j*w+i].g = g;
-					imageData[j*w+i].b = b;
-					imageData[j*w+i].a = a;
-				}
+			uint32_t srcRow = flip ? (h-j-1) : j;
+			ImageProcessing::ConvertRow(PF_RGBA8_UNORM, pixel + srcRow * w * 4, PF_BGRA8_UNORM, &imageData[j*w], w);
 		}
 		
 		WriteTGA(filename.c_str(), &imageData[0], w, h);
 	}
-	else if (mFormat == PF_RGBA32F)
-	{		
-		float* pixel = (float*)mSurfaces.at(index).pData;
-
-		vector<float> temp;
-		temp.resize(w * h * 3);
-		float* imageData = &temp[0];
-
-		if (Application::msApp->GetAppSettings().RHDeviceType == RD_Direct3D11)
-		{
-			for (uint32_t j = 0; j < h; j++)
-				for(uint32_t i = 0; i < w; i ++)
-				{
-					float r = pixel[((h-j-1) * w + i)*4 + 0];
-					float g = pixel[((h-j-1) * w + i)*4 + 1];
-					float b = pixel[((h-j-1) * w + i)*4 + 2];
-					float a = pixel[((h-j-1) * w + i)*4 + 3];
-
-					*imageData++ = r;
-					*imageData++ = g;
-					*imageData++ = b;
-				}
-		}
-		else
-		{
-			for (uint32_t j = 0; j < h; j++)
-				for(uint32_t i = 0; i < w; i ++)
-				{
-					float r = pixel[(j * w + i)*4 + 0];
-					float g = pixel[(j * w + i)*4 +1];
-					float b = pixel[(j * w + i)*4 +2];
-					float a = pixel[(j * w + i)*4 +3];
-
-					*imageData++ = r;
-					*imageData++ = g;
-					*imageData++ = b;
-				}
-		}
-
-		WritePfm(filename.c_str(), w, h, 3, &temp[0]);
-	}
-	else if (mFormat == PF_RGBA16F)
+	else if (mFormat == PF_RGBA32F || mFormat == PF_RGBA16F)
 	{
-		uint16_t* pixel = (uint16_t*)mSurfaces.at(index).pData;
+		const uint8_t* pixel = (const uint8_t*)mSurfaces.at(index).pData;
+		uint32_t rowBytes = w * PixelFormatUtils::GetNumElemBytes(mFormat);
+		bool flip = (Application::msApp->GetAppSettings().RHDeviceType == RD_Direct3D11);
 
-		vector<float> temp;
-		temp.resize(w * h * 3);
+		vector<float> temp(w * h * 3), row(w * 4);
 		float* imageData = &temp[0];
 
-		if (Application::msApp->GetAppSettings().RHDeviceType == RD_Direct3D11)
-		{
-			for (uint32_t j = 0; j < h; j++)
-				for(uint32_t i = 0; i < w; i ++)
-				{
-					uint16_t r = pixel[((h-j-1) * w + i)*4 + 0];
-					uint16_t g = pixel[((h-j-1) * w + i)*4 + 1];
-					uint16_t b = pixel[((h-j-1) * w + i)*4 + 2];
-					uint16_t a = pixel[((h-j-1) * w + i)*4 + 3];
-
-					*imageData++ = Float16ToFloat(r);
-					*imageData++ = Float16ToFloat(g);
-					*imageData++ = Float16ToFloat(b);
-				}
-		}
-		else
+		for (uint32_t j = 0; j < h; j++)
 		{
-			for (uint32_t j = 0; j < h; j++)
-				for(uint32_t i = 0; i < w; i ++)
-				{
-					uint16_t r = pixel[(j * w + i)*4 + 0];
-					uint16_t g = pixel[(j * w + i)*4 +1];
-					uint16_t b = pixel[(j * w + i)*4 +2];
-					uint16_t a = pixel[(j * w + i)*4 +3];
-
-					*imageData++ = Float16ToFloat(r);
-					*imageData++ = Float16ToFloat(g);
-					*imageData++ = Float16ToFloat(b);
-				}
+			uint32_t srcRow = flip ? (h-j-1) : j;
+			ImageProcessing::UnpackRow(mFormat, pixel + srcRow * rowBytes, &row[0], w);
+
+			// PFM has no alpha
+			for(uint32_t i = 0; i < w; i ++)
+			{
+				*imageData++ = row[i*4 + 0];
+				*imageData++ = row[i*4 + 1];
+				*imageData++ = row[i*4 + 2];
+			}
 		}
 
 		WritePfm(filename.c_str(), w, h, 3, &temp[0]);
@@ -13,7 +13,29 @@ public:
 	Image();
 	~Image();
 
-	bool LoadImageFromDDS(const String& filename);
+	/**
+	 * Load DDS from file, levels more detailed than firstLevel are skipped and not read, image
+	 * size is the size of firstLevel then. 
+	 */
+	bool LoadImageFromDDS(const String& filename, uint32_t firstLevel = 0);
+	bool LoadImageFromDDS(Stream& stream, uint32_t firstLevel = 0);
+
+	// Only read DDS header, surfaces have pitches but no data
+	bool LoadImageInfoFromDDS(const String& filename);
+	bool LoadImageInfoFromDDS(Stream& stream);
+
+	/**
+	 * Write all layers and levels to a DDS file with DX10 header extension. Format must have
+	 * a DXGI equivalent.
+	 */
+	bool SaveImageToDDS(const String& filename) const;
+
+	/**
+	 * Allocate surfaces of all layers and levels with tightly packed rows, contents are
+	 * undefined. Compressed formats must be supported by BlockCompression.
+	 */
+	void Create(TextureType type, PixelFormat format, uint32_t width, uint32_t height, uint32_t depth, uint32_t levels, uint32_t layers);
+
 	void SaveImageToFile(const String& filename, int layer = 0, int level = 0);
 	void SaveLinearDepthToFile(const String& filename, float projM33, float projM43);
 
@@ -26,9 +48,12 @@ public:
 	inline PixelFormat GetFormat() const	{ assert(mValid); return mFormat; }
 	inline TextureType GetType() const		{ assert(mValid); return mType; }
 
-	uint32_t GetRowPitch(uint32_t level);
-	uint32_t GetSlicePitch(uint32_t level);
-	uint32_t GetSurfaceSize(uint32_t level);
+	uint32_t GetRowPitch(uint32_t level) const;
+	uint32_t GetSlicePitch(uint32_t level) const;
+	uint32_t GetSurfaceSize(uint32_t level) const;
+
+	// Number of surfaces with a mip chain each, layers times faces for cube maps
+	uint32_t GetNumChains() const			{ assert(mValid); return mType == TT_TextureCube ? mLayers * CMF_Count : mLayers; }
 	
 	const void* GetLevel(uint32_t level, uint32_t layer = 0, CubeMapFace face = CMF_PositiveX) const;
 	void* GetLevel(uint32_t level, uint32_t layer = 0, CubeMapFace face = CMF_PositiveX);
@@ -37,6 +62,7 @@ public:
 
 private:
 	void Clear();
+	bool LoadDDS(Stream& stream, uint32_t firstLevel, bool headerOnly);
 	
 private:
 
@@ -0,0 +1,888 @@
+#include <Graphics/ImageProcessing.h>
+#include <Graphics/BlockCompression.h>
+#include <Graphics/Image.h>
+#include <Core/JobSystem.h>
+#include <Core/CpuInfo.h>
+#include <Core/Exception.h>
+#include <emmintrin.h>
+
+namespace RcEngine {
+
+namespace {
+
+// Pixels per job of conversion and filtering
+const uint32_t PixelGrainSize = 16384;
+
+// Pixels converted at once through a float row on the stack
+const uint32_t ConvertChunkSize = 256;
+
+// Kaiser window half width in destination pixels and its shape parameter
+const float KaiserWidth = 3.0f;
+const float KaiserAlpha = 4.0f;
+
+ImageProcessing::CodePath gCodePath = ImageProcessing::Path_Auto;
+
+enum RowLayout
+{
+	RL_None,
+	RL_RGBA8,
+	RL_BGRA8,
+	RL_RGBA16F,
+	RL_RGBA32F
+};
+
+RowLayout GetRowLayout( PixelFormat format )
+{
+	switch (format)
+	{
+	case PF_RGBA8_UNORM:
+	case PF_SRGB8_ALPHA8_UNORM:
+		return RL_RGBA8;
+	case PF_BGRA8_UNORM:
+	case PF_SBGR8_ALPHA8_UNORM:
+		return RL_BGRA8;
+	case PF_RGBA16F:
+		return RL_RGBA16F;
+	case PF_RGBA32F:
+		return RL_RGBA32F;
+	default:
+		return RL_None;
+	}
+}
+
+/**
+ * RGBA8 format block compressed pixels are encoded from and decoded to.
+ */
+PixelFormat GetBlockPixelFormat( PixelFormat format )
+{
+	return PixelFormatUtils::IsSRGB(format) ? PF_SRGB8_ALPHA8_UNORM : PF_RGBA8_UNORM;
+}
+
+bool UseSSE()
+{
+	return gCodePath != ImageProcessing::Path_Scalar && CpuInfo::HasSSE2();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// sRGB
+
+double SRGBToLinear( double value )
+{
+	return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+}
+
+/**
+ * Decode table and the linear values where the rounded encoding steps to the next code,
+ * built at static initialization so jobs never race on them.
+ */
+struct SRGBTables
+{
+	SRGBTables()
+	{
+		for (uint32_t i = 0; i < 256; ++i)
+			ToLinear[i] = float(SRGBToLinear(i / 255.0));
+
+		for (uint32_t i = 0; i < 255; ++i)
+			Thresholds[i] = float(SRGBToLinear((i + 0.5) / 255.0));
+	}
+
+	float ToLinear[256];
+	float Thresholds[255];
+};
+
+const SRGBTables gSRGBTables;
+
+inline uint8_t LinearToSRGB8( float value )
+{
+	// Number of thresholds not above value by a fixed 8 step search, NaN encodes to 0
+	uint32_t index = 0;
+	for (uint32_t step = 128; step > 0; step >>= 1)
+		index += (value >= gSRGBTables.Thresholds[index + step - 1]) ? step : 0;
+
+	return uint8_t(index);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Half float, branch free except for specials so scalar and SSE agree bit for bit
+
+union FloatBits
+{
+	uint32_t u;
+	float f;
+};
+
+inline float HalfToFloatScalar( uint16_t value )
+{
+	FloatBits magic, result;
+	magic.u = (254 - 15) << 23;
+
+	// Multiply rebiases the exponent and normalizes denormals
+	result.u = uint32_t(value & 0x7FFF) << 13;
+	result.f *= magic.f;
+	if ((value & 0x7FFF) > 0x7BFF)
+		result.u |= 255 << 23;
+
+	result.u |= uint32_t(value & 0x8000) << 16;
+	return result.f;
+}
+
+inline uint16_t FloatToHalfScalar( float value )
+{
+	FloatBits bits, subnormalMagic;
+	subnormalMagic.u = ((127 - 15) + (23 - 10) + 1) << 23;
+
+	bits.f = value;
+	uint32_t sign = bits.u & 0x80000000u;
+	bits.u ^= sign;
+
+	uint32_t result;
+	if (bits.u >= (127 + 16) << 23)
+	{
+		// Overflow to infinity, NaN stays a quiet NaN
+		result = (bits.u > (255 << 23)) ? 0x7E00 : 0x7C00;
+	}
+	else if (bits.u < (127 - 14) << 23)
+	{
+		// Denormal or zero, the add rounds the mantissa
+		bits.f += subnormalMagic.f;
+		result = bits.u - subnormalMagic.u;
+	}
+	else
+	{
+		// Rebias exponent and round to nearest even
+		uint32_t mantissaOdd = (bits.u >> 13) & 1;
+		bits.u += 0xFFF - ((127 - 15) << 23) + mantissaOdd;
+		result = bits.u >> 13;
+	}
+
+	return uint16_t(result | (sign >> 16));
+}
+
+inline __m128 HalfToFloatSSE( __m128i halves )
+{
+	const __m128i mask = _mm_set1_epi32(0x7FFF);
+	const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+	const __m128i infNanThreshold = _mm_set1_epi32(0x7BFF);
+	const __m128 infNanExponent = _mm_castsi128_ps(_mm_set1_epi32(255 << 23));
+
+	__m128i exponentMantissa = _mm_and_si128(halves, mask);
+	__m128i sign = _mm_slli_epi32(_mm_xor_si128(halves, exponentMantissa), 16);
+	__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)), magic);
+	__m128 infNan = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(exponentMantissa, infNanThreshold)), infNanExponent);
+
+	return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), infNan));
+}
+
+/**
+ * Halves in the low 16 bits of each lane, sign extended so they can be packed with
+ * signed saturation.
+ */
+inline __m128i FloatToHalfSSE( __m128 value )
+{
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	const __m128i halfMax = _mm_set1_epi32((127 + 16) << 23);
+	const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+	const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+	__m128 sign = _mm_and_ps(value, signMask);
+	__m128 absolute = _mm_xor_ps(value, sign);
+	__m128i absoluteBits = _mm_castps_si128(absolute);
+
+	__m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+	__m128i isRegular = _mm_cmpgt_epi32(halfMax, absoluteBits);
+	__m128i infNan = _mm_or_si128(_mm_and_si128(isNan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+	__m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absoluteBits);
+	__m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+	__m128i mantissaOdd = _mm_srli_epi32(_mm_slli_epi32(absoluteBits, 31 - 13), 31);
+	__m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(absoluteBits, normalBias), mantissaOdd), 13);
+
+	__m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+	__m128i result = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infNan));
+
+	return _mm_or_si128(result, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Row unpack and pack
+
+inline float ClampUnit( float value )
+{
+	// NaN clamps to 0 like the SSE path
+	value = value > 0.0f ? value : 0.0f;
+	return value < 1.0f ? value : 1.0f;
+}
+
+void UnpackRowScalar( RowLayout layout, bool srgb, const void* src, float* dest, uint32_t count )
+{
+	switch (layout)
+	{
+	case RL_RGBA8:
+	case RL_BGRA8:
+		{
+			const uint8_t* pixel = static_cast<const uint8_t*>(src);
+			uint32_t r = (layout == RL_RGBA8) ? 0 : 2;
+			for (uint32_t i = 0; i < count; ++i, pixel += 4, dest += 4)
+			{
+				if (srgb)
+				{
+					dest[0] = gSRGBTables.ToLinear[pixel[r]];
+					dest[1] = gSRGBTables.ToLinear[pixel[1]];
+					dest[2] = gSRGBTables.ToLinear[pixel[2-r]];
+				}
+				else
+				{
+					dest[0] = pixel[r] * (1.0f / 255.0f);
+					dest[1] = pixel[1] * (1.0f / 255.0f);
+					dest[2] = pixel[2-r] * (1.0f / 255.0f);
+				}
+				dest[3] = pixel[3] * (1.0f / 255.0f);
+			}
+		}
+		break;
+	case RL_RGBA16F:
+		{
+			const uint16_t* halves = static_cast<const uint16_t*>(src);
+			for (uint32_t i = 0; i < count * 4; ++i)
+				dest[i] = HalfToFloatScalar(halves[i]);
+		}
+		break;
+	case RL_RGBA32F:
+		memcpy(dest, src, count * 16);
+		break;
+	default:
+		break;
+	}
+}
+
+void PackRowScalar( RowLayout layout, bool srgb, const float* src, void* dest, uint32_t count )
+{
+	switch (layout)
+	{
+	case RL_RGBA8:
+	case RL_BGRA8:
+		{
+			uint8_t* pixel = static_cast<uint8_t*>(dest);
+			uint32_t r = (layout == RL_RGBA8) ? 0 : 2;
+			for (uint32_t i = 0; i < count; ++i, pixel += 4, src += 4)
+			{
+				if (srgb)
+				{
+					pixel[r] = LinearToSRGB8(src[0]);
+					pixel[1] = LinearToSRGB8(src[1]);
+					pixel[2-r] = LinearToSRGB8(src[2]);
+				}
+				else
+				{
+					pixel[r] = uint8_t(ClampUnit(src[0]) * 255.0f + 0.5f);
+					pixel[1] = uint8_t(ClampUnit(src[1]) * 255.0f + 0.5f);
+					pixel[2-r] = uint8_t(ClampUnit(src[2]) * 255.0f + 0.5f);
+				}
+				pixel[3] = uint8_t(ClampUnit(src[3]) * 255.0f + 0.5f);
+			}
+		}
+		break;
+	case RL_RGBA16F:
+		{
+			uint16_t* halves = static_cast<uint16_t*>(dest);
+			for (uint32_t i = 0; i < count * 4; ++i)
+				halves[i] = FloatToHalfScalar(src[i]);
+		}
+		break;
+	case RL_RGBA32F:
+		memcpy(dest, src, count * 16);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * SSE2 for linear formats, sRGB goes through the scalar tables, there is no gather.
+ */
+void UnpackRowSSE( RowLayout layout, bool srgb, const void* src, float* dest, uint32_t count )
+{
+	if (srgb || layout == RL_RGBA32F)
+	{
+		UnpackRowScalar(layout, srgb, src, dest, count);
+		return;
+	}
+
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t i = 0;
+
+	if (layout == RL_RGBA8 || layout == RL_BGRA8)
+	{
+		const uint8_t* pixels = static_cast<const uint8_t*>(src);
+		const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+			__m128i low = _mm_unpacklo_epi8(bytes, zero);
+			__m128i high = _mm_unpackhi_epi8(bytes, zero);
+
+			__m128 p0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale);
+			__m128 p1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale);
+			__m128 p2 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale);
+			__m128 p3 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale);
+
+			if (layout == RL_BGRA8)
+			{
+				p0 = _mm_shuffle_ps(p0, p0, _MM_SHUFFLE(3, 0, 1, 2));
+				p1 = _mm_shuffle_ps(p1, p1, _MM_SHUFFLE(3, 0, 1, 2));
+				p2 = _mm_shuffle_ps(p2, p2, _MM_SHUFFLE(3, 0, 1, 2));
+				p3 = _mm_shuffle_ps(p3, p3, _MM_SHUFFLE(3, 0, 1, 2));
+			}
+
+			_mm_storeu_ps(dest + i * 4 + 0, p0);
+			_mm_storeu_ps(dest + i * 4 + 4, p1);
+			_mm_storeu_ps(dest + i * 4 + 8, p2);
+			_mm_storeu_ps(dest + i * 4 + 12, p3);
+		}
+
+		UnpackRowScalar(layout, srgb, pixels + i * 4, dest + i * 4, count - i);
+	}
+	else if (layout == RL_RGBA16F)
+	{
+		const uint16_t* halves = static_cast<const uint16_t*>(src);
+
+		for (; i + 2 <= count; i += 2)
+		{
+			__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(halves + i * 4));
+			_mm_storeu_ps(dest + i * 4, HalfToFloatSSE(_mm_unpacklo_epi16(value, zero)));
+			_mm_storeu_ps(dest + i * 4 + 4, HalfToFloatSSE(_mm_unpackhi_epi16(value, zero)));
+		}
+
+		UnpackRowScalar(layout, srgb, halves + i * 4, dest + i * 4, count - i);
+	}
+}
+
+void PackRowSSE( RowLayout layout, bool srgb, const float* src, void* dest, uint32_t count )
+{
+	if (srgb || layout == RL_RGBA32F)
+	{
+		PackRowScalar(layout, srgb, src, dest, count);
+		return;
+	}
+
+	uint32_t i = 0;
+
+	if (layout == RL_RGBA8 || layout == RL_BGRA8)
+	{
+		uint8_t* pixels = static_cast<uint8_t*>(dest);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i p[4];
+			for (uint32_t j = 0; j < 4; ++j)
+			{
+				__m128 value = _mm_loadu_ps(src + (i + j) * 4);
+				if (layout == RL_BGRA8)
+					value = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 0, 1, 2));
+
+				// Max first so NaN becomes 0
+				value = _mm_min_ps(_mm_max_ps(value, zero), one);
+				p[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+			}
+
+			__m128i words = _mm_packs_epi32(p[0], p[1]);
+			__m128i words2 = _mm_packs_epi32(p[2], p[3]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), _mm_packus_epi16(words, words2));
+		}
+
+		PackRowScalar(layout, srgb, src + i * 4, pixels + i * 4, count - i);
+	}
+	else if (layout == RL_RGBA16F)
+	{
+		uint16_t* halves = static_cast<uint16_t*>(dest);
+
+		for (; i + 2 <= count; i += 2)
+		{
+			__m128i p0 = FloatToHalfSSE(_mm_loadu_ps(src + i * 4));
+			__m128i p1 = FloatToHalfSSE(_mm_loadu_ps(src + i * 4 + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(halves + i * 4), _mm_packs_epi32(p0, p1));
+		}
+
+		PackRowScalar(layout, srgb, src + i * 4, halves + i * 4, count - i);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Resampling
+
+/**
+ * Taps of a 1D filter for each destination texel, source indices are clamped to the edge.
+ * Every texel has MaxTaps taps, unused ones have weight 0.
+ */
+struct FilterKernel
+{
+	uint32_t MaxTaps;
+	vector<uint32_t> Indices;
+	vector<float> Weights;
+};
+
+double BesselI0( double x )
+{
+	// Power series, converges fast for the small arguments of a Kaiser window
+	double sum = 1.0, term = 1.0;
+	for (uint32_t k = 1; k < 32; ++k)
+	{
+		term *= (x * 0.5 / k) * (x * 0.5 / k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+double KaiserSinc( double x )
+{
+	if (fabs(x) >= KaiserWidth)
+		return 0.0;
+
+	const double pi = 3.14159265358979323846;
+	double sinc = (x == 0.0) ? 1.0 : sin(pi * x) / (pi * x);
+	double ratio = x / KaiserWidth;
+	return sinc * BesselI0(KaiserAlpha * sqrt(1.0 - ratio * ratio)) / BesselI0(KaiserAlpha);
+}
+
+void BuildKernel( MipFilter filter, uint32_t srcSize, uint32_t destSize, FilterKernel& kernel )
+{
+	double scale = double(srcSize) / destSize;
+	double radius = (filter == MF_Box) ? 0.5 * scale : KaiserWidth * scale;
+
+	kernel.MaxTaps = uint32_t(ceil(2.0 * radius)) + 1;
+	kernel.Indices.assign(destSize * kernel.MaxTaps, 0);
+	kernel.Weights.assign(destSize * kernel.MaxTaps, 0.0f);
+
+	vector<double> weights(kernel.MaxTaps);
+	for (uint32_t x = 0; x < destSize; ++x)
+	{
+		double center = (x + 0.5) * scale;
+		int32_t first = int32_t(floor(center - radius));
+
+		double sum = 0.0;
+		for (uint32_t tap = 0; tap < kernel.MaxTaps; ++tap)
+		{
+			int32_t i = first + int32_t(tap);
+
+			double weight;
+			if (filter == MF_Box)
+			{
+				// Area of the texel covered by the destination texel footprint
+				weight = (std::min)(i + 1.0, center + radius) - (std::max)(double(i), center - radius);
+				weight = (std::max)(weight, 0.0);
+			}
+			else
+				weight = KaiserSinc((i + 0.5 - center) / scale);
+
+			weights[tap] = weight;
+			sum += weight;
+
+			kernel.Indices[x * kernel.MaxTaps + tap] = uint32_t((std::min)((std::max)(i, 0), int32_t(srcSize) - 1));
+		}
+
+		for (uint32_t tap = 0; tap < kernel.MaxTaps; ++tap)
+			kernel.Weights[x * kernel.MaxTaps + tap] = float(weights[tap] / sum);
+	}
+}
+
+/**
+ * Horizontal pass of one row, RGBA float pixels.
+ */
+void FilterRowScalar( const FilterKernel& kernel, const float* src, float* dest, uint32_t destWidth )
+{
+	const uint32_t* indices = &kernel.Indices[0];
+	const float* weights = &kernel.Weights[0];
+
+	for (uint32_t x = 0; x < destWidth; ++x, dest += 4)
+	{
+		float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (uint32_t tap = 0; tap < kernel.MaxTaps; ++tap, ++indices, ++weights)
+		{
+			const float* pixel = src + *indices * 4;
+			for (uint32_t c = 0; c < 4; ++c)
+				sum[c] += *weights * pixel[c];
+		}
+
+		memcpy(dest, sum, sizeof(sum));
+	}
+}
+
+void FilterRowSSE( const FilterKernel& kernel, const float* src, float* dest, uint32_t destWidth )
+{
+	const uint32_t* indices = &kernel.Indices[0];
+	const float* weights = &kernel.Weights[0];
+
+	for (uint32_t x = 0; x < destWidth; ++x, dest += 4)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (uint32_t tap = 0; tap < kernel.MaxTaps; ++tap, ++indices, ++weights)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(*weights), _mm_loadu_ps(src + *indices * 4)));
+
+		_mm_storeu_ps(dest, sum);
+	}
+}
+
+/**
+ * Vertical pass of one destination row, weighted sum of whole source rows.
+ */
+void FilterColumnsScalar( const FilterKernel& kernel, uint32_t y, const float* src, float* dest, uint32_t numFloats )
+{
+	const uint32_t* indices = &kernel.Indices[y * kernel.MaxTaps];
+	const float* weights = &kernel.Weights[y * kernel.MaxTaps];
+
+	for (uint32_t i = 0; i < numFloats; ++i)
+	{
+		float sum = 0.0f;
+		for (uint32_t tap = 0; tap < kernel.MaxTaps; ++tap)
+			sum += weights[tap] * src[indices[tap] * numFloats + i];
+		dest[i] = sum;
+	}
+}
+
+void FilterColumnsSSE( const FilterKernel& kernel, uint32_t y, const float* src, float* dest, uint32_t numFloats )
+{
+	const uint32_t* indices = &kernel.Indices[y * kernel.MaxTaps];
+	const float* weights = &kernel.Weights[y * kernel.MaxTaps];
+
+	// Rows are RGBA, numFloats is a multiple of 4
+	for (uint32_t i = 0; i < numFloats; i += 4)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (uint32_t tap = 0; tap < kernel.MaxTaps; ++tap)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[tap]), _mm_loadu_ps(src + indices[tap] * numFloats + i)));
+		_mm_storeu_ps(dest + i, sum);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void ForEachRow( uint32_t width, uint32_t numRows, bool parallel, const std::function<void(uint32_t, uint32_t)>& kernel )
+{
+	uint32_t grainSize = (std::max)(1U, PixelGrainSize / (std::max)(1U, width));
+	if (parallel && numRows > grainSize)
+		JobSystem::GetSingleton().ParallelFor(0, numRows, grainSize, kernel);
+	else
+		kernel(0, numRows);
+}
+
+inline const uint8_t* GetChainLevel( const Image& image, uint32_t chain, uint32_t level )
+{
+	if (image.GetType() == TT_TextureCube)
+		return static_cast<const uint8_t*>(image.GetLevel(level, chain / CMF_Count, CubeMapFace(chain % CMF_Count)));
+	return static_cast<const uint8_t*>(image.GetLevel(level, chain));
+}
+
+inline uint8_t* GetChainLevel( Image& image, uint32_t chain, uint32_t level )
+{
+	return const_cast<uint8_t*>(GetChainLevel(const_cast<const Image&>(image), chain, level));
+}
+
+/**
+ * Convert rows of a 2D surface between row formats.
+ */
+void ConvertRows( PixelFormat srcFormat, const uint8_t* src, uint32_t srcPitch, PixelFormat destFormat, uint8_t* dest, uint32_t destPitch,
+	              uint32_t width, uint32_t numRows, bool parallel )
+{
+	ForEachRow(width, numRows, parallel, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t y = begin; y < end; ++y)
+			ImageProcessing::ConvertRow(srcFormat, src + y * srcPitch, destFormat, dest + y * destPitch, width);
+	});
+}
+
+/**
+ * Rows of a surface to unpack from, block compressed surfaces are decoded to RGBA8 first.
+ */
+const uint8_t* GetSourceRows( PixelFormat& format, const uint8_t* src, uint32_t width, uint32_t height, vector<uint8_t>& decoded, bool parallel )
+{
+	if (BlockCompression::IsSupported(format))
+	{
+		decoded.resize(width * height * 4);
+		BlockCompression::Decode(format, src, (width + 3) / 4 * BlockCompression::GetBlockBytes(format), width, height, &decoded[0], width * 4, parallel);
+
+		format = GetBlockPixelFormat(format);
+		return &decoded[0];
+	}
+
+	return src;
+}
+
+void PackSurface( PixelFormat format, const float* src, uint32_t width, uint32_t height, uint8_t* dest, bool parallel )
+{
+	vector<uint8_t> unpacked;
+	PixelFormat rowFormat = format;
+	uint8_t* rows = dest;
+
+	if (BlockCompression::IsSupported(format))
+	{
+		unpacked.resize(width * height * 4);
+		rowFormat = GetBlockPixelFormat(format);
+		rows = &unpacked[0];
+	}
+
+	uint32_t rowPitch = width * PixelFormatUtils::GetNumElemBytes(rowFormat);
+	ForEachRow(width, height, parallel, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t y = begin; y < end; ++y)
+			ImageProcessing::PackRow(rowFormat, src + y * width * 4, rows + y * rowPitch, width);
+	});
+
+	if (rows != dest)
+		BlockCompression::Encode(format, rows, rowPitch, width, height, dest, (width + 3) / 4 * BlockCompression::GetBlockBytes(format), parallel);
+}
+
+/**
+ * Convert one 2D surface, block compressed formats go through RGBA8.
+ */
+void ConvertSurface( PixelFormat srcFormat, const uint8_t* src, PixelFormat destFormat, uint8_t* dest, uint32_t width, uint32_t height, bool parallel )
+{
+	vector<uint8_t> decoded, encoded;
+
+	if (BlockCompression::IsSupported(srcFormat))
+	{
+		decoded.resize(width * height * 4);
+		BlockCompression::Decode(srcFormat, src, (width + 3) / 4 * BlockCompression::GetBlockBytes(srcFormat), width, height, &decoded[0], width * 4, parallel);
+
+		src = &decoded[0];
+		srcFormat = GetBlockPixelFormat(srcFormat);
+	}
+
+	PixelFormat rowFormat = destFormat;
+	uint8_t* rows = dest;
+	if (BlockCompression::IsSupported(destFormat))
+	{
+		rowFormat = GetBlockPixelFormat(destFormat);
+		if (rowFormat != srcFormat)
+		{
+			encoded.resize(width * height * 4);
+			rows = &encoded[0];
+		}
+		else
+			rows = nullptr;
+	}
+
+	if (rows)
+	{
+		ConvertRows(srcFormat, src, width * PixelFormatUtils::GetNumElemBytes(srcFormat), rowFormat, rows,
+			width * PixelFormatUtils::GetNumElemBytes(rowFormat), width, height, parallel);
+	}
+
+	if (BlockCompression::IsSupported(destFormat))
+	{
+		const uint8_t* pixels = rows ? rows : src;
+		BlockCompression::Encode(destFormat, pixels, width * 4, width, height, dest, (width + 3) / 4 * BlockCompression::GetBlockBytes(destFormat), parallel);
+	}
+}
+
+}
+
+bool ImageProcessing::IsRowFormat( PixelFormat format )
+{
+	return GetRowLayout(format) != RL_None;
+}
+
+bool ImageProcessing::IsFormatSupported( PixelFormat format )
+{
+	return IsRowFormat(format) || BlockCompression::IsSupported(format);
+}
+
+void ImageProcessing::UnpackRow( PixelFormat format, const void* src, float* dest, uint32_t count )
+{
+	RowLayout layout = GetRowLayout(format);
+	if (layout == RL_None)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported row format", "ImageProcessing::UnpackRow");
+
+	if (UseSSE())
+		UnpackRowSSE(layout, PixelFormatUtils::IsSRGB(format), src, dest, count);
+	else
+		UnpackRowScalar(layout, PixelFormatUtils::IsSRGB(format), src, dest, count);
+}
+
+void ImageProcessing::PackRow( PixelFormat format, const float* src, void* dest, uint32_t count )
+{
+	RowLayout layout = GetRowLayout(format);
+	if (layout == RL_None)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported row format", "ImageProcessing::PackRow");
+
+	if (UseSSE())
+		PackRowSSE(layout, PixelFormatUtils::IsSRGB(format), src, dest, count);
+	else
+		PackRowScalar(layout, PixelFormatUtils::IsSRGB(format), src, dest, count);
+}
+
+void ImageProcessing::ConvertRow( PixelFormat srcFormat, const void* src, PixelFormat destFormat, void* dest, uint32_t count )
+{
+	if (srcFormat == destFormat)
+	{
+		memcpy(dest, src, count * PixelFormatUtils::GetNumElemBytes(srcFormat));
+		return;
+	}
+
+	const uint8_t* srcPixels = static_cast<const uint8_t*>(src);
+	uint8_t* destPixels = static_cast<uint8_t*>(dest);
+	uint32_t srcBytes = PixelFormatUtils::GetNumElemBytes(srcFormat);
+	uint32_t destBytes = PixelFormatUtils::GetNumElemBytes(destFormat);
+
+	float chunk[ConvertChunkSize * 4];
+	for (uint32_t i = 0; i < count; i += ConvertChunkSize)
+	{
+		uint32_t chunkSize = (std::min)(ConvertChunkSize, count - i);
+		UnpackRow(srcFormat, srcPixels + i * srcBytes, chunk, chunkSize);
+		PackRow(destFormat, chunk, destPixels + i * destBytes, chunkSize);
+	}
+}
+
+void ImageProcessing::Convert( const Image& src, Image& dest, PixelFormat format, bool parallel )
+{
+	if (!IsFormatSupported(src.GetFormat()) || !IsFormatSupported(format))
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported image format", "ImageProcessing::Convert");
+
+	dest.Create(src.GetType(), format, src.GetWidth(), src.GetHeight(), src.GetDepth(), src.GetLevels(), src.GetLayers());
+
+	for (uint32_t chain = 0; chain < src.GetNumChains(); ++chain)
+	{
+		for (uint32_t level = 0; level < src.GetLevels(); ++level)
+		{
+			uint32_t width = (std::max)(1U, src.GetWidth() >> level);
+			uint32_t height = (std::max)(1U, src.GetHeight() >> level);
+			uint32_t depth = (std::max)(1U, src.GetDepth() >> level);
+
+			const uint8_t* srcLevel = GetChainLevel(src, chain, level);
+			uint8_t* destLevel = GetChainLevel(dest, chain, level);
+
+			if (src.GetFormat() == format)
+			{
+				memcpy(destLevel, srcLevel, src.GetSurfaceSize(level));
+				continue;
+			}
+
+			// Slices of volume textures one by one
+			uint32_t srcSliceSize = src.GetSurfaceSize(level) / depth;
+			uint32_t destSliceSize = dest.GetSurfaceSize(level) / depth;
+			for (uint32_t z = 0; z < depth; ++z)
+				ConvertSurface(src.GetFormat(), srcLevel + z * srcSliceSize, format, destLevel + z * destSliceSize, width, height, parallel);
+		}
+	}
+}
+
+void ImageProcessing::GenerateMipmaps( const Image& src, Image& dest, MipFilter filter, uint32_t numLevels, bool parallel )
+{
+	PixelFormat format = src.GetFormat();
+	if (!IsFormatSupported(format))
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Unsupported image format", "ImageProcessing::GenerateMipmaps");
+
+	if (src.GetType() == TT_Texture3D)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Mipmaps of volume textures are not supported", "ImageProcessing::GenerateMipmaps");
+
+	uint32_t fullLevels = GetNumMipLevels(src.GetWidth(), src.GetHeight());
+	numLevels = numLevels ? (std::min)(numLevels, fullLevels) : fullLevels;
+
+	dest.Create(src.GetType(), format, src.GetWidth(), src.GetHeight(), 1, numLevels, src.GetLayers());
+
+	bool useSSE = UseSSE();
+	auto filterRow = useSSE ? &FilterRowSSE : &FilterRowScalar;
+	auto filterColumns = useSSE ? &FilterColumnsSSE : &FilterColumnsScalar;
+
+	vector<float> current, next, horizontal;
+	vector<uint8_t> decoded;
+	FilterKernel horizontalKernel, verticalKernel;
+
+	for (uint32_t chain = 0; chain < src.GetNumChains(); ++chain)
+	{
+		uint32_t width = src.GetWidth();
+		uint32_t height = src.GetHeight();
+
+		// Level 0 as is, levels below are filtered from float of the previous one so
+		// quantization errors don't accumulate. Level 0 is unpacked row by row as it is
+		// filtered, the largest level is never held in float
+		const uint8_t* srcLevel = GetChainLevel(src, chain, 0);
+		memcpy(GetChainLevel(dest, chain, 0), srcLevel, src.GetSurfaceSize(0));
+
+		PixelFormat rowFormat = format;
+		const uint8_t* srcRows = GetSourceRows(rowFormat, srcLevel, width, height, decoded, parallel);
+		uint32_t srcRowPitch = width * PixelFormatUtils::GetNumElemBytes(rowFormat);
+
+		for (uint32_t level = 1; level < numLevels; ++level)
+		{
+			uint32_t destWidth = (std::max)(1U, width >> 1);
+			uint32_t destHeight = (std::max)(1U, height >> 1);
+
+			BuildKernel(filter, width, destWidth, horizontalKernel);
+			BuildKernel(filter, height, destHeight, verticalKernel);
+
+			horizontal.resize(destWidth * height * 4);
+			next.resize(destWidth * destHeight * 4);
+
+			ForEachRow(width, height, parallel, [&](uint32_t begin, uint32_t end) {
+				vector<float> row(level == 1 ? width * 4 : 0);
+				for (uint32_t y = begin; y < end; ++y)
+				{
+					const float* srcRow;
+					if (level == 1)
+					{
+						ImageProcessing::UnpackRow(rowFormat, srcRows + y * srcRowPitch, &row[0], width);
+						srcRow = &row[0];
+					}
+					else
+						srcRow = &current[y * width * 4];
+
+					filterRow(horizontalKernel, srcRow, &horizontal[y * destWidth * 4], destWidth);
+				}
+			});
+
+			ForEachRow(destWidth * verticalKernel.MaxTaps, destHeight, parallel, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t y = begin; y < end; ++y)
+					filterColumns(verticalKernel, y, &horizontal[0], &next[y * destWidth * 4], destWidth * 4);
+			});
+
+			PackSurface(format, &next[0], destWidth, destHeight, GetChainLevel(dest, chain, level), parallel);
+
+			current.swap(next);
+			width = destWidth;
+			height = destHeight;
+		}
+	}
+}
+
+uint32_t ImageProcessing::GetNumMipLevels( uint32_t width, uint32_t height )
+{
+	uint32_t size = (std::max)(width, height);
+
+	uint32_t numLevels = 1;
+	while (size > 1)
+	{
+		size >>= 1;
+		++numLevels;
+	}
+
+	return numLevels;
+}
+
+float ImageProcessing::HalfToFloat( uint16_t value )
+{
+	return HalfToFloatScalar(value);
+}
+
+uint16_t ImageProcessing::FloatToHalf( float value )
+{
+	return FloatToHalfScalar(value);
+}
+
+void ImageProcessing::SetCodePath( CodePath path )
+{
+	gCodePath = path;
+}
+
+ImageProcessing::CodePath ImageProcessing::GetCodePath()
+{
+	return gCodePath;
+}
+
+} // Namespace RcEngine
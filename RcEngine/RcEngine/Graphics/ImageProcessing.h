@@ -0,0 +1,87 @@
+#ifndef ImageProcessing_h__
+#define ImageProcessing_h__
+
+#include <Core/Prerequisites.h>
+#include <Graphics/PixelFormat.h>
+
+namespace RcEngine {
+
+class Image;
+
+enum MipFilter
+{
+	MF_Box,
+
+	// Kaiser windowed sinc, sharper than box, may ring slightly around hard edges
+	MF_Kaiser
+};
+
+/**
+ * CPU image processing on Image: format conversion and mip generation, for the texture
+ * cooker and for DDS files loaded without mips. Pixels go through linear float RGBA, sRGB
+ * formats are decoded to linear and encoded back, so filtering is gamma correct. Block
+ * compressed formats are decoded and encoded by BlockCompression.
+ *
+ * Row formats are RGBA8, BGRA8, their sRGB variants, RGBA16F and RGBA32F. Conversion and
+ * filtering have scalar and SSE2 paths, picked at runtime by CpuInfo, and split rows over
+ * JobSystem workers if parallel.
+ */
+class _ApiExport ImageProcessing
+{
+public:
+	enum CodePath
+	{
+		Path_Auto,
+		Path_Scalar,
+		Path_SSE
+	};
+
+public:
+	static bool IsRowFormat(PixelFormat format);
+
+	/**
+	 * Row formats and block compressed formats BlockCompression handles.
+	 */
+	static bool IsFormatSupported(PixelFormat format);
+
+	/**
+	 * Unpack count pixels to linear float RGBA.
+	 */
+	static void UnpackRow(PixelFormat format, const void* src, float* dest, uint32_t count);
+
+	/**
+	 * Pack count linear float RGBA pixels, clamped to [0, 1] for normalized formats.
+	 */
+	static void PackRow(PixelFormat format, const float* src, void* dest, uint32_t count);
+
+	static void ConvertRow(PixelFormat srcFormat, const void* src, PixelFormat destFormat, void* dest, uint32_t count);
+
+	/**
+	 * Convert all layers and levels of src into dest of another format.
+	 */
+	static void Convert(const Image& src, Image& dest, PixelFormat format, bool parallel = true);
+
+	/**
+	 * Filter numLevels, or a full chain if 0, from level 0 of src into dest of the same format.
+	 * 1D, 2D and cube textures and arrays of them, edges are clamped.
+	 */
+	static void GenerateMipmaps(const Image& src, Image& dest, MipFilter filter, uint32_t numLevels = 0, bool parallel = true);
+
+	static uint32_t GetNumMipLevels(uint32_t width, uint32_t height);
+
+	/**
+	 * IEEE half conversion, round to nearest even, denormals, infinity and NaN preserved.
+	 */
+	static float HalfToFloat(uint16_t value);
+	static uint16_t FloatToHalf(float value);
+
+	/**
+	 * Force a code path, for benchmarks and tests. Unsupported paths fall back to scalar.
+	 */
+	static void SetCodePath(CodePath path);
+	static CodePath GetCodePath();
+};
+
+} // Namespace RcEngine
+
+#endif // ImageProcessing_h__
@@ -0,0 +1,158 @@
+#include <Graphics/InstanceBatcher.h>
+#include <Graphics/Renderable.h>
+#include <Graphics/Material.h>
+#include <Graphics/RenderDevice.h>
+#include <Graphics/RenderFactory.h>
+#include <Graphics/GraphicsResource.h>
+#include <Graphics/VertexDeclaration.h>
+#include <Core/Environment.h>
+#include <Core/Exception.h>
+
+namespace RcEngine {
+
+// Rows of world matrix, one float4 each
+static const uint32_t NumInstanceTransformRows = 4;
+
+InstanceBatcher::InstanceBatcher()
+	: mInstanceTransformsDirty(false),
+	  mInstanceCapacity(0)
+{
+
+}
+
+InstanceBatcher::~InstanceBatcher()
+{
+
+}
+
+bool InstanceBatcher::IsInstanced( const Renderable& renderable )
+{
+	const shared_ptr<Material>& material = renderable.GetMaterial();
+	return material && material->IsInstancingEnabled() && renderable.GetWorldTransformsCount() == 1;
+}
+
+void InstanceBatcher::BuildBatches( const RenderBucket& bucket )
+{
+	mBatches.clear();
+	mInstanceTransforms.clear();
+	mInstanceTransformsDirty = true;
+
+	const size_t numItems = bucket.size();
+
+	size_t first = 0;
+	while (first < numItems)
+	{
+		Renderable* renderable = bucket[first].Renderable;
+
+		InstanceBatch batch;
+		batch.Items = &bucket[first];
+		batch.NumItems = 1;
+		batch.InstanceStart = 0;
+		batch.Instanced = IsInstanced(*renderable);
+
+		if (batch.Instanced)
+		{
+			const shared_ptr<Material>& material = renderable->GetMaterial();
+			const RenderOperation& operation = *renderable->GetRenderOperation();
+
+			size_t last = first + 1;
+			while (last < numItems)
+			{
+				Renderable* next = bucket[last].Renderable;
+				if (next->GetMaterial() != material || !IsInstanced(*next) || !next->GetRenderOperation()->IsSameGeometry(operation))
+					break;
+				++last;
+			}
+
+			batch.NumItems = uint32_t(last - first);
+			batch.InstanceStart = uint32_t(mInstanceTransforms.size());
+
+			mInstanceTransforms.resize(mInstanceTransforms.size() + batch.NumItems);
+			for (uint32_t i = 0; i < batch.NumItems; ++i)
+				batch.Items[i].Renderable->GetWorldTransforms(&mInstanceTransforms[batch.InstanceStart + i]);
+		}
+
+		mBatches.push_back(batch);
+		first += batch.NumItems;
+	}
+}
+
+void InstanceBatcher::UploadInstanceTransforms()
+{
+	RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
+
+	const uint32_t numInstances = mInstanceTransforms.size();
+	if (numInstances > mInstanceCapacity)
+	{
+		mInstanceCapacity = (std::max)(numInstances, mInstanceCapacity * 2);
+		mInstanceBuffer = factory->CreateVertexBuffer(mInstanceCapacity * sizeof(float4x4), EAH_CPU_Write | EAH_GPU_Read, BufferCreate_Vertex, NULL);
+
+		// Vertex array objects reference the old buffer
+		mInstancedDeclarations.clear();
+	}
+
+	if (numInstances)
+	{
+		const uint32_t dataSize = numInstances * sizeof(float4x4);
+		void* data = mInstanceBuffer->Map(0, dataSize, RMA_Write_Discard);
+		memcpy(data, &mInstanceTransforms[0], dataSize);
+		mInstanceBuffer->UnMap();
+	}
+
+	mInstanceTransformsDirty = false;
+}
+
+const shared_ptr<VertexDeclaration>& InstanceBatcher::GetInstancedDeclaration( const shared_ptr<VertexDeclaration>& vertexDecl, uint32_t instanceSlot )
+{
+	InstancedDeclaration& entry = mInstancedDeclarations[vertexDecl.get()];
+	if (!entry.Instanced)
+	{
+		// Instance elements go last, shader attribute locations follow mesh attributes
+		vector<VertexElement> elements = vertexDecl->GetVertexElements();
+		for (uint32_t row = 0; row < NumInstanceTransformRows; ++row)
+		{
+			VertexElement element(row * sizeof(float4), VEF_Float4, VEU_InstanceTransform, row);
+			element.InputSlot = instanceSlot;
+			element.InstanceStepRate = 1;
+			elements.push_back(element);
+		}
+
+		RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
+		entry.Source = vertexDecl;
+		entry.Instanced = factory->CreateVertexDeclaration(&elements[0], elements.size());
+	}
+
+	return entry.Instanced;
+}
+
+void InstanceBatcher::Render( const InstanceBatch& batch )
+{
+	Renderable* renderable = batch.Items[0].Renderable;
+
+	if (!batch.Instanced)
+	{
+		for (uint32_t i = 0; i < batch.NumItems; ++i)
+			batch.Items[i].Renderable->Render();
+		return;
+	}
+
+	if (mInstanceTransformsDirty)
+		UploadInstanceTransforms();
+
+	// Geometry of first instance plus instance stream in the slot after mesh streams
+	mBatchOperation = *renderable->GetRenderOperation();
+
+	const uint32_t instanceSlot = mBatchOperation.VertexStreams.size();
+	mBatchOperation.VertexDecl = GetInstancedDeclaration(mBatchOperation.VertexDecl, instanceSlot);
+	mBatchOperation.BindVertexStream(instanceSlot, mInstanceBuffer);
+	mBatchOperation.NumInstances = batch.NumItems;
+	mBatchOperation.InstanceStart = batch.InstanceStart;
+
+	EffectTechnique* technique = renderable->GetTechnique();
+
+	renderable->OnRenderBegin();
+	Environment::GetSingleton().GetRenderDevice()->Draw(technique, mBatchOperation);
+	renderable->OnRenderEnd();
+}
+
+} // Namespace RcEngine
@@ -0,0 +1,90 @@
+#ifndef InstanceBatcher_h__
+#define InstanceBatcher_h__
+
+#include <Core/Prerequisites.h>
+#include <Graphics/RenderQueue.h>
+#include <Graphics/RenderOperation.h>
+#include <Math/Matrix.h>
+
+namespace RcEngine {
+
+/**
+ * Consecutive queue items drawn with one draw call. Items of a batch share material, if
+ * instanced they also share geometry and their world matrices are instances
+ * [InstanceStart, InstanceStart + NumItems) of the instance stream.
+ */
+struct _ApiExport InstanceBatch
+{
+	const RenderQueueItem* Items;
+	uint32_t NumItems;
+	uint32_t InstanceStart;
+	bool Instanced;
+};
+
+/**
+ * Merges renderables sharing mesh part and material into instanced draws. Run after the
+ * queue is sorted, RO_None and RO_StateChange keys group items by material and vertex
+ * buffer so instances are adjacent. Depth first orders only batch items of equal depth.
+ *
+ * Only renderables with a single world transform whose material has the _Instancing effect
+ * flag are instanced. Such effects read the world matrix from a per-instance vertex stream
+ * (VEU_InstanceTransform rows) instead of the World parameter, so they must be drawn
+ * through a batcher, even alone. Other renderables get a batch of their own and are drawn
+ * as before.
+ *
+ * BuildBatches only runs on the CPU, instance stream and vertex declarations are created
+ * on first Render.
+ */
+class _ApiExport InstanceBatcher
+{
+public:
+	InstanceBatcher();
+	~InstanceBatcher();
+
+	/**
+	 * Split sorted bucket into batches and pack instance world matrices. Batches point into
+	 * bucket, it must not change before they are rendered.
+	 */
+	void BuildBatches(const RenderBucket& bucket);
+
+	const vector<InstanceBatch>& GetBatches() const				{ return mBatches; }
+	const vector<float4x4>& GetInstanceTransforms() const		{ return mInstanceTransforms; }
+
+	/**
+	 * Draw a batch with technique of its material. Instance matrices are uploaded on first
+	 * draw after BuildBatches.
+	 */
+	void Render(const InstanceBatch& batch);
+
+	/**
+	 * Whether renderable is drawn as an instance.
+	 */
+	static bool IsInstanced(const Renderable& renderable);
+
+private:
+	void UploadInstanceTransforms();
+	const shared_ptr<VertexDeclaration>& GetInstancedDeclaration(const shared_ptr<VertexDeclaration>& vertexDecl, uint32_t instanceSlot);
+
+private:
+	vector<InstanceBatch> mBatches;
+	vector<float4x4> mInstanceTransforms;
+	bool mInstanceTransformsDirty;
+
+	shared_ptr<GraphicsBuffer> mInstanceBuffer;
+	uint32_t mInstanceCapacity;
+
+	// Mesh vertex declaration with instance stream appended. OpenGL vertex array objects
+	// keep the instance buffer, so they are recreated when it grows.
+	struct InstancedDeclaration
+	{
+		shared_ptr<VertexDeclaration> Source;
+		shared_ptr<VertexDeclaration> Instanced;
+	};
+	unordered_map<VertexDeclaration*, InstancedDeclaration> mInstancedDeclarations;
+
+	RenderOperation mBatchOperation;
+};
+
+} // Namespace RcEngine
+
+#endif // InstanceBatcher_h__
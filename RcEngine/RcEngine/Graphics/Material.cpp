@@ -6,6 +6,7 @@
 #include <Graphics/Effect.h>
 #include <Graphics/GraphicsResource.h>
 #include <Graphics/TextureResource.h>
+#include <Graphics/TextureStreamer.h>
 #include <Graphics/RenderState.h>
 #include <Graphics/RenderQueue.h>
 #include <Core/Environment.h>
@@ -45,7 +46,11 @@ uint32_t GetRenderQueueBucket(const String& str)
 namespace RcEngine {
 
 Material::Material( ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
-	: Resource(RT_Material, creator, handle, name, group)
+	: Resource(RT_Material, creator, handle, name, group),
+	  mHasStreamedTextures(false),
+	  mSkinMatricesParam(nullptr),
+	  mWorldInverseUsed(false),
+	  mInstancing(false)
 {
 }
 
@@ -70,7 +75,12 @@ shared_ptr<Resource> Material::Clone()
 
 	retVal->mEffect = mEffect;
 	retVal->mMaterialTextures = mMaterialTextures;
+	retVal->mTextureResources = mTextureResources;
 	retVal->mAutoBindings = mAutoBindings;
+	retVal->mHasStreamedTextures = mHasStreamedTextures;
+	retVal->mSkinMatricesParam = mSkinMatricesParam;
+	retVal->mWorldInverseUsed = mWorldInverseUsed;
+	retVal->mInstancing = mInstancing;
 
 	retVal->SetLoadState(Resource::Loaded);
 
@@ -88,19 +98,30 @@ void Material::SetTexture(const String& name, const shared_ptr<Texture>& texture
 
 	mMaterialTextures[name] = texture;
 	effectParam->SetValue(texture->GetShaderResourceView());
+
+	for (AutoBinding& binding : mAutoBindings)
+	{
+		if (binding.Param == effectParam)
+		{
+			binding.TextureSRV = texture->GetShaderResourceView();
+			binding.StreamedTexture = nullptr;
+		}
+	}
 }
 
-void Material::LoadImpl()
+void Material::PrepareImpl()
 {
 	FileSystem& fileSystem = FileSystem::GetSingleton();
-	RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
-	ResourceManager& resMan = ResourceManager::GetSingleton();
 
 	shared_ptr<Stream> matStream = fileSystem.OpenStream(mResourceName, mGroup);
 	Stream& source = *matStream;	
 
-	XMLDoc doc;
-	XMLNodePtr root = doc.Parse(source);
+	String materialFile;
+	if (fileSystem.FindFile(mResourceName, mGroup, materialFile))
+		AddFileDependency(materialFile);
+
+	mMaterialDoc = std::make_shared<XMLDoc>();
+	XMLNodePtr root = mMaterialRoot = mMaterialDoc->Parse(source);
 
 	// material name 
 	mMaterialName = root->AttributeString("name", "");
@@ -110,30 +131,55 @@ void Material::LoadImpl()
 	String effecFile =  effectNode->AttributeString("name", "");		// file name
 	
 	String parentDir = PathUtil::GetPath(mResourceName);
-	String effectResGroup;
 
 	// Test if a effect exits in the same group as material
 	if( fileSystem.Exits(parentDir + effecFile, mGroup) )
 	{
-		effectResGroup = mGroup;
+		mEffectGroup = mGroup;
 		effecFile = parentDir + effecFile;  // Add material resource directory
 	}
 	else
-		effectResGroup = "General";
+		mEffectGroup = "General";
 	
 	/* Effect name is unique resource ID, but with the effect shader macro, we can define different effect
 	 * with the same file. So the full effect name is the effect file string + shader macro. By this way, 
 	 * we can distinction effects.
 	 */
-	String effectName = effecFile;
+	mEffectName = effecFile;
 	for (XMLNodePtr effectFlagNode = effectNode->FirstNode("Flag"); effectFlagNode; effectFlagNode = effectFlagNode->NextSibling("Flag"))
 	{
 		String flag = effectFlagNode->AttributeString("name", "");
-		effectName += " " + flag;
+		mEffectName += " " + flag;
+
+		if (flag == "_Instancing")
+			mInstancing = true;
 	}
-	
+
+	AddDependency(RT_Effect, mEffectName, mEffectGroup);
+
+	// Parameter type is only known after effect is loaded, for background load treat every value 
+	// naming an existing file as texture, so textures are decoded on loader threads too.
+	if (mBackground)
+	{
+		for (XMLNodePtr paramNode = root->FirstNode("Parameter"); paramNode; paramNode = paramNode->NextSibling("Parameter"))
+		{
+			String texFile = paramNode->AttributeString("value", "");
+			if (!texFile.empty() && paramNode->FirstAttribute("semantic") && fileSystem.Exits(parentDir + texFile, mGroup))
+				AddDependency(RT_Texture, parentDir + texFile, mGroup);
+		}
+	}
+}
+
+void Material::LoadImpl()
+{
+	FileSystem& fileSystem = FileSystem::GetSingleton();
+	ResourceManager& resMan = ResourceManager::GetSingleton();
+
+	XMLNodePtr root = mMaterialRoot;
+	String parentDir = PathUtil::GetPath(mResourceName);
+
 	// load effect
-	mEffect = std::static_pointer_cast<Effect>( resMan.GetResourceByName(RT_Effect, effectName, effectResGroup) );
+	mEffect = std::static_pointer_cast<Effect>( resMan.GetResourceByName(RT_Effect, mEffectName, mEffectGroup) );
 
 	for (XMLNodePtr paramNode = root->FirstNode("Parameter"); paramNode; paramNode = paramNode->NextSibling("Parameter"))
 	{
@@ -158,7 +204,11 @@ void Material::LoadImpl()
 						resGroup = "General";
 
 					shared_ptr<TextureResource> textureRes = resMan.GetResourceByName<TextureResource>(RT_Texture, texturePath, mGroup);
-					SetTexture(effectParam->GetName(), textureRes->GetTexture());		
+					SetTexture(effectParam->GetName(), textureRes->GetTexture());
+					AddReloadDependency(*textureRes);
+
+					// Hold texture resource so it is not evicted while material is alive
+					mTextureResources.push_back(textureRes);		
 				}
 			}
 
@@ -206,20 +256,86 @@ void Material::LoadImpl()
 	{
 		EffectParameter* effectParam = kv.second;
 		if (effectParam->GetParameterUsage() != EPU_Unknown)
-			mAutoBindings.push_back(effectParam);
+		{
+			AutoBinding binding;
+			binding.Param = effectParam;
+			binding.Usage = effectParam->GetParameterUsage();
+			binding.StreamedTexture = nullptr;
+
+			auto texIt = mMaterialTextures.find(effectParam->GetName());
+			if (texIt != mMaterialTextures.end())
+			{
+				binding.TextureSRV = texIt->second->GetShaderResourceView();
+
+				for (const shared_ptr<TextureResource>& textureRes : mTextureResources)
+				{
+					if (textureRes->IsStreamed() && textureRes->GetTexture() == texIt->second)
+					{
+						binding.StreamedTexture = textureRes.get();
+						mHasStreamedTextures = true;
+					}
+				}
+			}
+
+			if (binding.Usage == EPU_WorldInverseTranspose || binding.Usage == EPU_WorldMatrixInverse)
+				mWorldInverseUsed = true;
+
+			mAutoBindings.push_back(binding);
+		}
 	}
 
+	mSkinMatricesParam = mEffect->GetParameterByName("SkinMatrices");
+
 	// Parse render queue bucket
 	if (root->FirstNode("Queue"))
 	{
 		String bucket = root->FirstNode("Queue")->AttributeString("name", "");
 		mQueueBucket = GetRenderQueueBucket(bucket);
 	}
+
+	mMaterialRoot.reset();
+	mMaterialDoc.reset();
+
+	mSize = sizeof(Material);
 }
 
 void Material::UnloadImpl()
 {
+	mMaterialTextures.clear();
+	mTextureResources.clear();
+	mAutoBindings.clear();
+	mHasStreamedTextures = false;
+	mSkinMatricesParam = nullptr;
+	mWorldInverseUsed = false;
+	mInstancing = false;
+	mEffect.reset();
+}
 
+void Material::ReloadImpl()
+{
+	// Load into a scratch material first, this one keeps its content if the file is broken
+	Material reloaded(mCreator, mResourceHandle, mResourceName, mGroup);
+	reloaded.PrepareImpl();
+	reloaded.LoadImpl();
+
+	std::swap(mMaterialName, reloaded.mMaterialName);
+	std::swap(mEffect, reloaded.mEffect);
+	std::swap(mQueueBucket, reloaded.mQueueBucket);
+	std::swap(mAmbient, reloaded.mAmbient);
+	std::swap(mDiffuse, reloaded.mDiffuse);
+	std::swap(mSpecular, reloaded.mSpecular);
+	std::swap(mEmissive, reloaded.mEmissive);
+	std::swap(mPower, reloaded.mPower);
+	std::swap(mMaterialTextures, reloaded.mMaterialTextures);
+	std::swap(mTextureResources, reloaded.mTextureResources);
+	std::swap(mAutoBindings, reloaded.mAutoBindings);
+	std::swap(mHasStreamedTextures, reloaded.mHasStreamedTextures);
+	std::swap(mSkinMatricesParam, reloaded.mSkinMatricesParam);
+	std::swap(mWorldInverseUsed, reloaded.mWorldInverseUsed);
+	std::swap(mInstancing, reloaded.mInstancing);
+	std::swap(mEffectName, reloaded.mEffectName);
+	std::swap(mEffectGroup, reloaded.mEffectGroup);
+	std::swap(mSize, reloaded.mSize);
 }
 
 shared_ptr<Resource> Material::FactoryFunc( ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
@@ -243,22 +359,28 @@ void Material::SetCurrentTechnique( uint32_t index )
 }
 
 void Material::ApplyMaterial( const float4x4& world )
+{
+	ApplyMaterial(world, mWorldInverseUsed ? world.Inverse() : world);
+}
+
+void Material::ApplyMaterial( const float4x4& world, const float4x4& worldInverse )
 {
 	RenderDevice* renderDevice = Environment::GetSingleton().GetRenderDevice();
-	const shared_ptr<Camera> camera = renderDevice->GetCurrentFrameBuffer()->GetCamera();
+	const Camera& camera = *(renderDevice->GetCurrentFrameBuffer()->GetCamera());
 
-	for (EffectParameter* effectParam : mAutoBindings)
+	for (const AutoBinding& binding : mAutoBindings)
 	{
-		switch (effectParam->GetParameterUsage())
+		EffectParameter* effectParam = binding.Param;
+		switch (binding.Usage)
 		{
 		case EPU_WorldMatrix:			{ effectParam->SetValue(world); } break;
-		case EPU_ViewMatrix:			{ effectParam->SetValue(camera->GetViewMatrix()); }	break;
-		case EPU_ProjectionMatrix:		{ effectParam->SetValue(camera->GetEngineProjMatrix()); } break;
-		case EPU_WorldViewMatrix:		{ effectParam->SetValue(world * camera->GetViewMatrix()); }	break;
-		case EPU_ViewProjectionMatrix:  { effectParam->SetValue(camera->GetEngineViewProjMatrix()); } break;	
-		case EPU_WorldViewProjection:   { effectParam->SetValue(world * camera->GetEngineViewProjMatrix()); } break;
-		case EPU_WorldInverseTranspose: { effectParam->SetValue(world.Inverse().Transpose()); } break;
-		case EPU_WorldMatrixInverse:	{ effectParam->SetValue(world.Inverse()); } break;
+		case EPU_ViewMatrix:			{ effectParam->SetValue(camera.GetViewMatrix()); }	break;
+		case EPU_ProjectionMatrix:		{ effectParam->SetValue(camera.GetEngineProjMatrix()); } break;
+		case EPU_WorldViewMatrix:		{ effectParam->SetValue(world * camera.GetViewMatrix()); }	break;
+		case EPU_ViewProjectionMatrix:  { effectParam->SetValue(camera.GetEngineViewProjMatrix()); } break;	
+		case EPU_WorldViewProjection:   { effectParam->SetValue(world * camera.GetEngineViewProjMatrix()); } break;
+		case EPU_WorldInverseTranspose: { effectParam->SetValue(worldInverse.Transpose()); } break;
+		case EPU_WorldMatrixInverse:	{ effectParam->SetValue(worldInverse); } break;
 		/*case EPU_ViewMatrixInverse:
 			{
 				effectParam->SetValue(camera->GetInvViewMatrix());
@@ -269,20 +391,40 @@ void Material::ApplyMaterial( const float4x4& world )
 				effectParam->SetValue(camera->GetInvProjMatrix());
 			}
 			break;*/
-		case EPU_Camera_Position:         { effectParam->SetValue(camera->GetPosition()); } break;
+		case EPU_Camera_Position:         { effectParam->SetValue(camera.GetPosition()); } break;
 		case EPU_Material_Ambient_Color:  { effectParam->SetValue(mAmbient); } break;
 		case EPU_Material_Diffuse_Color:  { effectParam->SetValue(mDiffuse); } break;
 		case EPU_Material_Specular_Color: { effectParam->SetValue(mSpecular); } break;
 		case EPU_Material_Power:		  { effectParam->SetValue(mPower); } break;
 		case EPU_Material_DiffuseMap:
 		case EPU_Material_SpecularMap:
-		case EPU_Material_NormalMap:	  { effectParam->SetValue(mMaterialTextures[effectParam->GetName()]->GetShaderResourceView()); } break;
+		case EPU_Material_NormalMap:
+			{
+				if (binding.StreamedTexture)
+					effectParam->SetValue(binding.StreamedTexture->GetTexture()->GetShaderResourceView());
+				else if (binding.TextureSRV)
+					effectParam->SetValue(binding.TextureSRV);
+			}
+			break;
 		default:
 			{ }
 		}
 	}
 }
 
+void Material::RequestTextureDensity( float screenSize )
+{
+	if (!mHasStreamedTextures)
+		return;
+
+	TextureStreamer& streamer = TextureStreamer::GetSingleton();
+	for (const shared_ptr<TextureResource>& textureRes : mTextureResources)
+	{
+		if (textureRes->IsStreamed())
+			streamer.RequestScreenSize(*textureRes, screenSize);
+	}
+}
+
 
 
 } // Namespace RcEngine
\ No newline at end of file
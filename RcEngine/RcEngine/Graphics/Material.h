@@ -14,6 +14,10 @@ namespace RcEngine {
 	
 static const int32_t MaxMaterialTextures = 16;
 
+class XMLDoc;
+class XMLNode;
+class TextureResource;
+
 struct _ApiExport MaterialParameter
 {
 	String Name;
@@ -49,12 +53,32 @@ public:
 	// Apply shader parameter before rendering, called by renderable
 	void ApplyMaterial(const float4x4& world = float4x4::Identity());
 
+	// Same as above with world inverse computed by caller, which can cache it across draws
+	void ApplyMaterial(const float4x4& world, const float4x4& worldInverse);
+
+	// Whether auto bindings need world inverse, worldInverse is ignored otherwise
+	bool IsWorldInverseUsed() const						{ return mWorldInverseUsed; }
+
+	// Effect skin matrices parameter, null if effect has no skinning
+	EffectParameter* GetSkinMatricesParameter() const	{ return mSkinMatricesParam; }
+
+	// Effect compiled with _Instancing flag, world matrix comes from per-instance stream
+	bool IsInstancingEnabled() const					{ return mInstancing; }
+
+	/**
+	 * Request mip levels of streamed textures for an object covering screenSize of screen
+	 * height, called for each visible draw.
+	 */
+	void RequestTextureDensity(float screenSize);
+
 	shared_ptr<Resource> Clone();
 
 protected:
 
+	void PrepareImpl();
 	void LoadImpl();
     void UnloadImpl();
+	void ReloadImpl();
 
 public:
 	static shared_ptr<Resource> FactoryFunc(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group);
@@ -73,7 +97,28 @@ protected:
 	float mPower;
 	
 	unordered_map<String, shared_ptr<Texture> > mMaterialTextures;
-	vector<EffectParameter*> mAutoBindings;
+	vector<shared_ptr<TextureResource> > mTextureResources;
+
+	// Parameters resolved once at load, so applying material doesn't look up anything by name
+	struct AutoBinding
+	{
+		EffectParameter* Param;
+		EffectParameterUsage Usage;
+		shared_ptr<ShaderResourceView> TextureSRV;	// Material maps only
+		TextureResource* StreamedTexture;			// Texture object changes when mips are streamed
+	};
+	vector<AutoBinding> mAutoBindings;
+	bool mHasStreamedTextures;
+
+	EffectParameter* mSkinMatricesParam;
+	bool mWorldInverseUsed;
+	bool mInstancing;
+
+	// Parsed in PrepareImpl, released after LoadImpl
+	shared_ptr<XMLDoc> mMaterialDoc;
+	shared_ptr<XMLNode> mMaterialRoot;
+	String mEffectName;
+	String mEffectGroup;
 };
 
 
@@ -6,6 +6,7 @@
 #include <Graphics/VertexDeclaration.h>
 #include <Graphics/GraphicsResource.h>
 #include <Graphics/Skeleton.h>
+#include <Graphics/CpuSkinning.h>
 #include <Core/Environment.h>
 #include <Core/Exception.h>
 #include <Core/Loger.h>
@@ -20,6 +21,33 @@
 
 namespace RcEngine {
 
+namespace {
+
+template<typename BufferData>
+void ReadBufferData(Stream& source, BufferData& bufferData, uint32_t size)
+{
+	bufferData.Size = size;
+	bufferData.View = source.GetView(source.GetPosition(), size);
+
+	if (bufferData.View)
+	{
+		// Zero copy, data is passed to render factory straight from mapped file
+		source.Seek(source.GetPosition() + size);
+	}
+	else
+	{
+		bufferData.Storage.resize(size);
+		if (size)
+			source.Read(&bufferData.Storage[0], size);
+
+		bufferData.View = size ? &bufferData.Storage[0] : nullptr;
+	}
+}
+
+}
+
+bool Mesh::msBuildSkinningSources = false;
+
 Mesh::Mesh(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
 	: Resource(RT_Mesh, creator, handle, name, group)
 {
@@ -47,16 +75,14 @@ Mesh::~Mesh()
    Index Buffer Data
 */
 
-void Mesh::LoadImpl()
+void Mesh::PrepareImpl()
 {
-	ResourceManager& resMan = ResourceManager::GetSingleton();
 	FileSystem& fileSystem = FileSystem::GetSingleton();
-	RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
 
 	String currMeshDirectory = PathUtil::GetParentPath(mResourceName);
 
-	shared_ptr<Stream> streamPtr = fileSystem.OpenStream(mResourceName, mGroup);
-	Stream& source = *streamPtr;
+	mSourceStream = fileSystem.OpenStream(mResourceName, mGroup);
+	Stream& source = *mSourceStream;
 
 	const uint32_t MeshId = ('M' << 24) | ('E' << 16) | ('S' << 8) | ('H');
 
@@ -64,7 +90,7 @@ void Mesh::LoadImpl()
 	assert(header == MeshId);
 
 	// read mesh name
-	String meshName = source.ReadString();
+	mMeshName = source.ReadString();
 
 	// read bounding box
 	float3 min, max;
@@ -97,8 +123,12 @@ void Mesh::LoadImpl()
 			continue;
 		}
 
-		// add mesh part material resource
-		ResourceManager::GetSingleton().AddResource(RT_Material, matPath, mGroup);
+		// add mesh part material resource, background load brings it in ahead of SubEntity
+		if (mBackground)
+			AddDependency(RT_Material, matPath, mGroup);
+		else
+			ResourceManager::GetSingleton().AddResource(RT_Material, matPath, mGroup);
+
 		mMeshParts.push_back(subMesh);
 	}
 
@@ -109,38 +139,56 @@ void Mesh::LoadImpl()
 	}
 	
 	// Read vertex buffers
-	mVertexBuffers.resize(numVertexBuffers);
+	mVertexBufferData.resize(numVertexBuffers);
 	for (uint32_t i = 0; i < numVertexBuffers; ++i)
 	{
 		uint32_t vertexCount = source.ReadUInt();
 
 		// Read vertex declaration
 		uint32_t veCount = source.ReadUInt();
-		vector<VertexElement> elements(veCount);
+		vector<VertexElement>& elements = mVertexBufferData[i].Elements;
+		elements.resize(veCount);
+
+		uint32_t vertexSize = 0;
 		for (VertexElement& vertexElement : elements)
 		{
 			vertexElement.Offset = source.ReadUInt();
 			vertexElement.Type =  static_cast<VertexElementFormat>(source.ReadUInt());
 			vertexElement.Usage =  static_cast<VertexElementUsage>(source.ReadUInt());
 			vertexElement.UsageIndex = source.ReadUShort();
+
+			vertexSize += VertexElementUtil::GetElementSize(vertexElement);
 		}
 	
-		mVertexBuffers[i].VertexDecl = factory->CreateVertexDeclaration(&elements[0], elements.size());
-		printf("%s, size=%d, count=%d\n", meshName.c_str(), veCount, mVertexBuffers[i].VertexDecl->GetVertexSize());
-
 		// Read vertex buffer
-		uint32_t vertexSize = mVertexBuffers[i].VertexDecl->GetVertexSize();
-		uint32_t vertexBufferSize = vertexSize * vertexCount;
-
-		mVertexBuffers[i].Buffer = factory->CreateVertexBuffer(vertexBufferSize, EAH_GPU_Read | EAH_CPU_Write, BufferCreate_Vertex, nullptr);
+		ReadBufferData(source, mVertexBufferData[i].Data, vertexSize * vertexCount);
+	}
 
-		void* pBuffer = mVertexBuffers[i].Buffer->Map(0, vertexBufferSize, RMA_Write_Discard);
-		source.Read(pBuffer, vertexBufferSize);
-		mVertexBuffers[i].Buffer->UnMap();
+	// Repack skinned vertex buffers here, off the main thread when loaded in background
+	mSkinningSources.clear();
+	if (mSkeleton && msBuildSkinningSources)
+	{
+		mSkinningSources.resize(numVertexBuffers);
+		for (uint32_t i = 0; i < numVertexBuffers; ++i)
+		{
+			const vector<VertexElement>& elements = mVertexBufferData[i].Elements;
+
+			bool skinned = false;
+			for (const VertexElement& element : elements)
+				skinned |= (element.Usage == VEU_BlendWeight);
+
+			if (skinned)
+			{
+				VertexDeclaration vertexDecl(&elements[0], elements.size());
+				uint32_t vertexCount = mVertexBufferData[i].Data.Size / vertexDecl.GetVertexSize();
+				mSkinningSources[i] = std::make_shared<SkinningSource>(vertexDecl, mVertexBufferData[i].Data.View, vertexCount);
+			}
+		}
 	}
 
 	// Read index buffers
 	mIndexBuffers.resize(numIndexBuffers);
+	mIndexBufferData.resize(numIndexBuffers);
 	for (uint32_t i = 0; i < numIndexBuffers; ++i)
 	{
 		uint32_t indexCount = source.ReadUInt();
@@ -158,16 +206,62 @@ void Mesh::LoadImpl()
 		}
 
 		// Read index buffer
-		mIndexBuffers[i].Buffer = factory->CreateIndexBuffer(indexBufferSize, EAH_GPU_Read | EAH_CPU_Write, BufferCreate_Index, nullptr);
-		void* pBuffer = mIndexBuffers[i].Buffer->Map(0, indexBufferSize, RMA_Write_Discard);
-		source.Read(pBuffer, indexBufferSize);
-		mIndexBuffers[i].Buffer->UnMap();
+		ReadBufferData(source, mIndexBufferData[i], indexBufferSize);
 	}
 }
 
-void Mesh::UnloadImpl()
+void Mesh::LoadImpl()
+{
+	RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
+
+	// Create GPU buffers from data read in PrepareImpl
+	mVertexBuffers.resize(mVertexBufferData.size());
+	for (size_t i = 0; i < mVertexBufferData.size(); ++i)
+	{
+		vector<VertexElement>& elements = mVertexBufferData[i].Elements;
+		mVertexBuffers[i].VertexDecl = factory->CreateVertexDeclaration(&elements[0], elements.size());
+
+		ElementInitData initData;
+		initData.pData = mVertexBufferData[i].Data.View;
+		initData.rowPitch = mVertexBufferData[i].Data.Size;
+		initData.slicePitch = 0;
+
+		mVertexBuffers[i].Buffer = factory->CreateVertexBuffer(initData.rowPitch, EAH_GPU_Read | EAH_CPU_Write, BufferCreate_Vertex, &initData);
+	}
+
+	for (size_t i = 0; i < mIndexBufferData.size(); ++i)
+	{
+		ElementInitData initData;
+		initData.pData = mIndexBufferData[i].View;
+		initData.rowPitch = mIndexBufferData[i].Size;
+		initData.slicePitch = 0;
+
+		mIndexBuffers[i].Buffer = factory->CreateIndexBuffer(initData.rowPitch, EAH_GPU_Read | EAH_CPU_Write, BufferCreate_Index, &initData);
+	}
+
+	mSize = sizeof(Mesh) + mMeshParts.size() * sizeof(MeshPart);
+	for (const VertexBufferData& vertexBuffer : mVertexBufferData)
+		mSize += vertexBuffer.Data.Size;
+	for (const BufferData& indexBuffer : mIndexBufferData)
+		mSize += indexBuffer.Size;
+
+	vector<VertexBufferData>().swap(mVertexBufferData);
+	vector<BufferData>().swap(mIndexBufferData);
+	mSourceStream.reset();
+}
+
+shared_ptr<SkinningSource> Mesh::GetSkinningSource( uint32_t vertexBuffer ) const
 {
+	return (vertexBuffer < mSkinningSources.size()) ? mSkinningSources[vertexBuffer] : nullptr;
+}
 
+void Mesh::UnloadImpl()
+{
+	mMeshParts.clear();
+	mSkinningSources.clear();
+	mVertexBuffers.clear();
+	mIndexBuffers.clear();
+	mSkeleton.reset();
 }
 
 shared_ptr<Resource> Mesh::FactoryFunc( ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
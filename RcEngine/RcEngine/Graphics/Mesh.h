@@ -5,12 +5,14 @@
 #include <Graphics/GraphicsCommon.h>
 #include <Math/BoundingBox.h>
 #include <Math/Matrix.h>
+#include <Graphics/VertexDeclaration.h>
 #include <Resource/Resource.h>
 
 namespace RcEngine {
 
 class Skeleton;
 class MeshPart;
+class SkinningSource;
 
 /**
   MeshPart don't store a material reference, it only store a material name which is define 
@@ -39,16 +41,32 @@ public:
 	uint32_t GetPrimitiveCount() const							{ return mPrimitiveCount; }
 	uint32_t GetVertexCount() const								{ return mVertexCount; }
 
+	/**
+	 * Vertex data of a skinned vertex buffer for CpuSkinning, null unless skinning sources
+	 * were enabled when the mesh was loaded, or the buffer has no blend weights.
+	 */
+	shared_ptr<SkinningSource> GetSkinningSource(uint32_t vertexBuffer) const;
+
+	/**
+	 * Keep CPU copies of skinned vertex buffers for meshes loaded afterwards, off by default.
+	 */
+	static void SetBuildSkinningSources(bool enable)			{ msBuildSkinningSources = enable; }
+	static bool GetBuildSkinningSources()						{ return msBuildSkinningSources; }
+
 	virtual shared_ptr<Resource> Clone();
 
 protected:
+	void PrepareImpl();
 	void LoadImpl();
 	void UnloadImpl();
 
 public:
 	static shared_ptr<Resource> FactoryFunc(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group);
 
-private:		
+private:
+	static bool msBuildSkinningSources;
+
+	String mMeshName;
 	BoundingBoxf mBoundingBox;
 
 	uint32_t mPrimitiveCount;
@@ -72,8 +90,31 @@ private:
 	};
 	vector<IndexBuffer> mIndexBuffers;
 
+	// Buffer data read in PrepareImpl, released after GPU buffers are created. View points
+	// into the mapped source stream if it is memory backed, otherwise into Storage.
+	struct BufferData
+	{
+		const void* View;
+		uint32_t Size;
+		vector<uint8_t> Storage;
+	};
+
+	struct VertexBufferData
+	{
+		vector<VertexElement> Elements;
+		BufferData Data;
+	};
+	vector<VertexBufferData> mVertexBufferData;
+	vector<BufferData> mIndexBufferData;
+
+	// Keep mapped file alive until buffer views are consumed
+	shared_ptr<Stream> mSourceStream;
+
 	// Skeleton for skinned mesh, empty for static mesh
 	shared_ptr<Skeleton> mSkeleton;
+
+	// Per vertex buffer, built while loading if enabled
+	vector<shared_ptr<SkinningSource> > mSkinningSources;
 };
 
 class _ApiExport MeshPart
@@ -92,6 +133,8 @@ public:
 	inline uint32_t GetIndexCount() const						{ return mIndexCount; }
 	inline uint32_t GetStartIndex() const						{ return mIndexStart; }
 	inline uint32_t GetStartVertex() const						{ return mVertexStart;}
+	inline int32_t GetBaseVertex() const						{ return mBaseVertex; }
+	inline int32_t GetVertexBufferIndex() const					{ return mVertexBufferIndex; }
 
 	inline const String& GetMaterialName() const				{ return mMaterialName; }
 
@@ -165,30 +165,30 @@ static const PixelFormatDescription& GetPixelFormatDescription(PixelFormat forma
 		{ 4, 4, PFF_sRGB | PFF_HasAlpha},	//PF_SBGR8_ALPHA8_UNORM,
 		{ 4, 4, PFF_sRGB },					//PF_SRGBX8_UNORM,
 		{ 4, 4, PFF_sRGB },					//PF_SBGRX8_UNORM,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB_DXT1,
-		{ 3, 4, PFF_sRGB | PFF_HasAlpha },	//PF_SRGB_ALPHA_DXT1,
-		{ 3, 4, PFF_sRGB | PFF_HasAlpha },	//PF_SRGB_ALPHA_DXT3,
-		{ 3, 4, PFF_sRGB | PFF_HasAlpha },	//PF_SRGB_ALPHA_DXT5,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB_DXT1,
+		{ 3, 4, PFF_sRGB | PFF_Compressed | PFF_HasAlpha },	//PF_SRGB_ALPHA_DXT1,
+		{ 3, 4, PFF_sRGB | PFF_Compressed | PFF_HasAlpha },	//PF_SRGB_ALPHA_DXT3,
+		{ 3, 4, PFF_sRGB | PFF_Compressed | PFF_HasAlpha },	//PF_SRGB_ALPHA_DXT5,
 				
-		{ 3, 3, PFF_sRGB },					//PF_SRGB_BP_UNORM,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB_PVRTC_2BPPV1,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB_PVRTC_4BPPV1,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB_ALPHA_PVRTC_2BPPV1,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB_ALPHA_PVRTC_4BPPV1,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_4x4,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_5x4,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_5x5,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_6x5,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_6x6,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_8x5,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_8x6,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_8x8,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_10x5,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_10x6,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_10x8,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_10x10,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_12x10,
-		{ 3, 3, PFF_sRGB },					//PF_SRGB8_ALPHA8_ASTC_12x12,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB_BP_UNORM,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB_PVRTC_2BPPV1,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB_PVRTC_4BPPV1,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB_ALPHA_PVRTC_2BPPV1,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB_ALPHA_PVRTC_4BPPV1,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_4x4,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_5x4,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_5x5,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_6x5,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_6x6,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_8x5,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_8x6,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_8x8,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_10x5,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_10x6,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_10x8,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_10x10,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_12x10,
+		{ 3, 3, PFF_sRGB | PFF_Compressed },	//PF_SRGB8_ALPHA8_ASTC_12x12,
 	};
 
 	static_assert(ARRAY_SIZE(PixelFormatDesc) == PF_Count, "PixelFormatDesc not match PixelFormat");
@@ -216,6 +216,11 @@ bool PixelFormatUtils::IsCompressed( PixelFormat format )
 	return (GetPixelFormatDescription(format).Flags & PFF_Compressed) != 0;
 }
 
+bool PixelFormatUtils::IsSRGB( PixelFormat format )
+{
+	return (GetPixelFormatDescription(format).Flags & PFF_sRGB) != 0;
+}
+
 void PixelFormatUtils::GetNumDepthStencilBits( PixelFormat format, uint32_t& depth, uint32_t& stencil )
 {
 	switch (format)
@@ -193,6 +193,9 @@ public:
 	/** Shortcut method to determine if the format is compressed */
 	static bool IsCompressed(PixelFormat format);
 
+	/** Shortcut method to determine if color components are sRGB encoded */
+	static bool IsSRGB(PixelFormat format);
+
 	/** Shortcut method to determine if the format is a depth format. */
 	static bool IsDepth(PixelFormat format);
 
@@ -1,11 +1,11 @@
 #include <Graphics/RenderFactory.h>
 #include <Graphics/GraphicsResource.h>
 #include <MainApp/Application.h>
-#include <IO/FileSystem.h>
 #include <Core/Environment.h>
 #include <Core/Utility.h>
 #include <Core/Exception.h>
 #include <Core/Profiler.h>
+#include <Core/JobSystem.h>
 #include <Graphics/Image.h>
 #include <IO/PathUtil.h>
 
@@ -58,37 +58,124 @@ shared_ptr<DepthStencilState> RenderFactory::CreateDepthStencilState( const Dept
 
 shared_ptr<Shader> RenderFactory::LoadShaderFromFile( ShaderType shaderType, const String& filename, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint /*= ""*/ )
 {
-	size_t shaderSeed = 0;
+	vector<ShaderLoadDesc> shaders(1);
+	shaders[0].Type = shaderType;
+	shaders[0].Filename = filename;
+	shaders[0].EntryPoint = entryPoint;
+	shaders[0].Macros.assign(macros, macros + macroCount);
 
-	HashCombine(shaderSeed, filename);
-	HashCombine(shaderSeed, entryPoint);
-	for (uint32_t i = 0; i < macroCount; ++i)
-	{
-		HashCombine(shaderSeed, macros[i].Name);
-		HashCombine(shaderSeed, macros[i].Definition);
-	}
+	LoadShadersFromFile(shaders);
+	return shaders[0].Result;
+}
+
+void RenderFactory::LoadShadersFromFile( vector<ShaderLoadDesc>& shaders )
+{
+	// Shaders to load, each once, in order they first appear
+	vector<size_t> newShaders;
+	vector<ShaderHashCode> newShaderHashes;
+	vector<String> newShaderFiles;
+	std::map<ShaderHashCode, shared_ptr<Shader> > batchShaders;
+
+	bool d3d11 = (Application::msApp->GetAppSettings().RHDeviceType == RD_Direct3D11);
 
-	if (mShaderPool.find(shaderSeed) == mShaderPool.end())
+	for (size_t i = 0; i < shaders.size(); ++i)
 	{
-		shared_ptr<Shader> shader = CreateShader(shaderType);
-		
-		String shaderFile;
-		if ( Application::msApp->GetAppSettings().RHDeviceType == RD_Direct3D11)
+		ShaderLoadDesc& desc = shaders[i];
+
+		size_t shaderSeed = 0;
+
+		HashCombine(shaderSeed, desc.Filename);
+		HashCombine(shaderSeed, desc.EntryPoint);
+		for (const ShaderMacro& macro : desc.Macros)
 		{
-			shaderFile = "HLSL/" + filename + ".hlsl";
+			HashCombine(shaderSeed, macro.Name);
+			HashCombine(shaderSeed, macro.Definition);
 		}
-		else 
+
+		auto pooled = mShaderPool.find(shaderSeed);
+		if (pooled != mShaderPool.end())
 		{
-			shaderFile = "GLSL/" + filename + ".glsl";
+			desc.Result = pooled->second;
+			continue;
 		}
 
+		shared_ptr<Shader>& batchShader = batchShaders[shaderSeed];
+		if (!batchShader)
+		{
+			String shaderFile;
+			if (d3d11)
+			{
+				shaderFile = "HLSL/" + desc.Filename + ".hlsl";
+			}
+			else 
+			{
+				shaderFile = "GLSL/" + desc.Filename + ".glsl";
+			}
+
+			batchShader = CreateShader(desc.Type);
+			newShaders.push_back(i);
+			newShaderHashes.push_back(shaderSeed);
+
+			// Name in General group, render systems read it through FileSystem so it may be archived
+			newShaderFiles.push_back(shaderFile);
+		}
+
+		desc.Result = batchShader;
+	}
+
+	// Exceptions can't leave a job, they are kept and thrown in order below
+	vector<std::exception_ptr> errors(newShaders.size());
+	auto prepareShaders = [&](uint32_t begin, uint32_t end) {
+		for (uint32_t j = begin; j < end; ++j)
+		{
+			const ShaderLoadDesc& desc = shaders[newShaders[j]];
+			try
+			{
+				desc.Result->PrepareFromFile(newShaderFiles[j], desc.Macros.empty() ? nullptr : &desc.Macros[0], uint32_t(desc.Macros.size()), desc.EntryPoint);
+			}
+			catch (...)
+			{
+				errors[j] = std::current_exception();
+			}
+		}
+	};
+
+	JobSystem::GetSingleton().ParallelFor(0, uint32_t(newShaders.size()), 1, prepareShaders);
+
+	for (size_t j = 0; j < newShaders.size(); ++j)
+	{
+		if (errors[j])
+			std::rethrow_exception(errors[j]);
+
+		const ShaderLoadDesc& desc = shaders[newShaders[j]];
+
 		//ENGINE_CPU_AUTO_PROFIER("Load Shader");
-		shader->LoadFromFile(FileSystem::GetSingleton().Locate(shaderFile), macros, macroCount, entryPoint);
+		desc.Result->LoadFromFile(newShaderFiles[j], desc.Macros.empty() ? nullptr : &desc.Macros[0], uint32_t(desc.Macros.size()), desc.EntryPoint);
 
-		mShaderPool[shaderSeed] = shader;
+		mShaderPool[newShaderHashes[j]] = desc.Result;
 	}
+}
+
+void RenderFactory::InvalidateShaderFiles( const vector<String>& files )
+{
+	unordered_set<String> normalizedFiles;
+	for (const String& file : files)
+		normalizedFiles.insert(PathUtil::GetNormalizedPath(file));
+
+	auto shaderIter = mShaderPool.begin();
+	while (shaderIter != mShaderPool.end())
+	{
+		const vector<String>& sourceFiles = shaderIter->second->GetSourceFiles();
 
-	return mShaderPool[shaderSeed];
+		bool changed = false;
+		for (size_t i = 0; i < sourceFiles.size() && !changed; ++i)
+			changed = (normalizedFiles.find(PathUtil::GetNormalizedPath(sourceFiles[i])) != normalizedFiles.end());
+
+		if (changed)
+			shaderIter = mShaderPool.erase(shaderIter);
+		else
+			++shaderIter;
+	}
 }
 
 //shared_ptr<Texture> RenderFactory::LoadTextureFromFile( const String& filename )
@@ -187,6 +274,11 @@ shared_ptr<Texture> RenderFactory::LoadTextureFromFile( const String& filename )
 	if (image.LoadImageFromDDS(filename.c_str()) == false)
 		ENGINE_EXCEPT(Exception::ERR_FILE_NOT_FOUND, filename + " not found!", "RenderFactory::LoadTextureFromFile");
 
+	return CreateTextureFromImage(image);
+}
+
+shared_ptr<Texture> RenderFactory::CreateTextureFromImage( Image& image )
+{
 	uint32_t numLayers = image.GetLayers();
 	uint32_t numLevels = image.GetLevels();
 
@@ -248,7 +340,7 @@ shared_ptr<Texture> RenderFactory::LoadTextureFromFile( const String& filename )
 		break;
 	}
 
-	ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Internal Error", "RenderFactory::LoadTextureFromFile");
+	ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Internal Error", "RenderFactory::CreateTextureFromImage");
 }
 
 void RenderFactory::SaveTextureToFile(const String& filename, const shared_ptr<Texture>& texture)
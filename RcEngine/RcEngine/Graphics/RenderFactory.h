@@ -11,9 +11,11 @@ namespace RcEngine {
 
 class ShaderResourceView;
 class UnorderedAccessView;
+class Image;
 
 struct ElementInitData;
 struct ShaderMacro;
+struct ShaderLoadDesc;
 struct VertexElement;
 
 
@@ -92,6 +94,7 @@ public:
 	
 	// Utility function
 	shared_ptr<Texture> LoadTextureFromFile(const String& filename);
+	shared_ptr<Texture> CreateTextureFromImage(Image& image);
 
 	void SaveTextureToFile(const String& filename, const shared_ptr<Texture>& texture);
 	void SaveLinearDepthTextureToFile(const String& filename, const shared_ptr<Texture>& texture, float projM33, float projM43);
@@ -103,6 +106,19 @@ public:
 		uint32_t macroCount,
 		const String& entryPoint = "");
 
+	/**
+	 * Load shaders not in shader pool yet, preprocessing and compiling them in parallel on
+	 * JobSystem workers. Shaders are created on calling thread in batch order, the first
+	 * failure is thrown like loading them one by one would.
+	 */
+	void LoadShadersFromFile(vector<ShaderLoadDesc>& shaders);
+
+	/**
+	 * Drop pooled shaders read from any of files, so they are compiled again when next loaded.
+	 * Render systems also drop what they cache of these files. Shaders in use are not affected.
+	 */
+	virtual void InvalidateShaderFiles(const vector<String>& files);
+
 	// Shader resource view
 	virtual shared_ptr<ShaderResourceView> CreateStructuredBufferSRV(const shared_ptr<GraphicsBuffer>& buffer, uint32_t elementOffset, uint32_t elementCount, uint32_t strutureStride) = 0;
 	virtual shared_ptr<ShaderResourceView> CreateTextureBufferSRV(const shared_ptr<GraphicsBuffer>& buffer, uint32_t elementOffset, uint32_t elementCount, PixelFormat format) = 0;
@@ -5,6 +5,7 @@ namespace RcEngine {
 RenderOperation::RenderOperation()
 	: PrimitiveType(PT_Triangle_List),
 	  NumInstances(0),
+	  InstanceStart(0),
 	  VertexStart(0),
 	  VertexCount(0),
 	  IndexStart(0),
@@ -32,14 +33,31 @@ void RenderOperation::SetIndexRange( uint32_t indexStart, uint32_t indexCount, u
 {
 	IndexStart = indexStart;
 	IndexCount = indexCount;
-	numInstance = numInstance;
+	NumInstances = numInstance;
 }
 
 void RenderOperation::SetVertexRange( uint32_t vertexStart, uint32_t vertexCount, uint32_t numInstance /*= 0*/ )
 {
 	VertexStart = vertexStart;
 	VertexCount = vertexCount;
-	numInstance = numInstance;
+	NumInstances = numInstance;
+}
+
+bool RenderOperation::IsSameGeometry( const RenderOperation& rhs ) const
+{
+	if (PrimitiveType != rhs.PrimitiveType || VertexDecl != rhs.VertexDecl || VertexStreams != rhs.VertexStreams)
+		return false;
+
+	if (IndexBuffer != rhs.IndexBuffer)
+		return false;
+
+	if (IndexBuffer)
+	{
+		return IndexType == rhs.IndexType && IndexStart == rhs.IndexStart && IndexCount == rhs.IndexCount &&
+			BaseVertex == rhs.BaseVertex;
+	}
+
+	return VertexStart == rhs.VertexStart && VertexCount == rhs.VertexCount;
 }
 
 }
@@ -20,6 +20,10 @@ public:
 	// glDrawElements, glDrawElementsInstanced
 	void SetVertexRange(uint32_t vertexStart, uint32_t vertexCount, uint32_t numInstance = 0);
 
+	// Same primitives from same buffers, instance range ignored. Draws of such operations
+	// can be merged into one instanced draw.
+	bool IsSameGeometry(const RenderOperation& rhs) const;
+
 
 public:
 	PrimitiveType PrimitiveType;
@@ -42,6 +46,9 @@ public:
 
 	// Instance 
 	uint32_t NumInstances;
+
+	// First instance of per-instance vertex streams, like BaseVertex for per-vertex streams
+	uint32_t InstanceStart;
 };
 
 
@@ -26,6 +26,18 @@
 
 namespace RcEngine {
 
+// Names looked up per draw, kept as strings so lookups don't allocate
+static const String DirectionalLightingTechName = "DirectionalLighting";
+static const String ShadowEnabledParamName = "ShadowEnabled";
+static const String PossionDiskSamplesCBufferName = "cbPossionDiskSamples";
+static const String CascadeShadowMapParamName = "CascadeShadowMap";
+static const String LightViewParamName = "LightView";
+static const String NumCascadesParamName = "NumCascades";
+static const String BorderPaddingMinMaxParamName = "BorderPaddingMinMax";
+static const String CascadeScaleParamName = "CascadeScale";
+static const String CascadeOffsetParamName = "CascadeOffset";
+static const String InvShadowMapSizeParamName = "InvShadowMapSize";
+
 RenderPath::RenderPath()
 {
 	mDevice = Environment::GetSingleton().GetRenderDevice();
@@ -100,28 +112,31 @@ void ForwardPath::RenderScene()
 	const LightQueue& sceneLights = mSceneMan->GetLightQueue();
 
 	// Draw opaque 
-	RenderBucket opaqueBucket;
+	RenderBucket& opaqueBucket = mOpaqueBucket;
+	opaqueBucket.clear();
+	mSceneMan->GetRenderQueue().GetRenderBucket(RenderQueue::BucketOpaque); // sort, instances must be adjacent
 	mSceneMan->GetRenderQueue().SwapRenderBucket(opaqueBucket, RenderQueue::BucketOpaque);
+	mInstanceBatcher.BuildBatches(opaqueBucket);
 	
 	for (Light* light : sceneLights)
 	{
 		bool bCastShadow = light->GetCastShadow();
 
-		String techName;
 		if (light->GetLightType() == LT_DirectionalLight)
 		{
 			if (bCastShadow)
 				mShadowMan->MakeCascadedShadowMap(*light);
 
-			techName = "DirectionalLighting";
+			const String& techName = DirectionalLightingTechName;
 
-			for (const RenderQueueItem& renderItem : opaqueBucket) 
+			// Items of a batch share material, so effect parameters are set once per batch
+			for (const InstanceBatch& batch : mInstanceBatcher.GetBatches()) 
 			{
-				auto material = renderItem.Renderable->GetMaterial();
+				const shared_ptr<Material>& material = batch.Items[0].Renderable->GetMaterial();
 
 				material->SetCurrentTechnique(techName);
 				
-				shared_ptr<Effect> effect = material->GetEffect();
+				Effect* effect = material->GetEffect().get();
 
 				float3 lightColor = light->GetLightColor() * light->GetLightIntensity();
 				effect->GetParameterByUsage(EPU_Light_Color)->SetValue(lightColor);
@@ -130,23 +145,23 @@ void ForwardPath::RenderScene()
 				float4 lightDir(worldDirection[0], worldDirection[1], worldDirection[2], 0.0f);
 				effect->GetParameterByUsage(EPU_Light_Dir)->SetValue(lightDir);
 
-				EffectParameter* enableShadowParam = effect->GetParameterByName("ShadowEnabled");
+				EffectParameter* enableShadowParam = effect->GetParameterByName(ShadowEnabledParamName);
 				enableShadowParam->SetValue(bCastShadow);
 				if (bCastShadow)
 				{    
-					effect->GetConstantBuffer("cbPossionDiskSamples")->SetBuffer(mShadowMan->mPossionSamplesCBuffer);
+					effect->GetConstantBuffer(PossionDiskSamplesCBufferName)->SetBuffer(mShadowMan->mPossionSamplesCBuffer);
 					
-					effect->GetParameterByName("CascadeShadowMap")->SetValue( mShadowMan->mShadowTexture->GetShaderResourceView());
-					effect->GetParameterByName("LightView")->SetValue(mShadowMan->mLightViewMatrix);
-					effect->GetParameterByName("NumCascades")->SetValue((int)light->GetShadowCascades());
-					effect->GetParameterByName("BorderPaddingMinMax")->SetValue(mShadowMan->mBorderPaddingMinMax);
-					effect->GetParameterByName("CascadeScale")->SetValue(&mShadowMan->mShadowCascadeScale[0], MAX_CASCADES);
-					effect->GetParameterByName("CascadeOffset")->SetValue(&mShadowMan->mShadowCascadeOffset[0], MAX_CASCADES); 
-					effect->GetParameterByName("InvShadowMapSize")->SetValue(1.0f / SHADOW_MAP_SIZE);
+					effect->GetParameterByName(CascadeShadowMapParamName)->SetValue( mShadowMan->mShadowTexture->GetShaderResourceView());
+					effect->GetParameterByName(LightViewParamName)->SetValue(mShadowMan->mLightViewMatrix);
+					effect->GetParameterByName(NumCascadesParamName)->SetValue((int)light->GetShadowCascades());
+					effect->GetParameterByName(BorderPaddingMinMaxParamName)->SetValue(mShadowMan->mBorderPaddingMinMax);
+					effect->GetParameterByName(CascadeScaleParamName)->SetValue(&mShadowMan->mShadowCascadeScale[0], MAX_CASCADES);
+					effect->GetParameterByName(CascadeOffsetParamName)->SetValue(&mShadowMan->mShadowCascadeOffset[0], MAX_CASCADES); 
+					effect->GetParameterByName(InvShadowMapSizeParamName)->SetValue(1.0f / SHADOW_MAP_SIZE);
 					//effect->GetParameterByName("CascadeBlendArea")->SetValue(mShadowMan->mCascadeBlendArea);
 				}
 
-				renderItem.Renderable->Render();
+				mInstanceBatcher.Render(batch);
 			}
 		}
 	}
@@ -372,10 +387,11 @@ void DeferredPath::GenereateGBuffer()
 	auto aabb = mSceneMan->GetRootSceneNode()->GetWorldBoundingBox();
 
 	const RenderBucket& opaqueBucket = mSceneMan->GetRenderQueue().GetRenderBucket(RenderQueue::BucketOpaque);
-	for (const RenderQueueItem& renderItem : opaqueBucket) 
+	mInstanceBatcher.BuildBatches(opaqueBucket);
+	for (const InstanceBatch& batch : mInstanceBatcher.GetBatches()) 
 	{
-		renderItem.Renderable->GetMaterial()->SetCurrentTechnique("GBuffer");
-		renderItem.Renderable->Render();
+		batch.Items[0].Renderable->GetMaterial()->SetCurrentTechnique("GBuffer");
+		mInstanceBatcher.Render(batch);
 	}
 
 	//if ( InputSystem::GetSingleton().MouseButtonPress(MS_MiddleButton) )
@@ -713,10 +729,11 @@ void TiledDeferredPath::GenereateGBuffer()
 	mSceneMan->UpdateRenderQueue(camera, RO_None, RenderQueue::BucketAll, 0);   
 
 	const RenderBucket& opaqueBucket = mSceneMan->GetRenderQueue().GetRenderBucket(RenderQueue::BucketOpaque);
-	for (const RenderQueueItem& renderItem : opaqueBucket) 
+	mInstanceBatcher.BuildBatches(opaqueBucket);
+	for (const InstanceBatch& batch : mInstanceBatcher.GetBatches()) 
 	{
-		renderItem.Renderable->GetMaterial()->SetCurrentTechnique("GBuffer");
-		renderItem.Renderable->Render();
+		batch.Items[0].Renderable->GetMaterial()->SetCurrentTechnique("GBuffer");
+		mInstanceBatcher.Render(batch);
 	}
 
 	//if ( InputSystem::GetSingleton().MouseButtonPress(MS_MiddleButton) )
@@ -5,6 +5,8 @@
 #include <Graphics/PixelFormat.h>
 #include <Graphics/GraphicsCommon.h>
 #include <Graphics/RenderOperation.h>
+#include <Graphics/RenderQueue.h>
+#include <Graphics/InstanceBatcher.h>
 #include <Math/ColorRGBA.h>
 #include <Math/Matrix.h>
 #include <Resource/Resource.h>
@@ -36,6 +38,9 @@ protected:
 	shared_ptr<Camera> mCamera;
 
 	RenderOperation mFullscreenTrangle;
+
+	// Merges opaque renderables into instanced draws
+	InstanceBatcher mInstanceBatcher;
 };
 
 /**
@@ -61,6 +66,9 @@ public:
 
 	shared_ptr<Texture> mDepthStencilBuffer;
 	shared_ptr<RenderView> mDepthStencilView;
+
+	// Swapped with render queue each frame, so neither loses its capacity
+	RenderBucket mOpaqueBucket;
 };
 
 /**
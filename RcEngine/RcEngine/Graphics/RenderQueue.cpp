@@ -1,101 +1,262 @@
 #include <Graphics/RenderQueue.h>
+#include <Graphics/Renderable.h>
+#include <Graphics/RenderOperation.h>
+#include <Graphics/Material.h>
+#include <Graphics/Effect.h>
 #include <Core/Exception.h>
 
 namespace RcEngine {
 
+// Below this size insertion sort is cheaper than radix passes.
+static const size_t RadixSortThreshold = 64;
+
+static inline uint64_t PackField(uint64_t value, uint32_t numBits, uint32_t shift)
+{
+	return (value & ((uint64_t(1) << numBits) - 1)) << shift;
+}
+
+static inline uint32_t HashPointer(const void* ptr)
+{
+	size_t value = reinterpret_cast<size_t>(ptr);
+	return uint32_t(value >> 4) ^ uint32_t(value >> 16);
+}
+
 RenderQueue::RenderQueue()
+	: mBucketFlags(0),
+	  mSortedFlags(0)
 {
 	// set up default bucket
-	mRenderBuckets.insert(std::make_pair(BucketOpaque, new RenderBucket()));
-	mRenderBuckets.insert(std::make_pair(BucketTransparent, new RenderBucket()));
-	mRenderBuckets.insert(std::make_pair(BucketBackground, new RenderBucket()));
-	mRenderBuckets.insert(std::make_pair(BucketTranslucent, new RenderBucket()));
-	mRenderBuckets.insert(std::make_pair(BucketOverlay, new RenderBucket()));
+	mBucketFlags = BucketBackground | BucketOpaque | BucketTransparent | BucketTranslucent | BucketOverlay;
 }
 
 RenderQueue::~RenderQueue()
 {
-	for (auto& kv : mRenderBuckets)
-		delete kv.second;
+
 }
 
-const RenderBucket& RenderQueue::GetRenderBucket(Bucket bucket, bool sortBucket /*= true*/)
+uint32_t RenderQueue::GetBucketIndex( Bucket bucket )
 {
-	if (mRenderBuckets.find(bucket) == mRenderBuckets.end())
+	uint32_t flag = bucket;
+	if (flag == 0 || (flag & (flag - 1)) != 0)
 	{
-		ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND, "Render bucket not exits!",  "RenderQueue::GetRenderBucket");
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Render bucket must be a single flag!",  "RenderQueue::GetBucketIndex");
 	}
 
-	RenderBucket& renderBucker = (*mRenderBuckets[bucket]);
-
-	if (sortBucket)
+	uint32_t index = 0;
+	while ((flag & 1) == 0)
 	{
-		std::sort(renderBucker.begin(), renderBucker.end(), [](const RenderQueueItem& lhs, const RenderQueueItem& rhs) {
-			return lhs.SortKey < rhs.SortKey; });
+		flag >>= 1;
+		++index;
 	}
 
-	return renderBucker;
+	return index;
 }
 
-const std::map<RenderQueue::Bucket, RenderBucket*>& RenderQueue::GetAllRenderBuckets(bool sortBucket /*= true*/)
+const RenderBucket& RenderQueue::GetRenderBucket(Bucket bucket, bool sortBucket /*= true*/)
 {
-	if (sortBucket)
+	if ((mBucketFlags & bucket) == 0)
 	{
-		for (auto& kv : mRenderBuckets)
-		{
-			std::sort(kv.second->begin(), kv.second->end(), [](const RenderQueueItem& lhs, const RenderQueueItem& rhs) {
-				return lhs.SortKey < rhs.SortKey; });
-		}
+		ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND, "Render bucket not exits!",  "RenderQueue::GetRenderBucket");
 	}
 
-	return mRenderBuckets;
-}
+	RenderBucket& renderBucker = mRenderBuckets[GetBucketIndex(bucket)];
+
+	if (sortBucket && (mSortedFlags & bucket) == 0)
+	{
+		SortBucket(renderBucker);
+		mSortedFlags |= bucket;
+	}
 
+	return renderBucker;
+}
 
 void RenderQueue::AddToQueue( RenderQueueItem item, Bucket bucket )
 {
-	if (mRenderBuckets.find(bucket) == mRenderBuckets.end())
+	if ((mBucketFlags & bucket) == 0)
 	{
 		ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND, "Render bucket not exits!",  "RenderQueue::AddToQueue");
 	}
 
-	mRenderBuckets[bucket]->push_back(item);
+	mRenderBuckets[GetBucketIndex(bucket)].push_back(item);
+	mSortedFlags &= ~uint32_t(bucket);
 }
 
 void RenderQueue::AddRenderBucket( Bucket bucket )
 {
-	if (mRenderBuckets.find(bucket) != mRenderBuckets.end())
+	if (mBucketFlags & bucket)
 	{
 		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Render bucket already exits!",  "RenderQueue::AddRenderBucket");
 	}
 
-	mRenderBuckets.insert(std::make_pair(bucket, new RenderBucket()));
+	mRenderBuckets[GetBucketIndex(bucket)].clear();
+	mBucketFlags |= bucket;
 }
 
 void RenderQueue::ClearAllQueue()
 {
-	for (auto iter = mRenderBuckets.begin(); iter != mRenderBuckets.end(); ++iter)
-	{
-		iter->second->clear();
-	}
+	ClearQueues(mBucketFlags);
 }
 
 void RenderQueue::ClearQueues( uint32_t bucketFlags )
 {
-	if (bucketFlags & BucketBackground)		mRenderBuckets[BucketBackground]->clear();
-	if (bucketFlags & BucketOpaque)			mRenderBuckets[BucketOpaque]->clear();
-	if (bucketFlags & BucketTransparent)	mRenderBuckets[BucketTransparent]->clear();
-	if (bucketFlags & BucketTranslucent)	mRenderBuckets[BucketTranslucent]->clear();
-	if (bucketFlags & BucketOverlay)		mRenderBuckets[BucketOverlay]->clear();
+	bucketFlags &= mBucketFlags;
+
+	// clear() keeps capacity, so queues are not reallocated every frame
+	for (uint32_t i = 0; i < MaxBuckets; ++i)
+	{
+		if (bucketFlags & (1UL << i))
+			mRenderBuckets[i].clear();
+	}
+
+	mSortedFlags &= ~bucketFlags;
 }
 
 void RenderQueue::SwapRenderBucket( RenderBucket& bucket, Bucket type )
 {
-	assert( mRenderBuckets.count(type) );
-	mRenderBuckets[type]->swap(bucket);
+	assert( mBucketFlags & type );
+	mRenderBuckets[GetBucketIndex(type)].swap(bucket);
+	mSortedFlags &= ~uint32_t(type);
+}
+
+void RenderQueue::SortBucket( RenderBucket& bucket )
+{
+	const size_t numItems = bucket.size();
+
+	if (numItems < RadixSortThreshold)
+	{
+		for (size_t i = 1; i < numItems; ++i)
+		{
+			RenderQueueItem item = bucket[i];
+
+			size_t j = i;
+			for (; j > 0 && bucket[j-1].SortKey > item.SortKey; --j)
+				bucket[j] = bucket[j-1];
+
+			bucket[j] = item;
+		}
+		return;
+	}
+
+	// Histogram of all 8 byte passes in one scan
+	uint32_t histogram[8][256];
+	memset(histogram, 0, sizeof(histogram));
+
+	uint64_t keyAnd = ~uint64_t(0), keyOr = 0;
+	for (size_t i = 0; i < numItems; ++i)
+	{
+		uint64_t key = bucket[i].SortKey;
+		keyAnd &= key;
+		keyOr |= key;
+
+		for (uint32_t pass = 0; pass < 8; ++pass)
+			histogram[pass][(key >> (pass * 8)) & 0xFF]++;
+	}
+
+	mSortScratch.resize(numItems);
+
+	RenderQueueItem* src = &bucket[0];
+	RenderQueueItem* dst = &mSortScratch[0];
+
+	const uint64_t varyingBits = keyAnd ^ keyOr;
+	for (uint32_t pass = 0; pass < 8; ++pass)
+	{
+		const uint32_t shift = pass * 8;
+
+		// All items share this byte, order would not change
+		if (((varyingBits >> shift) & 0xFF) == 0)
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t b = 0; b < 256; ++b)
+		{
+			uint32_t count = histogram[pass][b];
+			histogram[pass][b] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < numItems; ++i)
+		{
+			uint32_t b = uint32_t(src[i].SortKey >> shift) & 0xFF;
+			dst[histogram[pass][b]++] = src[i];
+		}
+
+		std::swap(src, dst);
+	}
+
+	if (src != &bucket[0])
+		bucket.swap(mSortScratch);
+}
+
+uint32_t RenderQueue::QuantizeDepth( float depth, uint32_t numBits )
+{
+	// Bit pattern of non-negative IEEE float grows with its value, keep the highest bits
+	// below sign bit. This gives relative precision at any distance.
+	if (!(depth > 0.0f))
+		return 0;
+
+	union { float f; uint32_t u; } bits;
+	bits.f = depth;
+
+	return bits.u >> (31 - numBits);
 }
 
+uint64_t RenderQueue::MakeSortKey( Bucket bucket, RenderOrder order, const Renderable* renderable, float depth )
+{
+	uint32_t effectId = 0, techniqueId = 0, materialId = 0, vertexBufferId = 0;
+
+	const shared_ptr<Material>& material = renderable->GetMaterial();
+	if (material)
+	{
+		materialId = material->GetResourceHandle();
+
+		Effect* effect = material->GetEffect().get();
+		if (effect)
+		{
+			effectId = effect->GetResourceHandle();
+
+			EffectTechnique* technique = renderable->GetTechnique();
+			for (uint32_t i = 0; i < effect->GetNumTechniques(); ++i)
+			{
+				if (effect->GetTechniqueByIndex(i) == technique)
+				{
+					techniqueId = i;
+					break;
+				}
+			}
+		}
+	}
+
+	const shared_ptr<RenderOperation>& rop = renderable->GetRenderOperation();
+	if (rop && rop->VertexStreams.size())
+		vertexBufferId = HashPointer(rop->VertexStreams.front().get());
+
+	uint64_t key = PackField(GetBucketIndex(bucket), 4, 60);
+
+	if (order == RO_FrontToBack || order == RO_BackToFront)
+	{
+		uint32_t depthBits = QuantizeDepth(depth, 24);
+		if (order == RO_BackToFront)
+			depthBits = ~depthBits;
+
+		key |= PackField(depthBits, 24, 36);
+		key |= PackField(effectId, 12, 24);
+		key |= PackField(techniqueId, 4, 20);
+		key |= PackField(materialId, 12, 8);
+		key |= PackField(vertexBufferId, 8, 0);
+	}
+	else
+	{
+		key |= PackField(effectId, 12, 48);
+		key |= PackField(techniqueId, 4, 44);
+		key |= PackField(materialId, 12, 32);
+		key |= PackField(vertexBufferId, 12, 20);
 
+		// Front to back inside same state, helps early z
+		key |= PackField(QuantizeDepth(depth, 20), 20, 0);
+	}
+
+	return key;
+}
 
 
 }
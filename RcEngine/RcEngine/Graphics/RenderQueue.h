@@ -2,16 +2,20 @@
 #define RenderQueue_h__
 
 #include <Core/Prerequisites.h>
+#include <Graphics/GraphicsCommon.h>
 
 namespace RcEngine {
 
+/**
+ * Render queue items are sorted by a 64 bit key, see RenderQueue::MakeSortKey for the layout.
+ */
 struct _ApiExport RenderQueueItem
 {
 	Renderable* Renderable;
-	float SortKey;
+	uint64_t SortKey;
 
 	RenderQueueItem() {}
-	RenderQueueItem(class Renderable* rd, float key) : Renderable(rd), SortKey(key) { }
+	RenderQueueItem(class Renderable* rd, uint64_t key) : Renderable(rd), SortKey(key) { }
 };
 
 typedef std::vector<RenderQueueItem> RenderBucket;
@@ -75,14 +79,25 @@ public:
 		BucketAll = BucketBackground | BucketOpaque | BucketTransparent | BucketTranslucent | BucketOverlay
 	};
 
+	// Bucket is a single bit flag, so at most 32 buckets.
+	static const uint32_t MaxBuckets = 32;
+
 public:
 	RenderQueue();
 	~RenderQueue();
 
 	void AddRenderBucket(Bucket bucket);
 
+	/**
+	 * Get render bucket. Bucket is sorted by key at most once after it has been modified,
+	 * so fetching the same bucket in several passes does not sort it again.
+	 */
 	const RenderBucket& GetRenderBucket(Bucket bucket, bool sort = true);
-	const std::map<Bucket, RenderBucket*>& GetAllRenderBuckets(bool sort = true);
+
+	/**
+	 * Return bit flags of all registered buckets.
+	 */
+	uint32_t GetRenderBucketFlags() const						{ return mBucketFlags; }
 
 	void AddToQueue(RenderQueueItem item, Bucket bucket);
 	void ClearAllQueue();
@@ -90,8 +105,41 @@ public:
 
 	void SwapRenderBucket(RenderBucket& bucket, Bucket type);
 
-public:
-	std::map<Bucket, RenderBucket*> mRenderBuckets;
+	/**
+	 * Build 64 bit sort key for renderable. Higher bits are sorted first:
+	 *
+	 * RO_StateChange and RO_None:
+	 *   [63..60] bucket  [59..48] effect  [47..44] technique  [43..32] material  [31..20] vertex buffer  [19..0] depth
+	 *
+	 * RO_FrontToBack and RO_BackToFront:
+	 *   [63..60] bucket  [59..36] depth  [35..24] effect  [23..20] technique  [19..8] material  [7..0] vertex buffer
+	 *
+	 * Ids are truncated to the field width, a collision only affects batching, never correctness.
+	 * Depth is a non-negative view distance, it is inverted for RO_BackToFront.
+	 */
+	static uint64_t MakeSortKey(Bucket bucket, RenderOrder order, const Renderable* renderable, float depth);
+
+	/**
+	 * Quantize non-negative depth to numBits (<= 31) preserving order.
+	 */
+	static uint32_t QuantizeDepth(float depth, uint32_t numBits);
+
+private:
+	static uint32_t GetBucketIndex(Bucket bucket);
+
+	// Stable LSD radix sort, byte passes shared by all items are skipped.
+	void SortBucket(RenderBucket& bucket);
+
+private:
+	RenderBucket mRenderBuckets[MaxBuckets];
+
+	uint32_t mBucketFlags;
+
+	// Buckets already sorted since last modification
+	uint32_t mSortedFlags;
+
+	// Radix sort scratch, kept to avoid per frame allocation
+	RenderBucket mSortScratch;
 };
 
 
@@ -6,11 +6,13 @@
 #include <Graphics/EffectParameter.h>
 #include <Graphics/GraphicsResource.h>
 #include <Core/Environment.h>
+#include <Core/FrameAllocator.h>
 
 namespace RcEngine {
 
 
 Renderable::Renderable()
+	: mWorldInverseValid(false)
 {
 
 }
@@ -37,7 +39,7 @@ void Renderable::Render()
 void Renderable::OnRenderBegin()
 {
 	// Get material 
-	shared_ptr<Material> material = GetMaterial();
+	const shared_ptr<Material>& material = GetMaterial();
 
 	// Get world transforms
 	float4x4 worldMatrix;
@@ -45,27 +47,33 @@ void Renderable::OnRenderBegin()
 
 	if (matCounts > 0)
 	{
-		vector<float4x4> matWorlds(matCounts);
-		GetWorldTransforms(&matWorlds[0]);
+		// Only used by this draw, released at next frame
+		float4x4* matWorlds = FrameAllocator::GetSingleton().AllocateArray<float4x4>(matCounts);
+		GetWorldTransforms(matWorlds);
 
 		//Last matrix is world transform matrix, previous is skin matrices.
-		worldMatrix = matWorlds.back();
+		worldMatrix = matWorlds[matCounts - 1];
 
 		// Skin matrix
 		if (matCounts > 1)
 		{	
-			EffectParameter* skinMatricesParam = material->GetEffect()->GetParameterByName("SkinMatrices");
-			if (skinMatricesParam)
-			{
-				// delete last world matrix first
-				matWorlds.pop_back();
-				skinMatricesParam->SetValue(&matWorlds[0], matWorlds.size());
-			}
+			if (EffectParameter* skinMatricesParam = material->GetSkinMatricesParameter())
+				skinMatricesParam->SetValue(matWorlds, matCounts - 1);
+		}
+	}
+
+	if (material->IsWorldInverseUsed())
+	{
+		if (!mWorldInverseValid || mCachedWorld != worldMatrix)
+		{
+			mCachedWorld = worldMatrix;
+			mCachedWorldInverse = worldMatrix.Inverse();
+			mWorldInverseValid = true;
 		}
 	}
 			
 	// Setup other material parameter
-	material->ApplyMaterial(worldMatrix);
+	material->ApplyMaterial(worldMatrix, mCachedWorldInverse);
 }
 
 void Renderable::OnRenderEnd()
@@ -49,6 +49,12 @@ public:
 
 	virtual void OnRenderBegin();
 	virtual void OnRenderEnd();
+
+protected:
+	// World inverse of last draw, only recomputed when world matrix changes
+	float4x4 mCachedWorld;
+	float4x4 mCachedWorldInverse;
+	bool mWorldInverseValid;
 };
 
 
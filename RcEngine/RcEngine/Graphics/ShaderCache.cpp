@@ -0,0 +1,201 @@
+#include <Graphics/ShaderCache.h>
+#include <Graphics/GraphicsResource.h>
+#include <IO/FileSystem.h>
+#include <IO/FileStream.h>
+#include <IO/PathUtil.h>
+#include <Core/Exception.h>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+
+namespace RcEngine {
+
+namespace {
+
+const uint32_t CacheFileMagic = 0x43485352; // "RSHC"
+
+// Bump when layout of entries or what keys cover changes
+const uint32_t CacheFileVersion = 1;
+
+struct CacheFileHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t Key;
+	uint32_t Format;
+	uint32_t Size;
+	uint64_t DataHash;
+};
+
+// Strings are hashed with length, so "ab"+"c" and "a"+"bc" differ
+inline uint64_t HashString(const String& str, uint64_t seed)
+{
+	uint64_t length = str.length();
+	seed = ShaderCache::Hash(&length, sizeof(length), seed);
+	return ShaderCache::Hash(str.data(), str.length(), seed);
+}
+
+}
+
+ShaderCache::ShaderCache()
+	: mNumHits(0),
+	  mNumMisses(0),
+	  mNumStores(0)
+{
+
+}
+
+ShaderCache::~ShaderCache()
+{
+
+}
+
+void ShaderCache::SetDirectory( const String& directory )
+{
+	mDirectory.clear();
+
+	if (directory.empty())
+		return;
+
+	if (!FileSystem::GetSingleton().CreateDir(directory))
+	{
+		std::cout << "Can't create shader cache directory " << directory << ", shader cache disabled" << std::endl;
+		return;
+	}
+
+	mDirectory = PathUtil::AddTrailingSlash(directory);
+}
+
+uint64_t ShaderCache::Hash( const void* data, size_t size, uint64_t seed )
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+uint64_t ShaderCache::ComputeKey( const String& source, const ShaderMacro* macros, uint32_t macroCount, const String& entryPoint, uint32_t shaderType, const String& compilerTag )
+{
+	uint64_t key = HashString(source, Hash(nullptr, 0));
+
+	key = Hash(&macroCount, sizeof(macroCount), key);
+	for (uint32_t i = 0; i < macroCount; ++i)
+	{
+		key = HashString(macros[i].Name, key);
+		key = HashString(macros[i].Definition, key);
+	}
+
+	key = HashString(entryPoint, key);
+	key = Hash(&shaderType, sizeof(shaderType), key);
+	key = HashString(compilerTag, key);
+
+	return key;
+}
+
+String ShaderCache::GetEntryFile( uint64_t key ) const
+{
+	char name[32];
+	sprintf(name, "%08x%08x.bin", uint32_t(key >> 32), uint32_t(key));
+	return mDirectory + name;
+}
+
+bool ShaderCache::Load( uint64_t key, uint32_t& format, vector<uint8_t>& data )
+{
+	if (!IsEnabled())
+		return false;
+
+	FileStream stream;
+	if (!stream.Open(GetEntryFile(key), FILE_READ))
+	{
+		mNumMisses++;
+		return false;
+	}
+
+	CacheFileHeader header;
+	bool valid = stream.GetSize() >= sizeof(CacheFileHeader) &&
+		stream.Read(&header, sizeof(CacheFileHeader)) == sizeof(CacheFileHeader) &&
+		header.Magic == CacheFileMagic && header.Version == CacheFileVersion &&
+		header.Key == key && header.Size == stream.GetSize() - sizeof(CacheFileHeader);
+
+	if (valid)
+	{
+		data.resize(header.Size);
+		valid = header.Size > 0 && stream.Read(&data[0], header.Size) == header.Size &&
+			Hash(&data[0], header.Size) == header.DataHash;
+	}
+
+	if (!valid)
+	{
+		// Written by an older engine or damaged, overwritten by next store
+		data.clear();
+		mNumMisses++;
+		return false;
+	}
+
+	format = header.Format;
+	mNumHits++;
+	return true;
+}
+
+void ShaderCache::Store( uint64_t key, uint32_t format, const void* data, uint32_t size )
+{
+	if (!IsEnabled() || size == 0)
+		return;
+
+	CacheFileHeader header;
+	header.Magic = CacheFileMagic;
+	header.Version = CacheFileVersion;
+	header.Key = key;
+	header.Format = format;
+	header.Size = size;
+	header.DataHash = Hash(data, size);
+
+	// Unique per thread and process, readers never see a partially written entry
+	char suffix[64];
+	sprintf(suffix, ".%08x%08x.tmp",
+		uint32_t(std::hash<std::thread::id>()(std::this_thread::get_id())),
+		uint32_t(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+
+	String entryFile = GetEntryFile(key);
+	String tempFile = entryFile + suffix;
+
+	bool written = false;
+	try
+	{
+		FileStream stream;
+		if (stream.Open(tempFile, FILE_WRITE))
+		{
+			written = stream.Write(&header, sizeof(CacheFileHeader)) == sizeof(CacheFileHeader) &&
+				stream.Write(data, size) == size;
+			stream.Close();
+		}
+	}
+	catch (Exception&)
+	{
+		written = false;
+	}
+
+	// Rename doesn't replace an existing file on Windows. An entry of the same key has the
+	// same content, so if another writer wins the race nothing is lost.
+	if (written)
+	{
+		remove(entryFile.c_str());
+		written = (rename(tempFile.c_str(), entryFile.c_str()) == 0);
+	}
+
+	if (!written)
+	{
+		remove(tempFile.c_str());
+		return;
+	}
+
+	mNumStores++;
+}
+
+} // Namespace RcEngine
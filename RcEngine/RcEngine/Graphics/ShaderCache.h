@@ -0,0 +1,70 @@
+#ifndef ShaderCache_h__
+#define ShaderCache_h__
+
+#include <Core/Prerequisites.h>
+#include <Core/Singleton.h>
+#include <atomic>
+
+namespace RcEngine {
+
+struct ShaderMacro;
+
+/**
+ * Compiled shaders kept on disk across runs, one file per shader under a cache directory.
+ * Render systems key entries by everything that affects the compiled result: source after
+ * includes are resolved, macros, entry point, shader stage and a tag of compiler or driver
+ * version. Any change to one of them is a different key, stale entries are never loaded.
+ *
+ * Files carry a header with the key and a hash of the data, truncated, corrupted or foreign
+ * files are misses. Entries are written to a temporary file and renamed, so shaders may be
+ * loaded and stored from several threads and processes at once.
+ */
+class _ApiExport ShaderCache : public Singleton<ShaderCache>
+{
+public:
+	ShaderCache();
+	~ShaderCache();
+
+	/**
+	 * Directory of cache files, created if missing. Empty disables the cache.
+	 */
+	void SetDirectory(const String& directory);
+	const String& GetDirectory() const					{ return mDirectory; }
+
+	bool IsEnabled() const								{ return !mDirectory.empty(); }
+
+	/**
+	 * Key of a shader. Source must be fully expanded, or carry the text of all included files.
+	 */
+	static uint64_t ComputeKey(const String& source, const ShaderMacro* macros, uint32_t macroCount,
+		const String& entryPoint, uint32_t shaderType, const String& compilerTag);
+
+	/**
+	 * 64 bit FNV-1a, chained through seed.
+	 */
+	static uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+	/**
+	 * Read data and its render system specific format of key. False if there is no valid entry.
+	 */
+	bool Load(uint64_t key, uint32_t& format, vector<uint8_t>& data);
+	void Store(uint64_t key, uint32_t format, const void* data, uint32_t size);
+
+	uint32_t GetNumHits() const							{ return mNumHits; }
+	uint32_t GetNumMisses() const						{ return mNumMisses; }
+	uint32_t GetNumStores() const						{ return mNumStores; }
+
+private:
+	String GetEntryFile(uint64_t key) const;
+
+private:
+	String mDirectory;
+
+	std::atomic<uint32_t> mNumHits;
+	std::atomic<uint32_t> mNumMisses;
+	std::atomic<uint32_t> mNumStores;
+};
+
+} // Namespace RcEngine
+
+#endif // ShaderCache_h__
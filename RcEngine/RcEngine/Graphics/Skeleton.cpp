@@ -19,6 +19,25 @@ void Bone::CalculateBindPose()
 	mOffsetMatrix = bindPose.Inverse();
 }
 
+void Bone::SetAnimatedTransform( const float3& position, const Quaternionf& rotation, const float3& scale, const float4x4& worldTransform )
+{
+	mPosition = position;
+	mRotation = rotation;
+	mScale = scale;
+
+	mWorldTransform = worldTransform;
+	mDirtyBits = (mDirtyBits & ~NODE_DIRTY_WORLD) | NODE_DIRTY_BOUNDS;
+}
+
+void Bone::DirtyAttachedNodes()
+{
+	for (Node* child : mChildren)
+	{
+		if (!dynamic_cast<Bone*>(child))
+			child->PropagateDirtyDown(NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS);
+	}
+}
+
 Node* Bone::CreateChildImpl( const String& name )
 {
 	ENGINE_EXCEPT(Exception::ERR_RT_ASSERTION_FAILED, "Shound't call Bone::CreateChildImpl", "Bone::CreateChildImpl");
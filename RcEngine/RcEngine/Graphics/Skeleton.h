@@ -45,6 +45,15 @@ public:
 
 	void CalculateBindPose();	
 
+public_internal:
+	/**
+	 * Set local transform and world transform computed by AnimationPlayer. Nothing else is
+	 * dirtied, child bones are updated by the player as well and scene nodes attached to
+	 * the bone by DirtyAttachedNodes, which must be called on the main thread.
+	 */
+	void SetAnimatedTransform(const float3& position, const Quaternionf& rotation, const float3& scale, const float4x4& worldTransform);
+	void DirtyAttachedNodes();
+
 protected:
 
 	// Do not use this method to create bone node, Bone node only created when load from mesh file
@@ -237,7 +237,7 @@ void SpriteBatch::OnUpdateRenderQueue( RenderQueue& renderQueue )
 		item.Renderable = it->second;
 
 		// ignore render order, only handle state change order
-		item.SortKey = (float)mEffect->GetResourceHandle();
+		item.SortKey = RenderQueue::MakeSortKey(RenderQueue::BucketOverlay, RO_StateChange, item.Renderable, 0.0f);
 		renderQueue.AddToQueue(item, RenderQueue::BucketOverlay);
 	}
 }
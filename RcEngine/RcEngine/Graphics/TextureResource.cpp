@@ -1,28 +1,169 @@
 #include <Graphics/TextureResource.h>
+#include <Graphics/TextureStreamer.h>
 #include <Graphics/GraphicsResource.h>
 #include <Graphics/RenderFactory.h>
+#include <Graphics/Image.h>
+#include <Graphics/ImageProcessing.h>
 #include <Core/Environment.h>
+#include <Core/Exception.h>
 #include <IO/FileSystem.h>
+#include <IO/Stream.h>
+#include <Resource/ResourceManager.h>
 
 namespace RcEngine {
 
 TextureResource::TextureResource( ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
-	: Resource(RT_Texture, creator, handle, name, group)
+	: Resource(RT_Texture, creator, handle, name, group),
+	  mStreamed(false),
+	  mWidth(0), 
+	  mHeight(0),
+	  mResidentLevel(0),
+	  mTailLevel(0),
+	  mRequestedLevel(0),
+	  mRequestFrame(0)
 {
 
 }
 
-void TextureResource::LoadImpl()
+TextureResource::~TextureResource()
 {
-	String fullPath = FileSystem::GetSingleton().Locate(mResourceName, mGroup);
+	if (mStreamed && TextureStreamer::GetSingletonPtr())
+		TextureStreamer::GetSingleton().UnregisterTexture(this);
+}
+
+void TextureResource::PrepareImpl()
+{
+	FileSystem& fileSystem = FileSystem::GetSingleton();
+
+	mStreamed = false;
+	mLevelSizes.clear();
+
+	// Only loose files are watched, archived textures don't change at runtime
+	String filePath;
+	if (fileSystem.FindFile(mResourceName, mGroup, filePath))
+		AddFileDependency(filePath);
+
+	uint32_t firstLevel = 0;
+
+	TextureStreamer* streamer = TextureStreamer::GetSingletonPtr();
+	if (streamer && streamer->IsGroupStreamed(mGroup))
+	{
+		Image header;
+		if (header.LoadImageInfoFromDDS(*fileSystem.OpenStream(mResourceName, mGroup)) == false)
+			ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, mResourceName + " is not a valid DDS!", "TextureResource::PrepareImpl");
+
+		// Only single 2D textures with levels above mip tail are streamed
+		uint32_t tailLevel = streamer->GetMipTailLevel(header.GetWidth(), header.GetHeight(), header.GetLevels());
+		if (header.GetType() == TT_Texture2D && header.GetLayers() == 1 && tailLevel > 0)
+		{
+			mStreamed = true;
+			mTailLevel = tailLevel;
+			mWidth = header.GetWidth();
+			mHeight = header.GetHeight();
+			for (uint32_t level = 0; level < header.GetLevels(); ++level)
+				mLevelSizes.push_back(header.GetSurfaceSize(level));
 
+			firstLevel = mTailLevel;
+		}
+	}
+
+	mImage = std::make_shared<Image>();
+	if (mImage->LoadImageFromDDS(*fileSystem.OpenStream(mResourceName, mGroup), firstLevel) == false)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, mResourceName + " is not a valid DDS!", "TextureResource::PrepareImpl");
+
+	// DDS without mips, filter them on load. Block compressed files are left alone, encoding
+	// is too slow at runtime, the texture cooker generates their mips offline
+	if (!mStreamed && mImage->GetLevels() == 1 && mImage->GetType() != TT_Texture3D &&
+		(mImage->GetWidth() > 1 || mImage->GetHeight() > 1) && ImageProcessing::IsRowFormat(mImage->GetFormat()))
+	{
+		shared_ptr<Image> mipmapped = std::make_shared<Image>();
+		ImageProcessing::GenerateMipmaps(*mImage, *mipmapped, MF_Box);
+		mImage = mipmapped;
+	}
+}
+
+void TextureResource::LoadImpl()
+{
 	RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
-	mTexture = factory->LoadTextureFromFile(fullPath);
+	mTexture = factory->CreateTextureFromImage(*mImage);
+
+	uint32_t numSurfaces = mImage->GetLayers() * (mImage->GetType() == TT_TextureCube ? CMF_Count : 1);
+	mSize = sizeof(TextureResource);
+	for (uint32_t level = 0; level < mImage->GetLevels(); ++level)
+		mSize += mImage->GetSurfaceSize(level) * numSurfaces;
+
+	if (mStreamed)
+	{
+		// Resource size stays the mip tail, streamed levels are accounted by TextureStreamer budget
+		mResidentLevel = mTailLevel;
+		mRequestedLevel = mTailLevel;
+		TextureStreamer::GetSingleton().RegisterTexture(this);
+	}
+	else
+	{
+		mWidth = mImage->GetWidth();
+		mHeight = mImage->GetHeight();
+		for (uint32_t level = 0; level < mImage->GetLevels(); ++level)
+			mLevelSizes.push_back(mImage->GetSurfaceSize(level) * numSurfaces);
+		mResidentLevel = mTailLevel = mRequestedLevel = 0;
+	}
+
+	mImage.reset();
 }
 
 void TextureResource::UnloadImpl()
 {
+	if (mStreamed && TextureStreamer::GetSingletonPtr())
+		TextureStreamer::GetSingleton().UnregisterTexture(this);
 
+	mTexture.reset();
+}
+
+void TextureResource::ReloadImpl()
+{
+	// Decode into a scratch resource first, this one keeps its texture if the file is broken
+	TextureResource reloaded(mCreator, mResourceHandle, mResourceName, mGroup);
+	reloaded.PrepareImpl();
+
+	if (mStreamed)
+		TextureStreamer::GetSingleton().UnregisterTexture(this);
+
+	mImage = reloaded.mImage;
+	mStreamed = reloaded.mStreamed;
+	mWidth = reloaded.mWidth;
+	mHeight = reloaded.mHeight;
+	mTailLevel = reloaded.mTailLevel;
+	mLevelSizes.swap(reloaded.mLevelSizes);
+
+	// Scratch was never registered to streamer
+	reloaded.mStreamed = false;
+
+	LoadImpl();
+}
+
+uint32_t TextureResource::GetLevelsSize( uint32_t firstLevel ) const
+{
+	uint32_t size = 0;
+	for (uint32_t level = firstLevel; level < mLevelSizes.size(); ++level)
+		size += mLevelSizes[level];
+	return size;
+}
+
+void TextureResource::RequestMipLevel( uint32_t level )
+{
+	uint32_t frame = ResourceManager::GetSingleton().GetFrameNumber();
+	
+	level = (std::min)(level, mTailLevel);
+	if (mRequestFrame != frame || level < mRequestedLevel)
+		mRequestedLevel = level;
+
+	mRequestFrame = frame;
+}
+
+void TextureResource::SetStreamedTexture( const shared_ptr<Texture>& texture, uint32_t residentLevel )
+{
+	mTexture = texture;
+	mResidentLevel = residentLevel;
 }
 
 shared_ptr<Resource> RcEngine::TextureResource::FactoryFunc( ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
@@ -5,22 +5,77 @@
 
 namespace RcEngine {
 
+class Image;
+
 class _ApiExport TextureResource : public Resource
 {
 public:
 	TextureResource(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group);
+	~TextureResource();
 
+	/**
+	 * Texture of resident levels. For streamed textures it is replaced by TextureStreamer when
+	 * resident levels change, so don't cache it.
+	 */
 	inline const shared_ptr<Texture>& GetTexture() const { return mTexture; }
 
+	/**
+	 * Streamed texture is created with the mip tail only, more detailed levels are loaded on
+	 * request. See TextureStreamer.
+	 */
+	inline bool IsStreamed() const						{ return mStreamed; }
+
+	// Size and levels of the whole mip chain in file
+	inline uint32_t GetWidth() const					{ return mWidth; }
+	inline uint32_t GetHeight() const					{ return mHeight; }
+	inline uint32_t GetNumLevels() const				{ return uint32_t(mLevelSizes.size()); }
+
+	// Most detailed level in memory, and the least detailed one that may be evicted
+	inline uint32_t GetResidentLevel() const			{ return mResidentLevel; }
+	inline uint32_t GetMipTailLevel() const				{ return mTailLevel; }
+
+	// Bytes of levels [firstLevel, GetNumLevels)
+	uint32_t GetLevelsSize(uint32_t firstLevel) const;
+	inline uint32_t GetLevelSize(uint32_t level) const	{ return mLevelSizes[level]; }
+
+	/**
+	 * Ask for level to be resident, the most detailed level requested in a frame wins.
+	 * Main thread only.
+	 */
+	void RequestMipLevel(uint32_t level);
+
+	inline uint32_t GetRequestedLevel() const			{ return mRequestedLevel; }
+	inline uint32_t GetRequestFrame() const				{ return mRequestFrame; }
+
 public:
 	static shared_ptr<Resource> FactoryFunc(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group);
 
+public_internal:
+	// Called by TextureStreamer when a streamed load is finished
+	void SetStreamedTexture(const shared_ptr<Texture>& texture, uint32_t residentLevel);
+
 protected:
+	void PrepareImpl();
 	void LoadImpl();
 	void UnloadImpl();
+	void ReloadImpl();
 
 private:
 	shared_ptr<Texture> mTexture; 
+
+	// Decoded in PrepareImpl, released after texture is created
+	shared_ptr<Image> mImage;
+
+	bool mStreamed;
+
+	uint32_t mWidth, mHeight;
+	vector<uint32_t> mLevelSizes;
+
+	uint32_t mResidentLevel;
+	uint32_t mTailLevel;
+
+	uint32_t mRequestedLevel;
+	uint32_t mRequestFrame;
 };
 
 
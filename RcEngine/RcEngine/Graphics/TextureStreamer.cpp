@@ -0,0 +1,343 @@
+#include <Graphics/TextureStreamer.h>
+#include <Graphics/TextureResource.h>
+#include <Graphics/RenderDevice.h>
+#include <Graphics/RenderFactory.h>
+#include <Graphics/FrameBuffer.h>
+#include <Graphics/Image.h>
+#include <Core/Environment.h>
+#include <Core/Exception.h>
+#include <IO/FileSystem.h>
+#include <IO/Stream.h>
+#include <Resource/ResourceManager.h>
+
+namespace RcEngine {
+
+struct TextureStreamer::StreamRequest
+{
+	StreamRequest() : Texture(nullptr), Level(0), Succeeded(false), Done(false) {}
+
+	// Null if texture is unregistered while loading
+	TextureResource* Texture;
+
+	// Opened through FileSystem, texture may be in an archive
+	String Name;
+	String Group;
+	uint32_t Level;
+
+	// Levels [Level, NumLevels) read on a loader thread
+	Image LoadedImage;
+	bool Succeeded;
+	std::atomic<bool> Done;
+};
+
+TextureStreamer::TextureStreamer()
+	: mNumReading(0),
+	  mMemoryBudget(256 * 1024 * 1024),
+	  mMemoryUse(0),
+	  mMipTailSize(64),
+	  mUploadBudget(8 * 1024 * 1024),
+	  mMaxPendingLoads(8),
+	  mRequestLifetime(60),
+	  mScreenHeight(720),
+	  mMipBias(0.0f)
+{
+
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	WaitForPendingLoads();
+
+	for (const shared_ptr<StreamRequest>& request : mPendingLoads)
+		request->Texture = nullptr;
+}
+
+void TextureStreamer::SetGroupStreamed( const String& group, bool streamed )
+{
+	std::lock_guard<std::mutex> lock(mGroupMutex);
+
+	if (streamed)
+		mStreamedGroups.insert(group);
+	else
+		mStreamedGroups.erase(group);
+}
+
+bool TextureStreamer::IsGroupStreamed( const String& group ) const
+{
+	std::lock_guard<std::mutex> lock(mGroupMutex);
+	return mStreamedGroups.count(group) > 0;
+}
+
+uint32_t TextureStreamer::GetMipTailLevel( uint32_t width, uint32_t height, uint32_t numLevels ) const
+{
+	uint32_t level = 0;
+	while (level + 1 < numLevels && (std::max)(width >> level, height >> level) > mMipTailSize)
+		++level;
+
+	return level;
+}
+
+void TextureStreamer::RequestScreenSize( TextureResource& texture, float screenSize )
+{
+	float pixels = (std::max)(screenSize * mScreenHeight, 1.0f);
+	float texels = float( (std::max)(texture.GetWidth(), texture.GetHeight()) );
+
+	// Round down, prefer a sharper level
+	float level = std::log(texels / pixels) / std::log(2.0f) + mMipBias;
+	texture.RequestMipLevel(level > 0.0f ? uint32_t(level) : 0);
+}
+
+void TextureStreamer::RegisterTexture( TextureResource* texture )
+{
+	assert(FindTexture(texture) == nullptr);
+
+	StreamedTexture entry;
+	entry.Texture = texture;
+	entry.WantedLevel = texture->GetMipTailLevel();
+	mTextures.push_back(entry);
+}
+
+void TextureStreamer::UnregisterTexture( TextureResource* texture )
+{
+	StreamedTexture* entry = FindTexture(texture);
+	if (!entry)
+		return;
+
+	// Loader thread still owns the request, result is dropped in FinalizeLoads
+	if (entry->Pending)
+		entry->Pending->Texture = nullptr;
+
+	*entry = mTextures.back();
+	mTextures.pop_back();
+}
+
+TextureStreamer::StreamedTexture* TextureStreamer::FindTexture( TextureResource* texture )
+{
+	for (StreamedTexture& entry : mTextures)
+	{
+		if (entry.Texture == texture)
+			return &entry;
+	}
+
+	return nullptr;
+}
+
+void TextureStreamer::Update()
+{
+	RenderDevice* device = Environment::GetSingleton().GetRenderDevice();
+	if (device->GetScreenFrameBuffer())
+		mScreenHeight = device->GetScreenFrameBuffer()->GetHeight();
+
+	FinalizeLoads();
+	UpdateWantedLevels();
+	EvictLevels();
+	StartLoads();
+}
+
+void TextureStreamer::WaitForPendingLoads()
+{
+	std::unique_lock<std::mutex> lock(mReadMutex);
+	while (mNumReading > 0)
+		mReadCondition.wait(lock);
+}
+
+void TextureStreamer::FinalizeLoads()
+{
+	RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
+
+	uint32_t uploadBytes = 0;
+	for (size_t i = 0; i < mPendingLoads.size(); )
+	{
+		StreamRequest& request = *mPendingLoads[i];
+		if (!request.Done.load(std::memory_order_acquire))
+		{
+			++i;
+			continue;
+		}
+
+		if (request.Texture && request.Succeeded)
+		{
+			uint32_t textureBytes = request.Texture->GetLevelsSize(request.Level);
+			if (uploadBytes > 0 && uploadBytes + textureBytes > mUploadBudget)
+				break;
+
+			request.Texture->SetStreamedTexture(factory->CreateTextureFromImage(request.LoadedImage), request.Level);
+			uploadBytes += textureBytes;
+		}
+
+		if (request.Texture)
+			FindTexture(request.Texture)->Pending.reset();
+
+		mPendingLoads.erase(mPendingLoads.begin() + i);
+	}
+}
+
+void TextureStreamer::UpdateWantedLevels()
+{
+	const uint32_t frame = ResourceManager::GetSingleton().GetFrameNumber();
+
+	uint64_t wantedBytes = 0;
+	mMemoryUse = 0;
+
+	for (StreamedTexture& entry : mTextures)
+	{
+		TextureResource* texture = entry.Texture;
+
+		if (frame - texture->GetRequestFrame() <= mRequestLifetime)
+			entry.WantedLevel = texture->GetRequestedLevel();
+		else
+			entry.WantedLevel = texture->GetMipTailLevel();
+
+		wantedBytes += texture->GetLevelsSize(entry.WantedLevel);
+		mMemoryUse += texture->GetLevelsSize(texture->GetResidentLevel());
+	}
+
+	if (mMemoryBudget == 0 || wantedBytes <= mMemoryBudget)
+		return;
+
+	// Drop one level at a time from the texture requested longest ago, the largest level first
+	// among textures requested in the same frame
+	auto evictOrder = [](const StreamedTexture* lhs, const StreamedTexture* rhs) {
+		uint32_t lhsFrame = lhs->Texture->GetRequestFrame();
+		uint32_t rhsFrame = rhs->Texture->GetRequestFrame();
+		if (lhsFrame != rhsFrame)
+			return lhsFrame > rhsFrame;
+		return lhs->Texture->GetLevelSize(lhs->WantedLevel) < rhs->Texture->GetLevelSize(rhs->WantedLevel);
+	};
+
+	mCandidates.clear();
+	for (StreamedTexture& entry : mTextures)
+	{
+		if (entry.WantedLevel < entry.Texture->GetMipTailLevel())
+			mCandidates.push_back(&entry);
+	}
+
+	std::make_heap(mCandidates.begin(), mCandidates.end(), evictOrder);
+	while (wantedBytes > mMemoryBudget && !mCandidates.empty())
+	{
+		std::pop_heap(mCandidates.begin(), mCandidates.end(), evictOrder);
+		StreamedTexture* entry = mCandidates.back();
+
+		wantedBytes -= entry->Texture->GetLevelSize(entry->WantedLevel);
+		entry->WantedLevel++;
+
+		if (entry->WantedLevel < entry->Texture->GetMipTailLevel())
+			std::push_heap(mCandidates.begin(), mCandidates.end(), evictOrder);
+		else
+			mCandidates.pop_back();
+	}
+}
+
+void TextureStreamer::EvictLevels()
+{
+	RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
+
+	for (StreamedTexture& entry : mTextures)
+	{
+		TextureResource* texture = entry.Texture;
+		if (entry.Pending || entry.WantedLevel <= texture->GetResidentLevel())
+			continue;
+
+		// Wanted levels are the tail of resident chain, copy them on GPU
+		const shared_ptr<Texture>& resident = texture->GetTexture();
+		uint32_t firstLevel = entry.WantedLevel - texture->GetResidentLevel();
+		uint32_t evictedBytes = texture->GetLevelsSize(texture->GetResidentLevel()) - texture->GetLevelsSize(entry.WantedLevel);
+
+		shared_ptr<Texture> evicted = factory->CreateTexture2D(
+			(std::max)(resident->GetWidth() >> firstLevel, 1U), 
+			(std::max)(resident->GetHeight() >> firstLevel, 1U),
+			resident->GetTextureFormat(),
+			1,
+			resident->GetMipLevels() - firstLevel,
+			1,
+			0,
+			EAH_GPU_Read | EAH_GPU_Write,
+			TexCreate_ShaderResource,
+			nullptr);
+
+		resident->CopyLevelsToTexture(*evicted, firstLevel);
+		texture->SetStreamedTexture(evicted, entry.WantedLevel);
+		mMemoryUse -= evictedBytes;
+	}
+}
+
+void TextureStreamer::StartLoads()
+{
+	if (mPendingLoads.size() >= mMaxPendingLoads)
+		return;
+
+	// Memory use once pending loads are finished
+	uint64_t projectedUse = mMemoryUse;
+	for (const shared_ptr<StreamRequest>& request : mPendingLoads)
+	{
+		if (request->Texture)
+		{
+			uint32_t residentBytes = request->Texture->GetLevelsSize(request->Texture->GetResidentLevel());
+			uint32_t loadBytes = request->Texture->GetLevelsSize(request->Level);
+			projectedUse = projectedUse + loadBytes - residentBytes;
+		}
+	}
+
+	// Evictions are done, the most recently requested textures load first
+	mCandidates.clear();
+	for (StreamedTexture& entry : mTextures)
+	{
+		if (!entry.Pending && entry.WantedLevel < entry.Texture->GetResidentLevel())
+			mCandidates.push_back(&entry);
+	}
+
+	std::sort(mCandidates.begin(), mCandidates.end(), [](const StreamedTexture* lhs, const StreamedTexture* rhs) {
+		return lhs->Texture->GetRequestFrame() > rhs->Texture->GetRequestFrame();
+	});
+
+	ResourceManager& resourceManager = ResourceManager::GetSingleton();
+	for (StreamedTexture* entry : mCandidates)
+	{
+		if (mPendingLoads.size() >= mMaxPendingLoads)
+			break;
+
+		TextureResource* texture = entry->Texture;
+
+		uint32_t residentBytes = texture->GetLevelsSize(texture->GetResidentLevel());
+		uint32_t loadBytes = texture->GetLevelsSize(entry->WantedLevel);
+		if (mMemoryBudget && projectedUse + loadBytes - residentBytes > mMemoryBudget)
+			continue;
+
+		projectedUse = projectedUse + loadBytes - residentBytes;
+
+		shared_ptr<StreamRequest> request = std::make_shared<StreamRequest>();
+		request->Texture = texture;
+		request->Name = texture->GetResourceName();
+		request->Group = texture->GetResourceGroup();
+		request->Level = entry->WantedLevel;
+
+		entry->Pending = request;
+		mPendingLoads.push_back(request);
+
+		{
+			std::lock_guard<std::mutex> lock(mReadMutex);
+			mNumReading++;
+		}
+
+		resourceManager.RunOnLoaderThread([this, request]() {
+			try
+			{
+				shared_ptr<Stream> stream = FileSystem::GetSingleton().OpenStream(request->Name, request->Group);
+				request->Succeeded = request->LoadedImage.LoadImageFromDDS(*stream, request->Level);
+			}
+			catch (...)
+			{
+				request->Succeeded = false;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mReadMutex);
+				request->Done.store(true, std::memory_order_release);
+				mNumReading--;
+			}
+			mReadCondition.notify_all();
+		});
+	}
+}
+
+} // Namespace RcEngine
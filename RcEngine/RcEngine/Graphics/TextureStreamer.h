@@ -0,0 +1,158 @@
+#ifndef TextureStreamer_h__
+#define TextureStreamer_h__
+
+#include <Core/Prerequisites.h>
+#include <Core/Singleton.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+
+namespace RcEngine {
+
+class TextureResource;
+
+/**
+ * Mip level streaming of DDS textures. Textures of streamed resource groups are loaded with
+ * the mip tail only, materials request levels from the screen size of what they are drawn on,
+ * and more detailed levels are read from file by byte offset on a ResourceManager loader
+ * thread, reads block and would stall JobSystem workers.
+ *
+ * Resident levels of all streamed textures are kept under a memory budget, levels of textures
+ * not requested for the longest time are evicted first. Texture API can't change levels in
+ * place, so a new texture with the resident part of the chain replaces the old one on main
+ * thread in Update. Evicted textures are copied from the smaller resident levels, no file read.
+ *
+ * Settings must be changed before textures are loaded, they are read on loader threads.
+ */
+class _ApiExport TextureStreamer : public Singleton<TextureStreamer>
+{
+public:
+	TextureStreamer();
+	~TextureStreamer();
+
+	/**
+	 * Stream textures loaded in group, off by default.
+	 */
+	void SetGroupStreamed(const String& group, bool streamed);
+	bool IsGroupStreamed(const String& group) const;
+
+	/**
+	 * Bytes of levels resident for all streamed textures, 0 means unlimited. Mip tails are
+	 * never evicted, so it may be exceeded by them.
+	 */
+	void SetMemoryBudget(uint64_t budget)				{ mMemoryBudget = budget; }
+	uint64_t GetMemoryBudget() const					{ return mMemoryBudget; }
+	uint64_t GetMemoryUse() const						{ return mMemoryUse; }
+
+	/**
+	 * Levels not larger than size in both dimensions are loaded with the texture and always
+	 * resident.
+	 */
+	void SetMipTailSize(uint32_t size)					{ mMipTailSize = size; }
+	uint32_t GetMipTailSize() const						{ return mMipTailSize; }
+
+	/**
+	 * Bytes of textures created per frame on main thread, at least one is created each frame.
+	 */
+	void SetUploadBudget(uint32_t bytes)				{ mUploadBudget = bytes; }
+	uint32_t GetUploadBudget() const					{ return mUploadBudget; }
+
+	void SetMaxPendingLoads(uint32_t count)				{ mMaxPendingLoads = count; }
+	uint32_t GetMaxPendingLoads() const					{ return mMaxPendingLoads; }
+
+	/**
+	 * Added to requested levels. Requests assume a texture is mapped once across the object,
+	 * use a positive bias for textures tiled less densely than that.
+	 */
+	void SetMipBias(float bias)							{ mMipBias = bias; }
+	float GetMipBias() const							{ return mMipBias; }
+
+	/**
+	 * Frames a request is kept after the texture was last requested, then it goes back to
+	 * the mip tail.
+	 */
+	void SetRequestLifetime(uint32_t frames)			{ mRequestLifetime = frames; }
+	uint32_t GetRequestLifetime() const					{ return mRequestLifetime; }
+
+	/**
+	 * Screen height in pixels, updated from screen frame buffer each frame.
+	 */
+	void SetScreenHeight(uint32_t height)				{ mScreenHeight = height; }
+	uint32_t GetScreenHeight() const					{ return mScreenHeight; }
+
+	// Level of first mip in the tail of a chain
+	uint32_t GetMipTailLevel(uint32_t width, uint32_t height, uint32_t numLevels) const;
+
+	/**
+	 * Request level of texture from the fraction of screen height covered by the object it
+	 * is drawn on.
+	 */
+	void RequestScreenSize(TextureResource& texture, float screenSize);
+
+	/**
+	 * Finalize finished loads, fit wanted levels into budget and start new loads. Called once
+	 * per frame by Application.
+	 */
+	void Update();
+
+	/**
+	 * Block until all loads are read from file, they are finalized in next Update.
+	 */
+	void WaitForPendingLoads();
+
+	uint32_t GetNumStreamedTextures() const				{ return uint32_t(mTextures.size()); }
+	uint32_t GetNumPendingLoads() const					{ return uint32_t(mPendingLoads.size()); }
+
+public_internal:
+	void RegisterTexture(TextureResource* texture);
+	void UnregisterTexture(TextureResource* texture);
+
+private:
+	TextureStreamer(const TextureStreamer&);
+	TextureStreamer& operator= (const TextureStreamer&);
+
+	struct StreamRequest;
+
+	struct StreamedTexture
+	{
+		TextureResource* Texture;
+		uint32_t WantedLevel;
+		shared_ptr<StreamRequest> Pending;
+	};
+
+	StreamedTexture* FindTexture(TextureResource* texture);
+
+	void FinalizeLoads();
+	void UpdateWantedLevels();
+	void EvictLevels();
+	void StartLoads();
+
+private:
+	mutable std::mutex mGroupMutex;
+	std::set<String> mStreamedGroups;
+
+	vector<StreamedTexture> mTextures;
+	vector<shared_ptr<StreamRequest> > mPendingLoads;
+
+	// Scratch of Update, avoid per frame allocation
+	vector<StreamedTexture*> mCandidates;
+
+	// Guard Done of requests being read, and count of them
+	std::mutex mReadMutex;
+	std::condition_variable mReadCondition;
+	uint32_t mNumReading;
+
+	uint64_t mMemoryBudget;
+	uint64_t mMemoryUse;
+	uint32_t mMipTailSize;
+	uint32_t mUploadBudget;
+	uint32_t mMaxPendingLoads;
+	uint32_t mRequestLifetime;
+	uint32_t mScreenHeight;
+	float mMipBias;
+};
+
+} // Namespace RcEngine
+
+#endif // TextureStreamer_h__
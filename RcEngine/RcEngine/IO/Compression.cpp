@@ -0,0 +1,205 @@
+#include <IO/Compression.h>
+
+namespace RcEngine {
+
+namespace {
+
+// Constraints of the LZ4 block format: last 5 bytes are always literals, and the
+// last match must start at least 12 bytes before the end of block.
+const uint32_t MinMatch = 4;
+const uint32_t LastLiterals = 5;
+const uint32_t MatchFindLimit = 12;
+const uint32_t MaxDistance = 65535;
+
+const uint32_t HashLog = 12;
+
+inline uint32_t ReadU32(const uint8_t* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+inline uint32_t HashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761U) >> (32 - HashLog);
+}
+
+inline uint8_t* WriteLength(uint8_t* op, uint32_t length)
+{
+	for (; length >= 255; length -= 255)
+		*op++ = 255;
+	*op++ = uint8_t(length);
+	return op;
+}
+
+uint8_t* WriteSequence(uint8_t* op, const uint8_t* literals, uint32_t numLiterals, uint32_t offset, uint32_t matchLength)
+{
+	uint8_t* token = op++;
+
+	if (numLiterals >= 15)
+	{
+		*token = 15 << 4;
+		op = WriteLength(op, numLiterals - 15);
+	}
+	else
+		*token = uint8_t(numLiterals << 4);
+
+	memcpy(op, literals, numLiterals);
+	op += numLiterals;
+
+	// Last sequence has literals only
+	if (matchLength)
+	{
+		*op++ = uint8_t(offset);
+		*op++ = uint8_t(offset >> 8);
+
+		uint32_t length = matchLength - MinMatch;
+		if (length >= 15)
+		{
+			*token |= 15;
+			op = WriteLength(op, length - 15);
+		}
+		else
+			*token |= uint8_t(length);
+	}
+
+	return op;
+}
+
+}
+
+uint32_t LZ4::CompressBound( uint32_t srcSize )
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+uint32_t LZ4::Compress( const void* src, uint32_t srcSize, void* dest )
+{
+	const uint8_t* base = static_cast<const uint8_t*>(src);
+	const uint8_t* ip = base;
+	const uint8_t* anchor = base;
+	const uint8_t* iend = base + srcSize;
+	uint8_t* op = static_cast<uint8_t*>(dest);
+
+	if (srcSize > MatchFindLimit)
+	{
+		const uint8_t* matchLimit = iend - LastLiterals;
+		const uint8_t* findLimit = iend - MatchFindLimit;
+
+		// Position of last occurrence of each hashed 4 byte sequence
+		vector<uint32_t> hashTable(1 << HashLog, 0);
+
+		while (ip < findLimit)
+		{
+			uint32_t sequence = ReadU32(ip);
+			uint32_t hash = HashSequence(sequence);
+			const uint8_t* ref = base + hashTable[hash];
+			hashTable[hash] = uint32_t(ip - base);
+
+			if (ref >= ip || uint32_t(ip - ref) > MaxDistance || ReadU32(ref) != sequence)
+			{
+				++ip;
+				continue;
+			}
+
+			// Extend match backwards over pending literals
+			while (ip > anchor && ref > base && ip[-1] == ref[-1])
+			{
+				--ip;
+				--ref;
+			}
+
+			uint32_t matchLength = MinMatch;
+			while (ip + matchLength < matchLimit && ip[matchLength] == ref[matchLength])
+				++matchLength;
+
+			op = WriteSequence(op, anchor, uint32_t(ip - anchor), uint32_t(ip - ref), matchLength);
+
+			ip += matchLength;
+			anchor = ip;
+		}
+	}
+
+	op = WriteSequence(op, anchor, uint32_t(iend - anchor), 0, 0);
+	return uint32_t(op - static_cast<uint8_t*>(dest));
+}
+
+bool LZ4::Decompress( const void* src, uint32_t srcSize, void* dest, uint32_t destSize )
+{
+	const uint8_t* ip = static_cast<const uint8_t*>(src);
+	const uint8_t* iend = ip + srcSize;
+	uint8_t* const obase = static_cast<uint8_t*>(dest);
+	uint8_t* op = obase;
+	uint8_t* const oend = obase + destSize;
+
+	while (ip < iend)
+	{
+		uint32_t token = *ip++;
+
+		uint32_t numLiterals = token >> 4;
+		if (numLiterals == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if (ip >= iend) return false;
+				b = *ip++;
+				numLiterals += b;
+			} while (b == 255);
+		}
+
+		if (numLiterals > uint32_t(iend - ip) || numLiterals > uint32_t(oend - op))
+			return false;
+
+		memcpy(op, ip, numLiterals);
+		op += numLiterals;
+		ip += numLiterals;
+
+		// End of block
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return false;
+
+		uint32_t offset = ip[0] | (uint32_t(ip[1]) << 8);
+		ip += 2;
+
+		if (offset == 0 || offset > uint32_t(op - obase))
+			return false;
+
+		uint32_t matchLength = token & 15;
+		if (matchLength == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if (ip >= iend) return false;
+				b = *ip++;
+				matchLength += b;
+			} while (b == 255);
+		}
+		matchLength += MinMatch;
+
+		if (matchLength > uint32_t(oend - op))
+			return false;
+
+		// Match may overlap the output, copy forward byte by byte
+		const uint8_t* match = op - offset;
+		if (offset >= matchLength)
+		{
+			memcpy(op, match, matchLength);
+			op += matchLength;
+		}
+		else
+		{
+			for (uint32_t i = 0; i < matchLength; ++i)
+				*op++ = *match++;
+		}
+	}
+
+	return op == oend;
+}
+
+} // Namespace RcEngine
@@ -0,0 +1,36 @@
+#ifndef Compression_h__
+#define Compression_h__
+
+#include <Core/Prerequisites.h>
+
+namespace RcEngine {
+
+/**
+ * LZ4 block format codec. The output is a raw LZ4 block (no frame header), compatible
+ * with LZ4_compress_default/LZ4_decompress_safe, so archives can also be produced or
+ * inspected with the reference library.
+ */
+class _ApiExport LZ4
+{
+public:
+	/**
+	 * Maximum compressed size of srcSize bytes.
+	 */
+	static uint32_t CompressBound(uint32_t srcSize);
+
+	/**
+	 * Compress src into dest which must hold at least CompressBound(srcSize) bytes.
+	 * Return compressed size.
+	 */
+	static uint32_t Compress(const void* src, uint32_t srcSize, void* dest);
+
+	/**
+	 * Decompress a block into dest of exactly destSize bytes. Malformed input never
+	 * writes outside of dest, return false if the block is corrupted or size mismatch.
+	 */
+	static bool Decompress(const void* src, uint32_t srcSize, void* dest, uint32_t destSize);
+};
+
+} // Namespace RcEngine
+
+#endif // Compression_h__
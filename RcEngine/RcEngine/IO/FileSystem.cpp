@@ -1,9 +1,17 @@
 #include <IO/FileSystem.h>
 #include <IO/FileStream.h>
+#include <IO/MappedFileStream.h>
+#include <IO/PakArchive.h>
+#include <IO/FileWatcher.h>
 #include <IO/PathUtil.h>
 #include <Core/Exception.h>
 #include <sys/stat.h>
-#include <direct.h>
+
+#ifdef _WIN32
+	#include <direct.h>
+#else
+	#include <unistd.h>
+#endif
 
 #ifndef MAX_PATH
 	#define MAX_PATH 260
@@ -11,7 +19,21 @@
 
 namespace RcEngine {
 
+// Small files are cheaper to read than to map.
+static const uint32_t DefaultMappedStreamThreshold = 64 * 1024;
+
+static void MakeDir( const String& pathName )
+{
+#ifdef _WIN32
+	_mkdir(pathName.c_str());
+#else
+	mkdir(pathName.c_str(), 0755);
+#endif
+}
+
 FileSystem::FileSystem()
+	: mMappedStreamThreshold(DefaultMappedStreamThreshold),
+	  mWatchChanges(false)
 {
 
 }
@@ -57,9 +79,30 @@ void FileSystem::RegisterPath( const String& pathName, const String& group )
 		return;
 	}
 
-	String fixedPath = PathUtil::RemoveTrailingSlash(pathName);
+	ResourceLocation location;
+	location.Path = PathUtil::RemoveTrailingSlash(pathName);
+
+	mResouceGroups[group].push_back(location);
+
+	if (mWatchChanges)
+		WatchDirectory(location.Path);
+}
+
+bool FileSystem::MountArchive( const String& archiveFile, const String& group )
+{
+	shared_ptr<PakArchive> archive = std::make_shared<PakArchive>();
+	if (!archive->Open(archiveFile))
+	{
+		std::cerr << "Archive: " << archiveFile << " can't be opened" << std::endl;
+		return false;
+	}
+
+	ResourceLocation location;
+	location.Path = archiveFile;
+	location.Archive = archive;
 
-	mResouceGroups[group].push_back(fixedPath);
+	mResouceGroups[group].push_back(location);
+	return true;
 }
 
 
@@ -114,6 +157,24 @@ bool FileSystem::SetCurrentDir( const String& pathName )
 	return true;
 }
 
+bool FileSystem::CreateDir( const String& pathName )
+{
+	if (!CheckAccess(pathName))
+		return false;
+
+	String fixedName = PathUtil::RemoveTrailingSlash(PathUtil::GetInternalPath(pathName));
+	if (fixedName.empty() || DirExits(fixedName))
+		return true;
+
+	// Parents first, mkdir of an existing one just fails
+	for (size_t pos = fixedName.find('/', 1); pos != String::npos; pos = fixedName.find('/', pos + 1))
+		MakeDir(fixedName.substr(0, pos));
+	MakeDir(fixedName);
+
+	// Another thread or process may have created it meanwhile
+	return DirExits(fixedName);
+}
+
 void FileSystem::ScanDirInternal( vector<String>& result, String path, const String& startPath, const String& filter, unsigned flags, bool recursive )
 {
 
@@ -127,19 +188,35 @@ String FileSystem::Locate( const String& file, const String& group )
 		ENGINE_EXCEPT(Exception::ERR_FILE_NOT_FOUND, "Group: " + group + " doesn't exits", "FileSystem::Locate");
 	}
 
-	for (const String& path : mResouceGroups[group])
+	String fullPath;
+	if (FindFile(file, group, fullPath))
+		return fullPath;
+
+	// Log
+	std::cout << "File: " << file << " doesn't exit!" << std::endl;
+	ENGINE_EXCEPT(Exception::ERR_FILE_NOT_FOUND, "File: " + file + " doesn't exit!", "FileSystem::Locate");
+}
+
+bool FileSystem::FindFile( const String& file, const String& group, String& fullPath )
+{
+	auto groupIter = mResouceGroups.find(group);
+	if (groupIter == mResouceGroups.end())
+		return false;
+
+	for (const ResourceLocation& location : groupIter->second)
 	{
+		if (location.Archive)
+			continue;
+
 		//String fileName = PathUtil::GetFileNameAndExtension(file);
-		String fullPath = path + "/" + file;
+		fullPath = location.Path + "/" + file;
 
 		if (FileExits(fullPath))
-		{
-			return fullPath;
-		}
+			return true;
 	}
-	// Log
-	std::cout << "File: " << file << " doesn't exit!" << std::endl;
-	ENGINE_EXCEPT(Exception::ERR_FILE_NOT_FOUND, "File: " + file + " doesn't exit!", "FileSystem::Locate");
+
+	fullPath.clear();
+	return false;
 }
 
 shared_ptr<Stream> FileSystem::OpenStream( const String& file, const String& group/*="General"*/ )
@@ -150,13 +227,31 @@ shared_ptr<Stream> FileSystem::OpenStream( const String& file, const String& gro
 		ENGINE_EXCEPT(Exception::ERR_FILE_NOT_FOUND, "Group: " + group + " doesn't exits", "FileSystem::OpenStream");
 	}
 
-	for (const String& groupPath : mResouceGroups[group])
+	for (const ResourceLocation& location : mResouceGroups[group])
 	{
+		if (location.Archive)
+		{
+			shared_ptr<Stream> stream = location.Archive->OpenStream(file);
+			if (stream)
+				return stream;
+
+			continue;
+		}
+
 		/*String fileName = PathUtil::GetFileNameAndExtension(file);*/
-		String fullPath = groupPath + "/" + file;
+		String fullPath = location.Path + "/" + file;
 
 		if (FileExits(fullPath))
 		{
+			struct stat st;
+			if (mMappedStreamThreshold && stat(PathUtil::GetInternalPath(fullPath).c_str(), &st) == 0 && 
+				uint64_t(st.st_size) >= mMappedStreamThreshold)
+			{
+				shared_ptr<MappedFileStream> mappedStream ( new MappedFileStream );
+				if (mappedStream->Open(fullPath))
+					return mappedStream;
+			}
+
 			shared_ptr<FileStream> stream ( new FileStream );
 			stream->Open(fullPath);
 			return stream;
@@ -172,10 +267,18 @@ bool FileSystem::Exits( const String& name, const String& group/*="General"*/ )
 	if (mResouceGroups.find(group) == mResouceGroups.end())
 		return false;
 
-	for (const String& path : mResouceGroups[group])
+	for (const ResourceLocation& location : mResouceGroups[group])
 	{
+		if (location.Archive)
+		{
+			if (location.Archive->Exits(name))
+				return true;
+
+			continue;
+		}
+
 		//String fileName = PathUtil::GetFileNameAndExtension(name);
-		String fullPath = path + "/" + name;
+		String fullPath = location.Path + "/" + name;
 
 		if (FileExits(fullPath))
 		{
@@ -187,4 +290,59 @@ bool FileSystem::Exits( const String& name, const String& group/*="General"*/ )
 }
 
 
+void FileSystem::SetWatchChanges( bool enable )
+{
+	if (mWatchChanges == enable)
+		return;
+
+	mWatchChanges = enable;
+	mWatchers.clear();
+
+	if (enable)
+	{
+		for (auto& kv : mResouceGroups)
+		{
+			for (const ResourceLocation& location : kv.second)
+			{
+				if (!location.Archive)
+					WatchDirectory(location.Path);
+			}
+		}
+	}
+}
+
+void FileSystem::WatchDirectory( const String& pathName )
+{
+	String path = PathUtil::GetNormalizedPath(pathName);
+
+	// Groups often share directories or register sub directories of each other
+	auto watcherIter = mWatchers.begin();
+	while (watcherIter != mWatchers.end())
+	{
+		const String& watchedPath = (*watcherIter)->GetPath();
+		if (path == watchedPath || path.compare(0, watchedPath.length() + 1, watchedPath + "/") == 0)
+			return;
+
+		if (watchedPath.compare(0, path.length() + 1, path + "/") == 0)
+			watcherIter = mWatchers.erase(watcherIter);
+		else
+			++watcherIter;
+	}
+
+	shared_ptr<FileWatcher> watcher = std::make_shared<FileWatcher>();
+	if (!watcher->StartWatching(path))
+	{
+		std::cout << "Can't watch " << pathName << " for changes" << std::endl;
+		return;
+	}
+
+	mWatchers.push_back(watcher);
+}
+
+void FileSystem::GetChangedFiles( vector<String>& files )
+{
+	for (const shared_ptr<FileWatcher>& watcher : mWatchers)
+		watcher->GetChangedFiles(files);
+}
+
 } //Namespace RcEngine
\ No newline at end of file
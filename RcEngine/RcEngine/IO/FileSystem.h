@@ -6,6 +6,9 @@
 
 namespace RcEngine {
 
+class PakArchive;
+class FileWatcher;
+
 class _ApiExport FileSystem : public Singleton<FileSystem>  
 {
 public:
@@ -14,9 +17,20 @@ public:
 
 	void RegisterPath(const String& pathName, const String& group);
 
+	/**
+	 * Mount a pak archive into group. Directories and archives of a group are searched
+	 * in the order they are registered. Return false if archive can't be opened.
+	 */
+	bool MountArchive(const String& archiveFile, const String& group);
+
 	String GetCurrentDir() const;
 	bool SetCurrentDir(const String& pathName);
 
+	/**
+	 * Create a directory and its missing parents. Return true if it exists afterwards.
+	 */
+	bool CreateDir(const String& pathName);
+
 
 	/**
 	 * Check if a path is allowed to be accessed. If no paths are registered, all are allowed.
@@ -28,17 +42,59 @@ public:
 
 
 	bool Exits(const String& name, const String& group="General");
+
+	/**
+	 * Return OS path of a loose file, entries of mounted archives have no path and are skipped.
+	 */
 	String Locate(const String& file, const String& group="General");
+
+	/**
+	 * Same as Locate, but return false instead of throwing if there is no such loose file.
+	 */
+	bool FindFile(const String& file, const String& group, String& fullPath);
+
 	shared_ptr<Stream> OpenStream(const String& file, const String& group="General");
 
+	/**
+	 * Files of at least threshold bytes are opened as MappedFileStream by OpenStream, 0 disables it.
+	 */
+	void SetMappedStreamThreshold(uint32_t threshold)	{ mMappedStreamThreshold = threshold; }
+	uint32_t GetMappedStreamThreshold() const			{ return mMappedStreamThreshold; }
+
+	/**
+	 * Watch directories of all groups, and ones registered later, for changed files. Archives
+	 * are not watched.
+	 */
+	void SetWatchChanges(bool enable);
+	bool IsWatchingChanges() const						{ return mWatchChanges; }
+
+	/**
+	 * Append normalized paths of files changed since last call, see PathUtil::GetNormalizedPath.
+	 */
+	void GetChangedFiles(vector<String>& files);
+
 private:
+	void WatchDirectory(const String& pathName);
+
 	void ScanDirInternal(vector<String>& result, String path, const String& startPath,
 		const String& filter, unsigned flags, bool recursive);
 
 private:
+	// Directory or mounted archive of a resource group
+	struct ResourceLocation
+	{
+		String Path;
+		shared_ptr<PakArchive> Archive;
+	};
+
 	unordered_set<String> mAllowedPaths;
-	unordered_map<String, vector<String> > mResouceGroups;
-	
+	unordered_map<String, vector<ResourceLocation> > mResouceGroups;
+
+	uint32_t mMappedStreamThreshold;
+
+	// Watched directories never nest, a file is reported once
+	bool mWatchChanges;
+	vector<shared_ptr<FileWatcher> > mWatchers;
 };
 
 } //Namespace RcEngine
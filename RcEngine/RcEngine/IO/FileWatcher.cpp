@@ -0,0 +1,277 @@
+#include <IO/FileWatcher.h>
+#include <IO/PathUtil.h>
+#include <Core/Timer.h>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/inotify.h>
+	#include <sys/stat.h>
+	#include <poll.h>
+	#include <dirent.h>
+	#include <unistd.h>
+#endif
+
+namespace RcEngine {
+
+// Long enough for an editor to finish saving, short enough to feel immediate
+static const float DefaultSettleDelay = 0.1f;
+
+// Watcher thread checks this often whether watching is stopped
+static const int StopPollMilliseconds = 100;
+
+FileWatcher::FileWatcher()
+	: mSettleDelay(DefaultSettleDelay),
+	  mShouldRun(false),
+#ifdef _WIN32
+	  mDirHandle(nullptr)
+#else
+	  mNotifyHandle(-1)
+#endif
+{
+
+}
+
+FileWatcher::~FileWatcher()
+{
+	StopWatching();
+}
+
+bool FileWatcher::StartWatching( const String& path )
+{
+	StopWatching();
+
+	mPath = PathUtil::RemoveTrailingSlash(path);
+
+#ifdef _WIN32
+	HANDLE dirHandle = CreateFileA(mPath.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+
+	if (dirHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	mDirHandle = dirHandle;
+#else
+	mNotifyHandle = inotify_init();
+	if (mNotifyHandle < 0)
+		return false;
+
+	// inotify isn't recursive, each directory is watched on its own
+	AddWatchRecursive("");
+	if (mWatchDirs.empty())
+	{
+		close(mNotifyHandle);
+		mNotifyHandle = -1;
+		return false;
+	}
+#endif
+
+	mShouldRun = true;
+	mThread = std::thread(&FileWatcher::WatcherThreadFunc, this);
+
+	return true;
+}
+
+void FileWatcher::StopWatching()
+{
+	if (mThread.joinable())
+	{
+		mShouldRun = false;
+		mThread.join();
+	}
+
+#ifdef _WIN32
+	if (mDirHandle)
+	{
+		CloseHandle((HANDLE)mDirHandle);
+		mDirHandle = nullptr;
+	}
+#else
+	if (mNotifyHandle >= 0)
+	{
+		close(mNotifyHandle);
+		mNotifyHandle = -1;
+	}
+
+	mWatchDirs.clear();
+#endif
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mChanges.clear();
+}
+
+void FileWatcher::GetChangedFiles( vector<String>& files )
+{
+	uint64_t now = SystemClock::Now();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto changeIter = mChanges.begin();
+	while (changeIter != mChanges.end())
+	{
+		// Watcher thread may have stamped it after now was read
+		if (changeIter->second <= now && SystemClock::ToSeconds(now - changeIter->second) >= mSettleDelay)
+		{
+			files.push_back(changeIter->first);
+			changeIter = mChanges.erase(changeIter);
+		}
+		else
+			++changeIter;
+	}
+}
+
+void FileWatcher::AddChange( const String& name )
+{
+	String file = PathUtil::GetNormalizedPath(mPath + "/" + name);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mChanges[file] = SystemClock::Now();
+}
+
+#ifdef _WIN32
+
+void FileWatcher::WatcherThreadFunc()
+{
+	HANDLE dirHandle = (HANDLE)mDirHandle;
+
+	OVERLAPPED overlapped;
+	memset(&overlapped, 0, sizeof(overlapped));
+	overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+	// ReadDirectoryChangesW needs a DWORD aligned buffer
+	static const DWORD NotifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+	DWORD buffer[16 * 1024];
+
+	while (mShouldRun)
+	{
+		ResetEvent(overlapped.hEvent);
+		if (!ReadDirectoryChangesW(dirHandle, buffer, sizeof(buffer), TRUE, NotifyFilter, NULL, &overlapped, NULL))
+			break;
+
+		while (mShouldRun && WaitForSingleObject(overlapped.hEvent, StopPollMilliseconds) == WAIT_TIMEOUT) {}
+
+		DWORD length = 0;
+		if (!mShouldRun)
+		{
+			// Buffer must not be written after this thread leaves
+			CancelIo(dirHandle);
+			GetOverlappedResult(dirHandle, &overlapped, &length, TRUE);
+			break;
+		}
+
+		// Zero length means the buffer overflowed and changes are lost
+		if (!GetOverlappedResult(dirHandle, &overlapped, &length, FALSE) || length == 0)
+			continue;
+
+		const uint8_t* entry = reinterpret_cast<const uint8_t*>(buffer);
+		for (;;)
+		{
+			const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(entry);
+			if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+			{
+				int wideLength = int(info->FileNameLength / sizeof(WCHAR));
+				int nameLength = WideCharToMultiByte(CP_ACP, 0, info->FileName, wideLength, NULL, 0, NULL, NULL);
+
+				String name(nameLength, '\0');
+				WideCharToMultiByte(CP_ACP, 0, info->FileName, wideLength, &name[0], nameLength, NULL, NULL);
+
+				AddChange(name);
+			}
+
+			if (info->NextEntryOffset == 0)
+				break;
+
+			entry += info->NextEntryOffset;
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+
+#else
+
+void FileWatcher::AddWatchRecursive( const String& dir )
+{
+	String fullPath = dir.empty() ? mPath : mPath + "/" + dir;
+
+	// Files are written in place or moved over, new directories get a watch of their own
+	int watch = inotify_add_watch(mNotifyHandle, fullPath.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (watch < 0)
+		return;
+
+	mWatchDirs[watch] = dir;
+
+	DIR* dirHandle = opendir(fullPath.c_str());
+	if (!dirHandle)
+		return;
+
+	while (dirent* entry = readdir(dirHandle))
+	{
+		String name = entry->d_name;
+		if (name == "." || name == "..")
+			continue;
+
+		String subDir = dir.empty() ? name : dir + "/" + name;
+
+		struct stat st;
+		if (stat((mPath + "/" + subDir).c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+			AddWatchRecursive(subDir);
+	}
+
+	closedir(dirHandle);
+}
+
+void FileWatcher::WatcherThreadFunc()
+{
+	// Aligned for inotify_event
+	uint64_t buffer[2048];
+
+	while (mShouldRun)
+	{
+		pollfd notifyPoll = { mNotifyHandle, POLLIN, 0 };
+		if (poll(&notifyPoll, 1, StopPollMilliseconds) <= 0)
+			continue;
+
+		ssize_t length = read(mNotifyHandle, buffer, sizeof(buffer));
+		if (length <= 0)
+			continue;
+
+		const char* entry = reinterpret_cast<const char*>(buffer);
+		const char* end = entry + length;
+		while (entry < end)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(entry);
+			entry += sizeof(inotify_event) + event->len;
+
+			// Directory was removed or moved away
+			if (event->mask & IN_IGNORED)
+			{
+				mWatchDirs.erase(event->wd);
+				continue;
+			}
+
+			auto dirIter = mWatchDirs.find(event->wd);
+			if (dirIter == mWatchDirs.end() || event->len == 0)
+				continue;
+
+			String name = dirIter->second.empty() ? String(event->name) : dirIter->second + "/" + event->name;
+
+			if (event->mask & IN_ISDIR)
+			{
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+					AddWatchRecursive(name);
+			}
+			else if (event->mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO))
+			{
+				AddChange(name);
+			}
+		}
+	}
+}
+
+#endif
+
+} // Namespace RcEngine
@@ -0,0 +1,76 @@
+#ifndef FileWatcher_h__
+#define FileWatcher_h__
+
+#include <Core/Prerequisites.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+namespace RcEngine {
+
+/**
+ * Watch a directory and its sub directories for files written on a background thread, with
+ * ReadDirectoryChangesW on Windows and inotify elsewhere. Editors often save a file in several
+ * writes, so a file is reported once no change came for it for the settle delay.
+ */
+class _ApiExport FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	/**
+	 * Start watching path, return false if it can't be watched.
+	 */
+	bool StartWatching(const String& path);
+	void StopWatching();
+
+	bool IsWatching() const								{ return mThread.joinable(); }
+	const String& GetPath() const						{ return mPath; }
+
+	/**
+	 * Seconds without change before a file is reported.
+	 */
+	void SetSettleDelay(float seconds)					{ mSettleDelay = seconds; }
+	float GetSettleDelay() const						{ return mSettleDelay; }
+
+	/**
+	 * Append files written and settled since last call, paths are normalized and start with
+	 * watched path.
+	 */
+	void GetChangedFiles(vector<String>& files);
+
+private:
+	void WatcherThreadFunc();
+
+	// Called on watcher thread, name is relative to watched path
+	void AddChange(const String& name);
+
+#ifndef _WIN32
+	void AddWatchRecursive(const String& dir);
+#endif
+
+private:
+	String mPath;
+	float mSettleDelay;
+
+	std::thread mThread;
+	std::atomic<bool> mShouldRun;
+
+	// Normalized path to time of last change, in SystemClock counts
+	std::map<String, uint64_t> mChanges;
+	std::mutex mMutex;
+
+#ifdef _WIN32
+	void* mDirHandle;
+#else
+	int mNotifyHandle;
+
+	// Watch descriptor to directory relative to watched path
+	std::map<int, String> mWatchDirs;
+#endif
+};
+
+} // Namespace RcEngine
+
+#endif // FileWatcher_h__
@@ -0,0 +1,164 @@
+#include <IO/MappedFileStream.h>
+#include <Core/Exception.h>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace RcEngine {
+
+MappedFileStream::MappedFileStream()
+	: mData(nullptr), mFileHandle(nullptr), mMappingHandle(nullptr)
+{
+
+}
+
+MappedFileStream::MappedFileStream( const String& fileName )
+	: mData(nullptr), mFileHandle(nullptr), mMappingHandle(nullptr)
+{
+	Open(fileName);
+}
+
+MappedFileStream::~MappedFileStream()
+{
+	Close();
+}
+
+uint32_t MappedFileStream::Read( void* dest, uint32_t size )
+{
+	if (!mData)
+	{
+		ENGINE_EXCEPT(Exception::ERR_RT_ASSERTION_FAILED, 
+			"File not open", "MappedFileStream::Read( void*, uint32_t)");
+		return 0;
+	}
+
+	if (size + mPosition > mSize)
+		size = mSize - mPosition;
+
+	if (!size)
+		return 0;
+
+	memcpy(dest, mData + mPosition, size);
+	mPosition += size;
+	return size;
+}
+
+uint32_t MappedFileStream::Write( const void* data, uint32_t size )
+{
+	ENGINE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE, 
+		"Mapped file stream is read only", "MappedFileStream::Write( void*, uint32_t)");
+	return 0;
+}
+
+uint32_t MappedFileStream::Seek( uint32_t position )
+{
+	mPosition = (std::min)(position, mSize);
+	return mPosition;
+}
+
+const void* MappedFileStream::GetView( uint32_t offset, uint32_t size )
+{
+	if (!mData || offset > mSize || size > mSize - offset)
+		return nullptr;
+
+	return mData + offset;
+}
+
+void MappedFileStream::Flush()
+{
+
+}
+
+bool MappedFileStream::Open( const String& fileName )
+{
+	Close();
+
+	mFileName = fileName;
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.HighPart != 0 || fileSize.LowPart == 0)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hMapping)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+
+	const void* data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	mFileHandle = hFile;
+	mMappingHandle = hMapping;
+	mSize = fileSize.LowPart;
+#else
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0 || uint64_t(st.st_size) > UINT32_MAX)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	mSize = uint32_t(st.st_size);
+#endif
+
+	mData = static_cast<const uint8_t*>(data);
+	mPosition = 0;
+
+	return true;
+}
+
+void MappedFileStream::Close()
+{
+	if (mData)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(mData);
+		CloseHandle((HANDLE)mMappingHandle);
+		CloseHandle((HANDLE)mFileHandle);
+#else
+		munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+		mData = nullptr;
+		mFileHandle = nullptr;
+		mMappingHandle = nullptr;
+		mPosition = 0;
+		mSize = 0;
+	}
+}
+
+} //Namespace RcEngine
@@ -0,0 +1,44 @@
+#ifndef MappedFileStream_h__
+#define MappedFileStream_h__
+
+#include <Core/Prerequisites.h>
+#include <IO/Stream.h>
+
+namespace RcEngine {
+
+/**
+ * Read only stream backed by a memory mapped file. Read is a plain memory copy, and
+ * GetView returns pointers into the mapping, so loaders can pass large blobs to the
+ * render factory as init data without an intermediate copy.
+ */
+class _ApiExport MappedFileStream : public Stream
+{
+public:
+	MappedFileStream();
+	MappedFileStream(const String& fileName);
+	virtual ~MappedFileStream();
+
+	virtual const String& GetName() const	{ return mFileName; }
+	virtual uint32_t Read(void* dest, uint32_t size);
+	virtual uint32_t Write(const void* data, uint32_t size);
+	virtual uint32_t Seek(uint32_t position);
+
+	virtual void Close();
+	virtual void Flush();
+
+	virtual const void* GetView(uint32_t offset, uint32_t size);
+
+	bool Open(const String& fileName);
+	bool IsOpen() const { return mData != nullptr; }
+
+protected:
+	String mFileName;
+	const uint8_t* mData;
+
+	void* mFileHandle;
+	void* mMappingHandle;
+};
+
+} //Namespace RcEngine
+
+#endif // MappedFileStream_h__
@@ -0,0 +1,99 @@
+#include <IO/MemoryStream.h>
+#include <Core/Exception.h>
+
+namespace RcEngine {
+
+MemoryStream::MemoryStream()
+	: mData(nullptr)
+{
+
+}
+
+MemoryStream::MemoryStream( const String& name, vector<uint8_t>&& buffer )
+	: mName(name),
+	  mBuffer(std::move(buffer))
+{
+	mData = mBuffer.empty() ? nullptr : &mBuffer[0];
+	mSize = mBuffer.size();
+}
+
+MemoryStream::MemoryStream( const String& name, const void* data, uint32_t size, const shared_ptr<void>& owner )
+	: mName(name),
+	  mData(static_cast<const uint8_t*>(data)),
+	  mOwner(owner)
+{
+	mSize = size;
+}
+
+MemoryStream::~MemoryStream()
+{
+	Close();
+}
+
+uint32_t MemoryStream::Read( void* dest, uint32_t size )
+{
+	if (size + mPosition > mSize)
+		size = mSize - mPosition;
+
+	if (!size)
+		return 0;
+
+	memcpy(dest, mData + mPosition, size);
+	mPosition += size;
+	return size;
+}
+
+uint32_t MemoryStream::Write( const void* data, uint32_t size )
+{
+	if (mOwner)
+	{
+		ENGINE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE,
+			"External memory stream is read only", "MemoryStream::Write( void*, uint32_t)");
+		return 0;
+	}
+
+	if (!size)
+		return 0;
+
+	if (mPosition + size > mBuffer.size())
+		mBuffer.resize(mPosition + size);
+
+	memcpy(&mBuffer[mPosition], data, size);
+	mData = &mBuffer[0];
+
+	mPosition += size;
+	if (mPosition > mSize)
+		mSize = mPosition;
+
+	return size;
+}
+
+uint32_t MemoryStream::Seek( uint32_t position )
+{
+	mPosition = (std::min)(position, mSize);
+	return mPosition;
+}
+
+const void* MemoryStream::GetView( uint32_t offset, uint32_t size )
+{
+	if (!mData || offset > mSize || size > mSize - offset)
+		return nullptr;
+
+	return mData + offset;
+}
+
+void MemoryStream::Close()
+{
+	mData = nullptr;
+	mBuffer.clear();
+	mOwner.reset();
+	mPosition = 0;
+	mSize = 0;
+}
+
+void MemoryStream::Flush()
+{
+
+}
+
+} //Namespace RcEngine
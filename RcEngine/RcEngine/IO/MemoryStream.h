@@ -0,0 +1,44 @@
+#ifndef MemoryStream_h__
+#define MemoryStream_h__
+
+#include <Core/Prerequisites.h>
+#include <IO/Stream.h>
+
+namespace RcEngine {
+
+/**
+ * Stream over a block of memory. The memory is either owned by the stream, or external
+ * memory kept alive by an owner object, e.g. an archive entry inside a mapped file.
+ * External memory is read only.
+ */
+class _ApiExport MemoryStream : public Stream
+{
+public:
+	MemoryStream();
+	MemoryStream(const String& name, vector<uint8_t>&& buffer);
+	MemoryStream(const String& name, const void* data, uint32_t size, const shared_ptr<void>& owner);
+	virtual ~MemoryStream();
+
+	virtual const String& GetName() const	{ return mName; }
+	virtual uint32_t Read(void* dest, uint32_t size);
+	virtual uint32_t Write(const void* data, uint32_t size);
+	virtual uint32_t Seek(uint32_t position);
+
+	virtual void Close();
+	virtual void Flush();
+
+	virtual const void* GetView(uint32_t offset, uint32_t size);
+
+	const uint8_t* GetData() const { return mData; }
+
+protected:
+	String mName;
+	const uint8_t* mData;
+
+	vector<uint8_t> mBuffer;
+	shared_ptr<void> mOwner;
+};
+
+} //Namespace RcEngine
+
+#endif // MemoryStream_h__
@@ -0,0 +1,313 @@
+#include <IO/PakArchive.h>
+#include <IO/MappedFileStream.h>
+#include <IO/MemoryStream.h>
+#include <IO/FileStream.h>
+#include <IO/Compression.h>
+#include <Core/Exception.h>
+
+namespace RcEngine {
+
+namespace {
+
+static const String EmptyName;
+
+bool IsPowerOfTwo(uint32_t value)
+{
+	return value && !(value & (value - 1));
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////
+PakArchive::PakArchive()
+	: mHeader(nullptr), mBuckets(nullptr), mEntries(nullptr), mNames(nullptr)
+{
+
+}
+
+PakArchive::~PakArchive()
+{
+
+}
+
+bool PakArchive::Open( const String& archiveFile )
+{
+	mArchiveStream = std::make_shared<MappedFileStream>();
+	mHeader = nullptr;
+
+	if (!mArchiveStream->Open(archiveFile))
+		return false;
+
+	const PakHeader* header = static_cast<const PakHeader*>(mArchiveStream->GetView(0, sizeof(PakHeader)));
+	if (!header || header->Magic != PakMagic || header->Version != PakVersion)
+		return false;
+
+	// Entries are accessed in place, TOC must be aligned
+	if (header->TocOffset % sizeof(uint64_t) || !IsPowerOfTwo(header->NumBuckets) || header->NumBuckets <= header->NumEntries)
+		return false;
+
+	// Computed in 64 bits, counts of a corrupted header would wrap around in 32 bits
+	uint64_t tableSize = uint64_t(header->NumBuckets) * sizeof(uint32_t) + uint64_t(header->NumEntries) * sizeof(PakEntry);
+	if (tableSize > header->TocSize)
+		return false;
+
+	const uint8_t* toc = static_cast<const uint8_t*>(mArchiveStream->GetView(header->TocOffset, header->TocSize));
+	if (!toc)
+		return false;
+
+	const uint32_t* buckets = reinterpret_cast<const uint32_t*>(toc);
+	const PakEntry* entries = reinterpret_cast<const PakEntry*>(toc + header->NumBuckets * sizeof(uint32_t));
+	uint32_t namesSize = header->TocSize - uint32_t(tableSize);
+
+	for (uint32_t i = 0; i < header->NumBuckets; ++i)
+	{
+		if (buckets[i] > header->NumEntries)
+			return false;
+	}
+
+	for (uint32_t i = 0; i < header->NumEntries; ++i)
+	{
+		const PakEntry& entry = entries[i];
+		if (entry.Offset > header->TocOffset || entry.PackedSize > header->TocOffset - entry.Offset ||
+			entry.NameOffset > namesSize || entry.NameLength > namesSize - entry.NameOffset)
+			return false;
+
+		if (!(entry.Flags & PEF_LZ4) && entry.PackedSize != entry.Size)
+			return false;
+	}
+
+	mHeader = header;
+	mBuckets = buckets;
+	mEntries = entries;
+	mNames = reinterpret_cast<const char*>(toc + tableSize);
+
+	return true;
+}
+
+const String& PakArchive::GetName() const
+{
+	return mArchiveStream ? mArchiveStream->GetName() : EmptyName;
+}
+
+String PakArchive::GetEntryName( uint32_t index ) const
+{
+	return String(mNames + mEntries[index].NameOffset, mEntries[index].NameLength);
+}
+
+const PakEntry* PakArchive::FindEntry( const String& file ) const
+{
+	if (!mHeader || !mHeader->NumEntries)
+		return nullptr;
+
+	String name = NormalizeName(file);
+	uint64_t hash = HashName(name);
+
+	uint32_t mask = mHeader->NumBuckets - 1;
+	for (uint32_t bucket = uint32_t(hash) & mask; mBuckets[bucket]; bucket = (bucket + 1) & mask)
+	{
+		const PakEntry& entry = mEntries[mBuckets[bucket] - 1];
+		if (entry.NameHash == hash && entry.NameLength == name.length() &&
+			memcmp(mNames + entry.NameOffset, name.c_str(), name.length()) == 0)
+		{
+			return &entry;
+		}
+	}
+
+	return nullptr;
+}
+
+shared_ptr<Stream> PakArchive::OpenStream( const String& file ) const
+{
+	const PakEntry* entry = FindEntry(file);
+	if (!entry)
+		return nullptr;
+
+	String streamName = GetName() + "/" + String(mNames + entry->NameOffset, entry->NameLength);
+	const void* data = mArchiveStream->GetView(entry->Offset, entry->PackedSize);
+
+	if (entry->Flags & PEF_LZ4)
+	{
+		vector<uint8_t> buffer(entry->Size);
+		if (!LZ4::Decompress(data, entry->PackedSize, buffer.empty() ? nullptr : &buffer[0], entry->Size))
+		{
+			ENGINE_EXCEPT(Exception::ERR_INTERNAL_ERROR, "Corrupted archive entry " + streamName, "PakArchive::OpenStream");
+		}
+
+		return std::make_shared<MemoryStream>(streamName, std::move(buffer));
+	}
+
+	// Stream keeps the mapping alive
+	return std::make_shared<MemoryStream>(streamName, data, entry->Size, mArchiveStream);
+}
+
+String PakArchive::NormalizeName( const String& file )
+{
+	String result;
+	result.reserve(file.length());
+
+	size_t start = 0;
+	while (start <= file.length())
+	{
+		size_t end = file.find_first_of("/\\", start);
+		if (end == String::npos)
+			end = file.length();
+
+		String component = file.substr(start, end - start);
+		if (component == "..")
+		{
+			size_t parent = result.find_last_of('/');
+			result.erase(parent == String::npos ? 0 : parent);
+		}
+		else if (!component.empty() && component != ".")
+		{
+			if (!result.empty())
+				result += '/';
+
+			for (char c : component)
+				result += char(tolower((unsigned char)c));
+		}
+
+		start = end + 1;
+	}
+
+	return result;
+}
+
+uint64_t PakArchive::HashName( const String& normalizedName )
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (char c : normalizedName)
+	{
+		hash ^= uint8_t(c);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////
+PakArchiveWriter::PakArchiveWriter()
+	: mTotalSize(0), mPackedSize(0)
+{
+
+}
+
+PakArchiveWriter::~PakArchiveWriter()
+{
+
+}
+
+bool PakArchiveWriter::Create( const String& archiveFile )
+{
+	mEntries.clear();
+	mNames.clear();
+	mAddedNames.clear();
+	mTotalSize = mPackedSize = 0;
+
+	mArchiveStream = std::make_shared<FileStream>();
+	if (!mArchiveStream->Open(archiveFile, FILE_WRITE))
+	{
+		mArchiveStream.reset();
+		return false;
+	}
+
+	// Placeholder, written in Finish
+	PakHeader header;
+	memset(&header, 0, sizeof(header));
+	mArchiveStream->Write(&header, sizeof(header));
+
+	return true;
+}
+
+void PakArchiveWriter::AddEntry( const String& file, const void* data, uint32_t size, bool compress )
+{
+	if (!mArchiveStream)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_STATE, "Archive not created", "PakArchiveWriter::AddEntry");
+
+	String name = PakArchive::NormalizeName(file);
+	if (!mAddedNames.insert(name).second)
+		ENGINE_EXCEPT(Exception::ERR_DUPLICATE_ITEM, name + " already in archive", "PakArchiveWriter::AddEntry");
+
+	PakEntry entry;
+	entry.NameHash = PakArchive::HashName(name);
+	entry.NameOffset = mNames.length();
+	entry.NameLength = name.length();
+	entry.Size = size;
+	entry.PackedSize = size;
+	entry.Flags = PEF_None;
+
+	const void* packedData = data;
+	if (compress && size)
+	{
+		mCompressBuffer.resize(LZ4::CompressBound(size));
+		uint32_t packedSize = LZ4::Compress(data, size, &mCompressBuffer[0]);
+
+		if (packedSize <= size - size / 8)
+		{
+			entry.PackedSize = packedSize;
+			entry.Flags |= PEF_LZ4;
+			packedData = &mCompressBuffer[0];
+		}
+	}
+
+	static const uint8_t Padding[PakDataAlignment] = { 0 };
+	uint32_t position = mArchiveStream->GetPosition();
+	uint32_t paddingSize = (PakDataAlignment - position % PakDataAlignment) % PakDataAlignment;
+
+	if (uint64_t(position) + paddingSize + entry.PackedSize > UINT32_MAX)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_PARAMS, "Archive exceeds 4GB", "PakArchiveWriter::AddEntry");
+
+	mArchiveStream->Write(Padding, paddingSize);
+	entry.Offset = position + paddingSize;
+	mArchiveStream->Write(packedData, entry.PackedSize);
+
+	mEntries.push_back(entry);
+	mNames += name;
+
+	mTotalSize += entry.Size;
+	mPackedSize += entry.PackedSize;
+}
+
+void PakArchiveWriter::Finish()
+{
+	if (!mArchiveStream)
+		ENGINE_EXCEPT(Exception::ERR_INVALID_STATE, "Archive not created", "PakArchiveWriter::Finish");
+
+	PakHeader header;
+	header.Magic = PakMagic;
+	header.Version = PakVersion;
+	header.NumEntries = mEntries.size();
+
+	header.NumBuckets = 2;
+	while (header.NumBuckets < header.NumEntries * 2)
+		header.NumBuckets <<= 1;
+
+	vector<uint32_t> buckets(header.NumBuckets, 0);
+	uint32_t mask = header.NumBuckets - 1;
+	for (uint32_t i = 0; i < mEntries.size(); ++i)
+	{
+		uint32_t bucket = uint32_t(mEntries[i].NameHash) & mask;
+		while (buckets[bucket])
+			bucket = (bucket + 1) & mask;
+		buckets[bucket] = i + 1;
+	}
+
+	static const uint8_t Padding[PakDataAlignment] = { 0 };
+	uint32_t position = mArchiveStream->GetPosition();
+	uint32_t paddingSize = (PakDataAlignment - position % PakDataAlignment) % PakDataAlignment;
+	mArchiveStream->Write(Padding, paddingSize);
+
+	header.TocOffset = position + paddingSize;
+	header.TocSize = buckets.size() * sizeof(uint32_t) + mEntries.size() * sizeof(PakEntry) + mNames.length();
+
+	mArchiveStream->Write(&buckets[0], buckets.size() * sizeof(uint32_t));
+	if (!mEntries.empty())
+		mArchiveStream->Write(&mEntries[0], mEntries.size() * sizeof(PakEntry));
+	mArchiveStream->Write(mNames.c_str(), mNames.length());
+
+	mArchiveStream->Seek(0);
+	mArchiveStream->Write(&header, sizeof(header));
+	mArchiveStream->Close();
+	mArchiveStream.reset();
+}
+
+} // Namespace RcEngine
@@ -0,0 +1,151 @@
+#ifndef PakArchive_h__
+#define PakArchive_h__
+
+#include <Core/Prerequisites.h>
+
+namespace RcEngine {
+
+class Stream;
+class FileStream;
+class MappedFileStream;
+
+/**
+ * Pak archive layout, all integers little endian:
+ *
+ *   PakHeader
+ *   entry data, each entry aligned to PakDataAlignment
+ *   table of contents at PakHeader::TocOffset:
+ *     uint32_t buckets[NumBuckets]		open addressing hash table, entry index + 1, 0 if empty
+ *     PakEntry entries[NumEntries]
+ *     char names[]						normalized entry names, not null terminated
+ *
+ * Entry names are relative paths normalized by PakArchive::NormalizeName, and hashed
+ * with 64 bit FNV-1a. NumBuckets is a power of two at least twice of NumEntries.
+ */
+struct PakHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t NumEntries;
+	uint32_t NumBuckets;
+	uint32_t TocOffset;
+	uint32_t TocSize;
+};
+
+enum PakEntryFlags
+{
+	PEF_None = 0,
+	PEF_LZ4  = 1UL << 0
+};
+
+struct PakEntry
+{
+	uint64_t NameHash;
+	uint32_t NameOffset;
+	uint32_t NameLength;
+	uint32_t Offset;
+	uint32_t Size;
+	uint32_t PackedSize;
+	uint32_t Flags;
+};
+
+static const uint32_t PakMagic = 0x4B415052;   // "RPAK"
+static const uint32_t PakVersion = 1;
+static const uint32_t PakDataAlignment = 16;
+
+/**
+ * Read only archive mounted into FileSystem resource groups. The whole archive is
+ * memory mapped and the table of contents is used in place, a lookup is one hash
+ * probe without touching the OS. Uncompressed entries are returned as streams over
+ * the mapping, LZ4 entries are decompressed into memory on open.
+ *
+ * Lookups and OpenStream are thread safe.
+ */
+class _ApiExport PakArchive
+{
+public:
+	PakArchive();
+	~PakArchive();
+
+	/**
+	 * Map archive file and validate its table of contents. Return false if the file
+	 * can't be mapped or is not a valid archive.
+	 */
+	bool Open(const String& archiveFile);
+
+	const String& GetName() const;
+
+	uint32_t GetNumEntries() const		{ return mHeader ? mHeader->NumEntries : 0; }
+	const PakEntry& GetEntry(uint32_t index) const	{ return mEntries[index]; }
+	String GetEntryName(uint32_t index) const;
+
+	/**
+	 * Return entry of file, nullptr if not exits.
+	 */
+	const PakEntry* FindEntry(const String& file) const;
+
+	bool Exits(const String& file) const	{ return FindEntry(file) != nullptr; }
+
+	/**
+	 * Open file in archive, return nullptr if not exits.
+	 */
+	shared_ptr<Stream> OpenStream(const String& file) const;
+
+public:
+	/**
+	 * Convert to archive name: slashes, lower case, no "." or ".." components.
+	 */
+	static String NormalizeName(const String& file);
+	static uint64_t HashName(const String& normalizedName);
+
+private:
+	shared_ptr<MappedFileStream> mArchiveStream;
+
+	const PakHeader* mHeader;
+	const uint32_t* mBuckets;
+	const PakEntry* mEntries;
+	const char* mNames;
+};
+
+/**
+ * Build a pak archive. Entry data is written as it is added, only the table of
+ * contents is kept in memory until Finish.
+ */
+class _ApiExport PakArchiveWriter
+{
+public:
+	PakArchiveWriter();
+	~PakArchiveWriter();
+
+	bool Create(const String& archiveFile);
+
+	/**
+	 * Add an entry. With compress, the entry is stored LZ4 compressed unless that
+	 * saves less than 1/8 of its size. Throw if name is already added.
+	 */
+	void AddEntry(const String& file, const void* data, uint32_t size, bool compress);
+
+	/**
+	 * Write table of contents and header, close the file.
+	 */
+	void Finish();
+
+	uint32_t GetNumEntries() const	{ return mEntries.size(); }
+	uint32_t GetTotalSize() const	{ return mTotalSize; }
+	uint32_t GetPackedSize() const	{ return mPackedSize; }
+
+private:
+	shared_ptr<FileStream> mArchiveStream;
+
+	vector<PakEntry> mEntries;
+	String mNames;
+	unordered_set<String> mAddedNames;
+
+	uint32_t mTotalSize;
+	uint32_t mPackedSize;
+	vector<uint8_t> mCompressBuffer;
+};
+
+} // Namespace RcEngine
+
+#endif // PakArchive_h__
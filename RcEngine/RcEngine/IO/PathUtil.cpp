@@ -9,7 +9,7 @@ void PathUtil::SplitPath( const String& fullPath, String& pathName, String& file
 	size_t extPos = fullPathCopy.find_last_of('.');
 	size_t pathPos = fullPathCopy.find_last_of('/');
 
-	if (extPos != String::npos || (pathPos == String::npos || pathPos > extPos))
+	if (extPos != String::npos && (pathPos == String::npos || pathPos < extPos))
 	{
 		String extStr = fullPathCopy.substr(extPos);
 		std::transform(extStr.begin(), extStr.end(), extStr.begin(), (int(*)(int))tolower);
@@ -105,4 +105,50 @@ String PathUtil::GetInternalPath(const String& fullPath)
 	return fullPathCopy;
 }
 
+String PathUtil::GetNormalizedPath( const String& fullPath )
+{
+	String fullPathCopy = GetInternalPath(fullPath);
+
+#ifdef _WIN32
+	std::transform(fullPathCopy.begin(), fullPathCopy.end(), fullPathCopy.begin(), (int(*)(int))tolower);
+#endif
+
+	bool absolute = !fullPathCopy.empty() && fullPathCopy[0] == '/';
+
+	vector<String> parts;
+	size_t partBegin = 0;
+	while (partBegin <= fullPathCopy.length())
+	{
+		size_t partEnd = fullPathCopy.find('/', partBegin);
+		if (partEnd == String::npos)
+			partEnd = fullPathCopy.length();
+
+		String part = fullPathCopy.substr(partBegin, partEnd - partBegin);
+		if (part == "..")
+		{
+			// Leading ".." of a relative path can't be resolved
+			if (!parts.empty() && parts.back() != "..")
+				parts.pop_back();
+			else if (!absolute)
+				parts.push_back(part);
+		}
+		else if (!part.empty() && part != ".")
+		{
+			parts.push_back(part);
+		}
+
+		partBegin = partEnd + 1;
+	}
+
+	String result = absolute ? "/" : "";
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		if (i > 0)
+			result += '/';
+		result += parts[i];
+	}
+
+	return result;
+}
+
 }
\ No newline at end of file
@@ -28,6 +28,13 @@ public:
 	static String RemoveTrailingSlash(const String& pathName);
 
 	static String GetInternalPath(const String& fullPath);
+
+	/**
+	 * Internal format with "." and "dir/.." removed and repeated slashes collapsed, lower case on
+	 * Windows. Two spellings of the same file give the same string, as long as both are relative
+	 * to the same directory or both absolute.
+	 */
+	static String GetNormalizedPath(const String& fullPath);
 };
 
 }
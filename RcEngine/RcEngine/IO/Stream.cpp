@@ -20,6 +20,11 @@ const String& Stream::GetName() const
 	return NoName;
 }
 
+const void* Stream::GetView( uint32_t offset, uint32_t size )
+{
+	return nullptr;
+}
+
 
 int8_t Stream::ReadByte()
 {
@@ -92,6 +97,14 @@ String Stream::ReadString()
 	return ret;
 }
 
+String Stream::ReadText()
+{
+	String ret(mSize - (std::min)(mPosition, mSize), '\0');
+	if (!ret.empty())
+		ret.resize(Read(&ret[0], uint32_t(ret.size())));
+	return ret;
+}
+
 bool Stream::WriteInt(int32_t value)
 {
 	return Write(&value, sizeof value) == sizeof value;
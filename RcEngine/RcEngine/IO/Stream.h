@@ -29,6 +29,10 @@ public:
 	/// Clears all buffers for this stream and flush any buffered output to the underlying device.
 	virtual void Flush() = 0;
 
+	/// Return pointer to size bytes at offset if the stream is memory backed, null otherwise. 
+	/// The pointer is valid until the stream is closed.
+	virtual const void* GetView(uint32_t offset, uint32_t size);
+
 	/// Read a 32-bit integer.
 	int32_t ReadInt();
 	/// Read a 16-bit integer.
@@ -47,6 +51,8 @@ public:
 	float ReadFloat();
 	/// Read a null-terminated string.
 	String ReadString();
+	/// Read from current position to the end of the stream as text.
+	String ReadText();
 
 	/// Write bytes to the stream. Return number of bytes actually written.
 	virtual uint32_t Write(const void* data, uint32_t size) = 0;
@@ -10,6 +10,7 @@ enum RenderDeviceType
 	RD_OpenGL = 0,
 	RD_OpenGL_ES,
 	RD_Direct3D11,
+	RD_Null,			// Headless, no GPU
 	RD_Count
 };
 
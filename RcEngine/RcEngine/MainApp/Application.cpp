@@ -9,6 +9,10 @@
 #include <Graphics/Font.h>
 #include <Resource/ResourceManager.h>
 #include <Core/Environment.h>
+#include <Core/JobSystem.h>
+#include <Core/FrameAllocator.h>
+#include <Graphics/TextureStreamer.h>
+#include <Graphics/ShaderCache.h>
 #include <Core/ModuleManager.h>
 #include <Core/Exception.h>
 #include <Core/Profiler.h>
@@ -28,6 +32,7 @@ Application* Application::msApp = nullptr;
 
 Application::Application( const String& config )
 	: mEndGame(false),
+	  mActice(false),
 	  mAppPaused(false),
 	  mConfigFile(config)
 {
@@ -39,6 +44,10 @@ Application::Application( const String& config )
 	FileSystem::Initialize();
 	ResourceManager::Initialize();
 	ProfilerManager::Initialize();
+	JobSystem::Initialize();
+	FrameAllocator::Initialize();
+	TextureStreamer::Initialize();
+	ShaderCache::Initialize();
 	UIManager::Initialize();
 
 	// Init System Clock
@@ -63,7 +72,10 @@ Application::Application( const String& config )
 
 Application::~Application( void )
 {
-	
+	ShaderCache::Finalize();
+	TextureStreamer::Finalize();
+	JobSystem::Finalize();
+	FrameAllocator::Finalize();
 }
 
 void Application::RunGame()
@@ -97,6 +109,9 @@ void Application::Tick()
 	// Andvance Game Time
 	mTimer.Tick();
 
+	// Release per frame allocations of last frame
+	FrameAllocator::GetSingleton().Reset();
+
 	// Read Input
 	inputSystem.BeginEvents();
 		mMainWindow->CollectOSEvents();
@@ -109,6 +124,15 @@ void Application::Tick()
 
 	inputSystem.Dispatch(deltaTime);
 
+	// Run jobs which must execute on main thread
+	JobSystem::GetSingleton().Update();
+
+	// Finalize resources loaded in background, evict unused ones over budget
+	ResourceManager::GetSingleton().Update();
+
+	// Swap in streamed texture levels and start loading newly requested ones
+	TextureStreamer::GetSingleton().Update();
+
 	// update
 	Update(deltaTime);
 	
@@ -120,6 +144,9 @@ void Application::Tick()
 
 	// render
 	Render();
+
+	// Collect profiler scopes of all threads
+	ProfilerManager::GetSingleton().EndFrame();
 }
 
 void Application::ProcessEventQueue()
@@ -158,6 +185,8 @@ void Application::LoadAllModules()
 	ModuleType deviceType = MT_Render_OpengGL;
 	if (mAppSettings.RHDeviceType == RD_Direct3D11)
 		deviceType = MT_Render_D3D11;
+	else if (mAppSettings.RHDeviceType == RD_Null)
+		deviceType = MT_Render_Null;
 
 	ModuleManager::GetSingleton().Load(deviceType);
 }
@@ -234,8 +263,16 @@ void Application::Create()
 	// UI Graphics initailize
 	UIManager::GetSingleton().OnGraphicsInitialize();
 
-	// Show main window
-	mMainWindow->ShowWindow();
+	if (mAppSettings.RHDeviceType == RD_Null)
+	{
+		// Headless, no window message will activate application
+		mActice = true;
+	}
+	else
+	{
+		// Show main window
+		mMainWindow->ShowWindow();
+	}
 }
 
 void Application::Release()
@@ -302,6 +339,8 @@ void Application::LoadConfiguration()
 			mAppSettings.RHDeviceType = RD_OpenGL;
 		else if (name == "Direct3D11")
 			mAppSettings.RHDeviceType = RD_Direct3D11;
+		else if (name == "Null")
+			mAppSettings.RHDeviceType = RD_Null;
 		else
 		{
 			assert(false);
@@ -310,17 +349,41 @@ void Application::LoadConfiguration()
 	else
 		mAppSettings.RHDeviceType = RD_OpenGL;
 
+	// Compiled shaders are kept across runs only if a cache directory is given
+	node = appNode->FirstNode("ShaderCache");
+	if (node)
+	{
+		ShaderCache::GetSingleton().SetDirectory(node->AttributeString("Path", ""));
+	}
+
 	XMLNodePtr resNode = appNode->FirstNode("Resource");
 	for (XMLNodePtr groupNode = resNode->FirstNode("Group"); groupNode; groupNode = groupNode->NextSibling("Group"))
 	{
 		String groupName = groupNode->Attribute("Name")->ValueString();
-		for (XMLNodePtr pathNode = groupNode->FirstNode("Path"); pathNode; pathNode = pathNode->NextSibling("Path"))
+
+		// Paths and archives are searched in the order they are listed
+		for (XMLNodePtr pathNode = groupNode->FirstNode(); pathNode; pathNode = pathNode->NextSibling())
 		{
 			String pathName = pathNode->Attribute("Name")->ValueString();
-			ResourceManager::GetSingleton().AddResourceGroup(groupName);
-			FileSystem::GetSingleton().RegisterPath(pathName, groupName);
+			if (pathNode->NodeName() == "Path")
+			{
+				ResourceManager::GetSingleton().AddResourceGroup(groupName);
+				FileSystem::GetSingleton().RegisterPath(pathName, groupName);
+			}
+			else if (pathNode->NodeName() == "Archive")
+			{
+				ResourceManager::GetSingleton().AddResourceGroup(groupName);
+				FileSystem::GetSingleton().MountArchive(pathName, groupName);
+			}
 		}
 	}
+
+	// Reload effects, materials and textures when their files are saved, for development
+	node = appNode->FirstNode("HotReload");
+	if (node && node->AttributeInt("Enable", 0))
+	{
+		FileSystem::GetSingleton().SetWatchChanges(true);
+	}
 }
 
 
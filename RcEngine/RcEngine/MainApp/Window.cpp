@@ -56,7 +56,9 @@ void Window::SetMouseVisible( bool visible )
 	if (mMouseVisible != visible)
 	{
 		mMouseVisible = visible;
+#ifdef RcWindows
 		ShowCursor(mMouseVisible);
+#endif
 	}
 }
 
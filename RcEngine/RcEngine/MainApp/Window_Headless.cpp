@@ -0,0 +1,81 @@
+#include <MainApp/Window.h>
+#include <MainApp/AppSettings.h>
+#include <Core/Exception.h>
+#include <Input/InputSystem.h>
+
+#if !defined(RcWindows) && !defined(RcAndroid)
+
+namespace RcEngine {
+
+// Window without OS window for headless builds, no OS event ever comes.
+Window::Window(const ApplicationSettings& settings )
+	: mInSizeMove(false),
+	  mMaximized(false),
+	  mMinimized(false),
+	  mMouseVisible(false)
+{
+	msWindow = this;
+
+	mInputSystem = InputSystem::GetSingletonPtr();	
+	if (!mInputSystem)
+		ENGINE_EXCEPT(Exception::ERR_RT_ASSERTION_FAILED, "Input System Not Initialized!", "Window::Window");
+
+	mName = settings.AppTitle;
+	mFullscreen = settings.Fullscreen;
+
+	mLeft = settings.Left;
+	mTop = settings.Top;
+	mWidth = settings.Width;
+	mHeight = settings.Height;
+}
+
+Window::~Window(void)
+{
+	PaintEvent.clear();
+	ResumeEvent.clear();
+	SuspendEvent.clear();
+	ApplicationActivatedEvent.clear();
+	ApplicationDeactivatedEvent.clear();
+	WindowClose.clear();
+	UserResizedEvent.clear();
+}
+
+void Window::SetTitle( const String& title )
+{
+	mName = title;
+}
+
+void Window::UpdateWindowSize()
+{
+
+}
+
+void Window::ForceMouseToCenter()
+{
+	SetMouseVisible(false);
+}
+
+void Window::SetMousePosition(int32_t x, int32_t y)
+{
+
+}
+
+void Window::CollectOSEvents()
+{
+
+}
+
+void Window::ShowWindow()
+{
+
+}
+
+void Window::Reposition( int32_t left, int32_t top )
+{
+	mLeft = left;
+	mTop = top;
+}
+
+}
+
+#endif
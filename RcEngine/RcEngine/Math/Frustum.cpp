@@ -0,0 +1,210 @@
+#include <Math/Frustum.h>
+#include <Core/CpuInfo.h>
+#include <emmintrin.h>
+
+#if defined(_MSC_VER)
+#	include <immintrin.h>
+#	define ENGINE_HAS_AVX_PATH
+#	define ENGINE_TARGET_AVX
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#	include <immintrin.h>
+#	define ENGINE_HAS_AVX_PATH
+#	define ENGINE_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace RcEngine {
+
+namespace {
+
+FrustumCullPath gCullPath = FCP_Auto;
+
+// Plane coefficients with absolute normal precomputed, shared by all code paths.
+struct CullPlane
+{
+	float NX, NY, NZ, D;
+	float AbsNX, AbsNY, AbsNZ;
+};
+
+void SetupCullPlanes(const Frustumf& frustum, CullPlane planes[6])
+{
+	for (int i = 0; i < 6; ++i)
+	{
+		const Planef& plane = frustum.Planes[i];
+		planes[i].NX = plane.Normal.X();
+		planes[i].NY = plane.Normal.Y();
+		planes[i].NZ = plane.Normal.Z();
+		planes[i].D = plane.Distance;
+		planes[i].AbsNX = fabs(planes[i].NX);
+		planes[i].AbsNY = fabs(planes[i].NY);
+		planes[i].AbsNZ = fabs(planes[i].NZ);
+	}
+}
+
+/**
+ * Write visible bits of a block of boxes starting at index base, return new visible count.
+ */
+inline uint32_t EmitVisible(uint32_t bits, uint32_t base, uint32_t* visibleMask, uint32_t* visibleIndices, uint32_t numVisible)
+{
+	visibleMask[base >> 5] |= (bits << (base & 31));
+
+	if (visibleIndices)
+	{
+		while (bits)
+		{
+			uint32_t bit = 0;
+			while (!(bits & (1U << bit))) ++bit;
+
+			visibleIndices[numVisible++] = base + bit;
+			bits &= bits - 1;
+		}
+	}
+	else
+	{
+		while (bits)
+		{
+			++numVisible;
+			bits &= bits - 1;
+		}
+	}
+
+	return numVisible;
+}
+
+/**
+ * Scalar version, must keep the same operation order as SIMD path for identical result.
+ */
+uint32_t VisibleBatchScalar(const CullPlane planes[6], const BoundingBoxSoA<float>& boxes, uint32_t begin,
+	                        uint32_t* visibleMask, uint32_t* visibleIndices, uint32_t numVisible)
+{
+	for (uint32_t i = begin; i < boxes.Count; ++i)
+	{
+		bool outside = false;
+		for (int p = 0; p < 6; ++p)
+		{
+			float dist = planes[p].NX * boxes.CenterX[i] + planes[p].NY * boxes.CenterY[i];
+			dist = dist + planes[p].NZ * boxes.CenterZ[i];
+
+			float radius = planes[p].AbsNX * boxes.ExtentX[i] + planes[p].AbsNY * boxes.ExtentY[i];
+			radius = radius + planes[p].AbsNZ * boxes.ExtentZ[i];
+
+			outside |= ((dist + radius) + planes[p].D < 0.0f);
+		}
+
+		if (!outside)
+			numVisible = EmitVisible(1U, i, visibleMask, visibleIndices, numVisible);
+	}
+
+	return numVisible;
+}
+
+uint32_t VisibleBatchSSE2(const CullPlane planes[6], const BoundingBoxSoA<float>& boxes, uint32_t begin,
+	                      uint32_t* visibleMask, uint32_t* visibleIndices, uint32_t numVisible, uint32_t* processed)
+{
+	const __m128 zero = _mm_setzero_ps();
+
+	uint32_t i = begin;
+	for (; i + 4 <= boxes.Count; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(boxes.CenterX + i);
+		__m128 cy = _mm_loadu_ps(boxes.CenterY + i);
+		__m128 cz = _mm_loadu_ps(boxes.CenterZ + i);
+		__m128 ex = _mm_loadu_ps(boxes.ExtentX + i);
+		__m128 ey = _mm_loadu_ps(boxes.ExtentY + i);
+		__m128 ez = _mm_loadu_ps(boxes.ExtentZ + i);
+
+		__m128 outside = zero;
+		for (int p = 0; p < 6; ++p)
+		{
+			__m128 dist = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].NX), cx), _mm_mul_ps(_mm_set1_ps(planes[p].NY), cy));
+			dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p].NZ), cz));
+
+			__m128 radius = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].AbsNX), ex), _mm_mul_ps(_mm_set1_ps(planes[p].AbsNY), ey));
+			radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(planes[p].AbsNZ), ez));
+
+			__m128 d = _mm_add_ps(_mm_add_ps(dist, radius), _mm_set1_ps(planes[p].D));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(d, zero));
+		}
+
+		uint32_t bits = ~uint32_t(_mm_movemask_ps(outside)) & 0xF;
+		numVisible = EmitVisible(bits, i, visibleMask, visibleIndices, numVisible);
+	}
+
+	*processed = i;
+	return numVisible;
+}
+
+#ifdef ENGINE_HAS_AVX_PATH
+
+ENGINE_TARGET_AVX
+uint32_t VisibleBatchAVX(const CullPlane planes[6], const BoundingBoxSoA<float>& boxes, uint32_t begin,
+	                     uint32_t* visibleMask, uint32_t* visibleIndices, uint32_t numVisible, uint32_t* processed)
+{
+	const __m256 zero = _mm256_setzero_ps();
+
+	uint32_t i = begin;
+	for (; i + 8 <= boxes.Count; i += 8)
+	{
+		__m256 cx = _mm256_loadu_ps(boxes.CenterX + i);
+		__m256 cy = _mm256_loadu_ps(boxes.CenterY + i);
+		__m256 cz = _mm256_loadu_ps(boxes.CenterZ + i);
+		__m256 ex = _mm256_loadu_ps(boxes.ExtentX + i);
+		__m256 ey = _mm256_loadu_ps(boxes.ExtentY + i);
+		__m256 ez = _mm256_loadu_ps(boxes.ExtentZ + i);
+
+		__m256 outside = zero;
+		for (int p = 0; p < 6; ++p)
+		{
+			__m256 dist = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].NX), cx), _mm256_mul_ps(_mm256_set1_ps(planes[p].NY), cy));
+			dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(planes[p].NZ), cz));
+
+			__m256 radius = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].AbsNX), ex), _mm256_mul_ps(_mm256_set1_ps(planes[p].AbsNY), ey));
+			radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(planes[p].AbsNZ), ez));
+
+			__m256 d = _mm256_add_ps(_mm256_add_ps(dist, radius), _mm256_set1_ps(planes[p].D));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, zero, _CMP_LT_OQ));
+		}
+
+		uint32_t bits = ~uint32_t(_mm256_movemask_ps(outside)) & 0xFF;
+		numVisible = EmitVisible(bits, i, visibleMask, visibleIndices, numVisible);
+	}
+
+	_mm256_zeroupper();
+
+	*processed = i;
+	return numVisible;
+}
+
+#endif
+
+}
+
+template<>
+uint32_t Frustum<float>::VisibleBatch( const BoundingBoxSoA<float>& boxes, uint32_t* visibleMask, uint32_t* visibleIndices ) const
+{
+	CullPlane planes[6];
+	SetupCullPlanes(*this, planes);
+
+	for (uint32_t word = 0; word < (boxes.Count + 31) / 32; ++word)
+		visibleMask[word] = 0;
+
+	// Blocks never straddle a mask word since 32 is multiple of 8 and 4
+	uint32_t numVisible = 0;
+	uint32_t processed = 0;
+
+#ifdef ENGINE_HAS_AVX_PATH
+	if ((gCullPath == FCP_Auto || gCullPath == FCP_AVX) && CpuInfo::HasAVX())
+		numVisible = VisibleBatchAVX(planes, boxes, processed, visibleMask, visibleIndices, numVisible, &processed);
+#endif
+
+	if (gCullPath != FCP_Scalar && CpuInfo::HasSSE2())
+		numVisible = VisibleBatchSSE2(planes, boxes, processed, visibleMask, visibleIndices, numVisible, &processed);
+
+	return VisibleBatchScalar(planes, boxes, processed, visibleMask, visibleIndices, numVisible);
+}
+
+void SetFrustumCullPath( FrustumCullPath path )
+{
+	gCullPath = path;
+}
+
+} // Namespace RcEngine
@@ -1,6 +1,7 @@
 #ifndef Frustum_h__
 #define Frustum_h__
 
+#include <Core/Prerequisites.h>
 #include <Math/Plane.h>
 #include <Math/Matrix.h>
 #include <Math/BoundingSphere.h>
@@ -30,6 +31,22 @@ enum FrustumCorner
 	FC_Far_Bottom_Right,
 };
 
+/**
+ * Non-owning view of bounding boxes in structure-of-arrays center/extent form,
+ * used by batch frustum culling.
+ */
+template<typename Real>
+struct BoundingBoxSoA
+{
+	const Real* CenterX;
+	const Real* CenterY;
+	const Real* CenterZ;
+	const Real* ExtentX;
+	const Real* ExtentY;
+	const Real* ExtentZ;
+	uint32_t Count;
+};
+
 template<typename Real>
 class Frustum
 {
@@ -48,6 +65,16 @@ public:
 	ContainmentType Contain(const BoundingBox<Real>& box) const; 
 	/*ContainmentType Contain(const Frustum<Real>& frustum) const; */
 
+	/**
+	 * Batch test of boxes against frustum. Bit i of visibleMask (visibleMask[i/32]) is set if box i
+	 * is not outside the frustum, visibleMask must hold (Count+31)/32 words. If visibleIndices is not 
+	 * null, indices of visible boxes are written in ascending order. Return number of visible boxes.
+	 *
+	 * A box is culled if its positive vertex is behind any plane, the same test as Contain. The float
+	 * version runs with SSE2/AVX selected at runtime, all code paths give identical results.
+	 */
+	uint32_t VisibleBatch(const BoundingBoxSoA<Real>& boxes, uint32_t* visibleMask, uint32_t* visibleIndices = nullptr) const;
+
 	void UpdateCorner();
 
 public:
@@ -59,6 +86,24 @@ public:
 
 typedef Frustum<float> Frustumf;
 
+// SIMD version, implemented in Frustum.cpp
+template<> _ApiExport 
+uint32_t Frustum<float>::VisibleBatch(const BoundingBoxSoA<float>& boxes, uint32_t* visibleMask, uint32_t* visibleIndices) const;
+
+enum FrustumCullPath
+{
+	FCP_Auto,
+	FCP_Scalar,
+	FCP_SSE2,
+	FCP_AVX
+};
+
+/**
+ * Force the code path of Frustum<float>::VisibleBatch, for benchmarks and tests. Unsupported
+ * paths fall back to the next narrower one, SIMD paths still finish with a scalar tail.
+ */
+_ApiExport void SetFrustumCullPath(FrustumCullPath path);
+
 #include <Math/Frustum.inl>
 
 }
@@ -131,6 +131,40 @@ ContainmentType Frustum<Real>::Contain( const BoundingBox<Real>& aabb ) const
 	return allInside ? CT_Contains : CT_Intersects;
 }
 
+template<typename Real>
+uint32_t Frustum<Real>::VisibleBatch( const BoundingBoxSoA<Real>& boxes, uint32_t* visibleMask, uint32_t* visibleIndices ) const
+{
+	uint32_t numVisible = 0;
+
+	for (uint32_t word = 0; word < (boxes.Count + 31) / 32; ++word)
+		visibleMask[word] = 0;
+
+	for (uint32_t i = 0; i < boxes.Count; ++i)
+	{
+		bool outside = false;
+		for (const Plane<Real>& plane : Planes)
+		{
+			Real dist = plane.Normal.X() * boxes.CenterX[i] + plane.Normal.Y() * boxes.CenterY[i] + plane.Normal.Z() * boxes.CenterZ[i];
+			Real radius = fabs(plane.Normal.X()) * boxes.ExtentX[i] + fabs(plane.Normal.Y()) * boxes.ExtentY[i] + fabs(plane.Normal.Z()) * boxes.ExtentZ[i];
+			if (dist + radius + plane.Distance < Real(0))
+			{
+				outside = true;
+				break;
+			}
+		}
+
+		if (!outside)
+		{
+			visibleMask[i >> 5] |= (1U << (i & 31));
+			if (visibleIndices)
+				visibleIndices[numVisible] = i;
+			++numVisible;
+		}
+	}
+
+	return numVisible;
+}
+
 //template<typename Real>
 //ContainmentType Frustum<Real>::Contain( const Frustum<Real>& frustum ) const
 //{
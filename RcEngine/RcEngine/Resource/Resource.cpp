@@ -1,4 +1,5 @@
 #include <Resource/Resource.h>
+#include <Resource/ResourceManager.h>
 #include <Core/Exception.h>
 
 
@@ -6,7 +7,7 @@ namespace RcEngine {
 
 Resource::Resource( ResourceTypes resType, ResourceManager* creator, ResourceHandle handle, const String& name, const String& group )
 	: mResourceType(resType), mCreator(creator), mResourceName(name), mResourceHandle(handle), mGroup(group), mBackground(false), mSize(0),
-		mLoadState(Unloaded)
+		mLoadState(Unloaded), mLastUsedFrame(0)
 {
 
 }
@@ -18,55 +19,126 @@ Resource::~Resource()
 
 void Resource::Load( bool background /*= false*/ )
 {
-	LoadSync();
+	if (background)
+		LoadAsync();
+	else
+		LoadSync();
 }
 
 void Resource::Unload()
 {
+	if (GetLoadState() != Loaded)
+		return;
 
+	SetLoadState(Unloading);
+	UnloadImpl();
+
+	mCreator->OnResourceUnloaded(*this);
+	mSize = 0;
+
+	SetLoadState(Unloaded);
 }
 
 void Resource::Reload()
 {
+	if (GetLoadState() != Loaded)
+		return;
+
+	uint32_t oldSize = mSize;
+	mBackground = false;
+
+	try
+	{
+		ReloadImpl();
+	}
+	catch (...)
+	{
+		mCreator->OnResourceReloaded(*this, oldSize);
+		throw;
+	}
 
+	mCreator->OnResourceReloaded(*this, oldSize);
 }
 
-void Resource::Touch()
+void Resource::ReloadImpl()
 {
+	UnloadImpl();
+	mSize = 0;
 
+	try
+	{
+		PrepareImpl();
+		LoadImpl();
+	}
+	catch (...)
+	{
+		mSize = 0;
+		SetLoadState(Unloaded);
+		throw;
+	}
+}
+
+void Resource::Touch()
+{
+	mLastUsedFrame = mCreator->GetFrameNumber();
 }
 
 void Resource::LoadSync()
 {
-	if (mLoadState == Unloaded)
+	if (BeginLoading())
 	{
-		SetLoadState(Loading);
-		LoadImpl();
+		mBackground = false;
+
+		try
+		{
+			PrepareImpl();
+			LoadImpl();
+		}
+		catch (...)
+		{
+			SetLoadState(Unloaded);
+			throw;
+		}
+
 		SetLoadState(Loaded);
+		mCreator->OnResourceLoaded(*this);
+	}
+	else if (GetLoadState() != Loaded)
+	{
+		// Still in background queue, finish it now
+		mCreator->CompleteBackgroundLoad(shared_from_this());
 	}
 }
 
 void Resource::LoadAsync()
 {
+	mCreator->LoadInBackground(shared_from_this());
+}
 
+void Resource::AddDependency( uint32_t type, const String& name, const String& group )
+{
+	mCreator->AddLoadDependency(*this, type, name, group);
 }
 
-Resource::LoadState Resource::GetLoadState()
+void Resource::AddFileDependency( const String& file )
 {
-	LoadState state;
-	
-	mMutex.lock();
-	state = mLoadState;
-	mMutex.unlock();
+	mCreator->AddFileDependency(*this, file);
+}
 
-	return state;
+void Resource::AddReloadDependency( const Resource& dependency )
+{
+	mCreator->AddReloadDependency(*this, dependency);
+}
+
+bool Resource::BeginLoading()
+{
+	LoadState expected = Unloaded;
+	return mLoadState.compare_exchange_strong(expected, Loading, std::memory_order_acq_rel);
 }
 
 void Resource::SetLoadState( LoadState state )
 {
-	mMutex.lock();
-	mLoadState = state;
-	mMutex.unlock();
+	mLoadState.store(state, std::memory_order_release);
 }
 
 shared_ptr<Resource> Resource::Clone()
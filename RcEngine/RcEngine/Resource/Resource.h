@@ -3,6 +3,7 @@
 
 #include <Core/Prerequisites.h>
 #include <mutex>
+#include <atomic>
 
 namespace RcEngine {
 
@@ -23,13 +24,20 @@ enum ResourceTypes
 	RT_GuiSkin
 };
 
-class _ApiExport Resource
+class _ApiExport Resource : public std::enable_shared_from_this<Resource>
 {
+	friend class ResourceManager;
+
 public:
+	/**
+	 * Background load goes Unloaded -> Loading -> Prepared -> Loaded, synchronous
+	 * load skips Prepared.
+	 */
 	enum LoadState
 	{
 		Unloaded,
 		Loading,
+		Prepared,
 		Loaded,
 		Unloading,
 	};
@@ -45,40 +53,99 @@ public:
 	ResourceHandle	GetResourceHandle() const			{ return mResourceHandle; }
 	uint32_t		GetSize() const						{ return mSize; }
 	uint32_t		GetResourceType() const				{ return mResourceType; }
-
+	uint32_t		GetLastUsedFrame() const			{ return mLastUsedFrame; }
+
+	/**
+	 * Load resource. With background, PrepareImpl runs on a ResourceManager loader
+	 * thread and LoadImpl runs later on main thread in ResourceManager::UpdateBackgroundLoading.
+	 * Synchronous load of a resource which is still in the background queue completes it
+	 * immediately.
+	 */
 	void Load(bool background = false);
+
+	/**
+	 * Release loaded data, next access through ResourceManager loads it again.
+	 */
 	void Unload();
+
+	/**
+	 * Load again from changed files in place, so handles to this resource stay valid. Does nothing
+	 * if resource isn't loaded. Main thread only, throws if loading fails.
+	 */
 	void Reload();
+
+	/**
+	 * Mark resource as used in current frame, least recently used resources are evicted first.
+	 */
 	void Touch();
 
 	void SetLoadState(LoadState state);
-	LoadState GetLoadState();
+	LoadState GetLoadState() const						{ return mLoadState.load(std::memory_order_acquire); }
 
-	bool IsLoaded() const								{ return mLoadState == Loaded; }
-	bool IsLoading() const								{ return mLoadState == Loading; }
+	bool IsLoaded() const								{ return GetLoadState() == Loaded; }
+	bool IsLoading() const								{ return GetLoadState() == Loading; }
 
 private:
 	void LoadSync();
 	void LoadAsync();
 
+	// Atomically move from Unloaded to Loading, return false if already loading or loaded
+	bool BeginLoading();
+
 protected:
 	
+	/**
+	 * Thread safe part of loading: read file and parse it into CPU memory. Called on a loader
+	 * thread for background load, so it must not touch render device. Default does nothing,
+	 * then all work is done in LoadImpl.
+	 */
+	virtual void PrepareImpl() {}
+
+	/**
+	 * Create GPU objects from prepared data, always called on main thread.
+	 */
 	virtual void LoadImpl() = 0;
 	virtual void UnloadImpl() = 0;
 
+	/**
+	 * Default unloads and loads again, and leaves resource unloaded if that fails. Resources
+	 * referenced through pointers into them override it to update in place, and keep their
+	 * content if loading fails.
+	 */
+	virtual void ReloadImpl();
+
+	/**
+	 * Declare a resource which must be loaded before LoadImpl of this one, only call in PrepareImpl.
+	 * For background load the dependency is queued in background too, otherwise it is loaded now.
+	 */
+	void AddDependency(uint32_t type, const String& name, const String& group);
+
+	/**
+	 * Reload this resource when file changes on disk, file is an OS path as from FileSystem::Locate.
+	 */
+	void AddFileDependency(const String& file);
+
+	/**
+	 * Reload this resource after dependency is reloaded. Dependencies added with AddDependency
+	 * are added too.
+	 */
+	void AddReloadDependency(const Resource& dependency);
 
 protected:
 	ResourceManager* mCreator;
 	String mResourceName;
 	String mGroup;
 	bool mBackground;
-	LoadState mLoadState;
+	// Read without lock by loader threads and main thread
+	std::atomic<LoadState> mLoadState;
+
+	// CPU and GPU memory in bytes, set by LoadImpl. Resources reporting 0 are never evicted.
 	uint32_t mSize;
 
+	uint32_t mLastUsedFrame;
+
 	ResourceHandle mResourceHandle;
 	ResourceTypes mResourceType;
-
-	std::mutex mMutex; 
 };
 
 }
@@ -1,17 +1,38 @@
 #include <Resource/ResourceManager.h>
 #include <IO/FileSystem.h>
+#include <IO/PathUtil.h>
 #include <Core/Exception.h>
+#include <Core/CpuInfo.h>
+#include <Core/Timer.h>
 
 namespace RcEngine {
 
+// Loading is mostly disk bound, more threads do not help much.
+static const uint32_t MaxLoaderThreads = 2;
+
 ResourceManager::ResourceManager()
-: mNextHandle(1)
+: mNextHandle(1),
+  mShutdownLoaders(false),
+  mBackgroundLoadBudget(0.005f),
+  mFrameNumber(0)
 {
 
 }
 
 ResourceManager::~ResourceManager()
 {
+	{
+		std::lock_guard<std::mutex> lock(mLoadMutex);
+		mShutdownLoaders = true;
+		mPrepareQueue.clear();
+		mLoaderTasks.clear();
+	}
+
+	mLoadCondition.notify_all();
+	for (std::thread& loaderThread : mLoaderThreads)
+		loaderThread.join();
+
+	mBackgroundLoads.clear();
 	mResourcesByHandle.clear();
 }
 
@@ -46,6 +67,8 @@ void ResourceManager::AddResourceGroup( const String& groupName )
 
 ResourceHandle ResourceManager::AddResource( uint32_t type, const String& name, const String& group )
 {
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
 	ResourceHandle retVal = 0;
 
 	unordered_map<String, ResourceGroup>::iterator groupIter;
@@ -74,6 +97,8 @@ ResourceHandle ResourceManager::AddResource( uint32_t type, const String& name,
 
 ResourceHandle ResourceManager::AddNonExitingResource( uint32_t type, const String& name, const String& group )
 {
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
 	ResourceHandle retVal;
 
 	auto factoryIter = mRegistry.find(type);
@@ -97,34 +122,42 @@ shared_ptr<Resource> ResourceManager::GetResourceByName( uint32_t type, const St
 {
 	shared_ptr<Resource> retVal = nullptr;
 
-	auto groupIter = mResourcesWithGroup.find(group);
-
-	if (groupIter == mResourcesWithGroup.end())
 	{
-		String err = "Resource Group: " + group + " doesn't exit";
-		ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND, err , "ResourceManager::GetResourceByName");
-	}
+		std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
 
+		auto groupIter = mResourcesWithGroup.find(group);
 
-	ResourceGroup& resourceGroup = groupIter->second;
+		if (groupIter == mResourcesWithGroup.end())
+		{
+			String err = "Resource Group: " + group + " doesn't exit";
+			ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND, err , "ResourceManager::GetResourceByName");
+		}
 
-	auto resIter = resourceGroup.Resources.find(name);
+		ResourceGroup& resourceGroup = groupIter->second;
 
-	if (resIter != resourceGroup.Resources.end())
-	{
-		if (resIter->second->GetResourceType() == type)
+		auto resIter = resourceGroup.Resources.find(name);
+
+		if (resIter != resourceGroup.Resources.end())
+		{
+			if (resIter->second->GetResourceType() == type)
+			{
+				retVal = resIter->second;
+			}
+		}
+		else
 		{
-			retVal = resIter->second;
+			ResourceHandle newResHandle = AddNonExitingResource(type, name, group);
+			retVal = mResourcesByHandle[newResHandle];
 		}
 	}
-	else
+
+	if (retVal)
 	{
-		ResourceHandle newResHandle = AddNonExitingResource(type, name, group);
-		retVal = GetResourceByHandle(newResHandle);
-	}
+		if (retVal->IsLoaded() == false)
+			retVal->Load();
 
-	if (retVal && retVal->IsLoaded() == false)
-		retVal->Load();
+		retVal->Touch();
+	}
 
 	return retVal;
 }
@@ -134,14 +167,23 @@ shared_ptr<Resource> ResourceManager::GetResourceByHandle( ResourceHandle handle
 {
 	shared_ptr<Resource> retVal = nullptr;
 
-	auto found = mResourcesByHandle.find(handle);
-	if (found != mResourcesByHandle.end())
 	{
-		retVal =  found->second;
+		std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+		auto found = mResourcesByHandle.find(handle);
+		if (found != mResourcesByHandle.end())
+		{
+			retVal =  found->second;
+		}
 	}
 
-	if (retVal && retVal->IsLoaded() == false)
-		retVal->Load();
+	if (retVal)
+	{
+		if (retVal->IsLoaded() == false)
+			retVal->Load();
+
+		retVal->Touch();
+	}
 
 	return retVal;
 }
@@ -149,25 +191,664 @@ shared_ptr<Resource> ResourceManager::GetResourceByHandle( ResourceHandle handle
 
 void ResourceManager::LoadAllFromDisk()
 {
-	for (auto iter = mResourcesByHandle.begin(); iter != mResourcesByHandle.end(); ++iter)
+	vector<shared_ptr<Resource> > resources;
+
 	{
-		iter->second->Load();
+		std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+		resources.reserve(mResourcesByHandle.size());
+		for (auto iter = mResourcesByHandle.begin(); iter != mResourcesByHandle.end(); ++iter)
+			resources.push_back(iter->second);
 	}
+
+	for (const shared_ptr<Resource>& resource : resources)
+		resource->Load();
 }
 
 void ResourceManager::ReleaseResource( ResourceHandle handle )
 {
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
 	auto it = mResourcesByHandle.find(handle);
 	if (it != mResourcesByHandle.end())
 	{
 		//mResourcesByHandle[handle] = NULL;
 		mResourcesByHandle.erase(it);
+		mResourceDependents.erase(handle);
 	}
 }
 
 void ResourceManager::UnLoadAll()
 {
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
 	mResourcesByHandle.clear();
 }
 
+shared_ptr<Resource> ResourceManager::FindOrAddResource( uint32_t type, const String& name, const String& group )
+{
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+	ResourceHandle handle = AddResource(type, name, group);
+
+	auto found = mResourcesByHandle.find(handle);
+	if (found == mResourcesByHandle.end())
+	{
+		String err = "Resource: " + name + " has been released";
+		ENGINE_EXCEPT(Exception::ERR_ITEM_NOT_FOUND, err , "ResourceManager::FindOrAddResource");
+	}
+
+	return found->second;
+}
+
+std::list<ResourceManager::BackgroundLoad>::iterator ResourceManager::FindBackgroundLoad( Resource* resource )
+{
+	for (auto iter = mBackgroundLoads.begin(); iter != mBackgroundLoads.end(); ++iter)
+	{
+		if (iter->Target.get() == resource)
+			return iter;
+	}
+
+	return mBackgroundLoads.end();
+}
+
+void ResourceManager::LoadInBackground( const shared_ptr<Resource>& resource, const LoadCallback& callback )
+{
+	std::unique_lock<std::mutex> lock(mLoadMutex);
+
+	if (resource->BeginLoading())
+	{
+		resource->mBackground = true;
+
+		BackgroundLoad load;
+		load.Target = resource;
+		if (callback)
+			load.Callbacks.push_back(callback);
+
+		mBackgroundLoads.push_back(load);
+		mPrepareQueue.push_back(resource);
+
+		StartLoaderThreads();
+		mLoadCondition.notify_all();
+	}
+	else if (resource->GetLoadState() == Resource::Loaded)
+	{
+		lock.unlock();
+
+		if (callback)
+			callback(resource);
+	}
+	else
+	{
+		auto loadIter = FindBackgroundLoad(resource.get());
+
+		// No entry means it is being loaded synchronously on main thread, it is Loaded before
+		// any resource depending on it is finalized.
+		if (loadIter != mBackgroundLoads.end() && callback)
+			loadIter->Callbacks.push_back(callback);
+	}
+}
+
+shared_ptr<Resource> ResourceManager::LoadInBackground( uint32_t type, const String& name, const String& group, const LoadCallback& callback )
+{
+	shared_ptr<Resource> resource = FindOrAddResource(type, name, group);
+	LoadInBackground(resource, callback);
+	return resource;
+}
+
+void ResourceManager::AddLoadDependency( Resource& resource, uint32_t type, const String& name, const String& group )
+{
+	shared_ptr<Resource> dependency = FindOrAddResource(type, name, group);
+	AddReloadDependency(resource, *dependency);
+
+	if (resource.mBackground)
+	{
+		LoadInBackground(dependency);
+
+		std::lock_guard<std::mutex> lock(mLoadMutex);
+
+		auto loadIter = FindBackgroundLoad(&resource);
+		if (loadIter != mBackgroundLoads.end())
+			loadIter->Dependencies.push_back(dependency);
+	}
+	else
+	{
+		dependency->Load();
+	}
+}
+
+bool ResourceManager::IsReadyToFinalize( const BackgroundLoad& load ) const
+{
+	if (load.Target->GetLoadState() != Resource::Prepared)
+		return false;
+
+	// Failed load is finalized without waiting for dependencies
+	if (load.Error)
+		return true;
+
+	for (const shared_ptr<Resource>& dependency : load.Dependencies)
+	{
+		Resource::LoadState state = dependency->GetLoadState();
+
+		// Dependency queued in background goes back to Unloaded only if it failed, then fail this one too
+		if (state != Resource::Loaded && state != Resource::Unloaded)
+			return false;
+	}
+
+	return true;
+}
+
+std::exception_ptr ResourceManager::FinalizeBackgroundLoad( std::list<BackgroundLoad>::iterator loadIter, std::unique_lock<std::mutex>& lock )
+{
+	BackgroundLoad load = *loadIter;
+	mBackgroundLoads.erase(loadIter);
+
+	// LoadImpl and callbacks may queue new loads
+	lock.unlock();
+
+	std::exception_ptr error = load.Error;
+
+	if (!error)
+	{
+		for (const shared_ptr<Resource>& dependency : load.Dependencies)
+		{
+			if (dependency->GetLoadState() != Resource::Loaded)
+			{
+				String err = "Dependency " + dependency->GetResourceName() + " of " + load.Target->GetResourceName() + " failed to load";
+				error = std::make_exception_ptr(Exception(Exception::ERR_INVALID_STATE, err, "ResourceManager::FinalizeBackgroundLoad"));
+				break;
+			}
+		}
+	}
+
+	if (!error)
+	{
+		try
+		{
+			load.Target->LoadImpl();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+	}
+
+	if (error)
+	{
+		load.Target->SetLoadState(Resource::Unloaded);
+	}
+	else
+	{
+		load.Target->SetLoadState(Resource::Loaded);
+		OnResourceLoaded(*load.Target);
+	}
+
+	for (const LoadCallback& callback : load.Callbacks)
+		callback(load.Target);
+
+	lock.lock();
+	return error;
+}
+
+void ResourceManager::ReportLoadError( const Resource& resource, const std::exception_ptr& error )
+{
+	try
+	{
+		std::rethrow_exception(error);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Load " << resource.GetResourceName() << " failed: " << e.what() << std::endl;
+	}
+	catch (...)
+	{
+		std::cerr << "Load " << resource.GetResourceName() << " failed" << std::endl;
+	}
+}
+
+void ResourceManager::UpdateBackgroundLoading()
+{
+	uint64_t startTime = SystemClock::Now();
+
+	std::unique_lock<std::mutex> lock(mLoadMutex);
+
+	auto loadIter = mBackgroundLoads.begin();
+	while (loadIter != mBackgroundLoads.end())
+	{
+		if (!IsReadyToFinalize(*loadIter))
+		{
+			++loadIter;
+			continue;
+		}
+
+		shared_ptr<Resource> resource = loadIter->Target;
+		if (std::exception_ptr error = FinalizeBackgroundLoad(loadIter, lock))
+			ReportLoadError(*resource, error);
+
+		if (SystemClock::ToSeconds(SystemClock::Now() - startTime) >= mBackgroundLoadBudget)
+			break;
+
+		// Finalized resource may unblock earlier queued ones
+		loadIter = mBackgroundLoads.begin();
+	}
+}
+
+void ResourceManager::WaitForBackgroundLoading()
+{
+	std::unique_lock<std::mutex> lock(mLoadMutex);
+
+	while (!mBackgroundLoads.empty())
+	{
+		auto loadIter = mBackgroundLoads.begin();
+		while (loadIter != mBackgroundLoads.end() && !IsReadyToFinalize(*loadIter))
+			++loadIter;
+
+		if (loadIter != mBackgroundLoads.end())
+		{
+			shared_ptr<Resource> resource = loadIter->Target;
+			if (std::exception_ptr error = FinalizeBackgroundLoad(loadIter, lock))
+				ReportLoadError(*resource, error);
+		}
+		else
+			mLoadCondition.wait(lock);
+	}
+}
+
+void ResourceManager::CompleteBackgroundLoad( const shared_ptr<Resource>& resource )
+{
+	std::unique_lock<std::mutex> lock(mLoadMutex);
+
+	// No entry means it is being loaded synchronously further up the call stack
+	if (FindBackgroundLoad(resource.get()) == mBackgroundLoads.end())
+		return;
+
+	auto queuedIter = std::find(mPrepareQueue.begin(), mPrepareQueue.end(), resource);
+	if (queuedIter != mPrepareQueue.end())
+	{
+		// Not picked by a loader thread yet, prepare it here instead of waiting
+		mPrepareQueue.erase(queuedIter);
+		lock.unlock();
+
+		std::exception_ptr error;
+		try 
+		{
+			resource->PrepareImpl();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		lock.lock();
+		FindBackgroundLoad(resource.get())->Error = error;
+		resource->SetLoadState(Resource::Prepared);
+	}
+	else
+	{
+		while (resource->GetLoadState() != Resource::Prepared)
+			mLoadCondition.wait(lock);
+	}
+
+	auto loadIter = FindBackgroundLoad(resource.get());
+	if (!IsReadyToFinalize(*loadIter))
+	{
+		vector<shared_ptr<Resource> > dependencies = loadIter->Dependencies;
+		lock.unlock();
+
+		for (const shared_ptr<Resource>& dependency : dependencies)
+			dependency->Load();
+
+		lock.lock();
+		loadIter = FindBackgroundLoad(resource.get());
+	}
+
+	// Caller asked for this resource, it gets the error
+	if (std::exception_ptr error = FinalizeBackgroundLoad(loadIter, lock))
+	{
+		lock.unlock();
+		std::rethrow_exception(error);
+	}
+}
+
+uint32_t ResourceManager::GetNumBackgroundLoads() const
+{
+	std::lock_guard<std::mutex> lock(mLoadMutex);
+	return mBackgroundLoads.size();
+}
+
+void ResourceManager::RunOnLoaderThread( const std::function<void()>& task )
+{
+	{
+		std::lock_guard<std::mutex> lock(mLoadMutex);
+		mLoaderTasks.push_back(task);
+		StartLoaderThreads();
+	}
+
+	mLoadCondition.notify_all();
+}
+
+void ResourceManager::StartLoaderThreads()
+{
+	if (mLoaderThreads.size())
+		return;
+
+	uint32_t numHardwareThreads = CpuInfo::GetNumHardwareThreads();
+	uint32_t numThreads = (std::min)(MaxLoaderThreads, numHardwareThreads > 1 ? numHardwareThreads - 1 : 1);
+
+	for (uint32_t i = 0; i < numThreads; ++i)
+		mLoaderThreads.push_back( std::thread(&ResourceManager::LoaderThreadFunc, this) );
+}
+
+void ResourceManager::LoaderThreadFunc()
+{
+	for (;;)
+	{
+		shared_ptr<Resource> resource;
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(mLoadMutex);
+
+			while (!mShutdownLoaders && mPrepareQueue.empty() && mLoaderTasks.empty())
+				mLoadCondition.wait(lock);
+
+			if (mShutdownLoaders)
+				return;
+
+			// Main thread may be blocked on a prepare, tasks go after them
+			if (mPrepareQueue.size())
+			{
+				resource = mPrepareQueue.front();
+				mPrepareQueue.pop_front();
+			}
+			else
+			{
+				task = std::move(mLoaderTasks.front());
+				mLoaderTasks.pop_front();
+			}
+		}
+
+		if (task)
+		{
+			task();
+			continue;
+		}
+
+		std::exception_ptr error;
+		try 
+		{
+			resource->PrepareImpl();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mLoadMutex);
+
+			auto loadIter = FindBackgroundLoad(resource.get());
+			if (loadIter != mBackgroundLoads.end())
+				loadIter->Error = error;
+
+			resource->SetLoadState(Resource::Prepared);
+		}
+
+		mLoadCondition.notify_all();
+	}
+}
+
+void ResourceManager::Update()
+{
+	++mFrameNumber;
+
+	UpdateBackgroundLoading();
+
+	FileSystem* fileSystem = FileSystem::GetSingletonPtr();
+	if (fileSystem && fileSystem->IsWatchingChanges())
+	{
+		mChangedFiles.clear();
+		fileSystem->GetChangedFiles(mChangedFiles);
+
+		if (mChangedFiles.size())
+			ReloadChangedFiles(mChangedFiles);
+	}
+
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+	for (auto& kv : mResourcesWithGroup)
+	{
+		ResourceGroup& group = kv.second;
+		if (group.MemoryBudget > 0 && group.MemoryUse > group.MemoryBudget)
+			EvictResources(group);
+	}
+}
+
+void ResourceManager::EvictResources( ResourceGroup& group )
+{
+	// Tables by name and by handle both hold a reference, more means it is used outside
+	static const long NumInternalReferences = 2;
+
+	mEvictCandidates.clear();
+	for (auto& kv : group.Resources)
+	{
+		const shared_ptr<Resource>& resource = kv.second;
+
+		if (resource->IsLoaded() && resource->GetSize() > 0 && resource.use_count() <= NumInternalReferences &&
+			resource->GetLastUsedFrame() != mFrameNumber)
+		{
+			mEvictCandidates.push_back(resource.get());
+		}
+	}
+
+	std::sort(mEvictCandidates.begin(), mEvictCandidates.end(), [](Resource* lhs, Resource* rhs) {
+		return lhs->GetLastUsedFrame() < rhs->GetLastUsedFrame(); });
+
+	for (Resource* resource : mEvictCandidates)
+	{
+		if (group.MemoryUse <= group.MemoryBudget)
+			break;
+
+		resource->Unload();
+	}
+
+	mEvictCandidates.clear();
+}
+
+void ResourceManager::OnResourceLoaded( Resource& resource )
+{
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+	auto groupIter = mResourcesWithGroup.find(resource.GetResourceGroup());
+	if (groupIter != mResourcesWithGroup.end())
+		groupIter->second.MemoryUse += resource.GetSize();
+
+	resource.Touch();
+}
+
+void ResourceManager::OnResourceUnloaded( Resource& resource )
+{
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+	auto groupIter = mResourcesWithGroup.find(resource.GetResourceGroup());
+	if (groupIter != mResourcesWithGroup.end())
+	{
+		ResourceGroup& group = groupIter->second;
+		group.MemoryUse -= (std::min)(group.MemoryUse, uint64_t(resource.GetSize()));
+	}
+}
+
+void ResourceManager::SetMemoryBudget( const String& group, uint64_t budget )
+{
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+	mResourcesWithGroup[group].MemoryBudget = budget;
+}
+
+uint64_t ResourceManager::GetMemoryBudget( const String& group ) const
+{
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+	auto groupIter = mResourcesWithGroup.find(group);
+	return (groupIter != mResourcesWithGroup.end()) ? groupIter->second.MemoryBudget : 0;
+}
+
+uint64_t ResourceManager::GetMemoryUse( const String& group ) const
+{
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+	auto groupIter = mResourcesWithGroup.find(group);
+	return (groupIter != mResourcesWithGroup.end()) ? groupIter->second.MemoryUse : 0;
+}
+
+void ResourceManager::OnResourceReloaded( Resource& resource, uint32_t oldSize )
+{
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+	auto groupIter = mResourcesWithGroup.find(resource.GetResourceGroup());
+	if (groupIter != mResourcesWithGroup.end())
+	{
+		ResourceGroup& group = groupIter->second;
+		group.MemoryUse -= (std::min)(group.MemoryUse, uint64_t(oldSize));
+		group.MemoryUse += resource.GetSize();
+	}
+
+	resource.Touch();
+}
+
+void ResourceManager::AddFileDependency( Resource& resource, const String& file )
+{
+	if (file.empty())
+		return;
+
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+	vector<ResourceHandle>& dependents = mFileDependents[PathUtil::GetNormalizedPath(file)];
+	if (std::find(dependents.begin(), dependents.end(), resource.GetResourceHandle()) == dependents.end())
+		dependents.push_back(resource.GetResourceHandle());
+}
+
+void ResourceManager::AddReloadDependency( Resource& resource, const Resource& dependency )
+{
+	if (&resource == &dependency)
+		return;
+
+	std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+	vector<ResourceHandle>& dependents = mResourceDependents[dependency.GetResourceHandle()];
+	if (std::find(dependents.begin(), dependents.end(), resource.GetResourceHandle()) == dependents.end())
+		dependents.push_back(resource.GetResourceHandle());
+}
+
+void ResourceManager::ReloadChangedFiles( const vector<String>& files )
+{
+	// Resources to reload, each after the ones it depends on
+	vector<shared_ptr<Resource> > reloads;
+	unordered_map<ResourceHandle, vector<ResourceHandle> > dependents;
+
+	{
+		std::lock_guard<std::recursive_mutex> lock(mResourceMutex);
+
+		vector<ResourceHandle> affected;
+		unordered_set<ResourceHandle> affectedSet;
+
+		for (const String& file : files)
+		{
+			auto fileIter = mFileDependents.find(PathUtil::GetNormalizedPath(file));
+			if (fileIter == mFileDependents.end())
+				continue;
+
+			for (ResourceHandle handle : fileIter->second)
+			{
+				if (affectedSet.insert(handle).second)
+					affected.push_back(handle);
+			}
+		}
+
+		// Resources depending on a reloaded one may point into it, reload them too
+		for (size_t i = 0; i < affected.size(); ++i)
+		{
+			auto dependentIter = mResourceDependents.find(affected[i]);
+			if (dependentIter == mResourceDependents.end())
+				continue;
+
+			for (ResourceHandle handle : dependentIter->second)
+			{
+				if (affectedSet.insert(handle).second)
+					affected.push_back(handle);
+			}
+
+			dependents[affected[i]] = dependentIter->second;
+		}
+
+		// Topological order, all dependents of an affected resource are affected
+		unordered_map<ResourceHandle, uint32_t> numDependencies;
+		for (auto& kv : dependents)
+		{
+			for (ResourceHandle handle : kv.second)
+				numDependencies[handle]++;
+		}
+
+		vector<ResourceHandle> order;
+		for (ResourceHandle handle : affected)
+		{
+			if (numDependencies[handle] == 0)
+				order.push_back(handle);
+		}
+
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			auto dependentIter = dependents.find(order[i]);
+			if (dependentIter == dependents.end())
+				continue;
+
+			for (ResourceHandle handle : dependentIter->second)
+			{
+				if (--numDependencies[handle] == 0)
+					order.push_back(handle);
+			}
+		}
+
+		// Resources on a cycle go last, in the order they were found
+		for (ResourceHandle handle : affected)
+		{
+			if (numDependencies[handle] > 0)
+				order.push_back(handle);
+		}
+
+		for (ResourceHandle handle : order)
+		{
+			auto resIter = mResourcesByHandle.find(handle);
+			if (resIter != mResourcesByHandle.end())
+				reloads.push_back(resIter->second);
+		}
+	}
+
+	// Resources which failed, or depend on one which failed
+	unordered_set<ResourceHandle> failed;
+
+	for (const shared_ptr<Resource>& resource : reloads)
+	{
+		ResourceHandle handle = resource->GetResourceHandle();
+
+		if (failed.find(handle) == failed.end() && resource->IsLoaded())
+		{
+			try
+			{
+				resource->Reload();
+				std::cout << "Reloaded " << resource->GetResourceName() << std::endl;
+			}
+			catch (std::exception& e)
+			{
+				std::cerr << "Reload " << resource->GetResourceName() << " failed: " << e.what() << std::endl;
+				failed.insert(handle);
+			}
+		}
+
+		if (failed.find(handle) != failed.end())
+		{
+			auto dependentIter = dependents.find(handle);
+			if (dependentIter != dependents.end())
+				failed.insert(dependentIter->second.begin(), dependentIter->second.end());
+		}
+	}
+}
+
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include <Core/Prerequisites.h>
 #include <Core/Singleton.h>
 #include <Resource/Resource.h>
+#include <thread>
+#include <deque>
+#include <condition_variable>
 
 namespace RcEngine {
 
@@ -16,6 +19,9 @@ public:
 	typedef void (*ResTypeReleaseFunc)();
 	typedef shared_ptr<Resource> (*ResTypeFactoryFunc)( ResourceManager*, ResourceHandle, const String&, const String&);
 
+	// Called on main thread after a background load is finished
+	typedef std::function<void (const shared_ptr<Resource>&)> LoadCallback;
+
 	struct ResourceRegEntry
 	{
 		String					   TypeString;
@@ -27,9 +33,11 @@ public:
 	{
 		ResourceGroup() : MemoryBudget(0), MemoryUse(0) {}
 
-		unsigned MemoryBudget;
+		// Bytes of loaded resources allowed, 0 means unlimited
+		uint64_t MemoryBudget;
 
-		unsigned MemoryUse;
+		// Sum of Resource::GetSize of loaded resources
+		uint64_t MemoryUse;
 		unordered_map<String, shared_ptr<Resource> > Resources;
 	};
 
@@ -54,16 +62,143 @@ public:
 	void ReleaseResource(ResourceHandle handle);
 	void UnLoadAll();
 
+	/**
+	 * Advance frame number, finalize background loads and evict least recently used
+	 * resources from groups over budget. Called once per frame by Application.
+	 */
+	void Update();
+
+	uint32_t GetFrameNumber() const						{ return mFrameNumber; }
+
+	/**
+	 * When a group uses more than budget bytes, loaded resources referenced only by ResourceManager
+	 * are unloaded in least recently used order. They are loaded again on next access.
+	 */
+	void SetMemoryBudget(const String& group, uint64_t budget);
+	uint64_t GetMemoryBudget(const String& group) const;
+	uint64_t GetMemoryUse(const String& group) const;
+
+	/**
+	 * Queue resource to load in background. Callback is called on main thread when the resource
+	 * and all its dependencies are loaded, immediately if it is already loaded. It is called
+	 * too if loading failed, the resource is left Unloaded then.
+	 */
+	void LoadInBackground(const shared_ptr<Resource>& resource, const LoadCallback& callback = LoadCallback());
+
+	/**
+	 * Find or create resource by name and queue it to load in background, return without waiting.
+	 */
+	shared_ptr<Resource> LoadInBackground(uint32_t type, const String& name, const String& group, const LoadCallback& callback = LoadCallback());
+
+	/**
+	 * Finalize prepared background loads (create GPU objects) on main thread until the time budget
+	 * is used up, at least one resource is finalized each call. Called by Update. Failed loads
+	 * are reported, not thrown.
+	 */
+	void UpdateBackgroundLoading();
+
+	/**
+	 * Block until all queued background loads are finished.
+	 */
+	void WaitForBackgroundLoading();
+
+	/**
+	 * Number of resources queued in background and not loaded yet.
+	 */
+	uint32_t GetNumBackgroundLoads() const;
+
+	/**
+	 * Main thread time in seconds spent each frame finalizing background loads.
+	 */
+	void SetBackgroundLoadBudget(float seconds)			{ mBackgroundLoadBudget = seconds; }
+	float GetBackgroundLoadBudget() const				{ return mBackgroundLoadBudget; }
+
+	/**
+	 * Reload loaded resources built from any of files, and resources depending on those, each
+	 * after the resources it depends on. A failed reload is reported and the resources depending
+	 * on it are skipped. Called by Update with files FileSystem reports changed when it watches
+	 * them. Files are OS paths.
+	 */
+	void ReloadChangedFiles(const vector<String>& files);
+
+public_internal:
+	void OnResourceLoaded(Resource& resource);
+	void OnResourceUnloaded(Resource& resource);
+	void OnResourceReloaded(Resource& resource, uint32_t oldSize);
+
+	void AddLoadDependency(Resource& resource, uint32_t type, const String& name, const String& group);
+	void AddFileDependency(Resource& resource, const String& file);
+	void AddReloadDependency(Resource& resource, const Resource& dependency);
+	void CompleteBackgroundLoad(const shared_ptr<Resource>& resource);
+
+	/**
+	 * Run a blocking file read that is not a resource load on a loader thread, after queued
+	 * prepares. Task must not throw, tasks still queued are dropped when manager is destroyed.
+	 */
+	void RunOnLoaderThread(const std::function<void()>& task);
+
 protected:
 	ResourceHandle AddNonExitingResource(uint32_t type, const String& name, const String& group);
 	ResourceHandle GetNextHandle();  
 
+	// Find or create resource without loading it
+	shared_ptr<Resource> FindOrAddResource(uint32_t type, const String& name, const String& group);
+
+	struct BackgroundLoad
+	{
+		shared_ptr<Resource> Target;
+		vector<shared_ptr<Resource> > Dependencies;
+		vector<LoadCallback> Callbacks;
+
+		// Exception thrown by PrepareImpl, passed to main thread
+		std::exception_ptr Error;
+	};
+
+	std::list<BackgroundLoad>::iterator FindBackgroundLoad(Resource* resource);
+
+	bool IsReadyToFinalize(const BackgroundLoad& load) const;
+
+	// Return error of a failed load, resource is left Unloaded and callbacks are called anyway
+	std::exception_ptr FinalizeBackgroundLoad(std::list<BackgroundLoad>::iterator loadIter, std::unique_lock<std::mutex>& lock);
+	void ReportLoadError(const Resource& resource, const std::exception_ptr& error);
+
+	void StartLoaderThreads();
+	void LoaderThreadFunc();
+
+	void EvictResources(ResourceGroup& group);
+
 protected:	
 	uint32_t mNextHandle;
 	std::map<int, ResourceRegEntry>  mRegistry;  // Registry of resource type
 	std::map<ResourceHandle, shared_ptr<Resource> > mResourcesByHandle;
 	unordered_map<String, ResourceGroup> mResourcesWithGroup;
+
+	// Guard resource tables, loader threads add dependencies while main thread looks up resources
+	mutable std::recursive_mutex mResourceMutex;
+
+	// Queued background loads in request order, and resources waiting for a loader thread
+	std::list<BackgroundLoad> mBackgroundLoads;
+	std::deque<shared_ptr<Resource> > mPrepareQueue;
+	std::deque<std::function<void()> > mLoaderTasks;
+
+	mutable std::mutex mLoadMutex;
+	std::condition_variable mLoadCondition;
 	
+	vector<std::thread> mLoaderThreads;
+	bool mShutdownLoaders;
+
+	float mBackgroundLoadBudget;
+
+	uint32_t mFrameNumber;
+
+	// Eviction scratch, avoid per frame allocation
+	vector<Resource*> mEvictCandidates;
+
+	// Reload graph, resources to reload when a normalized file path or a resource changes
+	unordered_map<String, vector<ResourceHandle> > mFileDependents;
+	unordered_map<ResourceHandle, vector<ResourceHandle> > mResourceDependents;
+
+	vector<String> mChangedFiles;
 };
 
 template<typename ResType>
@@ -0,0 +1,471 @@
+#include <Scene/DynamicAabbTree.h>
+#include <Scene/SceneObject.h>
+
+namespace RcEngine {
+
+namespace {
+
+inline BoundingBoxf CombineBox(const BoundingBoxf& a, const BoundingBoxf& b)
+{
+	return BoundingBoxf( float3((std::min)(a.Min.X(), b.Min.X()), (std::min)(a.Min.Y(), b.Min.Y()), (std::min)(a.Min.Z(), b.Min.Z())),
+		                 float3((std::max)(a.Max.X(), b.Max.X()), (std::max)(a.Max.Y(), b.Max.Y()), (std::max)(a.Max.Z(), b.Max.Z())) );
+}
+
+inline float SurfaceArea(const BoundingBoxf& box)
+{
+	float3 d = box.Max - box.Min;
+	return 2.0f * (d.X() * d.Y() + d.Y() * d.Z() + d.Z() * d.X());
+}
+
+}
+
+DynamicAabbTree::DynamicAabbTree( float fatMargin )
+	: mRoot(NullNode),
+	  mFreeList(NullNode),
+	  mNumProxies(0),
+	  mFatMargin(fatMargin)
+{
+
+}
+
+DynamicAabbTree::~DynamicAabbTree()
+{
+
+}
+
+void DynamicAabbTree::Clear()
+{
+	mNodes.clear();
+	mMovedProxies.clear();
+	mRoot = NullNode;
+	mFreeList = NullNode;
+	mNumProxies = 0;
+}
+
+int32_t DynamicAabbTree::AllocateNode()
+{
+	int32_t node;
+	if (mFreeList != NullNode)
+	{
+		node = mFreeList;
+		mFreeList = mNodes[node].Parent;
+	}
+	else
+	{
+		node = int32_t(mNodes.size());
+		mNodes.push_back(TreeNode());
+	}
+
+	mNodes[node].Object = nullptr;
+	mNodes[node].Parent = NullNode;
+	mNodes[node].Child1 = NullNode;
+	mNodes[node].Child2 = NullNode;
+	mNodes[node].Height = 0;
+	mNodes[node].Moved = false;
+	return node;
+}
+
+void DynamicAabbTree::FreeNode( int32_t node )
+{
+	mNodes[node].Parent = mFreeList;
+	mNodes[node].Height = -1;
+	mNodes[node].Object = nullptr;
+	mFreeList = node;
+}
+
+int32_t DynamicAabbTree::CreateProxy( const BoundingBoxf& box, SceneObject* object )
+{
+	int32_t proxy = AllocateNode();
+
+	const float3 margin(mFatMargin, mFatMargin, mFatMargin);
+	mNodes[proxy].Box = BoundingBoxf(box.Min - margin, box.Max + margin);
+	mNodes[proxy].Object = object;
+
+	InsertLeaf(proxy);
+	++mNumProxies;
+
+	return proxy;
+}
+
+void DynamicAabbTree::DestroyProxy( int32_t proxy )
+{
+	assert(mNodes[proxy].IsLeaf());
+
+	if (mNodes[proxy].Moved)
+	{
+		auto found = std::find(mMovedProxies.begin(), mMovedProxies.end(), proxy);
+		if (found != mMovedProxies.end())
+			mMovedProxies.erase(found);
+	}
+
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	--mNumProxies;
+}
+
+bool DynamicAabbTree::MoveProxy( int32_t proxy, const BoundingBoxf& box )
+{
+	assert(mNodes[proxy].IsLeaf());
+
+	if (mNodes[proxy].Box.Contains(box) == CT_Contains)
+		return false;
+
+	RemoveLeaf(proxy);
+
+	const float3 margin(mFatMargin, mFatMargin, mFatMargin);
+	mNodes[proxy].Box = BoundingBoxf(box.Min - margin, box.Max + margin);
+
+	InsertLeaf(proxy);
+	return true;
+}
+
+void DynamicAabbTree::MarkMoved( int32_t proxy )
+{
+	if (!mNodes[proxy].Moved)
+	{
+		mNodes[proxy].Moved = true;
+		mMovedProxies.push_back(proxy);
+	}
+}
+
+void DynamicAabbTree::Refit()
+{
+	for (int32_t proxy : mMovedProxies)
+	{
+		mNodes[proxy].Moved = false;
+
+		const BoundingBoxf& box = mNodes[proxy].Object->GetWorldBoundingBox();
+		if (box.IsValid())
+			MoveProxy(proxy, box);
+	}
+
+	mMovedProxies.clear();
+}
+
+int32_t DynamicAabbTree::GetHeight() const
+{
+	return (mRoot == NullNode) ? 0 : mNodes[mRoot].Height;
+}
+
+void DynamicAabbTree::InsertLeaf( int32_t leaf )
+{
+	if (mRoot == NullNode)
+	{
+		mRoot = leaf;
+		mNodes[mRoot].Parent = NullNode;
+		return;
+	}
+
+	// Find the best sibling with surface area heuristic
+	const BoundingBoxf leafBox = mNodes[leaf].Box;
+	int32_t index = mRoot;
+	while (!mNodes[index].IsLeaf())
+	{
+		int32_t child1 = mNodes[index].Child1;
+		int32_t child2 = mNodes[index].Child2;
+
+		float area = SurfaceArea(mNodes[index].Box);
+		float combinedArea = SurfaceArea(CombineBox(mNodes[index].Box, leafBox));
+
+		// Cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float cost1 = SurfaceArea(CombineBox(leafBox, mNodes[child1].Box)) + inheritanceCost;
+		if (!mNodes[child1].IsLeaf())
+			cost1 -= SurfaceArea(mNodes[child1].Box);
+
+		float cost2 = SurfaceArea(CombineBox(leafBox, mNodes[child2].Box)) + inheritanceCost;
+		if (!mNodes[child2].IsLeaf())
+			cost2 -= SurfaceArea(mNodes[child2].Box);
+
+		if (cost < cost1 && cost < cost2)
+			break;
+
+		index = (cost1 < cost2) ? child1 : child2;
+	}
+
+	int32_t sibling = index;
+
+	// Create a new parent
+	int32_t oldParent = mNodes[sibling].Parent;
+	int32_t newParent = AllocateNode();
+	mNodes[newParent].Parent = oldParent;
+	mNodes[newParent].Box = CombineBox(leafBox, mNodes[sibling].Box);
+	mNodes[newParent].Height = mNodes[sibling].Height + 1;
+	mNodes[newParent].Child1 = sibling;
+	mNodes[newParent].Child2 = leaf;
+	mNodes[sibling].Parent = newParent;
+	mNodes[leaf].Parent = newParent;
+
+	if (oldParent != NullNode)
+	{
+		if (mNodes[oldParent].Child1 == sibling)
+			mNodes[oldParent].Child1 = newParent;
+		else
+			mNodes[oldParent].Child2 = newParent;
+	}
+	else
+	{
+		mRoot = newParent;
+	}
+
+	// Walk back up the tree fixing heights and boxes
+	index = mNodes[leaf].Parent;
+	while (index != NullNode)
+	{
+		index = Balance(index);
+
+		int32_t child1 = mNodes[index].Child1;
+		int32_t child2 = mNodes[index].Child2;
+
+		mNodes[index].Height = 1 + (std::max)(mNodes[child1].Height, mNodes[child2].Height);
+		mNodes[index].Box = CombineBox(mNodes[child1].Box, mNodes[child2].Box);
+
+		index = mNodes[index].Parent;
+	}
+}
+
+void DynamicAabbTree::RemoveLeaf( int32_t leaf )
+{
+	if (leaf == mRoot)
+	{
+		mRoot = NullNode;
+		return;
+	}
+
+	int32_t parent = mNodes[leaf].Parent;
+	int32_t grandParent = mNodes[parent].Parent;
+	int32_t sibling = (mNodes[parent].Child1 == leaf) ? mNodes[parent].Child2 : mNodes[parent].Child1;
+
+	if (grandParent != NullNode)
+	{
+		// Destroy parent and connect sibling to grand parent
+		if (mNodes[grandParent].Child1 == parent)
+			mNodes[grandParent].Child1 = sibling;
+		else
+			mNodes[grandParent].Child2 = sibling;
+
+		mNodes[sibling].Parent = grandParent;
+		FreeNode(parent);
+
+		int32_t index = grandParent;
+		while (index != NullNode)
+		{
+			index = Balance(index);
+
+			int32_t child1 = mNodes[index].Child1;
+			int32_t child2 = mNodes[index].Child2;
+
+			mNodes[index].Box = CombineBox(mNodes[child1].Box, mNodes[child2].Box);
+			mNodes[index].Height = 1 + (std::max)(mNodes[child1].Height, mNodes[child2].Height);
+
+			index = mNodes[index].Parent;
+		}
+	}
+	else
+	{
+		mRoot = sibling;
+		mNodes[sibling].Parent = NullNode;
+		FreeNode(parent);
+	}
+}
+
+int32_t DynamicAabbTree::Balance( int32_t iA )
+{
+	TreeNode& A = mNodes[iA];
+	if (A.IsLeaf() || A.Height < 2)
+		return iA;
+
+	int32_t iB = A.Child1;
+	int32_t iC = A.Child2;
+	TreeNode& B = mNodes[iB];
+	TreeNode& C = mNodes[iC];
+
+	int32_t balance = C.Height - B.Height;
+
+	// Rotate C up
+	if (balance > 1)
+	{
+		int32_t iF = C.Child1;
+		int32_t iG = C.Child2;
+		TreeNode& F = mNodes[iF];
+		TreeNode& G = mNodes[iG];
+
+		// Swap A and C
+		C.Child1 = iA;
+		C.Parent = A.Parent;
+		A.Parent = iC;
+
+		// A's old parent should point to C
+		if (C.Parent != NullNode)
+		{
+			if (mNodes[C.Parent].Child1 == iA)
+				mNodes[C.Parent].Child1 = iC;
+			else
+				mNodes[C.Parent].Child2 = iC;
+		}
+		else
+		{
+			mRoot = iC;
+		}
+
+		if (F.Height > G.Height)
+		{
+			C.Child2 = iF;
+			A.Child2 = iG;
+			G.Parent = iA;
+			A.Box = CombineBox(B.Box, G.Box);
+			C.Box = CombineBox(A.Box, F.Box);
+
+			A.Height = 1 + (std::max)(B.Height, G.Height);
+			C.Height = 1 + (std::max)(A.Height, F.Height);
+		}
+		else
+		{
+			C.Child2 = iG;
+			A.Child2 = iF;
+			F.Parent = iA;
+			A.Box = CombineBox(B.Box, F.Box);
+			C.Box = CombineBox(A.Box, G.Box);
+
+			A.Height = 1 + (std::max)(B.Height, F.Height);
+			C.Height = 1 + (std::max)(A.Height, G.Height);
+		}
+
+		return iC;
+	}
+
+	// Rotate B up
+	if (balance < -1)
+	{
+		int32_t iD = B.Child1;
+		int32_t iE = B.Child2;
+		TreeNode& D = mNodes[iD];
+		TreeNode& E = mNodes[iE];
+
+		// Swap A and B
+		B.Child1 = iA;
+		B.Parent = A.Parent;
+		A.Parent = iB;
+
+		// A's old parent should point to B
+		if (B.Parent != NullNode)
+		{
+			if (mNodes[B.Parent].Child1 == iA)
+				mNodes[B.Parent].Child1 = iB;
+			else
+				mNodes[B.Parent].Child2 = iB;
+		}
+		else
+		{
+			mRoot = iB;
+		}
+
+		if (D.Height > E.Height)
+		{
+			B.Child2 = iD;
+			A.Child1 = iE;
+			E.Parent = iA;
+			A.Box = CombineBox(C.Box, E.Box);
+			B.Box = CombineBox(A.Box, D.Box);
+
+			A.Height = 1 + (std::max)(C.Height, E.Height);
+			B.Height = 1 + (std::max)(A.Height, D.Height);
+		}
+		else
+		{
+			B.Child2 = iE;
+			A.Child1 = iD;
+			D.Parent = iA;
+			A.Box = CombineBox(C.Box, D.Box);
+			B.Box = CombineBox(A.Box, E.Box);
+
+			A.Height = 1 + (std::max)(C.Height, D.Height);
+			B.Height = 1 + (std::max)(A.Height, E.Height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+void DynamicAabbTree::Query( const Frustumf& frustum, std::vector<SceneObject*>& objects ) const
+{
+	if (mRoot == NullNode)
+		return;
+
+	// Second element is true if node is known to be fully inside frustum
+	mQueryStack.clear();
+	mQueryStack.push_back( std::make_pair(mRoot, false) );
+	mQueryLeaves.clear();
+
+	while (!mQueryStack.empty())
+	{
+		int32_t index = mQueryStack.back().first;
+		bool inside = mQueryStack.back().second;
+		mQueryStack.pop_back();
+
+		const TreeNode& node = mNodes[index];
+
+		if (node.IsLeaf())
+		{
+			if (inside)
+				objects.push_back(node.Object);
+			else
+				mQueryLeaves.push_back(index);
+
+			continue;
+		}
+
+		if (!inside)
+		{
+			ContainmentType result = frustum.Contain(node.Box);
+			if (result == CT_Disjoint)
+				continue;
+
+			inside = (result == CT_Contains);
+		}
+
+		mQueryStack.push_back( std::make_pair(node.Child1, inside) );
+		mQueryStack.push_back( std::make_pair(node.Child2, inside) );
+	}
+
+	const uint32_t numLeaves = mQueryLeaves.size();
+	if (numLeaves == 0)
+		return;
+
+	// Gather leaf boxes in SoA form and cull all of them in one batch
+	mQueryCullData.resize(numLeaves * 6);
+	mQueryVisibleMask.resize((numLeaves + 31) / 32);
+
+	float* cullData = &mQueryCullData[0];
+	for (uint32_t i = 0; i < numLeaves; ++i)
+	{
+		const BoundingBoxf& box = mNodes[mQueryLeaves[i]].Box;
+
+		float3 center = box.Center();
+		float3 extent = (box.Max - box.Min) * 0.5f;
+		cullData[i]                 = center.X();
+		cullData[i + numLeaves]     = center.Y();
+		cullData[i + numLeaves * 2] = center.Z();
+		cullData[i + numLeaves * 3] = extent.X();
+		cullData[i + numLeaves * 4] = extent.Y();
+		cullData[i + numLeaves * 5] = extent.Z();
+	}
+
+	BoundingBoxSoA<float> leafBounds = { cullData, cullData + numLeaves, cullData + numLeaves * 2, 
+		cullData + numLeaves * 3, cullData + numLeaves * 4, cullData + numLeaves * 5, numLeaves };
+	frustum.VisibleBatch(leafBounds, &mQueryVisibleMask[0]);
+
+	for (uint32_t i = 0; i < numLeaves; ++i)
+	{
+		if (mQueryVisibleMask[i >> 5] & (1U << (i & 31)))
+			objects.push_back(mNodes[mQueryLeaves[i]].Object);
+	}
+}
+
+} // Namespace RcEngine
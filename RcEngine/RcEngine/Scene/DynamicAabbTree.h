@@ -0,0 +1,116 @@
+#ifndef DynamicAabbTree_h__
+#define DynamicAabbTree_h__
+
+#include <Core/Prerequisites.h>
+#include <Math/BoundingBox.h>
+#include <Math/Frustum.h>
+
+namespace RcEngine {
+
+class SceneObject;
+
+/**
+ * Dynamic AABB tree used by SceneManager to accelerate view frustum culling. Each
+ * leaf (proxy) stores a fattened world bounding box of one scene object, so small
+ * movements do not change the tree structure. Inner nodes are kept balanced with
+ * tree rotations, the same way Box2D/Bullet broadphase does.
+ */
+class _ApiExport DynamicAabbTree
+{
+public:
+	static const int32_t NullNode = -1;
+
+public:
+	DynamicAabbTree( float fatMargin = 0.1f );
+	~DynamicAabbTree();
+
+	/**
+	 * Create a proxy for object, return proxy id.
+	 */
+	int32_t CreateProxy( const BoundingBoxf& box, SceneObject* object );
+
+	void DestroyProxy( int32_t proxy );
+
+	/**
+	 * Update proxy bounding box, the leaf is only reinserted when box is out of
+	 * the fat box. Return true if the tree is changed.
+	 */
+	bool MoveProxy( int32_t proxy, const BoundingBoxf& box );
+
+	/**
+	 * Flag the proxy as moved, the bounding box is fetched from the object in next Refit.
+	 * Not thread safe, only call from main thread.
+	 */
+	void MarkMoved( int32_t proxy );
+
+	/**
+	 * Refresh bounding box of all proxies marked as moved.
+	 */
+	void Refit();
+
+	/**
+	 * Remove all proxies.
+	 */
+	void Clear();
+
+	inline SceneObject* GetObject( int32_t proxy ) const		{ return mNodes[proxy].Object; }
+	inline const BoundingBoxf& GetFatBox( int32_t proxy ) const	{ return mNodes[proxy].Box; }
+
+	inline uint32_t GetNumProxies() const					{ return mNumProxies; }
+	int32_t GetHeight() const;
+
+	/**
+	 * Collect all objects whose fat box is not outside of the frustum. Subtrees
+	 * fully inside the frustum are collected without further plane tests, other leaves
+	 * reached are tested together with Frustum::VisibleBatch after traversal.
+	 */
+	void Query( const Frustumf& frustum, std::vector<SceneObject*>& objects ) const;
+
+private:
+	struct TreeNode
+	{
+		BoundingBoxf Box;
+		SceneObject* Object;
+
+		// Next free node if node is in free list
+		int32_t Parent;
+
+		int32_t Child1;
+		int32_t Child2;
+
+		// Leaf = 0, free node = -1
+		int32_t Height;
+
+		bool Moved;
+
+		inline bool IsLeaf() const { return Child1 == NullNode; }
+	};
+
+	int32_t AllocateNode();
+	void FreeNode( int32_t node );
+
+	void InsertLeaf( int32_t leaf );
+	void RemoveLeaf( int32_t leaf );
+
+	int32_t Balance( int32_t index );
+
+private:
+	std::vector<TreeNode> mNodes;
+
+	int32_t mRoot;
+	int32_t mFreeList;
+	uint32_t mNumProxies;
+
+	float mFatMargin;
+
+	// Scratch buffers, avoid per frame allocation
+	std::vector<int32_t> mMovedProxies;
+	mutable std::vector<std::pair<int32_t, bool> > mQueryStack;
+	mutable std::vector<int32_t> mQueryLeaves;
+	mutable std::vector<float> mQueryCullData;
+	mutable std::vector<uint32_t> mQueryVisibleMask;
+};
+
+} // Namespace RcEngine
+
+#endif // DynamicAabbTree_h__
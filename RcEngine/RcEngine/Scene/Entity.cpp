@@ -67,10 +67,17 @@ void Entity::Initialize()
 		mSubEntityList.push_back( subEnt );
 	}
 
+	uint32_t numSubEntities = mSubEntityList.size();
+	mSubEntityWorldBounds.resize(numSubEntities);
+	mSubEntityCullData.resize(numSubEntities * 6);
+	mSubEntityVisibleMask.resize((numSubEntities + 31) / 32);
+
 	if (HasSkeleton())
 	{
 		mNumSkinMatrices = mSkeleton->GetNumBones();
 		mSkinMatrices.resize(mNumSkinMatrices);
+		for (float4x4& skinMatrix : mSkinMatrices)
+			skinMatrix.MakeIdentity();
 	}
 
 	if (mParentNode)
@@ -129,88 +136,89 @@ AnimationPlayer* Entity::GetAnimationPlayer()
 	if (!mAnimationPlayer && mMesh->GetSkeleton())
 	{
 		mAnimationPlayer = new SkinnedAnimationPlayer(mSkeleton);
+		mAnimationPlayer->SetVisibilityTracked(true);
 	}
 
 	return mAnimationPlayer;
 }
 
+const float4x4* Entity::GetSkinMatrices() const
+{
+	const float4x4* skinMatrices = mAnimationPlayer ? mAnimationPlayer->GetSkinMatrices() : nullptr;
+	return skinMatrices ? skinMatrices : &mSkinMatrices[0];
+}
+
 void Entity::OnUpdateRenderQueue( RenderQueue* renderQueue, const Camera& camera, RenderOrder order, uint32_t buckterFilter, uint32_t filterIgnore )
 {
 	// Add each visible SubEntity to the queue
 
-	if ((mFlags & filterIgnore) == 0)
+	if ((mFlags & filterIgnore) == 0 && !mSubEntityList.empty())
 	{
-		for (SubEntity* subEntity : mSubEntityList)
+		const float4x4& worldMatrix = mParentNode->GetWorldTransform();
+		const uint32_t numSubEntities = mSubEntityList.size();
+
+		// Gather sub entity world bounds in SoA form and cull all of them in one batch
+		float* cullData = &mSubEntityCullData[0];
+		for (uint32_t i = 0; i < numSubEntities; ++i)
+		{
+			const BoundingBoxf& subWorldBoud = mSubEntityWorldBounds[i] = Transform(mSubEntityList[i]->GetBoundingBox(), worldMatrix);
+			
+			float3 center = subWorldBoud.Center();
+			float3 extent = (subWorldBoud.Max - subWorldBoud.Min) * 0.5f;
+			cullData[i]                      = center.X();
+			cullData[i + numSubEntities]     = center.Y();
+			cullData[i + numSubEntities * 2] = center.Z();
+			cullData[i + numSubEntities * 3] = extent.X();
+			cullData[i + numSubEntities * 4] = extent.Y();
+			cullData[i + numSubEntities * 5] = extent.Z();
+		}
+
+		BoundingBoxSoA<float> subBounds = { cullData, cullData + numSubEntities, cullData + numSubEntities * 2, 
+			cullData + numSubEntities * 3, cullData + numSubEntities * 4, cullData + numSubEntities * 5, numSubEntities };
+		camera.GetFrustum().VisibleBatch(subBounds, &mSubEntityVisibleMask[0]);
+
+		for (uint32_t i = 0; i < numSubEntities; ++i)
 		{
+			// Todo:  mesh part world bounding has some bugs.
+			if ( (mSubEntityVisibleMask[i >> 5] & (1U << (i & 31))) == 0 )
+				continue;
+
+			SubEntity* subEntity = mSubEntityList[i];
 			RenderQueue::Bucket bucket = (RenderQueue::Bucket)subEntity->GetMaterial()->GetQueueBucket();
 			if ( (buckterFilter & bucket) == 0 ) 
 				continue;
 
-			BoundingBoxf subWorldBoud = Transform(subEntity->GetBoundingBox(), mParentNode->GetWorldTransform());
+			const BoundingBoxf& subWorldBoud = mSubEntityWorldBounds[i];
 
-			// Todo:  mesh part world bounding has some bugs.
-			if(camera.Visible(subWorldBoud))
-			{
-				float sortKey = 0;
-				switch( order )
-				{
-				case RO_StateChange:
-					sortKey = (float)subEntity->GetMaterial()->GetEffect()->GetResourceHandle();
-					break;
-				case RO_FrontToBack:
-					sortKey = NearestDistToAABB( camera.GetPosition(), subWorldBoud.Min, subWorldBoud.Max);
-					break;
-				case RO_BackToFront:
-					sortKey = -NearestDistToAABB( camera.GetPosition(), subWorldBoud.Min, subWorldBoud.Max);
-					break;
-				}
-
-				if (bucket == RenderQueue::BucketTransparent)
-				{
-					// Transparent object must render from furthest to nearest
-					sortKey = -NearestDistToAABB( camera.GetPosition(), subWorldBoud.Min, subWorldBoud.Max);
-				}
-
-				renderQueue->AddToQueue(RenderQueueItem(subEntity, sortKey), bucket);			
-			}
+			// Transparent object must render from furthest to nearest, RO_None still groups by state
+			float depth = NearestDistToAABB( camera.GetPosition(), subWorldBoud.Min, subWorldBoud.Max);
+			RenderOrder bucketOrder = (bucket == RenderQueue::BucketTransparent) ? RO_BackToFront : order;
+			uint64_t sortKey = RenderQueue::MakeSortKey(bucket, bucketOrder, subEntity, depth);
+
+			renderQueue->AddToQueue(RenderQueueItem(subEntity, sortKey), bucket);			
+
+			// Streamed texture levels follow screen size of sub entity bounding sphere, same as animation LOD below
+			subEntity->GetMaterial()->RequestTextureDensity(camera.GetProjectedScreenSize(subWorldBoud));
 		}
 	}
 
-	// Update animation 
-	if (HasSkeleton())
+	// Animation is evaluated by AnimationController before culling, level of detail for
+	// next update is picked from what cameras see now
+	if (mAnimationPlayer && (mFlags & filterIgnore) == 0)
 	{
-		UpdateAnimation();
+		float distance;
+		float screenSize = camera.GetProjectedScreenSize(GetWorldBoundingBox(), &distance);
 
-		for (BoneSceneNode* boneSceneNode : mBoneSceneNodes)
-		{
-			boneSceneNode->OnUpdateRenderQueues(camera, order, buckterFilter, filterIgnore);
-		}
+		mAnimationPlayer->NotifyVisible(screenSize, distance);
 	}
-}
 
-void Entity::UpdateAnimation()
-{
-	if (mAnimationPlayer)
+	if (HasSkeleton())
 	{
-		for (auto& kv : mAnimationPlayer->GetAllClip())
-		{
-			AnimationState* animState = kv.second;
-			animState->Apply();
-		}
-
-		// Note: the model's world transform will be baked in the skin matrices
-		for (uint32_t i = 0; i < mSkeleton->GetNumBones(); ++i)
+		for (BoneSceneNode* boneSceneNode : mBoneSceneNodes)
 		{
-			Bone* bone = mSkeleton->GetBone(i);
-			auto world = bone->GetWorldTransform();
-			mSkinMatrices[i] = bone->GetOffsetMatrix() * bone->GetWorldTransform();
+			boneSceneNode->OnUpdateRenderQueues(camera, order, buckterFilter, filterIgnore);
 		}
 	}
-	else
-	{
-		for (uint32_t i = 0; i < mSkeleton->GetNumBones(); ++i)
-			mSkinMatrices[i].MakeIdentity();
-	}
 }
 
 BoneSceneNode* Entity::CreateBoneSceneNode( const String& nodeName, const String& boneName )
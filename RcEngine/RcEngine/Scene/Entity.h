@@ -41,12 +41,17 @@ public:
 	bool HasSkeletonAnimation() const;
 	AnimationPlayer* GetAnimationPlayer();
 
+	/**
+	 * Skin matrices evaluated by AnimationController this frame, identity if the entity
+	 * has no animation player.
+	 */
+	const float4x4* GetSkinMatrices() const;
+
 	// Create a SceneNode take bone as parent
 	BoneSceneNode* CreateBoneSceneNode(const String& nodeName, const String& boneName);
 
 protected:
 	void Initialize();
-	void UpdateAnimation();
 
 	void OnAttach( SceneNode* node ) override;
 	void OnDetach( SceneNode* node ) override;
@@ -61,9 +66,15 @@ protected:
 	mutable BoundingBoxf mWorldBoundingBox;
 
 	vector<SubEntity*> mSubEntityList;
+
+	// Scratch buffers for batch culling of sub entities, sized in Initialize
+	vector<BoundingBoxf> mSubEntityWorldBounds;
+	vector<float> mSubEntityCullData;
+	vector<uint32_t> mSubEntityVisibleMask;
 	
 	vector<BoneSceneNode*> mBoneSceneNodes;
 
+	// Identity skin matrices, used until the animation player is evaluated
 	vector<float4x4> mSkinMatrices;
 	uint32_t mNumSkinMatrices;
 
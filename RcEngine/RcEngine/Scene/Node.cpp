@@ -385,6 +385,8 @@ void Node::Update( )
 void Node::PropagateDirtyDown( uint32_t dirtyFlag )
 {
 	mDirtyBits |= dirtyFlag;
+	OnPropagateDirty(dirtyFlag);
+
 	for (size_t i = 0; i < mChildren.size(); ++i)
 	{
 		mChildren[i]->PropagateDirtyDown(dirtyFlag);
@@ -23,6 +23,9 @@ namespace RcEngine {
  */
 class _ApiExport Node
 {
+	friend class TransformHierarchy;
+	friend class Bone;
+
 public: 
 	enum TransformSpace
 	{
@@ -206,6 +209,12 @@ protected:
 
 	virtual void OnChildNodeAdded( Node* node ) ;
 	virtual void OnChildNodeRemoved( Node* node );
+
+	/**
+	 * Called when dirty flags are propagated down to this node, which means
+	 * the node transform is changed.
+	 */
+	virtual void OnPropagateDirty( uint32_t dirtyFlag ) { }
 	
 	virtual void UpdateWorldTransform() const;
 
@@ -1,5 +1,7 @@
 #include <Scene/SceneManager.h>
 #include <Scene/SceneNode.h>
+#include <Scene/TransformHierarchy.h>
+#include <Scene/DynamicAabbTree.h>
 #include <Scene/SceneObject.h>
 #include <Scene/Entity.h>
 #include <Graphics/RenderDevice.h>
@@ -24,7 +26,11 @@
 namespace RcEngine {
 
 SceneManager::SceneManager()
-	: mSkySceneNode(nullptr) 
+	: mSkySceneNode(nullptr),
+	  mParallelSceneGraphUpdate(false),
+	  mSceneGraphChanged(true),
+	  mSpatialCulling(false),
+	  mCullingTreeChanged(true)
 {
 	Environment::GetSingleton().mSceneManager = this;
 
@@ -34,22 +40,33 @@ SceneManager::SceneManager()
 	RegisterType(SOT_Sky, "Sky Type", nullptr, nullptr, SkyBox::FactoryFunc);
 
 	mAnimationController = new AnimationController;
+	mTransformHierarchy = new TransformHierarchy;
+	mObjectTree = new DynamicAabbTree;
+	mLightTree = new DynamicAabbTree;
 }
 
 SceneManager::~SceneManager()
 {
 	ClearScene();
 	SAFE_DELETE(mAnimationController);
+	SAFE_DELETE(mTransformHierarchy);
+	SAFE_DELETE(mObjectTree);
+	SAFE_DELETE(mLightTree);
 }
 
 void SceneManager::ClearScene()
 {
+	// Objects are deleted, tree is rebuilt from scratch
+	mCullingTreeChanged = true;
+	mPendingProxies.clear();
+
 	// clear all scene node
 	for (SceneNode* node : mAllSceneNodes) 
 		delete node;
 	
 	mAllSceneNodes.clear();
 	SAFE_DELETE(mSkySceneNode);
+	mSceneGraphChanged = true;
 
 	// clear all sprite
 	for (SpriteBatch* batch : mSpriteBatchs)
@@ -65,6 +82,10 @@ void SceneManager::ClearScene()
 
 	// lights has delete by mSceneObjectCollections
 	mAllSceneLights.clear();
+
+	if (mObjectTree) mObjectTree->Clear();
+	if (mLightTree) mLightTree->Clear();
+	mLightProxies.clear();
 }
 
 void SceneManager::RegisterType( uint32_t type, const String& typeString, ResTypeInitializationFunc inf, ResTypeReleaseFunc rf, ResTypeFactoryFunc ff )
@@ -84,6 +105,7 @@ SceneNode* SceneManager::CreateSceneNode( const String& name )
 {
 	SceneNode* node = CreateSceneNodeImpl(name);
 	mAllSceneNodes.push_back(node);
+	mSceneGraphChanged = true;
 	return node;
 }
 
@@ -138,6 +160,7 @@ void SceneManager::DestroySceneNode( SceneNode* node )
 
 		delete (*found);
 		mAllSceneNodes.erase(found);
+		mSceneGraphChanged = true;
 	}
 	else if (node == mSkySceneNode)
 	{
@@ -219,7 +242,26 @@ void SceneManager::UpdateSceneGraph( float delta )
 	mAnimationController->Update(delta);
 
 	// update scene node transform
-	GetRootSceneNode()->Update();
+	if (mParallelSceneGraphUpdate)
+	{
+		if (mSceneGraphChanged)
+		{
+			mTransformHierarchy->Build(GetRootSceneNode());
+			mSceneGraphChanged = false;
+		}
+
+		mTransformHierarchy->Update();
+	}
+	else
+	{
+		GetRootSceneNode()->Update();
+	}
+}
+
+void SceneManager::SetParallelSceneGraphUpdate( bool enable )
+{
+	mParallelSceneGraphUpdate = enable;
+	mSceneGraphChanged = true;
 }
 
 void SceneManager::UpdateRenderQueue( shared_ptr<Camera> camera, RenderOrder order, uint32_t buckterFilter, uint32_t filterIgnore )
@@ -246,7 +288,161 @@ void SceneManager::UpdateRenderQueue( shared_ptr<Camera> camera, RenderOrder ord
 
 	if (buckterFilter & (~(RenderQueue::BucketOverlay | RenderQueue::BucketBackground)))
 	{
-		GetRootSceneNode()->OnUpdateRenderQueues(*camera, order, buckterFilter, filterIgnore);
+		if (mSpatialCulling)
+		{
+			UpdateCullingTree();
+
+			mVisibleObjects.clear();
+			mObjectTree->Query(camera->GetFrustum(), mVisibleObjects);
+
+			for (SceneObject* pSceneObject : mVisibleObjects)
+			{
+				if (pSceneObject->IsActive() && pSceneObject->Renderable())
+					pSceneObject->OnUpdateRenderQueue(&mRenderQueue, *camera, order, buckterFilter, filterIgnore);
+			}
+		}
+		else
+		{
+			GetRootSceneNode()->OnUpdateRenderQueues(*camera, order, buckterFilter, filterIgnore);
+		}
+	}
+}
+
+void SceneManager::SetSpatialCulling( bool enable )
+{
+	mSpatialCulling = enable;
+	mCullingTreeChanged = true;
+}
+
+void SceneManager::OnSceneObjectMoved( SceneObject* object )
+{
+	if (IsCullingTreeLive())
+	{
+		if (object->mCullingProxy != DynamicAabbTree::NullNode)
+			mObjectTree->MarkMoved(object->mCullingProxy);
+		else
+			mPendingProxies.push_back(object);
+	}
+}
+
+void SceneManager::OnSceneObjectAdded( SceneObject* object )
+{
+	// Node may not be in scene yet, or object bound not valid, checked in next query
+	if (IsCullingTreeLive())
+		mPendingProxies.push_back(object);
+}
+
+void SceneManager::OnSceneObjectRemoved( SceneObject* object )
+{
+	if (IsCullingTreeLive())
+	{
+		if (object->mCullingProxy != DynamicAabbTree::NullNode)
+		{
+			mObjectTree->DestroyProxy(object->mCullingProxy);
+			object->mCullingProxy = DynamicAabbTree::NullNode;
+		}
+
+		mPendingProxies.erase(std::remove(mPendingProxies.begin(), mPendingProxies.end(), object), mPendingProxies.end());
+	}
+}
+
+void SceneManager::OnSceneNodeAdded( SceneNode* node )
+{
+	if (!IsCullingTreeLive())
+		return;
+
+	std::vector<SceneNode*> nodeStack(1, node);
+	while (!nodeStack.empty())
+	{
+		SceneNode* subNode = nodeStack.back();
+		nodeStack.pop_back();
+
+		for (uint32_t i = 0; i < subNode->GetNumAttachedObjects(); ++i)
+			mPendingProxies.push_back(subNode->GetAttachedObject(i));
+
+		for (Node* child : subNode->GetChildren())
+			nodeStack.push_back(static_cast<SceneNode*>(child));
+	}
+}
+
+void SceneManager::OnSceneNodeRemoved( SceneNode* node )
+{
+	if (!IsCullingTreeLive())
+		return;
+
+	std::vector<SceneNode*> nodeStack(1, node);
+	while (!nodeStack.empty())
+	{
+		SceneNode* subNode = nodeStack.back();
+		nodeStack.pop_back();
+
+		for (uint32_t i = 0; i < subNode->GetNumAttachedObjects(); ++i)
+			OnSceneObjectRemoved(subNode->GetAttachedObject(i));
+
+		for (Node* child : subNode->GetChildren())
+			nodeStack.push_back(static_cast<SceneNode*>(child));
+	}
+}
+
+void SceneManager::UpdateCullingTree()
+{
+	if (mCullingTreeChanged)
+	{
+		// Culling turned on or scene cleared, rebuild all proxies from objects reachable from scene root
+		for (auto& kv : mSceneObjectCollections)
+		{
+			for (SceneObject* object : kv.second)
+				object->mCullingProxy = DynamicAabbTree::NullNode;
+		}
+		mObjectTree->Clear();
+
+		std::vector<SceneNode*> nodeStack(1, GetRootSceneNode());
+		while (!nodeStack.empty())
+		{
+			SceneNode* node = nodeStack.back();
+			nodeStack.pop_back();
+
+			for (uint32_t i = 0; i < node->GetNumAttachedObjects(); ++i)
+			{
+				// Objects without bound, like light, never get rendered
+				SceneObject* object = node->GetAttachedObject(i);
+				const BoundingBoxf& worldBound = object->GetWorldBoundingBox();
+				if (worldBound.IsValid())
+					object->mCullingProxy = mObjectTree->CreateProxy(worldBound, object);
+			}
+
+			for (Node* child : node->GetChildren())
+				nodeStack.push_back(static_cast<SceneNode*>(child));
+		}
+
+		mPendingProxies.clear();
+		mCullingTreeChanged = false;
+	}
+	else
+	{
+		// Objects added to scene since last query, or moved without a proxy
+		SceneNode* rootNode = GetRootSceneNode();
+		for (SceneObject* object : mPendingProxies)
+		{
+			if (object->mCullingProxy != DynamicAabbTree::NullNode)
+				continue;
+
+			// Only objects reachable from scene root are culled, detached subtrees are added
+			// when attached to scene
+			Node* node = object->GetParentNode();
+			while (node && node != rootNode)
+				node = node->GetParent();
+
+			if (node)
+			{
+				const BoundingBoxf& worldBound = object->GetWorldBoundingBox();
+				if (worldBound.IsValid())
+					object->mCullingProxy = mObjectTree->CreateProxy(worldBound, object);
+			}
+		}
+		mPendingProxies.clear();
+
+		mObjectTree->Refit();
 	}
 }
 
@@ -262,24 +458,63 @@ void SceneManager::UpdateLightQueue( const Camera& cam )
 {
 	mLightQueue.clear();
 
-	for (Light* light : mAllSceneLights)
+	if (mSpatialCulling)
 	{
-		switch (light->GetLightType())
+		// Light position and range are not tracked by node dirty flags, refit all point lights.
+		// Proxies only move when light leaves its fat box.
+		mLightProxies.resize(mAllSceneLights.size(), DynamicAabbTree::NullNode);
+		for (size_t i = 0; i < mAllSceneLights.size(); ++i)
 		{
-		case LT_PointLight:
+			Light* light = mAllSceneLights[i];
+			if (light->GetLightType() == LT_PointLight)
 			{
-				BoundingSpheref sphere(light->GetDerivedPosition(), light->GetRange());
-				if (cam.Visible(sphere))
-					mLightQueue.push_back(light);
+				const float3& center = light->GetDerivedPosition();
+				const float3 extent(light->GetRange(), light->GetRange(), light->GetRange());
+				BoundingBoxf lightBound(center - extent, center + extent);
+
+				if (mLightProxies[i] == DynamicAabbTree::NullNode)
+					mLightProxies[i] = mLightTree->CreateProxy(lightBound, light);
+				else
+					mLightTree->MoveProxy(mLightProxies[i], lightBound);
+			}
+			else
+			{
+				mLightQueue.push_back(light);
 			}
-			break;
-		case LT_SpotLight:
+		}
+
+		mVisibleObjects.clear();
+		mLightTree->Query(cam.GetFrustum(), mVisibleObjects);
+
+		for (SceneObject* object : mVisibleObjects)
+		{
+			Light* light = static_cast<Light*>(object);
+			BoundingSpheref sphere(light->GetDerivedPosition(), light->GetRange());
+			if (cam.Visible(sphere))
+				mLightQueue.push_back(light);
+		}
+	}
+	else
+	{
+		for (Light* light : mAllSceneLights)
+		{
+			switch (light->GetLightType())
 			{
+			case LT_PointLight:
+				{
+					BoundingSpheref sphere(light->GetDerivedPosition(), light->GetRange());
+					if (cam.Visible(sphere))
+						mLightQueue.push_back(light);
+				}
+				break;
+			case LT_SpotLight:
+				{
+					mLightQueue.push_back(light);
+				}
+				break;
+			default:
 				mLightQueue.push_back(light);
 			}
-			break;
-		default:
-			mLightQueue.push_back(light);
 		}
 	}
 
@@ -12,11 +12,15 @@ namespace RcEngine {
 class SkyBox;
 class SceneObject;
 class SpriteBatch;
+class TransformHierarchy;
+class DynamicAabbTree;
 
 typedef std::vector<Light*> LightQueue;
 
 class _ApiExport SceneManager
 {
+	friend class SceneNode;
+
 public:
 	typedef void (*ResTypeInitializationFunc)();
 	typedef void (*ResTypeReleaseFunc)();
@@ -74,8 +78,22 @@ public:
 	 */
 	void UpdateSceneGraph(float delta);
 
+	/**
+	 * Use flattened, depth sorted transform arrays updated in parallel instead of
+	 * recursive Node::Update. Mainly for scenes with a large number of nodes.
+	 */
+	void SetParallelSceneGraphUpdate(bool enable);
+	bool IsParallelSceneGraphUpdate() const				{ return mParallelSceneGraphUpdate; }
+
 	void UpdateLightQueue(const Camera& cam);
 
+	/**
+	 * Cull scene objects and point lights with a dynamic AABB tree instead of
+	 * recursively testing scene node bounds.
+	 */
+	void SetSpatialCulling(bool enable);
+	bool IsSpatialCulling() const						{ return mSpatialCulling; }
+
 	/**
 	 * Update render queue, and remove scene node outside of the camera frustum.
 	 */
@@ -97,10 +115,36 @@ public:
 	SpriteBatch* CreateSpriteBatch(const shared_ptr<Effect>& effect);
 	void DestrySpriteBatch(SpriteBatch* batch);
 
+public_internal:
+	/**
+	 * Called when scene node attached or detached, flattened hierarchy need rebuild.
+	 */
+	void OnSceneGraphChanged()							{ mSceneGraphChanged = true; }
+
+	/**
+	 * Called when scene object or a subtree of scene nodes is attached or detached. Culling
+	 * proxies of removed objects are destroyed at once, added objects get one in next query.
+	 */
+	void OnSceneObjectAdded(SceneObject* object);
+	void OnSceneObjectRemoved(SceneObject* object);
+	void OnSceneNodeAdded(SceneNode* node);
+	void OnSceneNodeRemoved(SceneNode* node);
+
+	/**
+	 * Called when scene object's parent node transform changed, culling proxy need refit.
+	 * Object without proxy is added again, its bound may be valid now.
+	 */
+	void OnSceneObjectMoved(SceneObject* object);
+
 protected:
 	void ClearScene();
 	virtual SceneNode* CreateSceneNodeImpl( const String& name );
 
+	void UpdateCullingTree();
+
+	// Culling tree is built and kept up to date by scene changes
+	bool IsCullingTreeLive() const						{ return mSpatialCulling && !mCullingTreeChanged; }
+
 protected:
 	// Registry of scene object types
 	std::map< uint32_t, SceneObjectRegEntry >  mRegistry; 
@@ -120,6 +164,22 @@ protected:
 
 	AnimationController* mAnimationController;
 
+	TransformHierarchy* mTransformHierarchy;
+	bool mParallelSceneGraphUpdate;
+	bool mSceneGraphChanged;
+
+	DynamicAabbTree* mObjectTree;
+	DynamicAabbTree* mLightTree;
+	std::vector<int32_t> mLightProxies;
+	std::vector<SceneObject*> mVisibleObjects;
+	std::vector<SceneObject*> mPendingProxies;
+	bool mSpatialCulling;
+	bool mCullingTreeChanged;
+
+	// Child bounds and visible masks of SceneNode recursion, a stack with one range per level
+	std::vector<float> mNodeCullData;
+	std::vector<uint32_t> mNodeVisibleMask;
+
 	RenderQueue mRenderQueue;
 	LightQueue  mLightQueue;
 };
@@ -17,8 +17,16 @@ SceneNode::SceneNode( SceneManager* scene, const String& name )
 
 SceneNode::~SceneNode()
 {
+	// Detach here, scene must see a whole scene node leave. Base destructor is too late.
+	DetachAllChildren();
+	if (mParent)
+		mParent->DetachChild(this);
+
 	for ( auto iter = mAttachedObjects.begin(); iter != mAttachedObjects.end(); ++iter )
 	{
+		if (mScene)
+			mScene->OnSceneObjectRemoved(*iter);
+
 		(*iter)->OnDetach(this);
 	}
 	mAttachedObjects.clear();
@@ -41,6 +49,33 @@ SceneNode* SceneNode::CreateChildSceneNode( const String& name, const float3& tr
 	return static_cast<SceneNode*>( CreateChild(name, translate, rotate) );
 }
 
+void SceneNode::OnChildNodeAdded( Node* node )
+{
+	if (mScene)
+	{
+		mScene->OnSceneGraphChanged();
+		mScene->OnSceneNodeAdded(static_cast<SceneNode*>(node));
+	}
+}
+
+void SceneNode::OnChildNodeRemoved( Node* node )
+{
+	if (mScene)
+	{
+		mScene->OnSceneGraphChanged();
+		mScene->OnSceneNodeRemoved(static_cast<SceneNode*>(node));
+	}
+}
+
+void SceneNode::OnPropagateDirty( uint32_t dirtyFlag )
+{
+	if (mScene && (dirtyFlag & NODE_DIRTY_BOUNDS))
+	{
+		for (SceneObject* obj : mAttachedObjects)
+			mScene->OnSceneObjectMoved(obj);
+	}
+}
+
 void SceneNode::AttachObject( SceneObject* obj )
 {
 	if (obj->IsAttached())
@@ -54,6 +89,9 @@ void SceneNode::AttachObject( SceneObject* obj )
 	PropagateDirtyUp(NODE_DIRTY_BOUNDS);
 
 	obj->OnAttach(this);
+
+	if (mScene)
+		mScene->OnSceneObjectAdded(obj);
 }
 
 void SceneNode::DetachOject( SceneObject* obj )
@@ -61,6 +99,9 @@ void SceneNode::DetachOject( SceneObject* obj )
 	auto found = std::find(mAttachedObjects.begin(), mAttachedObjects.end(), obj);
 	if (found != mAttachedObjects.end())
 	{
+		if (mScene)
+			mScene->OnSceneObjectRemoved(obj);
+
 		obj->OnDetach(this);
 		mAttachedObjects.erase(found);
 
@@ -73,6 +114,9 @@ void SceneNode::DetachAllObject()
 {
 	for ( auto iter = mAttachedObjects.begin(); iter != mAttachedObjects.end(); ++iter )
 	{
+		if (mScene)
+			mScene->OnSceneObjectRemoved(*iter);
+
 		(*iter)->OnDetach(this);
 	}
 	mAttachedObjects.clear();
@@ -129,11 +173,14 @@ const BoundingBoxf& SceneNode::GetWorldBoundingBox() const
 
 void SceneNode::OnUpdateRenderQueues( const Camera& camera, RenderOrder order, uint32_t buckterFilter, uint32_t filterIgnore )
 {
-	const BoundingBoxf& worldBound = GetWorldBoundingBox();
-
 	if (!camera.Visible(GetWorldBoundingBox()))
 		return;
 
+	UpdateVisibleRenderQueues(camera, order, buckterFilter, filterIgnore);
+}
+
+void SceneNode::UpdateVisibleRenderQueues( const Camera& camera, RenderOrder order, uint32_t buckterFilter, uint32_t filterIgnore )
+{
 	RenderQueue& renderQueue = mScene->GetRenderQueue();
 	for (SceneObject* pSceneObject : mAttachedObjects)
 	{
@@ -141,12 +188,47 @@ void SceneNode::OnUpdateRenderQueues( const Camera& camera, RenderOrder order, u
 			pSceneObject->OnUpdateRenderQueue(&renderQueue, camera, order, buckterFilter, filterIgnore);
 	}
 
-	// recursively call children
-	for (Node* node : mChildren)
+	const uint32_t numChildren = mChildren.size();
+	if (numChildren == 0)
+		return;
+
+	// Push this level on scene scratch, deeper levels may reallocate it so only offsets are kept
+	std::vector<float>& cullStack = mScene->mNodeCullData;
+	std::vector<uint32_t>& maskStack = mScene->mNodeVisibleMask;
+	const size_t cullOffset = cullStack.size();
+	const size_t maskOffset = maskStack.size();
+	cullStack.resize(cullOffset + numChildren * 6);
+	maskStack.resize(maskOffset + (numChildren + 31) / 32);
+
+	// Gather child world bounds in SoA form and cull all of them in one batch
+	float* cullData = &cullStack[cullOffset];
+	for (uint32_t i = 0; i < numChildren; ++i)
 	{
-		SceneNode* child = static_cast<SceneNode*>(node);
-		child->OnUpdateRenderQueues(camera, order, buckterFilter, filterIgnore);
+		const BoundingBoxf& childBound = static_cast<SceneNode*>(mChildren[i])->GetWorldBoundingBox();
+
+		float3 center = childBound.Center();
+		float3 extent = (childBound.Max - childBound.Min) * 0.5f;
+		cullData[i]                   = center.X();
+		cullData[i + numChildren]     = center.Y();
+		cullData[i + numChildren * 2] = center.Z();
+		cullData[i + numChildren * 3] = extent.X();
+		cullData[i + numChildren * 4] = extent.Y();
+		cullData[i + numChildren * 5] = extent.Z();
 	}
+
+	BoundingBoxSoA<float> childBounds = { cullData, cullData + numChildren, cullData + numChildren * 2, 
+		cullData + numChildren * 3, cullData + numChildren * 4, cullData + numChildren * 5, numChildren };
+	camera.GetFrustum().VisibleBatch(childBounds, &maskStack[maskOffset]);
+
+	// recursively call visible children
+	for (uint32_t i = 0; i < numChildren; ++i)
+	{
+		if (maskStack[maskOffset + (i >> 5)] & (1U << (i & 31)))
+			static_cast<SceneNode*>(mChildren[i])->UpdateVisibleRenderQueues(camera, order, buckterFilter, filterIgnore);
+	}
+
+	cullStack.resize(cullOffset);
+	maskStack.resize(maskOffset);
 }
 
 }
\ No newline at end of file
@@ -64,8 +64,18 @@ protected:
 	 */
 	void UpdateWorldBounds() const;
 
+	/**
+	 * Add attached objects of a node known to be visible, children are culled together with
+	 * Frustum::VisibleBatch before recursion.
+	 */
+	void UpdateVisibleRenderQueues(const Camera& cam, RenderOrder order, uint32_t buckterFilter, uint32_t filterIgnore);
+
 	void OnPostUpdate() {}
 
+	virtual void OnChildNodeAdded( Node* node );
+	virtual void OnChildNodeRemoved( Node* node );
+	virtual void OnPropagateDirty( uint32_t dirtyFlag );
+
 protected:
 
 	mutable BoundingBoxf mWorldBounds;
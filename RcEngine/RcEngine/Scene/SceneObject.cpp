@@ -13,7 +13,8 @@ SceneObject::SceneObject( const String& name, SceneObejctType type, bool rendera
 	: mName(name),
 	  mType(type),
 	  mParentNode(nullptr), 
-	  mFlags(0)
+	  mFlags(0),
+	  mCullingProxy(-1)
 {
 
 }
@@ -32,6 +32,7 @@ enum SceneObejctType
 class _ApiExport SceneObject
 {
 	friend class SceneNode;
+	friend class SceneManager;
 
 public:
 	enum Flags
@@ -91,6 +92,9 @@ protected:
 	SceneNode* mParentNode;
 
 	uint32_t mFlags;
+
+	// Proxy in scene manager's culling tree, -1 if not in tree
+	int32_t mCullingProxy;
 };
 
 }
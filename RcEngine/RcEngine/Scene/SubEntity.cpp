@@ -67,9 +67,11 @@ void SubEntity::GetWorldTransforms( float4x4* xform ) const
 		if (mParent->HasSkeletonAnimation())
 		{
 			assert(mParent->mNumSkinMatrices != 0);
+			const float4x4* skinMatrices = mParent->GetSkinMatrices();
+
 			size_t i = 0;
 			for (i = 0; i < mParent->mNumSkinMatrices; ++i)
-				xform[i] = mParent->mSkinMatrices[i];
+				xform[i] = skinMatrices[i];
 
 			// last matrix is scene node world matrix
 			xform[i] = mParent->GetWorldTransform();
@@ -0,0 +1,99 @@
+#include <Scene/TransformHierarchy.h>
+#include <Scene/Node.h>
+#include <Math/MathUtil.h>
+#include <Core/JobSystem.h>
+
+namespace RcEngine {
+
+// Levels smaller than this are updated on the calling thread.
+static const uint32_t ParallelGrainSize = 512;
+
+TransformHierarchy::TransformHierarchy()
+{
+
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+
+}
+
+void TransformHierarchy::Build( Node* root )
+{
+	mNodes.clear();
+	mParentIndices.clear();
+	mLevelOffsets.clear();
+
+	if (root)
+	{
+		mNodes.push_back(root);
+		mParentIndices.push_back(-1);
+
+		// Breadth first traversal, parent always stored before its children.
+		uint32_t levelBegin = 0;
+		while (levelBegin < mNodes.size())
+		{
+			uint32_t levelEnd = mNodes.size();
+			mLevelOffsets.push_back(levelBegin);
+
+			for (uint32_t i = levelBegin; i < levelEnd; ++i)
+			{
+				for (Node* child : mNodes[i]->GetChildren())
+				{
+					mNodes.push_back(child);
+					mParentIndices.push_back(int32_t(i));
+				}
+			}
+
+			levelBegin = levelEnd;
+		}
+
+		mLevelOffsets.push_back(mNodes.size());
+	}
+}
+
+void TransformHierarchy::Update()
+{
+	for (uint32_t level = 0; level < GetNumLevels(); ++level)
+	{
+		uint32_t begin = mLevelOffsets[level];
+		uint32_t end = mLevelOffsets[level+1];
+
+		if (end - begin >= ParallelGrainSize * 2)
+		{
+			JobSystem& jobSystem = JobSystem::GetSingleton();
+			jobSystem.ParallelFor(begin, end, ParallelGrainSize, [this](uint32_t rangeBegin, uint32_t rangeEnd) {
+				UpdateRange(rangeBegin, rangeEnd);
+			});
+		}
+		else
+		{
+			UpdateRange(begin, end);
+		}
+	}
+}
+
+void TransformHierarchy::UpdateRange( uint32_t begin, uint32_t end )
+{
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		Node* node = mNodes[i];
+		if (!(node->mDirtyBits & NODE_DIRTY_WORLD))
+			continue;
+
+		node->OnPreUpdate();
+
+		// Parent is in a previous level and is up to date, whether it was recomputed in this pass or not.
+		int32_t parent = mParentIndices[i];
+		if (parent >= 0)
+			node->mWorldTransform = CreateTransformMatrix(node->mScale, node->mRotation, node->mPosition) * mNodes[parent]->mWorldTransform;
+		else
+			node->mWorldTransform = CreateTransformMatrix(node->mScale, node->mRotation, node->mPosition);
+
+		node->OnPostUpdate();
+
+		node->mDirtyBits &= ~NODE_DIRTY_WORLD;
+	}
+}
+
+} // Namespace RcEngine
@@ -0,0 +1,50 @@
+#ifndef TransformHierarchy_h__
+#define TransformHierarchy_h__
+
+#include <Core/Prerequisites.h>
+
+namespace RcEngine {
+
+/**
+ * Flattened, depth sorted view of a node tree. Nodes are stored level by level
+ * with parent indices, so world transforms can be updated with a linear walk
+ * instead of chasing Node::mChildren pointers. Nodes in the same level do not
+ * depend on each other and are updated in parallel.
+ *
+ * Transforms stay in the nodes, only the traversal order is flattened. Nodes marked
+ * with NODE_DIRTY_WORLD are recomputed, the result is identical to Node::Update.
+ */
+class _ApiExport TransformHierarchy
+{
+public:
+	TransformHierarchy();
+	~TransformHierarchy();
+
+	/**
+	 * Flatten the tree rooted at root. Must be called again whenever a node is
+	 * attached or detached below root.
+	 */
+	void Build( Node* root );
+
+	/**
+	 * Recompute world transform of all dirty nodes.
+	 */
+	void Update();
+
+	inline uint32_t GetNumNodes() const		{ return mNodes.size(); }
+	inline uint32_t GetNumLevels() const	{ return mLevelOffsets.empty() ? 0 : mLevelOffsets.size() - 1; }
+
+private:
+	void UpdateRange( uint32_t begin, uint32_t end );
+
+private:
+	std::vector<Node*> mNodes;
+	std::vector<int32_t> mParentIndices;
+
+	// Start index of each depth level, last element is node count.
+	std::vector<uint32_t> mLevelOffsets;
+};
+
+} // Namespace RcEngine
+
+#endif // TransformHierarchy_h__
@@ -0,0 +1,391 @@
+#include <Core/Prerequisites.h>
+#include <Core/Exception.h>
+#include <Graphics/AnimationClip.h>
+#include <IO/FileSystem.h>
+#include <IO/FileStream.h>
+#include <Math/MathUtil.h>
+#include <Resource/ResourceManager.h>
+#include "../TestCheck.h"
+
+using namespace RcEngine;
+
+/**
+ * Compressed clips are sampled against the same clips loaded uncompressed, at every raw key
+ * time and between keys, and the max error of each track is checked against compression
+ * tolerances plus quantization error.
+ *
+ * Clips shaped like the sample ones are generated to a scratch directory. Character sample
+ * clips are checked as well when sample media is installed. Clips saved compressed and
+ * uncompressed must load back to the same samples.
+ */
+
+namespace {
+
+const String ClipDir = "AnimationCompressionTest";
+
+// Quantization of 15 bit quaternion components, about 1e-4 radians
+const float RotationSlack = 0.0003f;
+
+typedef void (*KeyFunc)(uint32_t track, uint32_t key, float time, float3& translation, Quaternionf& rotation, float3& scale);
+
+void WriteClip(const String& name, float duration, uint32_t numTracks, uint32_t numKeys, KeyFunc keyFunc)
+{
+	FileStream stream;
+	if (stream.Open(ClipDir + "/" + name, FILE_WRITE) == false)
+		ENGINE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE, "Can't write " + name, "WriteClip");
+
+	stream.WriteFloat(duration);
+	stream.WriteUInt(numTracks);
+
+	for (uint32_t track = 0; track < numTracks; ++track)
+	{
+		stream.WriteString("Bone" + std::to_string(track));
+		stream.WriteUInt(numKeys);
+
+		for (uint32_t key = 0; key < numKeys; ++key)
+		{
+			float time = numKeys > 1 ? duration * key / (numKeys - 1) : 0.0f;
+
+			float3 translation, scale;
+			Quaternionf rotation;
+			keyFunc(track, key, time, translation, rotation, scale);
+
+			stream.WriteFloat(time);
+			stream.Write(&translation, sizeof(float3));
+			stream.Write(&rotation, sizeof(Quaternionf));
+			stream.Write(&scale, sizeof(float3));
+		}
+	}
+}
+
+// Mostly constant tracks, root bobbing and a slow sway
+void IdleKey(uint32_t track, uint32_t key, float time, float3& translation, Quaternionf& rotation, float3& scale)
+{
+	translation = float3(0, 0.5f, 0);
+	rotation = QuaternionFromRotationAxis(float3(1, 0, 0), 0.3f);
+	scale = float3(1, 1, 1);
+
+	if (track == 0)
+		translation[1] = 1.0f + 0.02f * sinf(time * Mathf::PI);
+	else if (track % 3 != 1)
+		rotation = QuaternionFromRotationAxis(float3(0, 0, 1), 0.1f * sinf(time * Mathf::PI + track));
+}
+
+// Root moves forward linearly, limbs swing wide, rotation signs flip between keys
+void RunKey(uint32_t track, uint32_t key, float time, float3& translation, Quaternionf& rotation, float3& scale)
+{
+	translation = float3(0, 0.3f, 0.1f * track);
+	rotation = QuaternionFromRotationAxis(float3(1, 0, 0), 1.2f * sinf(Mathf::TWO_PI * time + track * 0.5f));
+	scale = float3(1, 1, 1);
+
+	if (track == 0)
+	{
+		translation = float3(0, 1.0f + 0.1f * fabsf(sinf(Mathf::TWO_PI * time)), 5.0f * time);
+		rotation = Quaternionf::Identity();
+	}
+
+	if (key % 2)
+		rotation = rotation * -1.0f;
+
+	if (track % 5 == 0)
+		scale = float3(1.0f + 0.2f * sinf(Mathf::TWO_PI * time), 1.0f, 1.0f);
+}
+
+// Long clip, every channel keeps moving
+void DanceKey(uint32_t track, uint32_t key, float time, float3& translation, Quaternionf& rotation, float3& scale)
+{
+	translation = float3(sinf(time * 0.7f + track), cosf(time * 1.3f), time * 0.1f);
+	rotation = QuaternionFromRotationAxis(Normalize(float3(1.0f, float(track % 3), 1.0f)), time * 0.8f);
+	scale = float3(1.0f, 1.0f + 0.5f * sinf(time * 2.0f), 1.0f);
+}
+
+// Bind pose, single key
+void PoseKey(uint32_t track, uint32_t key, float time, float3& translation, Quaternionf& rotation, float3& scale)
+{
+	translation = float3(0, 0.2f * track, 0);
+	rotation = QuaternionFromRotationAxis(float3(0, 1, 0), 0.1f * track);
+	scale = float3(1, 1, 1);
+}
+
+float RotationError(const Quaternionf& a, const Quaternionf& b)
+{
+	// Chord length in double, acos is not accurate enough for small angles
+	double dot = 0.0, length = 0.0;
+	for (int32_t i = 0; i < 4; ++i)
+		dot += double(a[i]) * b[i];
+
+	double sign = dot < 0.0 ? -1.0 : 1.0;
+	for (int32_t i = 0; i < 4; ++i)
+		length += (a[i] - sign * b[i]) * (a[i] - sign * b[i]);
+
+	return float(4.0 * asin((std::min)(sqrt(length) * 0.5, 1.0)));
+}
+
+float ScaleError(const float3& a, const float3& b)
+{
+	return (std::max)((std::max)(fabsf(a[0] - b[0]), fabsf(a[1] - b[1])), fabsf(a[2] - b[2]));
+}
+
+shared_ptr<AnimationClip> LoadClip(const String& name, const String& group)
+{
+	shared_ptr<AnimationClip> clip = std::make_shared<AnimationClip>(ResourceManager::GetSingletonPtr(), 0, name, group);
+	clip->Load();
+	return clip;
+}
+
+void CheckClip(const String& name, const String& group, const AnimationClip::CompressionSettings& settings)
+{
+	shared_ptr<AnimationClip> raw = LoadClip(name, group);
+	shared_ptr<AnimationClip> compressed = LoadClip(name, group);
+	compressed->Compress(settings);
+
+	CHECK(!raw->IsCompressed() && compressed->IsCompressed());
+	CHECK(compressed->GetNumTracks() == raw->GetNumTracks());
+
+	uint32_t numRawKeys = 0;
+	float maxTranslationError = 0.0f, maxRotationError = 0.0f, maxScaleError = 0.0f;
+	float keyTranslationError = 0.0f, keyRotationError = 0.0f, keyScaleError = 0.0f;
+
+	for (uint32_t track = 0; track < raw->GetNumTracks(); ++track)
+	{
+		const AnimationClip::AnimationTrack& rawTrack = raw->GetTrack(track);
+		numRawKeys += rawTrack.NumKeys;
+		if (rawTrack.NumKeys == 0)
+			continue;
+
+		vector<float> times;
+		float3 translationMin, translationMax, scaleMin, scaleMax;
+
+		uint32_t rawCursor = 0;
+		for (uint32_t key = 0; key < rawTrack.NumKeys; ++key)
+		{
+			float time = raw->GetKeyTime(track, key);
+
+			float3 translation, scale;
+			Quaternionf rotation;
+			raw->SampleTrack(track, time, false, rawCursor, translation, rotation, scale);
+
+			// Quantization range
+			if (key == 0)
+			{
+				translationMin = translationMax = translation;
+				scaleMin = scaleMax = scale;
+			}
+			for (int32_t i = 0; i < 3; ++i)
+			{
+				translationMin[i] = (std::min)(translationMin[i], translation[i]);
+				translationMax[i] = (std::max)(translationMax[i], translation[i]);
+				scaleMin[i] = (std::min)(scaleMin[i], scale[i]);
+				scaleMax[i] = (std::max)(scaleMax[i], scale[i]);
+			}
+
+			times.push_back(time);
+			if (key + 1 < rawTrack.NumKeys)
+				times.push_back((time + raw->GetKeyTime(track, key + 1)) * 0.5f);
+		}
+
+		const float translationLimit = settings.TranslationTolerance + Length(translationMax - translationMin) / 65535.0f + 1e-5f;
+		const float rotationLimit = settings.RotationTolerance + RotationSlack;
+		const float scaleLimit = settings.ScaleTolerance + ScaleError(scaleMax, scaleMin) / 65535.0f + 1e-5f;
+
+		float translationError = 0.0f, rotationError = 0.0f, scaleError = 0.0f;
+
+		rawCursor = 0;
+		uint32_t cursor = 0;
+		for (size_t i = 0; i < times.size(); ++i)
+		{
+			float3 rawTranslation, rawScale, translation, scale;
+			Quaternionf rawRotation, rotation;
+			raw->SampleTrack(track, times[i], false, rawCursor, rawTranslation, rawRotation, rawScale);
+			compressed->SampleTrack(track, times[i], false, cursor, translation, rotation, scale);
+
+			translationError = (std::max)(translationError, Length(translation - rawTranslation));
+			rotationError = (std::max)(rotationError, RotationError(rotation, rawRotation));
+			scaleError = (std::max)(scaleError, ScaleError(scale, rawScale));
+
+			// Odd samples are between keys, report only covers key times
+			if (i % 2 == 0)
+			{
+				keyTranslationError = (std::max)(keyTranslationError, Length(translation - rawTranslation));
+				keyRotationError = (std::max)(keyRotationError, RotationError(rotation, rawRotation));
+				keyScaleError = (std::max)(keyScaleError, ScaleError(scale, rawScale));
+			}
+		}
+
+		if (translationError > translationLimit || rotationError > rotationLimit || scaleError > scaleLimit)
+		{
+			std::cout << "FAILED " << name << " " << rawTrack.Name << ": translation " << translationError << ", rotation "
+				<< rotationError << ", scale " << scaleError << std::endl;
+			++gFailures;
+		}
+
+		maxTranslationError = (std::max)(maxTranslationError, translationError);
+		maxRotationError = (std::max)(maxRotationError, rotationError);
+		maxScaleError = (std::max)(maxScaleError, scaleError);
+	}
+
+	const AnimationClip::CompressionReport& report = compressed->GetCompressionReport();
+	CHECK(report.NumRawKeys == numRawKeys && report.NumKeys <= report.NumRawKeys);
+	// Per track ranges cost more than they save on single key clips
+	CHECK(report.CompressedSize < report.RawSize || report.NumRawKeys == raw->GetNumTracks());
+
+	// Report measures at raw key times too
+	CHECK(fabsf(report.MaxTranslationError - keyTranslationError) < 1e-4f);
+	CHECK(fabsf(report.MaxRotationError - keyRotationError) < 1e-4f);
+	CHECK(fabsf(report.MaxScaleError - keyScaleError) < 1e-4f);
+
+	std::cout << name << ": " << report.NumRawKeys << " -> " << report.NumKeys << " keys, " << report.RawSize << " -> "
+		<< report.CompressedSize << " bytes, max error translation " << maxTranslationError << ", rotation "
+		<< maxRotationError << ", scale " << maxScaleError << std::endl;
+}
+
+void TestLoadCompression(const AnimationClip::CompressionSettings& settings)
+{
+	shared_ptr<AnimationClip> compressed = LoadClip("Run.anim", "General");
+	compressed->Compress(settings);
+
+	// Same result when compressed on load
+	AnimationClip::SetLoadCompression(settings);
+	shared_ptr<AnimationClip> loaded = LoadClip("Run.anim", "General");
+	AnimationClip::SetLoadCompression(AnimationClip::CompressionSettings());
+
+	CHECK(loaded->IsCompressed());
+	CHECK(loaded->GetCompressionReport().NumKeys == compressed->GetCompressionReport().NumKeys);
+	CHECK(loaded->GetCompressionReport().CompressedSize == compressed->GetCompressionReport().CompressedSize);
+	CHECK(!LoadClip("Run.anim", "General")->IsCompressed());
+}
+
+void SaveClip(const AnimationClip& clip, const String& name)
+{
+	FileStream stream;
+	if (stream.Open(ClipDir + "/" + name, FILE_WRITE) == false)
+		ENGINE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE, "Can't write " + name, "SaveClip");
+
+	clip.Save(stream);
+}
+
+// Samples of both clips are identical at keys and between keys
+bool SameSamples(const AnimationClip& a, const AnimationClip& b)
+{
+	if (a.GetNumTracks() != b.GetNumTracks() || a.GetDuration() != b.GetDuration())
+		return false;
+
+	for (uint32_t track = 0; track < a.GetNumTracks(); ++track)
+	{
+		if (a.GetTrack(track).Name != b.GetTrack(track).Name || a.GetTrack(track).NumKeys != b.GetTrack(track).NumKeys)
+			return false;
+
+		uint32_t cursorA = 0, cursorB = 0;
+		for (uint32_t step = 0; a.GetTrack(track).NumKeys && step <= 200; ++step)
+		{
+			float time = a.GetDuration() * step / 200;
+
+			float3 translationA, scaleA, translationB, scaleB;
+			Quaternionf rotationA, rotationB;
+			a.SampleTrack(track, time, true, cursorA, translationA, rotationA, scaleA);
+			b.SampleTrack(track, time, true, cursorB, translationB, rotationB, scaleB);
+
+			if (memcmp(&translationA, &translationB, sizeof(float3)) || memcmp(&rotationA, &rotationB, sizeof(Quaternionf)) ||
+				memcmp(&scaleA, &scaleB, sizeof(float3)))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void TestSave(const String& name, const AnimationClip::CompressionSettings& settings)
+{
+	shared_ptr<AnimationClip> raw = LoadClip(name, "General");
+	SaveClip(*raw, "Saved" + name);
+
+	shared_ptr<AnimationClip> rawLoaded = LoadClip("Saved" + name, "General");
+	CHECK(!rawLoaded->IsCompressed());
+	CHECK(SameSamples(*raw, *rawLoaded));
+
+	shared_ptr<AnimationClip> compressed = LoadClip(name, "General");
+	compressed->Compress(settings);
+	SaveClip(*compressed, "Compressed" + name);
+
+	shared_ptr<AnimationClip> loaded = LoadClip("Compressed" + name, "General");
+	CHECK(loaded->IsCompressed());
+	CHECK(SameSamples(*compressed, *loaded));
+
+	// Report is saved with the clip
+	const AnimationClip::CompressionReport& report = compressed->GetCompressionReport();
+	const AnimationClip::CompressionReport& loadedReport = loaded->GetCompressionReport();
+	CHECK(loadedReport.NumRawKeys == report.NumRawKeys && loadedReport.NumKeys == report.NumKeys);
+	CHECK(loadedReport.RawSize == report.RawSize && loadedReport.CompressedSize == report.CompressedSize);
+	CHECK(loadedReport.MaxRotationError == report.MaxRotationError);
+
+	// Load time compression leaves compressed files as they are
+	AnimationClip::SetLoadCompression(settings);
+	CHECK(SameSamples(*compressed, *LoadClip("Compressed" + name, "General")));
+	AnimationClip::SetLoadCompression(AnimationClip::CompressionSettings());
+}
+
+}
+
+int main()
+{
+	FileSystem::Initialize();
+	ResourceManager::Initialize();
+
+	FileSystem& fileSystem = FileSystem::GetSingleton();
+	fileSystem.CreateDir(ClipDir + "/");
+	fileSystem.RegisterPath(ClipDir, "General");
+	fileSystem.RegisterPath("../Media/Mesh", "Custom");
+
+	const String SampleClips[] = {
+		"./Sinbad/IdleBase.anim",
+		"./Sinbad/RunBase.anim",
+		"./Sinbad/RunTop.anim",
+		"./Sinbad/Dance.anim",
+		"./Sinbad/SliceHorizontal.anim",
+	};
+
+	try
+	{
+		WriteClip("Idle.anim", 2.0f, 30, 61, IdleKey);
+		WriteClip("Run.anim", 1.0f, 30, 31, RunKey);
+		WriteClip("Dance.anim", 20.0f, 60, 600, DanceKey);
+		WriteClip("Pose.anim", 0.0f, 30, 1, PoseKey);
+
+		AnimationClip::CompressionSettings settings;
+		settings.Enabled = true;
+
+		CheckClip("Idle.anim", "General", settings);
+		CheckClip("Run.anim", "General", settings);
+		CheckClip("Dance.anim", "General", settings);
+		CheckClip("Pose.anim", "General", settings);
+
+		// Coarse tolerances remove more keys, error must follow
+		AnimationClip::CompressionSettings coarse = settings;
+		coarse.TranslationTolerance = coarse.RotationTolerance = coarse.ScaleTolerance = 0.01f;
+		CheckClip("Dance.anim", "General", coarse);
+
+		for (size_t i = 0; i < ARRAY_SIZE(SampleClips); ++i)
+		{
+			if (fileSystem.Exits(SampleClips[i], "Custom"))
+				CheckClip(SampleClips[i], "Custom", settings);
+			else
+				std::cout << SampleClips[i] << " not installed, skipped" << std::endl;
+		}
+
+		TestLoadCompression(settings);
+
+		TestSave("Run.anim", settings);
+		TestSave("Dance.anim", settings);
+		TestSave("Pose.anim", settings);
+	}
+	catch (std::exception& e)
+	{
+		std::cout << "FAILED: " << e.what() << std::endl;
+		++gFailures;
+	}
+
+	ResourceManager::Finalize();
+	FileSystem::Finalize();
+
+	return ReportChecks();
+}
@@ -0,0 +1,197 @@
+#include <Core/Prerequisites.h>
+#include <Core/Exception.h>
+#include <Core/Timer.h>
+#include <Graphics/AnimationClip.h>
+#include <IO/FileSystem.h>
+#include <IO/FileStream.h>
+#include <Resource/ResourceManager.h>
+#include <random>
+
+using namespace RcEngine;
+
+/**
+ * Key frame lookup of 100 characters playing a 60 bone clip with 10k keys per track at 60 Hz.
+ * Characters play forward, reverse, slow and fast, all looping, and some seek to a random
+ * time every two seconds. Linear scan from the first key, binary search and cursors are timed
+ * over the same times and must find the same keys.
+ */
+
+namespace {
+
+const String ClipDir = "AnimationSamplingBenchmark";
+
+const uint32_t NumCharacters = 100;
+const uint32_t NumBones = 60;
+const uint32_t NumKeys = 10000;
+const float KeyRate = 30.0f;
+
+const uint32_t NumFrames = 240;
+const float FrameTime = 1.0f / 60.0f;
+
+void WriteClip(const String& name)
+{
+	FileStream stream;
+	if (stream.Open(ClipDir + "/" + name, FILE_WRITE) == false)
+		ENGINE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE, "Can't write " + name, "WriteClip");
+
+	const float duration = (NumKeys - 1) / KeyRate;
+
+	stream.WriteFloat(duration);
+	stream.WriteUInt(NumBones);
+
+	// Only key times matter for lookup
+	const float3 translation(0, 0, 0), scale(1, 1, 1);
+	const Quaternionf rotation = Quaternionf::Identity();
+
+	for (uint32_t bone = 0; bone < NumBones; ++bone)
+	{
+		stream.WriteString("Bone" + std::to_string(bone));
+		stream.WriteUInt(NumKeys);
+
+		for (uint32_t key = 0; key < NumKeys; ++key)
+		{
+			stream.WriteFloat(duration * key / (NumKeys - 1));
+			stream.Write(&translation, sizeof(float3));
+			stream.Write(&rotation, sizeof(Quaternionf));
+			stream.Write(&scale, sizeof(float3));
+		}
+	}
+}
+
+// Reference, how tracks were searched before cursors
+int32_t LinearScan(const AnimationClip& clip, uint32_t track, float time)
+{
+	const int32_t numKeys = (int32_t)clip.GetTrack(track).NumKeys;
+
+	int32_t index = 0;
+	while (index < numKeys && clip.GetKeyTime(track, index) < time)
+		index++;
+
+	return (std::max)(0, index-1);
+}
+
+/**
+ * Playback time of every character in every frame.
+ */
+vector<float> MakePlaybackTimes(float duration)
+{
+	const float Rates[] = { 1.0f, -1.0f, 0.5f, 2.0f };
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> seekTime(0.0f, duration);
+
+	vector<float> times(NumFrames * NumCharacters);
+	for (uint32_t character = 0; character < NumCharacters; ++character)
+	{
+		float time = duration * character / NumCharacters;
+		float rate = Rates[character % ARRAY_SIZE(Rates)];
+
+		for (uint32_t frame = 0; frame < NumFrames; ++frame)
+		{
+			if (character % 10 == 0 && frame % 120 == 119)
+			{
+				time = seekTime(random);
+			}
+			else
+			{
+				time = fmodf(time + rate * FrameTime, duration);
+				if (time < 0.0f)
+					time += duration;
+			}
+
+			times[frame * NumCharacters + character] = time;
+		}
+	}
+
+	return times;
+}
+
+void RunBenchmark(const AnimationClip& clip)
+{
+	const vector<float> times = MakePlaybackTimes(clip.GetDuration());
+	const uint32_t numSamples = NumFrames * NumCharacters * NumBones;
+
+	vector<int32_t> reference(numSamples), keys(numSamples);
+	vector<uint32_t> cursors(NumCharacters * NumBones, 0);
+
+	uint64_t start = SystemClock::Now();
+	for (uint32_t frame = 0, sample = 0; frame < NumFrames; ++frame)
+	{
+		for (uint32_t character = 0; character < NumCharacters; ++character)
+		{
+			float time = times[frame * NumCharacters + character];
+			for (uint32_t bone = 0; bone < NumBones; ++bone)
+				reference[sample++] = LinearScan(clip, bone, time);
+		}
+	}
+	double linearTime = SystemClock::ToSeconds(SystemClock::Now() - start);
+
+	start = SystemClock::Now();
+	for (uint32_t frame = 0, sample = 0; frame < NumFrames; ++frame)
+	{
+		for (uint32_t character = 0; character < NumCharacters; ++character)
+		{
+			float time = times[frame * NumCharacters + character];
+			for (uint32_t bone = 0; bone < NumBones; ++bone)
+				keys[sample++] = clip.GetKeyFrameIndex(bone, time);
+		}
+	}
+	double binaryTime = SystemClock::ToSeconds(SystemClock::Now() - start);
+	bool binaryMatch = (keys == reference);
+
+	start = SystemClock::Now();
+	for (uint32_t frame = 0, sample = 0; frame < NumFrames; ++frame)
+	{
+		for (uint32_t character = 0; character < NumCharacters; ++character)
+		{
+			float time = times[frame * NumCharacters + character];
+			uint32_t* characterCursors = &cursors[character * NumBones];
+
+			for (uint32_t bone = 0; bone < NumBones; ++bone)
+				keys[sample++] = clip.GetKeyFrameIndex(bone, time, characterCursors[bone]);
+		}
+	}
+	double cursorTime = SystemClock::ToSeconds(SystemClock::Now() - start);
+	bool cursorMatch = (keys == reference);
+
+	const double toMilliseconds = 1000.0 / NumFrames;
+	std::cout << NumCharacters << " characters x " << NumBones << " bones, " << NumKeys << " keys per track, per frame:" << std::endl;
+	std::cout << "  linear scan:   " << linearTime * toMilliseconds << " ms" << std::endl;
+	std::cout << "  binary search: " << binaryTime * toMilliseconds << " ms" << std::endl;
+	std::cout << "  cursors:       " << cursorTime * toMilliseconds << " ms" << std::endl;
+
+	if (!binaryMatch || !cursorMatch)
+		std::cout << "  keys differ from linear scan!" << std::endl;
+}
+
+}
+
+int main()
+{
+	SystemClock::InitClock();
+	FileSystem::Initialize();
+	ResourceManager::Initialize();
+
+	FileSystem& fileSystem = FileSystem::GetSingleton();
+	fileSystem.CreateDir(ClipDir + "/");
+	fileSystem.RegisterPath(ClipDir, "General");
+
+	try
+	{
+		WriteClip("Long.anim");
+
+		shared_ptr<AnimationClip> clip = std::make_shared<AnimationClip>(ResourceManager::GetSingletonPtr(), 0, "Long.anim", "General");
+		clip->Load();
+
+		RunBenchmark(*clip);
+	}
+	catch (std::exception& e)
+	{
+		std::cout << "FAILED: " << e.what() << std::endl;
+	}
+
+	ResourceManager::Finalize();
+	FileSystem::Finalize();
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <Core/Prerequisites.h>
+#include <Core/CpuInfo.h>
+#include <Core/Timer.h>
+#include <Math/Frustum.h>
+#include <Math/MathUtil.h>
+#include <random>
+
+using namespace RcEngine;
+
+/**
+ * Culling of 1M boxes against a perspective frustum. One Frustum::Contain call per box, how
+ * scene nodes were culled before, is timed against Frustum<float>::VisibleBatch forced to its
+ * scalar, SSE2 and AVX paths. All batch paths must give the same visible mask.
+ */
+
+namespace {
+
+const uint32_t NumBoxes = 1000000;
+const uint32_t NumIterations = 20;
+
+struct CullResult
+{
+	double Milliseconds;
+	uint32_t NumVisible;
+	vector<uint32_t> Mask;
+};
+
+CullResult RunContain(const Frustumf& frustum, const vector<BoundingBoxf>& boxes)
+{
+	CullResult result;
+	result.Mask.resize((NumBoxes + 31) / 32);
+
+	uint64_t start = SystemClock::Now();
+	for (uint32_t iteration = 0; iteration < NumIterations; ++iteration)
+	{
+		std::fill(result.Mask.begin(), result.Mask.end(), 0);
+		result.NumVisible = 0;
+
+		for (uint32_t i = 0; i < NumBoxes; ++i)
+		{
+			if (frustum.Contain(boxes[i]) != CT_Disjoint)
+			{
+				result.Mask[i >> 5] |= (1U << (i & 31));
+				++result.NumVisible;
+			}
+		}
+	}
+	result.Milliseconds = SystemClock::ToSeconds(SystemClock::Now() - start) * 1000.0 / NumIterations;
+
+	return result;
+}
+
+CullResult RunBatch(const Frustumf& frustum, const BoundingBoxSoA<float>& boxes, FrustumCullPath path)
+{
+	CullResult result;
+	result.Mask.resize((NumBoxes + 31) / 32);
+
+	SetFrustumCullPath(path);
+
+	uint64_t start = SystemClock::Now();
+	for (uint32_t iteration = 0; iteration < NumIterations; ++iteration)
+		result.NumVisible = frustum.VisibleBatch(boxes, &result.Mask[0]);
+	result.Milliseconds = SystemClock::ToSeconds(SystemClock::Now() - start) * 1000.0 / NumIterations;
+
+	SetFrustumCullPath(FCP_Auto);
+
+	return result;
+}
+
+void PrintResult(const char* name, const CullResult& result, const CullResult& reference)
+{
+	std::cout << "  " << name << result.Milliseconds << " ms, " << result.NumVisible << " visible, speedup "
+		<< reference.Milliseconds / result.Milliseconds << "x" << std::endl;
+}
+
+}
+
+int main()
+{
+	SystemClock::InitClock();
+
+	Frustumf frustum;
+	frustum.Update(CreateLookAtMatrixLH(float3(0, 50, -500), float3(0, 0, 0), float3(0, 1, 0)) *
+		CreatePerspectiveFovLH(Mathf::PI / 3, 16.0f / 9.0f, 1.0f, 1000.0f));
+
+	// Boxes of a large level, about a quarter of them in view
+	std::mt19937 random(99);
+	std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+	std::uniform_real_distribution<float> size(0.5f, 10.0f);
+
+	vector<BoundingBoxf> boxes(NumBoxes);
+	vector<float> cullData(NumBoxes * 6);
+	for (uint32_t i = 0; i < NumBoxes; ++i)
+	{
+		float3 center(position(random), position(random) * 0.1f, position(random));
+		float3 extent(size(random), size(random), size(random));
+		boxes[i] = BoundingBoxf(center - extent, center + extent);
+
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			cullData[i + NumBoxes * k] = center[k];
+			cullData[i + NumBoxes * (k + 3)] = extent[k];
+		}
+	}
+
+	float* streams = &cullData[0];
+	BoundingBoxSoA<float> boxStreams = { streams, streams + NumBoxes, streams + NumBoxes * 2,
+		streams + NumBoxes * 3, streams + NumBoxes * 4, streams + NumBoxes * 5, NumBoxes };
+
+	std::cout << NumBoxes << " boxes, SSE2 " << CpuInfo::HasSSE2() << ", AVX " << CpuInfo::HasAVX() << std::endl;
+
+	CullResult contain = RunContain(frustum, boxes);
+	CullResult scalar = RunBatch(frustum, boxStreams, FCP_Scalar);
+	CullResult sse2 = RunBatch(frustum, boxStreams, FCP_SSE2);
+	CullResult avx = RunBatch(frustum, boxStreams, FCP_AVX);
+
+	PrintResult("Contain per box: ", contain, contain);
+	PrintResult("batch scalar:    ", scalar, contain);
+	PrintResult("batch SSE2:      ", sse2, contain);
+	PrintResult("batch AVX:       ", avx, contain);
+
+	if (sse2.Mask != scalar.Mask || avx.Mask != scalar.Mask)
+		std::cout << "  batch paths differ!" << std::endl;
+
+	return 0;
+}
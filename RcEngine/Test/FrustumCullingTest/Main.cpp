@@ -0,0 +1,243 @@
+#include <Core/Prerequisites.h>
+#include <Math/Frustum.h>
+#include <Math/MathUtil.h>
+#include <random>
+#include "../TestCheck.h"
+
+using namespace RcEngine;
+
+/**
+ * Frustum<float>::VisibleBatch runs AVX and SSE2 blocks with a scalar tail. Every box is culled
+ * again alone, which only runs the scalar kernel, and in windows of 4 and 8 boxes, which run
+ * a single SSE2 or AVX block, and with each code path forced. Results must be identical bit
+ * for bit. Away from plane boundaries the result must also match Frustum::Contain.
+ */
+
+namespace {
+
+// Boxes closer to a plane may be rounded differently by Contain, which tests min/max corners
+const double BoundaryMargin = 0.01;
+
+struct BoxStreams
+{
+	vector<float> CenterX, CenterY, CenterZ;
+	vector<float> ExtentX, ExtentY, ExtentZ;
+
+	void Add(const float3& center, const float3& extent)
+	{
+		CenterX.push_back(center.X()); CenterY.push_back(center.Y()); CenterZ.push_back(center.Z());
+		ExtentX.push_back(extent.X()); ExtentY.push_back(extent.Y()); ExtentZ.push_back(extent.Z());
+	}
+
+	uint32_t Size() const { return CenterX.size(); }
+
+	BoundingBoxSoA<float> View(uint32_t first, uint32_t count) const
+	{
+		BoundingBoxSoA<float> boxes;
+		boxes.CenterX = &CenterX[first]; boxes.CenterY = &CenterY[first]; boxes.CenterZ = &CenterZ[first];
+		boxes.ExtentX = &ExtentX[first]; boxes.ExtentY = &ExtentY[first]; boxes.ExtentZ = &ExtentZ[first];
+		boxes.Count = count;
+		return boxes;
+	}
+};
+
+inline bool IsVisible(const vector<uint32_t>& mask, uint32_t i)
+{
+	return (mask[i >> 5] & (1U << (i & 31))) != 0;
+}
+
+/**
+ * Smallest distance of box's positive vertex to a frustum plane, in double.
+ */
+double BoundaryDistance(const Frustumf& frustum, const BoxStreams& boxes, uint32_t i)
+{
+	double distance = DBL_MAX;
+	for (const Planef& plane : frustum.Planes)
+	{
+		double d = double(plane.Normal.X()) * boxes.CenterX[i] + double(plane.Normal.Y()) * boxes.CenterY[i] + double(plane.Normal.Z()) * boxes.CenterZ[i];
+		d += fabs(double(plane.Normal.X())) * boxes.ExtentX[i] + fabs(double(plane.Normal.Y())) * boxes.ExtentY[i] + fabs(double(plane.Normal.Z())) * boxes.ExtentZ[i];
+		distance = (std::min)(distance, fabs(d + plane.Distance));
+	}
+	return distance;
+}
+
+void CheckBatch(const char* name, const Frustumf& frustum, const BoxStreams& boxes)
+{
+	const uint32_t numBoxes = boxes.Size();
+
+	vector<uint32_t> mask((numBoxes + 31) / 32, 0xFFFFFFFF);
+	vector<uint32_t> indices(numBoxes);
+	uint32_t numVisible = frustum.VisibleBatch(boxes.View(0, numBoxes), &mask[0], &indices[0]);
+
+	// Mask only version counts the same
+	vector<uint32_t> maskOnly(mask.size());
+	CHECK(frustum.VisibleBatch(boxes.View(0, numBoxes), &maskOnly[0]) == numVisible);
+	CHECK(maskOnly == mask);
+
+	// Every forced code path gives the same mask
+	const FrustumCullPath paths[] = { FCP_Scalar, FCP_SSE2, FCP_AVX };
+	for (FrustumCullPath path : paths)
+	{
+		vector<uint32_t> pathMask(mask.size());
+		SetFrustumCullPath(path);
+		CHECK(frustum.VisibleBatch(boxes.View(0, numBoxes), &pathMask[0]) == numVisible);
+		CHECK(pathMask == mask);
+	}
+	SetFrustumCullPath(FCP_Auto);
+
+	// Indices ascending and match mask
+	uint32_t numBits = 0;
+	for (uint32_t i = 0; i < numBoxes; ++i)
+		numBits += IsVisible(mask, i) ? 1 : 0;
+	CHECK(numBits == numVisible);
+
+	bool indicesMatch = true;
+	for (uint32_t i = 0; i < numVisible; ++i)
+		indicesMatch &= IsVisible(mask, indices[i]) && (i == 0 || indices[i - 1] < indices[i]);
+	CHECK(indicesMatch);
+
+	// Bits past Count are cleared
+	if (numBoxes & 31)
+		CHECK((mask.back() >> (numBoxes & 31)) == 0);
+
+	uint32_t scalarMismatches = 0, blockMismatches = 0, containMismatches = 0, numBoundary = 0;
+	for (uint32_t i = 0; i < numBoxes; ++i)
+	{
+		uint32_t single = 0;
+		frustum.VisibleBatch(boxes.View(i, 1), &single);
+		if ((single != 0) != IsVisible(mask, i))
+			++scalarMismatches;
+
+		if (BoundaryDistance(frustum, boxes, i) > BoundaryMargin)
+		{
+			BoundingBoxf box(float3(boxes.CenterX[i] - boxes.ExtentX[i], boxes.CenterY[i] - boxes.ExtentY[i], boxes.CenterZ[i] - boxes.ExtentZ[i]),
+							 float3(boxes.CenterX[i] + boxes.ExtentX[i], boxes.CenterY[i] + boxes.ExtentY[i], boxes.CenterZ[i] + boxes.ExtentZ[i]));
+
+			if ((frustum.Contain(box) != CT_Disjoint) != IsVisible(mask, i))
+				++containMismatches;
+		}
+		else
+			++numBoundary;
+	}
+
+	for (uint32_t blockSize = 4; blockSize <= 8; blockSize += 4)
+	{
+		for (uint32_t first = 0; first + blockSize <= numBoxes; first += blockSize)
+		{
+			uint32_t block = 0;
+			frustum.VisibleBatch(boxes.View(first, blockSize), &block);
+
+			for (uint32_t i = 0; i < blockSize; ++i)
+			{
+				if (((block >> i) & 1) != (IsVisible(mask, first + i) ? 1U : 0U))
+					++blockMismatches;
+			}
+		}
+	}
+
+	CHECK(scalarMismatches == 0);
+	CHECK(blockMismatches == 0);
+	CHECK(containMismatches == 0);
+
+	std::cout << name << ": " << numVisible << " of " << numBoxes << " visible, " << numBoundary << " on plane boundaries" << std::endl;
+}
+
+void TestPerspective()
+{
+	Frustumf frustum;
+	frustum.Update(CreateLookAtMatrixLH(float3(5, 3, -20), float3(0, 0, 0), float3(0, 1, 0)) *
+		CreatePerspectiveFovLH(Mathf::PI / 4, 16.0f / 9.0f, 1.0f, 500.0f));
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-300.0f, 300.0f);
+	std::uniform_real_distribution<float> size(0.0f, 20.0f);
+
+	// Odd count, so SIMD blocks are followed by a scalar tail
+	BoxStreams boxes;
+	for (uint32_t i = 0; i < 100003; ++i)
+	{
+		float3 center(position(random), position(random), position(random));
+		float3 extent(size(random), size(random), size(random));
+
+		switch (i % 16)
+		{
+		case 0: extent = float3(0, 0, 0); break;					// Points
+		case 1: extent = float3(1000, 1000, 1000); break;			// Contains frustum
+		case 2: extent.Y() = 0; break;								// Flat
+		}
+
+		boxes.Add(center, extent);
+	}
+
+	CheckBatch("Perspective", frustum, boxes);
+}
+
+void TestOrtho()
+{
+	// Integer box coordinates on planes of an ortho frustum hit exact ties
+	Frustumf frustum;
+	frustum.Update(CreateOrthoOffCenterLH(-10.0f, 10.0f, -10.0f, 10.0f, 0.0f, 100.0f));
+
+	BoxStreams boxes;
+	const float extents[] = { 0.0f, 1.0f, 2.0f, 4.0f };
+	for (int32_t x = -14; x <= 14; ++x)
+	{
+		for (int32_t y = -14; y <= 14; y += 2)
+		{
+			for (int32_t z = -5; z <= 105; z += 5)
+			{
+				float extent = extents[(x + y + z + 100) % 4];
+				boxes.Add(float3(float(x), float(y), float(z)), float3(extent, extent, extent));
+			}
+		}
+	}
+
+	CheckBatch("Ortho", frustum, boxes);
+}
+
+void TestSmallBatches()
+{
+	Frustumf frustum;
+	frustum.Update(CreatePerspectiveFovLH(Mathf::PI / 2, 1.0f, 1.0f, 100.0f));
+
+	BoxStreams boxes;
+	for (uint32_t i = 0; i < 40; ++i)
+		boxes.Add(float3(float(i) * 2.0f - 40.0f, 0.0f, 30.0f), float3(0.5f, 0.5f, 0.5f));
+
+	// Every count up to a mask word and a bit, mixes AVX, SSE2 and scalar
+	for (uint32_t count = 0; count <= 33; ++count)
+	{
+		uint32_t mask[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+		uint32_t indices[33];
+		uint32_t numVisible = frustum.VisibleBatch(boxes.View(0, count), mask, indices);
+
+		uint32_t expected = 0;
+		bool match = true;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			uint32_t single = 0;
+			frustum.VisibleBatch(boxes.View(i, 1), &single);
+
+			bool visible = (mask[i >> 5] & (1U << (i & 31))) != 0;
+			match &= (visible == (single != 0));
+			if (single)
+				match &= (indices[expected++] == i);
+		}
+
+		CHECK(match && numVisible == expected);
+
+		// Only (count + 31) / 32 mask words are written
+		CHECK(count > 32 || mask[1] == 0xFFFFFFFF);
+	}
+}
+
+}
+
+int main()
+{
+	TestPerspective();
+	TestOrtho();
+	TestSmallBatches();
+
+	return ReportChecks();
+}
@@ -0,0 +1,195 @@
+#include <Core/Prerequisites.h>
+#include <Core/Exception.h>
+#include <Graphics/GLSLPreprocessor.h>
+#include <Graphics/GraphicsResource.h>
+#include <IO/FileSystem.h>
+#include <IO/FileStream.h>
+#include "../TestCheck.h"
+
+using namespace RcEngine;
+
+/**
+ * GLSLPreprocessor runs without a GL context, shader files are written to a scratch
+ * directory registered to General group and the preprocessed stages are checked.
+ */
+
+namespace {
+
+const String ShaderDir = "GLSLPreprocessorTest";
+const String DefaultVersion = "#version 330";
+
+void WriteShaderFile(const String& name, const String& text)
+{
+	FileStream stream;
+	if (stream.Open(ShaderDir + "/" + name, FILE_WRITE) == false)
+		ENGINE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE, "Can't write " + name, "WriteShaderFile");
+
+	stream.Write(text.c_str(), uint32_t(text.length()));
+}
+
+inline bool Contains(const String& text, const String& part)
+{
+	return text.find(part) != String::npos;
+}
+
+void Preprocess(const String& name, ShaderType stage, const String& entryPoint, GLSLSource& result,
+	const ShaderMacro* macros = nullptr, uint32_t macroCount = 0)
+{
+	GLSLPreprocessor::Preprocess(name, stage, macros, macroCount, entryPoint, DefaultVersion, result);
+}
+
+const char* UtilGLSL =
+	"#pragma NoiseMap : PointSampler\n"
+	"float Saturate(float x) { return clamp(x, 0.0, 1.0); }\n";
+
+const char* CommonGLSL =
+	"#include \"/Util.glsl\"\n"
+	"#pragma DiffuseMap : LinearSampler\n"
+	"uniform sampler2D DiffuseMap;\n";
+
+const char* SectionGLSL =
+	"[[Vertex=MainVS]]\n"
+	"#version 430\n"
+	"void main() { gl_Position = vec4(0.0); }\n"
+	"\n"
+	"[[Fragment=MainPS]]\n"
+	"#include \"/Common.glsl\"\n"
+	"#pragma SpecularMap : MaterialSampler\n"
+	"out vec4 FragColor;\n"
+	"void main() { FragColor = texture(DiffuseMap, vec2(0.0)); }\n"
+	"\n"
+	"[[Fragment=OtherPS]]\n"
+	"void main() {}\n";
+
+const char* PlainGLSL =
+	"uniform mat4 World;\n"
+	"void main() {}\n";
+
+void TestSections()
+{
+	GLSLSource vs;
+	Preprocess("Section.glsl", ST_Vertex, "MainVS", vs);
+
+	// Own #version replaces the default one, section text only
+	CHECK(vs.Source.compare(0, 13, "#version 430\n") == 0);
+	CHECK(!Contains(vs.Source, DefaultVersion));
+	CHECK(Contains(vs.Source, "gl_Position"));
+	CHECK(!Contains(vs.Source, "FragColor") && !Contains(vs.Source, "[["));
+	CHECK(vs.Includes.empty() && vs.SamplerStates.empty() && vs.IncludeHash == 0);
+
+	GLSLSource ps;
+	Preprocess("Section.glsl", ST_Pixel, "OtherPS", ps);
+	CHECK(ps.Source.compare(0, DefaultVersion.length(), DefaultVersion) == 0);
+	CHECK(!Contains(ps.Source, "gl_Position") && !Contains(ps.Source, "FragColor"));
+
+	GLSLSource plain;
+	Preprocess("Plain.glsl", ST_Pixel, "AnyPS", plain);
+	CHECK(Contains(plain.Source, "uniform mat4 World;"));
+
+	bool thrown = false;
+	try
+	{
+		GLSLSource missing;
+		Preprocess("Section.glsl", ST_Pixel, "MissingPS", missing);
+	}
+	catch (Exception&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+}
+
+void TestMacrosAndIncludes()
+{
+	ShaderMacro macros[2];
+	macros[0].Name = "NUM_LIGHTS";
+	macros[0].Definition = "4";
+	macros[1].Name = "USE_SHADOW";
+	macros[1].Definition = "1";
+
+	GLSLSource ps;
+	Preprocess("Section.glsl", ST_Pixel, "MainPS", ps, macros, 2);
+
+	CHECK(Contains(ps.Source, "#extension GL_ARB_shading_language_include : enable\n"));
+	CHECK(Contains(ps.Source, "#define NUM_LIGHTS 4\n") && Contains(ps.Source, "#define USE_SHADOW 1\n"));
+
+	// Include directives stay, the text is registered as named string by OpenGL render system
+	CHECK(Contains(ps.Source, "#include \"/Common.glsl\""));
+
+	// Nested include first
+	CHECK(ps.Includes.size() == 2 && ps.Includes[0] == "/Util.glsl" && ps.Includes[1] == "/Common.glsl");
+	CHECK(GLSLPreprocessor::GetIncludeSource("/Common.glsl") == CommonGLSL);
+	CHECK(GLSLPreprocessor::GetIncludeSource("/Util.glsl") == UtilGLSL);
+
+	// Sampler states of the section and of nested includes
+	CHECK(ps.SamplerStates.size() == 3);
+	CHECK(ps.SamplerStates["SpecularMap"] == "MaterialSampler");
+	CHECK(ps.SamplerStates["DiffuseMap"] == "LinearSampler");
+	CHECK(ps.SamplerStates["NoiseMap"] == "PointSampler");
+	CHECK(ps.IncludeHash != 0);
+
+	// Loose files are listed for hot reload
+	vector<String> files;
+	GLSLPreprocessor::GetSourceFiles("Section.glsl", ps, files);
+	CHECK(files.size() == 3 && files[0] == ShaderDir + "/Section.glsl");
+	CHECK(files[1] == ShaderDir + "/Util.glsl" && files[2] == ShaderDir + "/Common.glsl");
+}
+
+void TestIncludeCache()
+{
+	GLSLSource before;
+	Preprocess("Section.glsl", ST_Pixel, "MainPS", before);
+
+	// Cached include is used until the cache is cleared
+	WriteShaderFile("Util.glsl", String(UtilGLSL) + "float Extra;\n");
+
+	GLSLSource cached;
+	Preprocess("Section.glsl", ST_Pixel, "MainPS", cached);
+	CHECK(cached.IncludeHash == before.IncludeHash);
+	CHECK(GLSLPreprocessor::GetIncludeSource("/Util.glsl") == UtilGLSL);
+
+	// Change of a nested include changes hash of shaders including it
+	GLSLPreprocessor::ClearIncludeCache();
+
+	GLSLSource changed;
+	Preprocess("Section.glsl", ST_Pixel, "MainPS", changed);
+	CHECK(changed.IncludeHash != before.IncludeHash);
+	CHECK(Contains(GLSLPreprocessor::GetIncludeSource("/Util.glsl"), "float Extra;"));
+
+	WriteShaderFile("Util.glsl", UtilGLSL);
+	GLSLPreprocessor::ClearIncludeCache();
+
+	GLSLSource restored;
+	Preprocess("Section.glsl", ST_Pixel, "MainPS", restored);
+	CHECK(restored.IncludeHash == before.IncludeHash);
+}
+
+}
+
+int main()
+{
+	FileSystem::Initialize();
+	FileSystem::GetSingleton().CreateDir(ShaderDir + "/");
+	FileSystem::GetSingleton().RegisterPath(ShaderDir, "General");
+
+	try
+	{
+		WriteShaderFile("Util.glsl", UtilGLSL);
+		WriteShaderFile("Common.glsl", CommonGLSL);
+		WriteShaderFile("Section.glsl", SectionGLSL);
+		WriteShaderFile("Plain.glsl", PlainGLSL);
+
+		TestSections();
+		TestMacrosAndIncludes();
+		TestIncludeCache();
+	}
+	catch (std::exception& e)
+	{
+		std::cout << "FAILED: " << e.what() << std::endl;
+		++gFailures;
+	}
+
+	FileSystem::Finalize();
+
+	return ReportChecks();
+}
@@ -0,0 +1,356 @@
+#include <MainApp/Application.h>
+#include <Core/Environment.h>
+#include <Core/Exception.h>
+#include <Graphics/InstanceBatcher.h>
+#include <Graphics/Renderable.h>
+#include <Graphics/RenderOperation.h>
+#include <Graphics/Material.h>
+#include <Graphics/Camera.h>
+#include <Graphics/VertexDeclaration.h>
+#include <Scene/SceneManager.h>
+#include <Scene/SceneNode.h>
+#include <Scene/Entity.h>
+#include <IO/FileSystem.h>
+#include <IO/FileStream.h>
+#include <Resource/ResourceManager.h>
+#include "../TestCheck.h"
+
+using namespace RcEngine;
+
+/**
+ * InstanceBatcher::BuildBatches runs on the CPU only, renderables with test materials and
+ * render operations are batched without a render device. Last test fills the queue from
+ * entities through SceneManager::UpdateRenderQueue on the null device, so batches depend
+ * on the sort keys the scene gives.
+ */
+
+namespace {
+
+class TestMaterial : public Material
+{
+public:
+	TestMaterial(bool instancing)
+		: Material(nullptr, 0, "TestMaterial", "General")
+	{
+		mInstancing = instancing;
+	}
+};
+
+class TestRenderable : public Renderable
+{
+public:
+	TestRenderable(const shared_ptr<Material>& material, const shared_ptr<RenderOperation>& operation, float x, uint32_t numTransforms = 1)
+		: mMaterial(material), mOperation(operation), mNumTransforms(numTransforms)
+	{
+		mWorld = float4x4::Identity();
+		mWorld.M41 = x;
+	}
+
+	const shared_ptr<Material>& GetMaterial() const					{ return mMaterial; }
+	const shared_ptr<RenderOperation>& GetRenderOperation() const	{ return mOperation; }
+	uint32_t GetWorldTransformsCount() const						{ return mNumTransforms; }
+
+	void GetWorldTransforms(float4x4* xform) const
+	{
+		// Skin matrices first, world transform last
+		for (uint32_t i = 0; i < mNumTransforms; ++i)
+			xform[i] = mWorld;
+	}
+
+private:
+	shared_ptr<Material> mMaterial;
+	shared_ptr<RenderOperation> mOperation;
+	float4x4 mWorld;
+	uint32_t mNumTransforms;
+};
+
+shared_ptr<RenderOperation> MakeOperation(uint32_t vertexStart)
+{
+	shared_ptr<RenderOperation> operation = std::make_shared<RenderOperation>();
+	operation->PrimitiveType = PT_Triangle_List;
+	operation->SetVertexRange(vertexStart, 36);
+	return operation;
+}
+
+void TestMixedBucket()
+{
+	shared_ptr<Material> instanced = std::make_shared<TestMaterial>(true);
+	shared_ptr<Material> otherInstanced = std::make_shared<TestMaterial>(true);
+	shared_ptr<Material> plain = std::make_shared<TestMaterial>(false);
+
+	shared_ptr<RenderOperation> box = MakeOperation(0);
+	shared_ptr<RenderOperation> sameBox = MakeOperation(0);		// Other object, same geometry
+	shared_ptr<RenderOperation> sphere = MakeOperation(36);
+
+	vector<shared_ptr<TestRenderable> > renderables;
+	renderables.push_back(std::make_shared<TestRenderable>(instanced, box, 0.0f));
+	renderables.push_back(std::make_shared<TestRenderable>(instanced, sameBox, 1.0f));
+	renderables.push_back(std::make_shared<TestRenderable>(instanced, box, 2.0f));
+	renderables.push_back(std::make_shared<TestRenderable>(instanced, sphere, 3.0f));			// other geometry
+	renderables.push_back(std::make_shared<TestRenderable>(otherInstanced, sphere, 4.0f));		// other material
+	renderables.push_back(std::make_shared<TestRenderable>(otherInstanced, sphere, 5.0f));
+	renderables.push_back(std::make_shared<TestRenderable>(instanced, sphere, 6.0f, 3));		// skinned
+	renderables.push_back(std::make_shared<TestRenderable>(plain, box, 7.0f));
+	renderables.push_back(std::make_shared<TestRenderable>(plain, box, 8.0f));
+	renderables.push_back(std::make_shared<TestRenderable>(instanced, box, 9.0f));				// not adjacent to first run
+	renderables.push_back(std::make_shared<TestRenderable>(instanced, box, 10.0f));
+
+	RenderBucket bucket;
+	for (size_t i = 0; i < renderables.size(); ++i)
+		bucket.push_back(RenderQueueItem(renderables[i].get(), i));
+
+	InstanceBatcher batcher;
+	batcher.BuildBatches(bucket);
+
+	const vector<InstanceBatch>& batches = batcher.GetBatches();
+	CHECK(batches.size() == 7);
+	if (batches.size() != 7)
+		return;
+
+	const uint32_t expectedItems[] = { 3, 1, 2, 1, 1, 1, 2 };
+	const bool expectedInstanced[] = { true, true, true, false, false, false, true };
+
+	uint32_t item = 0, instance = 0;
+	for (size_t i = 0; i < batches.size(); ++i)
+	{
+		CHECK(batches[i].Items == &bucket[item]);
+		CHECK(batches[i].NumItems == expectedItems[i]);
+		CHECK(batches[i].Instanced == expectedInstanced[i]);
+
+		if (batches[i].Instanced)
+		{
+			CHECK(batches[i].InstanceStart == instance);
+			instance += batches[i].NumItems;
+		}
+		item += batches[i].NumItems;
+	}
+	CHECK(item == bucket.size());
+
+	// World matrices of instanced items, in queue order
+	const vector<float4x4>& transforms = batcher.GetInstanceTransforms();
+	const float expectedX[] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 9.0f, 10.0f };
+	CHECK(transforms.size() == 8);
+	for (size_t i = 0; i < transforms.size() && i < 8; ++i)
+		CHECK(transforms[i].M41 == expectedX[i] && transforms[i].M44 == 1.0f);
+}
+
+void TestManyCopies()
+{
+	shared_ptr<Material> instanced = std::make_shared<TestMaterial>(true);
+	shared_ptr<RenderOperation> box = MakeOperation(0);
+
+	const uint32_t NumCopies = 10000;
+
+	vector<shared_ptr<TestRenderable> > renderables;
+	RenderBucket bucket;
+	for (uint32_t i = 0; i < NumCopies; ++i)
+	{
+		renderables.push_back(std::make_shared<TestRenderable>(instanced, box, float(i)));
+		bucket.push_back(RenderQueueItem(renderables.back().get(), 0));
+	}
+
+	// One draw call for all copies, rebuilt each frame
+	InstanceBatcher batcher;
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		batcher.BuildBatches(bucket);
+		CHECK(batcher.GetBatches().size() == 1);
+		CHECK(batcher.GetBatches()[0].NumItems == NumCopies && batcher.GetBatches()[0].Instanced);
+		CHECK(batcher.GetInstanceTransforms().size() == NumCopies);
+		CHECK(batcher.GetInstanceTransforms().back().M41 == float(NumCopies - 1));
+	}
+
+	// Empty bucket
+	batcher.BuildBatches(RenderBucket());
+	CHECK(batcher.GetBatches().empty() && batcher.GetInstanceTransforms().empty());
+}
+
+const String SceneDir = "InstanceBatcherTest";
+
+// Material of scene entities, instanced without an effect so nothing is compiled
+class SceneMaterial : public Material
+{
+public:
+	SceneMaterial(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group)
+		: Material(creator, handle, name, group)
+	{
+		mMaterialName = name;
+		mQueueBucket = RenderQueue::BucketOpaque;
+		mInstancing = true;
+	}
+
+	static shared_ptr<Resource> FactoryFunc(ResourceManager* creator, ResourceHandle handle, const String& name, const String& group)
+	{
+		return std::make_shared<SceneMaterial>(creator, handle, name, group);
+	}
+
+protected:
+	void PrepareImpl()		{ }
+	void LoadImpl()			{ }
+	void UnloadImpl()		{ }
+};
+
+// Mesh of one non-indexed triangle, material file only has to exist
+void WriteMesh(const String& name, const String& materialName, float size)
+{
+	FileStream stream;
+	if (stream.Open(SceneDir + "/" + name, FILE_WRITE) == false)
+		ENGINE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE, "Can't write " + name, "WriteMesh");
+
+	const float3 vertices[] = { float3(0, 0, 0), float3(size, 0, 0), float3(0, size, 0) };
+	const float3 min(0, 0, 0), max(size, size, 0);
+
+	stream.WriteUInt(('M' << 24) | ('E' << 16) | ('S' << 8) | ('H'));
+	stream.WriteString(name);
+	stream.Write(&min, sizeof(float3));
+	stream.Write(&max, sizeof(float3));
+	stream.WriteUInt(1);			// mesh parts
+	stream.WriteUInt(0);			// bones
+	stream.WriteUInt(1);			// vertex buffers
+	stream.WriteUInt(0);			// index buffers
+
+	stream.WriteString(name);
+	stream.WriteString(materialName);
+	stream.Write(&min, sizeof(float3));
+	stream.Write(&max, sizeof(float3));
+	stream.WriteInt(0);				// vertex buffer
+	stream.WriteInt(-1);			// index buffer
+	stream.WriteUInt(0);			// index start
+	stream.WriteUInt(0);			// index count
+	stream.WriteInt(0);				// base vertex
+
+	stream.WriteUInt(ARRAY_SIZE(vertices));
+	stream.WriteUInt(1);
+	stream.WriteUInt(0);
+	stream.WriteUInt(VEF_Float3);
+	stream.WriteUInt(VEU_Position);
+	stream.WriteUShort(0);
+	stream.Write(vertices, sizeof(vertices));
+
+	FileStream material;
+	if (material.Open(SceneDir + "/" + materialName, FILE_WRITE) == false)
+		ENGINE_EXCEPT(Exception::ERR_CANNOT_WRITE_TO_FILE, "Can't write " + materialName, "WriteMesh");
+	material.WriteString(materialName);
+}
+
+class SceneBatchingApp : public Application
+{
+public:
+	SceneBatchingApp(const String& config)
+		: Application(config)
+	{
+		mAppSettings.RHDeviceType = RD_Null;
+	}
+
+protected:
+	void Initialize()
+	{
+		mCamera = std::make_shared<Camera>();
+		mCamera->CreateLookAt(float3(0, 0, -20), float3(0, 0, 0));
+		mCamera->CreatePerspectiveFov(Mathf::PI/4, 1.0f, 1.0f, 1000.0f);
+	}
+
+	void LoadContent()
+	{
+		ResourceManager& resMan = ResourceManager::GetSingleton();
+		FileSystem& fileSystem = FileSystem::GetSingleton();
+
+		fileSystem.CreateDir(SceneDir + "/");
+		fileSystem.RegisterPath(SceneDir, "General");
+		resMan.RegisterType(RT_Material, "Material", SceneMaterial::FactoryFunc);
+
+		try
+		{
+			WriteMesh("RedBox.mesh", "Red.material.xml", 1.0f);
+			WriteMesh("BlueBox.mesh", "Blue.material.xml", 1.0f);
+			WriteMesh("RedSphere.mesh", "Red.material.xml", 2.0f);
+
+			TestSceneQueue();
+		}
+		catch (std::exception& e)
+		{
+			std::cout << "FAILED: " << e.what() << std::endl;
+			++gFailures;
+		}
+
+		resMan.RegisterType(RT_Material, "Material", Material::FactoryFunc);
+	}
+
+	void UnloadContent()
+	{
+
+	}
+
+	void Update(float deltaTime)
+	{
+		mEndGame = true;
+	}
+
+	void Render()
+	{
+
+	}
+
+	void TestSceneQueue()
+	{
+		const char* meshes[] = { "RedBox.mesh", "BlueBox.mesh", "RedSphere.mesh" };
+		const uint32_t NumEntities = 30;
+
+		SceneManager& sceneMan = *Environment::GetSingleton().GetSceneManager();
+		SceneNode* root = sceneMan.GetRootSceneNode();
+
+		// Scene order interleaves materials and meshes, every item differs from the one before
+		for (uint32_t i = 0; i < NumEntities; ++i)
+		{
+			String name = "Entity" + std::to_string(i);
+			Entity* entity = sceneMan.CreateEntity(name, meshes[i % ARRAY_SIZE(meshes)], "General");
+
+			SceneNode* node = root->CreateChildSceneNode(name, float3(float(i % 6) - 3.0f, float(i / 6) - 3.0f, 0.0f));
+			node->AttachObject(entity);
+		}
+		sceneMan.UpdateSceneGraph(0.0f);
+
+		for (int spatialCulling = 0; spatialCulling < 2; ++spatialCulling)
+		{
+			sceneMan.SetSpatialCulling(spatialCulling != 0);
+			sceneMan.UpdateRenderQueue(mCamera, RO_None, RenderQueue::BucketOpaque, 0);
+
+			RenderQueue& renderQueue = sceneMan.GetRenderQueue();
+
+			// Tree query visits objects in its own order, only recursion keeps scene order
+			InstanceBatcher batcher;
+			if (spatialCulling == 0)
+			{
+				batcher.BuildBatches(renderQueue.GetRenderBucket(RenderQueue::BucketOpaque, false));
+				CHECK(batcher.GetBatches().size() == NumEntities);
+			}
+
+			// One instanced draw per material and mesh once the bucket is sorted
+			batcher.BuildBatches(renderQueue.GetRenderBucket(RenderQueue::BucketOpaque));
+			const vector<InstanceBatch>& batches = batcher.GetBatches();
+			CHECK(batches.size() == ARRAY_SIZE(meshes));
+
+			for (const InstanceBatch& batch : batches)
+				CHECK(batch.Instanced && batch.NumItems == NumEntities / ARRAY_SIZE(meshes));
+			CHECK(batcher.GetInstanceTransforms().size() == NumEntities);
+		}
+	}
+
+private:
+	shared_ptr<Camera> mCamera;
+};
+
+}
+
+int main()
+{
+	TestMixedBucket();
+	TestManyCopies();
+
+	SceneBatchingApp app("../Config.xml");
+	app.Create();
+	app.RunGame();
+	app.Release();
+
+	return ReportChecks();
+}
@@ -0,0 +1,228 @@
+#include <MainApp/Application.h>
+#include <Core/Environment.h>
+#include <Core/FrameAllocator.h>
+#include <Core/MemoryHook.h>
+#include <Graphics/RenderDevice.h>
+#include <Graphics/RenderFactory.h>
+#include <Graphics/RenderOperation.h>
+#include <Graphics/RenderQueue.h>
+#include <Graphics/Renderable.h>
+#include <Graphics/InstanceBatcher.h>
+#include <Graphics/FrameBuffer.h>
+#include <Graphics/Material.h>
+#include <Graphics/Camera.h>
+#include <Graphics/VertexDeclaration.h>
+#include <Resource/ResourceManager.h>
+#include <atomic>
+#include "../TestCheck.h"
+
+// Allocations of the test itself are counted too
+#ifndef BUILD_STATIC
+#include <Core/MemoryHook.inl>
+#endif
+
+using namespace RcEngine;
+
+/**
+ * Runs the render loop headless on the null device and counts heap allocations of every
+ * module from queue build to swap. Once the warm up frames have grown frame allocator,
+ * render queue and batcher, a frame must not touch the heap.
+ */
+
+namespace {
+
+const uint32_t NumRenderables = 400;
+const uint32_t NumSkinMatrices = 64;
+const uint32_t NumWarmupFrames = 10;
+const uint32_t NumCountedFrames = 100;
+
+std::atomic<uint32_t> gNumAllocations(0);
+
+void CountAllocation(size_t size)
+{
+	++gNumAllocations;
+}
+
+class TestRenderable : public Renderable
+{
+public:
+	TestRenderable(const shared_ptr<Material>& material, const shared_ptr<RenderOperation>& operation, float x, uint32_t numTransforms)
+		: mMaterial(material), mOperation(operation), mNumTransforms(numTransforms)
+	{
+		mWorld = float4x4::Identity();
+		mWorld.M41 = x;
+	}
+
+	const shared_ptr<Material>& GetMaterial() const					{ return mMaterial; }
+	const shared_ptr<RenderOperation>& GetRenderOperation() const	{ return mOperation; }
+	uint32_t GetWorldTransformsCount() const						{ return mNumTransforms; }
+
+	void GetWorldTransforms(float4x4* xform) const
+	{
+		// Skin matrices first, world transform last
+		for (uint32_t i = 0; i < mNumTransforms; ++i)
+			xform[i] = mWorld;
+	}
+
+	void SetHeight(float y)		{ mWorld.M42 = y; }
+	float GetDepth() const		{ return mWorld.M41; }
+
+private:
+	shared_ptr<Material> mMaterial;
+	shared_ptr<RenderOperation> mOperation;
+	float4x4 mWorld;
+	uint32_t mNumTransforms;
+};
+
+class RenderAllocationApp : public Application
+{
+public:
+	RenderAllocationApp(const String& config)
+		: Application(config),
+		  mFrame(0),
+		  mNumOverflows(0)
+	{
+		mAppSettings.RHDeviceType = RD_Null;
+	}
+
+	uint32_t GetNumOverflows() const	{ return mNumOverflows; }
+
+protected:
+	void Initialize()
+	{
+		mCamera = std::make_shared<Camera>();
+		mCamera->CreateLookAt(float3(-10, 0, 0), float3(0, 0, 0));
+		mCamera->CreatePerspectiveFov(Mathf::PI/4, 1.0f, 1.0f, 1000.0f);
+
+		RenderDevice* device = Environment::GetSingleton().GetRenderDevice();
+		device->GetScreenFrameBuffer()->SetCamera(mCamera);
+	}
+
+	void LoadContent()
+	{
+		RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
+
+		shared_ptr<Material> material = ResourceManager::GetSingleton().GetResourceByName<Material>(RT_Material, "DebugView.material.xml", "General");
+
+		// Two triangles, each object draws one of them
+		const float3 vertices[] = {
+			float3(0, 0, 0), float3(1, 0, 0), float3(0, 1, 0),
+			float3(0, 0, 1), float3(1, 0, 1), float3(0, 1, 1)
+		};
+
+		ElementInitData initData;
+		initData.pData = vertices;
+		initData.rowPitch = sizeof(vertices);
+		initData.slicePitch = 0;
+		shared_ptr<GraphicsBuffer> vertexBuffer = factory->CreateVertexBuffer(sizeof(vertices), EAH_GPU_Read, BufferCreate_Vertex, &initData);
+
+		VertexElement element(0, VEF_Float3, VEU_Position, 0);
+		shared_ptr<VertexDeclaration> vertexDecl = factory->CreateVertexDeclaration(&element, 1);
+
+		shared_ptr<RenderOperation> operations[2];
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			operations[i] = std::make_shared<RenderOperation>();
+			operations[i]->PrimitiveType = PT_Triangle_List;
+			operations[i]->BindVertexStream(0, vertexBuffer);
+			operations[i]->VertexDecl = vertexDecl;
+			operations[i]->SetVertexRange(i * 3, 3);
+		}
+
+		// Every fourth object is skinned
+		for (uint32_t i = 0; i < NumRenderables; ++i)
+		{
+			uint32_t numTransforms = (i % 4 == 0) ? NumSkinMatrices + 1 : 1;
+			mRenderables.push_back(std::make_shared<TestRenderable>(material, operations[i % 2], float(i % 50), numTransforms));
+		}
+	}
+
+	void UnloadContent()
+	{
+		mRenderables.clear();
+	}
+
+	void Update(float deltaTime)
+	{
+		// Move objects so sort order and world matrices change every frame
+		for (size_t i = 0; i < mRenderables.size(); ++i)
+			mRenderables[i]->SetHeight(float((mFrame + i) % 7));
+	}
+
+	void Render()
+	{
+		if (mFrame == NumWarmupFrames)
+		{
+			mNumOverflows = FrameAllocator::GetSingleton().GetNumOverflows();
+			SetAllocationHook(CountAllocation);
+		}
+
+		DrawFrame();
+
+		if (++mFrame == NumWarmupFrames + NumCountedFrames)
+		{
+			SetAllocationHook(nullptr);
+			mNumOverflows = FrameAllocator::GetSingleton().GetNumOverflows() - mNumOverflows;
+			mEndGame = true;
+		}
+	}
+
+	void DrawFrame()
+	{
+		RenderDevice* device = Environment::GetSingleton().GetRenderDevice();
+
+		const shared_ptr<FrameBuffer>& screenFB = device->GetScreenFrameBuffer();
+		device->BindFrameBuffer(screenFB);
+		screenFB->Clear(CF_Color | CF_Depth, ColorRGBA::Black, 1.0f, 0);
+
+		mRenderQueue.ClearAllQueue();
+		for (const shared_ptr<TestRenderable>& renderable : mRenderables)
+		{
+			uint64_t sortKey = RenderQueue::MakeSortKey(RenderQueue::BucketOpaque, RO_StateChange, renderable.get(), renderable->GetDepth());
+			mRenderQueue.AddToQueue(RenderQueueItem(renderable.get(), sortKey), RenderQueue::BucketOpaque);
+		}
+
+		const RenderBucket& opaqueBucket = mRenderQueue.GetRenderBucket(RenderQueue::BucketOpaque);
+		mInstanceBatcher.BuildBatches(opaqueBucket);
+		for (const InstanceBatch& batch : mInstanceBatcher.GetBatches())
+			mInstanceBatcher.Render(batch);
+
+		screenFB->SwapBuffers();
+	}
+
+private:
+	shared_ptr<Camera> mCamera;
+	vector<shared_ptr<TestRenderable> > mRenderables;
+
+	RenderQueue mRenderQueue;
+	InstanceBatcher mInstanceBatcher;
+
+	uint32_t mFrame;
+
+	// Frame allocator overflows in counted frames
+	uint32_t mNumOverflows;
+};
+
+}
+
+int main()
+{
+	try
+	{
+		RenderAllocationApp app("../Config.xml");
+		app.Create();
+		app.RunGame();
+		app.Release();
+
+		std::cout << gNumAllocations << " allocations in " << NumCountedFrames << " frames" << std::endl;
+		CHECK(gNumAllocations == 0);
+		CHECK(app.GetNumOverflows() == 0);
+	}
+	catch (std::exception& e)
+	{
+		std::cout << "FAILED: " << e.what() << std::endl;
+		++gFailures;
+	}
+
+	return ReportChecks();
+}
@@ -0,0 +1,274 @@
+#include <MainApp/Application.h>
+#include <Core/Environment.h>
+#include <Core/Timer.h>
+#include <Graphics/RenderFactory.h>
+#include <Graphics/RenderOperation.h>
+#include <Graphics/RenderQueue.h>
+#include <Graphics/Renderable.h>
+#include <Graphics/GraphicsResource.h>
+#include <Graphics/Material.h>
+#include <Graphics/Effect.h>
+#include <Resource/ResourceManager.h>
+#include <random>
+
+using namespace RcEngine;
+
+/**
+ * Opaque bucket of 20k items over 16 effects, 128 materials and 64 vertex buffers, submitted
+ * in random order with new depths every frame. Compares sort time of RenderQueue's radix sort
+ * with std::sort and std::stable_sort of the same keys, and counts pipeline, material and
+ * vertex buffer switches of the unsorted order, the old effect handle key and the packed key.
+ */
+
+namespace {
+
+const uint32_t NumItems = 20000;
+const uint32_t NumEffects = 16;
+const uint32_t NumMaterialsPerEffect = 8;
+const uint32_t NumVertexBuffers = 64;
+const uint32_t NumFrames = 100;
+
+// Material of an effect which is never loaded, only handles are used by the sort key
+class BenchmarkMaterial : public Material
+{
+public:
+	BenchmarkMaterial(ResourceHandle handle, const shared_ptr<Effect>& effect)
+		: Material(ResourceManager::GetSingletonPtr(), handle, "Material" + std::to_string(handle), "General")
+	{
+		mEffect = effect;
+	}
+};
+
+class BenchmarkRenderable : public Renderable
+{
+public:
+	BenchmarkRenderable(const shared_ptr<Material>& material, const shared_ptr<RenderOperation>& operation)
+		: mMaterial(material), mOperation(operation), mDepth(0) {}
+
+	const shared_ptr<Material>& GetMaterial() const					{ return mMaterial; }
+	const shared_ptr<RenderOperation>& GetRenderOperation() const	{ return mOperation; }
+	EffectTechnique* GetTechnique() const							{ return nullptr; }
+
+	void GetWorldTransforms(float4x4* xform) const					{ *xform = float4x4::Identity(); }
+	uint32_t GetWorldTransformsCount() const						{ return 1; }
+
+	float GetDepth() const											{ return mDepth; }
+	void SetDepth(float depth)										{ mDepth = depth; }
+
+private:
+	shared_ptr<Material> mMaterial;
+	shared_ptr<RenderOperation> mOperation;
+	float mDepth;
+};
+
+struct SwitchCounts
+{
+	uint32_t Pipelines;
+	uint32_t Materials;
+	uint32_t VertexBuffers;
+};
+
+template <typename Iterator>
+SwitchCounts CountSwitches(Iterator first, Iterator last)
+{
+	SwitchCounts counts = { 0, 0, 0 };
+
+	const Effect* effect = nullptr;
+	const Material* material = nullptr;
+	const GraphicsBuffer* vertexBuffer = nullptr;
+
+	for (; first != last; ++first)
+	{
+		const Renderable* renderable = first->Renderable;
+
+		const Material* itemMaterial = renderable->GetMaterial().get();
+		const Effect* itemEffect = itemMaterial->GetEffect().get();
+		const GraphicsBuffer* itemVertexBuffer = renderable->GetRenderOperation()->VertexStreams.front().get();
+
+		if (itemEffect != effect) ++counts.Pipelines;
+		if (itemMaterial != material) ++counts.Materials;
+		if (itemVertexBuffer != vertexBuffer) ++counts.VertexBuffers;
+
+		effect = itemEffect;
+		material = itemMaterial;
+		vertexBuffer = itemVertexBuffer;
+	}
+
+	return counts;
+}
+
+void PrintSwitches(const char* name, const SwitchCounts& counts)
+{
+	std::cout << "  " << name << counts.Pipelines << " pipeline, " << counts.Materials << " material, "
+		<< counts.VertexBuffers << " vertex buffer switches" << std::endl;
+}
+
+// Old RO_StateChange key, effect handle cast to float
+struct FloatKeyItem
+{
+	Renderable* Renderable;
+	float SortKey;
+};
+
+class RenderQueueSortApp : public Application
+{
+public:
+	RenderQueueSortApp(const String& config)
+		: Application(config)
+	{
+		mAppSettings.RHDeviceType = RD_Null;
+	}
+
+protected:
+	void Initialize()
+	{
+
+	}
+
+	void LoadContent()
+	{
+		CreateItems();
+		RunBenchmark();
+	}
+
+	void UnloadContent()
+	{
+		mRenderables.clear();
+	}
+
+	void Update(float deltaTime)
+	{
+		mEndGame = true;
+	}
+
+	void Render()
+	{
+
+	}
+
+	void CreateItems()
+	{
+		RenderFactory* factory = Environment::GetSingleton().GetRenderFactory();
+
+		vector<shared_ptr<Material> > materials;
+		for (uint32_t i = 0; i < NumEffects; ++i)
+		{
+			shared_ptr<Effect> effect = std::make_shared<Effect>(ResourceManager::GetSingletonPtr(), 1000 + i, "Effect" + std::to_string(i), "General");
+			for (uint32_t j = 0; j < NumMaterialsPerEffect; ++j)
+				materials.push_back(std::make_shared<BenchmarkMaterial>(2000 + materials.size(), effect));
+		}
+
+		vector<shared_ptr<RenderOperation> > operations;
+		for (uint32_t i = 0; i < NumVertexBuffers; ++i)
+		{
+			shared_ptr<RenderOperation> operation = std::make_shared<RenderOperation>();
+			operation->PrimitiveType = PT_Triangle_List;
+			operation->BindVertexStream(0, factory->CreateVertexBuffer(1024, EAH_GPU_Read, BufferCreate_Vertex, nullptr));
+			operations.push_back(operation);
+		}
+
+		// Materials and meshes are not correlated, like a level with shared meshes
+		for (uint32_t i = 0; i < NumItems; ++i)
+		{
+			const shared_ptr<Material>& material = materials[mRandom() % materials.size()];
+			const shared_ptr<RenderOperation>& operation = operations[mRandom() % operations.size()];
+			mRenderables.push_back(std::make_shared<BenchmarkRenderable>(material, operation));
+		}
+	}
+
+	void RunBenchmark()
+	{
+		std::uniform_real_distribution<float> depth(1.0f, 1000.0f);
+
+		double radixTime = 0.0, stdSortTime = 0.0, stableSortTime = 0.0, resortTime = 0.0;
+
+		RenderBucket reference;
+		vector<FloatKeyItem> floatKeyItems;
+
+		std::cout << NumItems << " items, state switches in draw order:" << std::endl;
+
+		for (uint32_t frame = 0; frame < NumFrames; ++frame)
+		{
+			mRenderQueue.ClearAllQueue();
+			reference.clear();
+			floatKeyItems.clear();
+
+			for (const shared_ptr<BenchmarkRenderable>& renderable : mRenderables)
+			{
+				renderable->SetDepth(depth(mRandom));
+
+				uint64_t sortKey = RenderQueue::MakeSortKey(RenderQueue::BucketOpaque, RO_StateChange, renderable.get(), renderable->GetDepth());
+				mRenderQueue.AddToQueue(RenderQueueItem(renderable.get(), sortKey), RenderQueue::BucketOpaque);
+				reference.push_back(RenderQueueItem(renderable.get(), sortKey));
+
+				FloatKeyItem floatKeyItem = { renderable.get(), float(renderable->GetMaterial()->GetEffect()->GetResourceHandle()) };
+				floatKeyItems.push_back(floatKeyItem);
+			}
+
+			if (frame == 0)
+				PrintSwitches("unsorted:          ", CountSwitches(reference.begin(), reference.end()));
+
+			uint64_t start = SystemClock::Now();
+			const RenderBucket& bucket = mRenderQueue.GetRenderBucket(RenderQueue::BucketOpaque);
+			radixTime += SystemClock::ToSeconds(SystemClock::Now() - start);
+
+			// Second pass fetching the same bucket must not sort again
+			start = SystemClock::Now();
+			mRenderQueue.GetRenderBucket(RenderQueue::BucketOpaque);
+			resortTime += SystemClock::ToSeconds(SystemClock::Now() - start);
+
+			RenderBucket stableSorted = reference;
+
+			start = SystemClock::Now();
+			std::sort(reference.begin(), reference.end(), [](const RenderQueueItem& lhs, const RenderQueueItem& rhs) {
+				return lhs.SortKey < rhs.SortKey; });
+			stdSortTime += SystemClock::ToSeconds(SystemClock::Now() - start);
+
+			start = SystemClock::Now();
+			std::stable_sort(stableSorted.begin(), stableSorted.end(), [](const RenderQueueItem& lhs, const RenderQueueItem& rhs) {
+				return lhs.SortKey < rhs.SortKey; });
+			stableSortTime += SystemClock::ToSeconds(SystemClock::Now() - start);
+
+			std::sort(floatKeyItems.begin(), floatKeyItems.end(), [](const FloatKeyItem& lhs, const FloatKeyItem& rhs) {
+				return lhs.SortKey < rhs.SortKey; });
+
+			if (frame == 0)
+			{
+				PrintSwitches("effect handle key: ", CountSwitches(floatKeyItems.begin(), floatKeyItems.end()));
+				PrintSwitches("packed key:        ", CountSwitches(bucket.begin(), bucket.end()));
+			}
+
+			// Radix sort is stable, order must be the same as std::stable_sort
+			bool sameOrder = bucket.size() == stableSorted.size();
+			for (size_t i = 0; sameOrder && i < bucket.size(); ++i)
+				sameOrder = bucket[i].Renderable == stableSorted[i].Renderable;
+
+			if (!sameOrder)
+				std::cout << "  frame " << frame << ": radix sort order differs from std::stable_sort!" << std::endl;
+		}
+
+		const double toMilliseconds = 1000.0 / NumFrames;
+		std::cout << "Sort per frame:" << std::endl;
+		std::cout << "  radix sort:       " << radixTime * toMilliseconds << " ms, fetch again " << resortTime * toMilliseconds << " ms" << std::endl;
+		std::cout << "  std::sort:        " << stdSortTime * toMilliseconds << " ms" << std::endl;
+		std::cout << "  std::stable_sort: " << stableSortTime * toMilliseconds << " ms" << std::endl;
+	}
+
+private:
+	std::mt19937 mRandom;
+
+	vector<shared_ptr<BenchmarkRenderable> > mRenderables;
+	RenderQueue mRenderQueue;
+};
+
+}
+
+int main()
+{
+	RenderQueueSortApp app("../Config.xml");
+	app.Create();
+	app.RunGame();
+	app.Release();
+
+	return 0;
+}
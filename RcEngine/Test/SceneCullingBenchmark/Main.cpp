@@ -0,0 +1,264 @@
+#include <MainApp/Application.h>
+#include <Core/Environment.h>
+#include <Core/Timer.h>
+#include <Scene/SceneManager.h>
+#include <Scene/SceneNode.h>
+#include <Scene/SceneObject.h>
+#include <Graphics/Camera.h>
+#include <Graphics/RenderQueue.h>
+#include <Math/MathUtil.h>
+
+using namespace RcEngine;
+
+/**
+ * Visible set cost of SceneManager::UpdateRenderQueue, recursion through scene nodes against
+ * the dynamic AABB tree, with 10k, 100k and 1M objects on a grid. Objects are grouped in block
+ * nodes of 32 x 32 cells under the root, scene grows from one size to the next. Camera turns every frame, the moving run also moves 1% of
+ * the objects per frame so the tree is refit, the churn run detaches and attaches 1% of the objects and one block per frame so
+ * proxies are removed and inserted. Both modes must find the same visible objects.
+ */
+
+namespace {
+
+const uint32_t SceneSizes[] = { 10000, 100000, 1000000 };
+const float ObjectSpacing = 4.0f;
+const uint32_t BlockSize = 32;
+
+// Object counts itself when it reaches render queue and its exact box is visible
+class BoxObject : public SceneObject
+{
+public:
+	BoxObject(const String& name)
+		: SceneObject(name, SOT_Entity, true)
+	{
+		mBoundingBox = BoundingBoxf(float3(-1, 0, -1), float3(1, 2, 1));
+	}
+
+	const BoundingBoxf& GetWorldBoundingBox() const
+	{
+		mWorldBoundingBox = Transform(mBoundingBox, mParentNode->GetWorldTransform());
+		return mWorldBoundingBox;
+	}
+
+	void OnUpdateRenderQueue(RenderQueue* renderQueue, const Camera& cam, RenderOrder order, uint32_t buckets, uint32_t filterIgnore)
+	{
+		if (cam.Visible(GetWorldBoundingBox()))
+			++msNumVisible;
+	}
+
+public:
+	static uint32_t msNumVisible;
+
+private:
+	mutable BoundingBoxf mWorldBoundingBox;
+};
+
+uint32_t BoxObject::msNumVisible = 0;
+
+struct FrameStats
+{
+	double Milliseconds;
+	uint64_t NumVisible;
+};
+
+void TurnCamera(Camera& camera, uint32_t frame)
+{
+	float yaw = frame * 0.1f;
+	float3 eye(0, 30, 0);
+	camera.CreateLookAt(eye, eye + float3(sinf(yaw), -0.2f, cosf(yaw)));
+}
+
+FrameStats RunFrames(SceneManager& sceneMan, Camera& camera, const shared_ptr<Camera>& cameraPtr,
+	vector<SceneNode*>& nodes, const vector<float3>& positions, const vector<SceneNode*>& blocks,
+	uint32_t numFrames, uint32_t numMoving, uint32_t numChurn)
+{
+	SceneNode* root = sceneMan.GetRootSceneNode();
+
+	FrameStats stats = { 0.0, 0 };
+
+	for (uint32_t frame = 0; frame < numFrames; ++frame)
+	{
+		TurnCamera(camera, frame);
+
+		// Same objects move in both modes, they go back to their place every other frame
+		for (uint32_t i = 0; i < numMoving; ++i)
+		{
+			uint32_t index = (frame / 2 * numMoving + i * 97) % nodes.size();
+			nodes[index]->SetPosition(positions[index] + float3(0, 0, (frame & 1) ? 1.0f : 0.0f));
+		}
+
+		// Objects and block leave the scene and come back at the same place
+		uint64_t start = SystemClock::Now();
+		for (uint32_t i = 0; i < numChurn; ++i)
+		{
+			SceneNode* node = nodes[(frame * numChurn + i * 89) % nodes.size()];
+			SceneObject* object = node->GetAttachedObject(0);
+			node->DetachOject(object);
+			node->AttachObject(object);
+		}
+
+		if (numChurn)
+		{
+			SceneNode* block = blocks[frame % blocks.size()];
+			root->DetachChild(block);
+			root->AttachChild(block);
+		}
+		double churnTime = SystemClock::ToSeconds(SystemClock::Now() - start) * 1000.0;
+
+		sceneMan.UpdateSceneGraph(0.0f);
+
+		BoxObject::msNumVisible = 0;
+
+		start = SystemClock::Now();
+		sceneMan.UpdateRenderQueue(cameraPtr, RO_None, RenderQueue::BucketOpaque, 0);
+		stats.Milliseconds += SystemClock::ToSeconds(SystemClock::Now() - start) * 1000.0 + churnTime;
+
+		stats.NumVisible += BoxObject::msNumVisible;
+	}
+
+	// Put moved objects back so every run starts from the same scene
+	for (uint32_t frame = 0; frame < numFrames; frame += 2)
+	{
+		for (uint32_t i = 0; i < numMoving; ++i)
+		{
+			uint32_t index = (frame / 2 * numMoving + i * 97) % nodes.size();
+			nodes[index]->SetPosition(positions[index]);
+		}
+	}
+	sceneMan.UpdateSceneGraph(0.0f);
+
+	stats.Milliseconds /= numFrames;
+	return stats;
+}
+
+// Camera needs a render device, benchmark runs on the null device before the first frame
+class SceneCullingApp : public Application
+{
+public:
+	SceneCullingApp(const String& config)
+		: Application(config)
+	{
+		mAppSettings.RHDeviceType = RD_Null;
+	}
+
+protected:
+	void Initialize()
+	{
+		mCamera = std::make_shared<Camera>();
+		mCamera->CreatePerspectiveFov(Mathf::PI / 3, 16.0f / 9.0f, 1.0f, 500.0f);
+	}
+
+	void LoadContent()
+	{
+		// Scene only grows, nodes are owned by scene manager until exit
+		for (size_t i = 0; i < ARRAY_SIZE(SceneSizes); ++i)
+		{
+			AddObjects(SceneSizes[i]);
+			RunScene();
+		}
+	}
+
+	void UnloadContent()
+	{
+
+	}
+
+	void Update(float deltaTime)
+	{
+		mEndGame = true;
+	}
+
+	void Render()
+	{
+
+	}
+
+	// Objects fill square shells of a grid from origin, first n * n objects cover an n x n square
+	void AddObjects(uint32_t numObjects)
+	{
+		SceneManager& sceneMan = *Environment::GetSingleton().GetSceneManager();
+		SceneNode* root = sceneMan.GetRootSceneNode();
+
+		for (uint32_t i = mNodes.size(); i < numObjects; ++i)
+		{
+			uint32_t shell = uint32_t(sqrtf(float(i)));
+			while (shell * shell > i) --shell;
+			while ((shell + 1) * (shell + 1) <= i) ++shell;
+
+			uint32_t j = i - shell * shell;
+			uint32_t x = (j <= shell) ? shell : 2 * shell - j;
+			uint32_t z = (j <= shell) ? j : shell;
+			float3 position = float3(float(x), 0.0f, float(z)) * ObjectSpacing;
+
+			// Attaching a child dirties all its siblings, a flat level would take quadratic time to build
+			SceneNode*& block = mBlocks[(x / BlockSize) << 16 | (z / BlockSize)];
+			if (!block)
+			{
+				block = root->CreateChildSceneNode("Block" + std::to_string(mBlocks.size()));
+				mBlockList.push_back(block);
+			}
+
+			SceneNode* node = block->CreateChildSceneNode("Node" + std::to_string(i), position);
+			mObjects.push_back(std::unique_ptr<BoxObject>(new BoxObject("Box" + std::to_string(i))));
+			node->AttachObject(mObjects.back().get());
+
+			mNodes.push_back(node);
+			mPositions.push_back(position);
+		}
+
+		sceneMan.UpdateSceneGraph(0.0f);
+	}
+
+	void RunScene()
+	{
+		SceneManager& sceneMan = *Environment::GetSingleton().GetSceneManager();
+
+		const uint32_t numObjects = mNodes.size();
+		const uint32_t numFrames = numObjects >= 1000000 ? 10 : 50;
+		const uint32_t numMoving = numObjects / 100;
+
+		sceneMan.SetSpatialCulling(false);
+		FrameStats recursion = RunFrames(sceneMan, *mCamera, mCamera, mNodes, mPositions, mBlockList, numFrames, 0, 0);
+		FrameStats recursionMoving = RunFrames(sceneMan, *mCamera, mCamera, mNodes, mPositions, mBlockList, numFrames, numMoving, 0);
+		FrameStats recursionChurn = RunFrames(sceneMan, *mCamera, mCamera, mNodes, mPositions, mBlockList, numFrames, 0, numMoving);
+
+		// First query builds the tree
+		sceneMan.SetSpatialCulling(true);
+		FrameStats build = RunFrames(sceneMan, *mCamera, mCamera, mNodes, mPositions, mBlockList, 1, 0, 0);
+		FrameStats tree = RunFrames(sceneMan, *mCamera, mCamera, mNodes, mPositions, mBlockList, numFrames, 0, 0);
+		FrameStats treeMoving = RunFrames(sceneMan, *mCamera, mCamera, mNodes, mPositions, mBlockList, numFrames, numMoving, 0);
+		FrameStats treeChurn = RunFrames(sceneMan, *mCamera, mCamera, mNodes, mPositions, mBlockList, numFrames, 0, numMoving);
+		sceneMan.SetSpatialCulling(false);
+
+		std::cout << numObjects << " objects, " << recursion.NumVisible / numFrames << " visible per frame" << std::endl;
+		std::cout << "  recursion:         " << recursion.Milliseconds << " ms, moving " << recursionMoving.Milliseconds
+			<< " ms, churn " << recursionChurn.Milliseconds << " ms" << std::endl;
+		std::cout << "  dynamic AABB tree: " << tree.Milliseconds << " ms, moving " << treeMoving.Milliseconds
+			<< " ms, churn " << treeChurn.Milliseconds << " ms, build " << build.Milliseconds << " ms" << std::endl;
+
+		if (recursion.NumVisible != tree.NumVisible || recursionMoving.NumVisible != treeMoving.NumVisible ||
+			recursionChurn.NumVisible != treeChurn.NumVisible)
+			std::cout << "  visible sets differ!" << std::endl;
+	}
+
+private:
+	shared_ptr<Camera> mCamera;
+
+	std::map<uint32_t, SceneNode*> mBlocks;
+	vector<SceneNode*> mBlockList;
+	vector<std::unique_ptr<BoxObject> > mObjects;
+	vector<SceneNode*> mNodes;
+	vector<float3> mPositions;
+};
+
+}
+
+int main()
+{
+	SceneCullingApp app("../Config.xml");
+	app.Create();
+	app.RunGame();
+	app.Release();
+
+	return 0;
+}
@@ -0,0 +1,181 @@
+#include <Core/Prerequisites.h>
+#include <Core/CpuInfo.h>
+#include <Core/JobSystem.h>
+#include <Core/Timer.h>
+#include <Graphics/CpuSkinning.h>
+#include <Graphics/VertexDeclaration.h>
+#include <Math/MathUtil.h>
+#include <random>
+
+using namespace RcEngine;
+
+/**
+ * CPU skinning of 200k vertices with 3 influences over 64 bones. Every code path of linear
+ * blend and dual quaternion skinning is timed on one thread and compared with the scalar
+ * path, then the default path is timed split over JobSystem workers. With one influence per
+ * vertex both methods must give the same result.
+ */
+
+namespace {
+
+const uint32_t NumVertices = 200000;
+const uint32_t NumBones = 64;
+const uint32_t NumIterations = 20;
+
+// Position, normal, weights and indices
+struct SkinnedVertex
+{
+	float Position[3];
+	float Normal[3];
+	float Weights[3];
+	uint32_t Indices[3];
+};
+
+struct SkinnedMesh
+{
+	vector<SkinnedVertex> Vertices;
+	shared_ptr<SkinningSource> Source;
+};
+
+SkinnedMesh CreateMesh(uint32_t numInfluences, std::mt19937& random)
+{
+	std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> weight(0.1f, 1.0f);
+
+	SkinnedMesh mesh;
+	mesh.Vertices.resize(NumVertices);
+
+	for (SkinnedVertex& vertex : mesh.Vertices)
+	{
+		float3 normal = Normalize(float3(coordinate(random), coordinate(random), coordinate(random)));
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			vertex.Position[k] = coordinate(random) * 2.0f;
+			vertex.Normal[k] = normal[k];
+		}
+
+		float weightSum = 0.0f;
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			vertex.Weights[i] = (i < numInfluences) ? weight(random) : 0.0f;
+			vertex.Indices[i] = random() % NumBones;
+			weightSum += vertex.Weights[i];
+		}
+
+		for (uint32_t i = 0; i < 3; ++i)
+			vertex.Weights[i] /= weightSum;
+	}
+
+	const VertexElement elements[] = {
+		VertexElement(0, VEF_Float3, VEU_Position),
+		VertexElement(12, VEF_Float3, VEU_Normal),
+		VertexElement(24, VEF_Float3, VEU_BlendWeight),
+		VertexElement(36, VEF_UInt3, VEU_BlendIndices)
+	};
+
+	VertexDeclaration vertexDecl(elements, ARRAY_SIZE(elements));
+	mesh.Source = std::make_shared<SkinningSource>(vertexDecl, &mesh.Vertices[0], NumVertices);
+
+	return mesh;
+}
+
+// Rigid matrices, dual quaternion skinning ignores scale
+vector<float4x4> CreateSkinMatrices(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> angle(-Mathf::PI, Mathf::PI);
+
+	vector<float4x4> skinMatrices;
+	for (uint32_t i = 0; i < NumBones; ++i)
+	{
+		float3 axis = Normalize(float3(coordinate(random), coordinate(random), coordinate(random)));
+		float3 translation(coordinate(random), coordinate(random), coordinate(random));
+		skinMatrices.push_back(CreateTransformMatrix(float3(1, 1, 1), QuaternionFromRotationAxis(axis, angle(random)), translation));
+	}
+
+	return skinMatrices;
+}
+
+struct SkinResult
+{
+	double Milliseconds;
+	vector<float> Positions;
+	vector<float> Normals;
+};
+
+SkinResult RunSkinning(const SkinnedMesh& mesh, const vector<float4x4>& skinMatrices, SkinningMethod method,
+	CpuSkinning::CodePath path, bool parallel)
+{
+	SkinResult result;
+	result.Positions.resize(NumVertices * 3);
+	result.Normals.resize(NumVertices * 3);
+
+	SkinningTarget target = { &result.Positions[0], &result.Normals[0], sizeof(float3) };
+
+	CpuSkinning::SetCodePath(path);
+
+	uint64_t start = SystemClock::Now();
+	for (uint32_t i = 0; i < NumIterations; ++i)
+		CpuSkinning::Skin(*mesh.Source, &skinMatrices[0], NumBones, target, method, 0, NumVertices, parallel);
+	result.Milliseconds = SystemClock::ToSeconds(SystemClock::Now() - start) * 1000.0 / NumIterations;
+
+	CpuSkinning::SetCodePath(CpuSkinning::Path_Auto);
+
+	return result;
+}
+
+float MaxDifference(const SkinResult& a, const SkinResult& b)
+{
+	float difference = 0.0f;
+	for (size_t i = 0; i < a.Positions.size(); ++i)
+	{
+		difference = (std::max)(difference, fabsf(a.Positions[i] - b.Positions[i]));
+		difference = (std::max)(difference, fabsf(a.Normals[i] - b.Normals[i]));
+	}
+	return difference;
+}
+
+void PrintResult(const char* name, const SkinResult& result, const SkinResult& reference)
+{
+	std::cout << "  " << name << result.Milliseconds << " ms, max difference " << MaxDifference(result, reference) << std::endl;
+}
+
+}
+
+int main()
+{
+	SystemClock::InitClock();
+	JobSystem::Initialize();
+
+	std::mt19937 random(7);
+	vector<float4x4> skinMatrices = CreateSkinMatrices(random);
+	SkinnedMesh mesh = CreateMesh(3, random);
+
+	std::cout << NumVertices << " vertices, " << NumBones << " bones, 3 influences, SSE2 " << CpuInfo::HasSSE2()
+		<< ", AVX " << CpuInfo::HasAVX() << std::endl;
+
+	SkinResult linearScalar = RunSkinning(mesh, skinMatrices, SM_LinearBlend, CpuSkinning::Path_Scalar, false);
+	std::cout << "Linear blend, one thread:" << std::endl;
+	PrintResult("scalar:    ", linearScalar, linearScalar);
+	PrintResult("SSE:       ", RunSkinning(mesh, skinMatrices, SM_LinearBlend, CpuSkinning::Path_SSE, false), linearScalar);
+	PrintResult("AVX:       ", RunSkinning(mesh, skinMatrices, SM_LinearBlend, CpuSkinning::Path_AVX, false), linearScalar);
+
+	SkinResult dualQuatScalar = RunSkinning(mesh, skinMatrices, SM_DualQuaternion, CpuSkinning::Path_Scalar, false);
+	std::cout << "Dual quaternion, one thread:" << std::endl;
+	PrintResult("scalar:    ", dualQuatScalar, dualQuatScalar);
+	PrintResult("SSE:       ", RunSkinning(mesh, skinMatrices, SM_DualQuaternion, CpuSkinning::Path_SSE, false), dualQuatScalar);
+
+	std::cout << "Default path, " << JobSystem::GetSingleton().GetNumWorkers() << " workers and main thread:" << std::endl;
+	PrintResult("linear:    ", RunSkinning(mesh, skinMatrices, SM_LinearBlend, CpuSkinning::Path_Auto, true), linearScalar);
+	PrintResult("dual quat: ", RunSkinning(mesh, skinMatrices, SM_DualQuaternion, CpuSkinning::Path_Auto, true), dualQuatScalar);
+
+	// Rigid single bone transform is the same for both methods
+	SkinnedMesh rigidMesh = CreateMesh(1, random);
+	SkinResult rigidLinear = RunSkinning(rigidMesh, skinMatrices, SM_LinearBlend, CpuSkinning::Path_Auto, true);
+	SkinResult rigidDualQuat = RunSkinning(rigidMesh, skinMatrices, SM_DualQuaternion, CpuSkinning::Path_Auto, true);
+	std::cout << "One influence, dual quaternion against linear blend: max difference " << MaxDifference(rigidDualQuat, rigidLinear) << std::endl;
+
+	JobSystem::Finalize();
+
+	return 0;
+}
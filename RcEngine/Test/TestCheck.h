@@ -0,0 +1,32 @@
+#ifndef TestCheck_h__
+#define TestCheck_h__
+
+#include <iostream>
+
+/**
+ * Check harness of the console tests. A failed CHECK prints its line and condition and is
+ * counted, main returns ReportChecks() as exit code.
+ */
+
+namespace {
+
+int gFailures = 0;
+
+inline int ReportChecks()
+{
+	if (gFailures)
+	{
+		std::cout << gFailures << " checks failed" << std::endl;
+		return 1;
+	}
+
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}
+
+}
+
+#define CHECK(cond) \
+	do { if (!(cond)) { std::cout << "FAILED " << __LINE__ << ": " << #cond << std::endl; ++gFailures; } } while (0)
+
+#endif // TestCheck_h__
@@ -0,0 +1,105 @@
+#include <Core/Prerequisites.h>
+#include <Core/Exception.h>
+#include <Graphics/AnimationClip.h>
+#include <IO/FileSystem.h>
+#include <IO/FileStream.h>
+#include <IO/PathUtil.h>
+#include <Resource/ResourceManager.h>
+
+using namespace RcEngine;
+
+namespace {
+
+const String InputGroup = "ClipCompressor";
+
+int Compress(int argc, char** argv)
+{
+	String inputFile, outputFile;
+
+	AnimationClip::CompressionSettings settings;
+	settings.Enabled = true;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		String arg = argv[i];
+		if (arg == "-translation" && i + 1 < argc)
+			settings.TranslationTolerance = float(atof(argv[++i]));
+		else if (arg == "-rotation" && i + 1 < argc)
+			settings.RotationTolerance = float(atof(argv[++i]));
+		else if (arg == "-scale" && i + 1 < argc)
+			settings.ScaleTolerance = float(atof(argv[++i]));
+		else if (inputFile.empty())
+			inputFile = arg;
+		else
+			outputFile = arg;
+	}
+
+	if (inputFile.empty() || outputFile.empty())
+	{
+		std::cerr << "Missing input or output clip" << std::endl;
+		return 1;
+	}
+
+	// Clips load through the file system, input directory becomes a group of its own
+	String inputDir = PathUtil::GetPath(inputFile);
+	FileSystem::GetSingleton().RegisterPath(inputDir.empty() ? "." : inputDir, InputGroup);
+
+	AnimationClip clip(ResourceManager::GetSingletonPtr(), 0, PathUtil::GetFileNameAndExtension(inputFile), InputGroup);
+	clip.Load();
+
+	if (clip.IsCompressed())
+	{
+		std::cerr << inputFile << " is compressed already" << std::endl;
+		return 1;
+	}
+
+	clip.Compress(settings);
+
+	FileStream stream;
+	if (!stream.Open(outputFile, FILE_WRITE))
+	{
+		std::cerr << "Can't create " << outputFile << std::endl;
+		return 1;
+	}
+	clip.Save(stream);
+
+	const AnimationClip::CompressionReport& report = clip.GetCompressionReport();
+	std::cout << inputFile << ": " << report.NumRawKeys << " -> " << report.NumKeys << " keys, " << report.RawSize << " -> "
+		<< report.CompressedSize << " bytes, max error translation " << report.MaxTranslationError << ", rotation "
+		<< report.MaxRotationError << ", scale " << report.MaxScaleError << std::endl;
+
+	return 0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		AnimationClip::CompressionSettings defaults;
+		std::cout << "Usage:\n"
+			<< "  ClipCompressor <input.anim> <output.anim> [-translation <tolerance>] [-rotation <radians>] [-scale <tolerance>]\n"
+			<< "Default tolerances: translation " << defaults.TranslationTolerance << ", rotation " << defaults.RotationTolerance
+			<< ", scale " << defaults.ScaleTolerance << std::endl;
+		return 1;
+	}
+
+	FileSystem::Initialize();
+	ResourceManager::Initialize();
+
+	int result = 1;
+	try
+	{
+		result = Compress(argc, argv);
+	}
+	catch (Exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+	}
+
+	ResourceManager::Finalize();
+	FileSystem::Finalize();
+
+	return result;
+}
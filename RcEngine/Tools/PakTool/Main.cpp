@@ -0,0 +1,309 @@
+#include <Core/Prerequisites.h>
+#include <Core/Timer.h>
+#include <Core/Exception.h>
+#include <IO/FileSystem.h>
+#include <IO/FileStream.h>
+#include <IO/PakArchive.h>
+#include <IO/Stream.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+using namespace RcEngine;
+
+namespace {
+
+/**
+ * Collect files below dir recursively, names are relative to root.
+ */
+void ScanFiles(const String& root, const String& dir, vector<String>& files)
+{
+	String searchDir = dir.empty() ? root : root + "/" + dir;
+
+#ifdef _WIN32
+	_finddata_t data;
+	intptr_t handle = _findfirst((searchDir + "/*").c_str(), &data);
+	if (handle == -1)
+		return;
+
+	do
+	{
+		String name = data.name;
+		if (name == "." || name == "..")
+			continue;
+
+		String relative = dir.empty() ? name : dir + "/" + name;
+		if (data.attrib & _A_SUBDIR)
+			ScanFiles(root, relative, files);
+		else
+			files.push_back(relative);
+
+	} while (_findnext(handle, &data) == 0);
+
+	_findclose(handle);
+#else
+	DIR* handle = opendir(searchDir.c_str());
+	if (!handle)
+		return;
+
+	while (dirent* data = readdir(handle))
+	{
+		String name = data->d_name;
+		if (name == "." || name == "..")
+			continue;
+
+		String relative = dir.empty() ? name : dir + "/" + name;
+
+		struct stat st;
+		if (stat((root + "/" + relative).c_str(), &st) != 0)
+			continue;
+
+		if (S_ISDIR(st.st_mode))
+			ScanFiles(root, relative, files);
+		else
+			files.push_back(relative);
+	}
+
+	closedir(handle);
+#endif
+}
+
+bool ReadFile(const String& fileName, vector<uint8_t>& data)
+{
+	FileStream stream;
+	if (!stream.Open(fileName, FILE_READ))
+		return false;
+
+	data.resize(stream.GetSize());
+	if (!data.empty())
+		stream.Read(&data[0], data.size());
+
+	return true;
+}
+
+String GetExtension(const String& file)
+{
+	size_t dot = file.find_last_of('.');
+	size_t slash = file.find_last_of('/');
+	if (dot == String::npos || (slash != String::npos && dot < slash))
+		return String();
+
+	String ext = file.substr(dot);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+	return ext;
+}
+
+int Pack(int argc, char** argv)
+{
+	String archiveFile;
+	vector<String> inputDirs;
+	unordered_set<String> storedExts;
+	bool compress = false;
+
+	for (int i = 2; i < argc; ++i)
+	{
+		String arg = argv[i];
+		if (arg == "-lz4")
+			compress = true;
+		else if (arg == "-store" && i + 1 < argc)
+		{
+			String ext = argv[++i];
+			std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+			storedExts.insert(ext[0] == '.' ? ext : "." + ext);
+		}
+		else if (archiveFile.empty())
+			archiveFile = arg;
+		else
+			inputDirs.push_back(arg);
+	}
+
+	if (archiveFile.empty() || inputDirs.empty())
+	{
+		std::cerr << "Missing archive or input directory" << std::endl;
+		return 1;
+	}
+
+	PakArchiveWriter writer;
+	if (!writer.Create(archiveFile))
+	{
+		std::cerr << "Can't create " << archiveFile << std::endl;
+		return 1;
+	}
+
+	// Same name in several directories, the first one wins like FileSystem lookup does
+	unordered_set<String> packedNames;
+	vector<uint8_t> data;
+
+	for (const String& inputDir : inputDirs)
+	{
+		vector<String> files;
+		ScanFiles(inputDir, "", files);
+		std::sort(files.begin(), files.end());
+
+		for (const String& file : files)
+		{
+			if (!packedNames.insert(PakArchive::NormalizeName(file)).second)
+			{
+				std::cout << "Skip " << inputDir << "/" << file << ", already packed" << std::endl;
+				continue;
+			}
+
+			if (!ReadFile(inputDir + "/" + file, data))
+			{
+				std::cerr << "Can't read " << inputDir << "/" << file << std::endl;
+				return 1;
+			}
+
+			bool compressEntry = compress && !storedExts.count(GetExtension(file));
+			writer.AddEntry(file, data.empty() ? nullptr : &data[0], data.size(), compressEntry);
+		}
+	}
+
+	writer.Finish();
+
+	std::cout << archiveFile << ": " << writer.GetNumEntries() << " files, "
+		<< writer.GetTotalSize() << " bytes, packed " << writer.GetPackedSize() << " bytes" << std::endl;
+
+	return 0;
+}
+
+int List(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cerr << "Missing archive" << std::endl;
+		return 1;
+	}
+
+	PakArchive archive;
+	if (!archive.Open(argv[2]))
+	{
+		std::cerr << "Can't open " << argv[2] << std::endl;
+		return 1;
+	}
+
+	for (uint32_t i = 0; i < archive.GetNumEntries(); ++i)
+	{
+		const PakEntry& entry = archive.GetEntry(i);
+		std::cout << archive.GetEntryName(i) << " " << entry.Size << " " << entry.PackedSize
+			<< ((entry.Flags & PEF_LZ4) ? " lz4" : "") << std::endl;
+	}
+
+	return 0;
+}
+
+/**
+ * Open and read every file of the archive through FileSystem, once as loose files and
+ * once from the archive. The first pass is cold for FileSystem, the OS file cache is
+ * only cold if it was flushed before running the benchmark.
+ */
+int Bench(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		std::cerr << "Missing archive or input directory" << std::endl;
+		return 1;
+	}
+
+	PakArchive archive;
+	if (!archive.Open(argv[2]))
+	{
+		std::cerr << "Can't open " << argv[2] << std::endl;
+		return 1;
+	}
+
+	// Use names as found on disk, archive names are lower case
+	vector<String> files;
+	unordered_set<String> scannedNames;
+
+	FileSystem& fileSystem = FileSystem::GetSingleton();
+	for (int i = 3; i < argc; ++i)
+	{
+		fileSystem.RegisterPath(argv[i], "Loose");
+
+		vector<String> dirFiles;
+		ScanFiles(argv[i], "", dirFiles);
+		for (const String& file : dirFiles)
+		{
+			if (scannedNames.insert(PakArchive::NormalizeName(file)).second && archive.Exits(file))
+				files.push_back(file);
+		}
+	}
+
+	uint64_t mountStart = SystemClock::Now();
+	fileSystem.MountArchive(argv[2], "Pak");
+	double mountTime = SystemClock::ToSeconds(SystemClock::Now() - mountStart);
+
+	const char* groups[] = { "Loose", "Pak" };
+	vector<uint8_t> buffer;
+
+	std::cout << "Files: " << files.size() << ", mount: " << mountTime * 1000.0 << " ms" << std::endl;
+	for (const char* group : groups)
+	{
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			uint64_t bytes = 0;
+			uint64_t start = SystemClock::Now();
+
+			for (const String& file : files)
+			{
+				if (!fileSystem.Exits(file, group))
+					continue;
+
+				shared_ptr<Stream> stream = fileSystem.OpenStream(file, group);
+				buffer.resize(stream->GetSize());
+				if (!buffer.empty())
+					bytes += stream->Read(&buffer[0], buffer.size());
+			}
+
+			double time = SystemClock::ToSeconds(SystemClock::Now() - start);
+			std::cout << group << (pass ? " warm: " : " cold: ") << time * 1000.0 << " ms, " << bytes << " bytes" << std::endl;
+		}
+	}
+
+	return 0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage:\n"
+			<< "  PakTool pack <archive> <dir>... [-lz4] [-store <ext>]...\n"
+			<< "  PakTool list <archive>\n"
+			<< "  PakTool bench <archive> <dir>..." << std::endl;
+		return 1;
+	}
+
+	SystemClock::InitClock();
+	FileSystem::Initialize();
+
+	int result = 1;
+	try
+	{
+		String command = argv[1];
+		if (command == "pack")
+			result = Pack(argc, argv);
+		else if (command == "list")
+			result = List(argc, argv);
+		else if (command == "bench")
+			result = Bench(argc, argv);
+		else
+			std::cerr << "Unknown command " << command << std::endl;
+	}
+	catch (Exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+	}
+
+	FileSystem::Finalize();
+	SystemClock::ShutClock();
+
+	return result;
+}
@@ -0,0 +1,309 @@
+#include <Core/Prerequisites.h>
+#include <Core/Timer.h>
+#include <Core/Exception.h>
+#include <Core/Environment.h>
+#include <Core/JobSystem.h>
+#include <IO/FileSystem.h>
+#include <Graphics/Image.h>
+#include <Graphics/ImageProcessing.h>
+#include <thread>
+
+using namespace RcEngine;
+
+namespace {
+
+struct FormatName
+{
+	const char* Name;
+	PixelFormat Format;
+};
+
+const FormatName FormatNames[] = {
+	{ "rgba8",		PF_RGBA8_UNORM },
+	{ "srgba8",		PF_SRGB8_ALPHA8_UNORM },
+	{ "rgba16f",	PF_RGBA16F },
+	{ "rgba32f",	PF_RGBA32F },
+	{ "bc1",		PF_RGB_DXT1_UNORM },
+	{ "bc1_srgb",	PF_SRGB_DXT1_UNORM },
+	{ "bc1a",		PF_RGBA_DXT1_UNORM },
+	{ "bc2",		PF_RGBA_DXT3_UNORM },
+	{ "bc2_srgb",	PF_SRGB_ALPHA_DXT3_UNORM },
+	{ "bc3",		PF_RGBA_DXT5_UNORM },
+	{ "bc3_srgb",	PF_SRGB_ALPHA_DXT5_UNORM },
+	{ "bc4",		PF_R_ATI1N_UNORM },
+	{ "bc5",		PF_RG_ATI2N_UNORM },
+	{ "bc7",		PF_RGB_BP_UNORM },
+	{ "bc7_srgb",	PF_SRGB_BP_UNORM },
+};
+
+/**
+ * Same data, color components declared sRGB encoded. PF_Unknown if format has no sRGB variant.
+ */
+PixelFormat GetSRGBFormat(PixelFormat format)
+{
+	switch (format)
+	{
+	case PF_RGBA8_UNORM:		return PF_SRGB8_ALPHA8_UNORM;
+	case PF_BGRA8_UNORM:		return PF_SBGR8_ALPHA8_UNORM;
+	case PF_RGB_DXT1_UNORM:		return PF_SRGB_DXT1_UNORM;
+	case PF_RGBA_DXT1_UNORM:	return PF_SRGB_ALPHA_DXT1_UNORM;
+	case PF_RGBA_DXT3_UNORM:	return PF_SRGB_ALPHA_DXT3_UNORM;
+	case PF_RGBA_DXT5_UNORM:	return PF_SRGB_ALPHA_DXT5_UNORM;
+	case PF_RGB_BP_UNORM:		return PF_SRGB_BP_UNORM;
+	default:
+		return PixelFormatUtils::IsSRGB(format) ? format : PF_Unknown;
+	}
+}
+
+const void* GetChainLevel(const Image& image, uint32_t chain, uint32_t level)
+{
+	if (image.GetType() == TT_TextureCube)
+		return image.GetLevel(level, chain / CMF_Count, CubeMapFace(chain % CMF_Count));
+	return image.GetLevel(level, chain);
+}
+
+double Seconds(uint64_t start)
+{
+	return SystemClock::ToSeconds(SystemClock::Now() - start);
+}
+
+int Cook(int argc, char** argv)
+{
+	String inputFile, outputFile;
+	PixelFormat format = PF_Unknown;
+	MipFilter filter = MF_Box;
+	bool generateMips = true;
+	bool srgb = false;
+
+	for (int i = 2; i < argc; ++i)
+	{
+		String arg = argv[i];
+		if (arg == "-format" && i + 1 < argc)
+		{
+			String name = argv[++i];
+			for (const FormatName& entry : FormatNames)
+			{
+				if (name == entry.Name)
+					format = entry.Format;
+			}
+
+			if (format == PF_Unknown)
+			{
+				std::cerr << "Unknown format " << name << std::endl;
+				return 1;
+			}
+		}
+		else if (arg == "-mips" && i + 1 < argc)
+		{
+			String name = argv[++i];
+			generateMips = (name != "none");
+			filter = (name == "kaiser") ? MF_Kaiser : MF_Box;
+		}
+		else if (arg == "-srgb")
+			srgb = true;
+		else if (inputFile.empty())
+			inputFile = arg;
+		else
+			outputFile = arg;
+	}
+
+	if (inputFile.empty() || outputFile.empty())
+	{
+		std::cerr << "Missing input or output file" << std::endl;
+		return 1;
+	}
+
+	shared_ptr<Image> image = std::make_shared<Image>();
+	if (!image->LoadImageFromDDS(inputFile))
+	{
+		std::cerr << "Can't load " << inputFile << std::endl;
+		return 1;
+	}
+
+	if (!ImageProcessing::IsFormatSupported(image->GetFormat()))
+	{
+		std::cerr << inputFile << ": unsupported format" << std::endl;
+		return 1;
+	}
+
+	// Files authored without sRGB format, the bytes stay the same, mips and conversion decode them
+	if (srgb)
+	{
+		PixelFormat srgbFormat = GetSRGBFormat(image->GetFormat());
+		if (srgbFormat == PF_Unknown)
+		{
+			std::cerr << inputFile << ": format has no sRGB variant" << std::endl;
+			return 1;
+		}
+
+		shared_ptr<Image> relabeled = std::make_shared<Image>();
+		relabeled->Create(image->GetType(), srgbFormat, image->GetWidth(), image->GetHeight(), image->GetDepth(), image->GetLevels(), image->GetLayers());
+		for (uint32_t chain = 0; chain < image->GetNumChains(); ++chain)
+		{
+			for (uint32_t level = 0; level < image->GetLevels(); ++level)
+				memcpy(const_cast<void*>(GetChainLevel(*relabeled, chain, level)), GetChainLevel(*image, chain, level), image->GetSurfaceSize(level));
+		}
+		image = relabeled;
+	}
+
+	if (format == PF_Unknown)
+		format = image->GetFormat();
+
+	if (PixelFormatUtils::IsCompressed(format) && (image->GetWidth() % 4 || image->GetHeight() % 4))
+		std::cout << "Warning: " << inputFile << " size isn't a multiple of 4, D3D11 can't create block compressed textures of it" << std::endl;
+
+	uint64_t start = SystemClock::Now();
+
+	// Mips are filtered before compression, from the best quality data there is
+	if (generateMips && image->GetType() != TT_Texture3D)
+	{
+		shared_ptr<Image> mipmapped = std::make_shared<Image>();
+		ImageProcessing::GenerateMipmaps(*image, *mipmapped, filter);
+		image = mipmapped;
+	}
+
+	if (format != image->GetFormat())
+	{
+		shared_ptr<Image> converted = std::make_shared<Image>();
+		ImageProcessing::Convert(*image, *converted, format);
+		image = converted;
+	}
+
+	double time = Seconds(start);
+
+	if (!image->SaveImageToDDS(outputFile))
+	{
+		std::cerr << "Can't save " << outputFile << std::endl;
+		return 1;
+	}
+
+	std::cout << outputFile << ": " << image->GetWidth() << "x" << image->GetHeight() << ", "
+		<< image->GetLevels() << " levels, " << time * 1000.0 << " ms" << std::endl;
+
+	return 0;
+}
+
+/**
+ * Time mips, conversion and block compression of a synthetic image serial and with an
+ * increasing number of workers.
+ */
+int Bench(int argc, char** argv)
+{
+	uint32_t size = (argc > 2) ? uint32_t(atoi(argv[2])) : 4096;
+
+	Image source;
+	source.Create(TT_Texture2D, PF_SRGB8_ALPHA8_UNORM, size, size, 1, 1, 1);
+
+	// Gradients with a checker pattern, not trivial to compress
+	uint8_t* pixels = static_cast<uint8_t*>(source.GetLevel(0));
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x, pixels += 4)
+		{
+			float u = float(x) / size, v = float(y) / size;
+			pixels[0] = uint8_t(255.0f * (0.5f + 0.5f * sinf(u * 40.0f + v * 7.0f)));
+			pixels[1] = uint8_t(255.0f * v);
+			pixels[2] = ((x / 32 + y / 32) & 1) ? 200 : 40;
+			pixels[3] = uint8_t(255.0f * (0.5f + 0.5f * cosf(v * 23.0f)));
+		}
+	}
+
+	uint32_t maxWorkers = (std::max)(1U, std::thread::hardware_concurrency()) - 1;
+
+	vector<uint32_t> workerCounts;
+	for (uint32_t workers = 1; workers < maxWorkers; workers *= 2)
+		workerCounts.push_back(workers);
+	workerCounts.push_back(maxWorkers);
+
+	std::cout << size << "x" << size << ", " << maxWorkers + 1 << " hardware threads" << std::endl;
+	std::cout << "threads\tbox mips\tkaiser mips\tto rgba16f\tbc1\tbc7 (ms)" << std::endl;
+
+	// First run serial, then the calling thread helps each number of workers
+	for (int run = -1; run < int(workerCounts.size()); ++run)
+	{
+		bool parallel = (run >= 0);
+		JobSystem* jobSystem = parallel ? new JobSystem(workerCounts[run]) : nullptr;
+
+		Image result;
+		double times[5];
+
+		uint64_t start = SystemClock::Now();
+		ImageProcessing::GenerateMipmaps(source, result, MF_Box, 0, parallel);
+		times[0] = Seconds(start);
+
+		start = SystemClock::Now();
+		ImageProcessing::GenerateMipmaps(source, result, MF_Kaiser, 0, parallel);
+		times[1] = Seconds(start);
+
+		start = SystemClock::Now();
+		ImageProcessing::Convert(source, result, PF_RGBA16F, parallel);
+		times[2] = Seconds(start);
+
+		start = SystemClock::Now();
+		ImageProcessing::Convert(source, result, PF_SRGB_DXT1_UNORM, parallel);
+		times[3] = Seconds(start);
+
+		start = SystemClock::Now();
+		ImageProcessing::Convert(source, result, PF_SRGB_BP_UNORM, parallel);
+		times[4] = Seconds(start);
+
+		if (parallel)
+			std::cout << workerCounts[run] + 1;
+		else
+			std::cout << "serial";
+
+		for (double time : times)
+			std::cout << "\t" << time * 1000.0;
+		std::cout << std::endl;
+
+		delete jobSystem;
+	}
+
+	return 0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage:\n"
+			<< "  TextureCooker cook <input.dds> <output.dds> [-format <format>] [-mips box|kaiser|none] [-srgb]\n"
+			<< "  TextureCooker bench [size]\n"
+			<< "Formats:";
+		for (const FormatName& entry : FormatNames)
+			std::cout << " " << entry.Name;
+		std::cout << std::endl;
+		return 1;
+	}
+
+	Environment::Initialize();
+	SystemClock::InitClock();
+	FileSystem::Initialize();
+
+	int result = 1;
+	try
+	{
+		String command = argv[1];
+		if (command == "cook")
+		{
+			JobSystem jobSystem;
+			result = Cook(argc, argv);
+		}
+		else if (command == "bench")
+			result = Bench(argc, argv);
+		else
+			std::cerr << "Unknown command " << command << std::endl;
+	}
+	catch (Exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+	}
+
+	FileSystem::Finalize();
+	SystemClock::ShutClock();
+	Environment::Finalize();
+
+	return result;
+}